@@ -0,0 +1,141 @@
+/**
+ * @file fsaudiovoiceallocator.cpp
+ * @brief Priority based voice allocation for audio sources
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "fsaudiovoiceallocator.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+    // Most important first; equal priorities keep the caller's order so the
+    // outcome doesn't depend on the sort
+    bool request_before(const FSAudioVoiceAllocator::Request& a, const FSAudioVoiceAllocator::Request& b)
+    {
+        if (a.mPriority != b.mPriority)
+        {
+            return a.mPriority > b.mPriority;
+        }
+        return a.mSource < b.mSource;
+    }
+}
+
+FSAudioVoiceAllocator::FSAudioVoiceAllocator()
+{
+    resetStats();
+}
+
+void FSAudioVoiceAllocator::resetStats()
+{
+    mLastAssigned = 0;
+    mLastStolen = 0;
+    mLastStarved = 0;
+    mTotalAssigned = 0;
+    mTotalStolen = 0;
+    mTotalStarved = 0;
+    mStarvedFrames = 0;
+    mFrames = 0;
+}
+
+void FSAudioVoiceAllocator::allocate(std::vector<Request>& requests, const std::vector<Voice>& voices, std::vector<Assignment>& assignments)
+{
+    assignments.clear();
+    mLastAssigned = 0;
+    mLastStolen = 0;
+    ++mFrames;
+
+    mFreeVoices.clear();
+    mBusyVoices.clear();
+    for (U32 i = 0; i < (U32)voices.size(); ++i)
+    {
+        if (voices[i].mBusy)
+        {
+            mBusyVoices.push_back(std::make_pair(voices[i].mPriority, i));
+        }
+        else
+        {
+            mFreeVoices.push_back(i);
+        }
+    }
+
+    // No more requests than voices can ever be served, only those are sorted
+    size_t candidates = llmin(requests.size(), voices.size());
+    if (candidates < requests.size())
+    {
+        std::nth_element(requests.begin(), requests.begin() + candidates, requests.end(), request_before);
+    }
+    std::sort(requests.begin(), requests.begin() + candidates, request_before);
+
+    // Least important busy voice first
+    std::sort(mBusyVoices.begin(), mBusyVoices.end());
+
+    size_t next_free = 0;
+    size_t next_busy = 0;
+    for (size_t i = 0; i < candidates; ++i)
+    {
+        const Request& request = requests[i];
+        Assignment assignment;
+        assignment.mSource = request.mSource;
+        if (next_free < mFreeVoices.size())
+        {
+            assignment.mVoice = mFreeVoices[next_free++];
+            assignment.mStolen = false;
+        }
+        else if (next_busy < mBusyVoices.size() && mBusyVoices[next_busy].first < request.mPriority)
+        {
+            assignment.mVoice = mBusyVoices[next_busy++].second;
+            assignment.mStolen = true;
+            ++mLastStolen;
+        }
+        else
+        {
+            // Requests are sorted, nobody after this one gets a voice either
+            break;
+        }
+        assignments.push_back(assignment);
+        ++mLastAssigned;
+    }
+
+    mLastStarved = (U32)requests.size() - mLastAssigned;
+    mTotalAssigned += mLastAssigned;
+    mTotalStolen += mLastStolen;
+    mTotalStarved += mLastStarved;
+    if (mLastStarved)
+    {
+        ++mStarvedFrames;
+    }
+}
+
+std::string FSAudioVoiceAllocator::getSummary() const
+{
+    std::ostringstream summary;
+    summary << mTotalAssigned << " voices assigned, " << mTotalStolen << " stolen, "
+            << mTotalStarved << " starved requests in " << mStarvedFrames << " of " << mFrames << " frames";
+    return summary.str();
+}
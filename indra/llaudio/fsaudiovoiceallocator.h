@@ -0,0 +1,101 @@
+/**
+ * @file fsaudiovoiceallocator.h
+ * @brief Priority based voice allocation for audio sources
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_AUDIOVOICEALLOCATOR_H
+#define FS_AUDIOVOICEALLOCATOR_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hands out the audio engine's channels ("voices") to sources waiting for
+// one, once per frame and all at once. Only the requests that can possibly
+// get a voice are sorted; free voices go to the most important requests
+// first, then busy voices are taken from the least important sources that
+// are still below a waiting request. Everything here works on plain
+// priorities and indices, the engine maps them back to its sources and
+// channels.
+class FSAudioVoiceAllocator
+{
+public:
+    struct Voice
+    {
+        F32     mPriority;  // priority of the source using the voice
+        bool    mBusy;      // playing or waiting for sync; idle voices are free
+    };
+
+    struct Request
+    {
+        F32     mPriority;
+        U32     mSource;    // caller's index of the waiting source
+    };
+
+    struct Assignment
+    {
+        U32     mSource;
+        U32     mVoice;
+        bool    mStolen;    // the voice was taken from a busy source
+    };
+
+    FSAudioVoiceAllocator();
+
+    // Decides which requests get which voice this frame. requests is
+    // reordered. A busy voice is only taken for a request of strictly higher
+    // priority, so equally important sources don't steal from each other
+    // every frame.
+    void allocate(std::vector<Request>& requests, const std::vector<Voice>& voices, std::vector<Assignment>& assignments);
+
+    U32 getLastAssigned() const { return mLastAssigned; }
+    U32 getLastStolen() const { return mLastStolen; }
+    U32 getLastStarved() const { return mLastStarved; }
+
+    U64 getTotalAssigned() const { return mTotalAssigned; }
+    U64 getTotalStolen() const { return mTotalStolen; }
+    U64 getTotalStarved() const { return mTotalStarved; }   // request-frames without a voice
+    U64 getStarvedFrames() const { return mStarvedFrames; } // frames with at least one
+    U64 getFrames() const { return mFrames; }
+
+    void resetStats();
+    std::string getSummary() const;
+
+private:
+    typedef std::pair<F32, U32> voice_entry_t;
+
+    std::vector<U32>            mFreeVoices;
+    std::vector<voice_entry_t>  mBusyVoices;
+
+    U32 mLastAssigned;
+    U32 mLastStolen;
+    U32 mLastStarved;
+    U64 mTotalAssigned;
+    U64 mTotalStolen;
+    U64 mTotalStarved;
+    U64 mStarvedFrames;
+    U64 mFrames;
+};
+
+#endif // FS_AUDIOVOICEALLOCATOR_H
@@ -46,6 +46,10 @@ extern void request_sound(const LLUUID &sound_guid);
 
 LLAudioEngine* gAudiop = NULL;
 
+// <FS> Voice allocation
+static const F32 VOICE_REPORT_INTERVAL = 300.f; // seconds between channel statistics in the log
+// </FS>
+
 // NaCl - Sound explorer
 S32 LLAudioSource::sSoundHistoryPruneCounter;
 // NaCl End
@@ -107,6 +111,11 @@ void LLAudioEngine::setDefaults()
 
     for (U32 i = 0; i < LLAudioEngine::AUDIO_TYPE_COUNT; i++)
         mSecondaryGain[i] = 1.0f;
+
+    // <FS> Voice allocation
+    mVoiceAllocator.resetStats();
+    mVoiceReportedStarved = 0;
+    // </FS>
 }
 
 
@@ -251,8 +260,13 @@ void LLAudioEngine::idle()
         }
     }
 
-    F32 max_priority = -1.f;
-    LLAudioSource *max_sourcep = NULL; // Maximum priority source without a channel
+    // <FS> Voice allocation
+    //F32 max_priority = -1.f;
+    //LLAudioSource *max_sourcep = NULL; // Maximum priority source without a channel
+    const LLVector3 listener_pos = getListenerPos();
+    mVoiceRequests.clear();
+    mVoiceRequestSources.clear();
+    // </FS>
     source_map::iterator iter;
     for (iter = mAllSources.begin(); iter != mAllSources.end();)
     {
@@ -260,7 +274,10 @@ void LLAudioEngine::idle()
 
         // Update this source
         sourcep->update();
-        sourcep->updatePriority();
+        // <FS> Voice allocation
+        //sourcep->updatePriority();
+        sourcep->updatePriority(listener_pos);
+        // </FS>
 
         if (sourcep->isDone())
         {
@@ -279,11 +296,18 @@ void LLAudioEngine::idle()
         if (!sourcep->getChannel() && sourcep->getCurrentBuffer())
         {
             // We could potentially play this sound if its priority is high enough.
-            if (sourcep->getPriority() > max_priority)
-            {
-                max_priority = sourcep->getPriority();
-                max_sourcep = sourcep;
-            }
+            // <FS> Voice allocation
+            //if (sourcep->getPriority() > max_priority)
+            //{
+            //    max_priority = sourcep->getPriority();
+            //    max_sourcep = sourcep;
+            //}
+            FSAudioVoiceAllocator::Request request;
+            request.mPriority = sourcep->getPriority();
+            request.mSource = (U32)mVoiceRequestSources.size();
+            mVoiceRequests.push_back(request);
+            mVoiceRequestSources.push_back(sourcep);
+            // </FS>
         }
 
         // Move on to the next source
@@ -293,27 +317,31 @@ void LLAudioEngine::idle()
     // Now, do priority-based organization of audio sources.
     // All channels used, check priorities.
     // Find channel with lowest priority
-    if (max_sourcep)
-    {
-        LLAudioChannel *channelp = getFreeChannel(max_priority);
-        if (channelp)
-        {
-            //LL_INFOS() << "Replacing source in channel due to priority!" << LL_ENDL;
-            max_sourcep->setChannel(channelp);
-            channelp->setSource(max_sourcep);
-            if (max_sourcep->isSyncSlave())
-            {
-                // A sync slave, it doesn't start playing until it's synced up with the master.
-                // Flag this channel as waiting for sync, and return true.
-                channelp->setWaiting(true);
-            }
-            else
-            {
-                channelp->setWaiting(false);
-                channelp->play();
-            }
-        }
-    }
+    // <FS> Voice allocation: hand out all channels at once instead of one
+    // source per frame
+    //if (max_sourcep)
+    //{
+    //    LLAudioChannel *channelp = getFreeChannel(max_priority);
+    //    if (channelp)
+    //    {
+    //        //LL_INFOS() << "Replacing source in channel due to priority!" << LL_ENDL;
+    //        max_sourcep->setChannel(channelp);
+    //        channelp->setSource(max_sourcep);
+    //        if (max_sourcep->isSyncSlave())
+    //        {
+    //            // A sync slave, it doesn't start playing until it's synced up with the master.
+    //            // Flag this channel as waiting for sync, and return true.
+    //            channelp->setWaiting(true);
+    //        }
+    //        else
+    //        {
+    //            channelp->setWaiting(false);
+    //            channelp->play();
+    //        }
+    //    }
+    //}
+    allocateVoices();
+    // </FS>
 
 
     // Do this BEFORE we update the channels
@@ -586,6 +614,74 @@ LLAudioBuffer * LLAudioEngine::getFreeBuffer()
 }
 
 
+// <FS> Voice allocation
+void LLAudioEngine::allocateVoices()
+{
+    if (!mVoiceRequests.empty())
+    {
+        mVoices.resize(LL_MAX_AUDIO_CHANNELS);
+        for (S32 i = 0; i < LL_MAX_AUDIO_CHANNELS; i++)
+        {
+            LLAudioChannel *channelp = mChannels[i];
+            FSAudioVoiceAllocator::Voice& voice = mVoices[i];
+            voice.mBusy = channelp && (channelp->isPlaying() || channelp->isWaiting());
+            voice.mPriority = (voice.mBusy && channelp->getSource()) ? channelp->getSource()->getPriority() : 0.f;
+        }
+
+        mVoiceAllocator.allocate(mVoiceRequests, mVoices, mVoiceAssignments);
+
+        for (const FSAudioVoiceAllocator::Assignment& assignment : mVoiceAssignments)
+        {
+            LLAudioSource *sourcep = mVoiceRequestSources[assignment.mSource];
+            LLAudioChannel *channelp = mChannels[assignment.mVoice];
+            if (!channelp)
+            {
+                // No channel allocated here, use it.
+                channelp = mChannels[assignment.mVoice] = createChannel();
+                if (!channelp)
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                // Idle, or playing something less important
+                channelp->cleanup();
+                if (channelp->getSource())
+                {
+                    channelp->getSource()->setChannel(NULL);
+                }
+            }
+
+            sourcep->setChannel(channelp);
+            channelp->setSource(sourcep);
+            if (sourcep->isSyncSlave())
+            {
+                // A sync slave, it doesn't start playing until it's synced up with the master.
+                // Flag this channel as waiting for sync.
+                channelp->setWaiting(true);
+            }
+            else
+            {
+                channelp->setWaiting(false);
+                channelp->play();
+            }
+        }
+    }
+
+    // Only worth a line in the log if sounds had to wait for a channel
+    if (mVoiceReportTimer.getElapsedTimeF32() > VOICE_REPORT_INTERVAL)
+    {
+        mVoiceReportTimer.reset();
+        if (mVoiceAllocator.getTotalStarved() != mVoiceReportedStarved)
+        {
+            mVoiceReportedStarved = mVoiceAllocator.getTotalStarved();
+            LL_INFOS("AudioEngine") << "Audio channels: " << mVoiceAllocator.getSummary() << LL_ENDL;
+        }
+    }
+}
+// </FS>
+
 LLAudioChannel * LLAudioEngine::getFreeChannel(const F32 priority)
 {
     S32 i;
@@ -1306,7 +1402,11 @@ LLAudioSource::LLAudioSource(const LLUUID& id, const LLUUID& owner_id, const F32
     mQueuedDatap(NULL),
 // NaCl - Sound explorer
     mSourceID(source_id),
-    mIsTrigger(isTrigger)
+    mIsTrigger(isTrigger),
+    // <FS> Voice allocation
+    mPriorityCached(false),
+    mPriorityGain(0.f)
+    // </FS>
 {
     mLogID.generate();
 }
@@ -1445,31 +1545,66 @@ void LLAudioSource::update()
 }
 
 void LLAudioSource::updatePriority()
+{
+    // <FS> Voice allocation
+    //if (isForcedPriority())
+    //{
+    //    mPriority = 1.f;
+    //}
+    //else if (isMuted())
+    //{
+    //    mPriority = 0.f;
+    //}
+    //else
+    //{
+    //    // Priority is based on distance
+    //    LLVector3 dist_vec;
+    //    dist_vec.setVec(getPositionGlobal());
+    //
+    //    if (gAudiop)
+    //    {
+    //        dist_vec -= gAudiop->getListenerPos();
+    //    }
+    //
+    //    F32 dist_squared = llmax(1.f, dist_vec.magVecSquared());
+    //
+    //    mPriority = mGain / dist_squared;
+    //}
+    updatePriority(gAudiop ? gAudiop->getListenerPos() : LLVector3::zero);
+    // </FS>
+}
+
+// <FS> Voice allocation
+void LLAudioSource::updatePriority(const LLVector3& listener_pos)
 {
     if (isForcedPriority())
     {
         mPriority = 1.f;
+        mPriorityCached = false;
     }
     else if (isMuted())
     {
         mPriority = 0.f;
+        mPriorityCached = false;
     }
-    else
+    else if (!mPriorityCached || mPriorityGain != mGain || mPriorityPosition != mPositionGlobal || mPriorityListener != listener_pos)
     {
-        // Priority is based on distance
+        // Priority is based on distance; most sources and the listener stand
+        // still, so it is only attenuated again once something moved
         LLVector3 dist_vec;
-        dist_vec.setVec(getPositionGlobal());
-
-        if (gAudiop)
-        {
-            dist_vec -= gAudiop->getListenerPos();
-        }
+        dist_vec.setVec(mPositionGlobal);
+        dist_vec -= listener_pos;
 
         F32 dist_squared = llmax(1.f, dist_vec.magVecSquared());
 
         mPriority = mGain / dist_squared;
+        mPriorityCached = true;
+        mPriorityGain = mGain;
+        mPriorityPosition = mPositionGlobal;
+        mPriorityListener = listener_pos;
     }
 }
+// </FS>
 
 bool LLAudioSource::setupChannel()
 {
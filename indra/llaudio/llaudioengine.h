@@ -43,6 +43,7 @@
 #include "lllistener.h"
 
 #include <boost/signals2.hpp> // <FS:Ansariel> Output device selection
+#include "fsaudiovoiceallocator.h" // <FS> Voice allocation
 
 const F32 LL_WIND_UPDATE_INTERVAL = 0.1f;
 const F32 LL_WIND_UNDERWATER_CENTER_FREQ = 20.f;
@@ -175,6 +176,9 @@ public:
 
     LLAudioBuffer *getFreeBuffer(); // Get a free buffer, or flush an existing one if you have to.
     LLAudioChannel *getFreeChannel(const F32 priority); // Get a free channel or flush an existing one if your priority is higher
+    // <FS> Voice allocation
+    const FSAudioVoiceAllocator& getVoiceAllocator() const { return mVoiceAllocator; }
+    // </FS>
     void cleanupBuffer(LLAudioBuffer *bufferp);
 
     bool hasDecodedFile(const LLUUID &uuid);
@@ -218,6 +222,10 @@ protected:
 
     void commitDeferredChanges();
 
+    // <FS> Voice allocation
+    void allocateVoices();
+    // </FS>
+
     virtual void allocateListener() = 0;
 
 
@@ -279,6 +287,16 @@ private:
 
     std::map<LLUUID,U32> mCorruptData;
 
+    // <FS> Voice allocation
+    FSAudioVoiceAllocator                       mVoiceAllocator;
+    std::vector<FSAudioVoiceAllocator::Request> mVoiceRequests;
+    std::vector<LLAudioSource*>                 mVoiceRequestSources;
+    std::vector<FSAudioVoiceAllocator::Voice>   mVoices;
+    std::vector<FSAudioVoiceAllocator::Assignment> mVoiceAssignments;
+    LLFrameTimer                                mVoiceReportTimer;
+    U64                                         mVoiceReportedStarved;
+    // </FS>
+
 public:
     void markSoundCorrupt( LLUUID const & );
     bool isCorruptSound( LLUUID const& ) const;
@@ -306,6 +324,8 @@ public:
 
     virtual void update();                      // Update this audio source
     void updatePriority();
+    // <FS> Voice allocation: the engine looks up the listener once per frame
+    void updatePriority(const LLVector3& listener_pos);
 
     void preload(const LLUUID &audio_id); // Only used for preloading UI sounds, now.
 
@@ -405,6 +425,13 @@ protected:
     data_map mPreloadMap;
 
     LLFrameTimer mAgeTimer;
+
+    // <FS> Voice allocation: inputs of the last distance attenuated priority
+    bool            mPriorityCached;
+    F32             mPriorityGain;
+    LLVector3d      mPriorityPosition;
+    LLVector3       mPriorityListener;
+    // </FS>
 };
 
 
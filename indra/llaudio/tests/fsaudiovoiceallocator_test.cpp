@@ -0,0 +1,367 @@
+/**
+ * @file fsaudiovoiceallocator_test.cpp
+ * @brief Voice allocation and audio source churn replay
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsaudiovoiceallocator.h"
+
+#include "lltimer.h"
+
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    typedef FSAudioVoiceAllocator::Request Request;
+    typedef FSAudioVoiceAllocator::Voice Voice;
+    typedef FSAudioVoiceAllocator::Assignment Assignment;
+
+    Request make_request(U32 source, F32 priority)
+    {
+        Request request;
+        request.mSource = source;
+        request.mPriority = priority;
+        return request;
+    }
+
+    Voice make_voice(bool busy, F32 priority)
+    {
+        Voice voice;
+        voice.mBusy = busy;
+        voice.mPriority = priority;
+        return voice;
+    }
+
+    const S32 NUM_VOICES = 30;
+
+    // Stands in for the audio backend: a sound holds its voice until it
+    // played to the end, then the voice is idle again.
+    struct Sound
+    {
+        F32 mPriority;
+        S32 mStart;         // frame the sound was triggered
+        S32 mLength;        // frames
+        S32 mVoice;         // -1 while waiting
+        S32 mPlayedFrom;    // frame it got a voice, -1 if never
+        bool mImportant;
+    };
+
+    struct ReplayResult
+    {
+        S32 mImportant;
+        S32 mImportantWait;     // frames, summed
+        S32 mImportantMaxWait;
+        S32 mDropped;           // sounds that expired without a voice
+        S32 mStolen;
+    };
+
+    // A busy club: dozens of sounds triggered every second all around the
+    // listener, with a close gunshot now and then that must be heard at once
+    std::vector<Sound> record_sounds()
+    {
+        std::vector<Sound> sounds;
+        U32 seed = 12345;
+        for (S32 frame = 0; frame < 900; ++frame)
+        {
+            for (S32 i = 0; i < 4; ++i)
+            {
+                seed = seed * 1664525 + 1013904223;
+                Sound sound;
+                sound.mPriority = 0.001f + (F32)(seed >> 8) / (F32)(1 << 24) * 0.05f;
+                sound.mStart = frame;
+                sound.mLength = 15 + (S32)((seed >> 4) % 75);
+                sound.mVoice = -1;
+                sound.mPlayedFrom = -1;
+                sound.mImportant = false;
+                sounds.push_back(sound);
+            }
+            if (frame % 20 == 10)
+            {
+                for (S32 i = 0; i < 3; ++i)
+                {
+                    Sound sound;
+                    sound.mPriority = 0.5f + 0.1f * i;
+                    sound.mStart = frame;
+                    sound.mLength = 10;
+                    sound.mVoice = -1;
+                    sound.mPlayedFrom = -1;
+                    sound.mImportant = true;
+                    sounds.push_back(sound);
+                }
+            }
+        }
+        return sounds;
+    }
+
+    // bulk: the allocator; otherwise the previous engine behaviour, which
+    // gave a voice to the single most important waiting sound per frame
+    ReplayResult replay(std::vector<Sound> sounds, bool bulk)
+    {
+        FSAudioVoiceAllocator allocator;
+        std::vector<S32> voice_owner(NUM_VOICES, -1);
+        std::vector<Voice> voices(NUM_VOICES);
+        std::vector<Request> requests;
+        std::vector<Assignment> assignments;
+        ReplayResult result = { 0, 0, 0, 0, 0 };
+
+        const S32 last_frame = sounds.back().mStart + 100;
+        size_t first_live = 0;
+        for (S32 frame = 0; frame < last_frame; ++frame)
+        {
+            for (S32 v = 0; v < NUM_VOICES; ++v)
+            {
+                S32 owner = voice_owner[v];
+                if (owner >= 0 && sounds[owner].mPlayedFrom + sounds[owner].mLength <= frame)
+                {
+                    voice_owner[v] = -1;
+                    sounds[owner].mVoice = -1;
+                }
+                voices[v] = make_voice(voice_owner[v] >= 0, voice_owner[v] >= 0 ? sounds[voice_owner[v]].mPriority : 0.f);
+            }
+
+            requests.clear();
+            while (first_live < sounds.size() && sounds[first_live].mStart + sounds[first_live].mLength <= frame)
+            {
+                ++first_live;
+            }
+            for (size_t i = first_live; i < sounds.size() && sounds[i].mStart <= frame; ++i)
+            {
+                // Trigger sounds that never got a voice die with their timeout
+                if (sounds[i].mPlayedFrom < 0 && sounds[i].mStart + sounds[i].mLength > frame)
+                {
+                    requests.push_back(make_request((U32)i, sounds[i].mPriority));
+                }
+            }
+
+            if (bulk)
+            {
+                allocator.allocate(requests, voices, assignments);
+            }
+            else
+            {
+                assignments.clear();
+                S32 best = -1;
+                for (size_t i = 0; i < requests.size(); ++i)
+                {
+                    if (best < 0 || requests[i].mPriority > requests[best].mPriority)
+                    {
+                        best = (S32)i;
+                    }
+                }
+                S32 lowest = -1;
+                for (S32 v = 0; best >= 0 && v < NUM_VOICES; ++v)
+                {
+                    if (!voices[v].mBusy)
+                    {
+                        lowest = v;
+                        break;
+                    }
+                    if (lowest < 0 || voices[v].mPriority < voices[lowest].mPriority)
+                    {
+                        lowest = v;
+                    }
+                }
+                if (best >= 0 && lowest >= 0 && (!voices[lowest].mBusy || voices[lowest].mPriority <= requests[best].mPriority))
+                {
+                    Assignment assignment = { requests[best].mSource, (U32)lowest, voices[lowest].mBusy };
+                    assignments.push_back(assignment);
+                }
+            }
+
+            for (size_t i = 0; i < assignments.size(); ++i)
+            {
+                const Assignment& assignment = assignments[i];
+                if (voice_owner[assignment.mVoice] >= 0)
+                {
+                    // Stolen sounds are cut off, as in the engine
+                    Sound& victim = sounds[voice_owner[assignment.mVoice]];
+                    victim.mVoice = -1;
+                    victim.mLength = frame - victim.mPlayedFrom;
+                    ++result.mStolen;
+                }
+                Sound& sound = sounds[assignment.mSource];
+                sound.mVoice = (S32)assignment.mVoice;
+                sound.mPlayedFrom = frame;
+                voice_owner[assignment.mVoice] = (S32)assignment.mSource;
+            }
+        }
+
+        for (size_t i = 0; i < sounds.size(); ++i)
+        {
+            const Sound& sound = sounds[i];
+            if (sound.mPlayedFrom < 0)
+            {
+                ++result.mDropped;
+            }
+            if (sound.mImportant)
+            {
+                S32 wait = sound.mPlayedFrom < 0 ? sound.mLength : sound.mPlayedFrom - sound.mStart;
+                ++result.mImportant;
+                result.mImportantWait += wait;
+                result.mImportantMaxWait = llmax(result.mImportantMaxWait, wait);
+            }
+        }
+        return result;
+    }
+}
+
+namespace tut
+{
+    struct audiovoiceallocator_data
+    {
+        FSAudioVoiceAllocator mAllocator;
+        std::vector<Request> mRequests;
+        std::vector<Voice> mVoices;
+        std::vector<Assignment> mAssignments;
+    };
+    typedef test_group<audiovoiceallocator_data> audiovoiceallocator_t;
+    typedef audiovoiceallocator_t::object audiovoiceallocator_object_t;
+    tut::audiovoiceallocator_t tut_audiovoiceallocator("FSAudioVoiceAllocator");
+
+    template<> template<>
+    void audiovoiceallocator_object_t::test<1>()
+    {
+        set_test_name("Free voices");
+        mVoices.push_back(make_voice(false, 0.f));
+        mVoices.push_back(make_voice(true, 0.9f));
+        mVoices.push_back(make_voice(false, 0.f));
+        for (U32 i = 0; i < 10; ++i)
+        {
+            mRequests.push_back(make_request(i, 0.01f * (F32)((i * 7) % 10)));
+        }
+
+        mAllocator.allocate(mRequests, mVoices, mAssignments);
+        ensure_equals("two free voices", mAssignments.size(), (size_t)2);
+        // Priorities 0.09 and 0.08 belong to sources 7 and 4
+        ensure_equals("most important first", mAssignments[0].mSource, 7U);
+        ensure_equals("first free voice", mAssignments[0].mVoice, 0U);
+        ensure_equals("next most important", mAssignments[1].mSource, 4U);
+        ensure_equals("second free voice", mAssignments[1].mVoice, 2U);
+        ensure("nothing stolen", !mAssignments[0].mStolen && !mAssignments[1].mStolen);
+        ensure_equals("starved", mAllocator.getLastStarved(), 8U);
+        ensure_equals("starved total", mAllocator.getTotalStarved(), (U64)8);
+    }
+
+    template<> template<>
+    void audiovoiceallocator_object_t::test<2>()
+    {
+        set_test_name("Stealing voices");
+        mVoices.push_back(make_voice(true, 0.5f));
+        mVoices.push_back(make_voice(true, 0.1f));
+        mVoices.push_back(make_voice(true, 0.3f));
+        mRequests.push_back(make_request(0, 0.3f));
+        mRequests.push_back(make_request(1, 0.4f));
+        mRequests.push_back(make_request(2, 0.05f));
+
+        mAllocator.allocate(mRequests, mVoices, mAssignments);
+        // 0.4 takes the 0.1 voice, 0.3 doesn't take the equal 0.3 voice
+        ensure_equals("one steal", mAssignments.size(), (size_t)1);
+        ensure_equals("most important", mAssignments[0].mSource, 1U);
+        ensure_equals("least important voice", mAssignments[0].mVoice, 1U);
+        ensure("stolen", mAssignments[0].mStolen);
+        ensure_equals("stolen count", mAllocator.getLastStolen(), 1U);
+        ensure_equals("starved", mAllocator.getLastStarved(), 2U);
+        ensure_equals("starved frames", mAllocator.getStarvedFrames(), (U64)1);
+
+        mRequests.clear();
+        mAllocator.allocate(mRequests, mVoices, mAssignments);
+        ensure("nothing to do", mAssignments.empty());
+        ensure_equals("frames", mAllocator.getFrames(), (U64)2);
+        ensure_equals("starved frames unchanged", mAllocator.getStarvedFrames(), (U64)1);
+    }
+
+    template<> template<>
+    void audiovoiceallocator_object_t::test<3>()
+    {
+        set_test_name("Bulk reassignment");
+        // Everything busy with distant sounds, a crowd arrives next to the listener
+        for (S32 i = 0; i < NUM_VOICES; ++i)
+        {
+            mVoices.push_back(make_voice(true, 0.001f * i));
+        }
+        for (U32 i = 0; i < 200; ++i)
+        {
+            mRequests.push_back(make_request(i, i < 40 ? 0.5f + 0.01f * i : 0.0001f));
+        }
+
+        mAllocator.allocate(mRequests, mVoices, mAssignments);
+        ensure_equals("every voice in one frame", mAssignments.size(), (size_t)NUM_VOICES);
+        std::vector<bool> voice_used(NUM_VOICES, false);
+        for (size_t i = 0; i < mAssignments.size(); ++i)
+        {
+            ensure("only the crowd", mAssignments[i].mSource >= 10 && mAssignments[i].mSource < 40);
+            ensure("voice used once", !voice_used[mAssignments[i].mVoice]);
+            voice_used[mAssignments[i].mVoice] = true;
+        }
+        ensure_equals("all stolen", mAllocator.getLastStolen(), (U32)NUM_VOICES);
+        ensure_equals("rest starved", mAllocator.getLastStarved(), 200U - NUM_VOICES);
+        ensure("summary", mAllocator.getSummary().find("30 stolen") != std::string::npos);
+    }
+
+    template<> template<>
+    void audiovoiceallocator_object_t::test<4>()
+    {
+        set_test_name("Busy region replay");
+        std::vector<Sound> sounds = record_sounds();
+        ReplayResult single = replay(sounds, false);
+        ReplayResult bulk = replay(sounds, true);
+
+        // Close sounds get a voice the frame they are triggered
+        ensure("important sounds", bulk.mImportant > 0);
+        ensure_equals("no wait for important sounds", bulk.mImportantMaxWait, 0);
+        ensure("single promotion made them wait", single.mImportantWait > 0);
+        ensure("fewer sounds dropped", bulk.mDropped < single.mDropped);
+
+        // Cost of one frame with a few hundred waiting sources
+        std::vector<Voice> voices;
+        for (S32 i = 0; i < NUM_VOICES; ++i)
+        {
+            voices.push_back(make_voice(true, 0.02f + 0.001f * i));
+        }
+        std::vector<Request> requests;
+        std::vector<Assignment> assignments;
+        const S32 frames = 2000;
+        LLTimer timer;
+        for (S32 frame = 0; frame < frames; ++frame)
+        {
+            requests.clear();
+            for (U32 i = 0; i < 500; ++i)
+            {
+                requests.push_back(make_request(i, 0.0001f * (F32)((i * 7919 + frame) % 500)));
+            }
+            mAllocator.allocate(requests, voices, assignments);
+        }
+        F64 us = timer.getElapsedTimeF64() * 1000000.0 / frames;
+
+        std::cout << std::endl << "FSAudioVoiceAllocator replay: important sounds waited " << single.mImportantWait
+                  << " frames (max " << single.mImportantMaxWait << ") with one promotion per frame, " << bulk.mImportantWait
+                  << " (max " << bulk.mImportantMaxWait << ") allocating in bulk; dropped " << single.mDropped << " vs " << bulk.mDropped
+                  << " of " << sounds.size() << ", " << bulk.mStolen << " steals; " << us << " us per frame for 500 waiting sources" << std::endl;
+    }
+}
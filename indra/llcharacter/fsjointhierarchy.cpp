@@ -0,0 +1,267 @@
+/**
+ * @file fsjointhierarchy.cpp
+ * @brief Flattened, topologically ordered joint hierarchy of a skeleton
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "fsjointhierarchy.h"
+
+#include "lljoint.h"
+#include "llvector4logical.h"
+
+namespace
+{
+    // out = a * b in LLQuaternion terms: rotation a, then rotation b
+    inline void quat_mul(LLVector4a& out, const LLVector4a& a, const LLVector4a& b)
+    {
+        LLVector4a a_w, b_w;
+        a_w.splat<3>(a);
+        b_w.splat<3>(b);
+
+        LLVector4a xyz, term;
+        xyz.setCross3(b, a);
+        term.setMul(b_w, a);
+        xyz.add(term);
+        term.setMul(a_w, b);
+        xyz.add(term);
+
+        LLVector4a w, dot;
+        w.setMul(a_w, b_w);
+        dot.setAllDot3(a, b);
+        w.sub(dot);
+
+        LLVector4Logical w_lane;
+        w_lane.clear();
+        w_lane.setElement<3>();
+        out.setSelectWithMask(w_lane, w, xyz);
+    }
+
+    // out = v * q in LLVector3 terms, v rotated by the unit quaternion q
+    inline void quat_rotate(LLVector4a& out, const LLVector4a& v, const LLVector4a& q)
+    {
+        LLVector4a t;
+        t.setCross3(q, v);
+        t.add(t);
+
+        LLVector4a q_w, term;
+        q_w.splat<3>(q);
+        out.setMul(q_w, t);
+        out.add(v);
+        term.setCross3(q, t);
+        out.add(term);
+    }
+}
+
+FSJointHierarchy::FSJointHierarchy()
+{
+}
+
+FSJointHierarchy::~FSJointHierarchy()
+{
+    clear();
+}
+
+void FSJointHierarchy::build(LLJoint* root)
+{
+    clear();
+
+    addJoint(root, -1);
+
+    U32 count = (U32)mJoints.size();
+    mWorldPositions.resize(count);
+    mWorldRotations.resize(count);
+    mWorldMatrices.resize(count);
+    for (U32 i = 0; i < count; ++i)
+    {
+        LLJoint* joint = mJoints[i];
+        mWorldPositions.mArray[i].load3(joint->mXform.getWorldPosition().mV);
+        mWorldRotations.mArray[i].loadua(joint->mXform.getWorldRotation().mQ);
+        mWorldMatrices.mArray[i] = joint->mWorldMatrix;
+        joint->mHierarchy = this;
+        joint->mHierarchyIndex = (S32)i;
+    }
+}
+
+void FSJointHierarchy::addJoint(LLJoint* joint, S32 parent)
+{
+    if (joint->mHierarchy && joint->mHierarchy != this)
+    {
+        joint->mHierarchy->clear();
+    }
+
+    // Depth first, so the descendants follow the joint without gaps
+    S32 index = (S32)mJoints.size();
+    mJoints.push_back(joint);
+    mParents.push_back(parent);
+    mSubtreeEnds.push_back(index + 1);
+    mDirtyFlags.push_back(joint->mDirtyFlags);
+
+    for (LLJoint* child : joint->mChildren)
+    {
+        if (child)
+        {
+            addJoint(child, index);
+        }
+    }
+    mSubtreeEnds[index] = (S32)mJoints.size();
+}
+
+void FSJointHierarchy::clear()
+{
+    for (size_t i = 0; i < mJoints.size(); ++i)
+    {
+        LLJoint* joint = mJoints[i];
+        joint->mDirtyFlags = mDirtyFlags[i];
+        joint->mWorldMatrix = mWorldMatrices.mArray[i];
+        joint->mHierarchy = NULL;
+        joint->mHierarchyIndex = -1;
+    }
+    mJoints.clear();
+    mParents.clear();
+    mSubtreeEnds.clear();
+    mDirtyFlags.clear();
+    // The aligned arrays keep their size, build() overwrites what it uses
+}
+
+void FSJointHierarchy::touch(S32 index, U32 flags)
+{
+    // Descendants of a dirty joint are always at least as dirty, so there
+    // is nothing to do if the joint already has all the flags
+    U32& joint_flags = mDirtyFlags[index];
+    if ((flags | joint_flags) == joint_flags)
+    {
+        return;
+    }
+    LLJoint::sNumTouches++;
+    joint_flags |= flags;
+
+    U32 child_flags = flags;
+    if (flags & LLJoint::ROTATION_DIRTY)
+    {
+        child_flags |= LLJoint::POSITION_DIRTY;
+    }
+    U32* dirty = mDirtyFlags.data();
+    for (S32 i = index + 1, end = mSubtreeEnds[index]; i < end; ++i)
+    {
+        dirty[i] |= child_flags;
+    }
+}
+
+void FSJointHierarchy::updateParentChain(S32 index, bool update_matrix)
+{
+    const U32 flags = update_matrix ? (U32)LLJoint::MATRIX_DIRTY : (U32)(LLJoint::ROTATION_DIRTY | LLJoint::POSITION_DIRTY);
+
+    mChain.clear();
+    for (S32 i = index; i >= 0 && (mDirtyFlags[i] & flags); i = mParents[i])
+    {
+        mChain.push_back(i);
+    }
+
+    for (std::vector<S32>::reverse_iterator it = mChain.rbegin(); it != mChain.rend(); ++it)
+    {
+        if (update_matrix)
+        {
+            updateMatrix(*it);
+        }
+        else
+        {
+            updatePRS(*it);
+            mDirtyFlags[*it] &= ~(LLJoint::ROTATION_DIRTY | LLJoint::POSITION_DIRTY);
+        }
+    }
+}
+
+void FSJointHierarchy::updateSubtree(S32 index)
+{
+    const U32* dirty = mDirtyFlags.data();
+    S32 i = index;
+    const S32 end = mSubtreeEnds[index];
+    while (i < end)
+    {
+        if (!mJoints[i]->mUpdateXform)
+        {
+            i = mSubtreeEnds[i];
+            continue;
+        }
+        if (dirty[i] & LLJoint::MATRIX_DIRTY)
+        {
+            updateMatrix(i);
+        }
+        ++i;
+    }
+}
+
+void FSJointHierarchy::updatePRS(S32 index)
+{
+    LLXformMatrix& xform = mJoints[index]->mXform;
+    S32 parent = mParents[index];
+    if (parent < 0)
+    {
+        // The root may hang off an object the avatar sits on, let the xform
+        // deal with that
+        xform.update();
+        mWorldPositions.mArray[index].load3(xform.getWorldPosition().mV);
+        mWorldRotations.mArray[index].loadua(xform.getWorldRotation().mQ);
+        return;
+    }
+
+    LLXformMatrix& parent_xform = mJoints[parent]->mXform;
+    const LLVector4a& parent_rotation = mWorldRotations.mArray[parent];
+
+    LLVector4a offset;
+    offset.load3(xform.getPosition().mV);
+    if (parent_xform.getScaleChildOffset())
+    {
+        LLVector4a parent_scale;
+        parent_scale.load3(parent_xform.getScale().mV);
+        offset.mul(parent_scale);
+    }
+
+    LLVector4a& position = mWorldPositions.mArray[index];
+    quat_rotate(position, offset, parent_rotation);
+    position.add(mWorldPositions.mArray[parent]);
+
+    LLVector4a local_rotation;
+    local_rotation.loadua(xform.getRotation().mQ);
+    LLVector4a& rotation = mWorldRotations.mArray[index];
+    quat_mul(rotation, local_rotation, parent_rotation);
+
+    xform.setWorldPRS(LLVector3(position.getF32ptr()),
+                      LLQuaternion(rotation[VX], rotation[VY], rotation[VZ], rotation[VW]));
+}
+
+void FSJointHierarchy::updateMatrix(S32 index)
+{
+    LLJoint::sNumUpdates++;
+    updatePRS(index);
+
+    LLXformMatrix& xform = mJoints[index]->mXform;
+    LLMatrix4 world_matrix;
+    world_matrix.initAll(xform.getScale(), xform.getWorldRotation(), xform.getWorldPosition());
+    xform.setWorldMatrix(world_matrix);
+    mWorldMatrices.mArray[index].loadu(world_matrix);
+    mDirtyFlags[index] = 0;
+}
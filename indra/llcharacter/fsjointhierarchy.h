@@ -0,0 +1,101 @@
+/**
+ * @file fsjointhierarchy.h
+ * @brief Flattened, topologically ordered joint hierarchy of a skeleton
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_JOINTHIERARCHY_H
+#define FS_JOINTHIERARCHY_H
+
+#include "llmath.h"
+#include "llalignedarray.h"
+#include "llmatrix4a.h"
+
+#include <vector>
+
+class LLJoint;
+
+// The joints of one skeleton flattened in depth first order, so every joint
+// comes after its parent and the descendants of a joint are the contiguous
+// range up to its subtree end. Dirty flags and world transforms of the
+// joints live in arrays here instead of in the joints themselves:
+// touching a joint dirties its descendants with a single linear loop, and
+// updating the skeleton is one pass from the root to the leaves instead of
+// a recursion through the joint objects.
+//
+// The root joint builds the hierarchy on its first updateWorldMatrixChildren()
+// and owns it. Adding or removing a child anywhere in the skeleton clears it,
+// the joints then fall back to their own storage until the root builds it
+// again. World transforms are still mirrored into the joints' LLXformMatrix,
+// attached objects and the renderer read them from there.
+class FSJointHierarchy
+{
+public:
+    FSJointHierarchy();
+    ~FSJointHierarchy();
+
+    // Flattens the skeleton below root; the joints read from here afterwards
+    void build(LLJoint* root);
+
+    // Hands dirty flags and world matrices back to the joints and forgets them
+    void clear();
+
+    bool isEmpty() const { return mJoints.empty(); }
+    S32 getNumJoints() const { return (S32)mJoints.size(); }
+    LLJoint* getJoint(S32 index) const { return mJoints[index]; }
+
+    // Flags the joint and, with position also dirty after a rotation, its descendants
+    void touch(S32 index, U32 flags);
+
+    U32& getDirtyFlags(S32 index) { return mDirtyFlags[index]; }
+
+    // Brings the joint and its dirty ancestors up to date, like
+    // LLJoint::updateWorldPRSParent() or updateWorldMatrixParent()
+    void updateParentChain(S32 index, bool update_matrix);
+
+    // Updates the world matrix of the joint from the current one of its parent
+    void updateMatrix(S32 index);
+
+    // Updates the world matrices of the subtree of the joint in one pass,
+    // skipping subtrees of joints that don't update their transform
+    void updateSubtree(S32 index);
+
+    const LLMatrix4a& getWorldMatrix(S32 index) const { return mWorldMatrices.mArray[index]; }
+
+private:
+    void addJoint(LLJoint* joint, S32 parent);
+    void updatePRS(S32 index);
+
+    std::vector<LLJoint*>   mJoints;
+    std::vector<S32>        mParents;       // -1 for the root
+    std::vector<S32>        mSubtreeEnds;   // one past the last descendant
+    std::vector<U32>        mDirtyFlags;
+    std::vector<S32>        mChain;         // scratch for updateParentChain()
+
+    LLAlignedArray<LLVector4a, 64>  mWorldPositions;
+    LLAlignedArray<LLVector4a, 64>  mWorldRotations;   // quaternions, x y z w
+    LLAlignedArray<LLMatrix4a, 64>  mWorldMatrices;
+};
+
+#endif // FS_JOINTHIERARCHY_H
@@ -41,7 +41,8 @@
 
 class LLPolyMesh;
 
-class LLPauseRequestHandle : public LLThreadSafeRefCount
+//class LLPauseRequestHandle : public LLThreadSafeRefCount
+class LLPauseRequestHandle : public LLMainThreadRefCount // <FS/> Only used on the main thread
 {
 public:
     LLPauseRequestHandle() {};
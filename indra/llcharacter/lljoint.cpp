@@ -30,6 +30,7 @@
 #include "linden_common.h"
 
 #include "lljoint.h"
+#include "fsjointhierarchy.h" // <FS> Flattened joint hierarchy
 
 #include "llmath.h"
 #include "llcallstack.h"
@@ -55,6 +56,7 @@ JointKey JointKey::construct(const std::string& aName)
 
 S32 LLJoint::sNumUpdates = 0;
 S32 LLJoint::sNumTouches = 0;
+bool LLJoint::sUseFlattenedHierarchy = true; // <FS> Flattened joint hierarchy
 
 template <class T>
 bool attachment_map_iter_compare_key(const T& a, const T& b)
@@ -123,6 +125,10 @@ void LLJoint::init()
 {
     mName = "unnamed";
     mParent = NULL;
+    // <FS> Flattened joint hierarchy
+    mHierarchy = NULL;
+    mHierarchyIndex = -1;
+    // </FS>
     mXform.setScaleChildOffset(TRUE);
     mXform.setScale(LLVector3(1.0f, 1.0f, 1.0f));
     mDirtyFlags = MATRIX_DIRTY | ROTATION_DIRTY | POSITION_DIRTY;
@@ -169,6 +175,12 @@ LLJoint::LLJoint(const std::string &name, LLJoint *parent) :
 //-----------------------------------------------------------------------------
 LLJoint::~LLJoint()
 {
+    // <FS> Flattened joint hierarchy
+    if (mHierarchy)
+    {
+        mHierarchy->clear();
+    }
+    // </FS>
     if (mParent)
     {
         mParent->removeChild( this );
@@ -216,6 +228,13 @@ void LLJoint::setSupport(const std::string& support_name)
 //-----------------------------------------------------------------------------
 void LLJoint::touch(U32 flags)
 {
+    // <FS> Flattened joint hierarchy
+    if (mHierarchy)
+    {
+        mHierarchy->touch(mHierarchyIndex, flags);
+        return;
+    }
+    // </FS>
     if ((flags | mDirtyFlags) != mDirtyFlags)
     {
         sNumTouches++;
@@ -290,6 +309,18 @@ void LLJoint::addChild(LLJoint* joint)
     if (joint->mParent)
         joint->mParent->removeChild(joint);
 
+    // <FS> Flattened joint hierarchy: both skeletons change shape
+    if (mHierarchy)
+    {
+        mHierarchy->clear();
+    }
+    joint->mOwnedHierarchy.reset();
+    if (joint->mHierarchy)
+    {
+        joint->mHierarchy->clear();
+    }
+    // </FS>
+
     mChildren.push_back(joint);
     joint->mXform.setParent(&mXform);
     joint->mParent = this;
@@ -305,6 +336,12 @@ void LLJoint::removeChild(LLJoint* joint)
     joints_t::iterator iter = std::find(mChildren.begin(), mChildren.end(), joint);
     if (iter != mChildren.end())
     {
+        // <FS> Flattened joint hierarchy
+        if (mHierarchy)
+        {
+            mHierarchy->clear();
+        }
+        // </FS>
         mChildren.erase(iter);
 
         joint->mXform.setParent(NULL);
@@ -319,6 +356,12 @@ void LLJoint::removeChild(LLJoint* joint)
 //--------------------------------------------------------------------
 void LLJoint::removeAllChildren()
 {
+    // <FS> Flattened joint hierarchy
+    if (mHierarchy && !mChildren.empty())
+    {
+        mHierarchy->clear();
+    }
+    // </FS>
     for (LLJoint* joint : mChildren)
     {
         if (joint)
@@ -936,6 +979,12 @@ const LLMatrix4a& LLJoint::getWorldMatrix4a()
 {
     updateWorldMatrixParent();
 
+    // <FS> Flattened joint hierarchy
+    if (mHierarchy)
+    {
+        return mHierarchy->getWorldMatrix(mHierarchyIndex);
+    }
+    // </FS>
     return mWorldMatrix;
 }
 
@@ -963,6 +1012,13 @@ void LLJoint::setWorldMatrix( const LLMatrix4& mat )
 //-----------------------------------------------------------------------------
 void LLJoint::updateWorldMatrixParent()
 {
+    // <FS> Flattened joint hierarchy
+    if (mHierarchy)
+    {
+        mHierarchy->updateParentChain(mHierarchyIndex, true);
+        return;
+    }
+    // </FS>
     if (mDirtyFlags & MATRIX_DIRTY)
     {
         LLJoint *parent = getParent();
@@ -979,6 +1035,13 @@ void LLJoint::updateWorldMatrixParent()
 //-----------------------------------------------------------------------------
 void LLJoint::updateWorldPRSParent()
 {
+    // <FS> Flattened joint hierarchy
+    if (mHierarchy)
+    {
+        mHierarchy->updateParentChain(mHierarchyIndex, false);
+        return;
+    }
+    // </FS>
     if (mDirtyFlags & (ROTATION_DIRTY | POSITION_DIRTY))
     {
         LLJoint *parent = getParent();
@@ -999,6 +1062,31 @@ void LLJoint::updateWorldMatrixChildren()
 {
     if (!this->mUpdateXform) return;
 
+    // <FS> Flattened joint hierarchy: skeleton roots update all their
+    // joints in one pass over the flattened skeleton
+    if (!mParent && sUseFlattenedHierarchy)
+    {
+        if (!mOwnedHierarchy)
+        {
+            mOwnedHierarchy.reset(new FSJointHierarchy());
+        }
+        if (mOwnedHierarchy->isEmpty())
+        {
+            mOwnedHierarchy->build(this);
+        }
+    }
+    else if (mOwnedHierarchy && !sUseFlattenedHierarchy)
+    {
+        mOwnedHierarchy.reset();
+    }
+
+    if (mHierarchy)
+    {
+        mHierarchy->updateSubtree(mHierarchyIndex);
+        return;
+    }
+    // </FS>
+
     if (mDirtyFlags & MATRIX_DIRTY)
     {
         updateWorldMatrix();
@@ -1014,6 +1102,16 @@ void LLJoint::updateWorldMatrixChildren()
 //-----------------------------------------------------------------------------
 void LLJoint::updateWorldMatrix()
 {
+    // <FS> Flattened joint hierarchy
+    if (mHierarchy)
+    {
+        if (mHierarchy->getDirtyFlags(mHierarchyIndex) & MATRIX_DIRTY)
+        {
+            mHierarchy->updateMatrix(mHierarchyIndex);
+        }
+        return;
+    }
+    // </FS>
     if (mDirtyFlags & MATRIX_DIRTY)
     {
         sNumUpdates++;
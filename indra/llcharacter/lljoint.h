@@ -32,6 +32,7 @@
 //-----------------------------------------------------------------------------
 #include <string>
 #include <list>
+#include <memory> // <FS> Flattened joint hierarchy
 
 #include "v3math.h"
 #include "v4math.h"
@@ -108,6 +109,8 @@ inline bool operator!=(const LLVector3OverrideMap& a, const LLVector3OverrideMap
     return !(a == b);
 }
 
+class FSJointHierarchy; // <FS> Flattened joint hierarchy
+
 //-----------------------------------------------------------------------------
 // class LLJoint
 //-----------------------------------------------------------------------------
@@ -156,6 +159,13 @@ protected:
     LLVector3       mDefaultPosition;
     LLVector3       mDefaultScale;
 
+    // <FS> Flattened joint hierarchy
+    friend class FSJointHierarchy;
+    FSJointHierarchy*   mHierarchy;         // skeleton this joint is flattened into, if any
+    S32                 mHierarchyIndex;
+    std::unique_ptr<FSJointHierarchy> mOwnedHierarchy;  // built when this joint is the root of a skeleton
+    // </FS>
+
 public:
     U32             mDirtyFlags;
     BOOL            mUpdateXform;
@@ -176,6 +186,7 @@ public:
     // debug statics
     static S32      sNumTouches;
     static S32      sNumUpdates;
+    static bool     sUseFlattenedHierarchy; // <FS> Flattened joint hierarchy
     typedef std::set<std::string> debug_joint_name_t;
     static debug_joint_name_t s_debugJointNames;
     static void setDebugJointNames(const debug_joint_name_t& names);
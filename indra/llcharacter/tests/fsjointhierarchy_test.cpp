@@ -0,0 +1,313 @@
+/**
+ * @file fsjointhierarchy_test.cpp
+ * @brief Flattened joint hierarchy against the recursive joint updates
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsjointhierarchy.h"
+#include "../lljoint.h"
+
+#include "lltimer.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Joint counts of the skeletons the viewer animates
+    struct SkeletonShape
+    {
+        const char* mName;
+        S32         mBones;
+        S32         mCollisionVolumes;
+        S32         mAttachmentPoints;
+    };
+    const SkeletonShape CLASSIC = { "classic", 26, 26, 55 };
+    const SkeletonShape BENTO = { "bento", 133, 26, 55 };
+    const SkeletonShape ANIMESH = { "animesh", 133, 26, 0 };
+
+    // Builds a skeleton from a seed, so two calls give identical skeletons.
+    // Bones hang off one of the last few bones for realistic chain depths,
+    // collision volumes and attachment points off random bones; half the
+    // attachment points have nothing attached and don't update.
+    struct Skeleton
+    {
+        std::vector<LLJoint*>   mJoints;    // root first, then bones
+        S32                     mBones;
+
+        Skeleton(const SkeletonShape& shape, U32 seed)
+        :   mBones(shape.mBones)
+        {
+            std::mt19937 rng(seed);
+            mJoints.push_back(new LLJoint());
+            mJoints[0]->setName("mRoot");
+            mJoints[0]->setPosition(LLVector3(128.f, 128.f, 25.f));
+            for (S32 i = 0; i < shape.mBones; ++i)
+            {
+                S32 recent = (S32)mJoints.size();
+                addJoint(mJoints[recent - 1 - rng() % llmin(recent, 6)], rng);
+            }
+            for (S32 i = 0; i < shape.mCollisionVolumes + shape.mAttachmentPoints; ++i)
+            {
+                LLJoint* joint = addJoint(mJoints[1 + rng() % shape.mBones], rng);
+                joint->mUpdateXform = i < shape.mCollisionVolumes || (i % 2);
+            }
+        }
+
+        ~Skeleton()
+        {
+            for (std::vector<LLJoint*>::reverse_iterator it = mJoints.rbegin(); it != mJoints.rend(); ++it)
+            {
+                delete *it;
+            }
+        }
+
+        LLJoint* addJoint(LLJoint* parent, std::mt19937& rng)
+        {
+            LLJoint* joint = new LLJoint();
+            joint->setup("joint", parent);
+            joint->setPosition(LLVector3(0.01f * (rng() % 20), 0.01f * (rng() % 20), 0.02f * (rng() % 10)));
+            joint->setScale(LLVector3(1.f, 1.f + 0.01f * (rng() % 10), 1.f));
+            mJoints.push_back(joint);
+            return joint;
+        }
+
+        // What the motion controller does every frame: rotate every bone
+        // and move the root
+        void animate(S32 frame)
+        {
+            mJoints[0]->setPosition(LLVector3(128.f + 0.01f * frame, 128.f, 25.f));
+            for (S32 i = 1; i <= mBones; ++i)
+            {
+                F32 angle = 0.3f * sinf(0.1f * frame + i);
+                mJoints[i]->setRotation(LLQuaternion(angle, LLVector3(i % 3 == 0, i % 3 == 1, i % 3 == 2)));
+            }
+        }
+    };
+
+    bool same_vector(const LLVector3& a, const LLVector3& b)
+    {
+        return dist_vec(a, b) < 1.e-4f;
+    }
+
+    bool same_rotation(const LLQuaternion& a, const LLQuaternion& b)
+    {
+        return fabsf(dot(a, b)) > 1.f - 1.e-5f;
+    }
+
+    bool same_matrix(const LLMatrix4a& a, const LLMatrix4& b)
+    {
+        const F32* values = a.getF32ptr();
+        for (S32 i = 0; i < 16; ++i)
+        {
+            if (fabsf(values[i] - b.mMatrix[i / 4][i % 4]) > 1.e-4f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void update(Skeleton& skeleton, bool flattened)
+    {
+        LLJoint::sUseFlattenedHierarchy = flattened;
+        skeleton.mJoints[0]->updateWorldMatrixChildren();
+        LLJoint::sUseFlattenedHierarchy = true;
+    }
+}
+
+namespace tut
+{
+    struct jointhierarchy_data
+    {
+        void ensure_same(const std::string& msg, Skeleton& reference, Skeleton& flattened)
+        {
+            for (size_t i = 0; i < reference.mJoints.size(); ++i)
+            {
+                LLJoint* expected = reference.mJoints[i];
+                LLJoint* actual = flattened.mJoints[i];
+                ensure(msg + " position", same_vector(expected->getLastWorldPosition(), actual->getLastWorldPosition()));
+                ensure(msg + " rotation", same_rotation(expected->getLastWorldRotation(), actual->getLastWorldRotation()));
+                ensure(msg + " matrix", same_matrix(actual->getWorldMatrix4a(), expected->getWorldMatrix()));
+            }
+        }
+    };
+    typedef test_group<jointhierarchy_data> jointhierarchy_t;
+    typedef jointhierarchy_t::object jointhierarchy_object_t;
+    tut::jointhierarchy_t tut_jointhierarchy("FSJointHierarchy");
+
+    template<> template<>
+    void jointhierarchy_object_t::test<1>()
+    {
+        set_test_name("Matches the recursive update");
+        Skeleton reference(BENTO, 1);
+        Skeleton flattened(BENTO, 1);
+        std::mt19937 rng(1);
+        for (S32 frame = 0; frame < 50; ++frame)
+        {
+            reference.animate(frame);
+            flattened.animate(frame);
+
+            // Lookups between the animation and the skeleton update, like
+            // name tags and look at targets
+            for (S32 i = 0; i < 5; ++i)
+            {
+                S32 joint = rng() % reference.mJoints.size();
+                ensure("lazy position", same_vector(reference.mJoints[joint]->getWorldPosition(), flattened.mJoints[joint]->getWorldPosition()));
+                joint = rng() % reference.mJoints.size();
+                ensure("lazy rotation", same_rotation(reference.mJoints[joint]->getWorldRotation(), flattened.mJoints[joint]->getWorldRotation()));
+            }
+
+            LLJoint::sNumUpdates = 0;
+            update(reference, false);
+            S32 reference_updates = LLJoint::sNumUpdates;
+            LLJoint::sNumUpdates = 0;
+            update(flattened, true);
+            ensure_equals("same joints updated", LLJoint::sNumUpdates, reference_updates);
+            ensure_same("frame", reference, flattened);
+        }
+    }
+
+    template<> template<>
+    void jointhierarchy_object_t::test<2>()
+    {
+        set_test_name("Skeleton changes");
+        Skeleton reference(CLASSIC, 2);
+        Skeleton flattened(CLASSIC, 2);
+        update(reference, false);
+        update(flattened, true);
+
+        // A joint added below a bone of a flattened skeleton
+        std::mt19937 reference_rng(2), flattened_rng(2);
+        reference.addJoint(reference.mJoints[5], reference_rng);
+        flattened.addJoint(flattened.mJoints[5], flattened_rng);
+        reference.animate(1);
+        flattened.animate(1);
+        ensure("added joint", same_vector(reference.mJoints.back()->getWorldPosition(), flattened.mJoints.back()->getWorldPosition()));
+        update(reference, false);
+        update(flattened, true);
+        ensure_same("after adding", reference, flattened);
+
+        // A bone moved to another parent
+        reference.mJoints[1]->addChild(reference.mJoints[10]);
+        flattened.mJoints[1]->addChild(flattened.mJoints[10]);
+        reference.animate(2);
+        flattened.animate(2);
+        update(reference, false);
+        update(flattened, true);
+        ensure_same("after moving", reference, flattened);
+
+        // Switched off and on again
+        reference.animate(3);
+        flattened.animate(3);
+        update(reference, false);
+        update(flattened, false);
+        ensure_same("switched off", reference, flattened);
+        reference.animate(4);
+        flattened.animate(4);
+        update(reference, false);
+        update(flattened, true);
+        ensure_same("switched on", reference, flattened);
+    }
+
+    template<> template<>
+    void jointhierarchy_object_t::test<3>()
+    {
+        set_test_name("Joints going away");
+        Skeleton flattened(ANIMESH, 3);
+        update(flattened, true);
+
+        // Deleting a bone in the middle takes it out of the flattened
+        // skeleton, the rest keeps working
+        LLJoint* bone = flattened.mJoints[20];
+        flattened.mJoints.erase(flattened.mJoints.begin() + 20);
+        delete bone;
+        flattened.mBones--;
+        flattened.animate(1);
+        update(flattened, true);
+        for (LLJoint* joint : flattened.mJoints)
+        {
+            ensure("matrix", same_matrix(joint->getWorldMatrix4a(), joint->getWorldMatrix()));
+        }
+    }
+
+    template<> template<>
+    void jointhierarchy_object_t::test<4>()
+    {
+        set_test_name("Skeleton update benchmark");
+        const SkeletonShape shapes[] = { CLASSIC, BENTO, ANIMESH };
+        const S32 counts[] = { 1, 10, 50, 200 };
+        const S32 frames = 20;
+
+        std::cout << std::endl;
+        for (const SkeletonShape& shape : shapes)
+        {
+            for (S32 count : counts)
+            {
+                F64 seconds[2] = { 0.0, 0.0 };
+                for (S32 flattened = 0; flattened < 2; ++flattened)
+                {
+                    std::vector<Skeleton*> skeletons;
+                    for (S32 i = 0; i < count; ++i)
+                    {
+                        skeletons.push_back(new Skeleton(shape, i));
+                    }
+
+                    LLTimer timer;
+                    LLVector3 sum;
+                    for (S32 frame = 0; frame < frames; ++frame)
+                    {
+                        for (Skeleton* skeleton : skeletons)
+                        {
+                            skeleton->animate(frame);
+                            // Name tag and camera lookups before the update,
+                            // skinning palette after it
+                            sum += skeleton->mJoints[skeleton->mBones]->getWorldPosition();
+                            sum += skeleton->mJoints[skeleton->mBones / 2]->getWorldPosition();
+                            update(*skeleton, flattened != 0);
+                            for (S32 i = 1; i <= skeleton->mBones; ++i)
+                            {
+                                sum.mV[VX] += skeleton->mJoints[i]->getWorldMatrix4a().mMatrix[3][0];
+                            }
+                        }
+                    }
+                    seconds[flattened] = timer.getElapsedTimeF64();
+                    ensure("finite", sum.isFinite());
+
+                    for (Skeleton* skeleton : skeletons)
+                    {
+                        delete skeleton;
+                    }
+                }
+                std::cout << shape.mName << " x" << count << ": recursive " << seconds[0] * 1000.0 / frames
+                          << " ms/frame, flattened " << seconds[1] * 1000.0 / frames << " ms/frame" << std::endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,260 @@
+/**
+ * @file fsasynclogwriter.cpp
+ * @brief Log records written to their destination by a dedicated thread
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "fsasynclogwriter.h"
+
+#include <chrono>
+
+static const size_t MAX_BATCH_RECORDS = 1024;
+static const size_t MAX_KEPT_MESSAGE_CAPACITY = 1024;  // larger messages don't keep their slot's memory
+static const std::chrono::milliseconds WRITER_IDLE_WAIT(20);
+
+FSAsyncLogWriter::FSAsyncLogWriter(const format_func_t& format, const sink_func_t& sink, size_t capacity)
+:   mFormatFunc(format),
+    mSinkFunc(sink),
+    mEnqueuePos(0),
+    mDequeuePos(0),
+    mReportedDropped(0),
+    mWrittenCount(0),
+    mDroppedCount(0),
+    mBatchCount(0),
+    mWriterSleeping(false),
+    mStop(false)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    mMask = size - 1;
+    mSlots.reset(new Slot[size]);
+    for (size_t i = 0; i < size; ++i)
+    {
+        mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+    }
+
+    mThread = std::thread([this]() { run(); });
+}
+
+FSAsyncLogWriter::~FSAsyncLogWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mStop = true;
+    }
+    mWakeCond.notify_one();
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mDrainMutex);
+    while (drain())
+    {
+    }
+}
+
+bool FSAsyncLogWriter::push(const LLError::CallSite* site, LLError::ELevel level, time_t time, const std::string& message)
+{
+    const bool may_drop = level < LLError::LEVEL_WARN;
+
+    // Bounded multi producer queue: a slot is free for position pos once
+    // its sequence equals pos, and holds a record once it is pos + 1
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &mSlots[pos & mMask];
+        size_t sequence = slot->mSequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Full
+            if (may_drop)
+            {
+                mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // Rather write out some records here than lose a warning
+            size_t written;
+            {
+                std::lock_guard<std::mutex> lock(mDrainMutex);
+                written = drain();
+            }
+            if (!written)
+            {
+                std::this_thread::yield();
+            }
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->mRecord.mSite = site;
+    slot->mRecord.mLevel = level;
+    slot->mRecord.mTime = time;
+    slot->mRecord.mMessage.assign(message);
+    slot->mSequence.store(pos + 1, std::memory_order_release);
+
+    // The writer looks for new records on its own every few milliseconds;
+    // only wake it early for warnings or when the ring fills up
+    if (!may_drop || pos - mDequeuePos.load(std::memory_order_relaxed) >= (mMask + 1) / 4)
+    {
+        wake();
+    }
+    return true;
+}
+
+void FSAsyncLogWriter::flush()
+{
+    const size_t target = mEnqueuePos.load(std::memory_order_acquire);
+    while ((intptr_t)(target - mDequeuePos.load(std::memory_order_acquire)) > 0)
+    {
+        size_t written;
+        {
+            std::lock_guard<std::mutex> lock(mDrainMutex);
+            written = drain();
+        }
+        if (!written)
+        {
+            // A record claimed before the call is still being copied in
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool FSAsyncLogWriter::flushForCrash(U32 timeout_ms)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true)
+    {
+        const size_t target = mEnqueuePos.load(std::memory_order_acquire);
+        if ((intptr_t)(target - mDequeuePos.load(std::memory_order_acquire)) <= 0)
+        {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+
+        // The writer or the crashed thread may hold the drain lock
+        std::unique_lock<std::mutex> lock(mDrainMutex, std::try_to_lock);
+        if (!lock.owns_lock() || !drain())
+        {
+            lock = std::unique_lock<std::mutex>();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void FSAsyncLogWriter::wake()
+{
+    if (mWriterSleeping.load())
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mWakeCond.notify_one();
+    }
+}
+
+void FSAsyncLogWriter::run()
+{
+    LL_PROFILER_SET_THREAD_NAME("Log writer");
+    while (!mStop.load())
+    {
+        size_t written;
+        {
+            std::lock_guard<std::mutex> lock(mDrainMutex);
+            written = drain();
+        }
+        if (written)
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWriterSleeping = true;
+        if (!mStop.load() && mEnqueuePos.load() == mDequeuePos.load())
+        {
+            mWakeCond.wait_for(lock, WRITER_IDLE_WAIT);
+        }
+        mWriterSleeping = false;
+    }
+}
+
+size_t FSAsyncLogWriter::drain()
+{
+    size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+    size_t count = 0;
+    mBatch.clear();
+    while (count < MAX_BATCH_RECORDS)
+    {
+        Slot& slot = mSlots[pos & mMask];
+        if (slot.mSequence.load(std::memory_order_acquire) != pos + 1)
+        {
+            break;
+        }
+
+        mFormatFunc(slot.mRecord, mBatch);
+        if (slot.mRecord.mMessage.capacity() > MAX_KEPT_MESSAGE_CAPACITY)
+        {
+            std::string().swap(slot.mRecord.mMessage);
+        }
+        slot.mSequence.store(pos + mMask + 1, std::memory_order_release);
+        ++pos;
+        ++count;
+    }
+
+    const U64 dropped = mDroppedCount.load(std::memory_order_relaxed);
+    if (dropped != mReportedDropped && mDroppedFunc)
+    {
+        mDroppedFunc(dropped - mReportedDropped, mBatch);
+        mReportedDropped = dropped;
+    }
+
+    if (!mBatch.empty())
+    {
+        mSinkFunc(mBatch);
+        mBatchCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    mWrittenCount.fetch_add(count, std::memory_order_relaxed);
+    mDequeuePos.store(pos, std::memory_order_release);
+    return count;
+}
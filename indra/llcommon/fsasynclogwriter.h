@@ -0,0 +1,127 @@
+/**
+ * @file fsasynclogwriter.h
+ * @brief Log records written to their destination by a dedicated thread
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_ASYNCLOGWRITER_H
+#define FS_ASYNCLOGWRITER_H
+
+#include "llerror.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Takes log records from any number of threads and hands them to a sink on
+// a thread of its own, many records per call. Callers only copy their
+// message into a slot of a fixed size ring, which takes no lock; turning
+// the call site and the time into text is left to the writer thread.
+//
+// When the ring is full, records that may be lost (debug and info) are
+// dropped and counted, the writer reports how many it missed. Warnings and
+// errors wait for room instead.
+class LL_COMMON_API FSAsyncLogWriter
+{
+public:
+    struct Record
+    {
+        const LLError::CallSite*    mSite;      // static call site, NULL for preformatted text
+        LLError::ELevel             mLevel;
+        time_t                      mTime;
+        std::string                 mMessage;
+    };
+
+    // Appends the text of record to batch
+    typedef std::function<void(const Record& record, std::string& batch)> format_func_t;
+    // Appends the line reporting count lost records to batch
+    typedef std::function<void(U64 count, std::string& batch)> dropped_func_t;
+    // Writes out a batch of formatted records
+    typedef std::function<void(const std::string& batch)> sink_func_t;
+
+    static constexpr size_t DEFAULT_CAPACITY = 8192;
+
+    FSAsyncLogWriter(const format_func_t& format, const sink_func_t& sink, size_t capacity = DEFAULT_CAPACITY);
+    ~FSAsyncLogWriter();    // writes everything still queued
+
+    void setDroppedFunction(const dropped_func_t& dropped) { mDroppedFunc = dropped; }
+
+    // Queues a record; returns false if it was dropped because the ring is full
+    bool push(const LLError::CallSite* site, LLError::ELevel level, time_t time, const std::string& message);
+
+    // Returns once everything queued before the call has reached the sink
+    void flush();
+
+    // For crash handlers: writes out what it can without waiting on locks
+    // or on records a crashed thread may never finish, giving up after
+    // timeout_ms. Returns true if the queue was emptied.
+    bool flushForCrash(U32 timeout_ms);
+
+    bool isRunning() const { return mThread.joinable(); }
+    size_t getCapacity() const { return mMask + 1; }
+    U64 getWritten() const { return mWrittenCount.load(std::memory_order_relaxed); }
+    U64 getDropped() const { return mDroppedCount.load(std::memory_order_relaxed); }
+    U64 getBatches() const { return mBatchCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> mSequence;
+        Record              mRecord;
+    };
+
+    void run();
+    size_t drain();     // writer side; returns the number of records written
+    void wake();
+
+    format_func_t               mFormatFunc;
+    dropped_func_t              mDroppedFunc;
+    sink_func_t                 mSinkFunc;
+
+    std::unique_ptr<Slot[]>     mSlots;
+    size_t                      mMask;
+
+    alignas(64) std::atomic<size_t> mEnqueuePos;
+    alignas(64) std::atomic<size_t> mDequeuePos;    // only advanced with mDrainMutex held
+    std::string                 mBatch;             // mDrainMutex
+    U64                         mReportedDropped;   // mDrainMutex
+    std::mutex                  mDrainMutex;        // held while records go to the sink
+
+    std::atomic<U64>            mWrittenCount;
+    std::atomic<U64>            mDroppedCount;
+    std::atomic<U64>            mBatchCount;
+    std::atomic<bool>           mWriterSleeping;
+    std::atomic<bool>           mStop;
+
+    std::mutex                  mWakeMutex;
+    std::condition_variable     mWakeCond;
+    std::thread                 mThread;
+};
+
+#endif // FS_ASYNCLOGWRITER_H
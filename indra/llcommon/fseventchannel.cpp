@@ -0,0 +1,79 @@
+/**
+ * @file fseventchannel.cpp
+ * @brief Typed event channels with pre-resolved handles next to LLEventPumps
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "fseventchannel.h"
+
+void FSEventConnection::disconnect()
+{
+    if (std::shared_ptr<Source> source = mSource.lock())
+    {
+        source->disconnect(mID);
+    }
+    mSource.reset();
+}
+
+bool FSEventConnection::connected() const
+{
+    std::shared_ptr<Source> source = mSource.lock();
+    return source && source->connected(mID);
+}
+
+FSEventChannels::FSEventChannels()
+{
+    // Mirrored channels listen on pumps, so LLEventPumps has to outlive us.
+    // Touching it here records the dependency.
+    LLEventPumps::instance();
+}
+
+FSEventChannels::~FSEventChannels()
+{
+}
+
+namespace
+{
+    LLSD mainloop_to_llsd(const FSMainloopEvent&)
+    {
+        return LLSD();
+    }
+
+    FSMainloopEvent mainloop_from_llsd(const LLSD&)
+    {
+        return FSMainloopEvent();
+    }
+}
+
+FSEventChannel<FSMainloopEvent>& fs_mainloop_channel()
+{
+    FSEventChannel<FSMainloopEvent>& channel(FSEventChannels::instance().obtain<FSMainloopEvent>("mainloop"));
+    if (!channel.isMirrored())
+    {
+        channel.mirror(LLEventPumps::instance().obtain("mainloop"), mainloop_to_llsd, mainloop_from_llsd);
+    }
+    return channel;
+}
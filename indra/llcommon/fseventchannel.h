@@ -0,0 +1,356 @@
+/**
+ * @file fseventchannel.h
+ * @brief Typed event channels with pre-resolved handles next to LLEventPumps
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_EVENTCHANNEL_H
+#define FS_EVENTCHANNEL_H
+
+#include "llevents.h"
+#include "llexception.h"
+#include "llsingleton.h"
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+
+/*****************************************************************************
+*   Typed event channels
+*   An LLEventPump carries every event as LLSD and calls its listeners through
+*   boost::signals2. That is the right thing for events crossing into
+*   scripting and LLLeap, but costs an LLSD build, a name lookup and a signal
+*   invocation for each post. FSEventChannel<EVENT> carries a plain struct by
+*   reference to a vector of std::functions instead. Look a channel up once
+*   with FSEventChannels::obtain() and keep the reference.
+*
+*   A channel can mirror an LLEventPump of the same name: posts to the channel
+*   are passed on to the pump for its LLSD listeners, and posts to the pump
+*   reach the typed listeners, so both kinds of listener see every event once.
+*
+*   Like LLEventPumps, channels are meant to be used from the main thread.
+*****************************************************************************/
+
+class LL_COMMON_API FSEventConnection
+{
+public:
+    // What a connection needs to know of the channel it belongs to
+    class Source
+    {
+    public:
+        virtual ~Source() {}
+        virtual void disconnect(U32 id) = 0;
+        virtual bool connected(U32 id) const = 0;
+    };
+
+    FSEventConnection() : mID(0) {}
+    FSEventConnection(const std::weak_ptr<Source>& source, U32 id) : mSource(source), mID(id) {}
+
+    // Harmless if already disconnected or if the channel is gone
+    void disconnect();
+    bool connected() const;
+
+private:
+    std::weak_ptr<Source>   mSource;
+    U32                     mID;
+};
+
+// Disconnects when destroyed, the counterpart of LLTempBoundListener
+class LL_COMMON_API FSScopedEventConnection
+{
+public:
+    FSScopedEventConnection() {}
+    FSScopedEventConnection(const FSEventConnection& connection) : mConnection(connection) {}
+    ~FSScopedEventConnection() { mConnection.disconnect(); }
+
+    FSScopedEventConnection(const FSScopedEventConnection&) = delete;
+    FSScopedEventConnection& operator=(const FSScopedEventConnection&) = delete;
+
+    FSScopedEventConnection& operator=(const FSEventConnection& connection)
+    {
+        mConnection.disconnect();
+        mConnection = connection;
+        return *this;
+    }
+
+    void disconnect() { mConnection.disconnect(); }
+    bool connected() const { return mConnection.connected(); }
+
+private:
+    FSEventConnection mConnection;
+};
+
+class LL_COMMON_API FSEventChannelBase
+{
+public:
+    FSEventChannelBase(const std::string& name) : mName(name) {}
+    virtual ~FSEventChannelBase() {}
+
+    const std::string& getName() const { return mName; }
+
+private:
+    std::string mName;
+};
+
+template<typename EVENT>
+class FSEventChannel : public FSEventChannelBase
+{
+public:
+    // Return true to keep the event from later listeners, as with LLEventPump
+    typedef std::function<bool(const EVENT&)> listener_t;
+    typedef LLSD (*to_llsd_t)(const EVENT&);
+    typedef EVENT (*from_llsd_t)(const LLSD&);
+
+    FSEventChannel(const std::string& name)
+    :   FSEventChannelBase(name),
+        mState(std::make_shared<State>())
+    {
+    }
+
+    ~FSEventChannel()
+    {
+        // A mirror pump still around must not call into a dead channel
+        mBridge.disconnect();
+    }
+
+    FSEventConnection listen(const listener_t& listener)
+    {
+        Slot slot;
+        slot.mID = ++mState->mLastID;
+        slot.mListener = listener;
+        mState->mSlots.push_back(slot);
+        return FSEventConnection(mState, slot.mID);
+    }
+
+    // Returns true if a listener stopped the event
+    bool post(const EVENT& event)
+    {
+        bool stopped = dispatch(event);
+        if (!stopped && mPump)
+        {
+            mPosting = true;
+            try
+            {
+                stopped = mPump->post(mToLLSD(event));
+            }
+            catch (...)
+            {
+                mPosting = false;
+                throw;
+            }
+            mPosting = false;
+        }
+        return stopped;
+    }
+
+    // Passes events on to and takes events from pump, see above
+    void mirror(LLEventPump& pump, to_llsd_t to_llsd, from_llsd_t from_llsd)
+    {
+        mBridge.disconnect();
+        mPump = &pump;
+        mToLLSD = to_llsd;
+        mFromLLSD = from_llsd;
+        mBridge = pump.listen(LLEventPump::inventName("FSEventChannel"),
+                              [this](const LLSD& event)
+                              {
+                                  // Posted from here, the typed listeners have it already
+                                  return !mPosting && dispatch(mFromLLSD(event));
+                              });
+    }
+
+    bool isMirrored() const { return mPump != nullptr; }
+
+    size_t getListenerCount() const
+    {
+        size_t count = 0;
+        for (const Slot& slot : mState->mSlots)
+        {
+            count += slot.mListener ? 1 : 0;
+        }
+        return count;
+    }
+
+private:
+    struct Slot
+    {
+        U32         mID;
+        listener_t  mListener;
+    };
+
+    struct State : public FSEventConnection::Source
+    {
+        State() : mLastID(0), mDispatching(0), mHoles(false) {}
+
+        void disconnect(U32 id) override
+        {
+            for (typename std::deque<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+            {
+                if (it->mID == id)
+                {
+                    if (mDispatching)
+                    {
+                        // The listener may be running, drop it after the post
+                        it->mListener = nullptr;
+                        mHoles = true;
+                    }
+                    else
+                    {
+                        mSlots.erase(it);
+                    }
+                    return;
+                }
+            }
+        }
+
+        bool connected(U32 id) const override
+        {
+            for (const Slot& slot : mSlots)
+            {
+                if (slot.mID == id)
+                {
+                    return (bool)slot.mListener;
+                }
+            }
+            return false;
+        }
+
+        // A deque keeps running listeners in place when others are added
+        std::deque<Slot>    mSlots;
+        U32                 mLastID;
+        S32                 mDispatching;
+        bool                mHoles;
+    };
+
+    bool dispatch(const EVENT& event)
+    {
+        // Keeps the state alive if the channel goes away in a listener
+        std::shared_ptr<State> state(mState);
+        ++state->mDispatching;
+        bool stopped = false;
+        // Listeners added during the post get the next one
+        const size_t count = state->mSlots.size();
+        for (size_t i = 0; i < count && !stopped; ++i)
+        {
+            const listener_t& listener = state->mSlots[i].mListener;
+            if (!listener)
+            {
+                continue;
+            }
+            try
+            {
+                stopped = listener(event);
+            }
+            catch (const LLContinueError&)
+            {
+                // Like LLStopWhenHandled: log, and let the other listeners
+                // have the event
+                LOG_UNHANDLED_EXCEPTION("FSEventChannel");
+            }
+            catch (...)
+            {
+                --state->mDispatching;
+                throw;
+            }
+        }
+        if (--state->mDispatching == 0 && state->mHoles)
+        {
+            state->mHoles = false;
+            for (typename std::deque<Slot>::iterator it = state->mSlots.begin(); it != state->mSlots.end(); )
+            {
+                it = it->mListener ? it + 1 : state->mSlots.erase(it);
+            }
+        }
+        return stopped;
+    }
+
+    std::shared_ptr<State>  mState;
+    LLEventPump*            mPump = nullptr;
+    to_llsd_t               mToLLSD = nullptr;
+    from_llsd_t             mFromLLSD = nullptr;
+    LLTempBoundListener     mBridge;
+    bool                    mPosting = false;
+};
+
+// Owns the typed channels by name
+class LL_COMMON_API FSEventChannels : public LLSingleton<FSEventChannels>
+{
+    LLSINGLETON(FSEventChannels);
+    ~FSEventChannels();
+
+public:
+    // obtain() with a name already used for another event type
+    struct WrongEventType : public LLException
+    {
+        WrongEventType(const std::string& what) : LLException("WrongEventType: " + what) {}
+    };
+
+    // Finds or creates the channel name, resolve it once and keep the
+    // reference
+    template<typename EVENT>
+    FSEventChannel<EVENT>& obtain(const std::string& name)
+    {
+        channel_map_t::iterator it = mChannels.find(name);
+        if (it == mChannels.end())
+        {
+            Entry entry;
+            entry.mType = std::type_index(typeid(EVENT));
+            entry.mChannel.reset(new FSEventChannel<EVENT>(name));
+            it = mChannels.insert(channel_map_t::value_type(name, std::move(entry))).first;
+        }
+        else if (it->second.mType != std::type_index(typeid(EVENT)))
+        {
+            LLTHROW(WrongEventType(name));
+        }
+        return *static_cast<FSEventChannel<EVENT>*>(it->second.mChannel.get());
+    }
+
+private:
+    struct Entry
+    {
+        Entry() : mType(typeid(void)) {}
+        std::type_index                         mType;
+        std::unique_ptr<FSEventChannelBase>     mChannel;
+    };
+    typedef std::map<std::string, Entry> channel_map_t;
+    channel_map_t mChannels;
+};
+
+/*****************************************************************************
+*   "mainloop"
+*****************************************************************************/
+
+// Posted once per frame. Carries nothing, as the LLSD posted on the pump
+// never did.
+struct FSMainloopEvent
+{
+};
+
+// The typed "mainloop" channel, mirroring the "mainloop" LLEventPump. Look
+// it up once and keep the reference.
+LL_COMMON_API FSEventChannel<FSMainloopEvent>& fs_mainloop_channel();
+
+#endif // FS_EVENTCHANNEL_H
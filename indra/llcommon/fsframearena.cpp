@@ -0,0 +1,135 @@
+/**
+ * @file fsframearena.cpp
+ * @brief Per-thread linear arena for data that lives no longer than a frame
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "fsframearena.h"
+
+#include <cstdlib>
+
+namespace
+{
+    const size_t INITIAL_CHUNK_SIZE = 64 * 1024;
+    // A single busy frame does not get to keep more than this for good
+    const size_t MAX_RETAINED_SIZE = 16 * 1024 * 1024;
+    const size_t CHUNK_HEADER_SIZE = 16;
+}
+
+// static
+FSFrameArena& FSFrameArena::instance()
+{
+    static thread_local FSFrameArena sArena;
+    return sArena;
+}
+
+FSFrameArena::FSFrameArena()
+:   mTop(0),
+    mEnd(0),
+    mChunks(nullptr),
+    mCapacity(0),
+    mLive(0)
+{
+    mCurrent = mLastFrame = Stats();
+}
+
+FSFrameArena::~FSFrameArena()
+{
+    freeChunks();
+}
+
+void* FSFrameArena::allocateSlow(size_t bytes, size_t alignment)
+{
+    if (bytes > (size_t)-1 / 2 - alignment)
+    {
+        throw std::bad_alloc();
+    }
+    size_t size = mChunks ? mChunks->mSize * 2 : INITIAL_CHUNK_SIZE;
+    addChunk(llmax(size, bytes + alignment));
+    return allocate(bytes, alignment);
+}
+
+FSFrameArena::Chunk* FSFrameArena::addChunk(size_t size)
+{
+    Chunk* chunk = (Chunk*)malloc(CHUNK_HEADER_SIZE + size);
+    if (!chunk)
+    {
+        throw std::bad_alloc();
+    }
+    chunk->mNext = mChunks;
+    chunk->mSize = size;
+    mChunks = chunk;
+    mTop = (uintptr_t)chunk + CHUNK_HEADER_SIZE;
+    mEnd = mTop + size;
+    mCapacity += size;
+    ++mCurrent.mSystemAllocations;
+    return chunk;
+}
+
+void FSFrameArena::freeChunks()
+{
+    while (mChunks)
+    {
+        Chunk* next = mChunks->mNext;
+        free(mChunks);
+        mChunks = next;
+    }
+    mTop = mEnd = 0;
+    mCapacity = 0;
+}
+
+void FSFrameArena::rewind()
+{
+    if (mChunks)
+    {
+        mTop = (uintptr_t)mChunks + CHUNK_HEADER_SIZE;
+    }
+}
+
+void FSFrameArena::reset()
+{
+    mLastFrame = mCurrent;
+    mCurrent = Stats();
+
+    if (mLive)
+    {
+        // Something allocated during the frame is still alive, it keeps
+        // its chunk until it is freed
+        LL_WARNS_ONCE() << mLive << " frame arena allocations outlived their frame" << LL_ENDL;
+        return;
+    }
+
+    if (mChunks && mChunks->mNext)
+    {
+        size_t size = llmin(mCapacity, MAX_RETAINED_SIZE);
+        freeChunks();
+        addChunk(size);
+        // Counted towards the frame that needed it
+        --mCurrent.mSystemAllocations;
+        ++mLastFrame.mSystemAllocations;
+    }
+    rewind();
+}
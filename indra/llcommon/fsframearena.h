@@ -0,0 +1,163 @@
+/**
+ * @file fsframearena.h
+ * @brief Per-thread linear arena for data that lives no longer than a frame
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_FRAMEARENA_H
+#define FS_FRAMEARENA_H
+
+#include "llpreprocessor.h"
+#include "stdtypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <new>
+#include <vector>
+
+// Linear allocator for containers that are built and thrown away within a
+// frame. Every thread has an arena of its own; allocating bumps a pointer
+// and freeing only gives memory back if it was the last allocation. The
+// whole arena is rewound when nothing allocated from it is alive anymore,
+// and at the end of every frame reset() folds the chunks a busy frame had
+// to add into a single one, so a steady scene allocates nothing from the
+// system heap at all.
+//
+// Containers using FSFrameAllocator must be destroyed before the frame ends
+// and must stay on the thread that created them.
+class LL_COMMON_API FSFrameArena
+{
+public:
+    struct Stats
+    {
+        U64     mRequests;          // allocations served
+        U64     mBytes;             // bytes handed out
+        U64     mSystemAllocations; // chunks taken from the heap
+    };
+
+    // Arena of the calling thread
+    static FSFrameArena& instance();
+
+    FSFrameArena();
+    ~FSFrameArena();
+
+    void* allocate(size_t bytes, size_t alignment)
+    {
+        uintptr_t start = (mTop + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+        if (start + bytes > mEnd || start < mTop)
+        {
+            return allocateSlow(bytes, alignment);
+        }
+        mTop = start + bytes;
+        ++mLive;
+        ++mCurrent.mRequests;
+        mCurrent.mBytes += bytes;
+        return (void*)start;
+    }
+
+    void deallocate(void* ptr, size_t bytes)
+    {
+        if ((uintptr_t)ptr + bytes == mTop)
+        {
+            mTop = (uintptr_t)ptr;
+        }
+        if (--mLive == 0)
+        {
+            rewind();
+        }
+    }
+
+    // Ends the frame of the calling thread's arena
+    void reset();
+
+    // Counts of the last completed frame
+    const Stats& getFrameStats() const { return mLastFrame; }
+    size_t getCapacity() const { return mCapacity; }
+    size_t getLiveAllocations() const { return mLive; }
+
+private:
+    struct Chunk
+    {
+        Chunk*  mNext;
+        size_t  mSize;
+    };
+
+    void* allocateSlow(size_t bytes, size_t alignment);
+    Chunk* addChunk(size_t size);
+    void freeChunks();
+    void rewind();
+
+    uintptr_t   mTop;
+    uintptr_t   mEnd;
+    Chunk*      mChunks;        // newest first, mTop points into the first
+    size_t      mCapacity;
+    size_t      mLive;
+    Stats       mCurrent;
+    Stats       mLastFrame;
+};
+
+// STL allocator drawing from the arena of the thread it was made on
+template<typename T>
+class FSFrameAllocator
+{
+public:
+    typedef T value_type;
+
+    FSFrameAllocator() : mArena(&FSFrameArena::instance()) {}
+    template<typename U>
+    FSFrameAllocator(const FSFrameAllocator<U>& other) : mArena(other.mArena) {}
+
+    T* allocate(size_t count)
+    {
+        if (count > (size_t)-1 / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(mArena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t count)
+    {
+        mArena->deallocate(ptr, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const FSFrameAllocator<U>& other) const { return mArena == other.mArena; }
+    template<typename U>
+    bool operator!=(const FSFrameAllocator<U>& other) const { return mArena != other.mArena; }
+
+private:
+    template<typename U> friend class FSFrameAllocator;
+
+    FSFrameArena* mArena;
+};
+
+template<typename T>
+using FSFrameVector = std::vector<T, FSFrameAllocator<T> >;
+
+template<typename T>
+using FSFrameList = std::list<T, FSFrameAllocator<T> >;
+
+#endif // FS_FRAMEARENA_H
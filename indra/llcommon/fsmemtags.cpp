@@ -0,0 +1,279 @@
+/**
+ * @file fsmemtags.cpp
+ * @brief Scoped memory tags accounting live bytes per viewer subsystem
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "fsmemtags.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace
+{
+    struct TagCounters
+    {
+        std::atomic<S64> mLiveBytes[FSMT_COUNT];
+        std::atomic<U64> mAllocations[FSMT_COUNT];
+    };
+
+    // Every thread counts into a block of its own, only it writes there, so
+    // claims need no atomic read-modify-write. Readers add up all blocks.
+    struct ThreadCounters
+    {
+        alignas(64) TagCounters mCounters;
+    };
+
+    struct Registry
+    {
+        std::mutex                      mMutex;
+        std::vector<ThreadCounters*>    mThreads;
+        TagCounters                     mRetired;   // exited threads and threads shutting down
+    };
+
+    // Never destroyed: tagged objects may be freed by static destructors
+    Registry& get_registry()
+    {
+        static Registry* sRegistry = new Registry();
+        return *sRegistry;
+    }
+
+    thread_local ThreadCounters* sThreadCounters = nullptr;
+    thread_local bool sThreadExited = false;
+    thread_local S32 sCurrentTag = -1;
+
+    // Folds the thread's counts into the registry when the thread exits
+    struct ThreadExitHook
+    {
+        ~ThreadExitHook()
+        {
+            Registry& registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mMutex);
+            for (S32 tag = 0; tag < FSMT_COUNT; ++tag)
+            {
+                registry.mRetired.mLiveBytes[tag] += sThreadCounters->mCounters.mLiveBytes[tag].load(std::memory_order_relaxed);
+                registry.mRetired.mAllocations[tag] += sThreadCounters->mCounters.mAllocations[tag].load(std::memory_order_relaxed);
+            }
+            registry.mThreads.erase(std::find(registry.mThreads.begin(), registry.mThreads.end(), sThreadCounters));
+            delete sThreadCounters;
+            sThreadCounters = nullptr;
+            sThreadExited = true;
+        }
+    };
+
+    // Counters of this thread, NULL once its thread locals are going away
+    TagCounters* thread_counters()
+    {
+        if (LL_LIKELY(sThreadCounters))
+        {
+            return &sThreadCounters->mCounters;
+        }
+        if (sThreadExited)
+        {
+            return nullptr;
+        }
+        ThreadCounters* counters = new ThreadCounters();
+        for (S32 tag = 0; tag < FSMT_COUNT; ++tag)
+        {
+            counters->mCounters.mLiveBytes[tag].store(0, std::memory_order_relaxed);
+            counters->mCounters.mAllocations[tag].store(0, std::memory_order_relaxed);
+        }
+        {
+            Registry& registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mMutex);
+            registry.mThreads.push_back(counters);
+        }
+        sThreadCounters = counters;
+        static thread_local ThreadExitHook sExitHook;
+        (void)sExitHook;
+        return &counters->mCounters;
+    }
+
+    template<typename T>
+    void add_owned(std::atomic<T>& counter, T value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    const char* const TAG_NAMES[FSMT_COUNT] =
+    {
+        "Textures",
+        "Meshes",
+        "LLSD",
+        "UI",
+        "Inventory"
+    };
+
+    // Sits right in front of every block from FSMemTags::allocate()
+    struct BlockHeader
+    {
+        size_t  mSize;
+        U32     mTag;
+        U32     mAlignment;
+    };
+
+    // Room in front of a block, keeps the block at the alignment asked for
+    size_t header_space(size_t alignment)
+    {
+        return llmax(alignment, (size_t)16);
+    }
+
+    bool is_over_aligned(size_t alignment)
+    {
+        return alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    }
+}
+
+//static
+const char* FSMemTags::getName(S32 tag)
+{
+    return (tag >= 0 && tag < FSMT_COUNT) ? TAG_NAMES[tag] : "Unknown";
+}
+
+//static
+void FSMemTags::claim(EFSMemTag tag, size_t bytes)
+{
+    TagCounters* counters = thread_counters();
+    if (counters)
+    {
+        add_owned(counters->mLiveBytes[tag], (S64)bytes);
+        add_owned(counters->mAllocations[tag], (U64)1);
+    }
+    else
+    {
+        Registry& registry = get_registry();
+        registry.mRetired.mLiveBytes[tag].fetch_add((S64)bytes, std::memory_order_relaxed);
+        registry.mRetired.mAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//static
+void FSMemTags::disclaim(EFSMemTag tag, size_t bytes)
+{
+    // Freed on another thread than allocated on: that thread's live bytes
+    // go negative, the sum is still right
+    TagCounters* counters = thread_counters();
+    if (counters)
+    {
+        add_owned(counters->mLiveBytes[tag], -(S64)bytes);
+    }
+    else
+    {
+        get_registry().mRetired.mLiveBytes[tag].fetch_sub((S64)bytes, std::memory_order_relaxed);
+    }
+}
+
+//static
+EFSMemTag FSMemTags::getCurrent(EFSMemTag fallback)
+{
+    return sCurrentTag < 0 ? fallback : (EFSMemTag)sCurrentTag;
+}
+
+//static
+S32 FSMemTags::setCurrent(S32 tag)
+{
+    S32 previous = sCurrentTag;
+    sCurrentTag = tag;
+    return previous;
+}
+
+//static
+void* FSMemTags::allocate(size_t size, size_t alignment, EFSMemTag fallback)
+{
+    size_t space = header_space(alignment);
+    void* block = is_over_aligned(alignment)
+        ? ::operator new(size + space, std::align_val_t(alignment))
+        : ::operator new(size + space);
+    U8* ptr = (U8*)block + space;
+
+    EFSMemTag tag = getCurrent(fallback);
+    BlockHeader* header = (BlockHeader*)ptr - 1;
+    header->mSize = size;
+    header->mTag = (U32)tag;
+    header->mAlignment = (U32)alignment;
+    claim(tag, size);
+    return ptr;
+}
+
+//static
+void FSMemTags::deallocate(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    BlockHeader* header = (BlockHeader*)ptr - 1;
+    size_t alignment = header->mAlignment;
+    disclaim((EFSMemTag)header->mTag, header->mSize);
+
+    void* block = (U8*)ptr - header_space(alignment);
+    if (is_over_aligned(alignment))
+    {
+        ::operator delete(block, std::align_val_t(alignment));
+    }
+    else
+    {
+        ::operator delete(block);
+    }
+}
+
+//static
+FSMemTags::Totals FSMemTags::getTotals(S32 tag)
+{
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    Totals totals;
+    totals.mLiveBytes = registry.mRetired.mLiveBytes[tag].load(std::memory_order_relaxed);
+    totals.mAllocations = registry.mRetired.mAllocations[tag].load(std::memory_order_relaxed);
+    for (const ThreadCounters* thread : registry.mThreads)
+    {
+        totals.mLiveBytes += thread->mCounters.mLiveBytes[tag].load(std::memory_order_relaxed);
+        totals.mAllocations += thread->mCounters.mAllocations[tag].load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+//static
+void FSMemTags::dump(std::ostream& out)
+{
+    out << std::left << std::setw(12) << "Tag"
+        << std::right << std::setw(14) << "Live KB"
+        << std::setw(16) << "Allocations" << '\n';
+    for (S32 tag = 0; tag < FSMT_COUNT; ++tag)
+    {
+        Totals totals = getTotals(tag);
+        out << std::left << std::setw(12) << getName(tag)
+            << std::right << std::setw(14) << totals.mLiveBytes / 1024
+            << std::setw(16) << totals.mAllocations << '\n';
+    }
+#ifndef FS_MEMTAGS
+    out << "LLSD values, views and inventory objects are only counted in builds with USE_FS_MEMTAGS\n";
+#endif
+}
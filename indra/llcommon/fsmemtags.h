@@ -0,0 +1,176 @@
+/**
+ * @file fsmemtags.h
+ * @brief Scoped memory tags accounting live bytes per viewer subsystem
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_MEMTAGS_H
+#define FS_MEMTAGS_H
+
+#include "llpreprocessor.h"
+#include "stdtypes.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <new>
+
+// Subsystems memory is accounted to
+enum EFSMemTag
+{
+    FSMT_TEXTURES = 0,  // decoded and encoded image data
+    FSMT_MESHES,        // volume face geometry of meshes and prims, mesh thread allocations
+    FSMT_LLSD,          // LLSD values not made under another tag
+    FSMT_UI,            // views and allocations while building them from XUI
+    FSMT_INVENTORY,     // inventory items and categories, inventory parsing
+    FSMT_COUNT
+};
+
+// Live bytes and allocation counts per subsystem. Owners of large buffers
+// report them with claim()/disclaim() or track(); classes deriving from
+// FSMemTagged are accounted on every new and delete.
+//
+// Every thread counts into counters of its own, reading the totals adds
+// them up. A block freed on another thread than the one that allocated it
+// is still debited to the tag it was charged to.
+class LL_COMMON_API FSMemTags
+{
+public:
+    struct Totals
+    {
+        S64 mLiveBytes;     // currently allocated
+        U64 mAllocations;   // allocations and claims since startup
+    };
+
+    static const char* getName(S32 tag);
+
+    static void claim(EFSMemTag tag, size_t bytes);
+    static void disclaim(EFSMemTag tag, size_t bytes);
+
+    // Sets what an owner holds under tag to bytes, claiming or disclaiming
+    // the difference to tracked, which it keeps for the next call
+    static void track(EFSMemTag tag, size_t& tracked, size_t bytes)
+    {
+        if (bytes > tracked)
+        {
+            claim(tag, bytes - tracked);
+        }
+        else if (bytes < tracked)
+        {
+            disclaim(tag, tracked - bytes);
+        }
+        tracked = bytes;
+    }
+
+    // Tag of the innermost FSMemTagScope on this thread, or fallback
+    static EFSMemTag getCurrent(EFSMemTag fallback);
+
+    // Blocks with a small header recording their size and tag
+    static void* allocate(size_t size, size_t alignment, EFSMemTag fallback);
+    static void deallocate(void* ptr);
+
+    static Totals getTotals(S32 tag);
+
+    // One line per tag, for the log or a file
+    static void dump(std::ostream& out);
+
+private:
+    friend class FSMemTagScope;
+    static S32 setCurrent(S32 tag);
+};
+
+// Charges allocations of FSMemTagged classes made on this thread while it
+// exists to tag. Scopes nest. Must not be held across a coroutine yield,
+// other coroutines of the thread would be charged to it.
+class LL_COMMON_API FSMemTagScope
+{
+public:
+    explicit FSMemTagScope(EFSMemTag tag)
+    :   mPrevious(FSMemTags::setCurrent(tag))
+    {
+    }
+
+    ~FSMemTagScope()
+    {
+        FSMemTags::setCurrent(mPrevious);
+    }
+
+    FSMemTagScope(const FSMemTagScope&) = delete;
+    FSMemTagScope& operator=(const FSMemTagScope&) = delete;
+
+private:
+    S32 mPrevious;
+};
+
+// Base class accounting every instance of a class and its subclasses to
+// the current FSMemTagScope of the allocating thread, or to TAG outside
+// of any scope
+template<EFSMemTag TAG>
+class FSMemTagged
+{
+public:
+    static void* operator new(size_t size)
+    {
+        return FSMemTags::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, TAG);
+    }
+
+    static void* operator new(size_t size, std::align_val_t alignment)
+    {
+        return FSMemTags::allocate(size, (size_t)alignment, TAG);
+    }
+
+    static void* operator new(size_t, void* where)
+    {
+        return where;
+    }
+
+    static void operator delete(void* ptr)
+    {
+        FSMemTags::deallocate(ptr);
+    }
+
+    static void operator delete(void* ptr, std::align_val_t)
+    {
+        FSMemTags::deallocate(ptr);
+    }
+
+    static void operator delete(void*, void*)
+    {
+    }
+};
+
+// Base of LLSD values, views and inventory objects. Their allocations are
+// on hot paths, so they only pay for the block header and the scope lookup
+// in builds configured with USE_FS_MEMTAGS. Otherwise their tags count the
+// claims made for them only.
+#ifdef FS_MEMTAGS
+template<EFSMemTag TAG>
+using FSMemTagBase = FSMemTagged<TAG>;
+#else
+template<EFSMemTag TAG>
+class FSMemTagBase
+{
+};
+#endif
+
+#endif // FS_MEMTAGS_H
@@ -0,0 +1,203 @@
+/**
+ * @file fstracecounttotals.cpp
+ * @brief Lifetime totals of LLTrace count stats in per-thread, cache line padded slots
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "fstracecounttotals.h"
+
+#include "llmemory.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace
+{
+    const size_t CACHE_LINE_SIZE = 64;
+    const size_t SLOTS_PER_LINE = CACHE_LINE_SIZE / sizeof(FSTraceCountTotals::Slot);
+    // Enough for every count stat the viewer has, so most threads never grow
+    const size_t MIN_SLOTS = 128;
+
+    struct Registry
+    {
+        std::mutex                                  mMutex;
+        std::vector<FSTraceCountTotals::ThreadSlots*> mThreads;
+        // Exited threads and threads shutting down
+        std::vector<F64>                            mRetiredSums;
+        std::vector<U64>                            mRetiredCounts;
+
+        void retire(size_t index, F64 sum, U64 count)
+        {
+            if (index >= mRetiredSums.size())
+            {
+                mRetiredSums.resize(index + 1, 0.0);
+                mRetiredCounts.resize(index + 1, 0);
+            }
+            mRetiredSums[index] += sum;
+            mRetiredCounts[index] += count;
+        }
+    };
+
+    // Never destroyed: stats may be added from static destructors
+    Registry& get_registry()
+    {
+        static Registry* sRegistry = new Registry();
+        return *sRegistry;
+    }
+
+    thread_local bool sThreadExited = false;
+
+    FSTraceCountTotals::Slot* allocate_slots(size_t num_slots)
+    {
+        FSTraceCountTotals::Slot* slots = static_cast<FSTraceCountTotals::Slot*>(ll_aligned_malloc<CACHE_LINE_SIZE>(num_slots * sizeof(FSTraceCountTotals::Slot)));
+        for (size_t i = 0; i < num_slots; ++i)
+        {
+            new (&slots[i]) FSTraceCountTotals::Slot();
+            slots[i].mSum.store(0.0, std::memory_order_relaxed);
+            slots[i].mCount.store(0, std::memory_order_relaxed);
+        }
+        return slots;
+    }
+
+    void free_slots(FSTraceCountTotals::Slot* slots)
+    {
+        // std::atomic of F64 and U64 need no destruction
+        ll_aligned_free<CACHE_LINE_SIZE>(slots);
+    }
+
+    // Folds the thread's totals into the registry when the thread exits
+    struct ThreadExitHook
+    {
+        ~ThreadExitHook()
+        {
+            FSTraceCountTotals::ThreadSlots* thread_slots = LLThreadLocalSingletonPointer<FSTraceCountTotals::ThreadSlots>::getInstance();
+            Registry& registry = get_registry();
+            {
+                std::lock_guard<std::mutex> lock(registry.mMutex);
+                for (size_t i = 0; i < thread_slots->mNumSlots; ++i)
+                {
+                    const FSTraceCountTotals::Slot& slot = thread_slots->mSlots[i];
+                    U64 count = slot.mCount.load(std::memory_order_relaxed);
+                    if (count)
+                    {
+                        registry.retire(i, slot.mSum.load(std::memory_order_relaxed), count);
+                    }
+                }
+                registry.mThreads.erase(std::find(registry.mThreads.begin(), registry.mThreads.end(), thread_slots));
+            }
+            free_slots(thread_slots->mSlots);
+            delete thread_slots;
+            LLThreadLocalSingletonPointer<FSTraceCountTotals::ThreadSlots>::setInstance(nullptr);
+            sThreadExited = true;
+        }
+    };
+}
+
+// static
+void FSTraceCountTotals::addSlow(size_t index, F64 value)
+{
+    Registry& registry = get_registry();
+    if (sThreadExited)
+    {
+        std::lock_guard<std::mutex> lock(registry.mMutex);
+        registry.retire(index, value, 1);
+        return;
+    }
+
+    // Room for stats registered later on, in whole cache lines
+    size_t num_slots = std::max(MIN_SLOTS, index + 1 + index / 2);
+    num_slots = (num_slots + SLOTS_PER_LINE - 1) / SLOTS_PER_LINE * SLOTS_PER_LINE;
+    Slot* slots = allocate_slots(num_slots);
+
+    ThreadSlots* thread_slots = LLThreadLocalSingletonPointer<ThreadSlots>::getInstance();
+    Slot* old_slots = nullptr;
+    {
+        // Readers must not see the slots while they are swapped
+        std::lock_guard<std::mutex> lock(registry.mMutex);
+        if (thread_slots)
+        {
+            for (size_t i = 0; i < thread_slots->mNumSlots; ++i)
+            {
+                slots[i].mSum.store(thread_slots->mSlots[i].mSum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                slots[i].mCount.store(thread_slots->mSlots[i].mCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            old_slots = thread_slots->mSlots;
+        }
+        else
+        {
+            thread_slots = new ThreadSlots();
+            registry.mThreads.push_back(thread_slots);
+        }
+        thread_slots->mSlots = slots;
+        thread_slots->mNumSlots = num_slots;
+    }
+    if (old_slots)
+    {
+        free_slots(old_slots);
+    }
+    else
+    {
+        LLThreadLocalSingletonPointer<ThreadSlots>::setInstance(thread_slots);
+        static thread_local ThreadExitHook sExitHook;
+        (void)sExitHook;
+    }
+
+    add(index, value);
+}
+
+// static
+F64 FSTraceCountTotals::getSum(size_t index)
+{
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    F64 sum = index < registry.mRetiredSums.size() ? registry.mRetiredSums[index] : 0.0;
+    for (const ThreadSlots* thread_slots : registry.mThreads)
+    {
+        if (index < thread_slots->mNumSlots)
+        {
+            sum += thread_slots->mSlots[index].mSum.load(std::memory_order_relaxed);
+        }
+    }
+    return sum;
+}
+
+// static
+U64 FSTraceCountTotals::getCount(size_t index)
+{
+    Registry& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    U64 count = index < registry.mRetiredCounts.size() ? registry.mRetiredCounts[index] : 0;
+    for (const ThreadSlots* thread_slots : registry.mThreads)
+    {
+        if (index < thread_slots->mNumSlots)
+        {
+            count += thread_slots->mSlots[index].mCount.load(std::memory_order_relaxed);
+        }
+    }
+    return count;
+}
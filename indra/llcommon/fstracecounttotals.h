@@ -0,0 +1,88 @@
+/**
+ * @file fstracecounttotals.h
+ * @brief Lifetime totals of LLTrace count stats in per-thread, cache line padded slots
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_TRACECOUNTTOTALS_H
+#define FS_TRACECOUNTTOTALS_H
+
+#include "llpreprocessor.h"
+#include "stdtypes.h"
+#include "llthreadlocalstorage.h"
+
+#include <atomic>
+#include <cstddef>
+
+// Sums and counts of everything ever added to each CountStatHandle, over all
+// threads and the whole session.
+//
+// The texture fetch, mesh and HTTP threads add to the same stats as the main
+// thread. Kept on the handle, every add() from any of them wrote the same
+// cache line, and the handles sit next to each other as globals. Instead
+// every thread adds into slots of its own, indexed by the stat's accumulator
+// index. Only the owning thread writes them, so no atomic read-modify-write
+// is needed, and the slots of a thread start and end on a cache line
+// boundary. Reading a total adds up the slots of all threads.
+class LL_COMMON_API FSTraceCountTotals
+{
+public:
+    struct Slot
+    {
+        std::atomic<F64>    mSum;
+        std::atomic<U64>    mCount;
+    };
+
+    struct ThreadSlots
+    {
+        Slot*   mSlots;
+        size_t  mNumSlots;
+    };
+
+    LL_FORCE_INLINE static void add(size_t index, F64 value)
+    {
+        ThreadSlots* thread_slots = LLThreadLocalSingletonPointer<ThreadSlots>::getInstance();
+        if (LL_LIKELY(thread_slots && index < thread_slots->mNumSlots))
+        {
+            Slot& slot = thread_slots->mSlots[index];
+            slot.mSum.store(slot.mSum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            slot.mCount.store(slot.mCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        else
+        {
+            addSlow(index, value);
+        }
+    }
+
+    // Totals of all threads, including threads that have exited
+    static F64 getSum(size_t index);
+    static U64 getCount(size_t index);
+
+private:
+    // First add() on a thread, a stat index past its slots, or a thread
+    // whose thread locals are being destroyed
+    static void addSlow(size_t index, F64 value);
+};
+
+#endif // FS_TRACECOUNTTOTALS_H
@@ -383,6 +383,7 @@ void LLApp::setErrorHandler(LLAppErrorHandler handler)
 // static
 void LLApp::runErrorHandler()
 {
+    LLError::flushAsyncLogging(); // <FS/> Asynchronous logging: the crash handler wants the last messages
     if (LLApp::sErrorHandler)
     {
         LLApp::sErrorHandler();
@@ -710,6 +711,7 @@ void default_unix_signal_handler(int signum, siginfo_t *info, void *)
         {
             LL_WARNS() << "Signal handler - Got SIGABRT, terminating" << LL_ENDL;
         }
+        LLError::flushAsyncLogging(); // <FS/> Asynchronous logging
         clear_signals();
         raise(signum);
         return;
@@ -788,6 +790,7 @@ void default_unix_signal_handler(int signum, siginfo_t *info, void *)
             {
                 clear_signals();
                 LL_WARNS() << "Fatal signal received, not handling the crash here, passing back to operating system" << LL_ENDL;
+                LLError::flushAsyncLogging(); // <FS/> Asynchronous logging
                 raise(signum);
                 return;
             }
@@ -799,6 +802,7 @@ void default_unix_signal_handler(int signum, siginfo_t *info, void *)
             {
                 LL_WARNS() << "Signal handler - App is stopped, reraising signal" << LL_ENDL;
             }
+            LLError::flushAsyncLogging(); // <FS/> Asynchronous logging
             clear_signals();
             raise(signum);
             return;
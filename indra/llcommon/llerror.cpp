@@ -55,6 +55,7 @@
 #include "llsingleton.h"
 #include "llstl.h"
 #include "lltimer.h"
+#include "fsasynclogwriter.h" // <FS> Asynchronous logging
 
 // On Mac, got:
 // #error "Boost.Stacktrace requires `_Unwind_Backtrace` function. Define
@@ -126,11 +127,40 @@ namespace {
     };
 #endif
 
+    // <FS> Asynchronous logging
+    std::string escapedMessageLines(const std::string& message);
+
+    // How long a crash handler waits for queued messages to be written
+    const U32 CRASH_FLUSH_TIMEOUT_MS = 500;
+
+    // Same text as LLError::utcTime() for a given time, safe to call from any thread
+    void appendUTCTime(time_t time, std::string& out)
+    {
+        struct tm utc;
+#if LL_WINDOWS
+        if (gmtime_s(&utc, &time) != 0)
+#else
+        if (!gmtime_r(&time, &utc))
+#endif
+        {
+            out += "time error";
+            return;
+        }
+        char time_str[64];    /* Flawfinder: ignore */
+        size_t chars = strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        out.append(chars ? time_str : "time error");
+    }
+    // </FS>
+
     class RecordToFile : public LLError::Recorder
     {
     public:
         RecordToFile(const std::string& filename):
-            mName(filename)
+            mName(filename),
+            // <FS> Asynchronous logging
+            mAlwaysFlush(true),
+            mLastFormattedTime(0)
+            // </FS>
         {
             // <FS:Ansariel> Don't screw up log file output
             this->showMultiline(true);
@@ -150,6 +180,9 @@ namespace {
 
         ~RecordToFile()
         {
+            // <FS> Asynchronous logging: writes out what is still queued
+            mWriter.reset();
+            // </FS>
             mFile.close();
         }
 
@@ -170,6 +203,12 @@ namespace {
                                     const std::string& message) override
         {
             LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
+            // <FS> Asynchronous logging: keep the order with anything queued
+            if (mWriter)
+            {
+                mWriter->flush();
+            }
+            // </FS>
             if (LLError::getAlwaysFlush())
             {
                 mFile << message << std::endl;
@@ -180,9 +219,105 @@ namespace {
             }
         }
 
+        // <FS> Asynchronous logging
+        virtual bool recordDeferred(const LLError::CallSite& site, time_t time,
+                                    const std::string& message) override
+        {
+            LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
+            mAlwaysFlush = LLError::getAlwaysFlush();
+            if (!mWriter)
+            {
+                mWriter.reset(new FSAsyncLogWriter(
+                    [this](const FSAsyncLogWriter::Record& record, std::string& batch) { formatRecord(record, batch); },
+                    [this](const std::string& batch) { writeBatch(batch); }));
+                mWriter->setDroppedFunction([this](U64 count, std::string& batch) { formatDropped(count, batch); });
+            }
+
+            mWriter->push(&site, site.mLevel, time, message);
+            if (site.mLevel == LLError::LEVEL_ERROR)
+            {
+                // The crash function runs next, the message has to be on disk
+                mWriter->flush();
+            }
+            return true;
+        }
+
+        virtual void flushDeferred() override
+        {
+            if (mWriter)
+            {
+                mWriter->flushForCrash(CRASH_FLUSH_TIMEOUT_MS);
+            }
+            mFile.flush();
+        }
+
+    private:
+        // Writer thread; the same layout writeToRecorders() gives this recorder
+        void formatRecord(const FSAsyncLogWriter::Record& record, std::string& batch)
+        {
+            const LLError::CallSite& site = *record.mSite;
+            if (mWantsTime)
+            {
+                if (record.mTime != mLastFormattedTime || mFormattedTime.empty())
+                {
+                    mFormattedTime.clear();
+                    appendUTCTime(record.mTime, mFormattedTime);
+                    mLastFormattedTime = record.mTime;
+                }
+                batch += mFormattedTime;
+            }
+            batch += ' ';
+            if (mWantsLevel)
+            {
+                batch += site.mLevelString;
+            }
+            batch += ' ';
+            if (mWantsTags)
+            {
+                batch += site.mTagString;
+            }
+            batch += ' ';
+            if (mWantsLocation || record.mLevel == LLError::LEVEL_ERROR)
+            {
+                batch += site.mLocationString;
+            }
+            batch += ' ';
+            if (mWantsFunctionName)
+            {
+                batch += site.mFunctionString;
+            }
+            batch += " : ";
+            batch += mWantsMultiline ? record.mMessage : escapedMessageLines(record.mMessage);
+            batch += '\n';
+        }
+
+        void formatDropped(U64 count, std::string& batch)
+        {
+            appendUTCTime(time(NULL), batch);
+            batch += " WARNING # llerror : ";
+            batch += std::to_string(count);
+            batch += " log messages dropped, logging faster than the log file could be written\n";
+        }
+
+        void writeBatch(const std::string& batch)
+        {
+            mFile.write(batch.data(), batch.size());
+            if (mAlwaysFlush)
+            {
+                mFile.flush();
+            }
+        }
+        // </FS>
+
     private:
         const std::string mName;
         llofstream mFile;
+        // <FS> Asynchronous logging
+        std::atomic<bool> mAlwaysFlush;
+        time_t mLastFormattedTime;  // writer thread
+        std::string mFormattedTime; // writer thread
+        std::unique_ptr<FSAsyncLogWriter> mWriter;
+        // </FS>
     };
 
 
@@ -498,6 +633,7 @@ namespace
         LLError::ELevel                     mDefaultLevel;
 
         bool                                mLogAlwaysFlush;
+        bool                                mLogAsync; // <FS> Asynchronous logging
 
         U32                                 mEnabledLogTypesMask;
 
@@ -525,6 +661,7 @@ namespace
         : LLRefCount(),
         mDefaultLevel(LLError::LEVEL_DEBUG),
         mLogAlwaysFlush(true),
+        mLogAsync(false), // <FS> Asynchronous logging
         mEnabledLogTypesMask(255),
         mFunctionLevelMap(),
         mClassLevelMap(),
@@ -756,6 +893,7 @@ namespace
 
         LLError::setDefaultLevel(LLError::LEVEL_INFO);
         LLError::setAlwaysFlush(true);
+        LLError::setAsyncLogging(false); // <FS> Asynchronous logging, off until every crash reporter flushes it
         LLError::setEnabledLogTypesMask(0xFFFFFFFF);
         LLError::setTimeFunction(LLError::utcTime);
 
@@ -840,6 +978,35 @@ namespace LLError
         return s->mLogAlwaysFlush;
     }
 
+    // <FS> Asynchronous logging
+    void setAsyncLogging(bool async)
+    {
+        SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+        s->mLogAsync = async;
+    }
+
+    bool getAsyncLogging()
+    {
+        SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+        return s->mLogAsync;
+    }
+
+    void flushAsyncLogging()
+    {
+        SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+        // The crashed thread may hold the lock, don't wait for it for long
+        LLMutexTrylock lock(&s->mRecorderMutex, 5);
+        if (!lock.isLocked())
+        {
+            return;
+        }
+        for (LLError::RecorderPtr& r : s->mRecorders)
+        {
+            r->flushDeferred();
+        }
+    }
+    // </FS>
+
     void setEnabledLogTypesMask(U32 mask)
     {
         SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
@@ -940,6 +1107,12 @@ namespace LLError
         {
             setAlwaysFlush(config["log-always-flush"]);
         }
+        // <FS> Asynchronous logging
+        if (config.has("log-async"))
+        {
+            setAsyncLogging(config["log-async"]);
+        }
+        // </FS>
         if (config.has("enabled-log-types-mask"))
         {
             setEnabledLogTypesMask(config["enabled-log-types-mask"].asInteger());
@@ -1232,6 +1405,13 @@ namespace
 
         std::string escaped_message;
 
+        // <FS> Asynchronous logging: recorders that can take the message as it
+        // is format it later on a thread of their own. Their time stamps
+        // come from utcTime(), anything else is formatted here.
+        const bool defer = s->mLogAsync && (s->mTimeFunction == LLError::utcTime || s->mTimeFunction == NULL);
+        const time_t now = defer ? time(NULL) : 0;
+        // </FS>
+
         LLMutexLock lock(&s->mRecorderMutex);
         for (LLError::RecorderPtr& r : s->mRecorders)
         {
@@ -1242,6 +1422,13 @@ namespace
                 continue;
             }
 
+            // <FS> Asynchronous logging
+            if (defer && (s->mTimeFunction != NULL || !r->wantsTime()) && r->recordDeferred(site, now, message))
+            {
+                continue;
+            }
+            // </FS>
+
             std::ostringstream message_stream;
 
             if (r->wantsTime() && s->mTimeFunction != NULL)
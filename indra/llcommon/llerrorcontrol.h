@@ -33,6 +33,7 @@
 #include "llrefcount.h"
 #include "boost/function.hpp"
 #include "boost/shared_ptr.hpp"
+#include <ctime>
 #include <string>
 
 class LLSD;
@@ -76,6 +77,12 @@ namespace LLError
     LL_COMMON_API ELevel getDefaultLevel();
     LL_COMMON_API void setAlwaysFlush(bool flush);
     LL_COMMON_API bool getAlwaysFlush();
+    // <FS> Asynchronous logging: recorders that support it write on a thread of their own
+    LL_COMMON_API void setAsyncLogging(bool async);
+    LL_COMMON_API bool getAsyncLogging();
+    // Writes out queued messages from a crash or signal handler
+    LL_COMMON_API void flushAsyncLogging();
+    // </FS>
     LL_COMMON_API void setEnabledLogTypesMask(U32 mask);
     LL_COMMON_API U32 getEnabledLogTypesMask();
     LL_COMMON_API void setFunctionLevel(const std::string& function_name, LLError::ELevel);
@@ -149,6 +156,14 @@ namespace LLError
         virtual void recordMessage(LLError::ELevel, const std::string& message) = 0;
             // use the level for better display, not for filtering
 
+        // <FS> Asynchronous logging
+        virtual bool recordDeferred(const LLError::CallSite& site, time_t time, const std::string& message) { return false; }
+            // takes the unformatted message of a static call site instead of
+            // recordMessage(); returns false to get recordMessage() called
+        virtual void flushDeferred() {}
+            // called from crash handlers, must not wait for long
+        // </FS>
+
         virtual bool enabled() { return true; }
 
         bool wantsTime();
@@ -28,6 +28,8 @@
 #ifndef LL_LLINSTANCETRACKER_H
 #define LL_LLINSTANCETRACKER_H
 
+#include <algorithm>
+#include <functional>
 #include <map>
 #include <set>
 #include <vector>
@@ -41,18 +43,78 @@
 #include <boost/iterator/indirect_iterator.hpp>
 #include <boost/iterator/filter_iterator.hpp>
 
-#include "lockstatic.h"
 #include "stringize.h"
 
 /*****************************************************************************
-*   StaticBase
+*   Shards
 *****************************************************************************/
 namespace LLInstanceTrackerPrivate
 {
-    struct StaticBase
+    // Instances are spread over this many independently locked shards, so
+    // threads creating, destroying and looking up instances of the same
+    // class rarely wait on each other.
+    constexpr size_t SHARD_COUNT = 16;
+
+    inline size_t shard_index(size_t hash)
+    {
+        // std::hash is the identity for integers and pointers: mix the bits
+        // before picking a shard
+        hash ^= hash >> 16;
+        hash *= 0x45d9f3b;
+        hash ^= hash >> 16;
+        return hash % SHARD_COUNT;
+    }
+
+    template <typename KEY, typename = void>
+    struct is_hashable: std::false_type {};
+    template <typename KEY>
+    struct is_hashable<KEY, decltype(void(std::hash<KEY>()(std::declval<const KEY&>())))>:
+        std::true_type {};
+
+    // keys without a std::hash specialization all live in the first shard
+    template <typename KEY>
+    typename std::enable_if<is_hashable<KEY>::value, size_t>::type key_shard(const KEY& key)
+    {
+        return shard_index(std::hash<KEY>()(key));
+    }
+    template <typename KEY>
+    typename std::enable_if<! is_hashable<KEY>::value, size_t>::type key_shard(const KEY&)
+    {
+        return 0;
+    }
+
+    template <typename CONTAINER>
+    struct Shard
     {
         // We need to be able to lock static data while manipulating it.
         std::mutex mMutex;
+        CONTAINER mInstances;
+    };
+
+    template <typename CONTAINER>
+    struct ShardedStatic
+    {
+        Shard<CONTAINER> mShards[SHARD_COUNT];
+
+        // Function-local static for the same reason llthread::LockStatic
+        // uses one: instances may be constructed during static
+        // initialization, before a class static would be.
+        static ShardedStatic& get()
+        {
+            static ShardedStatic sData;
+            return sData;
+        }
+
+        size_t size()
+        {
+            size_t count = 0;
+            for (auto& shard : mShards)
+            {
+                std::lock_guard<std::mutex> lock(shard.mMutex);
+                count += shard.mInstances.size();
+            }
+            return count;
+        }
     };
 
     void logerrs(const char* cls, const std::string&, const std::string&, const std::string&);
@@ -76,11 +138,13 @@ template<typename T, typename KEY = void,
 class LLInstanceTracker
 {
     typedef std::map<KEY, std::shared_ptr<T>> InstanceMap;
-    struct StaticData: public LLInstanceTrackerPrivate::StaticBase
+    typedef LLInstanceTrackerPrivate::Shard<InstanceMap> Shard;
+    typedef LLInstanceTrackerPrivate::ShardedStatic<InstanceMap> StaticData;
+
+    static Shard& getShard(const KEY& key)
     {
-        InstanceMap mMap;
-    };
-    typedef llthread::LockStatic<StaticData> LockStatic;
+        return StaticData::get().mShards[LLInstanceTrackerPrivate::key_shard(key)];
+    }
 
 public:
     using ptr_t  = std::shared_ptr<T>;
@@ -101,7 +165,7 @@ public:
 
     static size_t instanceCount()
     {
-        return LockStatic()->mMap.size();
+        return StaticData::get().size();
     }
 
     // snapshot of std::pair<const KEY, std::shared_ptr<SUBCLASS>> pairs, for
@@ -112,7 +176,8 @@ public:
         // It's very important that what we store in this snapshot are
         // weak_ptrs, NOT shared_ptrs. That's how we discover whether any
         // instance has been deleted during the lifespan of a snapshot.
-        typedef std::vector<std::pair<const KEY, weak_t>> VectorType;
+        // The key isn't const so the per-shard runs can be merged in place.
+        typedef std::vector<std::pair<KEY, weak_t>> VectorType;
         // Dereferencing the iterator we publish produces a
         // std::shared_ptr<SUBCLASS> for each instance that still exists.
         // Since we store weak_ptr<T>, that involves two chained
@@ -137,15 +202,50 @@ public:
         {
             return bool(pair.second);
         }
+        static bool key_less(const typename VectorType::value_type& lhs,
+                             const typename VectorType::value_type& rhs)
+        {
+            return std::less<KEY>()(lhs.first, rhs.first);
+        }
 
     public:
-        snapshot_of():
-            // populate our vector with a snapshot of (locked!) InstanceMap
-            // note, this assigns pair<KEY, shared_ptr> to pair<KEY, weak_ptr>
-            mData(mLock->mMap.begin(), mLock->mMap.end())
+        snapshot_of()
         {
-            // release the lock once we've populated mData
-            mLock.unlock();
+            StaticData& data(StaticData::get());
+            // populate our vector with a snapshot of each (locked!) shard in
+            // turn, remembering where each shard's sorted run starts
+            // note, this assigns pair<KEY, shared_ptr> to pair<KEY, weak_ptr>
+            std::vector<size_t> runs{ 0 };
+            for (Shard& shard : data.mShards)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(shard.mMutex);
+                    mData.insert(mData.end(), shard.mInstances.begin(), shard.mInstances.end());
+                }
+                if (mData.size() != runs.back())
+                {
+                    runs.push_back(mData.size());
+                }
+            }
+            // merge the runs pairwise so we still iterate in key order
+            while (runs.size() > 2)
+            {
+                std::vector<size_t> merged{ 0 };
+                size_t i = 0;
+                for (; i + 2 < runs.size(); i += 2)
+                {
+                    std::inplace_merge(mData.begin() + runs[i],
+                                       mData.begin() + runs[i + 1],
+                                       mData.begin() + runs[i + 2],
+                                       key_less);
+                    merged.push_back(runs[i + 2]);
+                }
+                if (i + 1 < runs.size())
+                {
+                    merged.push_back(runs[i + 1]);
+                }
+                runs.swap(merged);
+            }
         }
 
         // You can't make a transform_iterator (or anything else) that
@@ -168,24 +268,6 @@ public:
                             strong_iterator(mData.end(), strengthen));
         }
 
-        // lock static data during construction
-#if ! LL_WINDOWS
-        LockStatic mLock;
-#else  // LL_WINDOWS
-        // We want to be able to use (e.g.) our instance_snapshot subclass as:
-        // for (auto& inst : T::instance_snapshot()) ...
-        // But when this snapshot base class directly contains LockStatic, as
-        // above, Visual Studio 2017 requires us to code instead:
-        // for (auto& inst : std::move(T::instance_snapshot())) ...
-        // nat thinks this should be unnecessary, as an anonymous class
-        // instance is already a temporary. It shouldn't need to be cast to
-        // rvalue reference (the role of std::move()). clang evidently agrees,
-        // as the short form works fine with Xcode on Mac.
-        // To support the succinct usage, instead of directly storing
-        // LockStatic, store std::shared_ptr<LockStatic>, which is copyable.
-        std::shared_ptr<LockStatic> mLockp{std::make_shared<LockStatic>()};
-        LockStatic& mLock{*mLockp};
-#endif // LL_WINDOWS
         VectorType mData;
     };
     using snapshot = snapshot_of<T>;
@@ -236,8 +318,9 @@ public:
 
     static ptr_t getInstance(const KEY& k)
     {
-        LockStatic lock;
-        const InstanceMap& map(lock->mMap);
+        Shard& shard(getShard(k));
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        const InstanceMap& map(shard.mInstances);
         typename InstanceMap::const_iterator found = map.find(k);
         return (found == map.end()) ? NULL : found->second;
     }
@@ -252,25 +335,39 @@ protected:
         ptr_t ptr(static_cast<T*>(this), [](T*){});
         // save corresponding weak_ptr for future reference
         mSelf = ptr;
-        LockStatic lock;
-        add_(lock, key, ptr);
+        Shard& shard(getShard(key));
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        add_(shard, key, ptr);
     }
 public:
     virtual ~LLInstanceTracker()
     {
-        LockStatic lock;
-        remove_(lock);
+        Shard& shard(getShard(mInstanceKey));
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        remove_(shard);
     }
 protected:
     virtual void setKey(KEY key)
     {
-        LockStatic lock;
+        Shard& old_shard(getShard(mInstanceKey));
+        Shard& new_shard(getShard(key));
         // Even though the shared_ptr we store in our map has a no-op deleter
         // for T itself, letting the use count decrement to 0 will still
         // delete the use-count object. Capture the shared_ptr we just removed
         // and re-add it to the map with the new key.
-        auto ptr = remove_(lock);
-        add_(lock, key, ptr);
+        if (&old_shard == &new_shard)
+        {
+            std::lock_guard<std::mutex> lock(old_shard.mMutex);
+            auto ptr = remove_(old_shard);
+            add_(new_shard, key, ptr);
+        }
+        else
+        {
+            // lock both shards at once so the instance is never missing
+            std::scoped_lock lock(old_shard.mMutex, new_shard.mMutex);
+            auto ptr = remove_(old_shard);
+            add_(new_shard, key, ptr);
+        }
     }
 public:
     virtual const KEY& getKey() const { return mInstanceKey; }
@@ -285,34 +382,33 @@ private:
     static std::string report(const std::string& key) { return "'" + key + "'"; }
     static std::string report(const char* key) { return report(std::string(key)); }
 
-    // caller must instantiate LockStatic
-    void add_(LockStatic& lock, const KEY& key, const ptr_t& ptr)
+    // caller must hold the shard's lock exclusively
+    void add_(Shard& shard, const KEY& key, const ptr_t& ptr)
     {
         mInstanceKey = key;
-        InstanceMap& map = lock->mMap;
+        InstanceMap& map = shard.mInstances;
+        // map stores shared_ptr to self
+        auto pair = map.emplace(key, ptr);
+        if (pair.second)
+        {
+            return;
+        }
         switch(KEY_COLLISION_BEHAVIOR)
         {
         case LLInstanceTrackerErrorOnCollision:
-        {
-            // map stores shared_ptr to self
-            auto pair = map.emplace(key, ptr);
-            if (! pair.second)
-            {
-                LLInstanceTrackerPrivate::logerrs(typeid(*this).name(), " instance with key ",
-                                                  report(key), " already exists!");
-            }
+            LLInstanceTrackerPrivate::logerrs(typeid(*this).name(), " instance with key ",
+                                              report(key), " already exists!");
             break;
-        }
         case LLInstanceTrackerReplaceOnCollision:
-            map[key] = ptr;
+            pair.first->second = ptr;
             break;
         default:
             break;
         }
     }
-    ptr_t remove_(LockStatic& lock)
+    ptr_t remove_(Shard& shard)
     {
-        InstanceMap& map = lock->mMap;
+        InstanceMap& map = shard.mInstances;
         typename InstanceMap::iterator iter = map.find(mInstanceKey);
         if (iter != map.end())
         {
@@ -351,11 +447,15 @@ template<typename T, EInstanceTrackerAllowKeyCollisions KEY_COLLISION_BEHAVIOR>
 class LLInstanceTracker<T, void, KEY_COLLISION_BEHAVIOR>
 {
     typedef std::set<std::shared_ptr<T>> InstanceSet;
-    struct StaticData: public LLInstanceTrackerPrivate::StaticBase
+    typedef LLInstanceTrackerPrivate::Shard<InstanceSet> Shard;
+    typedef LLInstanceTrackerPrivate::ShardedStatic<InstanceSet> StaticData;
+
+    // without a key, spread instances by address
+    static Shard& getShard(const void* instance)
     {
-        InstanceSet mSet;
-    };
-    typedef llthread::LockStatic<StaticData> LockStatic;
+        return StaticData::get().mShards[LLInstanceTrackerPrivate::shard_index(
+            reinterpret_cast<uintptr_t>(instance) >> 4)];
+    }
 
 public:
     using ptr_t  = std::shared_ptr<T>;
@@ -376,7 +476,7 @@ public:
 
     static size_t instanceCount()
     {
-        return LockStatic()->mSet.size();
+        return StaticData::get().size();
     }
 
     // snapshot of std::shared_ptr<SUBCLASS> pointers
@@ -405,13 +505,16 @@ public:
         }
 
     public:
-        snapshot_of():
-            // populate our vector with a snapshot of (locked!) InstanceSet
-            // note, this assigns stored shared_ptrs to weak_ptrs for snapshot
-            mData(mLock->mSet.begin(), mLock->mSet.end())
+        snapshot_of()
         {
-            // release the lock once we've populated mData
-            mLock.unlock();
+            StaticData& data(StaticData::get());
+            // populate our vector with a snapshot of each (locked!) shard
+            // note, this assigns stored shared_ptrs to weak_ptrs for snapshot
+            for (Shard& shard : data.mShards)
+            {
+                std::lock_guard<std::mutex> lock(shard.mMutex);
+                mData.insert(mData.end(), shard.mInstances.begin(), shard.mInstances.end());
+            }
         }
 
         typedef boost::transform_iterator<decltype(strengthen)*,
@@ -431,24 +534,6 @@ public:
                             strong_iterator(mData.end(), strengthen));
         }
 
-        // lock static data during construction
-#if ! LL_WINDOWS
-        LockStatic mLock;
-#else  // LL_WINDOWS
-        // We want to be able to use our instance_snapshot subclass as:
-        // for (auto& inst : T::instance_snapshot()) ...
-        // But when this snapshot base class directly contains LockStatic, as
-        // above, Visual Studio 2017 requires us to code instead:
-        // for (auto& inst : std::move(T::instance_snapshot())) ...
-        // nat thinks this should be unnecessary, as an anonymous class
-        // instance is already a temporary. It shouldn't need to be cast to
-        // rvalue reference (the role of std::move()). clang evidently agrees,
-        // as the short form works fine with Xcode on Mac.
-        // To support the succinct usage, instead of directly storing
-        // LockStatic, store std::shared_ptr<LockStatic>, which is copyable.
-        std::shared_ptr<LockStatic> mLockp{std::make_shared<LockStatic>()};
-        LockStatic& mLock{*mLockp};
-#endif // LL_WINDOWS
         VectorType mData;
     };
     using snapshot = snapshot_of<T>;
@@ -488,14 +573,18 @@ protected:
         // save corresponding weak_ptr for future reference
         mSelf = ptr;
         // Also store it in our class-static set to track this instance.
-        LockStatic()->mSet.emplace(ptr);
+        Shard& shard(getShard(this));
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        shard.mInstances.emplace(ptr);
     }
 public:
     virtual ~LLInstanceTracker()
     {
         // convert weak_ptr to shared_ptr because that's what we store in our
         // InstanceSet
-        LockStatic()->mSet.erase(mSelf.lock());
+        Shard& shard(getShard(this));
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+        shard.mInstances.erase(mSelf.lock());
     }
 protected:
     LLInstanceTracker(const LLInstanceTracker& other):
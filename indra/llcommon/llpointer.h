@@ -342,6 +342,58 @@ private:
 };
 
 
+// <FS> Borrowed pointers
+// Non-owning view of an object kept alive by someone else, typically by the
+// LLPointer in the container being walked. Copying one touches no reference
+// count, which is what makes it worth using in place of LLPointer copies in
+// traversal loops. Assign it to an LLPointer to keep the object beyond the
+// lifetime of its owner. It can't be made from a temporary LLPointer, which
+// would leave it dangling.
+template <class Type> class LLBorrowedPointer
+{
+public:
+    LLBorrowedPointer() :
+        mPointer(NULL)
+    {
+    }
+
+    explicit LLBorrowedPointer(Type* ptr) :
+        mPointer(ptr)
+    {
+    }
+
+    LLBorrowedPointer(const LLPointer<Type>& ptr) :
+        mPointer(ptr.get())
+    {
+    }
+
+    template<typename Subclass>
+    LLBorrowedPointer(const LLPointer<Subclass>& ptr) :
+        mPointer(ptr.get())
+    {
+    }
+
+    LLBorrowedPointer(LLPointer<Type>&&) = delete;
+    template<typename Subclass>
+    LLBorrowedPointer(LLPointer<Subclass>&&) = delete;
+
+    Type*   get() const                         { return mPointer; }
+    Type*   operator->() const                  { return mPointer; }
+    Type&   operator*() const                   { return *mPointer; }
+
+    operator Type*() const                      { return mPointer; }
+    bool operator!() const                      { return (mPointer == NULL); }
+    bool isNull() const                         { return (mPointer == NULL); }
+    bool notNull() const                        { return (mPointer != NULL); }
+
+    bool operator ==(Type* ptr) const           { return (mPointer == ptr); }
+    bool operator !=(Type* ptr) const           { return (mPointer != ptr); }
+
+private:
+    Type*   mPointer;
+};
+// </FS>
+
 // boost hash adapter
 template <class Type>
 struct boost::hash<LLPointer<Type>>
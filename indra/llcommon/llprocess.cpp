@@ -35,6 +35,7 @@
 #include "apr_signal.h"
 #include "llevents.h"
 #include "llexception.h"
+#include "fseventchannel.h" // <FS/> Typed mainloop channel
 
 #include <boost/bind.hpp>
 #include <boost/asio/streambuf.hpp>
@@ -82,8 +83,11 @@ public:
         if (mCount++ == 0)
         {
             LL_DEBUGS("LLProcess") << "listening on \"mainloop\"" << LL_ENDL;
-            mConnection = LLEventPumps::instance().obtain("mainloop")
-                .listen("LLProcessListener", boost::bind(&LLProcessListener::tick, this, _1));
+            // <FS> Typed mainloop channel
+            //mConnection = LLEventPumps::instance().obtain("mainloop")
+            //    .listen("LLProcessListener", boost::bind(&LLProcessListener::tick, this, _1));
+            mConnection = fs_mainloop_channel().listen(boost::bind(&LLProcessListener::tick, this, _1));
+            // </FS>
         }
     }
 
@@ -100,7 +104,7 @@ public:
 
 private:
     /// called once per frame by the "mainloop" LLEventPump
-    bool tick(const LLSD&)
+    bool tick(const FSMainloopEvent&) // <FS/> Typed mainloop channel
     {
         // Tell APR to sense whether each registered LLProcess is still
         // running and call handle_status() appropriately. We should be able
@@ -125,7 +129,7 @@ private:
 
     /// If this object is destroyed before mCount goes to zero, stop
     /// listening on "mainloop" anyway.
-    LLTempBoundListener mConnection;
+    FSScopedEventConnection mConnection; // <FS/> Typed mainloop channel
     unsigned mCount;
 };
 static LLProcessListener sProcessListener;
@@ -148,9 +152,12 @@ public:
         // Essential to initialize our std::ostream with our special streambuf!
         mStream(&mStreambuf)
     {
-        mConnection = LLEventPumps::instance().obtain("mainloop")
-            .listen(LLEventPump::inventName("WritePipe"),
-                    boost::bind(&WritePipeImpl::tick, this, _1));
+        // <FS> Typed mainloop channel
+        //mConnection = LLEventPumps::instance().obtain("mainloop")
+        //    .listen(LLEventPump::inventName("WritePipe"),
+        //            boost::bind(&WritePipeImpl::tick, this, _1));
+        mConnection = fs_mainloop_channel().listen(boost::bind(&WritePipeImpl::tick, this, _1));
+        // </FS>
 
 #if ! LL_WINDOWS
         // We can't count on every child process reading everything we try to
@@ -165,7 +172,7 @@ public:
     virtual std::ostream& get_ostream() { return mStream; }
     virtual size_type size() const { return mStreambuf.size(); }
 
-    bool tick(const LLSD&)
+    bool tick(const FSMainloopEvent&) // <FS/> Typed mainloop channel
     {
         typedef boost::asio::streambuf::const_buffers_type const_buffer_sequence;
         // If there's anything to send, try to send it.
@@ -247,7 +254,7 @@ public:
 private:
     std::string mDesc;
     apr_file_t* mPipe;
-    LLTempBoundListener mConnection;
+    FSScopedEventConnection mConnection; // <FS/> Typed mainloop channel
     boost::asio::streambuf mStreambuf;
     std::ostream mStream;
 };
@@ -266,9 +273,12 @@ public:
         mLimit(0),
         mEOF(false)
     {
-        mConnection = LLEventPumps::instance().obtain("mainloop")
-            .listen(LLEventPump::inventName("ReadPipe"),
-                    boost::bind(&ReadPipeImpl::tick, this, _1));
+        // <FS> Typed mainloop channel
+        //mConnection = LLEventPumps::instance().obtain("mainloop")
+        //    .listen(LLEventPump::inventName("ReadPipe"),
+        //            boost::bind(&ReadPipeImpl::tick, this, _1));
+        mConnection = fs_mainloop_channel().listen(boost::bind(&ReadPipeImpl::tick, this, _1));
+        // </FS>
     }
 
     ~ReadPipeImpl()
@@ -357,7 +367,7 @@ public:
         return (found == end)? npos : (found - begin);
     }
 
-    bool tick(const LLSD&)
+    bool tick(const FSMainloopEvent&) // <FS/> Typed mainloop channel
     {
         // Once we've hit EOF, skip all the rest of this.
         if (mEOF)
@@ -467,7 +477,7 @@ private:
     std::string mDesc;
     apr_file_t* mPipe;
     LLProcess::FILESLOT mIndex;
-    LLTempBoundListener mConnection;
+    FSScopedEventConnection mConnection; // <FS/> Typed mainloop channel
     boost::asio::streambuf mStreambuf;
     std::istream mStream;
     LLEventStream mPump;
@@ -1006,8 +1016,11 @@ void LLProcess::handle_status(int reason, int status)
         ReadPipeImpl* ppipe = getPipePtr<ReadPipeImpl>(error, FILESLOT(i));
         if (ppipe)
         {
-            static LLSD trivial;
-            ppipe->tick(trivial);
+            // <FS> Typed mainloop channel
+            //static LLSD trivial;
+            //ppipe->tick(trivial);
+            ppipe->tick(FSMainloopEvent());
+            // </FS>
         }
     }
 
@@ -31,6 +31,7 @@
 #include "llatomic.h"
 
 class LLMutex;
+LL_COMMON_API bool on_main_thread(); // <FS/> see llthread.h
 
 //----------------------------------------------------------------------------
 // RefCount objects should generally only be accessed by way of LLPointer<>'s
@@ -136,6 +137,87 @@ private:
     LLAtomicS32 mRef;
 };
 
+//============================================================================
+
+// <FS> Reference count policies
+// LLPolicyRefCount takes its counter from a policy. Objects that never
+// leave the main thread can count with a plain integer instead of paying
+// for atomics like LLThreadSafeRefCount; builds with assertions check that
+// they really are only referenced from the main thread.
+
+struct LLRefCountMainThreadPolicy
+{
+    typedef S32 counter_t;
+    static bool checkThread() { return on_main_thread(); }
+};
+
+struct LLRefCountThreadSafePolicy
+{
+    typedef LLAtomicS32 counter_t;
+    static bool checkThread() { return true; }
+};
+
+template<class POLICY>
+class LLPolicyRefCount
+{
+protected:
+    virtual ~LLPolicyRefCount()
+    {
+        if (mRef != 0)
+        {
+            LL_ERRS() << "deleting referenced object mRef = " << (S32)mRef << LL_ENDL;
+        }
+    }
+
+public:
+    LLPolicyRefCount()
+    :   mRef(0)
+    {
+    }
+
+    // Copies are new objects with references of their own
+    LLPolicyRefCount(const LLPolicyRefCount&)
+    :   mRef(0)
+    {
+    }
+
+    LLPolicyRefCount& operator=(const LLPolicyRefCount&)
+    {
+        return *this;
+    }
+
+    void ref() const
+    {
+        llassert(POLICY::checkThread());
+        mRef++;
+    }
+
+    S32 unref() const
+    {
+        llassert(POLICY::checkThread());
+        llassert(mRef >= 1);
+        const S32 refs = --mRef;
+        if (0 == refs)
+        {
+            delete this;
+        }
+        return refs;
+    }
+
+    S32 getNumRefs() const
+    {
+        return mRef;
+    }
+
+private:
+    mutable typename POLICY::counter_t mRef;
+};
+
+typedef LLPolicyRefCount<LLRefCountMainThreadPolicy> LLMainThreadRefCount;
+// </FS>
+
+//============================================================================
+
 /**
  * intrusive pointer support for LLThreadSafeRefCount
  * this allows you to use boost::intrusive_ptr with any LLThreadSafeRefCount-derived type
@@ -35,6 +35,7 @@
 #include "llformat.h"
 #include "llsdserialize.h"
 #include "stringize.h"
+#include "fsmemtags.h" // <FS/> Memory tags
 
 #include <limits>
 
@@ -85,6 +86,7 @@ class LLSD::Impl
          as a working implementation of the Undefined type.
 
     */
+    : public FSMemTagBase<FSMT_LLSD> // <FS/> Memory tags
 {
 protected:
     Impl();
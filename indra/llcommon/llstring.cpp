@@ -35,8 +35,20 @@
 #if LL_WINDOWS
 #include "llwin32headerslean.h"
 #include <winnls.h> // for WideCharToMultiByte
+#include <intrin.h> // <FS> Vectorized transcoding
 #endif
 
+// <FS> Vectorized transcoding
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LL_UTF_AVX2 1
+#define LL_UTF_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LL_UTF_SSE2 1
+#endif
+// </FS>
+
 std::string ll_safe_string(const char* in)
 {
     if(in) return std::string(in);
@@ -141,6 +153,316 @@ std::string rawstr_to_utf8(const std::string& raw)
     return wstring_to_utf8str(wstr);
 }
 
+// <FS> Vectorized transcoding
+// Most text the viewer converts is ASCII, or at least has no characters
+// outside the BMP. The conversions below hand runs of such characters to
+// these helpers, which find where a run ends and convert it a vector
+// register at a time; everything else still goes through the per character
+// code, so the results are exactly what they always were.
+namespace
+{
+    inline U32 trailing_zeros(U32 mask)
+    {
+#if LL_WINDOWS
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (U32)index;
+#else
+        return (U32)__builtin_ctz(mask);
+#endif
+    }
+
+    // Leading bytes below 0x80
+    size_t utf8_ascii_run(const char* in, size_t len)
+    {
+        size_t i = 0;
+#if LL_UTF_AVX2
+        for (; i + 32 <= len; i += 32)
+        {
+            U32 mask = (U32)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(in + i)));
+            if (mask)
+            {
+                return i + trailing_zeros(mask);
+            }
+        }
+#endif
+#if LL_UTF_SSE2
+        for (; i + 16 <= len; i += 16)
+        {
+            U32 mask = (U32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(in + i)));
+            if (mask)
+            {
+                return i + trailing_zeros(mask);
+            }
+        }
+#endif
+        while (i < len && !(in[i] & 0x80))
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    void widen_ascii(const char* in, size_t len, llwchar* out)
+    {
+        size_t i = 0;
+#if LL_UTF_AVX2
+        for (; i + 8 <= len; i += 8)
+        {
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(in + i))));
+        }
+#elif LL_UTF_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+            __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+        }
+#endif
+        for (; i < len; ++i)
+        {
+            out[i] = (U8)in[i];
+        }
+    }
+
+    void widen_ascii(const char* in, size_t len, U16* out)
+    {
+        size_t i = 0;
+#if LL_UTF_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(in + i));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(bytes, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+        }
+#endif
+        for (; i < len; ++i)
+        {
+            out[i] = (U8)in[i];
+        }
+    }
+
+    // Leading characters from 0x01 to 0x7F; wstring_to_utf8str() drops NULs
+    size_t utf32_ascii_run(const llwchar* in, size_t len)
+    {
+        size_t i = 0;
+#if LL_UTF_AVX2
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i high_bits = _mm256_set1_epi32(~0x7F);
+            for (; i + 8 <= len; i += 8)
+            {
+                __m256i chars = _mm256_loadu_si256((const __m256i*)(in + i));
+                __m256i not_ascii = _mm256_cmpeq_epi32(_mm256_and_si256(chars, high_bits), zero);
+                __m256i ok = _mm256_andnot_si256(_mm256_cmpeq_epi32(chars, zero), not_ascii);
+                U32 mask = (U32)_mm256_movemask_ps(_mm256_castsi256_ps(ok));
+                if (mask != 0xFF)
+                {
+                    return i + trailing_zeros(~mask);
+                }
+            }
+        }
+#endif
+#if LL_UTF_SSE2
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i high_bits = _mm_set1_epi32(~0x7F);
+            for (; i + 4 <= len; i += 4)
+            {
+                __m128i chars = _mm_loadu_si128((const __m128i*)(in + i));
+                __m128i ascii = _mm_cmpeq_epi32(_mm_and_si128(chars, high_bits), zero);
+                __m128i ok = _mm_andnot_si128(_mm_cmpeq_epi32(chars, zero), ascii);
+                U32 mask = (U32)_mm_movemask_ps(_mm_castsi128_ps(ok));
+                if (mask != 0xF)
+                {
+                    return i + trailing_zeros(~mask);
+                }
+            }
+        }
+#endif
+        while (i < len && (U32)in[i] - 1 < 0x7F)
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    void narrow_ascii(const llwchar* in, size_t len, char* out)
+    {
+        size_t i = 0;
+#if LL_UTF_SSE2
+        for (; i + 16 <= len; i += 16)
+        {
+            __m128i a = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(in + i)), _mm_loadu_si128((const __m128i*)(in + i + 4)));
+            __m128i b = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(in + i + 8)), _mm_loadu_si128((const __m128i*)(in + i + 12)));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+        }
+#endif
+        for (; i < len; ++i)
+        {
+            out[i] = (char)in[i];
+        }
+    }
+
+    // Leading UTF-16 units that are not surrogates
+    size_t utf16_bmp_run(const U16* in, size_t len)
+    {
+        size_t i = 0;
+#if LL_UTF_AVX2
+        {
+            const __m256i surrogate_mask = _mm256_set1_epi16((short)0xF800);
+            const __m256i surrogate = _mm256_set1_epi16((short)0xD800);
+            for (; i + 16 <= len; i += 16)
+            {
+                __m256i units = _mm256_loadu_si256((const __m256i*)(in + i));
+                U32 mask = (U32)_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(units, surrogate_mask), surrogate));
+                if (mask)
+                {
+                    return i + trailing_zeros(mask) / 2;
+                }
+            }
+        }
+#endif
+#if LL_UTF_SSE2
+        {
+            const __m128i surrogate_mask = _mm_set1_epi16((short)0xF800);
+            const __m128i surrogate = _mm_set1_epi16((short)0xD800);
+            for (; i + 8 <= len; i += 8)
+            {
+                __m128i units = _mm_loadu_si128((const __m128i*)(in + i));
+                U32 mask = (U32)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, surrogate_mask), surrogate));
+                if (mask)
+                {
+                    return i + trailing_zeros(mask) / 2;
+                }
+            }
+        }
+#endif
+        while (i < len && (in[i] & 0xF800) != 0xD800)
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    void widen_bmp(const U16* in, size_t len, llwchar* out)
+    {
+        size_t i = 0;
+#if LL_UTF_AVX2
+        for (; i + 8 <= len; i += 8)
+        {
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(in + i))));
+        }
+#elif LL_UTF_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= len; i += 8)
+        {
+            __m128i units = _mm_loadu_si128((const __m128i*)(in + i));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(units, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(units, zero));
+        }
+#endif
+        for (; i < len; ++i)
+        {
+            out[i] = in[i];
+        }
+    }
+
+    // Leading characters up to 0xFFFF
+    size_t utf32_bmp_run(const llwchar* in, size_t len)
+    {
+        size_t i = 0;
+#if LL_UTF_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i high_bits = _mm_set1_epi32((int)0xFFFF0000);
+        for (; i + 4 <= len; i += 4)
+        {
+            __m128i chars = _mm_loadu_si128((const __m128i*)(in + i));
+            U32 mask = (U32)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(chars, high_bits), zero)));
+            if (mask != 0xF)
+            {
+                return i + trailing_zeros(~mask);
+            }
+        }
+#endif
+        while (i < len && (U32)in[i] <= 0xFFFF)
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    void narrow_bmp(const llwchar* in, size_t len, U16* out)
+    {
+        size_t i = 0;
+#if LL_UTF_SSE2
+        // No unsigned 32 to 16 bit pack before SSE4.1: shift into the signed range and back
+        const __m128i bias32 = _mm_set1_epi32(0x8000);
+        const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+        for (; i + 8 <= len; i += 8)
+        {
+            __m128i a = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(in + i)), bias32);
+            __m128i b = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(in + i + 4)), bias32);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi16(_mm_packs_epi32(a, b), bias16));
+        }
+#endif
+        for (; i < len; ++i)
+        {
+            out[i] = (U16)in[i];
+        }
+    }
+
+    // Leading UTF-16 units from 0x01 to 0x7F
+    size_t utf16_ascii_run(const U16* in, size_t len)
+    {
+        size_t i = 0;
+#if LL_UTF_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i high_bits = _mm_set1_epi16((short)0xFF80);
+        for (; i + 8 <= len; i += 8)
+        {
+            __m128i units = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(units, high_bits), zero);
+            __m128i ok = _mm_andnot_si128(_mm_cmpeq_epi16(units, zero), ascii);
+            U32 mask = (U32)_mm_movemask_epi8(ok);
+            if (mask != 0xFFFF)
+            {
+                return i + trailing_zeros(~mask) / 2;
+            }
+        }
+#endif
+        while (i < len && (U32)in[i] - 1 < 0x7F)
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    void narrow_ascii(const U16* in, size_t len, char* out)
+    {
+        size_t i = 0;
+#if LL_UTF_SSE2
+        for (; i + 16 <= len; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(in + i + 8));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+        }
+#endif
+        for (; i < len; ++i)
+        {
+            out[i] = (char)in[i];
+        }
+    }
+}
+// </FS>
+
 std::ptrdiff_t wchar_to_utf8chars(llwchar in_char, char* outchars)
 {
     U32 cur_char = (U32)in_char;
@@ -215,10 +537,24 @@ auto utf16chars_to_wchar(const U16* inchars, llwchar* outchar)
 llutf16string wstring_to_utf16str(const llwchar* utf32str, size_t len)
 {
     llutf16string out;
+    // <FS> Vectorized transcoding
+    out.reserve(len);
+    // </FS>
 
     S32 i = 0;
     while (i < len)
     {
+        // <FS> Vectorized transcoding
+        size_t bmp = utf32_bmp_run(utf32str + i, len - i);
+        if (bmp)
+        {
+            size_t out_pos = out.size();
+            out.resize(out_pos + bmp);
+            narrow_bmp(utf32str + i, bmp, &out[out_pos]);
+            i += (S32)bmp;
+            continue;
+        }
+        // </FS>
         U32 cur_char = utf32str[i];
         if (cur_char > 0xFFFF)
         {
@@ -236,6 +572,15 @@ llutf16string wstring_to_utf16str(const llwchar* utf32str, size_t len)
 
 llutf16string utf8str_to_utf16str( const char* utf8str, size_t len )
 {
+    // <FS> Vectorized transcoding: ASCII strings, like most paths and UI
+    // text, don't need the detour through UTF-32
+    if (utf8_ascii_run(utf8str, len) == len)
+    {
+        llutf16string out(len, 0);
+        widen_ascii(utf8str, len, &out[0]);
+        return out;
+    }
+    // </FS>
     LLWString wstr = utf8str_to_wstring ( utf8str, len );
     return wstring_to_utf16str ( wstr );
 }
@@ -245,10 +590,25 @@ LLWString utf16str_to_wstring(const U16* utf16str, size_t len)
     LLWString wout;
     if (len == 0) return wout;
 
+    // <FS> Vectorized transcoding
+    wout.reserve(len);
+    // </FS>
+
     S32 i = 0;
     const U16* chars16 = utf16str;
     while (i < len)
     {
+        // <FS> Vectorized transcoding
+        size_t bmp = utf16_bmp_run(chars16 + i, len - i);
+        if (bmp)
+        {
+            size_t out_pos = wout.size();
+            wout.resize(out_pos + bmp);
+            widen_bmp(chars16 + i, bmp, &wout[out_pos]);
+            i += (S32)bmp;
+            continue;
+        }
+        // </FS>
         llwchar cur_char;
         i += utf16chars_to_wchar(chars16+i, &cur_char);
         wout += cur_char;
@@ -400,10 +760,24 @@ S32 wstring_utf8_length(const LLWString& wstr)
 LLWString utf8str_to_wstring(const char* utf8str, size_t len)
 {
     LLWString wout;
+    // <FS> Vectorized transcoding
+    wout.reserve(len);
+    // </FS>
 
     S32 i = 0;
     while (i < len)
     {
+        // <FS> Vectorized transcoding
+        size_t ascii = utf8_ascii_run(utf8str + i, len - i);
+        if (ascii)
+        {
+            size_t out_pos = wout.size();
+            wout.resize(out_pos + ascii);
+            widen_ascii(utf8str + i, ascii, &wout[out_pos]);
+            i += (S32)ascii;
+            continue;
+        }
+        // </FS>
         llwchar unichar;
         U8 cur_char = utf8str[i];
 
@@ -488,10 +862,24 @@ LLWString utf8str_to_wstring(const char* utf8str, size_t len)
 std::string wstring_to_utf8str(const llwchar* utf32str, size_t len)
 {
     std::string out;
+    // <FS> Vectorized transcoding
+    out.reserve(len);
+    // </FS>
 
     S32 i = 0;
     while (i < len)
     {
+        // <FS> Vectorized transcoding
+        size_t ascii = utf32_ascii_run(utf32str + i, len - i);
+        if (ascii)
+        {
+            size_t out_pos = out.size();
+            out.resize(out_pos + ascii);
+            narrow_ascii(utf32str + i, ascii, &out[out_pos]);
+            i += (S32)ascii;
+            continue;
+        }
+        // </FS>
         char tchars[8];     /* Flawfinder: ignore */
         auto n = wchar_to_utf8chars(utf32str[i], tchars);
         tchars[n] = 0;
@@ -503,6 +891,14 @@ std::string wstring_to_utf8str(const llwchar* utf32str, size_t len)
 
 std::string utf16str_to_utf8str(const U16* utf16str, size_t len)
 {
+    // <FS> Vectorized transcoding
+    if (utf16_ascii_run(utf16str, len) == len)
+    {
+        std::string out(len, 0);
+        narrow_ascii(utf16str, len, &out[0]);
+        return out;
+    }
+    // </FS>
     return wstring_to_utf8str(utf16str_to_wstring(utf16str, len));
 }
 
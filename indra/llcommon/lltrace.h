@@ -37,6 +37,7 @@
 #include "lltimer.h"
 #include "llpointer.h"
 #include "llunits.h"
+#include "fstracecounttotals.h" // <FS/> Lifetime count totals in per-thread slots
 
 #define LL_TRACE_ENABLED 1
 
@@ -179,25 +180,36 @@ public:
 
     CountStatHandle(const char* name, const char* description = NULL)
     :   stat_t(name, description)
-    , mTotalSamplesCount(0)
-    , mTotalSamples(0.0)
+    // <FS> Lifetime count totals in per-thread slots
+    //, mTotalSamplesCount(0)
+    //, mTotalSamples(0.0)
+    // </FS>
     {}
 
     /*virtual*/ const char* getUnitLabel() const { return LLGetUnitLabel<T>::getUnitLabel(); }
 
     // <FS:ND> Add a stats global count. Which will accumulate all samples over the applicaton lifetime.
+    // <FS> Lifetime count totals in per-thread slots, the handle is shared by all threads
+    //void add( T const &samples )
+    //{
+    //    ++mTotalSamplesCount;
+    //    mTotalSamples += samples;
+    //}
+    //
+    //T getTotalSamples() const { return mTotalSamples; }
+    //U64 getTotalSampleCount() const { return mTotalSamplesCount; }
+    //
+    //private:
+    //U64 mTotalSamplesCount;
+    //T mTotalSamples;
     void add( T const &samples )
     {
-        ++mTotalSamplesCount;
-        mTotalSamples += samples;
+        FSTraceCountTotals::add(getIndex(), storage_value(samples));
     }
 
-    T getTotalSamples() const { return mTotalSamples; }
-    U64 getTotalSampleCount() const { return mTotalSamplesCount; }
-
-private:
-    U64 mTotalSamplesCount;
-    T mTotalSamples;
+    T getTotalSamples() const { return T(FSTraceCountTotals::getSum(getIndex())); }
+    U64 getTotalSampleCount() const { return FSTraceCountTotals::getCount(getIndex()); }
+    // </FS>
     // </FS:ND>
 };
 
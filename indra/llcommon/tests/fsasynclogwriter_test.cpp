@@ -0,0 +1,312 @@
+/**
+ * @file fsasynclogwriter_test.cpp
+ * @brief Asynchronous log writer ordering, loss policy and caller cost
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsasynclogwriter.h"
+
+#include "llfile.h"
+#include "lltimer.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void format_plain(const FSAsyncLogWriter::Record& record, std::string& batch)
+    {
+        batch += record.mMessage;
+        batch += '\n';
+    }
+
+    // Collects what the writer hands out, optionally taking its time about it
+    struct Sink
+    {
+        std::mutex                  mMutex;
+        std::vector<std::string>    mLines;
+        U32                         mBatches = 0;
+        U32                         mDelayMs = 0;
+
+        void write(const std::string& batch)
+        {
+            if (mDelayMs)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(mDelayMs));
+            }
+            std::lock_guard<std::mutex> lock(mMutex);
+            ++mBatches;
+            std::istringstream in(batch);
+            std::string line;
+            while (std::getline(in, line))
+            {
+                mLines.push_back(line);
+            }
+        }
+    };
+
+    std::string make_message(S32 thread, S32 n)
+    {
+        std::ostringstream message;
+        message << thread << " " << n << " texture fetch state changed for a texture nobody cares about";
+        return message.str();
+    }
+
+    // Per message cost seen by the logging threads, in nanoseconds
+    F64 measure_callers(S32 threads, S32 messages, bool async, const std::string& path)
+    {
+        std::ofstream file(path.c_str(), std::ios_base::out | std::ios_base::trunc);
+        std::mutex sync_mutex;
+        std::unique_ptr<FSAsyncLogWriter> writer;
+        if (async)
+        {
+            writer.reset(new FSAsyncLogWriter(
+                [](const FSAsyncLogWriter::Record& record, std::string& batch)
+                {
+                    batch += "2024-01-01T00:00:00Z INFO # TextureFetch : ";
+                    batch += record.mMessage;
+                    batch += '\n';
+                },
+                [&file](const std::string& batch) { file.write(batch.data(), batch.size()); file.flush(); },
+                1 << 18));
+        }
+
+        std::vector<F64> seconds(threads, 0.0);
+        std::vector<std::thread> workers;
+        for (S32 t = 0; t < threads; ++t)
+        {
+            workers.push_back(std::thread([&, t]()
+            {
+                const std::string message = make_message(t, 0);
+                LLTimer timer;
+                for (S32 n = 0; n < messages; ++n)
+                {
+                    if (async)
+                    {
+                        writer->push(NULL, LLError::LEVEL_INFO, 0, message);
+                    }
+                    else
+                    {
+                        // What the file recorder did: format and write under the log lock
+                        std::lock_guard<std::mutex> lock(sync_mutex);
+                        std::ostringstream line;
+                        line << "2024-01-01T00:00:00Z" << " " << "INFO" << " " << "# TextureFetch" << " " << " " << " : " << message;
+                        file << line.str() << std::endl;
+                    }
+                }
+                seconds[t] = timer.getElapsedTimeF64();
+            }));
+        }
+        F64 total = 0.0;
+        for (S32 t = 0; t < threads; ++t)
+        {
+            workers[t].join();
+            total += seconds[t];
+        }
+        writer.reset();
+        LLFile::remove(path);
+        return total * 1000000000.0 / ((F64)threads * messages);
+    }
+}
+
+namespace tut
+{
+    struct asynclogwriter_data
+    {
+        Sink mSink;
+    };
+    typedef test_group<asynclogwriter_data> asynclogwriter_t;
+    typedef asynclogwriter_t::object asynclogwriter_object_t;
+    tut::asynclogwriter_t tut_asynclogwriter("FSAsyncLogWriter");
+
+    template<> template<>
+    void asynclogwriter_object_t::test<1>()
+    {
+        set_test_name("Order and batching");
+        const S32 threads = 4;
+        const S32 messages = 20000;
+        {
+            FSAsyncLogWriter writer(format_plain, [this](const std::string& batch) { mSink.write(batch); }, threads * messages);
+            std::vector<std::thread> workers;
+            for (S32 t = 0; t < threads; ++t)
+            {
+                workers.push_back(std::thread([&writer, t, messages]()
+                {
+                    for (S32 n = 0; n < messages; ++n)
+                    {
+                        writer.push(NULL, LLError::LEVEL_INFO, 0, make_message(t, n));
+                    }
+                }));
+            }
+            for (std::thread& worker : workers)
+            {
+                worker.join();
+            }
+            writer.flush();
+            ensure_equals("all written after flush", writer.getWritten(), (U64)(threads * messages));
+            ensure_equals("none dropped", writer.getDropped(), (U64)0);
+        }
+
+        ensure_equals("every line", mSink.mLines.size(), (size_t)(threads * messages));
+        std::vector<S32> next(threads, 0);
+        for (const std::string& line : mSink.mLines)
+        {
+            std::istringstream in(line);
+            S32 t, n;
+            in >> t >> n;
+            ensure_equals("in order per thread", n, next[t]);
+            ++next[t];
+        }
+        ensure("batched", mSink.mBatches * 10 < (U32)(threads * messages));
+    }
+
+    template<> template<>
+    void asynclogwriter_object_t::test<2>()
+    {
+        set_test_name("Bounded loss under overload");
+        mSink.mDelayMs = 2;
+        const S32 messages = 20000;
+        U64 pushed = 0;
+        U64 dropped_reported = 0;
+        {
+            FSAsyncLogWriter writer(format_plain, [this](const std::string& batch) { mSink.write(batch); }, 64);
+            writer.setDroppedFunction([&dropped_reported](U64 count, std::string& batch)
+            {
+                dropped_reported += count;
+                batch += "dropped\n";
+            });
+            ensure_equals("capacity", writer.getCapacity(), (size_t)64);
+
+            for (S32 n = 0; n < messages; ++n)
+            {
+                if (writer.push(NULL, LLError::LEVEL_INFO, 0, make_message(0, n)))
+                {
+                    ++pushed;
+                }
+            }
+            ensure("info dropped when full", writer.getDropped() > 0);
+            ensure_equals("dropped counted", writer.getDropped() + pushed, (U64)messages);
+
+            // Warnings wait for room
+            for (S32 n = 0; n < 500; ++n)
+            {
+                ensure("warning kept", writer.push(NULL, LLError::LEVEL_WARN, 0, make_message(1, n)));
+            }
+            writer.flush();
+            ensure_equals("all dropped reported", dropped_reported, writer.getDropped());
+        }
+
+        U64 info = 0, warnings = 0, reports = 0;
+        S32 last_info = -1;
+        for (const std::string& line : mSink.mLines)
+        {
+            if (line == "dropped")
+            {
+                ++reports;
+                continue;
+            }
+            std::istringstream in(line);
+            S32 t, n;
+            in >> t >> n;
+            if (t == 0)
+            {
+                ensure("kept info in order", n > last_info);
+                last_info = n;
+                ++info;
+            }
+            else
+            {
+                ++warnings;
+            }
+        }
+        ensure_equals("kept info written", info, pushed);
+        ensure_equals("every warning written", warnings, (U64)500);
+        ensure("loss reported", reports > 0);
+    }
+
+    template<> template<>
+    void asynclogwriter_object_t::test<3>()
+    {
+        set_test_name("Caller cost with 1 to 8 logging threads");
+        const S32 messages = 20000;
+        std::string path = "fsasynclogwriter_bench.log";
+        std::cout << std::endl << "FSAsyncLogWriter caller cost per message (ns), synchronous file writes vs ring:" << std::endl;
+        for (S32 threads = 1; threads <= 8; threads *= 2)
+        {
+            F64 sync_ns = measure_callers(threads, messages, false, path);
+            F64 async_ns = measure_callers(threads, messages, true, path);
+            std::cout << "  " << threads << " thread(s): " << sync_ns << " vs " << async_ns << std::endl;
+            ensure("measured", sync_ns > 0.0 && async_ns > 0.0);
+        }
+    }
+
+    template<> template<>
+    void asynclogwriter_object_t::test<4>()
+    {
+        set_test_name("Flushing from a crash handler");
+        {
+            FSAsyncLogWriter writer(format_plain, [this](const std::string& batch) { mSink.write(batch); }, 256);
+            for (S32 n = 0; n < 200; ++n)
+            {
+                writer.push(NULL, LLError::LEVEL_INFO, 0, make_message(0, n));
+            }
+            ensure("queue emptied", writer.flushForCrash(2000));
+            std::lock_guard<std::mutex> lock(mSink.mMutex);
+            ensure_equals("every line written before the handler returns", mSink.mLines.size(), (size_t)200);
+        }
+
+        // A writer stuck in its sink, as if its thread crashed there, must not
+        // hang the crash handler
+        std::atomic<bool> entered(false);
+        std::atomic<bool> release(false);
+        FSAsyncLogWriter writer(format_plain,
+                                [&](const std::string& batch)
+                                {
+                                    entered = true;
+                                    while (!release)
+                                    {
+                                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                    }
+                                }, 256);
+        writer.push(NULL, LLError::LEVEL_WARN, 0, "first");
+        while (!entered)
+        {
+            std::this_thread::yield();
+        }
+        writer.push(NULL, LLError::LEVEL_WARN, 0, "second");
+        LLTimer timer;
+        ensure("gives up", !writer.flushForCrash(50));
+        ensure("within the timeout", timer.getElapsedTimeF32() < 1.f);
+        release = true;
+    }
+}
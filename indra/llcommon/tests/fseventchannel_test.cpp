@@ -0,0 +1,287 @@
+/**
+ * @file fseventchannel_test.cpp
+ * @brief Typed event channels, and their cost against LLSD event pumps
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../fseventchannel.h"
+
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // What a texture or mesh fetch would announce
+    struct FetchDone
+    {
+        LLUUID  mID;
+        S32     mDiscard;
+        bool    mSuccess;
+    };
+
+    LLSD fetch_to_llsd(const FetchDone& event)
+    {
+        LLSD sd;
+        sd["id"] = event.mID;
+        sd["discard"] = event.mDiscard;
+        sd["success"] = event.mSuccess;
+        return sd;
+    }
+
+    FetchDone fetch_from_llsd(const LLSD& sd)
+    {
+        FetchDone event;
+        event.mID = sd["id"].asUUID();
+        event.mDiscard = sd["discard"].asInteger();
+        event.mSuccess = sd["success"].asBoolean();
+        return event;
+    }
+
+    const LLUUID TEST_ID("5748decc-f629-461c-9a36-a35a221fe21f");
+    const S32 BENCHMARK_LISTENERS = 8;
+    const S32 BENCHMARK_EVENTS = 200000;
+}
+
+namespace tut
+{
+    struct eventchannel_data
+    {
+        ~eventchannel_data()
+        {
+            FSEventChannels::deleteSingleton();
+        }
+    };
+    typedef test_group<eventchannel_data> eventchannel_t;
+    typedef eventchannel_t::object eventchannel_object_t;
+    tut::eventchannel_t tut_eventchannel("FSEventChannel");
+
+    template<> template<>
+    void eventchannel_object_t::test<1>()
+    {
+        set_test_name("Listen, post and stop");
+        FSEventChannel<FetchDone>& channel(FSEventChannels::instance().obtain<FetchDone>("test1"));
+        ensure("same channel by name", &channel == &FSEventChannels::instance().obtain<FetchDone>("test1"));
+
+        std::vector<S32> calls;
+        FSEventConnection first = channel.listen([&calls](const FetchDone& event) { calls.push_back(1); return false; });
+        FSEventConnection second = channel.listen([&calls](const FetchDone& event) { calls.push_back(2); return !event.mSuccess; });
+        FSEventConnection third = channel.listen([&calls](const FetchDone& event) { calls.push_back(3); return false; });
+
+        FetchDone event = { LLUUID::null, 2, true };
+        ensure("not stopped", !channel.post(event));
+        ensure_equals("all called", calls.size(), 3);
+        ensure("in order", calls[0] == 1 && calls[1] == 2 && calls[2] == 3);
+
+        calls.clear();
+        event.mSuccess = false;
+        ensure("stopped", channel.post(event));
+        ensure_equals("stopped after the second", calls.size(), 2);
+
+        calls.clear();
+        second.disconnect();
+        ensure("disconnected", !second.connected());
+        ensure("others still connected", first.connected() && third.connected());
+        channel.post(event);
+        ensure_equals("second gone", calls.size(), 2);
+        ensure("rest in order", calls[0] == 1 && calls[1] == 3);
+        second.disconnect();
+    }
+
+    template<> template<>
+    void eventchannel_object_t::test<2>()
+    {
+        set_test_name("Changing listeners during a post");
+        FSEventChannel<FetchDone>& channel(FSEventChannels::instance().obtain<FetchDone>("test2"));
+
+        S32 late_calls = 0;
+        S32 victim_calls = 0;
+        FSEventConnection victim;
+        FSEventConnection late;
+        FSScopedEventConnection killer = channel.listen([&](const FetchDone&)
+            {
+                // Takes out the next listener and adds one
+                victim.disconnect();
+                if (!late.connected())
+                {
+                    late = channel.listen([&late_calls](const FetchDone&) { ++late_calls; return false; });
+                }
+                return false;
+            });
+        victim = channel.listen([&victim_calls](const FetchDone&) { ++victim_calls; return false; });
+
+        FetchDone event = { LLUUID::null, 0, true };
+        channel.post(event);
+        ensure_equals("disconnected listener skipped", victim_calls, 0);
+        ensure_equals("new listener waits for the next post", late_calls, 0);
+        ensure_equals("hole compacted", channel.getListenerCount(), 2);
+        channel.post(event);
+        ensure_equals("new listener called", late_calls, 1);
+
+        killer.disconnect();
+        ensure_equals("scoped connection disconnected", channel.getListenerCount(), 1);
+        {
+            FSScopedEventConnection scoped = channel.listen([](const FetchDone&) { return false; });
+            ensure_equals("scoped listener added", channel.getListenerCount(), 2);
+        }
+        ensure_equals("scoped listener gone", channel.getListenerCount(), 1);
+    }
+
+    template<> template<>
+    void eventchannel_object_t::test<3>()
+    {
+        set_test_name("Connections outliving their channel");
+        FSEventConnection connection;
+        FSScopedEventConnection scoped;
+        {
+            FSEventChannel<FetchDone> channel("local");
+            connection = channel.listen([](const FetchDone&) { return false; });
+            scoped = channel.listen([](const FetchDone&) { return false; });
+            ensure("connected", connection.connected() && scoped.connected());
+        }
+        ensure("channel gone", !connection.connected() && !scoped.connected());
+        connection.disconnect();
+    }
+
+    template<> template<>
+    void eventchannel_object_t::test<4>()
+    {
+        set_test_name("Wrong event type");
+        FSEventChannels::instance().obtain<FetchDone>("test4");
+        bool threw = false;
+        try
+        {
+            FSEventChannels::instance().obtain<FSMainloopEvent>("test4");
+        }
+        catch (const FSEventChannels::WrongEventType&)
+        {
+            threw = true;
+        }
+        ensure("type mismatch throws", threw);
+    }
+
+    template<> template<>
+    void eventchannel_object_t::test<5>()
+    {
+        set_test_name("Mirrored LLSD pump");
+        LLEventPump& pump(LLEventPumps::instance().obtain("FSEventChannelTest5"));
+        FSEventChannel<FetchDone>& channel(FSEventChannels::instance().obtain<FetchDone>("test5"));
+        channel.mirror(pump, fetch_to_llsd, fetch_from_llsd);
+
+        S32 typed_calls = 0;
+        S32 llsd_calls = 0;
+        S32 last_discard = -1;
+        FSScopedEventConnection typed = channel.listen([&](const FetchDone& event)
+            {
+                ++typed_calls;
+                last_discard = event.mDiscard;
+                return false;
+            });
+        LLTempBoundListener llsd = pump.listen("FSEventChannelTest5Listener", [&](const LLSD& event)
+            {
+                ++llsd_calls;
+                last_discard = event["discard"].asInteger();
+                return false;
+            });
+
+        FetchDone event = { TEST_ID, 3, true };
+        channel.post(event);
+        ensure_equals("typed listener once", typed_calls, 1);
+        ensure_equals("LLSD listener once", llsd_calls, 1);
+        ensure_equals("LLSD listener got the payload", last_discard, 3);
+
+        event.mDiscard = 5;
+        pump.post(fetch_to_llsd(event));
+        ensure_equals("typed listener reached from the pump", typed_calls, 2);
+        ensure_equals("LLSD listener once more", llsd_calls, 2);
+
+        // A typed listener stopping the event keeps it from the LLSD ones
+        FSScopedEventConnection stopper = channel.listen([](const FetchDone&) { return true; });
+        channel.post(event);
+        ensure_equals("LLSD listener not reached", llsd_calls, 2);
+    }
+
+    template<> template<>
+    void eventchannel_object_t::test<6>()
+    {
+        set_test_name("Mainloop channel");
+        FSEventChannel<FSMainloopEvent>& mainloop(fs_mainloop_channel());
+        ensure("resolved once", &mainloop == &fs_mainloop_channel());
+
+        S32 ticks = 0;
+        FSScopedEventConnection connection = mainloop.listen([&ticks](const FSMainloopEvent&) { ++ticks; return false; });
+        mainloop.post(FSMainloopEvent());
+        // Code still posting LLSD on the pump ticks the typed listeners too
+        LLEventPumps::instance().obtain("mainloop").post(LLSD());
+        ensure_equals("ticked from both sides", ticks, 2);
+    }
+
+    template<> template<>
+    void eventchannel_object_t::test<7>()
+    {
+        set_test_name("Events per second against LLSD pumps");
+        S32 llsd_sum = 0;
+        S32 typed_sum = 0;
+        FetchDone event = { TEST_ID, 1, true };
+
+        std::vector<LLTempBoundListener> llsd_listeners;
+        for (S32 i = 0; i < BENCHMARK_LISTENERS; ++i)
+        {
+            llsd_listeners.emplace_back(LLEventPumps::instance().obtain("FSEventChannelBenchmark").listen(
+                "FSEventChannelBenchmark" + std::to_string(i),
+                [&llsd_sum](const LLSD& sd) { llsd_sum += sd["discard"].asInteger(); return false; }));
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < BENCHMARK_EVENTS; ++i)
+        {
+            // What posting code does today: look the pump up, build the LLSD
+            LLEventPumps::instance().obtain("FSEventChannelBenchmark").post(fetch_to_llsd(event));
+        }
+        F64 llsd_seconds = std::chrono::duration<F64>(std::chrono::steady_clock::now() - start).count();
+
+        FSEventChannel<FetchDone>& channel(FSEventChannels::instance().obtain<FetchDone>("benchmark"));
+        std::vector<FSScopedEventConnection> typed_listeners(BENCHMARK_LISTENERS);
+        for (S32 i = 0; i < BENCHMARK_LISTENERS; ++i)
+        {
+            typed_listeners[i] = channel.listen([&typed_sum](const FetchDone& event) { typed_sum += event.mDiscard; return false; });
+        }
+        start = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < BENCHMARK_EVENTS; ++i)
+        {
+            channel.post(event);
+        }
+        F64 typed_seconds = std::chrono::duration<F64>(std::chrono::steady_clock::now() - start).count();
+
+        ensure_equals("every LLSD listener called", llsd_sum, BENCHMARK_EVENTS * BENCHMARK_LISTENERS);
+        ensure_equals("every typed listener called", typed_sum, BENCHMARK_EVENTS * BENCHMARK_LISTENERS);
+
+        std::cout << "\nFSEventChannel: " << BENCHMARK_LISTENERS << " listeners, " << BENCHMARK_EVENTS << " events\n"
+                  << "  LLSD pump:     " << (S64)(BENCHMARK_EVENTS / llsd_seconds) << " events/s\n"
+                  << "  typed channel: " << (S64)(BENCHMARK_EVENTS / typed_seconds) << " events/s" << std::endl;
+    }
+}
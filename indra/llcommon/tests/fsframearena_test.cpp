@@ -0,0 +1,283 @@
+/**
+ * @file fsframearena_test.cpp
+ * @brief Tests and benchmark of the per-thread frame arena
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../fsframearena.h"
+
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct alignas(16) Vec4
+    {
+        F32 mV[4];
+    };
+
+    struct alignas(64) CacheLine
+    {
+        U8 mBytes[64];
+    };
+
+    U64 sHeapAllocations = 0;
+
+    // std::allocator that counts how often it goes to the heap
+    template<typename T>
+    struct CountingAllocator : public std::allocator<T>
+    {
+        typedef T value_type;
+        template<typename U> struct rebind { typedef CountingAllocator<U> other; };
+
+        CountingAllocator() {}
+        template<typename U> CountingAllocator(const CountingAllocator<U>&) {}
+
+        T* allocate(size_t count)
+        {
+            ++sHeapAllocations;
+            return std::allocator<T>::allocate(count);
+        }
+    };
+
+    bool aligned(const void* ptr, size_t alignment)
+    {
+        return ((uintptr_t)ptr & (alignment - 1)) == 0;
+    }
+
+    // The light gathering of the deferred renderer: lights are collected
+    // into lists and vectors, then drained in batches
+    template<typename LIGHT_LIST, typename SPOT_LIST>
+    F32 gather_lights(S32 num_lights)
+    {
+        LIGHT_LIST fullscreen_lights;
+        LIGHT_LIST light_colors;
+        SPOT_LIST spot_lights;
+        SPOT_LIST fullscreen_spot_lights;
+        for (S32 i = 0; i < num_lights; ++i)
+        {
+            Vec4 light = { { (F32)i, 1.f, 2.f, 3.f } };
+            if (i % 4 == 0)
+            {
+                spot_lights.push_back(i);
+            }
+            else if (i % 4 == 1)
+            {
+                fullscreen_spot_lights.push_back(i);
+            }
+            fullscreen_lights.push_back(light);
+            light_colors.push_back(light);
+        }
+
+        F32 sum = 0.f;
+        while (!fullscreen_lights.empty())
+        {
+            sum += fullscreen_lights.front().mV[0] * light_colors.front().mV[1];
+            fullscreen_lights.pop_front();
+            light_colors.pop_front();
+        }
+        for (typename SPOT_LIST::const_iterator it = spot_lights.begin(); it != spot_lights.end(); ++it)
+        {
+            sum += (F32)*it;
+        }
+        return sum + (F32)fullscreen_spot_lights.size();
+    }
+}
+
+namespace tut
+{
+    struct framearena_data
+    {
+        framearena_data()
+        {
+            // Start every test from a clean frame
+            FSFrameArena::instance().reset();
+            FSFrameArena::instance().reset();
+        }
+    };
+    typedef test_group<framearena_data> framearena_t;
+    typedef framearena_t::object framearena_object_t;
+    tut::framearena_t tut_framearena("FSFrameArena");
+
+    template<> template<>
+    void framearena_object_t::test<1>()
+    {
+        set_test_name("Containers and alignment");
+        FSFrameArena& arena = FSFrameArena::instance();
+        {
+            FSFrameVector<S32> ints;
+            FSFrameList<Vec4> vecs;
+            FSFrameVector<CacheLine> lines;
+            for (S32 i = 0; i < 1000; ++i)
+            {
+                ints.push_back(i);
+                Vec4 v = { { (F32)i, 0.f, 0.f, 0.f } };
+                vecs.push_back(v);
+                if (i % 10 == 0)
+                {
+                    lines.push_back(CacheLine());
+                    ensure("cache line aligned", aligned(&lines.back(), 64));
+                }
+                ensure("vec4 aligned", aligned(&vecs.back(), 16));
+            }
+            S32 sum = 0;
+            for (S32 i : ints)
+            {
+                sum += i;
+            }
+            ensure_equals("vector contents", sum, 999 * 1000 / 2);
+            ensure_equals("list size", vecs.size(), (size_t)1000);
+            ensure_equals("list contents", vecs.back().mV[0], 999.f);
+            ensure("allocations alive", arena.getLiveAllocations() > 0);
+        }
+        ensure_equals("all freed", arena.getLiveAllocations(), (size_t)0);
+    }
+
+    template<> template<>
+    void framearena_object_t::test<2>()
+    {
+        set_test_name("Rollback and rewind");
+        FSFrameArena& arena = FSFrameArena::instance();
+        void* first = arena.allocate(100, 8);
+        void* second = arena.allocate(100, 8);
+        arena.deallocate(second, 100);
+        ensure_equals("last allocation is given back", arena.allocate(100, 8), second);
+        arena.deallocate(second, 100);
+
+        void* third = arena.allocate(32, 16);
+        arena.deallocate(first, 100);
+        // first is not on top, the arena can't take it back while third lives
+        void* fourth = arena.allocate(8, 8);
+        ensure("not rewound while allocations live", fourth != first);
+        arena.deallocate(third, 32);
+        ensure_equals("one allocation still alive", arena.getLiveAllocations(), (size_t)1);
+        arena.deallocate(fourth, 8);
+        ensure_equals("rewound once all are freed", arena.allocate(100, 8), first);
+        arena.deallocate(first, 100);
+    }
+
+    template<> template<>
+    void framearena_object_t::test<3>()
+    {
+        set_test_name("Frames settle on a single chunk");
+        FSFrameArena& arena = FSFrameArena::instance();
+        // A frame much bigger than the first chunk
+        for (S32 frame = 0; frame < 3; ++frame)
+        {
+            {
+                FSFrameVector<Vec4> big;
+                FSFrameList<Vec4> nodes;
+                for (S32 i = 0; i < 20000; ++i)
+                {
+                    big.push_back(Vec4());
+                    nodes.push_back(Vec4());
+                }
+            }
+            arena.reset();
+            const FSFrameArena::Stats& stats = arena.getFrameStats();
+            ensure("requests counted", stats.mRequests > 20000);
+            if (frame == 0)
+            {
+                ensure("first frame grows the arena", stats.mSystemAllocations > 1);
+            }
+            else
+            {
+                ensure_equals("later frames allocate nothing", stats.mSystemAllocations, (U64)0);
+            }
+        }
+    }
+
+    template<> template<>
+    void framearena_object_t::test<4>()
+    {
+        set_test_name("Arenas are per thread");
+        FSFrameArena* main_arena = &FSFrameArena::instance();
+        FSFrameArena* thread_arena = NULL;
+        size_t thread_sum = 0;
+        std::thread worker([&]()
+            {
+                thread_arena = &FSFrameArena::instance();
+                FSFrameVector<size_t> values;
+                for (size_t i = 0; i < 100; ++i)
+                {
+                    values.push_back(i);
+                }
+                for (size_t value : values)
+                {
+                    thread_sum += value;
+                }
+            });
+        FSFrameVector<size_t> values(100, 1);
+        worker.join();
+        ensure("different arena", thread_arena != main_arena);
+        ensure_equals("worker contents", thread_sum, (size_t)4950);
+        ensure_equals("main contents", values.size(), (size_t)100);
+    }
+
+    template<> template<>
+    void framearena_object_t::test<5>()
+    {
+        set_test_name("Frame arena benchmark");
+        const S32 frames = 2000;
+        const S32 num_lights = 256;
+        FSFrameArena& arena = FSFrameArena::instance();
+
+        F32 sum = 0.f;
+        sHeapAllocations = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (S32 frame = 0; frame < frames; ++frame)
+        {
+            sum += gather_lights<std::list<Vec4, CountingAllocator<Vec4> >, std::vector<S32, CountingAllocator<S32> > >(num_lights);
+        }
+        double heap_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        U64 heap_allocations = sHeapAllocations;
+
+        U64 arena_requests = 0;
+        U64 arena_allocations = 0;
+        start = std::chrono::steady_clock::now();
+        for (S32 frame = 0; frame < frames; ++frame)
+        {
+            sum -= gather_lights<FSFrameList<Vec4>, FSFrameVector<S32> >(num_lights);
+            arena.reset();
+            arena_requests += arena.getFrameStats().mRequests;
+            arena_allocations += arena.getFrameStats().mSystemAllocations;
+        }
+        double arena_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        ensure_equals("same result", sum, 0.f);
+        ensure_equals("same number of allocations", arena_requests, heap_allocations);
+        ensure("at most the first frame allocates", arena_allocations <= 1);
+
+        std::cout << std::endl << num_lights << " lights, " << frames << " frames:" << std::endl
+                  << "  heap:  " << (F32)heap_allocations / frames << " mallocs/frame, " << heap_ms / frames * 1000.0 << " us/frame" << std::endl
+                  << "  arena: " << (F32)arena_allocations / frames << " mallocs/frame, " << arena_ms / frames * 1000.0 << " us/frame" << std::endl;
+    }
+}
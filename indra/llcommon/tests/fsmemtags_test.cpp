@@ -0,0 +1,255 @@
+/**
+ * @file fsmemtags_test.cpp
+ * @brief Memory tag accounting and its overhead
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../fsmemtags.h"
+
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct SmallNode
+    {
+        SmallNode(S32 value) : mValue(value) {}
+        virtual ~SmallNode() {}
+        S32 mValue;
+        SmallNode* mNext = nullptr;
+    };
+
+    struct TaggedNode : public SmallNode, public FSMemTagged<FSMT_LLSD>
+    {
+        TaggedNode(S32 value) : SmallNode(value) {}
+    };
+
+    struct alignas(64) AlignedView : public FSMemTagged<FSMT_UI>
+    {
+        F32 mMatrix[16];
+    };
+
+    struct BaseNode : public SmallNode, public FSMemTagBase<FSMT_LLSD>
+    {
+        BaseNode(S32 value) : SmallNode(value) {}
+    };
+
+    struct ThrowingItem : public FSMemTagged<FSMT_INVENTORY>
+    {
+        ThrowingItem() { throw std::runtime_error("no item"); }
+        char mName[40];
+    };
+
+    S64 live(EFSMemTag tag)
+    {
+        return FSMemTags::getTotals(tag).mLiveBytes;
+    }
+
+    // Allocates and frees in batches like a parser building and dropping
+    // a tree, returns nanoseconds per new/delete pair
+    template<typename NODE>
+    double time_nodes(S32 batches, S32 batch_size)
+    {
+        std::vector<SmallNode*> nodes(batch_size);
+        auto start = std::chrono::steady_clock::now();
+        S64 sum = 0;
+        for (S32 batch = 0; batch < batches; ++batch)
+        {
+            for (S32 i = 0; i < batch_size; ++i)
+            {
+                nodes[i] = new NODE(i);
+            }
+            for (S32 i = 0; i < batch_size; ++i)
+            {
+                sum += nodes[i]->mValue;
+                delete nodes[i];
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return sum ? seconds * 1.0e9 / ((double)batches * batch_size) : 0.0;
+    }
+}
+
+namespace tut
+{
+    struct memtags_data
+    {
+    };
+    typedef test_group<memtags_data> memtags_t;
+    typedef memtags_t::object memtags_object_t;
+    tut::memtags_t tut_memtags("FSMemTags");
+
+    template<> template<>
+    void memtags_object_t::test<1>()
+    {
+        set_test_name("Claims and tracked buffers");
+        S64 before = live(FSMT_TEXTURES);
+        U64 allocations = FSMemTags::getTotals(FSMT_TEXTURES).mAllocations;
+        FSMemTags::claim(FSMT_TEXTURES, 4096);
+        ensure_equals("claimed", live(FSMT_TEXTURES), before + 4096);
+        ensure_equals("counted", FSMemTags::getTotals(FSMT_TEXTURES).mAllocations, allocations + 1);
+        FSMemTags::disclaim(FSMT_TEXTURES, 4096);
+        ensure_equals("disclaimed", live(FSMT_TEXTURES), before);
+
+        size_t tracked = 0;
+        FSMemTags::track(FSMT_MESHES, tracked, 1000);
+        FSMemTags::track(FSMT_MESHES, tracked, 3000);
+        FSMemTags::track(FSMT_MESHES, tracked, 200);
+        ensure_equals("tracked size", tracked, 200);
+        ensure_equals("tracked live", live(FSMT_MESHES), 200);
+        FSMemTags::track(FSMT_MESHES, tracked, 0);
+        ensure_equals("released", live(FSMT_MESHES), 0);
+    }
+
+    template<> template<>
+    void memtags_object_t::test<2>()
+    {
+        set_test_name("Tagged classes and scopes");
+        S64 llsd = live(FSMT_LLSD);
+        S64 inventory = live(FSMT_INVENTORY);
+        S64 ui = live(FSMT_UI);
+
+        std::unique_ptr<TaggedNode> outside(new TaggedNode(1));
+        ensure_equals("class tag outside scopes", live(FSMT_LLSD), llsd + (S64)sizeof(TaggedNode));
+
+        std::unique_ptr<TaggedNode> in_inventory, in_ui, back_in_inventory;
+        {
+            FSMemTagScope inventory_scope(FSMT_INVENTORY);
+            in_inventory.reset(new TaggedNode(2));
+            {
+                FSMemTagScope ui_scope(FSMT_UI);
+                in_ui.reset(new TaggedNode(3));
+            }
+            back_in_inventory.reset(new TaggedNode(4));
+        }
+        ensure_equals("inner scope", live(FSMT_UI), ui + (S64)sizeof(TaggedNode));
+        ensure_equals("outer scope restored", live(FSMT_INVENTORY), inventory + 2 * (S64)sizeof(TaggedNode));
+        ensure_equals("no scope after", FSMemTags::getCurrent(FSMT_LLSD), FSMT_LLSD);
+
+        // freed outside the scope, still debited to the tag it was charged to
+        in_inventory.reset();
+        back_in_inventory.reset();
+        in_ui.reset();
+        outside.reset();
+        ensure_equals("llsd back", live(FSMT_LLSD), llsd);
+        ensure_equals("inventory back", live(FSMT_INVENTORY), inventory);
+        ensure_equals("ui back", live(FSMT_UI), ui);
+    }
+
+    template<> template<>
+    void memtags_object_t::test<3>()
+    {
+        set_test_name("Over-aligned classes and constructor exceptions");
+        S64 ui = live(FSMT_UI);
+        std::vector<std::unique_ptr<AlignedView>> views;
+        for (S32 i = 0; i < 16; ++i)
+        {
+            views.emplace_back(new AlignedView);
+            ensure("aligned", ((uintptr_t)views.back().get() & 63) == 0);
+        }
+        ensure_equals("aligned views counted", live(FSMT_UI), ui + 16 * (S64)sizeof(AlignedView));
+        views.clear();
+        ensure_equals("aligned views released", live(FSMT_UI), ui);
+
+        S64 inventory = live(FSMT_INVENTORY);
+        try
+        {
+            new ThrowingItem;
+            fail("no exception");
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+        ensure_equals("freed after throwing constructor", live(FSMT_INVENTORY), inventory);
+    }
+
+    template<> template<>
+    void memtags_object_t::test<4>()
+    {
+        set_test_name("Freed on another thread");
+        S64 inventory = live(FSMT_INVENTORY);
+        std::vector<TaggedNode*> nodes;
+        std::thread producer([&nodes]()
+            {
+                FSMemTagScope scope(FSMT_INVENTORY);
+                for (S32 i = 0; i < 1000; ++i)
+                {
+                    nodes.push_back(new TaggedNode(i));
+                }
+            });
+        producer.join();
+        ensure_equals("charged on the producer", live(FSMT_INVENTORY), inventory + 1000 * (S64)sizeof(TaggedNode));
+        ensure_equals("scope is per thread", FSMemTags::getCurrent(FSMT_LLSD), FSMT_LLSD);
+        for (TaggedNode* node : nodes)
+        {
+            delete node;
+        }
+        ensure_equals("debited on this thread", live(FSMT_INVENTORY), inventory);
+    }
+
+    template<> template<>
+    void memtags_object_t::test<5>()
+    {
+        set_test_name("Overhead of tagged new and delete");
+        const S32 batches = 2000;
+        const S32 batch_size = 1000;
+        // warm up the heap
+        time_nodes<SmallNode>(100, batch_size);
+        time_nodes<TaggedNode>(100, batch_size);
+
+        double plain = time_nodes<SmallNode>(batches, batch_size);
+        double tagged = time_nodes<TaggedNode>(batches, batch_size);
+        double scoped = 0.0;
+        {
+            FSMemTagScope scope(FSMT_UI);
+            scoped = time_nodes<TaggedNode>(batches, batch_size);
+        }
+        std::cout << "\nnew/delete of a " << sizeof(SmallNode) << " byte object: plain " << plain
+                  << " ns, tagged " << tagged << " ns, tagged in a scope " << scoped << " ns" << std::endl;
+        ensure_equals("all released", live(FSMT_LLSD), 0);
+    }
+
+    template<> template<>
+    void memtags_object_t::test<6>()
+    {
+        set_test_name("Classes on hot paths");
+        S64 llsd = live(FSMT_LLSD);
+        BaseNode* node = new BaseNode(1);
+#ifdef FS_MEMTAGS
+        ensure_equals("accounted", live(FSMT_LLSD), llsd + (S64)sizeof(BaseNode));
+#else
+        ensure_equals("not accounted", live(FSMT_LLSD), llsd);
+        ensure_equals("no overhead", sizeof(BaseNode), sizeof(SmallNode));
+#endif
+        delete node;
+        ensure_equals("released", live(FSMT_LLSD), llsd);
+    }
+}
@@ -0,0 +1,226 @@
+/**
+ * @file fstracecounttotals_test.cpp
+ * @brief Per-thread count totals, and add() cost across threads
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lltrace.h"
+
+#include "../test/lltut.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const S32 NUM_STATS = 8;
+    const S32 ADDS_PER_THREAD = 2000000;
+
+    LLTrace::CountStatHandle<> sTestCount("fstracecounttotals_test", "Test count");
+
+    // Trace objects have to be made during static initialization
+    LLTrace::CountStatHandle<> sBenchmarkStats[NUM_STATS] =
+    {
+        "fstracecounttotals_bench0", "fstracecounttotals_bench1", "fstracecounttotals_bench2", "fstracecounttotals_bench3",
+        "fstracecounttotals_bench4", "fstracecounttotals_bench5", "fstracecounttotals_bench6", "fstracecounttotals_bench7"
+    };
+
+    // The lifetime totals as they were kept before: on the handle, which all
+    // threads share, next to the totals of the other handles
+    struct SharedTotals
+    {
+        std::atomic<U64>    mCount;
+        std::atomic<F64>    mSum;
+    };
+    SharedTotals sSharedTotals[NUM_STATS];
+
+    void add_shared(LLTrace::CountStatHandle<>& stat, SharedTotals& totals, F64 value)
+    {
+        stat.getCurrentAccumulator().add(value);
+        // Plain increments, like the members they stand in for
+        totals.mCount.store(totals.mCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        totals.mSum.store(totals.mSum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // Nanoseconds per add() with num_threads threads adding at once, each
+    // into an accumulator buffer of its own, as under a ThreadRecorder
+    F64 time_adds(S32 num_threads, bool shared)
+    {
+        std::atomic<S32> ready(0);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (S32 t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    LLTrace::AccumulatorBuffer<LLTrace::CountAccumulator> buffer;
+                    buffer.makeCurrent();
+                    ++ready;
+                    while (!go)
+                    {
+                        std::this_thread::yield();
+                    }
+                    for (S32 i = 0; i < ADDS_PER_THREAD; ++i)
+                    {
+                        S32 stat = (i + t) % NUM_STATS;
+                        if (shared)
+                        {
+                            add_shared(sBenchmarkStats[stat], sSharedTotals[stat], 1.0);
+                        }
+                        else
+                        {
+                            LLTrace::add(sBenchmarkStats[stat], 1.0);
+                        }
+                    }
+                    LLTrace::AccumulatorBuffer<LLTrace::CountAccumulator>::clearCurrent();
+                });
+        }
+        while (ready < num_threads)
+        {
+            std::this_thread::yield();
+        }
+        auto start = std::chrono::steady_clock::now();
+        go = true;
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        F64 seconds = std::chrono::duration<F64>(std::chrono::steady_clock::now() - start).count();
+        // Every thread runs its adds at the same time, so the wall time of one
+        // thread's share is the cost of one add
+        return seconds * 1e9 / ADDS_PER_THREAD;
+    }
+}
+
+namespace tut
+{
+    struct tracecounttotals_data
+    {
+    };
+    typedef test_group<tracecounttotals_data> tracecounttotals_t;
+    typedef tracecounttotals_t::object tracecounttotals_object_t;
+    tut::tracecounttotals_t tut_tracecounttotals("FSTraceCountTotals");
+
+    template<> template<>
+    void tracecounttotals_object_t::test<1>()
+    {
+        set_test_name("Totals over live and exited threads");
+        F64 sum = sTestCount.getTotalSamples();
+        U64 count = sTestCount.getTotalSampleCount();
+
+        LLTrace::AccumulatorBuffer<LLTrace::CountAccumulator> buffer;
+        buffer.makeCurrent();
+        LLTrace::add(sTestCount, 2.0);
+        ensure_equals("main thread count", sTestCount.getTotalSampleCount(), count + 1);
+        ensure_equals("main thread sum", sTestCount.getTotalSamples(), sum + 2.0);
+
+        std::atomic<bool> added(false);
+        std::atomic<bool> release(false);
+        std::thread live([&]()
+            {
+                LLTrace::add(sTestCount, 3.0);
+                added = true;
+                while (!release)
+                {
+                    std::this_thread::yield();
+                }
+            });
+        std::vector<std::thread> exiting;
+        for (S32 i = 0; i < 4; ++i)
+        {
+            exiting.emplace_back([]()
+                {
+                    for (S32 j = 0; j < 1000; ++j)
+                    {
+                        LLTrace::add(sTestCount, 0.5);
+                    }
+                });
+        }
+        for (std::thread& thread : exiting)
+        {
+            thread.join();
+        }
+        while (!added)
+        {
+            std::this_thread::yield();
+        }
+
+        ensure_equals("count with a live thread", sTestCount.getTotalSampleCount(), count + 1 + 1 + 4000);
+        ensure_equals("sum with a live thread", sTestCount.getTotalSamples(), sum + 2.0 + 3.0 + 2000.0);
+        release = true;
+        live.join();
+        ensure_equals("count after it exited", sTestCount.getTotalSampleCount(), count + 1 + 1 + 4000);
+        ensure_equals("sum after it exited", sTestCount.getTotalSamples(), sum + 2.0 + 3.0 + 2000.0);
+        LLTrace::AccumulatorBuffer<LLTrace::CountAccumulator>::clearCurrent();
+    }
+
+    template<> template<>
+    void tracecounttotals_object_t::test<2>()
+    {
+        set_test_name("Stats past the first slots of a thread");
+        // A stat registered after the thread made its slots grows them
+        std::thread thread([]()
+            {
+                FSTraceCountTotals::add(0, 1.0);
+                FSTraceCountTotals::add(1000, 4.0);
+                FSTraceCountTotals::add(1000, 4.0);
+                FSTraceCountTotals::add(0, 1.0);
+            });
+        thread.join();
+        ensure_equals("first slot kept", FSTraceCountTotals::getCount(0) >= 2, true);
+        ensure_equals("grown slot count", FSTraceCountTotals::getCount(1000), (U64)2);
+        ensure_equals("grown slot sum", FSTraceCountTotals::getSum(1000), 8.0);
+        ensure_equals("never used", FSTraceCountTotals::getCount(5000), (U64)0);
+    }
+
+    template<> template<>
+    void tracecounttotals_object_t::test<3>()
+    {
+        set_test_name("add() cost across threads");
+        std::cout << "\nFSTraceCountTotals: ns per add(), " << NUM_STATS << " stats, "
+                  << ADDS_PER_THREAD << " adds per thread, " << std::thread::hardware_concurrency() << " cores\n"
+                  << "  threads   shared totals   per-thread slots\n";
+        for (S32 threads = 1; threads <= 16; threads *= 2)
+        {
+            F64 shared_ns = time_adds(threads, true);
+            F64 slots_ns = time_adds(threads, false);
+            std::cout << "  " << std::setw(7) << threads << "   " << std::setw(13) << std::fixed << std::setprecision(2) << shared_ns
+                      << "   " << std::setw(16) << slots_ns << "\n";
+        }
+        std::cout << std::flush;
+
+        U64 total = 0;
+        for (const LLTrace::CountStatHandle<>& stat : sBenchmarkStats)
+        {
+            total += stat.getTotalSampleCount();
+        }
+        ensure_equals("no add lost", total, (U64)ADDS_PER_THREAD * (1 + 2 + 4 + 8 + 16));
+    }
+}
@@ -37,6 +37,13 @@
 #include <algorithm>                // std::sort()
 #include <stdexcept>
 // std headers
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
 // external library headers
 #include <boost/scoped_ptr.hpp>
 // other Linden headers
@@ -56,6 +63,14 @@ struct Keyed: public LLInstanceTracker<Keyed, std::string>
     std::string mName;
 };
 
+struct Renamable: public LLInstanceTracker<Renamable, std::string>
+{
+    Renamable(const std::string& name):
+        LLInstanceTracker<Renamable, std::string>(name)
+    {}
+    void rename(const std::string& name) { setKey(name); }
+};
+
 struct Unkeyed: public LLInstanceTracker<Unkeyed>
 {
     Unkeyed(const std::string& thrw="")
@@ -71,6 +86,49 @@ struct Unkeyed: public LLInstanceTracker<Unkeyed>
     }
 };
 
+// What every tracked class paid before instances were sharded: one mutex
+// around one map. Only used to compare the contention benchmark against.
+struct SingleLockRegistry
+{
+    std::mutex mMutex;
+    std::map<std::string, std::shared_ptr<std::string>> mMap;
+
+    void add(const std::string& key, const std::shared_ptr<std::string>& instance)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMap.emplace(key, instance);
+    }
+    std::shared_ptr<std::string> find(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mMap.find(key);
+        return (found == mMap.end()) ? nullptr : found->second;
+    }
+    void remove(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMap.erase(key);
+    }
+};
+
+// Runs body(thread index) on several threads at once, returns the seconds
+// the slowest one took
+template <typename FUNC>
+double run_threads(size_t count, FUNC body)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; ++i)
+    {
+        threads.emplace_back(body, i);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
 /*****************************************************************************
 *   TUT
 *****************************************************************************/
@@ -271,4 +329,102 @@ namespace tut
             ensure("failed to remove instance", existing.find(&ref) != existing.end());
         }
     }
+
+    template<> template<>
+    void object::test<9>()
+    {
+        set_test_name("snapshot key order and setKey across shards");
+        std::vector<std::unique_ptr<Keyed>> keyed;
+        for (int i = 0; i < 200; ++i)
+        {
+            keyed.emplace_back(new Keyed(stringize("key", 1000 - i)));
+        }
+        auto snap = Keyed::key_snapshot();
+        std::vector<std::string> keys(snap.begin(), snap.end());
+        ensure_equals("every key reported", keys.size(), 200);
+        ensure("keys in order", std::is_sorted(keys.begin(), keys.end()));
+
+        Renamable renamable("before");
+        for (int i = 0; i < 100; ++i)
+        {
+            std::string name(stringize("after", i));
+            renamable.rename(name);
+            ensure_equals("renamed instance found", Renamable::getInstance(name).get(), &renamable);
+            ensure("old key gone", ! Renamable::getInstance(stringize("after", i - 1)));
+            ensure_equals("still one instance", Renamable::instanceCount(), 1);
+        }
+    }
+
+    template<> template<>
+    void object::test<10>()
+    {
+        set_test_name("create and destroy instances across threads");
+        const size_t threads = 8;
+        const int rounds = 50000;
+        std::atomic<bool> lost(false);
+
+        // each thread creates, finds and destroys its own instances while
+        // another one keeps taking snapshots. It only counts the entries:
+        // the instances live on the other threads' stacks, and a snapshot
+        // entry does not keep them from being destroyed.
+        std::atomic<bool> done(false);
+        std::thread snapshotter([&done]()
+            {
+                while (! done)
+                {
+                    Keyed::snapshot keyed;
+                    Unkeyed::snapshot unkeyed;
+                    (void)std::distance(keyed.begin(), keyed.end());
+                    (void)std::distance(unkeyed.begin(), unkeyed.end());
+                }
+            });
+        run_threads(threads, [&lost](size_t index)
+            {
+                std::string prefix(stringize("thread", index, "-"));
+                for (int i = 0; i < 5000; ++i)
+                {
+                    std::string key(prefix + std::to_string(i % 64));
+                    Keyed keyed(key);
+                    Unkeyed unkeyed;
+                    if (Keyed::getInstance(key).get() != &keyed)
+                    {
+                        lost = true;
+                    }
+                }
+            });
+        done = true;
+        snapshotter.join();
+        ensure("every instance found", ! lost);
+        ensure_equals("no Keyed left", Keyed::instanceCount(), 0);
+        ensure_equals("no Unkeyed left", Unkeyed::instanceCount(), 0);
+
+        // same work against the sharded tracker and a single locked map
+        double tracked = run_threads(threads, [rounds](size_t index)
+            {
+                std::string prefix(stringize("thread", index, "-"));
+                for (int i = 0; i < rounds; ++i)
+                {
+                    std::string key(prefix + std::to_string(i % 64));
+                    Keyed keyed(key);
+                    Keyed::getInstance(key);
+                }
+            });
+        SingleLockRegistry registry;
+        double single = run_threads(threads, [&registry, rounds](size_t index)
+            {
+                std::string prefix(stringize("thread", index, "-"));
+                for (int i = 0; i < rounds; ++i)
+                {
+                    std::string key(prefix + std::to_string(i % 64));
+                    std::string instance(key);
+                    registry.add(key, std::shared_ptr<std::string>(&instance, [](std::string*){}));
+                    registry.find(key);
+                    registry.remove(key);
+                }
+            });
+
+        std::cout << "\n" << threads << " threads, " << rounds << " instances each: sharded tracker "
+                  << tracked * 1000.0 << " ms, single locked map "
+                  << single * 1000.0 << " ms" << std::endl;
+    }
 } // namespace tut
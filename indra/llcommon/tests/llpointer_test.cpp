@@ -0,0 +1,163 @@
+/**
+ * @file llpointer_test.cpp
+ * @brief Tests for borrowed pointers and policy based reference counts
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpointer.h"
+#include "../llrefcount.h"
+#include "../llthread.h"
+
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // Stands in for a drawable, updated through a virtual call the way
+    // state sort updates faces and drawables
+    template<class REFCOUNT>
+    class Drawable : public REFCOUNT
+    {
+    public:
+        static S32 sLive;
+
+        Drawable(S32 value) : mValue(value) { ++sLive; }
+        virtual S32 update() { return mValue; }
+
+    protected:
+        virtual ~Drawable() { --sLive; }
+
+    private:
+        S32 mValue;
+    };
+    template<class REFCOUNT> S32 Drawable<REFCOUNT>::sLive = 0;
+
+    typedef Drawable<LLRefCount> RefCounted;
+    typedef Drawable<LLThreadSafeRefCount> ThreadSafe;
+    typedef Drawable<LLMainThreadRefCount> MainThread;
+
+    // Walks the list passes times, returns nanoseconds per element
+    template<typename POINTER, typename OBJECT>
+    double traverse(const std::vector<LLPointer<OBJECT> >& objects, S32 passes, S64& sum)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (S32 pass = 0; pass < passes; ++pass)
+        {
+            for (typename std::vector<LLPointer<OBJECT> >::const_iterator it = objects.begin(); it != objects.end(); ++it)
+            {
+                POINTER objectp = *it;
+                sum += objectp->update();
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / ((double)passes * objects.size());
+    }
+
+    template<typename OBJECT>
+    void benchmark(const char* name, S32 count, S32 passes)
+    {
+        std::vector<LLPointer<OBJECT> > objects;
+        for (S32 i = 0; i < count; ++i)
+        {
+            objects.push_back(new OBJECT(i));
+        }
+        S64 owned_sum = 0;
+        S64 borrowed_sum = 0;
+        double owned = traverse<LLPointer<OBJECT> >(objects, passes, owned_sum);
+        double borrowed = traverse<LLBorrowedPointer<OBJECT> >(objects, passes, borrowed_sum);
+        tut::ensure_equals("same traversal", owned_sum, borrowed_sum);
+        std::cout << "  " << name << ": " << owned << " ns with LLPointer copies, "
+                  << borrowed << " ns borrowed" << std::endl;
+    }
+}
+
+namespace tut
+{
+    struct pointer_data
+    {
+    };
+    typedef test_group<pointer_data> pointer_t;
+    typedef pointer_t::object pointer_object_t;
+    tut::pointer_t tut_pointer("LLPointer");
+
+    template<> template<>
+    void pointer_object_t::test<1>()
+    {
+        set_test_name("Borrowed pointers leave counts alone");
+        LLPointer<RefCounted> owner = new RefCounted(7);
+        {
+            LLBorrowedPointer<RefCounted> borrowed = owner;
+            LLBorrowedPointer<RefCounted> copy = borrowed;
+            ensure_equals("no references taken", owner->getNumRefs(), 1);
+            ensure("points to the owned object", copy == owner.get());
+            ensure_equals("dereference", copy->update(), 7);
+
+            // Keeping the object past its owner takes a real reference
+            LLPointer<RefCounted> kept = copy.get();
+            ensure_equals("kept", owner->getNumRefs(), 2);
+        }
+        ensure_equals("back to the owner only", owner->getNumRefs(), 1);
+
+        LLBorrowedPointer<RefCounted> empty;
+        ensure("empty", empty.isNull());
+        ensure("empty converts to false", !empty);
+    }
+
+    template<> template<>
+    void pointer_object_t::test<2>()
+    {
+        set_test_name("Main thread reference counts");
+        // Establishes the main thread for the process
+        ensure("on main thread", on_main_thread());
+
+        S32 live = MainThread::sLive;
+        {
+            LLPointer<MainThread> first = new MainThread(1);
+            LLPointer<MainThread> second = first;
+            ensure_equals("two references", first->getNumRefs(), 2);
+            second = NULL;
+            ensure_equals("one reference", first->getNumRefs(), 1);
+            ensure_equals("alive", MainThread::sLive, live + 1);
+        }
+        ensure_equals("deleted with the last reference", MainThread::sLive, live);
+    }
+
+    template<> template<>
+    void pointer_object_t::test<3>()
+    {
+        set_test_name("Traversal reference count benchmark");
+        const S32 count = 50000;
+        const S32 passes = 100;
+        std::cout << std::endl << "Traversal of " << count << " objects, per object:" << std::endl;
+        benchmark<RefCounted>("LLRefCount", count, passes);
+        benchmark<ThreadSafe>("LLThreadSafeRefCount", count, passes);
+        benchmark<MainThread>("LLMainThreadRefCount", count, passes);
+        ensure_equals("all deleted", RefCounted::sLive + ThreadSafe::sLive + MainThread::sLive, 0);
+    }
+}
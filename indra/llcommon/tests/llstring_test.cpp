@@ -29,12 +29,181 @@
 #include "linden_common.h"
 
 #include <boost/assign/list_of.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
 #include "../llstring.h"
 #include "StringVec.h"                  // must come BEFORE lltut.h
 #include "../test/lltut.h"
 
 using boost::assign::list_of;
 
+namespace
+{
+    // The conversions as they were before they got their vectorized fast
+    // paths, so the fuzz tests below can check nothing changed, malformed
+    // input included.
+    LLWString reference_utf8str_to_wstring(const std::string& utf8str)
+    {
+        const char* chars = utf8str.c_str();
+        size_t len = utf8str.length();
+        LLWString wout;
+        S32 i = 0;
+        while (i < len)
+        {
+            llwchar unichar;
+            U8 cur_char = chars[i];
+            if (cur_char < 0x80)
+            {
+                unichar = cur_char;
+            }
+            else
+            {
+                S32 cont_bytes = 0;
+                if ((cur_char >> 5) == 0x6)
+                {
+                    unichar = (0x1F&cur_char);
+                    cont_bytes = 1;
+                }
+                else if ((cur_char >> 4) == 0xe)
+                {
+                    unichar = (0x0F&cur_char);
+                    cont_bytes = 2;
+                }
+                else if ((cur_char >> 3) == 0x1e)
+                {
+                    unichar = (0x07&cur_char);
+                    cont_bytes = 3;
+                }
+                else if ((cur_char >> 2) == 0x3e)
+                {
+                    unichar = (0x03&cur_char);
+                    cont_bytes = 4;
+                }
+                else if ((cur_char >> 1) == 0x7e)
+                {
+                    unichar = (0x01&cur_char);
+                    cont_bytes = 5;
+                }
+                else
+                {
+                    wout += LL_UNKNOWN_CHAR;
+                    ++i;
+                    continue;
+                }
+
+                auto end = (len < (i + cont_bytes)) ? len : (i + cont_bytes);
+                do
+                {
+                    ++i;
+                    cur_char = chars[i];
+                    if ((cur_char >> 6) == 0x2)
+                    {
+                        unichar <<= 6;
+                        unichar += (0x3F&cur_char);
+                    }
+                    else
+                    {
+                        unichar = LL_UNKNOWN_CHAR;
+                        --i;
+                        break;
+                    }
+                } while (i < end);
+
+                if (((cont_bytes == 1) && (unichar < 0x80))
+                    || ((cont_bytes == 2) && (unichar < 0x800))
+                    || ((cont_bytes == 3) && (unichar < 0x10000))
+                    || ((cont_bytes == 4) && (unichar < 0x200000))
+                    || ((cont_bytes == 5) && (unichar < 0x4000000)))
+                {
+                    unichar = LL_UNKNOWN_CHAR;
+                }
+            }
+            wout += unichar;
+            ++i;
+        }
+        return wout;
+    }
+
+    std::string reference_wstring_to_utf8str(const LLWString& utf32str)
+    {
+        std::string out;
+        for (size_t i = 0; i < utf32str.length(); ++i)
+        {
+            char tchars[8];
+            auto n = wchar_to_utf8chars(utf32str[i], tchars);
+            tchars[n] = 0;
+            out += tchars;
+        }
+        return out;
+    }
+
+    LLWString reference_utf16str_to_wstring(const llutf16string& utf16str)
+    {
+        LLWString wout;
+        const U16* chars16 = utf16str.c_str();
+        size_t len = utf16str.length();
+        S32 i = 0;
+        while (i < len)
+        {
+            U16 cur_char = chars16[i++];
+            llwchar char32 = cur_char;
+            if ((cur_char >= 0xD800) && (cur_char <= 0xDFFF))
+            {
+                char32 = ((llwchar)(cur_char - 0xD800)) << 10;
+                cur_char = chars16[i++];
+                char32 += (llwchar)(cur_char - 0xDC00) + 0x0010000UL;
+            }
+            wout += char32;
+        }
+        return wout;
+    }
+
+    llutf16string reference_wstring_to_utf16str(const LLWString& utf32str)
+    {
+        llutf16string out;
+        for (size_t i = 0; i < utf32str.length(); ++i)
+        {
+            U32 cur_char = utf32str[i];
+            if (cur_char > 0xFFFF)
+            {
+                out += (0xD7C0 + (cur_char >> 10));
+                out += (0xDC00 | (cur_char & 0x3FF));
+            }
+            else
+            {
+                out += cur_char;
+            }
+        }
+        return out;
+    }
+
+    // Mostly ASCII with some accented Latin, Cyrillic, CJK and emoji, the way
+    // chat and names look
+    LLWString random_text(std::mt19937& rng, size_t len)
+    {
+        static const llwchar others[] = { 0xE9, 0xFC, 0x416, 0x44F, 0x3042, 0x4E2D, 0xFFFD, 0x1F600, 0x1F44D, 0x10FFFF };
+        LLWString text;
+        for (size_t i = 0; i < len; ++i)
+        {
+            U32 roll = rng() % 100;
+            if (roll < 85)
+            {
+                text += (llwchar)(0x20 + rng() % 0x5F);
+            }
+            else if (roll < 87)
+            {
+                text += (llwchar)(rng() % 0x20);
+            }
+            else
+            {
+                text += others[rng() % LL_ARRAY_SIZE(others)];
+            }
+        }
+        return text;
+    }
+}
+
 namespace tut
 {
     struct string_index
@@ -868,4 +1037,95 @@ namespace tut
                       LLStringUtil::getTokens("it's^ up there^", " ", "", "'", "^"),
                       list_of("it's up")("there^"));
     }
+
+    template<> template<>
+    void string_index_object_t::test<43>()
+    {
+        set_test_name("UTF conversions match the scalar conversions on random text");
+        std::mt19937 rng(43);
+        for (S32 round = 0; round < 2000; ++round)
+        {
+            LLWString text = random_text(rng, rng() % 200);
+            std::string utf8 = reference_wstring_to_utf8str(text);
+            llutf16string utf16 = reference_wstring_to_utf16str(text);
+
+            ensure("utf8 to utf32", utf8str_to_wstring(utf8) == reference_utf8str_to_wstring(utf8));
+            ensure("utf32 to utf8", wstring_to_utf8str(text) == utf8);
+            ensure("utf32 to utf16", wstring_to_utf16str(text) == utf16);
+            ensure("utf16 to utf32", utf16str_to_wstring(utf16) == reference_utf16str_to_wstring(utf16));
+            ensure("utf8 to utf16", utf8str_to_utf16str(utf8) == reference_wstring_to_utf16str(reference_utf8str_to_wstring(utf8)));
+            ensure("utf16 to utf8", utf16str_to_utf8str(utf16) == reference_wstring_to_utf8str(reference_utf16str_to_wstring(utf16)));
+        }
+    }
+
+    template<> template<>
+    void string_index_object_t::test<44>()
+    {
+        set_test_name("UTF conversions match the scalar conversions on malformed input");
+        std::mt19937 rng(44);
+        for (S32 round = 0; round < 2000; ++round)
+        {
+            size_t len = rng() % 100;
+            std::string bytes;
+            LLWString wide;
+            llutf16string units;
+            for (size_t i = 0; i < len; ++i)
+            {
+                // Long ASCII stretches with stray lead, continuation and
+                // surrogate values in between, so every fast path gets cut off
+                bool odd = rng() % 8 == 0;
+                bytes += (char)(odd ? 0x80 + rng() % 0x80 : rng() % 0x80);
+                wide += (llwchar)(odd ? rng() : rng() % 0x80);
+                units += (U16)(odd ? 0xD800 + rng() % 0x800 : rng() % 0x10000);
+            }
+
+            ensure("utf8 to utf32", utf8str_to_wstring(bytes) == reference_utf8str_to_wstring(bytes));
+            ensure("utf8 to utf16", utf8str_to_utf16str(bytes) == reference_wstring_to_utf16str(reference_utf8str_to_wstring(bytes)));
+            ensure("utf32 to utf8", wstring_to_utf8str(wide) == reference_wstring_to_utf8str(wide));
+            ensure("utf32 to utf16", wstring_to_utf16str(wide) == reference_wstring_to_utf16str(wide));
+            ensure("utf16 to utf32", utf16str_to_wstring(units) == reference_utf16str_to_wstring(units));
+            ensure("utf16 to utf8", utf16str_to_utf8str(units) == reference_wstring_to_utf8str(reference_utf16str_to_wstring(units)));
+        }
+    }
+
+    template<> template<>
+    void string_index_object_t::test<45>()
+    {
+        set_test_name("UTF conversion benchmark");
+        std::mt19937 rng(45);
+        std::vector<std::string> chat;
+        std::vector<std::string> ui;
+        for (S32 i = 0; i < 2000; ++i)
+        {
+            chat.push_back(reference_wstring_to_utf8str(random_text(rng, 20 + rng() % 120)));
+            ui.push_back("Preferences > Graphics > Hardware settings " + std::to_string(i));
+        }
+
+        typedef std::chrono::steady_clock clock_t;
+        auto measure = [](const std::vector<std::string>& lines, bool reference)
+        {
+            size_t check = 0;
+            clock_t::time_point start = clock_t::now();
+            for (S32 pass = 0; pass < 20; ++pass)
+            {
+                for (const std::string& line : lines)
+                {
+                    LLWString wide = reference ? reference_utf8str_to_wstring(line) : utf8str_to_wstring(line);
+                    std::string back = reference ? reference_wstring_to_utf8str(wide) : wstring_to_utf8str(wide);
+                    check += back.size();
+                }
+            }
+            std::chrono::duration<F64, std::micro> elapsed = clock_t::now() - start;
+            ensure("round trip", check > 0);
+            return elapsed.count();
+        };
+
+        F64 chat_scalar = measure(chat, true);
+        F64 chat_vector = measure(chat, false);
+        F64 ui_scalar = measure(ui, true);
+        F64 ui_vector = measure(ui, false);
+        std::cout << "\nUTF-8 round trips of 2000 lines, 20 passes:"
+                  << "\n  chat: " << chat_scalar << " us scalar, " << chat_vector << " us vectorized"
+                  << "\n  ui:   " << ui_scalar << " us scalar, " << ui_vector << " us vectorized" << std::endl;
+    }
 }
@@ -39,6 +39,7 @@
 #include "llimagepng.h"
 #include "llimagedxt.h"
 #include "llmemory.h"
+#include "fsmemtags.h" // <FS/> Memory tags
 
 #include <boost/preprocessor.hpp>
 
@@ -627,7 +628,8 @@ LLImageBase::LLImageBase()
     mHeight(0),
     mComponents(0),
     mBadBufferAllocation(false),
-    mAllowOverSize(false)
+    mAllowOverSize(false),
+    mTaggedBytes(0) // <FS/> Memory tags
 {}
 
 // virtual
@@ -673,6 +675,7 @@ void LLImageBase::deleteData()
     ll_aligned_free_16(mData);
     mDataSize = 0;
     mData = NULL;
+    updateMemTag(); // <FS/> Memory tags
 }
 
 // virtual
@@ -729,6 +732,7 @@ U8* LLImageBase::allocateData(S32 size)
         addAllocationError();
     }
     mDataSize = size;
+    updateMemTag(); // <FS/> Memory tags
 
     return mData;
 }
@@ -751,6 +755,7 @@ U8* LLImageBase::reallocateData(S32 size)
     mData = new_datap;
     mDataSize = size;
     mBadBufferAllocation = false;
+    updateMemTag(); // <FS/> Memory tags
     return mData;
 }
 
@@ -2340,8 +2345,16 @@ void LLImageBase::setDataAndSize(U8 *data, S32 size)
     ll_assert_aligned(data, 16);
     mData = data;
     mDataSize = size;
+    updateMemTag(); // <FS/> Memory tags
 }
 
+// <FS> Memory tags
+void LLImageBase::updateMemTag()
+{
+    FSMemTags::track(FSMT_TEXTURES, mTaggedBytes, mData ? (size_t)llmax(mDataSize, 0) : 0);
+}
+// </FS>
+
 //static
 void LLImageBase::generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
 {
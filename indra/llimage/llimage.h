@@ -172,6 +172,11 @@ private:
 
     bool mBadBufferAllocation ;
     bool mAllowOverSize ;
+
+    // <FS> Memory tags
+    void updateMemTag();
+    size_t mTaggedBytes;
+    // </FS>
 public:
     // <FS:ND> Report amount of failed buffer allocations
     static void addAllocationError();
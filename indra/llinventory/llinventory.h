@@ -35,6 +35,7 @@
 #include "llsd.h"
 #include "lluuid.h"
 #include "lltrace.h"
+#include "fsmemtags.h" // <FS/> Memory tags
 
 class LLMessageSystem;
 
@@ -44,7 +45,7 @@ class LLMessageSystem;
 //   Base class for anything in the user's inventory.   Handles the common code
 //   between items and categories.
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-class LLInventoryObject : public LLRefCount
+class LLInventoryObject : public LLRefCount, public FSMemTagBase<FSMT_INVENTORY> // <FS/> Memory tags
 {
 public:
     typedef std::list<LLPointer<LLInventoryObject> > object_list_t;
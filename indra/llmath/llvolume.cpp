@@ -52,6 +52,7 @@
 #include "llmatrix4a.h"
 #include "llmeshoptimizer.h"
 #include "lltimer.h"
+#include "fsmemtags.h" // <FS/> Memory tags
 
 #include "mikktspace/mikktspace.h"
 #include "mikktspace/mikktspace.c" // insert mikktspace implementation into llvolume object file
@@ -4976,6 +4977,7 @@ LLVolumeFace& LLVolumeFace::operator=(const LLVolumeFace& src)
 
     mOptimized = src.mOptimized;
     mNormalizedScale = src.mNormalizedScale;
+    updateMemTag(); // <FS/> Memory tags
 
     //delete
     return *this;
@@ -5014,8 +5016,45 @@ void LLVolumeFace::freeData()
 #endif
 
     destroyOctree();
+    updateMemTag(); // <FS/> Memory tags
 }
 
+// <FS> Memory tags
+void LLVolumeFace::updateMemTag()
+{
+    // Estimated from the counts, what matters is that it drops to zero
+    // together with the buffers
+    size_t bytes = 0;
+    if (mPositions)
+    {
+        bytes += mNumAllocatedVertices * sizeof(LLVector4a) * 2 + ((mNumAllocatedVertices * sizeof(LLVector2) + 0xF) & ~0xF);
+    }
+    if (mIndices)
+    {
+        bytes += (mNumIndices * sizeof(U16) + 0xF) & ~0xF;
+    }
+    if (mTangents)
+    {
+        bytes += mNumVertices * sizeof(LLVector4a);
+    }
+    if (mWeights)
+    {
+        bytes += mNumVertices * sizeof(LLVector4a);
+    }
+#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
+    if (mJointIndices)
+    {
+        bytes += mNumVertices * sizeof(U8) * 4;
+    }
+    if (mJustWeights)
+    {
+        bytes += mNumVertices * sizeof(LLVector4a);
+    }
+#endif
+    FSMemTags::track(FSMT_MESHES, mTaggedBytes, bytes);
+}
+// </FS>
+
 BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
@@ -5129,6 +5168,7 @@ void LLVolumeFace::remap()
     mTexCoords = remap_tex_coords;
     mNumVertices = remap_vertices_count;
     mNumAllocatedVertices = remap_vertices_count;
+    updateMemTag(); // <FS/> Memory tags
 }
 
 void LLVolumeFace::optimize(F32 angle_cutoff)
@@ -5823,6 +5863,10 @@ void LLVolumeFace::swapData(LLVolumeFace& rhs)
     llswap(rhs.mIndices,mIndices);
     llswap(rhs.mNumVertices, mNumVertices);
     llswap(rhs.mNumIndices, mNumIndices);
+    // <FS> Memory tags
+    updateMemTag();
+    rhs.updateMemTag();
+    // </FS>
 }
 
 void    LerpPlanarVertex(LLVolumeFace::VertexData& v0,
@@ -6596,6 +6640,7 @@ void LLVolumeFace::resizeVertices(S32 num_verts)
 
     // Force update
     mJointRiggingInfoTab.clear();
+    updateMemTag(); // <FS/> Memory tags
 }
 
 void LLVolumeFace::pushVertex(const LLVolumeFace::VertexData& cv)
@@ -6643,7 +6688,7 @@ void LLVolumeFace::pushVertex(const LLVector4a& pos, const LLVector4a& norm, con
         ll_aligned_free<64>(old_buf);
 
         mNumAllocatedVertices = new_verts;
-
+        updateMemTag(); // <FS/> Memory tags
     }
 
     mPositions[mNumVertices] = pos;
@@ -6657,13 +6702,14 @@ void LLVolumeFace::allocateTangents(S32 num_verts)
 {
     ll_aligned_free_16(mTangents);
     mTangents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*num_verts);
+    updateMemTag(); // <FS/> Memory tags
 }
 
 void LLVolumeFace::allocateWeights(S32 num_verts)
 {
     ll_aligned_free_16(mWeights);
     mWeights = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a)*num_verts);
-
+    updateMemTag(); // <FS/> Memory tags
 }
 
 void LLVolumeFace::allocateJointIndices(S32 num_verts)
@@ -6674,6 +6720,7 @@ void LLVolumeFace::allocateJointIndices(S32 num_verts)
 
     mJointIndices = (U8*)ll_aligned_malloc_16(sizeof(U8) * 4 * num_verts);
     mJustWeights = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);
+    updateMemTag(); // <FS/> Memory tags
 #endif
 }
 
@@ -6703,6 +6750,7 @@ void LLVolumeFace::resizeIndices(S32 num_indices)
         // Either num_indices is zero or allocation failure
         mNumIndices = 0;
     }
+    updateMemTag(); // <FS/> Memory tags
 }
 
 void LLVolumeFace::pushIndex(const U16& idx)
@@ -6718,6 +6766,12 @@ void LLVolumeFace::pushIndex(const U16& idx)
     }
 
     mIndices[mNumIndices++] = idx;
+    // <FS> Memory tags
+    if (new_size != old_size)
+    {
+        updateMemTag();
+    }
+    // </FS>
 }
 
 void LLVolumeFace::fillFromLegacyData(std::vector<LLVolumeFace::VertexData>& v, std::vector<U16>& idx)
@@ -993,6 +993,11 @@ private:
     LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* mOctree;
     LLVolumeTriangle* mOctreeTriangles;
 
+    // <FS> Memory tags
+    void updateMemTag();
+    size_t mTaggedBytes = 0;
+    // </FS>
+
     BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
     BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
     BOOL createSide(LLVolume* volume, BOOL partial_build = FALSE);
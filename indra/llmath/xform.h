@@ -149,6 +149,9 @@ public:
 
     const LLMatrix4&    getWorldMatrix() const      { return mWorldMatrix; }
     void setWorldMatrix (const LLMatrix4& mat)   { mWorldMatrix = mat; }
+    // <FS> Flattened joint hierarchy: world position and rotation computed by the skeleton
+    void setWorldPRS(const LLVector3& pos, const LLQuaternion& rot) { mWorldPosition = pos; mWorldRotation = rot; }
+    // </FS>
 
     void init()
     {
@@ -1610,6 +1610,53 @@ S32 LLPrimitive::unpackTEMessage(LLDataPacker &dp)
     return retval;
 }
 
+// <FS> Region prefetch: read only the texture IDs of a packed TE block without a primitive
+//static
+bool LLPrimitive::extractTEImageIDs(LLDataPacker &dp, uuid_vec_t& image_ids)
+{
+    const U32 MAX_TES = 45;
+    const U32 MAX_TE_BUFFER = 4096;
+    U8 packed_buffer[MAX_TE_BUFFER];
+
+    S32 size;
+    if (!dp.unpackBinaryData(packed_buffer, size, "TextureEntry"))
+    {
+        return false;
+    }
+
+    if (size == 0)
+    {
+        return true;
+    }
+    else if (size >= MAX_TE_BUFFER)
+    {
+        size = MAX_TE_BUFFER - 1;
+    }
+
+    // Same termination trick as unpackTEMessage()
+    packed_buffer[size] = 0x00;
+    ++size;
+
+    // The number of faces is unknown here, so unpack into the maximum and
+    // collect the distinct IDs.
+    LLUUID image_data[MAX_TES];
+    U8 *cur_ptr = packed_buffer;
+    if (!unpack_TEField<LLUUID>(image_data, MAX_TES, cur_ptr, packed_buffer + size, MVT_LLUUID))
+    {
+        return false;
+    }
+
+    for (U32 i = 0; i < MAX_TES; ++i)
+    {
+        if (image_data[i].notNull() && std::find(image_ids.begin(), image_ids.end(), image_data[i]) == image_ids.end())
+        {
+            image_ids.push_back(image_data[i]);
+        }
+    }
+    return true;
+}
+// </FS>
+
 U8  LLPrimitive::getExpectedNumTEs() const
 {
     U8 expected_face_count = 0;
@@ -508,6 +508,9 @@ public:
     BOOL unpackTEMessage(LLDataPacker &dp);
     S32 parseTEMessage(LLMessageSystem* mesgsys, char const* block_name, const S32 block_num, LLTEContents& tec);
     S32 applyParsedTEMessage(LLTEContents& tec);
+    // <FS> Region prefetch: read only the texture IDs of a packed TE block without a primitive
+    static bool extractTEImageIDs(LLDataPacker &dp, uuid_vec_t& image_ids);
+    // </FS>
 
 #ifdef CHECK_FOR_FINITE
     inline void setPosition(const LLVector3& pos);
@@ -197,6 +197,7 @@ S32 LLUICtrlFactory::saveToXML(LLView* viewp, const std::string& filename)
 LLView *LLUICtrlFactory::createFromXML(LLXMLNodePtr node, LLView* parent, const std::string& filename, const widget_registry_t& registry, LLXMLNodePtr output_node)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_UI;
+    FSMemTagScope mem_tag(FSMT_UI); // <FS/> Memory tags
     std::string ctrl_type = node->getName()->mString;
     LLStringUtil::toLower(ctrl_type);
 
@@ -47,6 +47,7 @@
 #include "lluictrlfactory.h"
 #include "lltreeiterators.h"
 #include "llfocusmgr.h"
+#include "fsmemtags.h" // <FS/> Memory tags
 
 #include <list>
 #include <boost/function.hpp>
@@ -100,7 +101,8 @@ class LLView
 :   public LLMouseHandler,          // handles mouse events
     public LLFocusableElement,      // handles keyboard events
     public LLMortician,             // lazy deletion
-    public LLHandleProvider<LLView>     // passes out weak references to self
+    public LLHandleProvider<LLView>,    // passes out weak references to self
+    public FSMemTagBase<FSMT_UI>       // <FS/> accounted to the UI memory tag
 {
 public:
 
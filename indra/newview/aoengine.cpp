@@ -34,6 +34,7 @@
 #include "llagentcamera.h"
 #include "llanimationstates.h"
 #include "llassetstorage.h"
+#include "llcallbacklist.h"
 #include "llfilesystem.h"
 #include "llinventoryfunctions.h"       // for ROOT_FIRESTORM_FOLDER
 #include "llinventorymodel.h"
@@ -64,10 +65,18 @@ AOEngine::AOEngine() :
     gSavedPerAccountSettings.getControl("PauseAO")->getCommitSignal()->connect(boost::bind(&AOEngine::onPauseAO, this));
 
     mRegionChangeConnection = gAgent.addRegionChangedCallback(boost::bind(&AOEngine::onRegionChange, this));
+
+    gIdleCallbacks.addFunction(&AOEngine::onIdle, this);
 }
 
 AOEngine::~AOEngine()
 {
+    gIdleCallbacks.deleteFunction(&AOEngine::onIdle, this);
+
+    LL_INFOS("AOEngine") << "Animation requests: " << mAnimationRequests.getRequestCount()
+        << " made, " << mAnimationRequests.getSuppressedCount() << " suppressed, "
+        << mAnimationRequests.getSentCount() << " sent in " << mAnimationRequests.getMessageCount() << " messages" << LL_ENDL;
+
     clear(false);
 
     if (mRegionChangeConnection.connected())
@@ -144,13 +153,59 @@ void AOEngine::clear(bool from_timer)
     }
 }
 
+// static
+void AOEngine::onIdle(void* userdata)
+{
+    static_cast<AOEngine*>(userdata)->flushAnimationRequests();
+}
+
+void AOEngine::requestAnimation(const LLUUID& animation, bool start)
+{
+    static LLCachedControl<bool> coalesce(gSavedSettings, "FSAOCoalesceAnimationRequests");
+    if (!coalesce)
+    {
+        // keep the order with anything already queued
+        flushAnimationRequests();
+        gAgent.sendAnimationRequest(animation, start ? ANIM_REQUEST_START : ANIM_REQUEST_STOP);
+        return;
+    }
+
+    mAnimationRequests.add(animation, start);
+}
+
+// sends what is left of this frame's start and stop requests, stops first
+void AOEngine::flushAnimationRequests()
+{
+    if (mAnimationRequests.empty())
+    {
+        return;
+    }
+
+    if (!gAgent.getRegion())
+    {
+        // would be dropped by sendAnimationRequest() as well
+        mAnimationRequests.clear();
+        return;
+    }
+
+    mAnimationRequests.take(mStopRequests, mStartRequests);
+    if (!mStopRequests.empty())
+    {
+        gAgent.sendAnimationRequests(mStopRequests, ANIM_REQUEST_STOP);
+    }
+    if (!mStartRequests.empty())
+    {
+        gAgent.sendAnimationRequests(mStartRequests, ANIM_REQUEST_START);
+    }
+}
+
 void AOEngine::stopAllStandVariants()
 {
     LL_DEBUGS("AOEngine") << "stopping all STAND variants." << LL_ENDL;
-    gAgent.sendAnimationRequest(ANIM_AGENT_STAND_1, ANIM_REQUEST_STOP);
-    gAgent.sendAnimationRequest(ANIM_AGENT_STAND_2, ANIM_REQUEST_STOP);
-    gAgent.sendAnimationRequest(ANIM_AGENT_STAND_3, ANIM_REQUEST_STOP);
-    gAgent.sendAnimationRequest(ANIM_AGENT_STAND_4, ANIM_REQUEST_STOP);
+    requestAnimation(ANIM_AGENT_STAND_1, false);
+    requestAnimation(ANIM_AGENT_STAND_2, false);
+    requestAnimation(ANIM_AGENT_STAND_3, false);
+    requestAnimation(ANIM_AGENT_STAND_4, false);
     gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_STAND_1);
     gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_STAND_2);
     gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_STAND_3);
@@ -160,8 +215,8 @@ void AOEngine::stopAllStandVariants()
 void AOEngine::stopAllSitVariants()
 {
     LL_DEBUGS("AOEngine") << "stopping all SIT variants." << LL_ENDL;
-    gAgent.sendAnimationRequest(ANIM_AGENT_SIT_FEMALE, ANIM_REQUEST_STOP);
-    gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_STOP);
+    requestAnimation(ANIM_AGENT_SIT_FEMALE, false);
+    requestAnimation(ANIM_AGENT_SIT_GENERIC, false);
     gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_SIT_FEMALE);
     gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_SIT_GENERIC);
 
@@ -173,8 +228,8 @@ void AOEngine::stopAllSitVariants()
         return;
     }
 
-    gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GROUND, ANIM_REQUEST_STOP);
-    gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GROUND_CONSTRAINED, ANIM_REQUEST_STOP);
+    requestAnimation(ANIM_AGENT_SIT_GROUND, false);
+    requestAnimation(ANIM_AGENT_SIT_GROUND_CONSTRAINED, false);
 
     gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_SIT_GROUND);
     gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_SIT_GROUND_CONSTRAINED);
@@ -253,31 +308,8 @@ bool AOEngine::foreignAnimations()
 // map motion to underwater state, return nullptr if not applicable
 AOSet::AOState* AOEngine::mapSwimming(const LLUUID& motion) const
 {
-    S32 stateNum;
-
-    if (motion == ANIM_AGENT_HOVER)
-    {
-        stateNum = AOSet::Floating;
-    }
-    else if (motion == ANIM_AGENT_FLY)
-    {
-        stateNum = AOSet::SwimmingForward;
-    }
-    else if (motion == ANIM_AGENT_HOVER_UP)
-    {
-        stateNum = AOSet::SwimmingUp;
-    }
-    else if (motion == ANIM_AGENT_HOVER_DOWN)
-    {
-        stateNum = AOSet::SwimmingDown;
-    }
-    else
-    {
-        // motion not applicable for underwater mapping
-        return nullptr;
-    }
-
-    return mCurrentSet->getState(stateNum);
+    // the set's state table knows which motions have an underwater state
+    return mCurrentSet->getUnderwaterStateByRemapID(motion);
 }
 
 // switch between swimming and flying on transition in and out of Linden region water
@@ -307,7 +339,7 @@ void AOEngine::checkBelowWater(bool check_underwater)
     }
 
     // stop currently running animation
-    gAgent.sendAnimationRequest(id, ANIM_REQUEST_STOP);
+    requestAnimation(id, false);
 
     if (!mUnderWater)
     {
@@ -329,7 +361,7 @@ void AOEngine::checkBelowWater(bool check_underwater)
     }
 
     // start new animation
-    gAgent.sendAnimationRequest(id, ANIM_REQUEST_START);
+    requestAnimation(id, true);
 }
 
 // find the correct animation state for the requested motion, mapping flying to
@@ -391,7 +423,7 @@ void AOEngine::enable(bool enable)
                 mLastOverriddenMotion != ANIM_AGENT_SIT_GROUND_CONSTRAINED &&
                 mLastOverriddenMotion != ANIM_AGENT_SIT)
             {
-                gAgent.sendAnimationRequest(mLastOverriddenMotion, ANIM_REQUEST_STOP);
+                requestAnimation(mLastOverriddenMotion, false);
             }
 
             LLUUID animation = override(mLastMotion, true);
@@ -412,9 +444,9 @@ void AOEngine::enable(bool enable)
             else if (mLastMotion == ANIM_AGENT_WALK)
             {
                 LL_DEBUGS("AOEngine") << "Last motion was a WALK, stopping all variants." << LL_ENDL;
-                gAgent.sendAnimationRequest(ANIM_AGENT_WALK_NEW, ANIM_REQUEST_STOP);
-                gAgent.sendAnimationRequest(ANIM_AGENT_FEMALE_WALK, ANIM_REQUEST_STOP);
-                gAgent.sendAnimationRequest(ANIM_AGENT_FEMALE_WALK_NEW, ANIM_REQUEST_STOP);
+                requestAnimation(ANIM_AGENT_WALK_NEW, false);
+                requestAnimation(ANIM_AGENT_FEMALE_WALK, false);
+                requestAnimation(ANIM_AGENT_FEMALE_WALK_NEW, false);
                 gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_WALK_NEW);
                 gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_FEMALE_WALK);
                 gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_FEMALE_WALK_NEW);
@@ -422,22 +454,22 @@ void AOEngine::enable(bool enable)
             else if (mLastMotion == ANIM_AGENT_RUN)
             {
                 LL_DEBUGS("AOEngine") << "Last motion was a RUN, stopping all variants." << LL_ENDL;
-                gAgent.sendAnimationRequest(ANIM_AGENT_RUN_NEW, ANIM_REQUEST_STOP);
-                gAgent.sendAnimationRequest(ANIM_AGENT_FEMALE_RUN_NEW, ANIM_REQUEST_STOP);
+                requestAnimation(ANIM_AGENT_RUN_NEW, false);
+                requestAnimation(ANIM_AGENT_FEMALE_RUN_NEW, false);
                 gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_RUN_NEW);
                 gAgentAvatarp->LLCharacter::stopMotion(ANIM_AGENT_FEMALE_RUN_NEW);
             }
             else if (mLastMotion == ANIM_AGENT_SIT)
             {
                 stopAllSitVariants();
-                gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_START);
+                requestAnimation(ANIM_AGENT_SIT_GENERIC, true);
             }
             else
             {
                 LL_WARNS("AOEngine") << "Unhandled last motion id " << gAnimLibrary.animationName(mLastMotion) << LL_ENDL;
             }
 
-            gAgent.sendAnimationRequest(animation, ANIM_REQUEST_START);
+            requestAnimation(animation, true);
             mAnimationChangedSignal(state->mAnimations[state->mCurrentAnimation].mInventoryUUID);
 
             // remember to ignore this motion once in the overrider so stopping the Linden motion
@@ -452,7 +484,7 @@ void AOEngine::enable(bool enable)
         if (mLastOverriddenMotion == ANIM_AGENT_SIT)
         {
             // remove sit cycle cover up
-            gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_STOP);
+            requestAnimation(ANIM_AGENT_SIT_GENERIC, false);
         }
 
         // stop all overriders, catch leftovers
@@ -465,7 +497,7 @@ void AOEngine::enable(bool enable)
                 if (animation.notNull())
                 {
                     LL_DEBUGS("AOEngine") << "Stopping leftover animation from state " << state->mName << LL_ENDL;
-                    gAgent.sendAnimationRequest(animation, ANIM_REQUEST_STOP);
+                    requestAnimation(animation, false);
                     gAgentAvatarp->LLCharacter::stopMotion(animation);
                     state->mCurrentAnimationID.setNull();
                 }
@@ -479,7 +511,7 @@ void AOEngine::enable(bool enable)
         // restore Linden animation if applicable
         if (mLastOverriddenMotion != ANIM_AGENT_SIT || !foreignAnimations())
         {
-            gAgent.sendAnimationRequest(mLastMotion, ANIM_REQUEST_START);
+            requestAnimation(mLastMotion, true);
         }
 
         mCurrentSet->stopTimer();
@@ -543,7 +575,7 @@ const LLUUID AOEngine::override(const LLUUID& motion, bool start)
         // when stopping a sit motion make sure to stop the cycle point cover-up animation
         if (motion == ANIM_AGENT_SIT)
         {
-            gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_STOP);
+            requestAnimation(ANIM_AGENT_SIT_GENERIC, false);
         }
 
         return LLUUID::null;
@@ -624,7 +656,7 @@ const LLUUID AOEngine::override(const LLUUID& motion, bool start)
                     LL_WARNS() << "cleaning up animation in state " << stateToCheck->mName << LL_ENDL;
 
                     // stop  the leftover animation locally and in the region for everyone
-                    gAgent.sendAnimationRequest(stateToCheck->mCurrentAnimationID, ANIM_REQUEST_STOP);
+                    requestAnimation(stateToCheck->mCurrentAnimationID, false);
                     gAgentAvatarp->LLCharacter::stopMotion(stateToCheck->mCurrentAnimationID);
 
                     // mark the state as clean
@@ -697,7 +729,7 @@ const LLUUID AOEngine::override(const LLUUID& motion, bool start)
             LL_DEBUGS("AOEngine")   << "Previous animation for state "
                         << gAnimLibrary.animationName(motion)
                         << " was not stopped, but we were asked to start a new one. Killing old animation." << LL_ENDL;
-            gAgent.sendAnimationRequest(state->mCurrentAnimationID, ANIM_REQUEST_STOP);
+            requestAnimation(state->mCurrentAnimationID, false);
             gAgentAvatarp->LLCharacter::stopMotion(state->mCurrentAnimationID);
         }
 
@@ -719,7 +751,7 @@ const LLUUID AOEngine::override(const LLUUID& motion, bool start)
         {
             // Use ANIM_AGENT_SIT_GENERIC, so we don't create an overrider loop with ANIM_AGENT_SIT
             // while still having a base sitting pose to cover up cycle points
-            gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_START);
+            requestAnimation(ANIM_AGENT_SIT_GENERIC, true);
             if (mCurrentSet->getSmart())
             {
                 mSitCancelTimer.oneShot();
@@ -733,7 +765,7 @@ const LLUUID AOEngine::override(const LLUUID& motion, bool start)
                 motion == ANIM_AGENT_LAND ||
                 motion == ANIM_AGENT_MEDIUM_LAND)
         {
-            gAgent.sendAnimationRequest(animation, ANIM_REQUEST_START);
+            requestAnimation(animation, true);
             return LLUUID::null;
         }
     }
@@ -791,7 +823,7 @@ const LLUUID AOEngine::override(const LLUUID& motion, bool start)
             motion == ANIM_AGENT_LAND ||
             motion == ANIM_AGENT_MEDIUM_LAND)
         {
-            gAgent.sendAnimationRequest(animation, ANIM_REQUEST_STOP);
+            requestAnimation(animation, false);
             gAgentAvatarp->LLCharacter::stopMotion(animation);
             setStateCycleTimer(state);
             return LLUUID::null;
@@ -811,9 +843,9 @@ void AOEngine::checkSitCancel()
             if (animation.notNull())
             {
                 LL_DEBUGS("AOEngine") << "Stopping sit animation due to foreign animations running" << LL_ENDL;
-                gAgent.sendAnimationRequest(animation, ANIM_REQUEST_STOP);
+                requestAnimation(animation, false);
                 // remove cycle point cover-up
-                gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_STOP);
+                requestAnimation(ANIM_AGENT_SIT_GENERIC, false);
                 gAgentAvatarp->LLCharacter::stopMotion(animation);
                 mSitCancelTimer.stop();
                 // stop cycle tiemr
@@ -944,7 +976,7 @@ void AOEngine::cycle(eCycleMode cycleMode)
     if (animation.notNull())
     {
         LL_DEBUGS("AOEngine") << "requesting animation start for motion " << gAnimLibrary.animationName(mLastMotion) << ": " << animation << LL_ENDL;
-        gAgent.sendAnimationRequest(animation, ANIM_REQUEST_START);
+        requestAnimation(animation, true);
         mAnimationChangedSignal(state->mAnimations[state->mCurrentAnimation].mInventoryUUID);
     }
     else
@@ -955,7 +987,7 @@ void AOEngine::cycle(eCycleMode cycleMode)
     if (oldAnimation.notNull())
     {
         LL_DEBUGS("AOEngine") << "Cycling state " << state->mName << " - stopping animation " << oldAnimation << LL_ENDL;
-        gAgent.sendAnimationRequest(oldAnimation, ANIM_REQUEST_STOP);
+        requestAnimation(oldAnimation, false);
         gAgentAvatarp->LLCharacter::stopMotion(oldAnimation);
     }
 }
@@ -1627,7 +1659,7 @@ void AOEngine::selectSet(AOSet* set)
         AOSet::AOState* state = mCurrentSet->getStateByRemapID(mLastOverriddenMotion);
         if (state)
         {
-            gAgent.sendAnimationRequest(state->mCurrentAnimationID, ANIM_REQUEST_STOP);
+            requestAnimation(state->mCurrentAnimationID, false);
             state->mCurrentAnimationID.setNull();
             mCurrentSet->stopTimer();
         }
@@ -1638,7 +1670,7 @@ void AOEngine::selectSet(AOSet* set)
     if (mEnabled)
     {
         LL_DEBUGS("AOEngine") << "enabling with motion " << gAnimLibrary.animationName(mLastMotion) << LL_ENDL;
-        gAgent.sendAnimationRequest(override(mLastMotion, true), ANIM_REQUEST_START);
+        requestAnimation(override(mLastMotion, true), true);
     }
 }
 
@@ -1805,17 +1837,17 @@ void AOEngine::inMouselook(bool mouselook)
         LLUUID animation = state->mCurrentAnimationID;
         if (animation.notNull())
         {
-            gAgent.sendAnimationRequest(animation, ANIM_REQUEST_STOP);
+            requestAnimation(animation, false);
             gAgentAvatarp->LLCharacter::stopMotion(animation);
             state->mCurrentAnimationID.setNull();
             LL_DEBUGS("AOEngine") << " stopped animation " << animation << " in state " << state->mName << LL_ENDL;
         }
-        gAgent.sendAnimationRequest(ANIM_AGENT_STAND, ANIM_REQUEST_START);
+        requestAnimation(ANIM_AGENT_STAND, true);
     }
     else
     {
         stopAllStandVariants();
-        gAgent.sendAnimationRequest(override(ANIM_AGENT_STAND, true), ANIM_REQUEST_START);
+        requestAnimation(override(ANIM_AGENT_STAND, true), true);
     }
 }
 
@@ -1851,12 +1883,12 @@ void AOEngine::setOverrideSits(AOSet* set, bool override_sit)
     if (override_sit)
     {
         stopAllSitVariants();
-        gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_START);
+        requestAnimation(ANIM_AGENT_SIT_GENERIC, true);
     }
     else
     {
         // remove sit cycle cover up
-        gAgent.sendAnimationRequest(ANIM_AGENT_SIT_GENERIC, ANIM_REQUEST_STOP);
+        requestAnimation(ANIM_AGENT_SIT_GENERIC, false);
 
         AOSet::AOState* state = mCurrentSet->getState(AOSet::Sitting);
         if (state)
@@ -1864,14 +1896,14 @@ void AOEngine::setOverrideSits(AOSet* set, bool override_sit)
             LLUUID animation = state->mCurrentAnimationID;
             if (animation.notNull())
             {
-                gAgent.sendAnimationRequest(animation, ANIM_REQUEST_STOP);
+                requestAnimation(animation, false);
                 state->mCurrentAnimationID.setNull();
             }
         }
 
         if (!foreignAnimations())
         {
-            gAgent.sendAnimationRequest(ANIM_AGENT_SIT, ANIM_REQUEST_START);
+            requestAnimation(ANIM_AGENT_SIT, true);
         }
     }
 }
@@ -2349,7 +2381,7 @@ void AOEngine::onRegionChange()
     }
 
     // restart current animation on region crossing
-    gAgent.sendAnimationRequest(mLastMotion, ANIM_REQUEST_START);
+    requestAnimation(mLastMotion, true);
 }
 
 // ----------------------------------------------------
@@ -26,6 +26,7 @@
 #define AOENGINE_H
 
 #include "aoset.h"
+#include "fsaostatetable.h"
 
 #include "llassettype.h"
 #include "lleventtimer.h"
@@ -114,6 +115,11 @@ class AOEngine
         void checkSitCancel();
         void checkBelowWater(bool check_underwater);
 
+        // queues an animation start or stop for the region, sent once per frame
+        void requestAnimation(const LLUUID& animation, bool start);
+        void flushAnimationRequests();
+        const FSAOAnimationRequests& getAnimationRequests() const { return mAnimationRequests; }
+
         bool importNotecard(const LLInventoryItem* item);
         void processImport(bool from_timer);
 
@@ -181,6 +187,7 @@ class AOEngine
         void purgeFolder(const LLUUID& uuid) const;
 
         void onRegionChange();
+        static void onIdle(void* userdata);
 
         void onToggleAOControl();
         void onToggleAOStandsControl();
@@ -220,6 +227,10 @@ class AOEngine
         S32 mImportRetryCount;
 
         boost::signals2::connection mRegionChangeConnection;
+
+        FSAOAnimationRequests mAnimationRequests;
+        std::vector<LLUUID> mStopRequests;
+        std::vector<LLUUID> mStartRequests;
 };
 
 #endif // AOENGINE_H
@@ -119,7 +119,20 @@ AOSet::AOSet(const LLUUID inventoryID)
         mStates[index].mCycleTime = 0.0f;
         mStates[index].mDirty = false;
         mStateNames.emplace_back(stateNameList[0]);
+
+        // <FS> compile the motion lookup, the first state for a motion wins
+        mStateTable.addState(stateUUIDs[index], index);
+        // </FS>
     }
+
+    // <FS> ground sits share the state of constrained ground sits, flying
+    // motions map to swimming states under water
+    mStateTable.addAlias(ANIM_AGENT_SIT_GROUND, ANIM_AGENT_SIT_GROUND_CONSTRAINED);
+    mStateTable.addUnderwaterState(ANIM_AGENT_HOVER, Floating);
+    mStateTable.addUnderwaterState(ANIM_AGENT_FLY, SwimmingForward);
+    mStateTable.addUnderwaterState(ANIM_AGENT_HOVER_UP, SwimmingUp);
+    mStateTable.addUnderwaterState(ANIM_AGENT_HOVER_DOWN, SwimmingDown);
+    // </FS>
     stopTimer();
 }
 
@@ -151,21 +164,33 @@ AOSet::AOState* AOSet::getStateByName(const std::string& name)
 
 AOSet::AOState* AOSet::getStateByRemapID(const LLUUID& id)
 {
-    LLUUID remap_id = id;
-    if (remap_id == ANIM_AGENT_SIT_GROUND)
-    {
-        remap_id = ANIM_AGENT_SIT_GROUND_CONSTRAINED;
-    }
+    // <FS> look the state up in the compiled table
+    //LLUUID remap_id = id;
+    //if (remap_id == ANIM_AGENT_SIT_GROUND)
+    //{
+    //    remap_id = ANIM_AGENT_SIT_GROUND_CONSTRAINED;
+    //}
+    //
+    //for (S32 index = 0; index < AOSTATES_MAX; ++index)
+    //{
+    //    if (mStates[index].mRemapID == remap_id)
+    //    {
+    //        return &mStates[index];
+    //    }
+    //}
+    //return nullptr;
+    S32 index = mStateTable.getState(id);
+    return index != FSAOStateTable::NO_STATE ? &mStates[index] : nullptr;
+    // </FS>
+}
 
-    for (S32 index = 0; index < AOSTATES_MAX; ++index)
-    {
-        if (mStates[index].mRemapID == remap_id)
-        {
-            return &mStates[index];
-        }
-    }
-    return nullptr;
+// <FS>
+AOSet::AOState* AOSet::getUnderwaterStateByRemapID(const LLUUID& id)
+{
+    S32 index = mStateTable.getUnderwaterState(id);
+    return index != FSAOStateTable::NO_STATE ? &mStates[index] : nullptr;
 }
+// </FS>
 
 const LLUUID& AOSet::getAnimationForState(AOState* state) const
 {
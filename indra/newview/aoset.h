@@ -27,6 +27,8 @@
 
 #include "lleventtimer.h"
 
+#include "fsaostatetable.h" // <FS/> compiled motion to state lookup
+
 class LLInventoryItem;
 
 class AOSet
@@ -120,6 +122,9 @@ class AOSet
         AOState* getState(S32 eName);
         AOState* getStateByName(const std::string& name);
         AOState* getStateByRemapID(const LLUUID& id);
+        // <FS> state used instead of the normal one while under water, nullptr if none
+        AOState* getUnderwaterStateByRemapID(const LLUUID& id);
+        // </FS>
         const LLUUID& getAnimationForState(AOState* state) const;
 
         void startTimer(F32 timeout);
@@ -140,6 +145,7 @@ class AOSet
         bool mDirty;
 
         AOState mStates[AOSTATES_MAX];
+        FSAOStateTable mStateTable; // <FS/> compiled from the remap ids in the constructor
 };
 
 #endif // AOSET_H
@@ -0,0 +1,156 @@
+/**
+ * @file fsaostatetable.cpp
+ * @brief Animation overrider state tables and animation request coalescing
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsaostatetable.h"
+
+void FSAOStateTable::clear()
+{
+    mStates.clear();
+}
+
+void FSAOStateTable::addState(const LLUUID& motion, S32 state)
+{
+    Entry& entry = mStates[motion];
+    if (entry.mState == NO_STATE)
+    {
+        entry.mState = state;
+    }
+}
+
+void FSAOStateTable::addUnderwaterState(const LLUUID& motion, S32 state)
+{
+    Entry& entry = mStates[motion];
+    if (entry.mUnderwaterState == NO_STATE)
+    {
+        entry.mUnderwaterState = state;
+    }
+}
+
+void FSAOStateTable::addAlias(const LLUUID& motion, const LLUUID& same_as)
+{
+    entry_map_t::const_iterator it = mStates.find(same_as);
+    if (it != mStates.end())
+    {
+        // Copy first, inserting motion may move the entry
+        Entry entry = it->second;
+        mStates[motion] = entry;
+    }
+}
+
+S32 FSAOStateTable::getState(const LLUUID& motion) const
+{
+    entry_map_t::const_iterator it = mStates.find(motion);
+    return it != mStates.end() ? it->second.mState : NO_STATE;
+}
+
+S32 FSAOStateTable::getUnderwaterState(const LLUUID& motion) const
+{
+    entry_map_t::const_iterator it = mStates.find(motion);
+    return it != mStates.end() ? it->second.mUnderwaterState : NO_STATE;
+}
+
+FSAOAnimationRequests::FSAOAnimationRequests()
+:   mRequestCount(0),
+    mSuppressedCount(0),
+    mSentCount(0),
+    mMessageCount(0)
+{
+}
+
+void FSAOAnimationRequests::add(const LLUUID& animation, bool start)
+{
+    if (animation.isNull())
+    {
+        return;
+    }
+
+    ++mRequestCount;
+
+    // Only a handful of animations change per frame, a linear search is fine.
+    // An animation has at most one stop and one start pending; stops are
+    // sent first, so a stop followed by a start still restarts it.
+    bool stop_pending = false;
+    std::vector<Request>::iterator pending_start = mPending.end();
+    for (std::vector<Request>::iterator it = mPending.begin(); it != mPending.end(); ++it)
+    {
+        if (it->mAnimation == animation)
+        {
+            if (it->mStart)
+            {
+                pending_start = it;
+            }
+            else
+            {
+                stop_pending = true;
+            }
+        }
+    }
+
+    if (!start && pending_start != mPending.end())
+    {
+        // A start stopped again in the same frame only leaves the stop,
+        // at the end to keep the order requests were last made in
+        ++mSuppressedCount;
+        mPending.erase(pending_start);
+        pending_start = mPending.end();
+    }
+
+    if (start ? pending_start != mPending.end() : stop_pending)
+    {
+        ++mSuppressedCount;
+        return;
+    }
+
+    Request request;
+    request.mAnimation = animation;
+    request.mStart = start;
+    mPending.push_back(request);
+}
+
+U32 FSAOAnimationRequests::take(std::vector<LLUUID>& stops, std::vector<LLUUID>& starts)
+{
+    stops.clear();
+    starts.clear();
+    for (std::vector<Request>::const_iterator it = mPending.begin(); it != mPending.end(); ++it)
+    {
+        (it->mStart ? starts : stops).push_back(it->mAnimation);
+    }
+    mPending.clear();
+
+    U32 messages = (stops.empty() ? 0 : 1) + (starts.empty() ? 0 : 1);
+    mSentCount += (U32)(stops.size() + starts.size());
+    mMessageCount += messages;
+    return messages;
+}
+
+void FSAOAnimationRequests::clear()
+{
+    mSuppressedCount += (U32)mPending.size();
+    mPending.clear();
+}
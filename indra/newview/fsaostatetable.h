@@ -0,0 +1,113 @@
+/**
+ * @file fsaostatetable.h
+ * @brief Animation overrider state tables and animation request coalescing
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_AOSTATETABLE_H
+#define FS_AOSTATETABLE_H
+
+#include "lluuid.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Maps the motions the avatar reports to the states of one AO set. Built
+// once when the set is created, so the overrider does not walk the state
+// list on every start and stop of a motion. Each motion has a state for
+// normal movement and optionally one used instead while under water.
+class FSAOStateTable
+{
+public:
+    static const S32 NO_STATE = -1;
+
+    void clear();
+
+    // The first state added for a motion wins, like the lookup it replaces
+    void addState(const LLUUID& motion, S32 state);
+    void addUnderwaterState(const LLUUID& motion, S32 state);
+
+    // Makes motion resolve to whatever same_as resolves to
+    void addAlias(const LLUUID& motion, const LLUUID& same_as);
+
+    S32 getState(const LLUUID& motion) const;
+    S32 getUnderwaterState(const LLUUID& motion) const;
+
+    size_t size() const { return mStates.size(); }
+
+private:
+    struct Entry
+    {
+        Entry() : mState(NO_STATE), mUnderwaterState(NO_STATE) {}
+
+        S32 mState;
+        S32 mUnderwaterState;
+    };
+    typedef std::unordered_map<LLUUID, Entry> entry_map_t;
+
+    entry_map_t mStates;
+};
+
+// Collects the animation start and stop requests the overrider makes during
+// a frame and hands them out once per frame. The same request twice goes
+// out once, and a start followed by a stop of the same animation goes out
+// as the stop. A stop followed by a start keeps both, so the animation is
+// restarted. Surviving stops and starts are each sent as a single
+// AgentAnimation message, stops first.
+class FSAOAnimationRequests
+{
+public:
+    FSAOAnimationRequests();
+
+    void add(const LLUUID& animation, bool start);
+
+    bool empty() const { return mPending.empty(); }
+    size_t size() const { return mPending.size(); }
+
+    // Moves the surviving requests of this frame into stops and starts, in
+    // the order they were made, and returns the number of messages needed
+    U32 take(std::vector<LLUUID>& stops, std::vector<LLUUID>& starts);
+    void clear();
+
+    // Counted over the whole session
+    U32 getRequestCount() const { return mRequestCount; }
+    U32 getSuppressedCount() const { return mSuppressedCount; }
+    U32 getSentCount() const { return mSentCount; }
+    U32 getMessageCount() const { return mMessageCount; }
+
+private:
+    struct Request
+    {
+        LLUUID  mAnimation;
+        bool    mStart;
+    };
+
+    std::vector<Request>    mPending;
+    U32                     mRequestCount;
+    U32                     mSuppressedCount;
+    U32                     mSentCount;
+    U32                     mMessageCount;
+};
+
+#endif // FS_AOSTATETABLE_H
@@ -0,0 +1,177 @@
+/**
+ * @file fscamerapredictor.cpp
+ * @brief Camera trajectory prediction for detail and fetch priorities
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fscamerapredictor.h"
+
+#include "llquaternion.h"
+
+FSCameraPredictor gCameraPredictor;
+
+static const F32 SMOOTHING_TIME = 0.15f;        // seconds, time constant of the velocity filter
+static const F32 MAX_SAMPLE_GAP = 0.5f;         // longer frame gaps restart the estimate
+static const F32 TELEPORT_DISTANCE = 64.f;      // camera jumps farther than this in one frame are not motion
+static const F32 MIN_ACTIVE_SPEED = 0.5f;       // m/s
+static const F32 MIN_ACTIVE_ANGULAR_SPEED = 0.1f; // rad/s
+static const F32 MAX_PREDICTED_TURN = F_PI_BY_TWO;
+
+FSCameraPredictor::FSCameraPredictor()
+:   mEnabled(false),
+    mActive(false),
+    mHasSample(false),
+    mHorizon(0.5f),
+    mBlend(0.5f),
+    mLastTime(0.0),
+    mLastAtAxis(LLVector3::x_axis),
+    mPredictedAtAxis(LLVector3::x_axis)
+{
+}
+
+void FSCameraPredictor::setParameters(bool enabled, F32 horizon, F32 blend)
+{
+    if (enabled != mEnabled)
+    {
+        reset();
+    }
+    mEnabled = enabled;
+    mHorizon = llclamp(horizon, 0.f, 5.f);
+    mBlend = llclamp(blend, 0.f, 1.f);
+}
+
+void FSCameraPredictor::reset()
+{
+    mActive = false;
+    mHasSample = false;
+    mVelocity.clear();
+    mAngularVelocity.clear();
+}
+
+void FSCameraPredictor::update(const LLVector3& origin, const LLVector3& at_axis, F64 time)
+{
+    if (!mEnabled)
+    {
+        mActive = false;
+        mPredictedOrigin = origin;
+        mPredictedAtAxis = at_axis;
+        return;
+    }
+
+    const F32 dt = (F32)(time - mLastTime);
+    if (mHasSample && dt <= 0.f)
+    {
+        // Same frame, camera updated twice
+        return;
+    }
+
+    LLVector3 delta = origin - mLastOrigin;
+    if (!mHasSample || dt > MAX_SAMPLE_GAP || delta.length() > TELEPORT_DISTANCE)
+    {
+        reset();
+        mHasSample = true;
+        mLastTime = time;
+        mLastOrigin = origin;
+        mLastAtAxis = at_axis;
+        mPredictedOrigin = origin;
+        mPredictedAtAxis = at_axis;
+        return;
+    }
+
+    LLVector3 velocity = delta / dt;
+
+    LLVector3 angular_velocity;
+    LLVector3 turn_axis = mLastAtAxis % at_axis;
+    F32 sin_angle = turn_axis.normVec();
+    if (sin_angle > F_APPROXIMATELY_ZERO)
+    {
+        F32 angle = atan2f(sin_angle, mLastAtAxis * at_axis);
+        angular_velocity = turn_axis * (angle / dt);
+    }
+
+    const F32 alpha = 1.f - expf(-dt / SMOOTHING_TIME);
+    mVelocity = lerp(mVelocity, velocity, alpha);
+    mAngularVelocity = lerp(mAngularVelocity, angular_velocity, alpha);
+
+    mLastTime = time;
+    mLastOrigin = origin;
+    mLastAtAxis = at_axis;
+
+    mPredictedOrigin = origin + mVelocity * mHorizon;
+
+    LLVector3 axis = mAngularVelocity;
+    F32 angular_speed = axis.normVec();
+    F32 turn = llmin(angular_speed * mHorizon, MAX_PREDICTED_TURN);
+    if (turn > F_APPROXIMATELY_ZERO)
+    {
+        mPredictedAtAxis = at_axis * LLQuaternion(turn, axis);
+        mPredictedAtAxis.normVec();
+    }
+    else
+    {
+        mPredictedAtAxis = at_axis;
+    }
+
+    mActive = mHorizon > 0.f && mBlend > 0.f &&
+              (mVelocity.length() > MIN_ACTIVE_SPEED || angular_speed > MIN_ACTIVE_ANGULAR_SPEED);
+}
+
+F32 FSCameraPredictor::getBlendedDistance(const LLVector3& pos, F32 current_distance) const
+{
+    if (!mActive)
+    {
+        return current_distance;
+    }
+
+    F32 future_distance = dist_vec(pos, mPredictedOrigin);
+    if (future_distance >= current_distance)
+    {
+        return current_distance;
+    }
+    return current_distance - mBlend * (current_distance - future_distance);
+}
+
+bool FSCameraPredictor::getFutureView(const LLVector3& pos, F32& distance, F32& cos_angle_to_view_dir) const
+{
+    if (!mActive)
+    {
+        return false;
+    }
+
+    LLVector3 look_at = pos - mPredictedOrigin;
+    distance = look_at.normVec();
+    cos_angle_to_view_dir = look_at * mPredictedAtAxis;
+    return true;
+}
+
+F32 FSCameraPredictor::blendWithFuture(F32 current, F32 future) const
+{
+    if (!mActive)
+    {
+        return current;
+    }
+    return llmax(current, mBlend * future);
+}
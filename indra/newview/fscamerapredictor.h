@@ -0,0 +1,90 @@
+/**
+ * @file fscamerapredictor.h
+ * @brief Camera trajectory prediction for detail and fetch priorities
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_CAMERAPREDICTOR_H
+#define FS_CAMERAPREDICTOR_H
+
+#include "v3math.h"
+
+// Tracks smoothed linear and angular velocity of the camera and extrapolates
+// where it will be a short horizon ahead. Mesh LOD, texture virtual size and
+// object cache promotion blend the importance of things seen from that
+// future camera into their current importance, so detail is requested while
+// objects are still coming into view instead of after they popped in.
+//
+// The blend only ever raises importance; a parked camera behaves exactly as
+// before. Everything here is plain math so it can be driven from recorded
+// camera paths in tests.
+class FSCameraPredictor
+{
+public:
+    FSCameraPredictor();
+
+    void setParameters(bool enabled, F32 horizon, F32 blend);
+    void reset();
+
+    // Feed one camera sample per frame (agent space, time in seconds)
+    void update(const LLVector3& origin, const LLVector3& at_axis, F64 time);
+
+    // True if prediction is enabled and the camera moves enough to matter
+    bool isActive() const { return mActive; }
+    F32 getBlend() const { return mBlend; }
+
+    const LLVector3& getVelocity() const { return mVelocity; }
+    const LLVector3& getAngularVelocity() const { return mAngularVelocity; }
+    const LLVector3& getPredictedOrigin() const { return mPredictedOrigin; }
+    const LLVector3& getPredictedAtAxis() const { return mPredictedAtAxis; }
+
+    // Distance to use for detail decisions; never farther than current_distance
+    F32 getBlendedDistance(const LLVector3& pos, F32 current_distance) const;
+
+    // Distance and cosine of the angle to the view direction of pos as seen
+    // from the predicted camera. Returns false if prediction is inactive.
+    bool getFutureView(const LLVector3& pos, F32& distance, F32& cos_angle_to_view_dir) const;
+
+    // Blends a current importance or pixel area with the one seen from the
+    // predicted camera; the result is never lower than current
+    F32 blendWithFuture(F32 current, F32 future) const;
+
+private:
+    bool        mEnabled;
+    bool        mActive;
+    bool        mHasSample;
+    F32         mHorizon;
+    F32         mBlend;
+    F64         mLastTime;
+    LLVector3   mLastOrigin;
+    LLVector3   mLastAtAxis;
+    LLVector3   mVelocity;          // meters per second
+    LLVector3   mAngularVelocity;   // axis scaled by radians per second
+    LLVector3   mPredictedOrigin;
+    LLVector3   mPredictedAtAxis;
+};
+
+extern FSCameraPredictor gCameraPredictor;
+
+#endif // FS_CAMERAPREDICTOR_H
@@ -260,7 +260,7 @@ FSDiscordConnect::FSDiscordConnect()
     mConnectTime(0)
 {
     mMarkerFilename = gDirUtilp->getExpandedFilename(LL_PATH_USER_SETTINGS, "discord_in_use_marker");
-    LLEventPumps::instance().obtain("mainloop").listen("FSDiscordConnect", std::bind(&FSDiscordConnect::Tick, this, std::placeholders::_1));
+    mMainloopConnection = fs_mainloop_channel().listen(std::bind(&FSDiscordConnect::Tick, this, std::placeholders::_1));
 }
 
 FSDiscordConnect::~FSDiscordConnect()
@@ -288,7 +288,7 @@ void FSDiscordConnect::checkConnectionToDiscord(bool auto_connect)
         std::bind(&FSDiscordConnect::discordConnectedCoro, this, auto_connect));
 }
 
-bool FSDiscordConnect::Tick(const LLSD&)
+bool FSDiscordConnect::Tick(const FSMainloopEvent&)
 {
     Discord_RunCallbacks();
     updateRichPresence();
@@ -31,6 +31,7 @@
 #include "llsingleton.h"
 #include "llcoros.h"
 #include "lleventcoro.h"
+#include "fseventchannel.h"
 
 class LLEventPump;
 
@@ -65,7 +66,7 @@ public:
 
     void updateRichPresence() const;
 
-    bool Tick(const LLSD&);
+    bool Tick(const FSMainloopEvent&);
 
 private:
 
@@ -73,6 +74,7 @@ private:
     bool mConnected;
     LLSD mInfo;
     bool mRefreshInfo;
+    FSScopedEventConnection mMainloopConnection;
 
     static std::unique_ptr<LLEventPump> sStateWatcher;
     static std::unique_ptr<LLEventPump> sInfoWatcher;
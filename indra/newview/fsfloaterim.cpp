@@ -37,6 +37,7 @@
 #include "fsdata.h"
 #include "fsfloaterimcontainer.h" // to replace separate IM Floaters with multifloater container
 #include "fsfloaternearbychat.h"
+#include "fsimpipeline.h"
 #include "fsnearbychathub.h"    // <FS:Zi> FIRE-24133 - Redirect chat channel messages
 #include "fspanelimcontrolpanel.h"
 #include "llagent.h"
@@ -45,6 +46,7 @@
 #include "llavataractions.h"
 #include "llavatarnamecache.h"
 #include "llbutton.h"
+#include "llcallbacklist.h"
 #include "llchannelmanager.h"
 #include "llchatentry.h"
 #include "llcheckboxctrl.h"
@@ -321,6 +323,26 @@ void FSFloaterIM::snooze(S32 duration /*= -1*/)
     LLFloater::onClickCloseBtn();
 }
 
+// <FS> Sessions with new messages to show, updated once per frame
+static FSIMUpdateCoalescer sPendingIMUpdates;
+static const F64 IM_PIPELINE_REPORT_INTERVAL = 300.0;
+
+/* static */
+void FSFloaterIM::flushPendingUpdates()
+{
+    sPendingIMUpdates.flush([](const LLUUID& session_id, F64 first_queued)
+    {
+        FSFloaterIM* floater = LLFloaterReg::findTypedInstance<FSFloaterIM>("fs_impanel", session_id);
+        if (floater)
+        {
+            floater->updateMessages();
+            gIMStageStats.record(FSIM_STAGE_UI, LLTimer::getTotalSeconds() - first_queued);
+        }
+    });
+    gIMStageStats.reportIfDue(LLTimer::getTotalSeconds(), IM_PIPELINE_REPORT_INTERVAL);
+}
+// </FS>
+
 /* static */
 void FSFloaterIM::newIMCallback(const LLSD& data){
 
@@ -337,7 +359,14 @@ void FSFloaterIM::newIMCallback(const LLSD& data){
         floater->mPendingMessages++;
         if (floater->getVisible() || floater->mPendingMessages > fsMaxPendingIMMessages)
         {
-            floater->updateMessages();
+            // <FS> A burst of messages updates the floater once
+            //floater->updateMessages();
+            if (sPendingIMUpdates.empty())
+            {
+                doOnIdleOneTime(&FSFloaterIM::flushPendingUpdates);
+            }
+            sPendingIMUpdates.add(session_id, gIMStageStats.getMessageArrival(LLTimer::getTotalSeconds()));
+            // </FS>
         }
     }
 }
@@ -100,6 +100,7 @@ public:
     // callback for LLIMModel on new messages
     // route to specific floater if it is visible
     static void newIMCallback(const LLSD& data);
+    static void flushPendingUpdates(); // <FS/> One update per session per frame
 
     //AO: Callbacks for voice handling formerly in llPanelImControlPanel
     void onVoiceChannelStateChanged(const LLVoiceChannel::EState& old_state, const LLVoiceChannel::EState& new_state);
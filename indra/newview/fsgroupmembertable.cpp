@@ -0,0 +1,387 @@
+/**
+ * @file fsgroupmembertable.cpp
+ * @brief Columnar storage and sorted views of group member data
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsgroupmembertable.h"
+
+#include "llsd.h"
+#include "u64.h"
+
+#include <algorithm>
+
+FSGroupMemberTable::FSGroupMemberTable()
+{
+}
+
+void FSGroupMemberTable::clear()
+{
+    FSGroupMemberTable empty;
+    swap(empty);
+}
+
+void FSGroupMemberTable::reserve(U32 members)
+{
+    mIDs.reserve(members);
+    mContributions.reserve(members);
+    mPowers.reserve(members);
+    mTitleIndices.reserve(members);
+    mStatusIndices.reserve(members);
+    mLastLogins.reserve(members);
+    mOwners.reserve(members);
+    mRows.reserve(members);
+}
+
+void FSGroupMemberTable::swap(FSGroupMemberTable& other)
+{
+    mIDs.swap(other.mIDs);
+    mContributions.swap(other.mContributions);
+    mPowers.swap(other.mPowers);
+    mTitleIndices.swap(other.mTitleIndices);
+    mStatusIndices.swap(other.mStatusIndices);
+    mLastLogins.swap(other.mLastLogins);
+    mOwners.swap(other.mOwners);
+    mTitles.swap(other.mTitles);
+    mTitleIndex.swap(other.mTitleIndex);
+    mStatuses.swap(other.mStatuses);
+    mStatusIndex.swap(other.mStatusIndex);
+    mRows.swap(other.mRows);
+    for (S32 i = 0; i < COL_COUNT; i++)
+    {
+        mViews[i].mRows.swap(other.mViews[i].mRows);
+        std::swap(mViews[i].mSortedCount, other.mViews[i].mSortedCount);
+    }
+}
+
+// static
+U32 FSGroupMemberTable::intern(std::vector<std::string>& strings, string_index_t& index, const std::string& value)
+{
+    string_index_t::const_iterator it = index.find(value);
+    if (it != index.end())
+    {
+        return it->second;
+    }
+    U32 idx = (U32)strings.size();
+    strings.push_back(value);
+    index.emplace(value, idx);
+    return idx;
+}
+
+U32 FSGroupMemberTable::setMember(const LLUUID& id, S32 contribution, U64 powers, const std::string& title,
+                                  const std::string& status, U32 last_login, bool is_owner)
+{
+    const U32 title_idx = intern(mTitles, mTitleIndex, title);
+    const U32 status_idx = intern(mStatuses, mStatusIndex, status);
+
+    std::unordered_map<LLUUID, U32>::const_iterator it = mRows.find(id);
+    if (it != mRows.end())
+    {
+        const U32 row = it->second;
+        mContributions[row] = contribution;
+        mPowers[row] = powers;
+        mTitleIndices[row] = title_idx;
+        mStatusIndices[row] = status_idx;
+        mLastLogins[row] = last_login;
+        mOwners[row] = is_owner ? 1 : 0;
+        // The member may sort somewhere else now
+        invalidateViews();
+        return row;
+    }
+
+    const U32 row = (U32)mIDs.size();
+    mIDs.push_back(id);
+    mContributions.push_back(contribution);
+    mPowers.push_back(powers);
+    mTitleIndices.push_back(title_idx);
+    mStatusIndices.push_back(status_idx);
+    mLastLogins.push_back(last_login);
+    mOwners.push_back(is_owner ? 1 : 0);
+    mRows.emplace(id, row);
+    return row;
+}
+
+void FSGroupMemberTable::removeMember(const LLUUID& id)
+{
+    std::unordered_map<LLUUID, U32>::iterator it = mRows.find(id);
+    if (it == mRows.end())
+    {
+        return;
+    }
+
+    // Move the last member into the gap
+    const U32 row = it->second;
+    const U32 last = (U32)mIDs.size() - 1;
+    mRows.erase(it);
+    if (row != last)
+    {
+        mIDs[row] = mIDs[last];
+        mContributions[row] = mContributions[last];
+        mPowers[row] = mPowers[last];
+        mTitleIndices[row] = mTitleIndices[last];
+        mStatusIndices[row] = mStatusIndices[last];
+        mLastLogins[row] = mLastLogins[last];
+        mOwners[row] = mOwners[last];
+        mRows[mIDs[row]] = row;
+    }
+    mIDs.pop_back();
+    mContributions.pop_back();
+    mPowers.pop_back();
+    mTitleIndices.pop_back();
+    mStatusIndices.pop_back();
+    mLastLogins.pop_back();
+    mOwners.pop_back();
+    invalidateViews();
+}
+
+U32 FSGroupMemberTable::findRow(const LLUUID& id) const
+{
+    std::unordered_map<LLUUID, U32>::const_iterator it = mRows.find(id);
+    return it != mRows.end() ? it->second : NO_ROW;
+}
+
+void FSGroupMemberTable::formatStatuses(const boost::function<void (std::string&)>& format)
+{
+    mStatusIndex.clear();
+    for (U32 i = 0; i < (U32)mStatuses.size(); i++)
+    {
+        format(mStatuses[i]);
+        // Different raw strings may format the same, later ones still point
+        // at their own copy
+        mStatusIndex.emplace(mStatuses[i], i);
+    }
+}
+
+void FSGroupMemberTable::invalidateViews()
+{
+    for (S32 i = 0; i < COL_COUNT; i++)
+    {
+        mViews[i].mRows.clear();
+        mViews[i].mSortedCount = 0;
+    }
+}
+
+bool FSGroupMemberTable::lessThan(EColumn column, U32 a, U32 b) const
+{
+    switch (column)
+    {
+    case COL_CONTRIBUTION:
+        if (mContributions[a] != mContributions[b])
+        {
+            return mContributions[a] < mContributions[b];
+        }
+        break;
+    case COL_LAST_LOGIN:
+        if (mLastLogins[a] != mLastLogins[b])
+        {
+            return mLastLogins[a] < mLastLogins[b];
+        }
+        break;
+    case COL_TITLE:
+        if (mTitleIndices[a] != mTitleIndices[b])
+        {
+            return mTitles[mTitleIndices[a]] < mTitles[mTitleIndices[b]];
+        }
+        break;
+    default:
+        break;
+    }
+    // Ties keep the order members arrived in
+    return a < b;
+}
+
+const std::vector<U32>& FSGroupMemberTable::getSortedRows(EColumn column) const
+{
+    SortedView& view = mViews[column];
+    const U32 count = size();
+    if (view.mSortedCount < count)
+    {
+        const size_t sorted = view.mRows.size();
+        view.mRows.reserve(count);
+        for (U32 row = view.mSortedCount; row < count; row++)
+        {
+            view.mRows.push_back(row);
+        }
+
+        auto less = [this, column](U32 a, U32 b) { return lessThan(column, a, b); };
+        std::sort(view.mRows.begin() + sorted, view.mRows.end(), less);
+        std::inplace_merge(view.mRows.begin(), view.mRows.begin() + sorted, view.mRows.end(), less);
+        view.mSortedCount = count;
+    }
+    return view.mRows;
+}
+
+U32 FSGroupMemberTable::getPage(EColumn column, bool ascending, U32 first, U32 count, std::vector<U32>& rows) const
+{
+    const std::vector<U32>& sorted = getSortedRows(column);
+    const U32 total = (U32)sorted.size();
+    if (first >= total)
+    {
+        return 0;
+    }
+
+    const U32 copied = llmin(count, total - first);
+    for (U32 i = 0; i < copied; i++)
+    {
+        rows.push_back(ascending ? sorted[first + i] : sorted[total - 1 - first - i]);
+    }
+    return copied;
+}
+
+void FSGroupMemberTable::addCapabilityMembers(const LLSD& members, const LLSD& titles, U64 default_powers)
+{
+    reserve(size() + (U32)members.size());
+
+    const std::string unknown_status("unknown");
+    const std::string default_title = titles[0].asString();
+
+    // Titles arrive as indices into the titles array, look each one up once
+    std::vector<U32> title_indices;
+    title_indices.reserve(titles.size());
+    for (LLSD::array_const_iterator it = titles.beginArray(); it != titles.endArray(); ++it)
+    {
+        title_indices.push_back(intern(mTitles, mTitleIndex, it->asString()));
+    }
+    const U32 default_title_idx = intern(mTitles, mTitleIndex, default_title);
+    const U32 unknown_status_idx = intern(mStatuses, mStatusIndex, unknown_status);
+
+    for (LLSD::map_const_iterator it = members.beginMap(); it != members.endMap(); ++it)
+    {
+        const LLUUID member_id(it->first);
+        const LLSD& member_info = it->second;
+
+        U32 status_idx = unknown_status_idx;
+        U32 last_login = 0;
+        if (member_info.has("last_login"))
+        {
+            const std::string status = member_info["last_login"].asString();
+            status_idx = intern(mStatuses, mStatusIndex, status);
+            last_login = lastLoginKey(status);
+        }
+
+        U32 title_idx = default_title_idx;
+        if (member_info.has("title"))
+        {
+            S32 title = member_info["title"].asInteger();
+            title_idx = (title >= 0 && title < (S32)title_indices.size())
+                ? title_indices[title] : intern(mTitles, mTitleIndex, std::string());
+        }
+
+        U64 powers = default_powers;
+        if (member_info.has("powers"))
+        {
+            powers = llstrtou64(member_info["powers"].asString().c_str(), NULL, 16);
+        }
+
+        S32 contribution = 0;
+        if (member_info.has("donated_square_meters"))
+        {
+            contribution = member_info["donated_square_meters"].asInteger();
+        }
+
+        const bool is_owner = member_info.has("owner");
+
+        std::unordered_map<LLUUID, U32>::const_iterator row_it = mRows.find(member_id);
+        if (row_it != mRows.end())
+        {
+            // Listed twice, last one wins like it did in the member map
+            const U32 row = row_it->second;
+            mContributions[row] = contribution;
+            mPowers[row] = powers;
+            mTitleIndices[row] = title_idx;
+            mStatusIndices[row] = status_idx;
+            mLastLogins[row] = last_login;
+            mOwners[row] = is_owner ? 1 : 0;
+            invalidateViews();
+            continue;
+        }
+
+        mRows.emplace(member_id, (U32)mIDs.size());
+        mIDs.push_back(member_id);
+        mContributions.push_back(contribution);
+        mPowers.push_back(powers);
+        mTitleIndices.push_back(title_idx);
+        mStatusIndices.push_back(status_idx);
+        mLastLogins.push_back(last_login);
+        mOwners.push_back(is_owner ? 1 : 0);
+    }
+}
+
+// static
+U32 FSGroupMemberTable::lastLoginKey(const std::string& status)
+{
+    if (status == "Online")
+    {
+        return LOGIN_ONLINE;
+    }
+
+    U32 parts[3] = { 0, 0, 0 };
+    S32 digits[3] = { 0, 0, 0 };
+    S32 part = 0;
+    for (std::string::const_iterator it = status.begin(); it != status.end(); ++it)
+    {
+        if (*it >= '0' && *it <= '9')
+        {
+            parts[part] = parts[part] * 10 + (*it - '0');
+            if (++digits[part] > 4)
+            {
+                return 0;
+            }
+        }
+        else if (*it == '/' && part < 2 && digits[part] > 0)
+        {
+            ++part;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    if (part != 2 || digits[2] == 0)
+    {
+        return 0;
+    }
+
+    // MM/DD/YYYY from the servers, YYYY/MM/DD once formatted
+    U32 year, month, day;
+    if (digits[0] == 4)
+    {
+        year = parts[0];
+        month = parts[1];
+        day = parts[2];
+    }
+    else
+    {
+        month = parts[0];
+        day = parts[1];
+        year = parts[2];
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31)
+    {
+        return 0;
+    }
+    return year * 10000 + month * 100 + day;
+}
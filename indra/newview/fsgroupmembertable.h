@@ -0,0 +1,139 @@
+/**
+ * @file fsgroupmembertable.h
+ * @brief Columnar storage and sorted views of group member data
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_GROUPMEMBERTABLE_H
+#define FS_GROUPMEMBERTABLE_H
+
+#include "lluuid.h"
+
+#include <boost/function.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class LLSD;
+
+// Member data of one group, one column per field. Titles and online status
+// strings repeat a lot in large groups and are kept once each, so a 50k
+// member group costs a few vectors instead of 50k heap objects, and the
+// status strings only have to be formatted once per distinct value.
+//
+// Sorted views of the columns are kept per column and brought up to date
+// when asked for: members added since are sorted on their own and merged
+// in, so streaming in more members never resorts the whole group.
+class FSGroupMemberTable
+{
+public:
+    enum EColumn
+    {
+        COL_CONTRIBUTION = 0,
+        COL_LAST_LOGIN,     // online members last, so descending puts them first
+        COL_TITLE,
+        COL_COUNT
+    };
+
+    static constexpr U32 NO_ROW = 0xFFFFFFFF;
+    static constexpr U32 LOGIN_ONLINE = 0xFFFFFFFF;
+
+    FSGroupMemberTable();
+
+    void clear();
+    void reserve(U32 members);
+    void swap(FSGroupMemberTable& other);
+
+    U32 size() const { return (U32)mIDs.size(); }
+    bool empty() const { return mIDs.empty(); }
+
+    // Adds a member or replaces the data of a known one, returns its row
+    U32 setMember(const LLUUID& id, S32 contribution, U64 powers, const std::string& title,
+                  const std::string& status, U32 last_login, bool is_owner);
+    // Rows of other members may move
+    void removeMember(const LLUUID& id);
+    U32 findRow(const LLUUID& id) const;
+
+    const LLUUID& getID(U32 row) const { return mIDs[row]; }
+    S32 getContribution(U32 row) const { return mContributions[row]; }
+    U64 getPowers(U32 row) const { return mPowers[row]; }
+    const std::string& getTitle(U32 row) const { return mTitles[mTitleIndices[row]]; }
+    const std::string& getStatus(U32 row) const { return mStatuses[mStatusIndices[row]]; }
+    U32 getLastLogin(U32 row) const { return mLastLogins[row]; }
+    bool isOwner(U32 row) const { return mOwners[row] != 0; }
+
+    U32 getTitleCount() const { return (U32)mTitles.size(); }
+    U32 getStatusCount() const { return (U32)mStatuses.size(); }
+
+    // Rewrites every distinct online status string once
+    void formatStatuses(const boost::function<void (std::string&)>& format);
+
+    // Rows in ascending order of column
+    const std::vector<U32>& getSortedRows(EColumn column) const;
+
+    // Copies up to count rows in column order, starting count rows from the
+    // first (or last when descending). Returns the number of rows copied.
+    U32 getPage(EColumn column, bool ascending, U32 first, U32 count, std::vector<U32>& rows) const;
+
+    // Unpacks the "members" map of a GroupMemberData capability response.
+    // Touches nothing but this table, safe on a worker thread.
+    void addCapabilityMembers(const LLSD& members, const LLSD& titles, U64 default_powers);
+
+    // Sort key of an online status: LOGIN_ONLINE for "Online", YYYYMMDD for
+    // MM/DD/YYYY or YYYY/MM/DD dates, 0 for anything else
+    static U32 lastLoginKey(const std::string& status);
+
+private:
+    typedef std::unordered_map<std::string, U32> string_index_t;
+
+    static U32 intern(std::vector<std::string>& strings, string_index_t& index, const std::string& value);
+    bool lessThan(EColumn column, U32 a, U32 b) const;
+    void invalidateViews();
+
+    std::vector<LLUUID>         mIDs;
+    std::vector<S32>            mContributions;
+    std::vector<U64>            mPowers;
+    std::vector<U32>            mTitleIndices;
+    std::vector<U32>            mStatusIndices;
+    std::vector<U32>            mLastLogins;
+    std::vector<U8>             mOwners;
+
+    std::vector<std::string>    mTitles;
+    string_index_t              mTitleIndex;
+    std::vector<std::string>    mStatuses;
+    string_index_t              mStatusIndex;
+
+    std::unordered_map<LLUUID, U32> mRows;
+
+    struct SortedView
+    {
+        SortedView() : mSortedCount(0) {}
+
+        std::vector<U32>    mRows;
+        U32                 mSortedCount;   // rows below this are in mRows
+    };
+    mutable SortedView          mViews[COL_COUNT];
+};
+
+#endif // FS_GROUPMEMBERTABLE_H
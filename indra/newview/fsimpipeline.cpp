@@ -0,0 +1,274 @@
+/**
+ * @file fsimpipeline.cpp
+ * @brief Instant message intake: transcript writer, update coalescing and stage latency
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsimpipeline.h"
+
+#include "llfile.h"
+#include "lltimer.h"
+
+#include <sstream>
+#include <unordered_map>
+
+FSIMStageStats gIMStageStats;
+
+static const F64 FIRST_BUCKET_SECONDS = 0.000001;
+
+const char* fs_im_stage_name(S32 stage)
+{
+    switch (stage)
+    {
+    case FSIM_STAGE_INTAKE:     return "intake";
+    case FSIM_STAGE_FILTER:     return "filter";
+    case FSIM_STAGE_TRANSCRIPT: return "transcript";
+    case FSIM_STAGE_UI:         return "ui";
+    default:                    return "unknown";
+    }
+}
+
+FSIMStageStats::FSIMStageStats()
+:   mReportedCount(0),
+    mLastReport(0.0),
+    mMessageArrival(0.0)
+{
+    reset();
+}
+
+void FSIMStageStats::reset()
+{
+    memset(mStages, 0, sizeof(mStages));
+    mReportedCount = 0;
+}
+
+void FSIMStageStats::record(S32 stage, F64 seconds)
+{
+    if (stage < 0 || stage >= FSIM_STAGE_COUNT)
+    {
+        return;
+    }
+
+    Stage& s = mStages[stage];
+    seconds = llmax(seconds, 0.0);
+    ++s.mCount;
+    s.mTotal += seconds;
+    s.mMax = llmax(s.mMax, seconds);
+
+    S32 bucket = 0;
+    F64 bound = FIRST_BUCKET_SECONDS;
+    while (seconds > bound && bucket < BUCKET_COUNT - 1)
+    {
+        bound *= 2.0;
+        ++bucket;
+    }
+    ++s.mBuckets[bucket];
+}
+
+F64 FSIMStageStats::getMean(S32 stage) const
+{
+    const Stage& s = mStages[stage];
+    return s.mCount ? s.mTotal / (F64)s.mCount : 0.0;
+}
+
+F64 FSIMStageStats::getPercentile(S32 stage, F32 fraction) const
+{
+    const Stage& s = mStages[stage];
+    if (!s.mCount)
+    {
+        return 0.0;
+    }
+
+    const U32 wanted = llmax((U32)1, (U32)ceil(llclamp((F64)fraction, 0.0, 1.0) * (F64)s.mCount - 0.001));
+    U32 seen = 0;
+    F64 bound = FIRST_BUCKET_SECONDS;
+    for (S32 bucket = 0; bucket < BUCKET_COUNT; ++bucket, bound *= 2.0)
+    {
+        seen += s.mBuckets[bucket];
+        if (seen >= wanted)
+        {
+            // The last bucket is open ended
+            return bucket == BUCKET_COUNT - 1 ? s.mMax : llmin(bound, s.mMax);
+        }
+    }
+    return s.mMax;
+}
+
+std::string FSIMStageStats::getSummary() const
+{
+    std::ostringstream summary;
+    summary.precision(3);
+    summary << std::fixed;
+    for (S32 stage = 0; stage < FSIM_STAGE_COUNT; ++stage)
+    {
+        if (stage)
+        {
+            summary << ", ";
+        }
+        summary << fs_im_stage_name(stage) << " " << getCount(stage) << " x mean " << getMean(stage) * 1000.0
+                << " ms p99 " << getPercentile(stage, 0.99f) * 1000.0 << " ms max " << getMax(stage) * 1000.0 << " ms";
+    }
+    return summary.str();
+}
+
+void FSIMStageStats::reportIfDue(F64 now, F64 interval)
+{
+    const U32 count = getCount(FSIM_STAGE_INTAKE);
+    if (count == mReportedCount || now - mLastReport < interval)
+    {
+        return;
+    }
+    mReportedCount = count;
+    mLastReport = now;
+    LL_INFOS("IMPipeline") << "IM pipeline latency: " << getSummary() << LL_ENDL;
+}
+
+FSIMStageTimer::FSIMStageTimer(S32 stage, bool track)
+:   mStage(stage),
+    mTrack(track),
+    mStart(track ? (F64)LLTimer::getTotalSeconds() : 0.0)
+{
+    if (mTrack && mStage == FSIM_STAGE_INTAKE)
+    {
+        gIMStageStats.setMessageArrival(mStart);
+    }
+}
+
+FSIMStageTimer::~FSIMStageTimer()
+{
+    if (!mTrack)
+    {
+        return;
+    }
+    gIMStageStats.record(mStage, LLTimer::getTotalSeconds() - mStart);
+    if (mStage == FSIM_STAGE_INTAKE)
+    {
+        gIMStageStats.setMessageArrival(0.0);
+    }
+}
+
+bool FSIMUpdateCoalescer::add(const LLUUID& session_id, F64 now)
+{
+    for (std::vector<std::pair<LLUUID, F64> >::const_iterator it = mPending.begin(); it != mPending.end(); ++it)
+    {
+        if (it->first == session_id)
+        {
+            return false;
+        }
+    }
+    mPending.push_back(std::make_pair(session_id, now));
+    return true;
+}
+
+U32 FSIMUpdateCoalescer::flush(const flush_func_t& func)
+{
+    std::vector<std::pair<LLUUID, F64> > pending;
+    pending.swap(mPending);
+    for (std::vector<std::pair<LLUUID, F64> >::const_iterator it = pending.begin(); it != pending.end(); ++it)
+    {
+        func(it->first, it->second);
+    }
+    return (U32)pending.size();
+}
+
+FSTranscriptWriter::FSTranscriptWriter()
+:   mFailedOpens(0)
+{
+}
+
+FSTranscriptWriter::~FSTranscriptWriter()
+{
+    drain();
+}
+
+void FSTranscriptWriter::queue(const std::string& path, const std::string& line, F64 queued_at)
+{
+    Line entry;
+    entry.mPath = path;
+    entry.mText = line;
+    entry.mQueued = queued_at;
+
+    LLMutexLock lock(&mQueueMutex);
+    mPending.push_back(entry);
+}
+
+bool FSTranscriptWriter::hasPending() const
+{
+    LLMutexLock lock(&mQueueMutex);
+    return !mPending.empty();
+}
+
+U32 FSTranscriptWriter::drain(F64* oldest_queued)
+{
+    LLMutexLock write_lock(&mWriteMutex);
+
+    std::vector<Line> lines;
+    {
+        LLMutexLock lock(&mQueueMutex);
+        lines.swap(mPending);
+    }
+    if (lines.empty())
+    {
+        return 0;
+    }
+    if (oldest_queued)
+    {
+        *oldest_queued = lines.front().mQueued;
+    }
+
+    // Group the lines by file, keeping their order within each file
+    std::vector<std::string> paths;
+    std::unordered_map<std::string, std::vector<U32> > lines_by_path;
+    for (U32 i = 0; i < (U32)lines.size(); ++i)
+    {
+        std::vector<U32>& indices = lines_by_path[lines[i].mPath];
+        if (indices.empty())
+        {
+            paths.push_back(lines[i].mPath);
+        }
+        indices.push_back(i);
+    }
+
+    U32 written = 0;
+    for (std::vector<std::string>::const_iterator path_it = paths.begin(); path_it != paths.end(); ++path_it)
+    {
+        const std::vector<U32>& indices = lines_by_path[*path_it];
+        llofstream file(path_it->c_str(), std::ios_base::app);
+        if (!file.is_open())
+        {
+            LL_WARNS() << "Couldn't open chat history log! - " << *path_it << LL_ENDL;
+            ++mFailedOpens;
+            continue;
+        }
+        for (std::vector<U32>::const_iterator it = indices.begin(); it != indices.end(); ++it)
+        {
+            file << lines[*it].mText << '\n';
+        }
+        file.close();
+        written += (U32)indices.size();
+    }
+    return written;
+}
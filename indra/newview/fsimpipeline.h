@@ -0,0 +1,163 @@
+/**
+ * @file fsimpipeline.h
+ * @brief Instant message intake: transcript writer, update coalescing and stage latency
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_IMPIPELINE_H
+#define FS_IMPIPELINE_H
+
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <boost/function.hpp>
+#include <string>
+#include <vector>
+
+// Stages of incoming IM and group chat handling whose latency is tracked
+enum EFSIMStage
+{
+    FSIM_STAGE_INTAKE = 0,      // processNewMessage() on the main thread
+    FSIM_STAGE_FILTER,          // keyword alert matching
+    FSIM_STAGE_TRANSCRIPT,      // queued until written to the transcript file
+    FSIM_STAGE_UI,              // arrived until shown in its session floater
+    FSIM_STAGE_COUNT
+};
+
+const char* fs_im_stage_name(S32 stage);
+
+// Latency per stage: count, mean, maximum and a log2 histogram for
+// percentiles. Only touched on the main thread.
+class FSIMStageStats
+{
+public:
+    FSIMStageStats();
+
+    void reset();
+    void record(S32 stage, F64 seconds);
+
+    U32 getCount(S32 stage) const { return mStages[stage].mCount; }
+    F64 getMean(S32 stage) const;
+    F64 getMax(S32 stage) const { return mStages[stage].mMax; }
+    // Upper bound of the histogram bucket that holds the given fraction of
+    // the samples, in seconds
+    F64 getPercentile(S32 stage, F32 fraction) const;
+
+    std::string getSummary() const;
+    // Logs the summary every interval seconds while there are new samples
+    void reportIfDue(F64 now, F64 interval);
+
+    // Arrival time of the message being taken in, or now outside of intake
+    F64 getMessageArrival(F64 now) const { return mMessageArrival > 0.0 ? mMessageArrival : now; }
+    void setMessageArrival(F64 arrival) { mMessageArrival = arrival; }
+
+private:
+    static const S32 BUCKET_COUNT = 24; // 1 microsecond doubling up to 8 seconds
+
+    struct Stage
+    {
+        U32 mCount;
+        F64 mTotal;
+        F64 mMax;
+        U32 mBuckets[BUCKET_COUNT];
+    };
+
+    Stage   mStages[FSIM_STAGE_COUNT];
+    U32     mReportedCount;
+    F64     mLastReport;
+    F64     mMessageArrival;
+};
+
+extern FSIMStageStats gIMStageStats;
+
+// Records the time until it goes out of scope as one sample of a stage in
+// gIMStageStats. An intake timer also marks the arrival of the message for
+// the stages that follow.
+class FSIMStageTimer
+{
+public:
+    FSIMStageTimer(S32 stage, bool track = true);
+    ~FSIMStageTimer();
+
+private:
+    S32     mStage;
+    bool    mTrack;
+    F64     mStart;
+};
+
+// Sessions that got new messages since the last flush, in the order they
+// got their first one. Session floaters update once per flush however many
+// messages arrived in between.
+class FSIMUpdateCoalescer
+{
+public:
+    typedef boost::function<void (const LLUUID& session_id, F64 first_queued)> flush_func_t;
+
+    // Returns true if the session was not pending yet
+    bool add(const LLUUID& session_id, F64 now);
+    bool empty() const { return mPending.empty(); }
+    U32 size() const { return (U32)mPending.size(); }
+
+    // Calls func once per pending session and returns the number of
+    // sessions. Sessions added from inside func wait for the next flush.
+    U32 flush(const flush_func_t& func);
+
+private:
+    std::vector<std::pair<LLUUID, F64> > mPending;
+};
+
+// Appends chat transcript lines in the order they were queued. Lines are
+// formatted by the caller; drain() writes everything queued so far with one
+// open per file and can run on any thread. Concurrent drains are serialized,
+// so lines of a file never overtake each other.
+class FSTranscriptWriter
+{
+public:
+    FSTranscriptWriter();
+    ~FSTranscriptWriter();
+
+    void queue(const std::string& path, const std::string& line, F64 queued_at);
+    bool hasPending() const;
+
+    // Returns the number of lines written; oldest_queued receives the queue
+    // time of the oldest one
+    U32 drain(F64* oldest_queued = NULL);
+
+    U32 getFailedOpens() const { return mFailedOpens; }
+
+private:
+    struct Line
+    {
+        std::string mPath;
+        std::string mText;
+        F64         mQueued;
+    };
+
+    mutable LLMutex     mQueueMutex;
+    std::vector<Line>   mPending;
+    LLMutex             mWriteMutex;    // held for a whole drain
+    U32                 mFailedOpens;
+};
+
+#endif // FS_IMPIPELINE_H
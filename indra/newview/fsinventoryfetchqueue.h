@@ -0,0 +1,198 @@
+/**
+ * @file fsinventoryfetchqueue.h
+ * @brief Priority levels and queue for background inventory fetches
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_INVENTORYFETCHQUEUE_H
+#define FS_INVENTORYFETCHQUEUE_H
+
+#include <boost/function.hpp>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+// Interest levels of background inventory fetches, most urgent first
+enum EFSFetchPriority
+{
+    FSFP_REQUESTED = 0, // folders opened or explicitly requested
+    FSFP_OUTFITS,       // current outfit, outfits and everything below them
+    FSFP_SEARCH,        // folders below the root of an active search
+    FSFP_INVENTORY,     // rest of the agent's inventory
+    FSFP_LIBRARY,       // library
+    FSFP_COUNT
+};
+
+const char* fs_fetch_priority_name(S32 priority);
+
+// Stands in for the deque the background fetch keeps its folders in, with
+// one deque per priority level. front() is always the front of the most
+// urgent non-empty level; push_front() and push_back() keep their meaning
+// within a level, so equally interesting folders are still fetched breadth
+// first. The level of an entry is decided when it is queued.
+template<typename T>
+class FSPriorityFetchQueue
+{
+public:
+    typedef boost::function<S32(const T&)> priority_func_t;
+
+    FSPriorityFetchQueue()
+    :   mSize(0),
+        mLastBackLevel(FSFP_INVENTORY)
+    {
+    }
+
+    void setPriorityFunction(const priority_func_t& func) { mPriorityFunc = func; }
+
+    bool empty() const { return mSize == 0; }
+    size_t size() const { return mSize; }
+    size_t size(S32 priority) const { return mLevels[priority].size(); }
+
+    const T& front() const { return mLevels[frontLevel()].front(); }
+    S32 frontPriority() const { return frontLevel(); }
+
+    // Most recently push_back()'ed entry if it is still queued
+    const T& back() const
+    {
+        return mLevels[mLevels[mLastBackLevel].empty() ? backLevel() : mLastBackLevel].back();
+    }
+
+    void pop_front()
+    {
+        mLevels[frontLevel()].pop_front();
+        --mSize;
+    }
+
+    void push_front(const T& entry)
+    {
+        mLevels[getPriority(entry)].push_front(entry);
+        ++mSize;
+    }
+
+    void push_back(const T& entry)
+    {
+        mLastBackLevel = getPriority(entry);
+        mLevels[mLastBackLevel].push_back(entry);
+        ++mSize;
+    }
+
+    // Moves up to max_count entries matching pred from the most urgent level
+    // into out, looking at no more than max_scan entries from its front.
+    template<typename PRED>
+    void takeMatching(PRED pred, size_t max_scan, size_t max_count, std::vector<T>& out)
+    {
+        if (empty())
+        {
+            return;
+        }
+        std::deque<T>& level = mLevels[frontLevel()];
+        size_t scanned = 0;
+        size_t taken = 0;
+        typename std::deque<T>::iterator it = level.begin();
+        while (it != level.end() && scanned < max_scan && taken < max_count)
+        {
+            ++scanned;
+            if (pred(*it))
+            {
+                out.push_back(*it);
+                it = level.erase(it);
+                --mSize;
+                ++taken;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    // True if any entry on any level matches pred
+    template<typename PRED>
+    bool containsMatching(PRED pred) const
+    {
+        for (S32 i = 0; i < FSFP_COUNT; ++i)
+        {
+            if (std::find_if(mLevels[i].begin(), mLevels[i].end(), pred) != mLevels[i].end())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Decides the level of every queued entry again, keeping their order
+    void reprioritize()
+    {
+        std::deque<T> levels[FSFP_COUNT];
+        for (S32 i = 0; i < FSFP_COUNT; ++i)
+        {
+            levels[i].swap(mLevels[i]);
+        }
+        for (S32 i = 0; i < FSFP_COUNT; ++i)
+        {
+            for (typename std::deque<T>::const_iterator it = levels[i].begin(); it != levels[i].end(); ++it)
+            {
+                mLevels[getPriority(*it)].push_back(*it);
+            }
+        }
+    }
+
+private:
+    S32 getPriority(const T& entry) const
+    {
+        S32 priority = mPriorityFunc ? mPriorityFunc(entry) : (S32)FSFP_INVENTORY;
+        return llclamp(priority, 0, FSFP_COUNT - 1);
+    }
+
+    S32 frontLevel() const
+    {
+        for (S32 i = 0; i < FSFP_COUNT; ++i)
+        {
+            if (!mLevels[i].empty())
+            {
+                return i;
+            }
+        }
+        return FSFP_COUNT - 1;
+    }
+
+    S32 backLevel() const
+    {
+        for (S32 i = FSFP_COUNT - 1; i > 0; --i)
+        {
+            if (!mLevels[i].empty())
+            {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    std::deque<T>   mLevels[FSFP_COUNT];
+    size_t          mSize;
+    S32             mLastBackLevel;
+    priority_func_t mPriorityFunc;
+};
+
+#endif // FS_INVENTORYFETCHQUEUE_H
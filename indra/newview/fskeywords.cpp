@@ -27,6 +27,7 @@
 #include "llviewerprecompiledheaders.h"
 
 #include "fscommon.h"
+#include "fsimpipeline.h"
 #include "fskeywords.h"
 #include "growlmanager.h"
 #include "llagent.h"
@@ -75,6 +76,32 @@ void FSKeywords::updateKeywords()
             mWordList.push_back(token);
         }
     }
+
+    // <FS> Compile the whole word pattern once instead of once per keyword and message
+    mWholeWordRegex = boost::regex();
+    if (match_whole_words && !mWordList.empty())
+    {
+        std::string pattern = "\\b(?:";
+        for (size_t i = 0; i < mWordList.size(); ++i)
+        {
+            if (i)
+            {
+                pattern += "|";
+            }
+            pattern += mWordList[i];
+        }
+        pattern += ")\\b";
+        try
+        {
+            mWholeWordRegex.assign(pattern);
+        }
+        catch (const boost::regex_error& e)
+        {
+            LL_WARNS() << "Invalid keyword pattern: " << e.what() << LL_ENDL;
+            mWholeWordRegex = boost::regex();
+        }
+    }
+    // </FS>
 }
 
 bool FSKeywords::chatContainsKeyword(const LLChat& chat, bool is_local)
@@ -97,6 +124,8 @@ bool FSKeywords::chatContainsKeyword(const LLChat& chat, bool is_local)
         return false;
     }
 
+    FSIMStageTimer filter_timer(FSIM_STAGE_FILTER, !is_local); // <FS/> Keyword matching of IMs is a tracked stage
+
     static LLCachedControl<bool> sFSKeywordSpeakersName(gSavedPerAccountSettings, "FSKeywordSpeakersName", false);
 
     std::string source;
@@ -120,13 +149,19 @@ bool FSKeywords::chatContainsKeyword(const LLChat& chat, bool is_local)
 
     if (sFSKeywordMatchWholeWords)
     {
-        for (const auto& word : mWordList)
+        // <FS> Compiled once in updateKeywords()
+        //for (const auto& word : mWordList)
+        //{
+        //    if (boost::regex_search(source, boost::regex("\\b" + word + "\\b")))
+        //    {
+        //        return true;
+        //    }
+        //}
+        if (!mWholeWordRegex.empty() && boost::regex_search(source, mWholeWordRegex))
         {
-            if (boost::regex_search(source, boost::regex("\\b" + word + "\\b")))
-            {
-                return true;
-            }
+            return true;
         }
+        // </FS>
     }
     else
     {
@@ -29,6 +29,8 @@
 
 #include "llsingleton.h"
 
+#include <boost/regex.hpp>
+
 class LLChat;
 
 class FSKeywords : public LLSingleton<FSKeywords>
@@ -43,6 +45,7 @@ public:
 
 private:
     std::vector<std::string> mWordList;
+    boost::regex mWholeWordRegex; // <FS/> All keywords in one pattern, compiled when they change
 };
 
 #endif // FS_KEYWORDS_H
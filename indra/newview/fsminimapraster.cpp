@@ -0,0 +1,537 @@
+/**
+ * @file fsminimapraster.cpp
+ * @brief Minimap object layer footprints and incremental tile rasterizer
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsminimapraster.h"
+
+#include <emmintrin.h>
+
+const F64 FSMinimapFootprints::TILE_METERS = 32.0;
+const F64 FSMinimapFootprints::TILE_MARGIN = 8.0;
+
+void fs_fill_pixels(U32* pixels, S32 count, U32 value)
+{
+    S32 i = 0;
+    const __m128i fill = _mm_set1_epi32((int)value);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_si128((__m128i*)(pixels + i), fill);
+    }
+    for (; i < count; ++i)
+    {
+        pixels[i] = value;
+    }
+}
+
+//
+// FSMinimapFootprints
+//
+
+FSMinimapFootprints::FSMinimapFootprints()
+:   mPass(0),
+    mRevision(0)
+{
+}
+
+// static
+S32 FSMinimapFootprints::tileIndex(F64 meters)
+{
+    return (S32)floor(meters / TILE_METERS);
+}
+
+void FSMinimapFootprints::beginPass()
+{
+    ++mPass;
+}
+
+void FSMinimapFootprints::endPass()
+{
+    for (std::unordered_map<key_t, Footprint>::iterator it = mFootprints.begin(); it != mFootprints.end(); )
+    {
+        if (it->second.mPass != mPass)
+        {
+            removeFromTiles(it->first, it->second);
+            it = mFootprints.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void FSMinimapFootprints::set(key_t key, const FSMinimapFootprint& footprint)
+{
+    const F64 reach = footprint.mRadius + TILE_MARGIN;
+    Footprint entry;
+    entry.mFootprint = footprint;
+    entry.mTileLeft = tileIndex(footprint.mX - reach);
+    entry.mTileRight = tileIndex(footprint.mX + reach);
+    entry.mTileBottom = tileIndex(footprint.mY - reach);
+    entry.mTileTop = tileIndex(footprint.mY + reach);
+    entry.mPass = mPass;
+
+    std::unordered_map<key_t, Footprint>::iterator found = mFootprints.find(key);
+    if (found == mFootprints.end())
+    {
+        addToTiles(key, entry);
+        mFootprints.emplace(key, entry);
+        return;
+    }
+
+    Footprint& old_entry = found->second;
+    old_entry.mPass = mPass;
+    if (old_entry.mFootprint == footprint)
+    {
+        return;
+    }
+
+    if (old_entry.mTileLeft == entry.mTileLeft && old_entry.mTileRight == entry.mTileRight &&
+        old_entry.mTileBottom == entry.mTileBottom && old_entry.mTileTop == entry.mTileTop)
+    {
+        // Same tiles, update in place to keep the drawing order
+        for (S32 y = entry.mTileBottom; y <= entry.mTileTop; ++y)
+        {
+            for (S32 x = entry.mTileLeft; x <= entry.mTileRight; ++x)
+            {
+                Tile& tile = mTiles[tileKey(x, y)];
+                for (entry_t& tile_entry : tile.mEntries)
+                {
+                    if (tile_entry.first == key)
+                    {
+                        tile_entry.second = footprint;
+                        break;
+                    }
+                }
+                touchTile(tile);
+            }
+        }
+        old_entry = entry;
+        return;
+    }
+
+    removeFromTiles(key, old_entry);
+    old_entry = entry;
+    addToTiles(key, entry);
+}
+
+void FSMinimapFootprints::remove(key_t key)
+{
+    std::unordered_map<key_t, Footprint>::iterator found = mFootprints.find(key);
+    if (found != mFootprints.end())
+    {
+        removeFromTiles(key, found->second);
+        mFootprints.erase(found);
+    }
+}
+
+void FSMinimapFootprints::clear()
+{
+    // Tiles that are gone read as revision 0, which no drawn tile has
+    mFootprints.clear();
+    mTiles.clear();
+}
+
+U32 FSMinimapFootprints::getTileRevision(S32 tile_x, S32 tile_y) const
+{
+    std::unordered_map<U64, Tile>::const_iterator found = mTiles.find(tileKey(tile_x, tile_y));
+    return found != mTiles.end() ? found->second.mRevision : 0;
+}
+
+const FSMinimapFootprints::tile_t* FSMinimapFootprints::getTile(S32 tile_x, S32 tile_y) const
+{
+    std::unordered_map<U64, Tile>::const_iterator found = mTiles.find(tileKey(tile_x, tile_y));
+    return found != mTiles.end() ? &found->second.mEntries : NULL;
+}
+
+void FSMinimapFootprints::addToTiles(key_t key, const Footprint& footprint)
+{
+    for (S32 y = footprint.mTileBottom; y <= footprint.mTileTop; ++y)
+    {
+        for (S32 x = footprint.mTileLeft; x <= footprint.mTileRight; ++x)
+        {
+            Tile& tile = mTiles[tileKey(x, y)];
+            tile.mEntries.push_back(entry_t(key, footprint.mFootprint));
+            touchTile(tile);
+        }
+    }
+}
+
+void FSMinimapFootprints::removeFromTiles(key_t key, const Footprint& footprint)
+{
+    for (S32 y = footprint.mTileBottom; y <= footprint.mTileTop; ++y)
+    {
+        for (S32 x = footprint.mTileLeft; x <= footprint.mTileRight; ++x)
+        {
+            std::unordered_map<U64, Tile>::iterator found = mTiles.find(tileKey(x, y));
+            if (found == mTiles.end())
+            {
+                continue;
+            }
+            tile_t& entries = found->second.mEntries;
+            for (tile_t::iterator it = entries.begin(); it != entries.end(); ++it)
+            {
+                if (it->first == key)
+                {
+                    entries.erase(it);
+                    break;
+                }
+            }
+            if (entries.empty())
+            {
+                // Reads as revision 0 from now on, which differs from any
+                // revision it was drawn with
+                mTiles.erase(found);
+            }
+            else
+            {
+                touchTile(found->second);
+            }
+        }
+    }
+}
+
+//
+// FSMinimapRaster
+//
+
+static inline U64 tile_key(S32 tile_x, S32 tile_y)
+{
+    return ((U64)(U32)tile_x << 32) | (U32)tile_y;
+}
+
+FSMinimapRaster::FSMinimapRaster()
+:   mValid(false),
+    mPixelsPerMeter(1.f),
+    mWidth(0),
+    mHeight(0),
+    mCenterPixelX(0),
+    mCenterPixelY(0),
+    mDrawnCenterPixelX(0),
+    mDrawnCenterPixelY(0),
+    mTilesDrawn(0),
+    mFootprintsDrawn(0)
+{
+}
+
+void FSMinimapRaster::setView(F64 center_x, F64 center_y, F32 pixels_per_meter, S32 width, S32 height)
+{
+    if (pixels_per_meter != mPixelsPerMeter || width != mWidth || height != mHeight)
+    {
+        mValid = false;
+    }
+    mPixelsPerMeter = llmax(pixels_per_meter, 0.001f);
+    mWidth = width;
+    mHeight = height;
+    mCenterPixelX = (S64)floor(center_x * mPixelsPerMeter + 0.5);
+    mCenterPixelY = (S64)floor(center_y * mPixelsPerMeter + 0.5);
+}
+
+F64 FSMinimapRaster::getCenterX() const
+{
+    return (F64)mDrawnCenterPixelX / mPixelsPerMeter;
+}
+
+F64 FSMinimapRaster::getCenterY() const
+{
+    return (F64)mDrawnCenterPixelY / mPixelsPerMeter;
+}
+
+S32 FSMinimapRaster::columnAt(F64 meters) const
+{
+    S64 column = (S64)ceil(meters * mPixelsPerMeter - 0.5) - (mDrawnCenterPixelX - mWidth / 2);
+    return (S32)llclamp(column, (S64)0, (S64)mWidth);
+}
+
+S32 FSMinimapRaster::rowAt(F64 meters) const
+{
+    S64 row = (S64)ceil(meters * mPixelsPerMeter - 0.5) - (mDrawnCenterPixelY - mHeight / 2);
+    return (S32)llclamp(row, (S64)0, (S64)mHeight);
+}
+
+void FSMinimapRaster::getVisibleTiles(S32& tile_left, S32& tile_bottom, S32& tile_right, S32& tile_top) const
+{
+    const F64 left = (F64)(mDrawnCenterPixelX - mWidth / 2) / mPixelsPerMeter;
+    const F64 bottom = (F64)(mDrawnCenterPixelY - mHeight / 2) / mPixelsPerMeter;
+    tile_left = FSMinimapFootprints::tileIndex(left);
+    tile_bottom = FSMinimapFootprints::tileIndex(bottom);
+    tile_right = FSMinimapFootprints::tileIndex(left + mWidth / mPixelsPerMeter);
+    tile_top = FSMinimapFootprints::tileIndex(bottom + mHeight / mPixelsPerMeter);
+}
+
+bool FSMinimapRaster::update(const FSMinimapFootprints& footprints, U32* pixels, S32& left, S32& bottom, S32& right, S32& top)
+{
+    mTilesDrawn = 0;
+    mFootprintsDrawn = 0;
+    if (mWidth <= 0 || mHeight <= 0)
+    {
+        return false;
+    }
+
+    S32 tile_left, tile_bottom, tile_right, tile_top;
+    const S64 dx = mCenterPixelX - mDrawnCenterPixelX;
+    const S64 dy = mCenterPixelY - mDrawnCenterPixelY;
+    if (!mValid || llabs(dx) >= mWidth || llabs(dy) >= mHeight)
+    {
+        mDrawnCenterPixelX = mCenterPixelX;
+        mDrawnCenterPixelY = mCenterPixelY;
+        mDrawnRevisions.clear();
+        drawRect(footprints, pixels, 0, 0, mWidth, mHeight);
+
+        getVisibleTiles(tile_left, tile_bottom, tile_right, tile_top);
+        for (S32 y = tile_bottom; y <= tile_top; ++y)
+        {
+            for (S32 x = tile_left; x <= tile_right; ++x)
+            {
+                if (U32 revision = footprints.getTileRevision(x, y))
+                {
+                    mDrawnRevisions[tile_key(x, y)] = revision;
+                }
+            }
+        }
+        mValid = true;
+        left = bottom = 0;
+        right = mWidth;
+        top = mHeight;
+        return true;
+    }
+
+    bool changed = false;
+    left = mWidth;
+    bottom = mHeight;
+    right = top = 0;
+
+    if (dx || dy)
+    {
+        S32 old_left, old_bottom, old_right, old_top;
+        getVisibleTiles(old_left, old_bottom, old_right, old_top);
+
+        scroll(pixels, (S32)dx, (S32)dy);
+        mDrawnCenterPixelX = mCenterPixelX;
+        mDrawnCenterPixelY = mCenterPixelY;
+        pruneDrawnRevisions();
+
+        // Tiles that scrolled into view are drawn with what they hold now.
+        // Tiles that were at least partly in view before keep the revision
+        // they were drawn with and are redrawn below if it changed since.
+        const S32 strip_left = dx > 0 ? mWidth - (S32)dx : 0;
+        const S32 strip_right = dx > 0 ? mWidth : (S32)-dx;
+        const S32 strip_bottom = dy > 0 ? mHeight - (S32)dy : 0;
+        const S32 strip_top = dy > 0 ? mHeight : (S32)-dy;
+        drawRect(footprints, pixels, strip_left, 0, strip_right, mHeight);
+        drawRect(footprints, pixels, 0, strip_bottom, mWidth, strip_top);
+
+        getVisibleTiles(tile_left, tile_bottom, tile_right, tile_top);
+        for (S32 y = tile_bottom; y <= tile_top; ++y)
+        {
+            for (S32 x = tile_left; x <= tile_right; ++x)
+            {
+                if (x >= old_left && x <= old_right && y >= old_bottom && y <= old_top)
+                {
+                    continue;
+                }
+                if (U32 revision = footprints.getTileRevision(x, y))
+                {
+                    mDrawnRevisions[tile_key(x, y)] = revision;
+                }
+            }
+        }
+
+        changed = true;
+        left = bottom = 0;
+        right = mWidth;
+        top = mHeight;
+    }
+
+    getVisibleTiles(tile_left, tile_bottom, tile_right, tile_top);
+    for (S32 y = tile_bottom; y <= tile_top; ++y)
+    {
+        for (S32 x = tile_left; x <= tile_right; ++x)
+        {
+            const U64 key = tile_key(x, y);
+            const U32 revision = footprints.getTileRevision(x, y);
+            std::unordered_map<U64, U32>::iterator drawn = mDrawnRevisions.find(key);
+            const U32 drawn_revision = drawn != mDrawnRevisions.end() ? drawn->second : 0;
+            if (revision == drawn_revision)
+            {
+                continue;
+            }
+
+            if (revision)
+            {
+                mDrawnRevisions[key] = revision;
+            }
+            else
+            {
+                mDrawnRevisions.erase(drawn);
+            }
+
+            const S32 tile_l = columnAt(x * FSMinimapFootprints::TILE_METERS);
+            const S32 tile_r = columnAt((x + 1) * FSMinimapFootprints::TILE_METERS);
+            const S32 tile_b = rowAt(y * FSMinimapFootprints::TILE_METERS);
+            const S32 tile_t = rowAt((y + 1) * FSMinimapFootprints::TILE_METERS);
+            if (tile_l >= tile_r || tile_b >= tile_t)
+            {
+                continue;
+            }
+            drawRect(footprints, pixels, tile_l, tile_b, tile_r, tile_t);
+            left = llmin(left, tile_l);
+            bottom = llmin(bottom, tile_b);
+            right = llmax(right, tile_r);
+            top = llmax(top, tile_t);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void FSMinimapRaster::drawRect(const FSMinimapFootprints& footprints, U32* pixels, S32 left, S32 bottom, S32 right, S32 top)
+{
+    if (left >= right || bottom >= top)
+    {
+        return;
+    }
+    for (S32 row = bottom; row < top; ++row)
+    {
+        fs_fill_pixels(pixels + row * mWidth + left, right - left, 0);
+    }
+
+    // Tiles that own pixels of the rect
+    const S64 origin_x = mDrawnCenterPixelX - mWidth / 2;
+    const S64 origin_y = mDrawnCenterPixelY - mHeight / 2;
+    const S32 tile_left = FSMinimapFootprints::tileIndex((origin_x + left + 0.5) / mPixelsPerMeter);
+    const S32 tile_right = FSMinimapFootprints::tileIndex((origin_x + right - 0.5) / mPixelsPerMeter);
+    const S32 tile_bottom = FSMinimapFootprints::tileIndex((origin_y + bottom + 0.5) / mPixelsPerMeter);
+    const S32 tile_top = FSMinimapFootprints::tileIndex((origin_y + top - 0.5) / mPixelsPerMeter);
+    for (S32 y = tile_bottom; y <= tile_top; ++y)
+    {
+        for (S32 x = tile_left; x <= tile_right; ++x)
+        {
+            const FSMinimapFootprints::tile_t* tile = footprints.getTile(x, y);
+            if (!tile)
+            {
+                continue;
+            }
+            const S32 l = llmax(left, columnAt(x * FSMinimapFootprints::TILE_METERS));
+            const S32 r = llmin(right, columnAt((x + 1) * FSMinimapFootprints::TILE_METERS));
+            const S32 b = llmax(bottom, rowAt(y * FSMinimapFootprints::TILE_METERS));
+            const S32 t = llmin(top, rowAt((y + 1) * FSMinimapFootprints::TILE_METERS));
+            if (l < r && b < t)
+            {
+                drawTile(tile, pixels, l, b, r, t);
+            }
+        }
+    }
+}
+
+void FSMinimapRaster::drawTile(const FSMinimapFootprints::tile_t* tile, U32* pixels, S32 left, S32 bottom, S32 right, S32 top)
+{
+    ++mTilesDrawn;
+    const S64 origin_x = mDrawnCenterPixelX - mWidth / 2;
+    const S64 origin_y = mDrawnCenterPixelY - mHeight / 2;
+    for (const FSMinimapFootprints::entry_t& entry : *tile)
+    {
+        const FSMinimapFootprint& footprint = entry.second;
+        const F32 diameter_pixels = 2.f * footprint.mRadius * mPixelsPerMeter;
+        if (diameter_pixels < 0.5f)
+        {
+            // Rounds to nothing, as before
+            continue;
+        }
+
+        S32 l = columnAt(footprint.mX - footprint.mRadius);
+        S32 r = columnAt(footprint.mX + footprint.mRadius);
+        if (l >= r)
+        {
+            l = (S32)llclamp((S64)floor(footprint.mX * mPixelsPerMeter) - origin_x, (S64)-1, (S64)mWidth);
+            r = l + 1;
+        }
+        S32 b = rowAt(footprint.mY - footprint.mRadius);
+        S32 t = rowAt(footprint.mY + footprint.mRadius);
+        if (b >= t)
+        {
+            b = (S32)llclamp((S64)floor(footprint.mY * mPixelsPerMeter) - origin_y, (S64)-1, (S64)mHeight);
+            t = b + 1;
+        }
+
+        l = llmax(l, left);
+        r = llmin(r, right);
+        b = llmax(b, bottom);
+        t = llmin(t, top);
+        if (l >= r || b >= t)
+        {
+            continue;
+        }
+        for (S32 row = b; row < t; ++row)
+        {
+            fs_fill_pixels(pixels + row * mWidth + l, r - l, footprint.mColor);
+        }
+        ++mFootprintsDrawn;
+    }
+}
+
+void FSMinimapRaster::scroll(U32* pixels, S32 dx, S32 dy)
+{
+    // The pixel at (column, row) now shows what was at (column + dx, row + dy)
+    const S32 count = mWidth - llabs(dx);
+    const S32 dst_column = llmax(0, -dx);
+    const S32 src_column = llmax(0, dx);
+    if (dy >= 0)
+    {
+        for (S32 row = 0; row + dy < mHeight; ++row)
+        {
+            memmove(pixels + row * mWidth + dst_column, pixels + (row + dy) * mWidth + src_column, count * sizeof(U32));
+        }
+    }
+    else
+    {
+        for (S32 row = mHeight - 1; row + dy >= 0; --row)
+        {
+            memmove(pixels + row * mWidth + dst_column, pixels + (row + dy) * mWidth + src_column, count * sizeof(U32));
+        }
+    }
+}
+
+void FSMinimapRaster::pruneDrawnRevisions()
+{
+    S32 tile_left, tile_bottom, tile_right, tile_top;
+    getVisibleTiles(tile_left, tile_bottom, tile_right, tile_top);
+    for (std::unordered_map<U64, U32>::iterator it = mDrawnRevisions.begin(); it != mDrawnRevisions.end(); )
+    {
+        const S32 x = (S32)(U32)(it->first >> 32);
+        const S32 y = (S32)(U32)(it->first & 0xFFFFFFFF);
+        if (x < tile_left || x > tile_right || y < tile_bottom || y > tile_top)
+        {
+            it = mDrawnRevisions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * @file fsminimapraster.h
+ * @brief Minimap object layer footprints and incremental tile rasterizer
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_MINIMAPRASTER_H
+#define FS_MINIMAPRASTER_H
+
+#include <unordered_map>
+#include <vector>
+
+// An object as the minimap object layer shows it: a square around its
+// position in global meters, in one color
+struct FSMinimapFootprint
+{
+    F64 mX;
+    F64 mY;
+    F32 mRadius;
+    U32 mColor;     // as stored in the image, LLColor4U::asRGBA()
+
+    bool operator==(const FSMinimapFootprint& rhs) const
+    {
+        return mX == rhs.mX && mY == rhs.mY && mRadius == rhs.mRadius && mColor == rhs.mColor;
+    }
+    bool operator!=(const FSMinimapFootprint& rhs) const { return !(*this == rhs); }
+};
+
+// Footprints of everything on the object layer, binned into world aligned
+// tiles. Every tile has a revision that changes whenever a footprint in it
+// is added, changed or removed; minimap instances compare it against the
+// revision they drew to find the tiles to redraw. Setting an unchanged
+// footprint changes nothing, so objects can simply be set again on every
+// refresh.
+class FSMinimapFootprints
+{
+public:
+    typedef const void* key_t;
+    typedef std::pair<key_t, FSMinimapFootprint> entry_t;
+    typedef std::vector<entry_t> tile_t;
+
+    static const F64 TILE_METERS;
+    // Footprints are also binned into tiles this close, so the one pixel a
+    // footprint smaller than a pixel is drawn as always lies in one of its
+    // tiles at the map scales the minimap uses
+    static const F64 TILE_MARGIN;
+
+    FSMinimapFootprints();
+
+    // Footprints not set between beginPass() and endPass() are removed
+    void beginPass();
+    void endPass();
+
+    void set(key_t key, const FSMinimapFootprint& footprint);
+    void remove(key_t key);
+    void clear();
+
+    size_t size() const { return mFootprints.size(); }
+
+    // 0 for tiles that never held anything
+    U32 getTileRevision(S32 tile_x, S32 tile_y) const;
+    const tile_t* getTile(S32 tile_x, S32 tile_y) const;
+
+    static S32 tileIndex(F64 meters);
+
+private:
+    struct Footprint
+    {
+        FSMinimapFootprint mFootprint;
+        S32 mTileLeft, mTileBottom, mTileRight, mTileTop;  // inclusive
+        U32 mPass;
+    };
+
+    struct Tile
+    {
+        Tile() : mRevision(0) {}
+        tile_t  mEntries;
+        U32     mRevision;
+    };
+
+    static U64 tileKey(S32 tile_x, S32 tile_y) { return ((U64)(U32)tile_x << 32) | (U32)tile_y; }
+
+    void addToTiles(key_t key, const Footprint& footprint);
+    void removeFromTiles(key_t key, const Footprint& footprint);
+    void touchTile(Tile& tile) { tile.mRevision = ++mRevision; }
+
+    std::unordered_map<key_t, Footprint> mFootprints;
+    std::unordered_map<U64, Tile> mTiles;
+    U32 mPass;
+    U32 mRevision;
+};
+
+// The object layer image of one minimap. Keeps the image centered on a
+// pixel aligned position near the requested center: panning scrolls the
+// existing pixels and only draws what scrolled into view, and only tiles
+// whose revision changed since they were drawn are drawn again.
+//
+// A pixel shows the footprints covering its center; footprints smaller
+// than a pixel still get the pixel they are in. Every pixel belongs to
+// exactly one tile and only shows that tile's footprints, so redrawing a
+// tile never needs its neighbors.
+class FSMinimapRaster
+{
+public:
+    FSMinimapRaster();
+
+    // Image of width x height pixels at pixels_per_meter around center.
+    // A new scale or size redraws everything.
+    void setView(F64 center_x, F64 center_y, F32 pixels_per_meter, S32 width, S32 height);
+    void invalidate() { mValid = false; }
+
+    // Global position of the image center as drawn, the requested center
+    // rounded to whole pixels
+    F64 getCenterX() const;
+    F64 getCenterY() const;
+
+    // Brings pixels (width * height RGBA, rows from the bottom) up to date.
+    // Returns false if nothing changed, else the changed pixel rect, right
+    // and top exclusive.
+    bool update(const FSMinimapFootprints& footprints, U32* pixels, S32& left, S32& bottom, S32& right, S32& top);
+
+    // Work done by the last update()
+    S32 getTilesDrawn() const { return mTilesDrawn; }
+    S32 getFootprintsDrawn() const { return mFootprintsDrawn; }
+
+private:
+    // First column (row) whose pixel center lies at or past meters
+    S32 columnAt(F64 meters) const;
+    S32 rowAt(F64 meters) const;
+
+    // Clears the rect and draws the footprints of every tile in it
+    void drawRect(const FSMinimapFootprints& footprints, U32* pixels, S32 left, S32 bottom, S32 right, S32 top);
+    void drawTile(const FSMinimapFootprints::tile_t* tile, U32* pixels, S32 left, S32 bottom, S32 right, S32 top);
+    void scroll(U32* pixels, S32 dx, S32 dy);
+
+    void getVisibleTiles(S32& tile_left, S32& tile_bottom, S32& tile_right, S32& tile_top) const;
+    void pruneDrawnRevisions();
+
+    bool    mValid;
+    F32     mPixelsPerMeter;
+    S32     mWidth;
+    S32     mHeight;
+    S64     mCenterPixelX;      // requested center in whole pixels of global space
+    S64     mCenterPixelY;
+    S64     mDrawnCenterPixelX; // center of the pixels in the image
+    S64     mDrawnCenterPixelY;
+    std::unordered_map<U64, U32> mDrawnRevisions;
+    S32     mTilesDrawn;
+    S32     mFootprintsDrawn;
+};
+
+// Fills count pixels with value, four at a time
+void fs_fill_pixels(U32* pixels, S32 count, U32 value);
+
+#endif // FS_MINIMAPRASTER_H
@@ -0,0 +1,185 @@
+/**
+ * @file fsnametaggrid.cpp
+ * @brief Screen space grid to find overlapping name tags
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsnametaggrid.h"
+
+#include <algorithm>
+
+static const S32 MAX_GRID_DIM = 64;         // columns and rows
+static const F32 MIN_CELL_SIZE = 8.f;       // pixels
+static const S32 MIN_GRID_RECTS = 32;       // fewer are cheaper to test pairwise
+
+FSNameTagGrid::FSNameTagGrid()
+:   mOriginX(0.f),
+    mOriginY(0.f),
+    mCellWidth(1.f),
+    mCellHeight(1.f),
+    mColumns(0),
+    mRows(0),
+    mTestCount(0)
+{
+}
+
+S32 FSNameTagGrid::getCell(F32 x, F32 y) const
+{
+    S32 col = llclamp((S32)((x - mOriginX) / mCellWidth), 0, mColumns - 1);
+    S32 row = llclamp((S32)((y - mOriginY) / mCellHeight), 0, mRows - 1);
+    return row * mColumns + col;
+}
+
+void FSNameTagGrid::getCellRange(const LLRectf& rect, S32& col_begin, S32& col_end, S32& row_begin, S32& row_end) const
+{
+    col_begin = llclamp((S32)((rect.mLeft - mOriginX) / mCellWidth), 0, mColumns - 1);
+    col_end = llclamp((S32)((rect.mRight - mOriginX) / mCellWidth), 0, mColumns - 1) + 1;
+    row_begin = llclamp((S32)((rect.mBottom - mOriginY) / mCellHeight), 0, mRows - 1);
+    row_end = llclamp((S32)((rect.mTop - mOriginY) / mCellHeight), 0, mRows - 1) + 1;
+}
+
+void FSNameTagGrid::findOverlaps(const std::vector<LLRectf>& rects, F32 margin, pair_list_t& pairs)
+{
+    pairs.clear();
+    mTestCount = 0;
+    const S32 count = (S32)rects.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    // Bounds and average size of the grown rectangles
+    mGrown.resize(count);
+    LLRectf bounds;
+    F32 total_width = 0.f;
+    F32 total_height = 0.f;
+    for (S32 i = 0; i < count; ++i)
+    {
+        LLRectf& rect = mGrown[i];
+        rect = rects[i];
+        rect.stretch(margin);
+        if (i == 0)
+        {
+            bounds = rect;
+        }
+        else
+        {
+            bounds.unionWith(rect);
+        }
+        total_width += rect.getWidth();
+        total_height += rect.getHeight();
+    }
+
+    if (count < MIN_GRID_RECTS)
+    {
+        for (S32 first = 0; first < count; ++first)
+        {
+            for (S32 second = first + 1; second < count; ++second)
+            {
+                ++mTestCount;
+                if (mGrown[first].overlaps(mGrown[second]))
+                {
+                    pairs.push_back(index_pair_t(first, second));
+                }
+            }
+        }
+        return;
+    }
+
+    mOriginX = bounds.mLeft;
+    mOriginY = bounds.mBottom;
+    mCellWidth = llmax(total_width / count, MIN_CELL_SIZE, bounds.getWidth() / MAX_GRID_DIM);
+    mCellHeight = llmax(total_height / count, MIN_CELL_SIZE, bounds.getHeight() / MAX_GRID_DIM);
+    mColumns = llclamp((S32)(bounds.getWidth() / mCellWidth) + 1, 1, MAX_GRID_DIM);
+    mRows = llclamp((S32)(bounds.getHeight() / mCellHeight) + 1, 1, MAX_GRID_DIM);
+
+    // Bin the rectangles: count per cell, then fill
+    const S32 cells = mColumns * mRows;
+    mCellStart.assign(cells + 1, 0);
+    S32 col_begin, col_end, row_begin, row_end;
+    for (S32 i = 0; i < count; ++i)
+    {
+        getCellRange(mGrown[i], col_begin, col_end, row_begin, row_end);
+        for (S32 row = row_begin; row < row_end; ++row)
+        {
+            for (S32 col = col_begin; col < col_end; ++col)
+            {
+                ++mCellStart[row * mColumns + col + 1];
+            }
+        }
+    }
+    for (S32 cell = 0; cell < cells; ++cell)
+    {
+        mCellStart[cell + 1] += mCellStart[cell];
+    }
+    mCellEntries.resize(mCellStart[cells]);
+    std::vector<S32> fill(mCellStart.begin(), mCellStart.end() - 1);
+    for (S32 i = 0; i < count; ++i)
+    {
+        getCellRange(mGrown[i], col_begin, col_end, row_begin, row_end);
+        for (S32 row = row_begin; row < row_end; ++row)
+        {
+            for (S32 col = col_begin; col < col_end; ++col)
+            {
+                mCellEntries[fill[row * mColumns + col]++] = i;
+            }
+        }
+    }
+
+    // Visit the rectangles in order and test each against the later ones
+    // sharing a cell with it, so pairs come out sorted without sorting them
+    // all. A pair sharing several cells is only reported by the cell
+    // holding the lower left corner of its intersection.
+    for (S32 first = 0; first < count; ++first)
+    {
+        const LLRectf& first_rect = mGrown[first];
+        const size_t first_pair = pairs.size();
+        getCellRange(first_rect, col_begin, col_end, row_begin, row_end);
+        for (S32 row = row_begin; row < row_end; ++row)
+        {
+            for (S32 col = col_begin; col < col_end; ++col)
+            {
+                const S32 cell = row * mColumns + col;
+                for (S32 entry = mCellStart[cell]; entry < mCellStart[cell + 1]; ++entry)
+                {
+                    const S32 second = mCellEntries[entry];
+                    if (second <= first)
+                    {
+                        continue;
+                    }
+                    const LLRectf& second_rect = mGrown[second];
+                    ++mTestCount;
+                    if (first_rect.overlaps(second_rect)
+                        && getCell(llmax(first_rect.mLeft, second_rect.mLeft), llmax(first_rect.mBottom, second_rect.mBottom)) == cell)
+                    {
+                        pairs.push_back(index_pair_t(first, second));
+                    }
+                }
+            }
+        }
+        std::sort(pairs.begin() + first_pair, pairs.end());
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file fsnametaggrid.h
+ * @brief Screen space grid to find overlapping name tags
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_NAMETAGGRID_H
+#define FS_NAMETAGGRID_H
+
+#include "llrect.h"
+
+#include <utility>
+#include <vector>
+
+// Broadphase for the name tag overlap resolution. Rectangles are binned
+// into a uniform screen space grid sized after the average rectangle, so
+// only rectangles sharing a cell are tested against each other instead of
+// every pair. Pairs come out in the order the pairwise loop used to visit
+// them, first index ascending, then second.
+class FSNameTagGrid
+{
+public:
+    typedef std::pair<S32, S32> index_pair_t;
+    typedef std::vector<index_pair_t> pair_list_t;
+
+    FSNameTagGrid();
+
+    // Fills pairs with all pairs of rects that overlap once both are grown
+    // by margin on every side
+    void findOverlaps(const std::vector<LLRectf>& rects, F32 margin, pair_list_t& pairs);
+
+    // Rectangle tests done by the last findOverlaps()
+    S32 getTestCount() const { return mTestCount; }
+    S32 getCellCount() const { return mColumns * mRows; }
+
+private:
+    S32 getCell(F32 x, F32 y) const;
+    void getCellRange(const LLRectf& rect, S32& col_begin, S32& col_end, S32& row_begin, S32& row_end) const;
+
+    std::vector<LLRectf>    mGrown;
+    std::vector<S32>        mCellStart;     // per cell offset into mCellEntries, one extra at the end
+    std::vector<S32>        mCellEntries;   // rect indices, grouped by cell
+    F32                     mOriginX;
+    F32                     mOriginY;
+    F32                     mCellWidth;
+    F32                     mCellHeight;
+    S32                     mColumns;
+    S32                     mRows;
+    S32                     mTestCount;
+};
+
+#endif // FS_NAMETAGGRID_H
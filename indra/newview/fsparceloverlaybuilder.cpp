@@ -0,0 +1,379 @@
+/**
+ * @file fsparceloverlaybuilder.cpp
+ * @brief Parcel overlay texture and property line generation off the main thread
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsparceloverlaybuilder.h"
+
+#include "llparcel.h"
+
+static const F32 LINE_WIDTH = 0.0625f;
+
+FSParcelHeightField::FSParcelHeightField()
+:   mGridsPerEdge(0),
+    mMetersPerGrid(1.f),
+    mMetersPerEdge(0.f)
+{
+}
+
+void FSParcelHeightField::assign(const F32* heights, S32 grids_per_edge, F32 meters_per_grid)
+{
+    if (!heights || grids_per_edge <= 0)
+    {
+        clear();
+        return;
+    }
+    mHeights.assign(heights, heights + grids_per_edge * grids_per_edge);
+    mGridsPerEdge = grids_per_edge;
+    mMetersPerGrid = meters_per_grid;
+    mMetersPerEdge = meters_per_grid * (grids_per_edge - 1);
+}
+
+void FSParcelHeightField::clear()
+{
+    mHeights.clear();
+    mGridsPerEdge = 0;
+    mMetersPerEdge = 0.f;
+}
+
+F32 FSParcelHeightField::resolveHeight(F32 x, F32 y) const
+{
+    if (mHeights.empty() || x < 0.f || x > mMetersPerEdge || y < 0.f || y > mMetersPerEdge)
+    {
+        return 0.f;
+    }
+
+    const F32 oometerspergrid = 1.f / mMetersPerGrid;
+    const S32 left   = llfloor(x * oometerspergrid);
+    const S32 bottom = llfloor(y * oometerspergrid);
+    const S32 right  = (left + 1 < mGridsPerEdge - 1 ? left + 1 : left);
+    const S32 top    = (bottom + 1 < mGridsPerEdge - 1 ? bottom + 1 : bottom);
+
+    const F32 left_bottom  = getZ(left, bottom);
+    const F32 right_bottom = getZ(right, bottom);
+    const F32 left_top     = getZ(left, top);
+    const F32 right_top    = getZ(right, top);
+
+    F32 dx = x - left * mMetersPerGrid;
+    F32 dy = y - bottom * mMetersPerGrid;
+    if (dy > dx)
+    {
+        dy *= left_top - left_bottom;
+        dx *= right_top - left_top;
+    }
+    else
+    {
+        dx *= right_bottom - left_bottom;
+        dy *= right_top - right_bottom;
+    }
+    return left_bottom + (dx + dy) * oometerspergrid;
+}
+
+FSParcelOverlayInput::FSParcelOverlayInput()
+:   mVersion(0),
+    mGridsPerEdge(0),
+    mBuildLines(false),
+    mWaterHeight(0.f)
+{
+}
+
+FSParcelOverlayResult::FSParcelOverlayResult()
+:   mVersion(0),
+    mHasLines(false)
+{
+}
+
+namespace
+{
+    // Same strip LLViewerParcelOverlay::addPropertyLine() used to build
+    void add_property_line(std::vector<FSParcelOverlayEdge>& edges, const FSParcelHeightField& land, F32 water_z,
+                           F32 start_x, F32 start_y, F32 dx, F32 dy, F32 tick_dx, F32 tick_dy, const LLColor4U& color)
+    {
+        edges.resize(edges.size() + 1);
+        FSParcelOverlayEdge& edge = edges.back();
+        edge.color = color;
+        edge.vertices.reserve(2 * S32(PARCEL_GRID_STEP_METERS) + 6);
+
+        F32 outside_x = start_x;
+        F32 outside_y = start_y;
+        F32 outside_z = 0.f;
+        F32 inside_x  = start_x + tick_dx;
+        F32 inside_y  = start_y + tick_dy;
+        F32 inside_z  = 0.f;
+
+        auto split = [&](const LLVector3& start, F32 x, F32 y, F32 z, F32 part)
+            {
+                F32 new_x = start.mV[0] + (x - start.mV[0]) * part;
+                F32 new_y = start.mV[1] + (y - start.mV[1]) * part;
+                F32 new_z = start.mV[2] + (z - start.mV[2]) * part;
+                edge.vertices.emplace_back(new_x, new_y, new_z);
+            };
+
+        auto checkForSplit = [&]()
+            {
+                // Copies, split() may reallocate
+                const LLVector3 last_outside = edge.vertices.back();
+                F32 z0 = last_outside.mV[2];
+                F32 z1 = outside_z;
+                if ((z0 >= water_z && z1 >= water_z) || (z0 < water_z && z1 < water_z))
+                    return;
+                F32 part = (water_z - z0) / (z1 - z0);
+                const LLVector3 last_inside = edge.vertices[edge.vertices.size() - 2];
+                split(last_inside, inside_x, inside_y, inside_z, part);
+                split(last_outside, outside_x, outside_y, outside_z, part);
+            };
+
+        // First part, only one vertex
+        outside_z = land.resolveHeight(outside_x, outside_y);
+
+        edge.vertices.emplace_back(outside_x, outside_y, outside_z);
+
+        inside_x += dx * LINE_WIDTH;
+        inside_y += dy * LINE_WIDTH;
+
+        outside_x += dx * LINE_WIDTH;
+        outside_y += dy * LINE_WIDTH;
+
+        // Then the "actual edge"
+        inside_z = land.resolveHeight(inside_x, inside_y);
+        outside_z = land.resolveHeight(outside_x, outside_y);
+
+        edge.vertices.emplace_back(inside_x, inside_y, inside_z);
+        edge.vertices.emplace_back(outside_x, outside_y, outside_z);
+
+        inside_x += dx * (dx - LINE_WIDTH);
+        inside_y += dy * (dy - LINE_WIDTH);
+
+        outside_x += dx * (dx - LINE_WIDTH);
+        outside_y += dy * (dy - LINE_WIDTH);
+
+        // Middle part, full width
+        const S32 GRID_STEP = S32(PARCEL_GRID_STEP_METERS);
+        for (S32 i = 1; i < GRID_STEP; i++)
+        {
+            inside_z = land.resolveHeight(inside_x, inside_y);
+            outside_z = land.resolveHeight(outside_x, outside_y);
+
+            checkForSplit();
+
+            edge.vertices.emplace_back(inside_x, inside_y, inside_z);
+            edge.vertices.emplace_back(outside_x, outside_y, outside_z);
+
+            inside_x += dx;
+            inside_y += dy;
+
+            outside_x += dx;
+            outside_y += dy;
+        }
+
+        // Extra buffer for edge
+        inside_x -= dx * LINE_WIDTH;
+        inside_y -= dy * LINE_WIDTH;
+
+        outside_x -= dx * LINE_WIDTH;
+        outside_y -= dy * LINE_WIDTH;
+
+        inside_z = land.resolveHeight(inside_x, inside_y);
+        outside_z = land.resolveHeight(outside_x, outside_y);
+
+        checkForSplit();
+
+        edge.vertices.emplace_back(inside_x, inside_y, inside_z);
+        edge.vertices.emplace_back(outside_x, outside_y, outside_z);
+
+        outside_x += dx * LINE_WIDTH;
+        outside_y += dy * LINE_WIDTH;
+
+        // Last edge is not drawn to the edge
+        outside_z = land.resolveHeight(outside_x, outside_y);
+
+        edge.vertices.emplace_back(outside_x, outside_y, outside_z);
+    }
+
+    void build_property_lines(const FSParcelOverlayInput& input, std::vector<FSParcelOverlayEdge>& edges)
+    {
+        const F32 GRID_STEP = PARCEL_GRID_STEP_METERS;
+        const S32 GRIDS_PER_EDGE = input.mGridsPerEdge;
+        const U8* ownership = input.mOwnership.data();
+
+        for (S32 row = 0; row < GRIDS_PER_EDGE; row++)
+        {
+            for (S32 col = 0; col < GRIDS_PER_EDGE; col++)
+            {
+                U8 overlay = ownership[row * GRIDS_PER_EDGE + col];
+                S32 colorIndex = overlay & PARCEL_COLOR_MASK;
+                switch (colorIndex)
+                {
+                case PARCEL_SELF:
+                case PARCEL_GROUP:
+                case PARCEL_OWNED:
+                case PARCEL_FOR_SALE:
+                case PARCEL_AUCTION:
+                    break;
+                default:
+                    continue;
+                }
+
+                const LLColor4U& color = input.mColors[colorIndex];
+
+                F32 left = col * GRID_STEP;
+                F32 right = left + GRID_STEP;
+
+                F32 bottom = row * GRID_STEP;
+                F32 top = bottom + GRID_STEP;
+
+                // West edge
+                if (overlay & PARCEL_WEST_LINE)
+                {
+                    add_property_line(edges, input.mHeights, input.mWaterHeight, left, bottom, 0, 1, LINE_WIDTH, 0, color);
+                }
+
+                // East edge
+                if (col == GRIDS_PER_EDGE - 1 || ownership[row * GRIDS_PER_EDGE + col + 1] & PARCEL_WEST_LINE)
+                {
+                    add_property_line(edges, input.mHeights, input.mWaterHeight, right, bottom, 0, 1, -LINE_WIDTH, 0, color);
+                }
+
+                // South edge
+                if (overlay & PARCEL_SOUTH_LINE)
+                {
+                    add_property_line(edges, input.mHeights, input.mWaterHeight, left, bottom, 1, 0, 0, LINE_WIDTH, color);
+                }
+
+                // North edge
+                if (row == GRIDS_PER_EDGE - 1 || ownership[(row + 1) * GRIDS_PER_EDGE + col] & PARCEL_SOUTH_LINE)
+                {
+                    add_property_line(edges, input.mHeights, input.mWaterHeight, left, top, 1, 0, 0, -LINE_WIDTH, color);
+                }
+            }
+        }
+    }
+}
+
+void fs_build_parcel_overlay(const FSParcelOverlayInput& input, FSParcelOverlayResult& result)
+{
+    const S32 GRIDS_PER_EDGE = input.mGridsPerEdge;
+    const S32 COUNT = GRIDS_PER_EDGE * GRIDS_PER_EDGE;
+
+    result.mVersion = input.mVersion;
+    result.mHasLines = false;
+    result.mPixels.clear();
+    result.mEdges.clear();
+    if (GRIDS_PER_EDGE <= 0 || (S32)input.mOwnership.size() < COUNT)
+    {
+        result.mMinimapLines.clear();
+        result.mMarkedCells.clear();
+        return;
+    }
+
+    // Color stored in low three bits
+    result.mPixels.resize(COUNT * 4);
+    U8* pixel = result.mPixels.data();
+    for (S32 i = 0; i < COUNT; i++, pixel += 4)
+    {
+        const LLColor4U& color = input.mColors[input.mOwnership[i] & PARCEL_COLOR_MASK];
+        pixel[0] = color.mV[VRED];
+        pixel[1] = color.mV[VGREEN];
+        pixel[2] = color.mV[VBLUE];
+        pixel[3] = color.mV[VALPHA];
+    }
+
+    if (input.mBuildLines)
+    {
+        build_property_lines(input, result.mEdges);
+        result.mHasLines = true;
+    }
+
+    fs_build_parcel_minimap_lines(input.mOwnership.data(), GRIDS_PER_EDGE, result.mMinimapLines, result.mMarkedCells);
+}
+
+void fs_build_parcel_minimap_lines(const U8* ownership, S32 grids_per_edge,
+                                   std::vector<FSParcelLineSegment>& lines, std::vector<U32>& marked_cells)
+{
+    lines.clear();
+    marked_cells.clear();
+    if (!ownership || grids_per_edge <= 0)
+    {
+        return;
+    }
+
+    const S32 GRIDS_PER_EDGE = grids_per_edge;
+
+    // The east and north region borders are always drawn, everything else
+    // where the cell has its west or south line flag. Neighbouring cells
+    // on one border are merged into a single line.
+    for (S32 col = 0; col <= GRIDS_PER_EDGE; col++)
+    {
+        S32 run_start = -1;
+        for (S32 row = 0; row <= GRIDS_PER_EDGE; row++)
+        {
+            bool has_line = row < GRIDS_PER_EDGE &&
+                            (col == GRIDS_PER_EDGE || (ownership[row * GRIDS_PER_EDGE + col] & PARCEL_WEST_LINE));
+            if (has_line && run_start < 0)
+            {
+                run_start = row;
+            }
+            else if (!has_line && run_start >= 0)
+            {
+                FSParcelLineSegment segment = { (U16)col, (U16)run_start, (U16)col, (U16)row };
+                lines.push_back(segment);
+                run_start = -1;
+            }
+        }
+    }
+
+    for (S32 row = 0; row <= GRIDS_PER_EDGE; row++)
+    {
+        S32 run_start = -1;
+        for (S32 col = 0; col <= GRIDS_PER_EDGE; col++)
+        {
+            bool has_line = col < GRIDS_PER_EDGE &&
+                            (row == GRIDS_PER_EDGE || (ownership[row * GRIDS_PER_EDGE + col] & PARCEL_SOUTH_LINE));
+            if (has_line && run_start < 0)
+            {
+                run_start = col;
+            }
+            else if (!has_line && run_start >= 0)
+            {
+                FSParcelLineSegment segment = { (U16)run_start, (U16)row, (U16)col, (U16)row };
+                lines.push_back(segment);
+                run_start = -1;
+            }
+        }
+    }
+
+    const S32 COUNT = GRIDS_PER_EDGE * GRIDS_PER_EDGE;
+    for (S32 i = 0; i < COUNT; i++)
+    {
+        const U8 overlay = ownership[i];
+        const U8 color = overlay & PARCEL_COLOR_MASK;
+        if ((overlay & (PARCEL_SOUTH_LINE | PARCEL_WEST_LINE)) || color == PARCEL_FOR_SALE || color == PARCEL_AUCTION)
+        {
+            marked_cells.push_back((U32)i);
+        }
+    }
+}
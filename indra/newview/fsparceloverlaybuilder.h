@@ -0,0 +1,111 @@
+/**
+ * @file fsparceloverlaybuilder.h
+ * @brief Parcel overlay texture and property line generation off the main thread
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_PARCELOVERLAYBUILDER_H
+#define FS_PARCELOVERLAYBUILDER_H
+
+#include "v3math.h"
+#include "v4coloru.h"
+
+#include <vector>
+
+const S32 FS_PARCEL_COLOR_COUNT = 8;    // PARCEL_COLOR_MASK + 1
+
+// Copy of a region's height field, so property lines can follow the ground
+// on a worker thread while the surface keeps changing on the main thread.
+// resolveHeight() gives the same answer as LLSurface::resolveHeightRegion().
+class FSParcelHeightField
+{
+public:
+    FSParcelHeightField();
+
+    void assign(const F32* heights, S32 grids_per_edge, F32 meters_per_grid);
+    void clear();
+    bool isEmpty() const { return mHeights.empty(); }
+
+    F32 resolveHeight(F32 x, F32 y) const;
+
+private:
+    F32 getZ(S32 i, S32 j) const { return mHeights[i + j * mGridsPerEdge]; }
+
+    std::vector<F32>    mHeights;
+    S32                 mGridsPerEdge;
+    F32                 mMetersPerGrid;
+    F32                 mMetersPerEdge;
+};
+
+// One property line strip, drawn as a triangle strip in region coordinates
+struct FSParcelOverlayEdge
+{
+    std::vector<LLVector3> vertices;
+    LLColor4U color;
+};
+
+// Merged run of parcel borders for the 2D minimap, in parcel grid units
+struct FSParcelLineSegment
+{
+    U16 mStartX;
+    U16 mStartY;
+    U16 mEndX;
+    U16 mEndY;
+};
+
+// Everything the build needs, snapshotted on the main thread
+struct FSParcelOverlayInput
+{
+    FSParcelOverlayInput();
+
+    U32                 mVersion;
+    S32                 mGridsPerEdge;
+    std::vector<U8>     mOwnership;
+    LLColor4U           mColors[FS_PARCEL_COLOR_COUNT]; // by ownership & PARCEL_COLOR_MASK
+    bool                mBuildLines;
+    F32                 mWaterHeight;
+    FSParcelHeightField mHeights;
+};
+
+struct FSParcelOverlayResult
+{
+    FSParcelOverlayResult();
+
+    U32                                 mVersion;
+    bool                                mHasLines;
+    std::vector<U8>                     mPixels;        // RGBA, one pixel per parcel grid
+    std::vector<FSParcelOverlayEdge>    mEdges;
+    std::vector<FSParcelLineSegment>    mMinimapLines;
+    std::vector<U32>                    mMarkedCells;   // cells with a border, for sale or at auction
+};
+
+// Builds the overlay texture, the property lines and the minimap lines of
+// one region. Touches nothing but its arguments, safe on any thread.
+void fs_build_parcel_overlay(const FSParcelOverlayInput& input, FSParcelOverlayResult& result);
+
+// Only the minimap lines and marked cells, for the synchronous path
+void fs_build_parcel_minimap_lines(const U8* ownership, S32 grids_per_edge,
+                                   std::vector<FSParcelLineSegment>& lines, std::vector<U32>& marked_cells);
+
+#endif // FS_PARCELOVERLAYBUILDER_H
@@ -0,0 +1,595 @@
+/**
+ * @file fsregionprefetch.cpp
+ * @brief Prefetch meshes and textures of cached objects when a region connects
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsregionprefetch.h"
+
+#include "llagent.h"
+#include "llappviewer.h"
+#include "llcallbacklist.h"
+#include "llmeshrepository.h"
+#include "llpartdata.h"
+#include "llprimitive.h"
+#include "lltexturefetch.h"
+#include "llviewercamera.h"
+#include "llviewercontrol.h"
+#include "llviewerregion.h"
+#include "llviewertexture.h"
+#include "llvolumemessage.h"
+#include "llvolumemgr.h"
+#include "llvovolume.h"
+#include "llworld.h"
+
+#include <unordered_map>
+
+static const U32 MAX_PARAMS_SIZE = 1024;            // same as MAX_OBJECT_PARAMS_SIZE in llviewerobject.cpp
+static const F32 TEXTURE_HOLD_TIME = 60.f;          // seconds a prefetched texture is kept alive without an owner
+static const F32 MESH_HOLD_TIME = 60.f;             // seconds a prefetched mesh LOD is kept decoded without an owner
+static const S32 MESH_PENDING_LIMIT = 32;           // only prefetch meshes while the repository is this quiet
+static const S32 TEXTURE_PENDING_LIMIT = 64;        // only prefetch textures while the fetcher is this quiet
+static const F32 SCENE_MIN_SETTLE_TIME = 2.f;       // ignore quiet periods right after connecting
+static const F32 SCENE_QUIET_TIME = 1.f;            // scene must stay quiet this long to count as stable
+static const F32 SCENE_TIMEOUT = 120.f;             // give up measuring after this long
+
+FSRegionPrefetch::FSRegionPrefetch()
+{
+    gIdleCallbacks.addFunction(onIdle, this);
+}
+
+FSRegionPrefetch::~FSRegionPrefetch()
+{
+    gIdleCallbacks.deleteFunction(onIdle, this);
+    releaseHeldAssets();
+}
+
+void FSRegionPrefetch::releaseHeldAssets()
+{
+    LLVolumeMgr* volume_manager = LLPrimitive::getVolumeManager();
+    if (volume_manager)
+    {
+        for (const HeldMesh& held : mHeldMeshes)
+        {
+            volume_manager->unrefVolume(held.mVolume);
+        }
+    }
+    mHeldMeshes.clear();
+    mHeldTextures.clear();
+}
+
+// Faces and volumes only get added by objects that render the texture
+static bool is_texture_in_use(const LLViewerFetchedTexture* texture)
+{
+    for (U32 ch = 0; ch < LLRender::NUM_TEXTURE_CHANNELS; ++ch)
+    {
+        if (texture->getNumFaces(ch) > 0)
+        {
+            return true;
+        }
+    }
+    for (U32 ch = 0; ch < LLRender::NUM_VOLUME_TEXTURE_CHANNELS; ++ch)
+    {
+        if (texture->getNumVolumes(ch) > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//static
+bool FSRegionPrefetch::extractCachedAssetRefs(LLDataPackerBinaryBuffer* dp, FSCachedAssetRefs& refs)
+{
+    // Mirrors the OUT_FULL_CACHED path of LLViewerObject::processUpdateMessage()
+    // and LLVOVolume::processUpdateMessage(), skipping everything we don't need.
+    dp->reset();
+
+    LLUUID full_id;
+    U8 pcode = 0;
+    dp->unpackUUID(full_id, "ID");
+    dp->unpackU32(refs.mLocalID, "LocalID");
+    dp->unpackU8(pcode, "PCode");
+    if (pcode != LL_PCODE_VOLUME)
+    {
+        dp->reset();
+        return false;
+    }
+
+    U32 crc;
+    U8 material, click_action;
+    LLVector3 rot;
+    dp->unpackU32(crc, "CRC");
+    dp->unpackU8(material, "Material");
+    dp->unpackU8(click_action, "ClickAction");
+    dp->unpackVector3(refs.mScale, "Scale");
+    dp->unpackVector3(refs.mPosition, "Pos");
+    dp->unpackVector3(rot, "Rot");
+    refs.mRotation.unpackFromVector3(rot);
+
+    U32 value;
+    LLUUID owner_id;
+    dp->unpackU32(value, "SpecialCode");
+    dp->unpackUUID(owner_id, "Owner");
+
+    if (value & 0x80)
+    {
+        LLVector3 omega;
+        dp->unpackVector3(omega, "Omega");
+    }
+
+    refs.mParentID = 0;
+    if (value & 0x20)
+    {
+        dp->unpackU32(refs.mParentID, "ParentID");
+    }
+
+    if (value & 0x2)
+    {
+        U8 tree_data;
+        dp->unpackU8(tree_data, "TreeData");
+    }
+    else if (value & 0x1)
+    {
+        // Scratch pad data is not used by volumes and has no upper size bound; bail out
+        dp->reset();
+        return false;
+    }
+
+    if (value & 0x4)
+    {
+        std::string text;
+        U8 color[4];
+        dp->unpackString(text, "Text");
+        dp->unpackBinaryDataFixed(color, 4, "Color");
+    }
+
+    if (value & 0x200)
+    {
+        std::string media_url;
+        dp->unpackString(media_url, "MediaURL");
+    }
+
+    if (value & 0x8)
+    {
+        LLPartSysData part_sys_data;
+        part_sys_data.unpackLegacy(*dp);
+    }
+
+    U8 num_parameters = 0;
+    dp->unpackU8(num_parameters, "num_params");
+    U8 param_block[MAX_PARAMS_SIZE];
+    for (U8 param = 0; param < num_parameters; ++param)
+    {
+        U16 param_type;
+        S32 param_size;
+        dp->unpackU16(param_type, "param_type");
+        if (!dp->unpackBinaryData(param_block, param_size, "param_data") || param_size > (S32)MAX_PARAMS_SIZE)
+        {
+            dp->reset();
+            return false;
+        }
+
+        if (param_type == LLNetworkData::PARAMS_SCULPT)
+        {
+            LLDataPackerBinaryBuffer dp2(param_block, param_size);
+            LLSculptParams sculpt_params;
+            sculpt_params.unpack(dp2);
+            refs.mSculptID = sculpt_params.getSculptTexture();
+            refs.mSculptType = sculpt_params.getSculptType();
+        }
+    }
+
+    if (value & 0x10)
+    {
+        LLUUID sound_uuid;
+        F32 gain, cutoff;
+        U8 sound_flags;
+        dp->unpackUUID(sound_uuid, "SoundUUID");
+        dp->unpackF32(gain, "SoundGain");
+        dp->unpackU8(sound_flags, "SoundFlags");
+        dp->unpackF32(cutoff, "SoundRadius");
+    }
+
+    if (value & 0x100)
+    {
+        std::string name_value_list;
+        dp->unpackString(name_value_list, "NV");
+    }
+
+    // LLVOVolume::processUpdateMessage() adds the sculpt parameters the same way
+    bool success = LLVolumeMessage::unpackVolumeParams(&refs.mVolumeParams, *dp) &&
+                   LLPrimitive::extractTEImageIDs(*dp, refs.mTextureIDs);
+    refs.mVolumeParams.setSculptID(refs.mSculptID, refs.mSculptType);
+
+    dp->reset();
+    return success;
+}
+
+void FSRegionPrefetch::planRegion(LLViewerRegion* regionp, LLVOCacheEntry::vocache_entry_map_t& entries)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (!regionp)
+    {
+        return;
+    }
+
+    static LLCachedControl<bool> prefetch_enabled(gSavedSettings, "FSRegionPrefetch");
+
+    RegionVisit visit;
+    visit.mRegionHandle = regionp->getHandle();
+    visit.mRegionName = regionp->getName();
+    visit.mPrefetched = prefetch_enabled && !entries.empty();
+    mVisits.push_back(visit);
+
+    if (!visit.mPrefetched)
+    {
+        return;
+    }
+
+    static LLCachedControl<U32> max_meshes(gSavedSettings, "FSRegionPrefetchMaxMeshes");
+    static LLCachedControl<U32> max_textures(gSavedSettings, "FSRegionPrefetchMaxTextures");
+    static LLCachedControl<F32> min_pixel_radius(gSavedSettings, "FSRegionPrefetchMinPixelRadius");
+
+    std::vector<FSCachedAssetRefs> objects;
+    objects.reserve(entries.size());
+    std::unordered_map<U32, size_t> index_by_local_id;
+    for (auto& entry_pair : entries)
+    {
+        LLDataPackerBinaryBuffer* dp = entry_pair.second->getDP();
+        FSCachedAssetRefs refs;
+        if (dp && extractCachedAssetRefs(dp, refs))
+        {
+            index_by_local_id[refs.mLocalID] = objects.size();
+            objects.push_back(std::move(refs));
+        }
+    }
+
+    // Children are cached relative to their root
+    for (FSCachedAssetRefs& refs : objects)
+    {
+        if (refs.mParentID)
+        {
+            auto parent_it = index_by_local_id.find(refs.mParentID);
+            if (parent_it != index_by_local_id.end())
+            {
+                const FSCachedAssetRefs& parent = objects[parent_it->second];
+                refs.mPosition = parent.mPosition + refs.mPosition * parent.mRotation;
+            }
+        }
+    }
+
+    const LLViewerCamera* camera = LLViewerCamera::getInstance();
+    const LLVector3 camera_pos = regionp->getPosRegionFromAgent(camera->getOrigin());
+    const F32 pixel_meter_ratio = camera->getPixelMeterRatio();
+    const F32 lod_factor = LLVOVolume::sLODFactor;
+
+    std::unordered_map<LLUUID, PrefetchRequest, FSUUIDHash> meshes;
+    std::unordered_map<LLUUID, PrefetchRequest, FSUUIDHash> textures;
+    for (const FSCachedAssetRefs& refs : objects)
+    {
+        const F32 radius = refs.mScale.length() * 0.5f;
+        const F32 distance = llmax(dist_vec(camera_pos, refs.mPosition) - radius, 1.f);
+        const F32 pixel_radius = radius * pixel_meter_ratio / distance;
+        if (pixel_radius < min_pixel_radius)
+        {
+            continue;
+        }
+
+        PrefetchRequest request;
+        request.mRegionHandle = visit.mRegionHandle;
+        request.mScore = pixel_radius;
+
+        if (refs.mSculptID.notNull())
+        {
+            if ((refs.mSculptType & LL_SCULPT_TYPE_MASK) == LL_SCULPT_TYPE_MESH)
+            {
+                // Same estimate as LLVOVolume::computeLODDetail()
+                request.mKind = PREFETCH_MESH;
+                request.mAssetID = refs.mSculptID;
+                request.mLOD = LLVolumeLODGroup::getDetailFromTan(ll_round(lod_factor * radius / distance, 0.01f));
+                request.mVolumeParams = refs.mVolumeParams;
+                request.mVirtualSize = 0.f;
+
+                auto result = meshes.emplace(refs.mSculptID, request);
+                if (!result.second)
+                {
+                    result.first->second.mScore = llmax(result.first->second.mScore, request.mScore);
+                    result.first->second.mLOD = llmax(result.first->second.mLOD, request.mLOD);
+                }
+            }
+            else
+            {
+                // Sculpt maps are plain textures
+                request.mKind = PREFETCH_TEXTURE;
+                request.mAssetID = refs.mSculptID;
+                request.mLOD = 0;
+                request.mVirtualSize = F_PI * pixel_radius * pixel_radius;
+                auto result = textures.emplace(refs.mSculptID, request);
+                if (!result.second)
+                {
+                    result.first->second.mScore = llmax(result.first->second.mScore, request.mScore);
+                    result.first->second.mVirtualSize = llmax(result.first->second.mVirtualSize, request.mVirtualSize);
+                }
+            }
+        }
+
+        request.mKind = PREFETCH_TEXTURE;
+        request.mLOD = 0;
+        request.mVirtualSize = F_PI * pixel_radius * pixel_radius;
+        for (const LLUUID& texture_id : refs.mTextureIDs)
+        {
+            request.mAssetID = texture_id;
+            auto result = textures.emplace(texture_id, request);
+            if (!result.second)
+            {
+                result.first->second.mScore = llmax(result.first->second.mScore, request.mScore);
+                result.first->second.mVirtualSize = llmax(result.first->second.mVirtualSize, request.mVirtualSize);
+            }
+        }
+    }
+
+    auto by_score = [](const PrefetchRequest& lhs, const PrefetchRequest& rhs) { return lhs.mScore > rhs.mScore; };
+
+    std::vector<PrefetchRequest> planned;
+    planned.reserve(meshes.size() + textures.size());
+    for (const auto& mesh : meshes)
+    {
+        planned.push_back(mesh.second);
+    }
+    if (planned.size() > max_meshes)
+    {
+        std::partial_sort(planned.begin(), planned.begin() + max_meshes, planned.end(), by_score);
+        planned.resize(max_meshes);
+    }
+    const size_t num_meshes = planned.size();
+
+    for (const auto& texture : textures)
+    {
+        planned.push_back(texture.second);
+    }
+    if (planned.size() - num_meshes > max_textures)
+    {
+        std::partial_sort(planned.begin() + num_meshes, planned.begin() + num_meshes + max_textures, planned.end(), by_score);
+        planned.resize(num_meshes + max_textures);
+    }
+
+    std::sort(planned.begin(), planned.end(), by_score);
+
+    // Merge with what other regions still have queued
+    std::deque<PrefetchRequest> merged;
+    std::merge(mQueue.begin(), mQueue.end(), planned.begin(), planned.end(), std::back_inserter(merged), by_score);
+    mQueue.swap(merged);
+
+    LL_INFOS("RegionPrefetch") << "Planned " << num_meshes << " meshes and " << (planned.size() - num_meshes)
+        << " textures from " << objects.size() << " cached objects in " << visit.mRegionName << LL_ENDL;
+}
+
+const std::vector<F32>& FSRegionPrefetch::getVisitHistory(U64 region_handle) const
+{
+    static const std::vector<F32> empty;
+    auto it = mVisitHistory.find(region_handle);
+    return it != mVisitHistory.end() ? it->second : empty;
+}
+
+//static
+void FSRegionPrefetch::onIdle(void* user_data)
+{
+    static_cast<FSRegionPrefetch*>(user_data)->idle();
+}
+
+void FSRegionPrefetch::idle()
+{
+    if (!mQueue.empty())
+    {
+        static LLCachedControl<bool> prefetch_enabled(gSavedSettings, "FSRegionPrefetch");
+        if (prefetch_enabled)
+        {
+            issueRequests();
+        }
+        else
+        {
+            mQueue.clear();
+        }
+    }
+
+    if (!mHeldMeshes.empty())
+    {
+        // Keep the decoded LOD until an object references it as well or
+        // nobody came for it
+        const F64 now = LLTimer::getElapsedSeconds();
+        LLVolumeMgr* volume_manager = LLPrimitive::getVolumeManager();
+        for (auto it = mHeldMeshes.begin(); it != mHeldMeshes.end(); )
+        {
+            LLVolumeLODGroup* group = volume_manager->getGroup(it->mVolume->getParams());
+            const bool claimed = group && group->getNumRefs() > 1;
+            if (it->mExpires == 0.0 && it->mVolume->isMeshAssetLoaded())
+            {
+                it->mExpires = now + MESH_HOLD_TIME;
+            }
+
+            const bool expired = it->mExpires > 0.0 ? it->mExpires < now : it->mGiveUp < now;
+            if (claimed || expired)
+            {
+                volume_manager->unrefVolume(it->mVolume);
+                it = mHeldMeshes.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    if (!mHeldTextures.empty())
+    {
+        // Keep the stats up so the texture list doesn't immediately discard what we asked for
+        const F64 now = LLTimer::getElapsedSeconds();
+        for (auto it = mHeldTextures.begin(); it != mHeldTextures.end(); )
+        {
+            if (it->mExpires < now || is_texture_in_use(it->mTexture) || it->mTexture->isMissingAsset())
+            {
+                it = mHeldTextures.erase(it);
+            }
+            else
+            {
+                it->mTexture->addTextureStats(it->mVirtualSize);
+                ++it;
+            }
+        }
+    }
+
+    if (!mVisits.empty())
+    {
+        updateVisits();
+    }
+}
+
+void FSRegionPrefetch::issueRequests()
+{
+    LLViewerRegion* agent_region = gAgent.getRegion();
+    if (!agent_region || !agent_region->capabilitiesReceived())
+    {
+        // Neither the mesh repository nor the texture fetcher has a URL to use yet
+        return;
+    }
+
+    static LLCachedControl<U32> requests_per_frame(gSavedSettings, "FSRegionPrefetchRequestsPerFrame");
+
+    bool mesh_ok = (S32)LLMeshRepository::sLODPending < MESH_PENDING_LIMIT;
+    bool texture_ok = LLAppViewer::getTextureFetch()->getNumRequests() < TEXTURE_PENDING_LIMIT;
+
+    U32 issued = 0;
+    for (auto it = mQueue.begin(); it != mQueue.end() && issued < requests_per_frame && (mesh_ok || texture_ok); )
+    {
+        const PrefetchRequest& request = *it;
+
+        if (!LLWorld::getInstance()->getRegionFromHandle(request.mRegionHandle))
+        {
+            // Region went away before we got to it
+            it = mQueue.erase(it);
+            continue;
+        }
+
+        if (request.mKind == PREFETCH_MESH)
+        {
+            if (!mesh_ok)
+            {
+                ++it;
+                continue;
+            }
+
+            // The objects' own volume parameters, so the LOD lands in the
+            // volume group they will reference
+            LLVolume* volume = gMeshRepo.prefetchMesh(request.mVolumeParams, request.mLOD);
+            if (volume)
+            {
+                const F64 now = LLTimer::getElapsedSeconds();
+                mHeldMeshes.push_back({ volume, 0.0, now + SCENE_TIMEOUT });
+                ++mMeshesIssued;
+                ++issued;
+            }
+            mesh_ok = (S32)LLMeshRepository::sLODPending < MESH_PENDING_LIMIT;
+        }
+        else
+        {
+            if (!texture_ok)
+            {
+                ++it;
+                continue;
+            }
+
+            LLViewerFetchedTexture* texture = LLViewerTextureManager::getFetchedTexture(request.mAssetID, FTT_DEFAULT, TRUE,
+                LLGLTexture::BOOST_NONE, LLViewerTexture::LOD_TEXTURE);
+            if (texture && texture->getDiscardLevel() < 0)
+            {
+                texture->addTextureStats(request.mVirtualSize);
+                mHeldTextures.push_back({ texture, request.mVirtualSize, LLTimer::getElapsedSeconds() + TEXTURE_HOLD_TIME });
+                ++mTexturesIssued;
+                ++issued;
+            }
+        }
+
+        it = mQueue.erase(it);
+    }
+}
+
+bool FSRegionPrefetch::isSceneQuiet() const
+{
+    return LLMeshRepository::sLODPending == 0 &&
+           (LLMeshRepoThread::sActiveHeaderRequests + LLMeshRepoThread::sActiveLODRequests) == 0 &&
+           LLAppViewer::getTextureFetch()->getNumRequests() == 0;
+}
+
+void FSRegionPrefetch::updateVisits()
+{
+    const bool quiet = mQueue.empty() && isSceneQuiet();
+
+    for (auto it = mVisits.begin(); it != mVisits.end(); )
+    {
+        RegionVisit& visit = *it;
+        const F32 elapsed = visit.mTimer.getElapsedTimeF32();
+
+        if (!quiet || elapsed < SCENE_MIN_SETTLE_TIME)
+        {
+            visit.mQuietSince = -1.f;
+        }
+        else if (visit.mQuietSince < 0.f)
+        {
+            visit.mQuietSince = elapsed;
+        }
+
+        const bool stable = visit.mQuietSince >= 0.f && (elapsed - visit.mQuietSince) >= SCENE_QUIET_TIME;
+        if (!stable && elapsed < SCENE_TIMEOUT)
+        {
+            ++it;
+            continue;
+        }
+
+        std::vector<F32>& history = mVisitHistory[visit.mRegionHandle];
+        F32 previous_average = 0.f;
+        if (!history.empty())
+        {
+            for (F32 duration : history)
+            {
+                previous_average += duration;
+            }
+            previous_average /= (F32)history.size();
+        }
+
+        const F32 duration = stable ? visit.mQuietSince : SCENE_TIMEOUT;
+        history.push_back(duration);
+
+        LL_INFOS("RegionPrefetch") << "Visit " << history.size() << " of " << visit.mRegionName
+            << ": scene " << (stable ? "stable after " : "not stable after ") << duration << "s"
+            << " (prefetch " << (visit.mPrefetched ? "on" : "off")
+            << ", previous visits average " << previous_average << "s"
+            << ", meshes prefetched " << mMeshesIssued << ", textures prefetched " << mTexturesIssued << ")" << LL_ENDL;
+
+        it = mVisits.erase(it);
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * @file fsregionprefetch.h
+ * @brief Prefetch meshes and textures of cached objects when a region connects
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_REGIONPREFETCH_H
+#define FS_REGIONPREFETCH_H
+
+#include "llsingleton.h"
+#include "lltimer.h"
+#include "llvocache.h"
+#include "llquaternion.h"
+#include "llvolume.h"
+
+#include <deque>
+
+class LLViewerFetchedTexture;
+class LLViewerRegion;
+
+// Everything the planner needs to know about one cached object,
+// read straight from its cached ObjectUpdateCompressed block.
+struct FSCachedAssetRefs
+{
+    U32         mLocalID{ 0 };
+    U32         mParentID{ 0 };
+    LLVector3   mPosition;
+    LLVector3   mScale;
+    LLQuaternion mRotation;
+    LLUUID      mSculptID;
+    U8          mSculptType{ 0 };
+    LLVolumeParams mVolumeParams;   // as the object will ask the volume manager for it
+    uuid_vec_t  mTextureIDs;
+};
+
+// When a region's object cache has been read we already know every cached
+// object's meshes and textures, long before LLVOCachePartition promotes the
+// entries to real objects. The planner ranks those assets by camera distance
+// and projected size and trickles low priority requests into the mesh
+// repository and texture fetcher while they have spare capacity.
+//
+// It also times every region visit until the scene settles (no outstanding
+// mesh or texture requests), so repeated visits with the planner on and off
+// can be compared in the log.
+class FSRegionPrefetch : public LLSingleton<FSRegionPrefetch>
+{
+    LLSINGLETON(FSRegionPrefetch);
+    ~FSRegionPrefetch();
+
+public:
+    // Called once the object cache of a region has been read from disk
+    void planRegion(LLViewerRegion* regionp, LLVOCacheEntry::vocache_entry_map_t& entries);
+
+    // Parses a cached object update. Returns false for non-volume objects
+    // and for entries that cannot be parsed. The packer is reset afterwards.
+    static bool extractCachedAssetRefs(LLDataPackerBinaryBuffer* dp, FSCachedAssetRefs& refs);
+
+    // Time to stable scene of all recorded visits of a region, in seconds
+    const std::vector<F32>& getVisitHistory(U64 region_handle) const;
+
+    // Lets go of prefetched meshes and textures, before the volume manager goes away
+    void releaseHeldAssets();
+
+private:
+    enum EAssetKind
+    {
+        PREFETCH_MESH,
+        PREFETCH_TEXTURE
+    };
+
+    struct PrefetchRequest
+    {
+        LLUUID      mAssetID;
+        U64         mRegionHandle;
+        F32         mScore;         // projected radius in pixels
+        S32         mLOD;           // mesh only
+        LLVolumeParams mVolumeParams;   // mesh only
+        F32         mVirtualSize;   // texture only
+        EAssetKind  mKind;
+    };
+
+    struct HeldMesh
+    {
+        LLVolume*   mVolume;        // referenced through the volume manager
+        F64         mExpires;       // counted from the load, 0 while loading
+        F64         mGiveUp;
+    };
+
+    struct HeldTexture
+    {
+        LLPointer<LLViewerFetchedTexture> mTexture;
+        F32         mVirtualSize;
+        F64         mExpires;
+    };
+
+    struct RegionVisit
+    {
+        U64         mRegionHandle;
+        std::string mRegionName;
+        LLTimer     mTimer;
+        F32         mQuietSince{ -1.f };
+        bool        mPrefetched{ false };
+    };
+
+    static void onIdle(void* user_data);
+    void idle();
+    void issueRequests();
+    void updateVisits();
+    bool isSceneQuiet() const;
+
+    std::deque<PrefetchRequest> mQueue;
+    std::vector<HeldMesh>       mHeldMeshes;
+    std::vector<HeldTexture>    mHeldTextures;
+    std::vector<RegionVisit>    mVisits;
+    std::map<U64, std::vector<F32> > mVisitHistory;
+
+    U32 mMeshesIssued{ 0 };
+    U32 mTexturesIssued{ 0 };
+};
+
+#endif // FS_REGIONPREFETCH_H
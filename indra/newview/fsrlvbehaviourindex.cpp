@@ -0,0 +1,190 @@
+/**
+ * @file fsrlvbehaviourindex.cpp
+ * @brief Incrementally maintained index of active RLVa behaviours and exceptions
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsrlvbehaviourindex.h"
+
+#include <algorithm>
+
+static const std::string NO_OPTION;
+
+void fs_rlv_add_holder(fs_rlv_holders_t& holders, const LLUUID& id_obj)
+{
+    ++holders[id_obj];
+}
+
+bool fs_rlv_remove_holder(fs_rlv_holders_t& holders, const LLUUID& id_obj)
+{
+    fs_rlv_holders_t::iterator it = holders.find(id_obj);
+    if (it == holders.end())
+    {
+        return false;
+    }
+    if (--it->second == 0)
+    {
+        holders.erase(it);
+        return true;
+    }
+    return false;
+}
+
+FSRlvBehaviourIndex::FSRlvBehaviourIndex(S32 num_behaviours)
+:   mBehaviours(num_behaviours),
+    mEntryCount(0)
+{
+}
+
+void FSRlvBehaviourIndex::addCommand(const LLUUID& id_obj, S32 bhvr, const std::string& option, bool strict)
+{
+    if (bhvr < 0 || bhvr >= (S32)mBehaviours.size())
+    {
+        return;
+    }
+
+    OptionEntry& entry = mBehaviours[bhvr].mOptions[option];
+    fs_rlv_add_holder(entry.mAll, id_obj);
+    if (strict)
+    {
+        fs_rlv_add_holder(entry.mStrict, id_obj);
+    }
+    ++mEntryCount;
+}
+
+void FSRlvBehaviourIndex::removeCommand(const LLUUID& id_obj, S32 bhvr, const std::string& option, bool strict)
+{
+    if (bhvr < 0 || bhvr >= (S32)mBehaviours.size())
+    {
+        return;
+    }
+
+    option_map_t& options = mBehaviours[bhvr].mOptions;
+    option_map_t::iterator it = options.find(option);
+    if (it == options.end() || it->second.mAll.find(id_obj) == it->second.mAll.end())
+    {
+        return;
+    }
+
+    fs_rlv_remove_holder(it->second.mAll, id_obj);
+    if (strict)
+    {
+        fs_rlv_remove_holder(it->second.mStrict, id_obj);
+    }
+    if (it->second.mAll.empty())
+    {
+        options.erase(it);
+    }
+    --mEntryCount;
+}
+
+void FSRlvBehaviourIndex::addRefCounted(const LLUUID& id_obj, S32 bhvr)
+{
+    if (bhvr >= 0 && bhvr < (S32)mBehaviours.size())
+    {
+        fs_rlv_add_holder(mBehaviours[bhvr].mRefCounted, id_obj);
+    }
+}
+
+void FSRlvBehaviourIndex::removeRefCounted(const LLUUID& id_obj, S32 bhvr)
+{
+    if (bhvr >= 0 && bhvr < (S32)mBehaviours.size())
+    {
+        fs_rlv_remove_holder(mBehaviours[bhvr].mRefCounted, id_obj);
+    }
+}
+
+void FSRlvBehaviourIndex::clear()
+{
+    for (BehaviourEntry& entry : mBehaviours)
+    {
+        entry.mOptions.clear();
+        entry.mRefCounted.clear();
+    }
+    mEntryCount = 0;
+}
+
+const FSRlvBehaviourIndex::OptionEntry* FSRlvBehaviourIndex::findOption(S32 bhvr, const std::string& option) const
+{
+    if (bhvr < 0 || bhvr >= (S32)mBehaviours.size())
+    {
+        return NULL;
+    }
+    const option_map_t& options = mBehaviours[bhvr].mOptions;
+    option_map_t::const_iterator it = options.find(option);
+    return (it != options.end()) ? &it->second : NULL;
+}
+
+bool FSRlvBehaviourIndex::hasBehaviourExcept(S32 bhvr, const std::string& option, const LLUUID& id_except) const
+{
+    if (bhvr < 0 || bhvr >= (S32)mBehaviours.size())
+    {
+        return false;
+    }
+
+    const OptionEntry* entry = findOption(bhvr, option);
+    if (entry && fs_rlv_held_except(entry->mAll, id_except))
+    {
+        return true;
+    }
+    return option.empty() && fs_rlv_held_except(mBehaviours[bhvr].mRefCounted, id_except);
+}
+
+bool FSRlvBehaviourIndex::hasBehaviour(const LLUUID& id_obj, S32 bhvr, const std::string& option) const
+{
+    if (bhvr < 0 || bhvr >= (S32)mBehaviours.size())
+    {
+        return false;
+    }
+
+    const OptionEntry* entry = findOption(bhvr, option);
+    if (entry && entry->mAll.count(id_obj))
+    {
+        return true;
+    }
+    return option.empty() && mBehaviours[bhvr].mRefCounted.count(id_obj);
+}
+
+bool FSRlvBehaviourIndex::ownsBehaviour(const LLUUID& id_obj, S32 bhvr) const
+{
+    const OptionEntry* entry = findOption(bhvr, NO_OPTION);
+    return entry && entry->mAll.size() == 1 && entry->mAll.begin()->first == id_obj;
+}
+
+void FSRlvBehaviourIndex::getHolders(S32 bhvr, bool strict_only, std::vector<LLUUID>& id_objs) const
+{
+    id_objs.clear();
+    if (const OptionEntry* entry = findOption(bhvr, NO_OPTION))
+    {
+        const fs_rlv_holders_t& holders = (strict_only) ? entry->mStrict : entry->mAll;
+        id_objs.reserve(holders.size());
+        for (const fs_rlv_holders_t::value_type& holder : holders)
+        {
+            id_objs.push_back(holder.first);
+        }
+        std::sort(id_objs.begin(), id_objs.end());
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ * @file fsrlvbehaviourindex.h
+ * @brief Incrementally maintained index of active RLVa behaviours and exceptions
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_RLVBEHAVIOURINDEX_H
+#define FS_RLVBEHAVIOURINDEX_H
+
+#include "lluuid.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Objects holding an entry, with the number of times each holds it
+typedef std::unordered_map<LLUUID, U32> fs_rlv_holders_t;
+
+// True if any object other than id_except holds the entry (a null
+// id_except matches every object)
+inline bool fs_rlv_held_except(const fs_rlv_holders_t& holders, const LLUUID& id_except)
+{
+    return holders.size() > 1 || (holders.size() == 1 && holders.begin()->first != id_except);
+}
+
+void fs_rlv_add_holder(fs_rlv_holders_t& holders, const LLUUID& id_obj);
+// Returns true if this was the last time the object held the entry
+bool fs_rlv_remove_holder(fs_rlv_holders_t& holders, const LLUUID& id_obj);
+
+// Which objects hold which behaviour with which option, kept up to date as
+// RlvHandler adds and removes commands so behaviour checks don't have to
+// walk the command list of every restricting object. Behaviours are plain
+// indices so this can be used without the RLVa dictionaries.
+//
+// Matching follows RlvObject::hasBehaviour(): an empty option matches
+// commands without an option and reference counted commands with one.
+class FSRlvBehaviourIndex
+{
+public:
+    explicit FSRlvBehaviourIndex(S32 num_behaviours);
+
+    void addCommand(const LLUUID& id_obj, S32 bhvr, const std::string& option, bool strict);
+    void removeCommand(const LLUUID& id_obj, S32 bhvr, const std::string& option, bool strict);
+    // Commands with an option can become reference counted after they were added
+    void addRefCounted(const LLUUID& id_obj, S32 bhvr);
+    void removeRefCounted(const LLUUID& id_obj, S32 bhvr);
+    void clear();
+
+    // True if an object other than id_except holds bhvr with option
+    bool hasBehaviourExcept(S32 bhvr, const std::string& option, const LLUUID& id_except) const;
+    // True if id_obj holds bhvr with option
+    bool hasBehaviour(const LLUUID& id_obj, S32 bhvr, const std::string& option) const;
+    // True if id_obj is the only object holding bhvr without an option
+    bool ownsBehaviour(const LLUUID& id_obj, S32 bhvr) const;
+    // Objects holding bhvr without an option, in UUID order
+    void getHolders(S32 bhvr, bool strict_only, std::vector<LLUUID>& id_objs) const;
+
+    size_t getEntryCount() const { return mEntryCount; }
+
+private:
+    struct OptionEntry
+    {
+        fs_rlv_holders_t    mAll;
+        fs_rlv_holders_t    mStrict;
+    };
+    typedef std::unordered_map<std::string, OptionEntry> option_map_t;
+
+    struct BehaviourEntry
+    {
+        option_map_t        mOptions;
+        fs_rlv_holders_t    mRefCounted;    // reference counted commands with an option
+    };
+
+    const OptionEntry* findOption(S32 bhvr, const std::string& option) const;
+
+    std::vector<BehaviourEntry> mBehaviours;
+    size_t                      mEntryCount;
+};
+
+// Which objects added which exception, per behaviour and option. OPTION is
+// the option type of the exception (a variant in RlvHandler), HASH hashes it.
+template<typename OPTION, typename HASH = std::hash<OPTION> >
+class FSRlvExceptionIndex
+{
+public:
+    explicit FSRlvExceptionIndex(S32 num_behaviours) : mBehaviours(num_behaviours) {}
+
+    void add(const LLUUID& id_obj, S32 bhvr, const OPTION& option)
+    {
+        if (isValid(bhvr))
+        {
+            fs_rlv_add_holder(mBehaviours[bhvr][option], id_obj);
+        }
+    }
+
+    void remove(const LLUUID& id_obj, S32 bhvr, const OPTION& option)
+    {
+        if (!isValid(bhvr))
+        {
+            return;
+        }
+        option_map_t& options = mBehaviours[bhvr];
+        typename option_map_t::iterator it = options.find(option);
+        if (it != options.end())
+        {
+            fs_rlv_remove_holder(it->second, id_obj);
+            if (it->second.empty())
+            {
+                options.erase(it);
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (option_map_t& options : mBehaviours)
+        {
+            options.clear();
+        }
+    }
+
+    bool hasException(S32 bhvr) const
+    {
+        return isValid(bhvr) && !mBehaviours[bhvr].empty();
+    }
+
+    // Objects that added option as an exception for bhvr, NULL if none did
+    const fs_rlv_holders_t* find(S32 bhvr, const OPTION& option) const
+    {
+        if (!isValid(bhvr))
+        {
+            return NULL;
+        }
+        const option_map_t& options = mBehaviours[bhvr];
+        typename option_map_t::const_iterator it = options.find(option);
+        return (it != options.end()) ? &it->second : NULL;
+    }
+
+private:
+    typedef std::unordered_map<OPTION, fs_rlv_holders_t, HASH> option_map_t;
+
+    bool isValid(S32 bhvr) const { return bhvr >= 0 && bhvr < (S32)mBehaviours.size(); }
+
+    std::vector<option_map_t> mBehaviours;
+};
+
+#endif // FS_RLVBEHAVIOURINDEX_H
@@ -0,0 +1,94 @@
+/**
+ * @file fsselectnodelist.cpp
+ * @brief Selection node list with constant time lookup, removal and reordering
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsselectnodelist.h"
+
+FSSelectNodeList::FSSelectNodeList()
+:   mGeneration(1)
+{
+}
+
+void FSSelectNodeList::push_front(LLSelectNode* node)
+{
+    position_map_t::iterator found = mPositions.find(node);
+    if (found != mPositions.end())
+    {
+        mList.splice(mList.begin(), mList, found->second);
+    }
+    else
+    {
+        mPositions.emplace(node, mList.insert(mList.begin(), node));
+    }
+    ++mGeneration;
+}
+
+void FSSelectNodeList::push_back(LLSelectNode* node)
+{
+    position_map_t::iterator found = mPositions.find(node);
+    if (found != mPositions.end())
+    {
+        mList.splice(mList.end(), mList, found->second);
+    }
+    else
+    {
+        mPositions.emplace(node, mList.insert(mList.end(), node));
+    }
+    ++mGeneration;
+}
+
+void FSSelectNodeList::move_to_front(LLSelectNode* node)
+{
+    // Same as removing and adding it again, also for nodes not listed
+    push_front(node);
+}
+
+void FSSelectNodeList::remove(LLSelectNode* node)
+{
+    position_map_t::iterator found = mPositions.find(node);
+    if (found != mPositions.end())
+    {
+        mList.erase(found->second);
+        mPositions.erase(found);
+        ++mGeneration;
+    }
+}
+
+FSSelectNodeList::iterator FSSelectNodeList::erase(iterator it)
+{
+    mPositions.erase(*it);
+    ++mGeneration;
+    return mList.erase(it);
+}
+
+void FSSelectNodeList::clear()
+{
+    mList.clear();
+    mPositions.clear();
+    ++mGeneration;
+}
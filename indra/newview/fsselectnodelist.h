@@ -0,0 +1,120 @@
+/**
+ * @file fsselectnodelist.h
+ * @brief Selection node list with constant time lookup, removal and reordering
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_SELECTNODELIST_H
+#define FS_SELECTNODELIST_H
+
+#include <list>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+class LLSelectNode;
+
+// Node store of LLObjectSelection. Keeps the std::list the selection always
+// had, so list iterators and the filter iterators built on them stay valid
+// while the selection changes, and indexes every node's position in it.
+// Finding, removing and moving a node to the front no longer walk the
+// list, which made selecting or deselecting large linksets quadratic.
+//
+// A node is listed at most once; pushing a listed node moves it.
+class FSSelectNodeList
+{
+public:
+    typedef std::list<LLSelectNode*> list_t;
+    typedef list_t::iterator iterator;
+    typedef list_t::const_iterator const_iterator;
+
+    FSSelectNodeList();
+
+    iterator begin() { return mList.begin(); }
+    iterator end() { return mList.end(); }
+    const_iterator begin() const { return mList.begin(); }
+    const_iterator end() const { return mList.end(); }
+
+    size_t size() const { return mList.size(); }
+    bool empty() const { return mList.empty(); }
+    bool contains(LLSelectNode* node) const { return mPositions.find(node) != mPositions.end(); }
+
+    void push_front(LLSelectNode* node);
+    void push_back(LLSelectNode* node);
+    void move_to_front(LLSelectNode* node);
+    void remove(LLSelectNode* node);
+    iterator erase(iterator it);
+    void clear();
+
+    // Changes whenever nodes are added, removed or reordered, so views
+    // derived from the list can tell they are stale
+    U32 getGeneration() const { return mGeneration; }
+
+private:
+    typedef std::unordered_map<LLSelectNode*, iterator> position_map_t;
+
+    list_t          mList;
+    position_map_t  mPositions;
+    U32             mGeneration;
+};
+
+// Reorders entries so all entries with the same key are adjacent, keys in
+// order of their first appearance and entries of one key in their original
+// order. sendListToRegions() uses it to fill each region's messages before
+// starting on the next region instead of flushing on every region change.
+template<typename T, typename KEY_FUNC>
+void fs_group_by_first_appearance(std::vector<T>& entries, KEY_FUNC key_of)
+{
+    typedef typename std::decay<decltype(key_of(entries.front()))>::type key_t;
+    std::unordered_map<key_t, size_t> group_of;
+    std::vector<size_t> groups;
+    groups.reserve(entries.size());
+    for (const T& entry : entries)
+    {
+        groups.push_back(group_of.emplace(key_of(entry), group_of.size()).first->second);
+    }
+    if (group_of.size() < 2)
+    {
+        return;
+    }
+
+    // Counting sort by group, stable
+    std::vector<size_t> starts(group_of.size() + 1, 0);
+    for (size_t group : groups)
+    {
+        ++starts[group + 1];
+    }
+    for (size_t i = 1; i < starts.size(); ++i)
+    {
+        starts[i] += starts[i - 1];
+    }
+    std::vector<T> sorted(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        sorted[starts[groups[i]]++] = entries[i];
+    }
+    entries.swap(sorted);
+}
+
+#endif // FS_SELECTNODELIST_H
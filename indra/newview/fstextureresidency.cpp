@@ -0,0 +1,271 @@
+/**
+ * @file fstextureresidency.cpp
+ * @brief Texture memory budget with accounting per owner
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fstextureresidency.h"
+
+#include <algorithm>
+#include <queue>
+
+static const F32 LOW_WATER_MARK = 0.9f;     // enforcement stops below this share of the budget
+static const F32 STICKY_COST = 0.5f;        // cost factor for mips that were evicted last time
+static const F64 STALE_TIME = 30.0;         // seconds without an update before an entry is dropped
+
+FSTextureResidency::FSTextureResidency()
+:   mBudget(0),
+    mEnforcing(false)
+{
+}
+
+void FSTextureResidency::setBudget(U64 bytes)
+{
+    mBudget = bytes;
+}
+
+void FSTextureResidency::updateTexture(const Key& key, const Owner& owner, S32 full_width, S32 full_height, S32 components,
+                                       S32 max_discard, S32 current_discard, S32 desired_discard,
+                                       F32 value, bool evictable, F64 now)
+{
+    Entry& entry = mEntries[key];
+    entry.mOwner = owner;
+    entry.mFullWidth = full_width;
+    entry.mFullHeight = full_height;
+    entry.mComponents = components;
+    entry.mMaxDiscard = llmax(max_discard, 0);
+    entry.mCurrentDiscard = current_discard;
+    entry.mDesiredDiscard = llclamp(desired_discard, 0, entry.mMaxDiscard);
+    entry.mValue = llmax(value, 0.f);
+    entry.mEvictable = evictable;
+    entry.mLastUpdate = now;
+    if (!evictable)
+    {
+        entry.mCap = 0;
+    }
+}
+
+void FSTextureResidency::removeTexture(const Key& key)
+{
+    mEntries.erase(key);
+}
+
+void FSTextureResidency::clear()
+{
+    mEntries.clear();
+    mOwners.clear();
+    mTotal = Usage();
+    for (S32 i = 0; i < OWNER_COUNT; ++i)
+    {
+        mTypes[i] = Usage();
+    }
+    mEnforcing = false;
+}
+
+S32 FSTextureResidency::getDiscardCap(const Key& key) const
+{
+    entry_map_t::const_iterator it = mEntries.find(key);
+    return it != mEntries.end() ? it->second.mCap : 0;
+}
+
+//static
+U64 FSTextureResidency::getDecodedBytes(S32 full_width, S32 full_height, S32 components, S32 discard)
+{
+    if (discard < 0 || full_width <= 0 || full_height <= 0)
+    {
+        return 0;
+    }
+    U64 width = llmax(full_width >> discard, 1);
+    U64 height = llmax(full_height >> discard, 1);
+    U64 bytes = width * height * components;
+    return bytes + bytes / 3; // mip chain
+}
+
+//static
+const char* FSTextureResidency::getOwnerTypeName(EOwnerType type)
+{
+    switch (type)
+    {
+        case OWNER_WORLD:   return "World";
+        case OWNER_AVATAR:  return "Avatars";
+        case OWNER_HUD:     return "HUD";
+        case OWNER_UI:      return "UI";
+        default:            return "Other";
+    }
+}
+
+void FSTextureResidency::update(F64 now)
+{
+    mTotal = Usage();
+    for (S32 i = 0; i < OWNER_COUNT; ++i)
+    {
+        mTypes[i] = Usage();
+    }
+    mOwners.clear();
+
+    for (entry_map_t::iterator it = mEntries.begin(); it != mEntries.end(); )
+    {
+        if (now - it->second.mLastUpdate > STALE_TIME)
+        {
+            it = mEntries.erase(it);
+            continue;
+        }
+
+        const Entry& entry = it->second;
+        U64 resident = getDecodedBytes(entry.mFullWidth, entry.mFullHeight, entry.mComponents, entry.mCurrentDiscard);
+        U64 wanted = getDecodedBytes(entry.mFullWidth, entry.mFullHeight, entry.mComponents, entry.mDesiredDiscard);
+
+        Usage* usages[] = { &mTotal, &mTypes[entry.mOwner.mType], &mOwners[entry.mOwner] };
+        for (Usage* usage : usages)
+        {
+            usage->mResidentBytes += resident;
+            usage->mWantedBytes += wanted;
+            usage->mTextures++;
+        }
+        ++it;
+    }
+
+    const U64 low_water = (U64)(mBudget * LOW_WATER_MARK);
+    if (mBudget == 0 || mTotal.mWantedBytes <= low_water)
+    {
+        mEnforcing = false;
+    }
+    else if (mTotal.mWantedBytes > mBudget)
+    {
+        mEnforcing = true;
+    }
+
+    for (entry_map_t::value_type& pair : mEntries)
+    {
+        pair.second.mPrevCap = pair.second.mCap;
+        pair.second.mCap = 0;
+    }
+
+    if (!mEnforcing)
+    {
+        return;
+    }
+
+    computeCaps(mTotal.mWantedBytes - low_water);
+
+    for (entry_map_t::value_type& pair : mEntries)
+    {
+        const Entry& entry = pair.second;
+        if (entry.mCap <= entry.mDesiredDiscard)
+        {
+            continue;
+        }
+
+        U64 withheld = getDecodedBytes(entry.mFullWidth, entry.mFullHeight, entry.mComponents, entry.mDesiredDiscard)
+                     - getDecodedBytes(entry.mFullWidth, entry.mFullHeight, entry.mComponents, entry.mCap);
+        Usage* usages[] = { &mTotal, &mTypes[entry.mOwner.mType], &mOwners[entry.mOwner] };
+        for (Usage* usage : usages)
+        {
+            usage->mCappedBytes += withheld;
+            usage->mCapped++;
+        }
+    }
+}
+
+void FSTextureResidency::computeCaps(U64 excess)
+{
+    struct Candidate
+    {
+        F32     mScore;     // screen value lost per byte saved
+        U64     mSaved;
+        S32     mLevel;     // discard level after eviction
+        Entry*  mEntry;
+
+        bool operator>(const Candidate& rhs) const { return mScore > rhs.mScore; }
+    };
+
+    auto make_candidate = [](Entry& entry, S32 level, Candidate& candidate)
+    {
+        if (level > entry.mMaxDiscard)
+        {
+            return false;
+        }
+
+        U64 saved = getDecodedBytes(entry.mFullWidth, entry.mFullHeight, entry.mComponents, level - 1)
+                  - getDecodedBytes(entry.mFullWidth, entry.mFullHeight, entry.mComponents, level);
+        if (saved == 0)
+        {
+            return false;
+        }
+
+        // Every level below the wanted one halves the resolution again, so the
+        // loss doubles with each of them
+        S32 below = llmin(level - entry.mDesiredDiscard, 16);
+        F32 cost = entry.mValue * (F32)(1 << (below - 1));
+        if (level <= entry.mPrevCap)
+        {
+            cost *= STICKY_COST;
+        }
+
+        candidate.mScore = cost / (F32)saved;
+        candidate.mSaved = saved;
+        candidate.mLevel = level;
+        candidate.mEntry = &entry;
+        return true;
+    };
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > queue;
+    for (entry_map_t::value_type& pair : mEntries)
+    {
+        Candidate candidate;
+        if (pair.second.mEvictable && make_candidate(pair.second, pair.second.mDesiredDiscard + 1, candidate))
+        {
+            queue.push(candidate);
+        }
+    }
+
+    while (excess > 0 && !queue.empty())
+    {
+        Candidate candidate = queue.top();
+        queue.pop();
+
+        candidate.mEntry->mCap = candidate.mLevel;
+        excess -= llmin(excess, candidate.mSaved);
+
+        if (make_candidate(*candidate.mEntry, candidate.mLevel + 1, candidate))
+        {
+            queue.push(candidate);
+        }
+    }
+}
+
+void FSTextureResidency::getTopOwners(std::vector<std::pair<Owner, Usage> >& owners, size_t count) const
+{
+    owners.assign(mOwners.begin(), mOwners.end());
+    count = llmin(count, owners.size());
+    std::partial_sort(owners.begin(), owners.begin() + count, owners.end(),
+        [](const std::pair<Owner, Usage>& lhs, const std::pair<Owner, Usage>& rhs)
+        {
+            return lhs.second.mResidentBytes > rhs.second.mResidentBytes;
+        });
+    owners.resize(count);
+}
@@ -0,0 +1,155 @@
+/**
+ * @file fstextureresidency.h
+ * @brief Texture memory budget with accounting per owner
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#ifndef FS_TEXTURERESIDENCY_H
+#define FS_TEXTURERESIDENCY_H
+
+#include "lluuid.h"
+
+#include <map>
+#include <vector>
+
+// Keeps books on the decoded bytes of every texture and who they belong to
+// (an avatar, a region, HUD or UI) and enforces a memory budget on them.
+//
+// When the bytes the viewer wants exceed the budget, the least valuable mip
+// levels are evicted first: each candidate costs the screen area it would
+// blur and saves the bytes of one mip level, and the cheapest per byte goes.
+// Eviction is expressed as a discard cap per texture that the texture list
+// applies. Enforcement starts at the budget and stops below a low water
+// mark, and textures already capped are preferred for further eviction, so
+// the viewer does not thrash between discard levels around the limit.
+//
+// There is no GL in here; the texture list feeds the numbers each frame.
+class FSTextureResidency
+{
+public:
+    enum EOwnerType
+    {
+        OWNER_WORLD = 0,
+        OWNER_AVATAR,
+        OWNER_HUD,
+        OWNER_UI,
+        OWNER_OTHER,
+        OWNER_COUNT
+    };
+
+    struct Owner
+    {
+        EOwnerType  mType{ OWNER_OTHER };
+        LLUUID      mID;    // avatar or region ID, null for the other types
+
+        bool operator<(const Owner& rhs) const
+        {
+            return mType != rhs.mType ? mType < rhs.mType : mID < rhs.mID;
+        }
+    };
+
+    // Texture ID and texture list type, like LLTextureKey
+    struct Key
+    {
+        LLUUID  mID;
+        U32     mList{ 0 };
+
+        bool operator<(const Key& rhs) const
+        {
+            return mID != rhs.mID ? mID < rhs.mID : mList < rhs.mList;
+        }
+    };
+
+    struct Usage
+    {
+        U64 mResidentBytes{ 0 };    // decoded bytes at the current discard level
+        U64 mWantedBytes{ 0 };      // bytes at the discard level the viewer asks for
+        U64 mCappedBytes{ 0 };      // wanted bytes withheld by discard caps
+        U32 mTextures{ 0 };
+        U32 mCapped{ 0 };
+    };
+
+    FSTextureResidency();
+
+    // 0 disables enforcement; accounting keeps working
+    void setBudget(U64 bytes);
+    U64 getBudget() const { return mBudget; }
+
+    // value is what the texture is worth on screen (its virtual size).
+    // Textures that must not lose detail (baked, UI, HUD) pass evictable false
+    // and only count against the budget.
+    void updateTexture(const Key& key, const Owner& owner, S32 full_width, S32 full_height, S32 components,
+                       S32 max_discard, S32 current_discard, S32 desired_discard,
+                       F32 value, bool evictable, F64 now);
+    void removeTexture(const Key& key);
+    // Forgets every texture, for when nobody needs the accounting
+    void clear();
+
+    // Recomputes accounting and discard caps, once per frame
+    void update(F64 now);
+
+    // Lowest discard level the texture may have, 0 if it is not capped
+    S32 getDiscardCap(const Key& key) const;
+
+    bool isEnforcing() const { return mEnforcing; }
+    const Usage& getTotalUsage() const { return mTotal; }
+    const Usage& getTypeUsage(EOwnerType type) const { return mTypes[type]; }
+
+    // Owners with the most resident bytes, largest first
+    void getTopOwners(std::vector<std::pair<Owner, Usage> >& owners, size_t count) const;
+
+    // Decoded bytes of a texture at a discard level, including its mip chain
+    static U64 getDecodedBytes(S32 full_width, S32 full_height, S32 components, S32 discard);
+    static const char* getOwnerTypeName(EOwnerType type);
+
+private:
+    struct Entry
+    {
+        Owner   mOwner;
+        S32     mFullWidth{ 0 };
+        S32     mFullHeight{ 0 };
+        S32     mComponents{ 0 };
+        S32     mMaxDiscard{ 0 };
+        S32     mCurrentDiscard{ -1 };
+        S32     mDesiredDiscard{ 0 };
+        S32     mCap{ 0 };
+        S32     mPrevCap{ 0 };
+        F32     mValue{ 0.f };
+        F64     mLastUpdate{ 0.0 };
+        bool    mEvictable{ false };
+    };
+    typedef std::map<Key, Entry> entry_map_t;
+
+    void computeCaps(U64 excess);
+
+    entry_map_t             mEntries;
+    std::map<Owner, Usage>  mOwners;
+    Usage                   mTotal;
+    Usage                   mTypes[OWNER_COUNT];
+    U64                     mBudget;
+    bool                    mEnforcing;
+};
+
+#endif // FS_TEXTURERESIDENCY_H
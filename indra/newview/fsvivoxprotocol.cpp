@@ -0,0 +1,304 @@
+/**
+ * @file fsvivoxprotocol.cpp
+ * @brief SLVoice protocol name interning, message framing and update batching
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsvivoxprotocol.h"
+
+namespace
+{
+    struct FSVivoxNameEntry
+    {
+        const char*     mName;
+        EFSVivoxName    mId;
+    };
+
+    const FSVivoxNameEntry VIVOX_NAMES[] =
+    {
+        { "Event", FSVN_EVENT },
+        { "Response", FSVN_RESPONSE },
+        { "InputXml", FSVN_INPUTXML },
+        { "requestId", FSVN_REQUESTID },
+        { "action", FSVN_ACTION },
+        { "Type", FSVN_TYPE },
+
+        { "AccountHandle", FSVN_ACCOUNTHANDLE },
+        { "AccountName", FSVN_ACCOUNTNAME },
+        { "Alias", FSVN_ALIAS },
+        { "Application", FSVN_APPLICATION },
+        { "AudioMedia", FSVN_AUDIOMEDIA },
+        { "AutoAcceptMask", FSVN_AUTOACCEPTMASK },
+        { "AutoAddAsBuddy", FSVN_AUTOADDASBUDDY },
+        { "BlockMask", FSVN_BLOCKMASK },
+        { "BuddyURI", FSVN_BUDDYURI },
+        { "CaptureDevice", FSVN_CAPTUREDEVICE },
+        { "CaptureDevices", FSVN_CAPTUREDEVICES },
+        { "ChannelName", FSVN_CHANNELNAME },
+        { "ChannelURI", FSVN_CHANNELURI },
+        { "ConnectorHandle", FSVN_CONNECTORHANDLE },
+        { "Description", FSVN_DESCRIPTION },
+        { "Device", FSVN_DEVICE },
+        { "DisplayName", FSVN_DISPLAYNAME },
+        { "Enabled", FSVN_ENABLED },
+        { "Energy", FSVN_ENERGY },
+        { "ExpirationDate", FSVN_EXPIRATIONDATE },
+        { "Expired", FSVN_EXPIRED },
+        { "HasAudio", FSVN_HASAUDIO },
+        { "HasText", FSVN_HASTEXT },
+        { "HasVideo", FSVN_HASVIDEO },
+        { "ID", FSVN_ID },
+        { "Incoming", FSVN_INCOMING },
+        { "IsChannel", FSVN_ISCHANNEL },
+        { "IsLocallyMuted", FSVN_ISLOCALLYMUTED },
+        { "IsModeratorMuted", FSVN_ISMODERATORMUTED },
+        { "IsSpeaking", FSVN_ISSPEAKING },
+        { "MediaCompletionType", FSVN_MEDIACOMPLETIONTYPE },
+        { "MessageBody", FSVN_MESSAGEBODY },
+        { "MessageHeader", FSVN_MESSAGEHEADER },
+        { "MicEnergy", FSVN_MICENERGY },
+        { "Name", FSVN_NAME },
+        { "NotificationType", FSVN_NOTIFICATIONTYPE },
+        { "NumberOfAliases", FSVN_NUMBEROFALIASES },
+        { "ParticipantType", FSVN_PARTICIPANTTYPE },
+        { "ParticipantURI", FSVN_PARTICIPANTURI },
+        { "Presence", FSVN_PRESENCE },
+        { "PresenceOnly", FSVN_PRESENCEONLY },
+        { "RenderDevice", FSVN_RENDERDEVICE },
+        { "RenderDevices", FSVN_RENDERDEVICES },
+        { "ReturnCode", FSVN_RETURNCODE },
+        { "SessionFont", FSVN_SESSIONFONT },
+        { "SessionGroupHandle", FSVN_SESSIONGROUPHANDLE },
+        { "SessionHandle", FSVN_SESSIONHANDLE },
+        { "State", FSVN_STATE },
+        { "Status", FSVN_STATUS },
+        { "StatusCode", FSVN_STATUSCODE },
+        { "StatusString", FSVN_STATUSSTRING },
+        { "SubscriptionHandle", FSVN_SUBSCRIPTIONHANDLE },
+        { "SubscriptionType", FSVN_SUBSCRIPTIONTYPE },
+        { "TemplateFont", FSVN_TEMPLATEFONT },
+        { "Terminated", FSVN_TERMINATED },
+        { "URI", FSVN_URI },
+        { "Version", FSVN_VERSION },
+        { "VersionID", FSVN_VERSIONID },
+        { "Volume", FSVN_VOLUME },
+
+        { "AccountLoginStateChangeEvent", FSVN_ACCOUNTLOGINSTATECHANGEEVENT },
+        { "AudioDeviceHotSwapEvent", FSVN_AUDIODEVICEHOTSWAPEVENT },
+        { "AuxAudioPropertiesEvent", FSVN_AUXAUDIOPROPERTIESEVENT },
+        { "MediaCompletionEvent", FSVN_MEDIACOMPLETIONEVENT },
+        { "MediaStreamUpdatedEvent", FSVN_MEDIASTREAMUPDATEDEVENT },
+        { "MessageEvent", FSVN_MESSAGEEVENT },
+        { "ParticipantAddedEvent", FSVN_PARTICIPANTADDEDEVENT },
+        { "ParticipantRemovedEvent", FSVN_PARTICIPANTREMOVEDEVENT },
+        { "ParticipantUpdatedEvent", FSVN_PARTICIPANTUPDATEDEVENT },
+        { "SessionAddedEvent", FSVN_SESSIONADDEDEVENT },
+        { "SessionGroupAddedEvent", FSVN_SESSIONGROUPADDEDEVENT },
+        { "SessionGroupRemovedEvent", FSVN_SESSIONGROUPREMOVEDEVENT },
+        { "SessionGroupUpdatedEvent", FSVN_SESSIONGROUPUPDATEDEVENT },
+        { "SessionNotificationEvent", FSVN_SESSIONNOTIFICATIONEVENT },
+        { "SessionRemovedEvent", FSVN_SESSIONREMOVEDEVENT },
+        { "SessionUpdatedEvent", FSVN_SESSIONUPDATEDEVENT },
+        { "VoiceServiceConnectionStateChangedEvent", FSVN_VOICESERVICECONNECTIONSTATECHANGEDEVENT },
+    };
+
+    const U32 NAME_TABLE_SIZE = 256;    // power of two, well above the number of names
+
+    inline U8 fold_case(U8 c)
+    {
+        return (c >= 'A' && c <= 'Z') ? (U8)(c + ('a' - 'A')) : c;
+    }
+
+    // FNV-1a over the lower case name
+    inline U32 hash_name(const char* name)
+    {
+        U32 hash = 2166136261u;
+        for (const U8* c = (const U8*)name; *c; ++c)
+        {
+            hash = (hash ^ fold_case(*c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    inline bool equal_names(const char* a, const char* b)
+    {
+        while (*a && fold_case((U8)*a) == fold_case((U8)*b))
+        {
+            ++a;
+            ++b;
+        }
+        return *a == *b;
+    }
+
+    // Open addressing table, built once and read only afterwards
+    struct FSVivoxNameTable
+    {
+        const FSVivoxNameEntry* mSlots[NAME_TABLE_SIZE];
+        const char*             mNames[FSVN_COUNT];
+
+        FSVivoxNameTable()
+        {
+            memset(mSlots, 0, sizeof(mSlots));
+            for (S32 i = 0; i < FSVN_COUNT; ++i)
+            {
+                mNames[i] = "";
+            }
+            for (const FSVivoxNameEntry& entry : VIVOX_NAMES)
+            {
+                U32 slot = hash_name(entry.mName) & (NAME_TABLE_SIZE - 1);
+                while (mSlots[slot])
+                {
+                    slot = (slot + 1) & (NAME_TABLE_SIZE - 1);
+                }
+                mSlots[slot] = &entry;
+                mNames[entry.mId] = entry.mName;
+            }
+        }
+
+        EFSVivoxName find(const char* name) const
+        {
+            U32 slot = hash_name(name) & (NAME_TABLE_SIZE - 1);
+            while (const FSVivoxNameEntry* entry = mSlots[slot])
+            {
+                if (equal_names(entry->mName, name))
+                {
+                    return entry->mId;
+                }
+                slot = (slot + 1) & (NAME_TABLE_SIZE - 1);
+            }
+            return FSVN_UNKNOWN;
+        }
+    };
+
+    const FSVivoxNameTable& name_table()
+    {
+        static const FSVivoxNameTable table;
+        return table;
+    }
+
+    const char MESSAGE_DELIMITER[] = "\n\n\n";
+    const size_t MESSAGE_DELIMITER_LENGTH = 3;
+}
+
+EFSVivoxName fs_vivox_name(const char* name)
+{
+    return name ? name_table().find(name) : FSVN_UNKNOWN;
+}
+
+const char* fs_vivox_name_string(EFSVivoxName id)
+{
+    return (id > FSVN_UNKNOWN && id < FSVN_COUNT) ? name_table().mNames[id] : "";
+}
+
+//
+// FSVivoxMessageStream
+//
+
+FSVivoxMessageStream::FSVivoxMessageStream()
+:   mOffset(0),
+    mSearchFrom(0)
+{
+}
+
+void FSVivoxMessageStream::append(const char* data, size_t length)
+{
+    mBuffer.append(data, length);
+}
+
+bool FSVivoxMessageStream::nextMessage(const char*& message, size_t& length)
+{
+    size_t delim = mBuffer.find(MESSAGE_DELIMITER, llmax(mOffset, mSearchFrom), MESSAGE_DELIMITER_LENGTH);
+    if (delim == std::string::npos)
+    {
+        // A delimiter may straddle the end of the buffer
+        mSearchFrom = mBuffer.size() >= MESSAGE_DELIMITER_LENGTH ? mBuffer.size() - (MESSAGE_DELIMITER_LENGTH - 1) : 0;
+        return false;
+    }
+
+    message = mBuffer.data() + mOffset;
+    length = delim - mOffset;
+    mOffset = delim + MESSAGE_DELIMITER_LENGTH;
+    return true;
+}
+
+void FSVivoxMessageStream::compact()
+{
+    if (mOffset == 0)
+    {
+        return;
+    }
+    mBuffer.erase(0, mOffset);
+    mSearchFrom = mSearchFrom > mOffset ? mSearchFrom - mOffset : 0;
+    mOffset = 0;
+}
+
+//
+// FSVivoxParticipantUpdates
+//
+
+FSVivoxParticipantUpdates::FSVivoxParticipantUpdates()
+:   mReceived(0),
+    mApplied(0)
+{
+}
+
+void FSVivoxParticipantUpdates::add(const std::string& session_handle, const std::string& session_group_handle,
+                                    const std::string& uri, const std::string& alias,
+                                    bool is_moderator_muted, bool is_speaking, int volume, F32 energy)
+{
+    ++mReceived;
+
+    mKey.assign(session_handle);
+    mKey.push_back('\n');
+    mKey.append(uri);
+
+    std::pair<index_map_t::iterator, bool> inserted = mIndex.emplace(mKey, mUpdates.size());
+    if (inserted.second)
+    {
+        mUpdates.emplace_back();
+        FSVivoxParticipantUpdate& update = mUpdates.back();
+        update.mSessionHandle = session_handle;
+        update.mURI = uri;
+        update.mSpoke = false;
+    }
+
+    FSVivoxParticipantUpdate& update = mUpdates[inserted.first->second];
+    update.mSessionGroupHandle = session_group_handle;
+    update.mAlias = alias;
+    update.mIsModeratorMuted = is_moderator_muted;
+    update.mIsSpeaking = is_speaking;
+    update.mSpoke = update.mSpoke || is_speaking;
+    update.mVolume = volume;
+    update.mEnergy = energy;
+}
+
+void FSVivoxParticipantUpdates::take(std::vector<FSVivoxParticipantUpdate>& updates)
+{
+    mApplied += mUpdates.size();
+    updates.clear();
+    updates.swap(mUpdates);
+    mIndex.clear();
+}
@@ -0,0 +1,209 @@
+/**
+ * @file fsvivoxprotocol.h
+ * @brief SLVoice protocol name interning, message framing and update batching
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_VIVOXPROTOCOL_H
+#define FS_VIVOXPROTOCOL_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Element, attribute and event type names of the SLVoice protocol the
+// parser acts on. Names are matched case insensitively like the stricmp()
+// chains they replace; attribute "type" and element "Type" share an id.
+enum EFSVivoxName
+{
+    FSVN_UNKNOWN = 0,
+
+    // Message framing
+    FSVN_EVENT,
+    FSVN_RESPONSE,
+    FSVN_INPUTXML,
+    FSVN_REQUESTID,
+    FSVN_ACTION,
+    FSVN_TYPE,
+
+    // Elements
+    FSVN_ACCOUNTHANDLE,
+    FSVN_ACCOUNTNAME,
+    FSVN_ALIAS,
+    FSVN_APPLICATION,
+    FSVN_AUDIOMEDIA,
+    FSVN_AUTOACCEPTMASK,
+    FSVN_AUTOADDASBUDDY,
+    FSVN_BLOCKMASK,
+    FSVN_BUDDYURI,
+    FSVN_CAPTUREDEVICE,
+    FSVN_CAPTUREDEVICES,
+    FSVN_CHANNELNAME,
+    FSVN_CHANNELURI,
+    FSVN_CONNECTORHANDLE,
+    FSVN_DESCRIPTION,
+    FSVN_DEVICE,
+    FSVN_DISPLAYNAME,
+    FSVN_ENABLED,
+    FSVN_ENERGY,
+    FSVN_EXPIRATIONDATE,
+    FSVN_EXPIRED,
+    FSVN_HASAUDIO,
+    FSVN_HASTEXT,
+    FSVN_HASVIDEO,
+    FSVN_ID,
+    FSVN_INCOMING,
+    FSVN_ISCHANNEL,
+    FSVN_ISLOCALLYMUTED,
+    FSVN_ISMODERATORMUTED,
+    FSVN_ISSPEAKING,
+    FSVN_MEDIACOMPLETIONTYPE,
+    FSVN_MESSAGEBODY,
+    FSVN_MESSAGEHEADER,
+    FSVN_MICENERGY,
+    FSVN_NAME,
+    FSVN_NOTIFICATIONTYPE,
+    FSVN_NUMBEROFALIASES,
+    FSVN_PARTICIPANTTYPE,
+    FSVN_PARTICIPANTURI,
+    FSVN_PRESENCE,
+    FSVN_PRESENCEONLY,
+    FSVN_RENDERDEVICE,
+    FSVN_RENDERDEVICES,
+    FSVN_RETURNCODE,
+    FSVN_SESSIONFONT,
+    FSVN_SESSIONGROUPHANDLE,
+    FSVN_SESSIONHANDLE,
+    FSVN_STATE,
+    FSVN_STATUS,
+    FSVN_STATUSCODE,
+    FSVN_STATUSSTRING,
+    FSVN_SUBSCRIPTIONHANDLE,
+    FSVN_SUBSCRIPTIONTYPE,
+    FSVN_TEMPLATEFONT,
+    FSVN_TERMINATED,
+    FSVN_URI,
+    FSVN_VERSION,
+    FSVN_VERSIONID,
+    FSVN_VOLUME,
+
+    // Event types
+    FSVN_ACCOUNTLOGINSTATECHANGEEVENT,
+    FSVN_AUDIODEVICEHOTSWAPEVENT,
+    FSVN_AUXAUDIOPROPERTIESEVENT,
+    FSVN_MEDIACOMPLETIONEVENT,
+    FSVN_MEDIASTREAMUPDATEDEVENT,
+    FSVN_MESSAGEEVENT,
+    FSVN_PARTICIPANTADDEDEVENT,
+    FSVN_PARTICIPANTREMOVEDEVENT,
+    FSVN_PARTICIPANTUPDATEDEVENT,
+    FSVN_SESSIONADDEDEVENT,
+    FSVN_SESSIONGROUPADDEDEVENT,
+    FSVN_SESSIONGROUPREMOVEDEVENT,
+    FSVN_SESSIONGROUPUPDATEDEVENT,
+    FSVN_SESSIONNOTIFICATIONEVENT,
+    FSVN_SESSIONREMOVEDEVENT,
+    FSVN_SESSIONUPDATEDEVENT,
+    FSVN_VOICESERVICECONNECTIONSTATECHANGEDEVENT,
+
+    FSVN_COUNT
+};
+
+// Id of an element, attribute or event type name, FSVN_UNKNOWN for names
+// the parser does not act on. One hash and one compare, no allocation.
+EFSVivoxName fs_vivox_name(const char* name);
+const char* fs_vivox_name_string(EFSVivoxName id);
+
+// Splits the byte stream from SLVoice into messages terminated by three
+// newlines. Messages are handed out as pointers into the buffer, which is
+// only compacted once all complete messages of a read were taken.
+class FSVivoxMessageStream
+{
+public:
+    FSVivoxMessageStream();
+
+    void append(const char* data, size_t length);
+
+    // Next complete message, valid until the next append() or compact()
+    bool nextMessage(const char*& message, size_t& length);
+
+    // Drops the messages taken so far
+    void compact();
+
+    size_t getPendingBytes() const { return mBuffer.size() - mOffset; }
+    const std::string& getBuffer() const { return mBuffer; }
+
+private:
+    std::string mBuffer;
+    size_t      mOffset;        // start of the first message not taken yet
+    size_t      mSearchFrom;    // bytes before this hold no delimiter
+};
+
+// Latest state of one participant from ParticipantUpdatedEvents
+struct FSVivoxParticipantUpdate
+{
+    std::string mSessionHandle;
+    std::string mSessionGroupHandle;
+    std::string mURI;
+    std::string mAlias;
+    bool        mIsModeratorMuted;
+    bool        mIsSpeaking;
+    bool        mSpoke;         // speaking in any of the coalesced updates
+    int         mVolume;
+    F32         mEnergy;
+};
+
+// SLVoice sends a ParticipantUpdatedEvent per participant several times a
+// second while anyone talks. Updates are collected here and applied once per
+// frame, keeping only the latest state per participant and session.
+class FSVivoxParticipantUpdates
+{
+public:
+    FSVivoxParticipantUpdates();
+
+    void add(const std::string& session_handle, const std::string& session_group_handle,
+             const std::string& uri, const std::string& alias,
+             bool is_moderator_muted, bool is_speaking, int volume, F32 energy);
+
+    bool empty() const { return mUpdates.empty(); }
+    size_t size() const { return mUpdates.size(); }
+
+    // Hands the collected updates to the caller in arrival order of each
+    // participant's first update and starts a new batch
+    void take(std::vector<FSVivoxParticipantUpdate>& updates);
+
+    U64 getReceivedCount() const { return mReceived; }
+    U64 getAppliedCount() const { return mApplied; }
+
+private:
+    typedef std::unordered_map<std::string, size_t> index_map_t;
+
+    std::vector<FSVivoxParticipantUpdate>   mUpdates;
+    index_map_t                             mIndex;
+    std::string                             mKey;
+    U64                                     mReceived;
+    U64                                     mApplied;
+};
+
+#endif // FS_VIVOXPROTOCOL_H
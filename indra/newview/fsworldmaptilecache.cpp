@@ -0,0 +1,336 @@
+/**
+ * @file fsworldmaptilecache.cpp
+ * @brief Request budget and memory bounded LRU for world map tiles
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsworldmaptilecache.h"
+
+#include <algorithm>
+
+namespace
+{
+    struct WantedOrder
+    {
+        template<typename T>
+        bool operator()(const T& a, const T& b) const
+        {
+            if (a.mPriority != b.mPriority)
+            {
+                return a.mPriority < b.mPriority;
+            }
+            // A coarse tile covers many fine ones, show it first
+            return a.mKey.mLevel > b.mKey.mLevel;
+        }
+    };
+
+    struct EvictionCandidate
+    {
+        U32                             mLastUsed;
+        FSWorldMapTileCache::TileKey    mKey;
+
+        bool operator<(const EvictionCandidate& other) const
+        {
+            if (mLastUsed != other.mLastUsed)
+            {
+                return mLastUsed < other.mLastUsed;
+            }
+            // Finer levels go first, coarse ones serve as placeholders
+            return mKey.mLevel < other.mKey.mLevel;
+        }
+    };
+}
+
+FSWorldMapTileCache::FSWorldMapTileCache(S32 levels)
+:   mTiles(levels),
+    mWantedIndex(levels),
+    mFrame(1),
+    mMaxInFlight(0),
+    mMaxBytes(0),
+    mInFlight(0),
+    mResidentBytes(0),
+    mHits(0),
+    mMisses(0),
+    mPending(0),
+    mRequests(0),
+    mEvictions(0),
+    mLoadedBytes(0)
+{
+}
+
+void FSWorldMapTileCache::setBudget(U32 max_bytes, U32 max_in_flight)
+{
+    mMaxBytes = max_bytes;
+    mMaxInFlight = max_in_flight;
+}
+
+void FSWorldMapTileCache::beginFrame()
+{
+    ++mFrame;
+    mWanted.clear();
+    for (size_t level = 0; level < mWantedIndex.size(); ++level)
+    {
+        mWantedIndex[level].clear();
+    }
+}
+
+void FSWorldMapTileCache::clear()
+{
+    for (size_t level = 0; level < mTiles.size(); ++level)
+    {
+        mTiles[level].clear();
+        mWantedIndex[level].clear();
+    }
+    mWanted.clear();
+    mInFlight = 0;
+    mResidentBytes = 0;
+}
+
+FSWorldMapTileCache::Tile* FSWorldMapTileCache::find(S32 level, U64 handle)
+{
+    tile_map_t& tiles = mTiles[level - 1];
+    tile_map_t::iterator it = tiles.find(handle);
+    return it != tiles.end() ? &it->second : NULL;
+}
+
+const FSWorldMapTileCache::Tile* FSWorldMapTileCache::find(S32 level, U64 handle) const
+{
+    const tile_map_t& tiles = mTiles[level - 1];
+    tile_map_t::const_iterator it = tiles.find(handle);
+    return it != tiles.end() ? &it->second : NULL;
+}
+
+void FSWorldMapTileCache::touch(S32 level, U64 handle)
+{
+    Tile* tile = find(level, handle);
+    if (!tile)
+    {
+        return;
+    }
+
+    tile->mLastUsed = mFrame;
+    if (tile->mLoading)
+    {
+        ++mPending;
+    }
+    else
+    {
+        ++mHits;
+    }
+}
+
+void FSWorldMapTileCache::want(S32 level, U64 handle, F32 priority)
+{
+    if (find(level, handle))
+    {
+        touch(level, handle);
+        return;
+    }
+
+    wanted_index_t& index = mWantedIndex[level - 1];
+    wanted_index_t::iterator it = index.find(handle);
+    if (it != index.end())
+    {
+        // Looked up again this frame, e.g. as a placeholder of another tile
+        Wanted& wanted = mWanted[it->second];
+        wanted.mPriority = llmin(wanted.mPriority, priority);
+        return;
+    }
+
+    ++mMisses;
+    index[handle] = mWanted.size();
+    Wanted wanted;
+    wanted.mKey.mLevel = level;
+    wanted.mKey.mHandle = handle;
+    wanted.mPriority = priority;
+    mWanted.push_back(wanted);
+}
+
+bool FSWorldMapTileCache::isWanted(S32 level, U64 handle) const
+{
+    const wanted_index_t& index = mWantedIndex[level - 1];
+    return index.find(handle) != index.end();
+}
+
+void FSWorldMapTileCache::takeRequests(std::vector<TileKey>& out)
+{
+    out.clear();
+    if (mWanted.empty())
+    {
+        return;
+    }
+
+    size_t count = mWanted.size();
+    if (isBounded())
+    {
+        count = llmin(count, (size_t)(mMaxInFlight > mInFlight ? mMaxInFlight - mInFlight : 0));
+        std::partial_sort(mWanted.begin(), mWanted.begin() + count, mWanted.end(), WantedOrder());
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const TileKey& key = mWanted[i].mKey;
+        addTile(key.mLevel, key.mHandle);
+        out.push_back(key);
+    }
+
+    mWanted.clear();
+    for (size_t level = 0; level < mWantedIndex.size(); ++level)
+    {
+        mWantedIndex[level].clear();
+    }
+}
+
+void FSWorldMapTileCache::addTile(S32 level, U64 handle)
+{
+    tile_map_t& tiles = mTiles[level - 1];
+    if (tiles.find(handle) != tiles.end())
+    {
+        return;
+    }
+
+    Tile& tile = tiles[handle];
+    tile.mLastUsed = mFrame;
+    tile.mBytes = 0;
+    tile.mLoading = true;
+    ++mInFlight;
+    ++mRequests;
+}
+
+void FSWorldMapTileCache::setLoaded(S32 level, U64 handle, U32 bytes)
+{
+    Tile* tile = find(level, handle);
+    if (!tile || !tile->mLoading)
+    {
+        return;
+    }
+
+    tile->mLoading = false;
+    tile->mBytes = bytes;
+    --mInFlight;
+    mResidentBytes += bytes;
+    mLoadedBytes += bytes;
+}
+
+bool FSWorldMapTileCache::isLoading(S32 level, U64 handle) const
+{
+    const Tile* tile = find(level, handle);
+    return tile && tile->mLoading;
+}
+
+void FSWorldMapTileCache::remove(S32 level, U64 handle)
+{
+    tile_map_t& tiles = mTiles[level - 1];
+    tile_map_t::iterator it = tiles.find(handle);
+    if (it != tiles.end())
+    {
+        erase(level, it);
+    }
+}
+
+void FSWorldMapTileCache::erase(S32 level, tile_map_t::iterator it)
+{
+    if (it->second.mLoading)
+    {
+        --mInFlight;
+    }
+    mResidentBytes -= it->second.mBytes;
+    mTiles[level - 1].erase(it);
+}
+
+void FSWorldMapTileCache::evict(std::vector<TileKey>& out)
+{
+    out.clear();
+
+    // Loads nobody looks at anymore only hold up the ones that matter
+    std::vector<EvictionCandidate> candidates;
+    for (S32 level = 1; level <= (S32)mTiles.size(); ++level)
+    {
+        tile_map_t& tiles = mTiles[level - 1];
+        for (tile_map_t::iterator it = tiles.begin(); it != tiles.end(); )
+        {
+            const Tile& tile = it->second;
+            if (tile.mLastUsed == mFrame)
+            {
+                ++it;
+                continue;
+            }
+
+            TileKey key;
+            key.mLevel = level;
+            key.mHandle = it->first;
+            if (tile.mLoading && isBounded())
+            {
+                out.push_back(key);
+                ++mEvictions;
+                tile_map_t::iterator erase_it = it++;
+                erase(level, erase_it);
+            }
+            else if (mMaxBytes > 0 && tile.mBytes > 0)
+            {
+                EvictionCandidate candidate;
+                candidate.mLastUsed = tile.mLastUsed;
+                candidate.mKey = key;
+                candidates.push_back(candidate);
+                ++it;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    if (mMaxBytes == 0 || mResidentBytes <= mMaxBytes)
+    {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    for (size_t i = 0; i < candidates.size() && mResidentBytes > mMaxBytes; ++i)
+    {
+        const TileKey& key = candidates[i].mKey;
+        remove(key.mLevel, key.mHandle);
+        out.push_back(key);
+        ++mEvictions;
+    }
+}
+
+size_t FSWorldMapTileCache::getTileCount() const
+{
+    size_t count = 0;
+    for (size_t level = 0; level < mTiles.size(); ++level)
+    {
+        count += mTiles[level].size();
+    }
+    return count;
+}
+
+F32 FSWorldMapTileCache::getHitRate() const
+{
+    U32 lookups = getLookupCount();
+    return lookups ? (F32)mHits / (F32)lookups : 0.f;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file fsworldmaptilecache.h
+ * @brief Request budget and memory bounded LRU for world map tiles
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_WORLDMAPTILECACHE_H
+#define FS_WORLDMAPTILECACHE_H
+
+#include <unordered_map>
+#include <vector>
+
+// Bookkeeping for the tiles of the world map mipmap. The mipmap still loads
+// and decodes tiles through the texture pipeline; this decides which tiles
+// to ask for and which to let go:
+// - Tiles the map wants to draw are queued with a priority and only a
+//   bounded number of them is loading at any time. The queue is rebuilt
+//   every frame, so tiles panned or zoomed away from are never requested.
+// - Loaded tiles are kept in a least recently used list bounded by their
+//   decoded size. Tiles of finer levels go first, the coarse levels stay
+//   around as placeholders while finer ones load.
+// Levels are numbered from 1 (finest) like the mipmap levels.
+class FSWorldMapTileCache
+{
+public:
+    struct TileKey
+    {
+        S32 mLevel;
+        U64 mHandle;
+    };
+
+    explicit FSWorldMapTileCache(S32 levels);
+
+    // max_in_flight 0 loads every wanted tile right away
+    void setBudget(U32 max_bytes, U32 max_in_flight);
+    bool isBounded() const { return mMaxInFlight > 0; }
+
+    // Call once per frame after the tiles of the frame were looked up
+    void beginFrame();
+    void clear();
+
+    // The map looked up a tile it has: marks it as used this frame
+    void touch(S32 level, U64 handle);
+    // The map wants a tile it does not have; lower priorities load first
+    void want(S32 level, U64 handle, F32 priority);
+    bool isWanted(S32 level, U64 handle) const;
+
+    // Moves the wanted tiles that may start loading now into out, most
+    // urgent first and coarser levels before finer ones at equal priority,
+    // and tracks them as loading
+    void takeRequests(std::vector<TileKey>& out);
+
+    // Tracks a tile the map started loading by itself
+    void addTile(S32 level, U64 handle);
+    // A loading tile finished, bytes is its decoded size or 0 if missing
+    void setLoaded(S32 level, U64 handle, U32 bytes);
+    bool isLoading(S32 level, U64 handle) const;
+    void remove(S32 level, U64 handle);
+
+    // Picks tiles to drop: loading tiles nobody looked at last frame, then
+    // least recently used tiles while over the byte budget. Tiles used last
+    // frame are never picked.
+    void evict(std::vector<TileKey>& out);
+
+    size_t getTileCount() const;
+    U32 getInFlightCount() const { return mInFlight; }
+    U64 getResidentBytes() const { return mResidentBytes; }
+
+    // Counted over the whole session
+    U32 getLookupCount() const { return mHits + mMisses + mPending; }
+    U32 getHitCount() const { return mHits; }
+    U32 getMissCount() const { return mMisses; }
+    U32 getRequestCount() const { return mRequests; }
+    U32 getEvictionCount() const { return mEvictions; }
+    U64 getLoadedBytes() const { return mLoadedBytes; }
+    F32 getHitRate() const;
+
+private:
+    struct Tile
+    {
+        U32     mLastUsed;
+        U32     mBytes;
+        bool    mLoading;
+    };
+    typedef std::unordered_map<U64, Tile> tile_map_t;
+
+    struct Wanted
+    {
+        TileKey mKey;
+        F32     mPriority;
+    };
+    typedef std::unordered_map<U64, size_t> wanted_index_t;
+
+    Tile* find(S32 level, U64 handle);
+    const Tile* find(S32 level, U64 handle) const;
+    void erase(S32 level, tile_map_t::iterator it);
+
+    std::vector<tile_map_t>     mTiles;         // per level, level 1 first
+    std::vector<Wanted>         mWanted;        // this frame, in order of lookup
+    std::vector<wanted_index_t> mWantedIndex;   // per level, handle to mWanted index
+
+    U32     mFrame;
+    U32     mMaxInFlight;
+    U64     mMaxBytes;
+    U32     mInFlight;
+    U64     mResidentBytes;
+
+    U32     mHits;
+    U32     mMisses;
+    U32     mPending;
+    U32     mRequests;
+    U32     mEvictions;
+    U64     mLoadedBytes;
+};
+
+#endif // FS_WORLDMAPTILECACHE_H
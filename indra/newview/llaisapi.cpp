@@ -32,6 +32,7 @@
 #include "llappviewer.h"
 #include "llcallbacklist.h"
 #include "llinventorymodel.h"
+#include "llinventorymodelbackgroundfetch.h" // <FS/>
 #include "llinventoryobserver.h"
 #include "llnotificationsutil.h"
 #include "llsdutil.h"
@@ -41,6 +42,7 @@
 #include "llviewercontrol.h"
 
 #include "llviewernetwork.h"
+#include "workqueue.h" // <FS/>
 
 ///----------------------------------------------------------------------------
 /// Classes for AISv3 support.
@@ -59,6 +61,16 @@ const S32 MAX_SIMULTANEOUS_COROUTINES = 2048;
 // Specify own depth to be able to anticipate it and mark folders as incomplete
 const S32 MAX_FOLDER_DEPTH_REQUEST = 50;
 
+// <FS> Responses with fewer embedded objects are unpacked on the main thread,
+// the thread hop would cost more than it saves
+const S32 MIN_PREPARED_OBJECTS = 64;
+// Changes applied before observers get notified even if the time slice
+// has not run out, bounds the cost of a single notification
+const S32 MAX_BATCH_BACKLOG = 2000;
+// Updates this large get their statistics logged
+const S32 MIN_REPORTED_OBJECTS = 1000;
+// </FS>
+
 //-------------------------------------------------------------------------
 /*static*/
 bool AISAPI::isAvailable()
@@ -83,6 +95,13 @@ void AISAPI::getCapNames(LLSD& capNames)
 /*static*/
 std::string AISAPI::getInvCap()
 {
+    // <FS> Allow pointing AIS at a local stand-in service for benchmarks
+    static LLCachedControl<std::string> cap_override(gSavedSettings, "FSAISCapOverride");
+    if (!cap_override().empty())
+    {
+        return cap_override;
+    }
+    // </FS>
     if (gAgent.getRegion())
     {
         return gAgent.getRegion()->getCapability(INVENTORY_CAP_NAME);
@@ -847,9 +866,39 @@ void AISAPI::onUpdateReceived(const LLSD& update, COMMAND_TYPE type, const LLSD&
         dump_sequential_xml(gAgentAvatarp->getFullname() + "_ais_update", update);
     }
 
-    AISUpdate ais_update(update, type, request_body);
+    // <FS> Unpack large responses on a worker thread. The coroutine waits
+    // for the result, the main thread keeps running meanwhile.
+    //AISUpdate ais_update(update, type, request_body);
+    AISUpdate::PreparedObjects prepared;
+    F32 prepare_wait = 0.f;
+    static LLCachedControl<bool> threaded_unpack(gSavedSettings, "FSAISThreadedUnpack");
+    if (threaded_unpack && !LLCoros::getName().empty() && AISUpdate::shouldPrepare(update, type))
+    {
+        auto general_queue = LL::WorkQueue::getInstance("General");
+        if (general_queue)
+        {
+            try
+            {
+                general_queue->waitForResult([&update, &prepared]()
+                    {
+                        FSMemTagScope mem_tag(FSMT_INVENTORY); // <FS/> Memory tags
+                        AISUpdate::prepareObjects(update, prepared);
+                    });
+            }
+            catch (const LL::WorkQueue::Closed&)
+            {
+                // Shutting down, unpack on this thread instead
+                prepared.mItems.clear();
+                prepared.mCategories.clear();
+            }
+            prepare_wait = timer.getElapsedTimeF32();
+        }
+    }
+    AISUpdate ais_update(update, type, request_body, &prepared);
+    // </FS>
     ais_update.doUpdate(); // execute the updates in the appropriate order.
     LL_DEBUGS("Inventory", "AIS3") << "Elapsed processing: " << timer.getElapsedTimeF32() << LL_ENDL;
+    ais_update.reportStats(prepare_wait, timer.getElapsedTimeF32()); // <FS/>
 }
 
 /*static*/
@@ -1024,8 +1073,17 @@ void AISAPI::InvokeAISCommandCoro(LLCoreHttpUtil::HttpCoroutineAdapter::ptr_t ht
 }
 
 //-------------------------------------------------------------------------
-AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body)
-: mType(type)
+// <FS>
+//AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body)
+//: mType(type)
+AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body, PreparedObjects* prepared)
+: mType(type),
+  mPrepared(prepared),
+  mPreparedUsed(0),
+  mBatches(0),
+  mSlices(0),
+  mMaxSliceTime(0.f)
+// </FS>
 {
     mFetch = (type == AISAPI::FETCHITEM)
         || (type == AISAPI::FETCHCATEGORYCHILDREN)
@@ -1043,6 +1101,7 @@ AISUpdate::AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD&
 
     mTimer.setTimerExpirySec(AIS_EXPIRY_SECONDS);
     mTimer.start();
+    mSliceTimer.reset(); // <FS/>
     parseUpdate(update);
 }
 
@@ -1065,9 +1124,14 @@ void AISUpdate::checkTimeout()
 {
     if (mTimer.hasExpired())
     {
+        // <FS>
+        mMaxSliceTime = llmax(mMaxSliceTime, mSliceTimer.getElapsedTimeF32().value());
+        ++mSlices;
+        // </FS>
         llcoro::suspend();
         LLCoros::checkStop();
         mTimer.setTimerExpirySec(AIS_EXPIRY_SECONDS);
+        mSliceTimer.reset(); // <FS/>
     }
 }
 
@@ -1196,14 +1260,33 @@ void AISUpdate::parseContent(const LLSD& update)
 void AISUpdate::parseItem(const LLSD& item_map)
 {
     LLUUID item_id = item_map["item_id"].asUUID();
-    LLPointer<LLViewerInventoryItem> new_item(new LLViewerInventoryItem);
+    // <FS> Take the copy unpacked on the worker unless there are current values to default to
+    //LLPointer<LLViewerInventoryItem> new_item(new LLViewerInventoryItem);
+    //LLViewerInventoryItem *curr_item = gInventory.getItem(item_id);
+    //if (curr_item)
+    //{
+    //    // Default to current values where not provided.
+    //    new_item->copyViewerItem(curr_item);
+    //}
+    //BOOL rv = new_item->unpackMessage(item_map);
     LLViewerInventoryItem *curr_item = gInventory.getItem(item_id);
-    if (curr_item)
+    LLPointer<LLViewerInventoryItem> new_item;
+    if (!curr_item)
     {
-        // Default to current values where not provided.
-        new_item->copyViewerItem(curr_item);
+        new_item = takePreparedItem(item_map);
     }
-    BOOL rv = new_item->unpackMessage(item_map);
+    BOOL rv = new_item.notNull();
+    if (!rv)
+    {
+        new_item = new LLViewerInventoryItem;
+        if (curr_item)
+        {
+            // Default to current values where not provided.
+            new_item->copyViewerItem(curr_item);
+        }
+        rv = new_item->unpackMessage(item_map);
+    }
+    // </FS>
     if (rv)
     {
         if (mFetch)
@@ -1241,14 +1324,33 @@ void AISUpdate::parseItem(const LLSD& item_map)
 void AISUpdate::parseLink(const LLSD& link_map, S32 depth)
 {
     LLUUID item_id = link_map["item_id"].asUUID();
-    LLPointer<LLViewerInventoryItem> new_link(new LLViewerInventoryItem);
+    // <FS> Take the copy unpacked on the worker unless there are current values to default to
+    //LLPointer<LLViewerInventoryItem> new_link(new LLViewerInventoryItem);
+    //LLViewerInventoryItem *curr_link = gInventory.getItem(item_id);
+    //if (curr_link)
+    //{
+    //    // Default to current values where not provided.
+    //    new_link->copyViewerItem(curr_link);
+    //}
+    //BOOL rv = new_link->unpackMessage(link_map);
     LLViewerInventoryItem *curr_link = gInventory.getItem(item_id);
-    if (curr_link)
+    LLPointer<LLViewerInventoryItem> new_link;
+    if (!curr_link)
     {
-        // Default to current values where not provided.
-        new_link->copyViewerItem(curr_link);
+        new_link = takePreparedItem(link_map);
     }
-    BOOL rv = new_link->unpackMessage(link_map);
+    BOOL rv = new_link.notNull();
+    if (!rv)
+    {
+        new_link = new LLViewerInventoryItem;
+        if (curr_link)
+        {
+            // Default to current values where not provided.
+            new_link->copyViewerItem(curr_link);
+        }
+        rv = new_link->unpackMessage(link_map);
+    }
+    // </FS>
     if (rv)
     {
         const LLUUID& parent_id = new_link->getParentUUID();
@@ -1336,15 +1438,40 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
         return;
     }
 
+    // <FS> Take the copy unpacked on the worker unless there are current values to default to
+    //LLPointer<LLViewerInventoryCategory> new_cat;
+    //if (curr_cat)
+    //{
+    //    // Default to current values where not provided.
+    //    new_cat = new LLViewerInventoryCategory(curr_cat);
+    //}
+    //else
+    //{
+    //    if (category_map.has("agent_id"))
+    //    {
+    //        new_cat = new LLViewerInventoryCategory(category_map["agent_id"].asUUID());
+    //    }
+    //    else
+    //    {
+    //        LL_DEBUGS() << "No owner provided, folder might be assigned wrong owner" << LL_ENDL;
+    //        new_cat = new LLViewerInventoryCategory(LLUUID::null);
+    //    }
+    //}
+    //BOOL rv = new_cat->unpackMessage(category_map);
     LLPointer<LLViewerInventoryCategory> new_cat;
-    if (curr_cat)
+    if (!curr_cat)
     {
-        // Default to current values where not provided.
-        new_cat = new LLViewerInventoryCategory(curr_cat);
+        new_cat = takePreparedCategory(category_map);
     }
-    else
+    BOOL rv = new_cat.notNull();
+    if (!rv)
     {
-        if (category_map.has("agent_id"))
+        if (curr_cat)
+        {
+            // Default to current values where not provided.
+            new_cat = new LLViewerInventoryCategory(curr_cat);
+        }
+        else if (category_map.has("agent_id"))
         {
             new_cat = new LLViewerInventoryCategory(category_map["agent_id"].asUUID());
         }
@@ -1353,8 +1480,9 @@ void AISUpdate::parseCategory(const LLSD& category_map, S32 depth)
             LL_DEBUGS() << "No owner provided, folder might be assigned wrong owner" << LL_ENDL;
             new_cat = new LLViewerInventoryCategory(LLUUID::null);
         }
+        rv = new_cat->unpackMessage(category_map);
     }
-    BOOL rv = new_cat->unpackMessage(category_map);
+    // </FS>
     // *NOTE: unpackMessage does not unpack version or descendent count.
     if (rv)
     {
@@ -1598,6 +1726,13 @@ void AISUpdate::doUpdate()
 {
     checkTimeout();
 
+    // <FS> Fetch rate statistics
+    if (mFetch)
+    {
+        LLInventoryModelBackgroundFetch::instance().onFoldersReceived((S32)(mCategoriesCreated.size() + mCategoriesUpdated.size()));
+    }
+    // </FS>
+
     // Do version/descendant accounting.
     for (std::map<LLUUID,S32>::const_iterator catit = mCatDescendentDeltas.begin();
          catit != mCatDescendentDeltas.end(); ++catit)
@@ -1639,7 +1774,9 @@ void AISUpdate::doUpdate()
     }
 
     // CREATE CATEGORIES
-    const S32 MAX_UPDATE_BACKLOG = 50; // stall prevention
+    // <FS> Replaced by time budgeted batches
+    //const S32 MAX_UPDATE_BACKLOG = 50; // stall prevention
+    // </FS>
     for (deferred_category_map_t::const_iterator create_it = mCategoriesCreated.begin();
          create_it != mCategoriesCreated.end(); ++create_it)
     {
@@ -1650,11 +1787,14 @@ void AISUpdate::doUpdate()
         LL_DEBUGS("Inventory") << "created category " << category_id << LL_ENDL;
 
         // fetching can receive massive amount of items and folders
-        if (gInventory.getChangedIDs().size() > MAX_UPDATE_BACKLOG)
-        {
-            gInventory.notifyObservers();
-            checkTimeout();
-        }
+        // <FS> Notify observers once per time budgeted batch
+        //if (gInventory.getChangedIDs().size() > MAX_UPDATE_BACKLOG)
+        //{
+        //    gInventory.notifyObservers();
+        //    checkTimeout();
+        //}
+        checkBatch();
+        // </FS>
     }
 
     // UPDATE CATEGORIES
@@ -1711,11 +1851,14 @@ void AISUpdate::doUpdate()
         gInventory.updateItem(new_item, LLInventoryObserver::CREATE);
 
         // fetching can receive massive amount of items and folders
-        if (gInventory.getChangedIDs().size() > MAX_UPDATE_BACKLOG)
-        {
-            gInventory.notifyObservers();
-            checkTimeout();
-        }
+        // <FS> Notify observers once per time budgeted batch
+        //if (gInventory.getChangedIDs().size() > MAX_UPDATE_BACKLOG)
+        //{
+        //    gInventory.notifyObservers();
+        //    checkTimeout();
+        //}
+        checkBatch();
+        // </FS>
     }
 
     // UPDATE ITEMS
@@ -1787,3 +1930,195 @@ void AISUpdate::doUpdate()
     gInventory.notifyObservers();
 }
 
+// <FS> Worker thread unpacking and batched application of large updates.
+// Only the create loops of doUpdate() call this, they yielded before as
+// well. The update loops copy versions from the model and must not let
+// other coroutines see it half updated.
+void AISUpdate::checkBatch()
+{
+    if (mTimer.hasExpired() || (S32)gInventory.getChangedIDs().size() > MAX_BATCH_BACKLOG)
+    {
+        // Observers see everything applied during this slice at once
+        // instead of a notification every few changes
+        gInventory.notifyObservers();
+        ++mBatches;
+        checkTimeout();
+    }
+}
+
+//static
+bool AISUpdate::shouldPrepare(const LLSD& update, AISAPI::COMMAND_TYPE type)
+{
+    if (type != AISAPI::FETCHCATEGORYCHILDREN
+        && type != AISAPI::FETCHCATEGORYCATEGORIES
+        && type != AISAPI::FETCHCATEGORYSUBSET
+        && type != AISAPI::FETCHCOF
+        && type != AISAPI::FETCHCATEGORYLINKS
+        && type != AISAPI::FETCHORPHANS)
+    {
+        return false;
+    }
+
+    // Count embedded objects breadth first, stop as soon as there are enough
+    S32 count = 0;
+    std::vector<const LLSD*> pending(1, &update);
+    while (!pending.empty() && count < MIN_PREPARED_OBJECTS)
+    {
+        const LLSD* node = pending.back();
+        pending.pop_back();
+        if (!node->has("_embedded"))
+        {
+            continue;
+        }
+        const LLSD& embedded = (*node)["_embedded"];
+        count += embedded["links"].size() + embedded["items"].size();
+        const LLSD& categories = embedded["categories"];
+        count += categories.size();
+        for (LLSD::map_const_iterator it = categories.beginMap(); it != categories.endMap(); ++it)
+        {
+            pending.push_back(&it->second);
+        }
+    }
+    return count >= MIN_PREPARED_OBJECTS;
+}
+
+//static
+void AISUpdate::prepareObjects(const LLSD& update, PreparedObjects& prepared)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    LLTimer timer;
+
+    // Same shape as parseContent(), but everything is unpacked; filtering
+    // and the model lookups stay on the main thread
+    if (update.has("item_id") && update.has("parent_id"))
+    {
+        prepareItem(update, prepared);
+    }
+    else if (update.has("category_id") && update.has("parent_id"))
+    {
+        prepareCategory(update, prepared);
+    }
+    else if (update.has("_embedded"))
+    {
+        prepareEmbedded(update["_embedded"], prepared);
+    }
+
+    prepared.mTime = timer.getElapsedTimeF32();
+}
+
+//static
+void AISUpdate::prepareItem(const LLSD& item_map, PreparedObjects& prepared)
+{
+    // unpackMessage() without the name localization, its dictionary is a
+    // main thread singleton built from LLTrans strings. takePreparedItem()
+    // localizes the name.
+    LLPointer<LLViewerInventoryItem> new_item(new LLViewerInventoryItem);
+    if (new_item->LLInventoryItem::fromLLSD(item_map))
+    {
+        new_item->setComplete(true);
+        prepared.mItems[&item_map] = new_item;
+    }
+
+    // Links carry the linked item or category
+    if (item_map.has("_embedded"))
+    {
+        prepareEmbedded(item_map["_embedded"], prepared);
+    }
+}
+
+//static
+void AISUpdate::prepareCategory(const LLSD& category_map, PreparedObjects& prepared)
+{
+    // Localized in takePreparedCategory(), see prepareItem()
+    LLPointer<LLViewerInventoryCategory> new_cat(new LLViewerInventoryCategory(category_map["agent_id"].asUUID()));
+    if (new_cat->LLInventoryCategory::fromLLSD(category_map))
+    {
+        prepared.mCategories[&category_map] = new_cat;
+    }
+
+    if (category_map.has("_embedded"))
+    {
+        prepareEmbedded(category_map["_embedded"], prepared);
+    }
+}
+
+//static
+void AISUpdate::prepareEmbedded(const LLSD& embedded, PreparedObjects& prepared)
+{
+    const LLSD& links = embedded["links"];
+    for (LLSD::map_const_iterator it = links.beginMap(); it != links.endMap(); ++it)
+    {
+        prepareItem(it->second, prepared);
+    }
+    const LLSD& items = embedded["items"];
+    for (LLSD::map_const_iterator it = items.beginMap(); it != items.endMap(); ++it)
+    {
+        prepareItem(it->second, prepared);
+    }
+    if (embedded["item"].has("item_id"))
+    {
+        prepareItem(embedded["item"], prepared);
+    }
+    const LLSD& categories = embedded["categories"];
+    for (LLSD::map_const_iterator it = categories.beginMap(); it != categories.endMap(); ++it)
+    {
+        prepareCategory(it->second, prepared);
+    }
+    if (embedded["category"].has("category_id"))
+    {
+        prepareCategory(embedded["category"], prepared);
+    }
+}
+
+LLPointer<LLViewerInventoryItem> AISUpdate::takePreparedItem(const LLSD& item_map)
+{
+    LLPointer<LLViewerInventoryItem> item;
+    if (mPrepared)
+    {
+        PreparedObjects::item_map_t::iterator it = mPrepared->mItems.find(&item_map);
+        if (it != mPrepared->mItems.end())
+        {
+            item = it->second;
+            item->localizeName();
+            mPrepared->mItems.erase(it);
+            ++mPreparedUsed;
+        }
+    }
+    return item;
+}
+
+LLPointer<LLViewerInventoryCategory> AISUpdate::takePreparedCategory(const LLSD& category_map)
+{
+    LLPointer<LLViewerInventoryCategory> category;
+    if (mPrepared)
+    {
+        PreparedObjects::category_map_t::iterator it = mPrepared->mCategories.find(&category_map);
+        if (it != mPrepared->mCategories.end())
+        {
+            category = it->second;
+            category->localizeName();
+            mPrepared->mCategories.erase(it);
+            ++mPreparedUsed;
+        }
+    }
+    return category;
+}
+
+void AISUpdate::reportStats(F32 prepare_wait, F32 total_time) const
+{
+    const S32 objects = (S32)(mCategoriesCreated.size() + mCategoriesUpdated.size() + mItemsCreated.size() + mItemsUpdated.size());
+    const F32 max_slice = llmax(mMaxSliceTime, mSliceTimer.getElapsedTimeF32().value());
+    if (objects >= MIN_REPORTED_OBJECTS)
+    {
+        LL_INFOS("Inventory") << "AIS update applied " << objects << " objects (" << mPreparedUsed << " unpacked on worker in "
+            << (mPrepared ? mPrepared->mTime * 1000.f : 0.f) << " ms), " << mBatches + 1 << " batches, "
+            << mSlices + 1 << " slices, longest slice " << max_slice * 1000.f << " ms, waited "
+            << prepare_wait * 1000.f << " ms, total " << total_time * 1000.f << " ms" << LL_ENDL;
+    }
+    else
+    {
+        LL_DEBUGS("Inventory", "AIS3") << "Applied " << objects << " objects, " << mPreparedUsed << " unpacked on worker, "
+            << mSlices + 1 << " slices, longest slice " << max_slice * 1000.f << " ms" << LL_ENDL;
+    }
+}
+// </FS>
@@ -31,6 +31,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map> // <FS/>
 #include "llviewerinventory.h"
 #include "llcorehttputil.h"
 #include "llcoproceduremanager.h"
@@ -110,7 +111,30 @@ private:
 class AISUpdate
 {
 public:
-    AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body);
+    // <FS> Inventory objects unpacked from a response on a worker thread,
+    // keyed by the response node they were unpacked from.
+    struct PreparedObjects
+    {
+        typedef std::unordered_map<const LLSD*, LLPointer<LLViewerInventoryItem> > item_map_t;
+        typedef std::unordered_map<const LLSD*, LLPointer<LLViewerInventoryCategory> > category_map_t;
+        item_map_t      mItems;
+        category_map_t  mCategories;
+        F32             mTime{ 0.f };  // seconds spent unpacking on the worker
+    };
+
+    // True if the response carries enough embedded content to be worth
+    // unpacking on a worker thread
+    static bool shouldPrepare(const LLSD& update, AISAPI::COMMAND_TYPE type);
+
+    // Unpacks every item, link and category of a response into new objects.
+    // Reads the response only and never touches the inventory model or the
+    // name localization, so it can run on a worker thread while the owning
+    // coroutine waits. Names get localized when the objects are taken.
+    static void prepareObjects(const LLSD& update, PreparedObjects& prepared);
+
+    //AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body);
+    AISUpdate(const LLSD& update, AISAPI::COMMAND_TYPE type, const LLSD& request_body, PreparedObjects* prepared = NULL);
+    // </FS>
     void parseUpdate(const LLSD& update);
     void parseMeta(const LLSD& update);
     void parseContent(const LLSD& update);
@@ -126,10 +150,20 @@ public:
     void parseEmbeddedItem(const LLSD& item);
     void parseEmbeddedCategory(const LLSD& category, S32 depth);
     void doUpdate();
+    void reportStats(F32 prepare_wait, F32 total_time) const; // <FS/>
 private:
     void clearParseResults();
     void checkTimeout();
 
+    // <FS> Worker side unpacking and batched application
+    static void prepareItem(const LLSD& item_map, PreparedObjects& prepared);
+    static void prepareCategory(const LLSD& category_map, PreparedObjects& prepared);
+    static void prepareEmbedded(const LLSD& embedded, PreparedObjects& prepared);
+    LLPointer<LLViewerInventoryItem> takePreparedItem(const LLSD& item_map);
+    LLPointer<LLViewerInventoryCategory> takePreparedCategory(const LLSD& category_map);
+    void checkBatch();
+    // </FS>
+
     // Fetch can return large packets of data, throttle it to not cause lags
     // Todo: make throttle work over all fetch requests isntead of per-request
     const F32 AIS_EXPIRY_SECONDS = 0.008f;
@@ -156,6 +190,15 @@ private:
     S32 mFetchDepth;
     LLTimer mTimer;
     AISAPI::COMMAND_TYPE mType;
+
+    // <FS> Prepared objects and statistics of this update
+    PreparedObjects* mPrepared;
+    U32 mPreparedUsed;
+    U32 mBatches;           // observer notifications sent while applying
+    U32 mSlices;            // main thread time slices used
+    F32 mMaxSliceTime;      // longest main thread stretch without yielding
+    LLTimer mSliceTimer;
+    // </FS>
 };
 
 #endif
@@ -288,6 +288,9 @@ using namespace LL;
 
 #include "fsradar.h"
 #include "fsassetblacklist.h"
+#include "fsframearena.h"
+#include "fseventchannel.h"
+#include "fsregionprefetch.h"
 
 // #include "fstelemetry.h" // <FS:Beq> Tracy profiler support
 
@@ -1570,8 +1573,12 @@ bool LLAppViewer::doFrame()
         LLWorld::createInstance();
     }
 
-    LLEventPump& mainloop(LLEventPumps::instance().obtain("mainloop"));
-    LLSD newFrame;
+    // <FS> Typed mainloop channel, passes the tick on to the "mainloop" LLEventPump
+    //LLEventPump& mainloop(LLEventPumps::instance().obtain("mainloop"));
+    //LLSD newFrame;
+    FSEventChannel<FSMainloopEvent>& mainloop(fs_mainloop_channel());
+    const FSMainloopEvent newFrame;
+    // </FS>
     LLTimer frameTimer; // <FS:Beq/> relocated - <FS:Ansariel> FIRE-22297: FPS limiter not working properly on Mac/Linux
     {
         LLPerfStats::RecordSceneTime T (LLPerfStats::StatType_t::RENDER_IDLE); // perf stats
@@ -1898,6 +1905,8 @@ bool LLAppViewer::doFrame()
             }
             pingMainloopTimeout("Main:End");
         }
+
+        FSFrameArena::instance().reset(); // <FS/> Frame arena
     }
 
     if (LLApp::isExiting())
@@ -2237,6 +2246,13 @@ bool LLAppViewer::cleanup()
     //  gDXHardware.cleanup();
     //#endif // LL_WINDOWS
 
+    // <FS> Region prefetch
+    if (FSRegionPrefetch::instanceExists())
+    {
+        FSRegionPrefetch::instance().releaseHeldAssets();
+    }
+    // </FS>
+
     LLVolumeMgr* volume_manager = LLPrimitive::getVolumeManager();
     if (!volume_manager->cleanup())
     {
@@ -37,6 +37,7 @@
 #include "llwindowsdl.h"
 #include "llmd5.h"
 #include "llfindlocale.h"
+#include "llerrorcontrol.h" // <FS/> Asynchronous logging
 
 #include <exception>
 
@@ -172,6 +173,7 @@ std::string gCrashBehavior;
 
 static bool dumpCallback(const google_breakpad::MinidumpDescriptor& descriptor, void* context, bool succeeded)
 {
+    LLError::flushAsyncLogging(); // <FS/> Asynchronous logging
     if( fork() == 0 )
         execl( gCrashLogger.c_str(), gCrashLogger.c_str(), descriptor.path(), gVersion.c_str(), gBugsplatDB.c_str(),  gCrashBehavior.c_str(), nullptr );
     return succeeded;
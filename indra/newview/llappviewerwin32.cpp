@@ -127,6 +127,8 @@ namespace
     {
         if (nCode == MDSCB_EXCEPTIONCODE)
         {
+            LLError::flushAsyncLogging(); // <FS/> Asynchronous logging: the log is copied below
+
             // <FS:ND> Save dump and log into unique crash dymp folder
             __wchar_t aBuffer[1024] = {};
             sBugSplatSender->getMinidumpPath(aBuffer, _countof(aBuffer));
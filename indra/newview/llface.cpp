@@ -60,6 +60,7 @@
 #include "rlvhandler.h"
 // [/RLVa:KB]
 #include "llperfstats.h"
+#include "fscamerapredictor.h" // <FS> Predictive LOD
 
 #if LL_LINUX
 // Work-around spurious used before init warning on Vector4a
@@ -2328,6 +2329,26 @@ BOOL LLFace::calcPixelArea(F32& cos_angle_to_view_dir, F32& radius)
         mImportanceToCamera = LLFace::calcImportanceToCamera(cos_angle_to_view_dir, dist) ;
     }
 
+    // <FS> Predictive texture priority: also weigh the face as seen from where a moving camera is heading
+    F32 future_dist, future_cos;
+    if (gCameraPredictor.getFutureView(LLVector3(center.getF32ptr()), future_dist, future_cos))
+    {
+        future_dist = llmax(future_dist - size.getLength3().getF32(), 0.001f);
+        if (future_dist < 16.f)
+        {
+            future_dist /= 16.f;
+            future_dist *= future_dist;
+            future_dist *= 16.f;
+        }
+
+        F32 future_radius = atanf((F32) sqrt(size_squared) / future_dist) * LLDrawable::sCurPixelAngle;
+        mPixelArea = gCameraPredictor.blendWithFuture(mPixelArea, future_radius * future_radius * 3.14159f);
+
+        F32 future_importance = future_dist < mBoundingSphereRadius ? 1.f : LLFace::calcImportanceToCamera(future_cos, future_dist);
+        mImportanceToCamera = gCameraPredictor.blendWithFuture(mImportanceToCamera, future_importance);
+    }
+    // </FS>
+
     return true ;
 }
 
@@ -73,6 +73,10 @@
 // <FS:ND> For ll_pretty_print_sd
 #include "llsdutil.h"
 // </FS:ND>
+// <FS> Member data unpacked on a worker
+#include "llviewercontrol.h"
+#include "workqueue.h"
+// </FS>
 
 #if LL_MSVC
 #pragma warning(push)
@@ -87,6 +91,7 @@
 #endif
 
 const U32 MAX_CACHED_GROUPS = 20;
+const F32 GROUP_MEMBER_APPLY_SECONDS = 0.005f; // <FS/> Main thread time per slice of a member data update
 
 //
 // LLRoleActionSet
@@ -448,6 +453,7 @@ void LLGroupMgrGroupData::removeMemberData()
         delete mi->second;
     }
     mMembers.clear();
+    mMemberTable.clear(); // <FS/>
     mMemberDataComplete = false;
     mMemberVersion.generate();
 }
@@ -950,7 +956,10 @@ static void formatDateString(std::string &date_string)
 {
     using namespace boost;
     cmatch result;
-    const regex expression("([0-9]{1,2})/([0-9]{1,2})/([0-9]{4})");
+    // <FS> Compile once, this runs for every member of a group
+    //const regex expression("([0-9]{1,2})/([0-9]{1,2})/([0-9]{4})");
+    static const regex expression("([0-9]{1,2})/([0-9]{1,2})/([0-9]{4})");
+    // </FS>
     if (regex_match(date_string.c_str(), result, expression))
     {
         // convert matches to integers so that we can pad them with zeroes on Linux
@@ -1014,6 +1023,7 @@ void LLGroupMgr::processGroupMembersReply(LLMessageSystem* msg, void** data)
 
             if (member_id.notNull())
             {
+                const U32 last_login = FSGroupMemberTable::lastLoginKey(online_status); // <FS/>
                 if (online_status == "Online")
                 {
                     static std::string localized_online(LLTrans::getString("group_member_status_online"));
@@ -1039,6 +1049,7 @@ void LLGroupMgr::processGroupMembersReply(LLMessageSystem* msg, void** data)
                 }
 #endif
                 group_datap->mMembers[member_id] = newdata;
+                group_datap->mMemberTable.setMember(member_id, contribution, agent_powers, title, online_status, last_login, is_owner); // <FS/>
             }
             else
             {
@@ -2009,6 +2020,7 @@ void LLGroupMgr::sendGroupMemberEjects(const LLUUID& group_id,
                 }
 
                 group_datap->mMembers.erase(ejected_member_id);
+                group_datap->mMemberTable.removeMember(ejected_member_id); // <FS/>
 
                 // member_data was introduced and is used here instead of (*mit).second to avoid crash because of invalid iterator
                 // It becomes invalid after line with erase above. EXT-4778
@@ -2250,6 +2262,13 @@ void LLGroupMgr::sendCapGroupMembersRequest(const LLUUID& group_id)
 
     // Get our capability
     std::string cap_url =  currentRegion->getCapability("GroupMemberData");
+    // <FS> Allow pointing the member data at a local stand-in service for benchmarks
+    static LLCachedControl<std::string> cap_override(gSavedSettings, "FSGroupMemberDataCapOverride");
+    if (!cap_override().empty())
+    {
+        cap_url = cap_override;
+    }
+    // </FS>
 
     // Thank you FS:Ansariel!
     if(cap_url.empty())
@@ -2305,57 +2324,105 @@ void LLGroupMgr::processCapGroupMembersRequest(const LLSD& content)
     LLSD    titles      = content["titles"];
     LLSD    defaults    = content["defaults"];
 
-    std::string online_status;
-    std::string title;
-    S32         contribution;
-    U64         member_powers;
-    // If this is changed to a bool, make sure to change the LLGroupMemberData constructor
-    BOOL        is_owner;
-
     // Compute this once, rather than every time.
     U64 default_powers  = llstrtou64(defaults["default_powers"].asString().c_str(), NULL, 16);
 
-    LLSD::map_const_iterator member_iter_start  = member_list.beginMap();
-    LLSD::map_const_iterator member_iter_end    = member_list.endMap();
-    for( ; member_iter_start != member_iter_end; ++member_iter_start)
-    {
-        // Reset defaults
-        online_status   = "unknown";
-        title           = titles[0].asString();
-        contribution    = 0;
-        member_powers   = default_powers;
-        is_owner        = false;
+    // <FS> Unpack the members into a column table on a worker, then create
+    // the member data from it in time slices. Status strings are formatted
+    // once per distinct value instead of once per member.
+    LLTimer total_timer;
+    FSGroupMemberTable table;
+    bool unpacked_on_worker = false;
+    const bool in_coroutine = !LLCoros::getName().empty();
+    static LLCachedControl<bool> threaded_unpack(gSavedSettings, "FSGroupMembersThreadedUnpack");
+    if (threaded_unpack && in_coroutine)
+    {
+        auto general_queue = LL::WorkQueue::getInstance("General");
+        if (general_queue)
+        {
+            try
+            {
+                general_queue->waitForResult([&table, &member_list, &titles, default_powers]()
+                    {
+                        table.addCapabilityMembers(member_list, titles, default_powers);
+                    });
+                unpacked_on_worker = true;
+            }
+            catch (const LL::WorkQueue::Closed&)
+            {
+                // Shutting down, unpack on this thread instead
+                table.clear();
+            }
 
-        const LLUUID member_id(member_iter_start->first);
-        LLSD member_info = member_iter_start->second;
+            // The group may have been dropped meanwhile
+            group_datap = getGroupData(group_id);
+            if (!group_datap)
+            {
+                return;
+            }
+        }
+    }
+    if (!unpacked_on_worker)
+    {
+        table.addCapabilityMembers(member_list, titles, default_powers);
+    }
+    const F32 unpack_time = total_timer.getElapsedTimeF32();
 
-        if(member_info.has("last_login"))
+    table.formatStatuses([](std::string& online_status)
         {
-            online_status = member_info["last_login"].asString();
-            if(online_status == "Online")
-                online_status = LLTrans::getString("group_member_status_online");
+            if (online_status == "Online")
+            {
+                static const std::string localized_online(LLTrans::getString("group_member_status_online"));
+                online_status = localized_online;
+            }
             else
+            {
                 formatDateString(online_status);
-        }
-
-        if(member_info.has("title"))
-            title = titles[member_info["title"].asInteger()].asString();
-
-        if(member_info.has("powers"))
-            member_powers = llstrtou64(member_info["powers"].asString().c_str(), NULL, 16);
+            }
+        });
+
+    // Observers see the progress like with the UDP replies, the complete
+    // list once every member is in
+    group_datap->mMemberDataComplete = false;
+    const LLUUID member_version = group_datap->getMemberVersion();
+    const U32 member_count = table.size();
+    const U32 title_count = table.getTitleCount();
+    const U32 status_count = table.getStatusCount();
+    U32 slices = 1;
+    F32 max_slice = 0.f;
+    LLTimer slice_timer;
+    LLTimer slice_expiry;
+    slice_expiry.setTimerExpirySec(GROUP_MEMBER_APPLY_SECONDS);
+
+    for (U32 row = 0; row < member_count; row++)
+    {
+        if (in_coroutine && slice_expiry.hasExpired())
+        {
+            max_slice = llmax(max_slice, slice_timer.getElapsedTimeF32().value());
+            ++slices;
+            group_datap->mChanged = TRUE;
+            notifyObservers(GC_MEMBER_DATA);
 
-        if(member_info.has("donated_square_meters"))
-            contribution = member_info["donated_square_meters"];
+            llcoro::suspend();
+            LLCoros::checkStop();
 
-        if(member_info.has("owner"))
-            is_owner = true;
+            group_datap = getGroupData(group_id);
+            if (!group_datap || group_datap->getMemberVersion() != member_version)
+            {
+                LL_INFOS("GrpMgr") << "Member data of group " << group_id << " changed while it was applied, dropped" << LL_ENDL;
+                return;
+            }
+            slice_expiry.setTimerExpirySec(GROUP_MEMBER_APPLY_SECONDS);
+            slice_timer.reset();
+        }
 
+        const LLUUID& member_id = table.getID(row);
         LLGroupMemberData* data = new LLGroupMemberData(member_id,
-            contribution,
-            member_powers,
-            title,
-            online_status,
-            is_owner);
+            table.getContribution(row),
+            table.getPowers(row),
+            table.getTitle(row),
+            table.getStatus(row),
+            table.isOwner(row));
 
         LLGroupMemberData* member_old = group_datap->mMembers[member_id];
         if (member_old && group_datap->mRoleMemberDataComplete)
@@ -2375,6 +2442,26 @@ void LLGroupMgr::processCapGroupMembersRequest(const LLSD& content)
 
         group_datap->mMembers[member_id] = data;
     }
+    max_slice = llmax(max_slice, slice_timer.getElapsedTimeF32().value());
+
+    if (group_datap->mMemberTable.empty())
+    {
+        group_datap->mMemberTable.swap(table);
+    }
+    else
+    {
+        for (U32 row = 0; row < member_count; row++)
+        {
+            group_datap->mMemberTable.setMember(table.getID(row), table.getContribution(row), table.getPowers(row),
+                table.getTitle(row), table.getStatus(row), table.getLastLogin(row), table.isOwner(row));
+        }
+    }
+
+    LL_INFOS("GrpMgr") << "Group member data applied " << member_count << " members (" << title_count << " titles, "
+        << status_count << " status strings), unpacked " << (unpacked_on_worker ? "on worker " : "") << "in "
+        << unpack_time * 1000.f << " ms, " << slices << " slices, longest slice " << max_slice * 1000.f
+        << " ms, total " << total_timer.getElapsedTimeF32().value() * 1000.f << " ms" << LL_ENDL;
+    // </FS>
 
     group_datap->mMemberVersion.generate();
 
@@ -34,6 +34,7 @@
 #include <map>
 #include "lleventcoro.h"
 #include "llcoros.h"
+#include "fsgroupmembertable.h" // <FS/> Columnar member data
 
 // Forward Declarations
 class LLMessageSystem;
@@ -296,6 +297,7 @@ public:
     typedef std::map<LLUUID,LLGroupBanData> ban_list_t;
 
     member_list_t       mMembers;
+    FSGroupMemberTable  mMemberTable; // <FS/> Same members in columns, kept in step with mMembers
     role_list_t         mRoles;
     change_map_t        mRoleMemberChanges;
     role_data_map_t     mRoleChanges;
@@ -48,6 +48,7 @@
 #include "llstatusbar.h"
 #include "llmenugl.h"
 #include "pipeline.h"
+#include "fsnametaggrid.h" // <FS/>
 #include <boost/tokenizer.hpp>
 
 
@@ -102,7 +103,11 @@ LLHUDNameTag::LLHUDNameTag(const U8 type)
     mTextAlignment(ALIGN_TEXT_CENTER),
     mVertAlignment(ALIGN_VERT_CENTER),
     mLOD(0),
-    mHidden(FALSE)
+    mHidden(FALSE),
+    // <FS> Cached tag size
+    mSizeDirty(true),
+    mSizeMaxLines(0)
+    // </FS>
 {
     LLPointer<LLHUDNameTag> ptr(this);
     sTextObjects.insert(ptr);
@@ -411,12 +416,14 @@ void LLHUDNameTag::renderText(BOOL for_select)
 void LLHUDNameTag::setString(const std::string &text_utf8)
 {
     mTextSegments.clear();
+    mSizeDirty = true; // <FS/>
     addLine(text_utf8, mColor);
 }
 
 void LLHUDNameTag::clearString()
 {
     mTextSegments.clear();
+    mSizeDirty = true; // <FS/>
 }
 
 
@@ -427,6 +434,7 @@ void LLHUDNameTag::addLine(const std::string &text_utf8,
                         const bool use_ellipses,
                         F32 max_pixels)
 {
+    mSizeDirty = true; // <FS/>
     LLWString wline = utf8str_to_wstring(text_utf8);
     if (!wline.empty())
     {
@@ -496,11 +504,13 @@ void LLHUDNameTag::addLine(const std::string &text_utf8,
 void LLHUDNameTag::setLabel(const std::string &label_utf8)
 {
     mLabelSegments.clear();
+    mSizeDirty = true; // <FS/>
     addLabel(label_utf8);
 }
 
 void LLHUDNameTag::addLabel(const std::string& label_utf8, F32 max_pixels)
 {
+    mSizeDirty = true; // <FS/>
     LLWString wstr = utf8string_to_wstring(label_utf8);
     if (!wstr.empty())
     {
@@ -540,6 +550,7 @@ void LLHUDNameTag::setZCompare(const BOOL zcompare)
 void LLHUDNameTag::setFont(const LLFontGL* font)
 {
     mFontp = font;
+    mSizeDirty = true; // <FS/>
 }
 
 
@@ -695,6 +706,15 @@ void LLHUDNameTag::updateSize()
     F32 width = 0.f;
 
     S32 max_lines = getMaxLines();
+
+    // <FS> Only measure again when the text or the number of lines shown changed
+    if (!mSizeDirty && max_lines == mSizeMaxLines)
+    {
+        return;
+    }
+    mSizeDirty = false;
+    mSizeMaxLines = max_lines;
+    // </FS>
     //S32 lines = (max_lines < 0) ? (S32)mTextSegments.size() : llmin((S32)mTextSegments.size(), max_lines);
     //F32 height = (F32)mFontp->getLineHeight() * (lines + mLabelSegments.size());
 
@@ -796,19 +816,46 @@ void LLHUDNameTag::updateAll()
         return;
     }
 
-    VisibleTextObjectIterator src_it;
+    // <FS> Only test tags that share a cell of a screen space grid instead
+    // of all pairs. Candidates are found at the start of each pass and
+    // tested again before use, as the pairwise loop did; tags that only
+    // start to overlap during a pass are picked up by the next one.
+    //VisibleTextObjectIterator src_it;
+    //
+    //for (S32 i = 0; i < NUM_OVERLAP_ITERATIONS; i++)
+    //{
+    //    for (src_it = sVisibleTextObjects.begin(); src_it != sVisibleTextObjects.end(); ++src_it)
+    //    {
+    //        LLHUDNameTag* src_textp = (*src_it);
+    //
+    //        VisibleTextObjectIterator dst_it = src_it;
+    //        ++dst_it;
+    //        for (; dst_it != sVisibleTextObjects.end(); ++dst_it)
+    //        {
+    //            LLHUDNameTag* dst_textp = (*dst_it);
+    static FSNameTagGrid overlap_grid;
+    static std::vector<LLRectf> screen_rects;
+    static FSNameTagGrid::pair_list_t overlap_pairs;
 
     for (S32 i = 0; i < NUM_OVERLAP_ITERATIONS; i++)
     {
-        for (src_it = sVisibleTextObjects.begin(); src_it != sVisibleTextObjects.end(); ++src_it)
+        screen_rects.clear();
+        for (VisibleTextObjectIterator rect_it = sVisibleTextObjects.begin(); rect_it != sVisibleTextObjects.end(); ++rect_it)
         {
-            LLHUDNameTag* src_textp = (*src_it);
+            screen_rects.push_back((*rect_it)->mSoftScreenRect);
+        }
+        overlap_grid.findOverlaps(screen_rects, BUFFER_SIZE, overlap_pairs);
+        if (overlap_pairs.empty())
+        {
+            break;
+        }
 
-            VisibleTextObjectIterator dst_it = src_it;
-            ++dst_it;
-            for (; dst_it != sVisibleTextObjects.end(); ++dst_it)
+        for (FSNameTagGrid::pair_list_t::const_iterator pair_it = overlap_pairs.begin(); pair_it != overlap_pairs.end(); ++pair_it)
+        {
             {
-                LLHUDNameTag* dst_textp = (*dst_it);
+                LLHUDNameTag* src_textp = sVisibleTextObjects[pair_it->first];
+                LLHUDNameTag* dst_textp = sVisibleTextObjects[pair_it->second];
+    // </FS>
 
                 if (src_textp->mSoftScreenRect.overlaps(dst_textp->mSoftScreenRect))
                 {
@@ -936,6 +983,7 @@ void LLHUDNameTag::reshape()
     for (text_it = sTextObjects.begin(); text_it != sTextObjects.end(); ++text_it)
     {
         LLHUDNameTag* textp = (*text_it);
+        textp->mSizeDirty = true; // <FS/>
         std::vector<LLHUDTextSegment>::iterator segment_iter;
         for (segment_iter = textp->mTextSegments.begin();
              segment_iter != textp->mTextSegments.end(); ++segment_iter )
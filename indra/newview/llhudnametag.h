@@ -183,6 +183,10 @@ private:
     BOOL            mHidden;
     LLPointer<LLUIImage> mRoundedRectImgp;
     LLPointer<LLUIImage> mRoundedRectTopImgp;
+    // <FS> Cached tag size
+    bool            mSizeDirty;     // text, label or font changed since the last updateSize()
+    S32             mSizeMaxLines;  // lines shown at the last updateSize()
+    // </FS>
 
     static BOOL    sDisplayText ;
     static std::set<LLPointer<LLHUDNameTag> > sTextObjects;
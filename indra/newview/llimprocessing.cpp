@@ -73,6 +73,7 @@
 #include "exogroupmutelist.h"
 #include "fscommon.h"
 #include "fsdata.h"
+#include "fsimpipeline.h"
 #include "fskeywords.h"
 #include "llagentui.h"
 #include "llavataractions.h"
@@ -647,6 +648,8 @@ void LLIMProcessing::processNewMessage(LLUUID from_id,
     LLHost &sender,
     LLUUID aux_id)
 {
+    FSIMStageTimer intake_timer(FSIM_STAGE_INTAKE); // <FS/> Per stage IM latency
+
     LLChat chat;
     std::string buffer;
     std::string name = agentName;
@@ -49,6 +49,7 @@
 #include "llappviewer.h"
 #include "llavatariconctrl.h"
 #include "llcallingcard.h"
+#include "llcallbacklist.h"
 #include "llchat.h"
 // <FS:Ansariel> [FS communication UI]
 //#include "llfloaterimsession.h"
@@ -1790,7 +1791,19 @@ bool LLIMModel::logToFile(const std::string& file_name, const std::string& from,
         }
 
         LLLogChat::saveHistory(file_name, from_name, from_id, utf8_text);
-        LLConversationLog::instance().cache(); // update the conversation log too
+        // <FS> The conversation log is rewritten as a whole, do it once per frame
+        //LLConversationLog::instance().cache(); // update the conversation log too
+        static bool conversation_log_cache_pending = false;
+        if (!conversation_log_cache_pending)
+        {
+            conversation_log_cache_pending = true;
+            doOnIdleOneTime([]()
+            {
+                conversation_log_cache_pending = false;
+                LLConversationLog::instance().cache(); // update the conversation log too
+            });
+        }
+        // </FS>
         return true;
     }
     else
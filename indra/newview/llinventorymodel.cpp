@@ -3615,6 +3615,7 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
                                     bool &is_cache_obsolete)
 {
     LL_PROFILE_ZONE_NAMED("inventory load from file");
+    FSMemTagScope mem_tag(FSMT_INVENTORY); // <FS/> Memory tags
 
     if(filename.empty())
     {
@@ -181,6 +181,15 @@ private:
 
 const S32 MAX_FETCH_RETRIES = 10; // <FS:ND/> For legacy inventory
 
+// <FS> Fetch priorities and statistics
+const S32 MAX_PRIORITY_DEPTH = 64;  // ancestors looked at to decide the priority of a folder
+const size_t MAX_BATCH_SCAN = 64;   // queued folders looked at for siblings to batch
+
+LLTrace::CountStatHandle<> FOLDERS_FETCHED("inventoryfoldersfetched", "Inventory folders received by the background fetch");
+LLTrace::SampleStatHandle<> FOLDER_FETCH_QUEUE("inventoryfetchqueue", "Inventory folders waiting to be fetched");
+LLTrace::SampleStatHandle<> FOLDER_FETCHES_ACTIVE("inventoryfetchesactive", "Inventory fetch requests in flight");
+// </FS>
+
 const char * const LOG_INV("Inventory");
 
 } // end of namespace anonymous
@@ -200,8 +209,16 @@ LLInventoryModelBackgroundFetch::LLInventoryModelBackgroundFetch():
     mRecursiveInventoryFetchStarted(false),
     mRecursiveLibraryFetchStarted(false),
     mRecursiveMarketplaceFetchStarted(false),
-    mMinTimeBetweenFetches(0.3f)
-{}
+    mMinTimeBetweenFetches(0.3f),
+    // <FS> Fetch priorities and statistics
+    mFoldersReceived(0),
+    mBatchedRequests(0)
+    // </FS>
+{
+    // <FS> Fetch priorities and statistics
+    mFetchFolderQueue.setPriorityFunction(boost::bind(&LLInventoryModelBackgroundFetch::getFetchPriority, this, _1));
+    // </FS>
+}
 
 LLInventoryModelBackgroundFetch::~LLInventoryModelBackgroundFetch()
 {
@@ -340,6 +357,13 @@ void LLInventoryModelBackgroundFetch::start(const LLUUID& id, bool recursive)
         }
         else
         {
+            // <FS> Folders somebody asked for go before the rest
+            if (id != gInventory.getRootFolderID() && id != gInventory.getLibraryRootFolderID())
+            {
+                mInterestFolders.insert(id);
+            }
+            // </FS>
+
             if (AISAPI::isAvailable())
             {
                 if (mFetchFolderQueue.empty() || mFetchFolderQueue.back().mUUID != id)
@@ -509,8 +533,151 @@ void LLInventoryModelBackgroundFetch::setAllFoldersFetched()
     // For now only informs about initial fetch being done
     mFoldersFetchedSignal();
 
-    LL_INFOS(LOG_INV) << "Inventory background fetch completed" << LL_ENDL;
+    // <FS> Fetch statistics
+    //LL_INFOS(LOG_INV) << "Inventory background fetch completed" << LL_ENDL;
+    F32 elapsed = mFetchRateTimer.getElapsedTimeF32().value();
+    LL_INFOS(LOG_INV) << "Inventory background fetch completed: " << mFoldersReceived << " folders in " << elapsed
+        << " s (" << (elapsed > 0.f ? (F32)mFoldersReceived / elapsed : 0.f) << " folders/s), "
+        << mBatchedRequests << " batched requests" << LL_ENDL;
+    mFoldersReceived = 0;
+    mBatchedRequests = 0;
+    mInterestFolders.clear();
+    // </FS>
+}
+
+// <FS> Fetch priorities and statistics
+void LLInventoryModelBackgroundFetch::setSearchInterest(bool active, const LLUUID& root_id)
+{
+    LLUUID search_root;
+    if (active)
+    {
+        search_root = root_id.notNull() ? root_id : gInventory.getRootFolderID();
+    }
+    if (search_root != mSearchRootID)
+    {
+        mSearchRootID = search_root;
+        mFetchFolderQueue.reprioritize();
+    }
+}
+
+void LLInventoryModelBackgroundFetch::onFoldersReceived(S32 count)
+{
+    if (count > 0)
+    {
+        mFoldersReceived += count;
+        add(FOLDERS_FETCHED, count);
+    }
+}
+
+S32 LLInventoryModelBackgroundFetch::getFetchPriority(const FetchQueueInfo& info) const
+{
+    if (!info.mIsCategory || info.mUUID.isNull())
+    {
+        return FSFP_INVENTORY;
+    }
+    if (mInterestFolders.find(info.mUUID) != mInterestFolders.end())
+    {
+        return FSFP_REQUESTED;
+    }
+
+    const LLViewerInventoryCategory* cat = gInventory.getCategory(info.mUUID);
+    if (cat && cat->getOwnerID() == gInventory.getLibraryOwnerID())
+    {
+        return FSFP_LIBRARY;
+    }
+
+    S32 priority = FSFP_INVENTORY;
+    for (S32 depth = 0; cat && depth < MAX_PRIORITY_DEPTH; ++depth)
+    {
+        switch (cat->getPreferredType())
+        {
+            case LLFolderType::FT_CURRENT_OUTFIT:
+            case LLFolderType::FT_MY_OUTFITS:
+            case LLFolderType::FT_OUTFIT:
+                return FSFP_OUTFITS;
+            default:
+                break;
+        }
+        if (mSearchRootID.notNull() && cat->getUUID() == mSearchRootID)
+        {
+            priority = FSFP_SEARCH;
+        }
+        cat = gInventory.getCategory(cat->getParentUUID());
+    }
+    return priority;
+}
+
+// Fetches queued siblings of fetch_info together with it in a single request
+bool LLInventoryModelBackgroundFetch::batchFetchViaAis(const FetchQueueInfo& fetch_info, LLViewerInventoryCategory* cat)
+{
+    static LLCachedControl<S32> ais_batch(gSavedSettings, "BatchSizeAIS3", 20);
+    const size_t batch_limit = (size_t)llclamp(ais_batch(), 1, 40);
+    if (!fetch_info.mBatchable || batch_limit < 2)
+    {
+        return false;
+    }
+
+    const LLUUID parent_id = cat->getParentUUID();
+    LLViewerInventoryCategory* parent = gInventory.getCategory(parent_id);
+    if (!parent)
+    {
+        return false;
+    }
+
+    const LLUUID owner_id = cat->getOwnerID();
+    std::vector<FetchQueueInfo> siblings;
+    mFetchFolderQueue.takeMatching([&parent_id, &owner_id](const FetchQueueInfo& info)
+        {
+            if (!info.mIsCategory || !info.mBatchable || info.mFetchType != FT_RECURSIVE)
+            {
+                return false;
+            }
+            LLViewerInventoryCategory* sibling = gInventory.getCategory(info.mUUID);
+            return sibling
+                && sibling->getParentUUID() == parent_id
+                && sibling->getOwnerID() == owner_id
+                && sibling->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN
+                && sibling->getFetching() < LLViewerInventoryCategory::FETCH_RECURSIVE
+                && sibling->getPreferredType() != LLFolderType::FT_MARKETPLACE_LISTINGS;
+        }, MAX_BATCH_SCAN, batch_limit - 1, siblings);
+
+    if (siblings.empty())
+    {
+        return false;
+    }
+
+    uuid_vec_t children;
+    children.push_back(cat->getUUID());
+    for (std::vector<FetchQueueInfo>::const_iterator it = siblings.begin(); it != siblings.end(); ++it)
+    {
+        children.push_back(it->mUUID);
+    }
+    for (uuid_vec_t::const_iterator it = children.begin(); it != children.end(); ++it)
+    {
+        gInventory.getCategory(*it)->setFetching(LLViewerInventoryCategory::FETCH_RECURSIVE);
+        mExpectedFolderIds.push_back(*it);
+    }
+
+    // increment before call in case of immediate callback
+    incrFetchFolderCount(1);
+    ++mBatchedRequests;
+
+    AISAPI::completion_t cb = [parent_id, children](const LLUUID& response_id)
+    {
+        LLInventoryModelBackgroundFetch::instance().onAISContentCalback(parent_id, children, response_id, FT_RECURSIVE);
+    };
+
+    AISAPI::ITEM_TYPE item_type = AISAPI::INVENTORY;
+    if (ALEXANDRIA_LINDEN_ID == owner_id)
+    {
+        item_type = AISAPI::LIBRARY;
+    }
+
+    LL_DEBUGS(LOG_INV, "AIS3") << "Fetching " << children.size() << " folders of " << parent_id << " in one request" << LL_ENDL;
+    AISAPI::FetchCategorySubset(parent_id, children, item_type, true, cb, 0);
+    return true;
 }
+// </FS>
 
 boost::signals2::connection LLInventoryModelBackgroundFetch::setFetchCompletionCallback(folders_fetched_callback_t cb)
 {
@@ -752,10 +919,17 @@ void LLInventoryModelBackgroundFetch::onAISContentCalback(
         if (response_id.isNull())
         {
             // Failed to fetch, get it individually
-            mFetchFolderQueue.push_back(FetchQueueInfo(*folder_iter, FT_RECURSIVE));
+            // <FS> Don't batch it again
+            //mFetchFolderQueue.push_back(FetchQueueInfo(*folder_iter, FT_RECURSIVE));
+            FetchQueueInfo info(*folder_iter, FT_RECURSIVE);
+            info.mBatchable = false;
+            mFetchFolderQueue.push_back(info);
+            // </FS>
         }
         else
         {
+            mInterestFolders.erase(*folder_iter); // <FS/>
+
             // push descendant back to verify they are fetched fully (ex: didn't encounter depth limit)
             LLInventoryModel::cat_array_t* categories(NULL);
             LLInventoryModel::item_array_t* items(NULL);
@@ -831,6 +1005,8 @@ void LLInventoryModelBackgroundFetch::onAISFolderCalback(const LLUUID &request_i
     }
     else
     {
+        mInterestFolders.erase(request_id); // <FS/>
+
         if (fetch_type == FT_RECURSIVE)
         {
             // Got the folder and content, now verify content
@@ -912,13 +1088,30 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
     const F64 end_time = curent_time + max_time;
     S32 last_fetch_count = mFetchCount;
 
-    while (!mFetchFolderQueue.empty() && mFetchCount < max_concurrent_fetches && curent_time < end_time)
+    // <FS> Fetch folders by interest. Explicitly requested folders go
+    // before single items, everything else after them. Entries are copied
+    // and popped before they are processed, processing can queue more.
+    //while (!mFetchFolderQueue.empty() && mFetchCount < max_concurrent_fetches && curent_time < end_time)
+    //{
+    //    const FetchQueueInfo & fetch_info(mFetchFolderQueue.front());
+    //    bulkFetchViaAis(fetch_info);
+    //    mFetchFolderQueue.pop_front();
+    //    curent_time = LLTimer::getTotalSeconds();
+    //}
+    if (mFoldersReceived == 0 && mFetchCount == 0)
     {
-        const FetchQueueInfo & fetch_info(mFetchFolderQueue.front());
-        bulkFetchViaAis(fetch_info);
+        mFetchRateTimer.reset();
+    }
+
+    while (!mFetchFolderQueue.empty() && mFetchFolderQueue.frontPriority() == FSFP_REQUESTED
+           && mFetchCount < max_concurrent_fetches && curent_time < end_time)
+    {
+        const FetchQueueInfo fetch_info(mFetchFolderQueue.front());
         mFetchFolderQueue.pop_front();
+        bulkFetchViaAis(fetch_info);
         curent_time = LLTimer::getTotalSeconds();
     }
+    // </FS>
 
     // Ideally we shouldn't fetch items if recursive fetch isn't done,
     // but there is a chance some request will start timeouting and recursive
@@ -931,6 +1124,19 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
         curent_time = LLTimer::getTotalSeconds();
     }
 
+    // <FS> Rest of the folders
+    while (!mFetchFolderQueue.empty() && mFetchCount < max_concurrent_fetches && curent_time < end_time)
+    {
+        const FetchQueueInfo fetch_info(mFetchFolderQueue.front());
+        mFetchFolderQueue.pop_front();
+        bulkFetchViaAis(fetch_info);
+        curent_time = LLTimer::getTotalSeconds();
+    }
+
+    sample(FOLDER_FETCH_QUEUE, (F64)mFetchFolderQueue.size());
+    sample(FOLDER_FETCHES_ACTIVE, (F64)mFetchCount);
+    // </FS>
+
     if (last_fetch_count != mFetchCount // if anything was added
         || mLastFetchCount != mFetchCount) // if anything was substracted
     {
@@ -938,6 +1144,14 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis()
             << ", scheduled folder fetches: " << (S32)mFetchFolderQueue.size()
             << ", scheduled item fetches: " << (S32)mFetchItemQueue.size()
             << LL_ENDL;
+        // <FS> Fetch priorities
+        LL_DEBUGS(LOG_INV , "AIS3") << "Scheduled folder fetches by priority:";
+        for (S32 priority = 0; priority < FSFP_COUNT; ++priority)
+        {
+            LL_CONT << " " << fs_fetch_priority_name(priority) << " " << (S32)mFetchFolderQueue.size(priority);
+        }
+        LL_CONT << LL_ENDL;
+        // </FS>
         mLastFetchCount = mFetchCount;
 
         if (!mExpectedFolderIds.empty())
@@ -1114,7 +1328,13 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                         : LLViewerInventoryCategory::FETCH_NORMAL;
                     // start again if we did a non-recursive fetch before
                     // to get all children in a single request
-                    if (cat->getFetching() < target_state)
+                    // <FS> Queued siblings share one request
+                    //if (cat->getFetching() < target_state)
+                    if (cat->getFetching() < target_state
+                        && !(fetch_info.mFetchType == FT_RECURSIVE
+                             && cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN
+                             && batchFetchViaAis(fetch_info, cat)))
+                    // </FS>
                     {
                         // increment before call in case of immediate callback
                         incrFetchFolderCount(1);
@@ -1139,6 +1359,8 @@ void LLInventoryModelBackgroundFetch::bulkFetchViaAis(const FetchQueueInfo& fetc
                 }
                 else
                 {
+                    mInterestFolders.erase(cat_id); // <FS/>
+
                     // Already fetched, check if anything inside needs fetching
                     if (fetch_info.mFetchType == FT_RECURSIVE
                         || fetch_info.mFetchType == FT_FOLDER_AND_CONTENT)
@@ -1421,14 +1643,20 @@ void LLInventoryModelBackgroundFetch::bulkFetch()
 
 bool LLInventoryModelBackgroundFetch::fetchQueueContainsNoDescendentsOf(const LLUUID & cat_id) const
 {
-    for (fetch_queue_t::const_iterator it = mFetchFolderQueue.begin();
-         it != mFetchFolderQueue.end();
-         ++it)
+    // <FS> Folders are fetched by interest
+    //for (fetch_queue_t::const_iterator it = mFetchFolderQueue.begin();
+    //     it != mFetchFolderQueue.end();
+    //     ++it)
+    //{
+    //    const LLUUID & fetch_id = (*it).mUUID;
+    //    if (gInventory.isObjectDescendentOf(fetch_id, cat_id))
+    //        return false;
+    //}
+    if (mFetchFolderQueue.containsMatching([&cat_id](const FetchQueueInfo& info) { return gInventory.isObjectDescendentOf(info.mUUID, cat_id); }))
     {
-        const LLUUID & fetch_id = (*it).mUUID;
-        if (gInventory.isObjectDescendentOf(fetch_id, cat_id))
-            return false;
+        return false;
     }
+    // </FS>
     for (fetch_queue_t::const_iterator it = mFetchItemQueue.begin();
         it != mFetchItemQueue.end();
         ++it)
@@ -1521,6 +1749,7 @@ void BGFolderHttpHandler::processData(LLSD & content, LLCore::HttpResponse * res
     if (content.has("folders"))
     {
         LLSD folders(content["folders"]);
+        fetcher->onFoldersReceived(folders.size()); // <FS/>
 
         for (LLSD::array_const_iterator folder_it = folders.beginArray();
             folder_it != folders.endArray();
@@ -34,6 +34,9 @@
 #include "httpoptions.h"
 #include "httpheaders.h"
 #include "httphandler.h"
+#include "fsinventoryfetchqueue.h" // <FS/>
+
+class LLViewerInventoryCategory; // <FS/>
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Class LLInventoryModelBackgroundFetch
@@ -84,6 +87,14 @@ public:
     void addRequestAtFront(const LLUUID & id, bool recursive, bool is_category);
     void addRequestAtBack(const LLUUID & id, bool recursive, bool is_category);
 
+    // <FS> Fetch priorities and statistics
+    // While a search is active, folders below root_id are fetched before
+    // the rest of the inventory. A null root_id means the agent's inventory.
+    void setSearchInterest(bool active, const LLUUID& root_id = LLUUID::null);
+    // Folders that arrived with their content, for the fetch rate statistics
+    void onFoldersReceived(S32 count);
+    // </FS>
+
 protected:
     bool isFolderFetchProcessingComplete() const;
 
@@ -99,14 +110,17 @@ protected:
         FetchQueueInfo(const LLUUID& id, EFetchType recursive, bool is_category = true)
             : mUUID(id),
             mIsCategory(is_category),
-            mFetchType(recursive)
+            mFetchType(recursive),
+            mBatchable(true) // <FS/>
         {}
 
         LLUUID mUUID;
         bool mIsCategory;
         EFetchType mFetchType;
+        bool mBatchable; // <FS/> may share a request with queued siblings
     };
     typedef std::deque<FetchQueueInfo> fetch_queue_t;
+    typedef FSPriorityFetchQueue<FetchQueueInfo> folder_queue_t; // <FS/>
 
     void onAISContentCalback(const LLUUID& request_id, const uuid_vec_t &content_ids, const LLUUID& response_id, EFetchType fetch_type);
     void onAISFolderCalback(const LLUUID &request_id, const LLUUID &response_id, EFetchType fetch_type);
@@ -119,6 +133,11 @@ protected:
 
     bool fetchQueueContainsNoDescendentsOf(const LLUUID& cat_id) const;
 
+    // <FS> Fetch priorities and batching
+    S32 getFetchPriority(const FetchQueueInfo& info) const;
+    bool batchFetchViaAis(const FetchQueueInfo& fetch_info, LLViewerInventoryCategory* cat);
+    // </FS>
+
 private:
     bool mRecursiveInventoryFetchStarted;
     bool mRecursiveLibraryFetchStarted;
@@ -135,7 +154,15 @@ private:
 
     LLFrameTimer mFetchTimer;
     F32 mMinTimeBetweenFetches;
-    fetch_queue_t mFetchFolderQueue;
+    // <FS> Folders are fetched by interest
+    //fetch_queue_t mFetchFolderQueue;
+    folder_queue_t mFetchFolderQueue;
+    uuid_set_t mInterestFolders; // opened or explicitly requested folders
+    LLUUID mSearchRootID;
+    LLTimer mFetchRateTimer;
+    S32 mFoldersReceived;
+    S32 mBatchedRequests;
+    // </FS>
     fetch_queue_t mFetchItemQueue;
     uuid_set_t mForceFetchSet;
     std::list<LLUUID> mExpectedFolderIds; // for debug, should this track time?
@@ -41,6 +41,10 @@
 // </FS:CR>
 #include "llinstantmessage.h"
 #include "llsingleton.h" // for LLSingleton
+// <FS> Batched transcript writes
+#include "fsimpipeline.h"
+#include "workqueue.h"
+// </FS>
 
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/algorithm/string/replace.hpp>
@@ -300,6 +304,8 @@ LLLogChat::LLLogChat()
 
 LLLogChat::~LLLogChat()
 {
+    flushTranscripts(); // <FS/> Batched transcript writes
+
     delete mHistoryThreadsMutex;
     mHistoryThreadsMutex = NULL;
 
@@ -365,6 +371,8 @@ void LLLogChat::renameLogFile(const std::string& old_filename, const std::string
         return;
     }
 
+    flushTranscripts(); // <FS/> Batched transcript writes
+
     new_name += '.' + LL_TRANSCRIPT_FILE_EXTENSION;
     old_name += '.' + LL_TRANSCRIPT_FILE_EXTENSION;
 
@@ -450,12 +458,14 @@ void LLLogChat::saveHistory(const std::string& filename,
         return;
     }
 
-    llofstream file(LLLogChat::makeLogFileName(filename).c_str(), std::ios_base::app);
-    if (!file.is_open())
-    {
-        LL_WARNS() << "Couldn't open chat history log! - " + filename << LL_ENDL;
-        return;
-    }
+    // <FS> Lines are formatted here and written in batches on a worker
+    //llofstream file(LLLogChat::makeLogFileName(filename).c_str(), std::ios_base::app);
+    //if (!file.is_open())
+    //{
+    //    LL_WARNS() << "Couldn't open chat history log! - " + filename << LL_ENDL;
+    //    return;
+    //}
+    // </FS>
 
     LLSD item;
 
@@ -475,12 +485,107 @@ void LLLogChat::saveHistory(const std::string& filename,
         item["from"] = from;
     }
 
-    file << LLChatLogFormatter(item) << std::endl;
+    // <FS> Lines are formatted here and written in batches on a worker
+    //file << LLChatLogFormatter(item) << std::endl;
+    //
+    //file.close();
+    //
+    //LLLogChat::getInstance()->triggerHistorySignal();
+    std::ostringstream formatted;
+    formatted << LLChatLogFormatter(item);
+    queueTranscriptLine(LLLogChat::makeLogFileName(filename), formatted.str());
+    // </FS>
+}
+
+// <FS> Batched transcript writes
+static FSTranscriptWriter& get_transcript_writer()
+{
+    // Outlives LLLogChat, drains may still run on a worker during shutdown
+    static std::shared_ptr<FSTranscriptWriter> writer = std::make_shared<FSTranscriptWriter>();
+    return *writer;
+}
+
+static bool sTranscriptDrainPosted = false;
+
+// static
+void LLLogChat::queueTranscriptLine(const std::string& path, const std::string& line)
+{
+    get_transcript_writer().queue(path, line, LLTimer::getTotalSeconds());
+    postTranscriptDrain();
+}
+
+// static
+void LLLogChat::postTranscriptDrain()
+{
+    if (sTranscriptDrainPosted)
+    {
+        return;
+    }
+
+    static LLCachedControl<bool> threaded_transcripts(gSavedSettings, "FSIMThreadedTranscripts");
+    if (threaded_transcripts)
+    {
+        auto main_queue = LL::WorkQueue::getInstance("mainloop");
+        auto general_queue = LL::WorkQueue::getInstance("General");
+        if (main_queue && general_queue)
+        {
+            try
+            {
+                // Everything queued until the worker gets to it goes out in one batch
+                sTranscriptDrainPosted = main_queue->postTo(general_queue,
+                    []()
+                    {
+                        F64 oldest_queued = 0.0;
+                        U32 written = get_transcript_writer().drain(&oldest_queued);
+                        return std::make_pair(written, oldest_queued);
+                    },
+                    [](std::pair<U32, F64> result)
+                    {
+                        sTranscriptDrainPosted = false;
+                        onTranscriptsWritten(result.first, result.second);
+                    });
+            }
+            catch (const LL::WorkQueue::Closed&)
+            {
+                sTranscriptDrainPosted = false;
+            }
+            if (sTranscriptDrainPosted)
+            {
+                return;
+            }
+        }
+    }
+
+    F64 oldest_queued = 0.0;
+    U32 written = get_transcript_writer().drain(&oldest_queued);
+    onTranscriptsWritten(written, oldest_queued);
+}
+
+// static
+void LLLogChat::onTranscriptsWritten(U32 written, F64 oldest_queued)
+{
+    if (written)
+    {
+        gIMStageStats.record(FSIM_STAGE_TRANSCRIPT, LLTimer::getTotalSeconds() - oldest_queued);
+        if (instanceExists())
+        {
+            getInstance()->triggerHistorySignal();
+        }
+    }
 
-    file.close();
+    // Lines queued while the batch was written
+    if (get_transcript_writer().hasPending())
+    {
+        postTranscriptDrain();
+    }
+}
 
-    LLLogChat::getInstance()->triggerHistorySignal();
+// static
+void LLLogChat::flushTranscripts()
+{
+    get_transcript_writer().drain();
 }
+// </FS>
 
 // static
 void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& messages, const LLSD& load_params, bool is_group)
@@ -491,6 +596,8 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
         return ;
     }
 
+    flushTranscripts(); // <FS/> Batched transcript writes
+
     bool load_all_history = load_params.has("load_all_history") ? load_params["load_all_history"].asBoolean() : false;
 
     // Stat the file to find it and get the last history entry time
@@ -822,6 +929,8 @@ bool LLLogChat::moveTranscripts(const std::string originDirectory,
     std::string backupFileName;
     unsigned backupFileCount;
 
+    flushTranscripts(); // <FS/> Batched transcript writes
+
     for (const std::string& fullpath : listOfFilesToMove)
     {
         backupFileCount = 0;
@@ -889,6 +998,8 @@ bool LLLogChat::moveTranscripts(const std::string currentDirectory,
 //static
 void LLLogChat::deleteTranscripts()
 {
+    flushTranscripts(); // <FS/> Batched transcript writes
+
     std::vector<std::string> list_of_transcriptions;
     getListOfTranscriptFiles(list_of_transcriptions);
     getListOfTranscriptBackupFiles(list_of_transcriptions);
@@ -110,6 +110,12 @@ public:
 
     static void loadChatHistory(const std::string& file_name, std::list<LLSD>& messages, const LLSD& load_params = LLSD(), bool is_group = false);
 
+    // <FS> Transcript lines are written in batches on a worker; writes
+    // everything still queued before transcripts are read, moved or deleted.
+    // Safe on any thread.
+    static void flushTranscripts();
+    // </FS>
+
     typedef boost::signals2::signal<void ()> save_history_signal_t;
     boost::signals2::connection setSaveHistorySignal(const save_history_signal_t::slot_type& cb);
 
@@ -140,6 +146,12 @@ private:
     LLMutex* historyThreadsMutex();
     void triggerHistorySignal();
 
+    // <FS> Batched transcript writes
+    static void queueTranscriptLine(const std::string& path, const std::string& line);
+    static void postTranscriptDrain();
+    static void onTranscriptsWritten(U32 written, F64 oldest_queued);
+    // </FS>
+
     save_history_signal_t * mSaveHistorySignal;
     std::map<LLUUID,LLLoadHistoryThread *> mLoadHistoryThreads;
     std::map<LLUUID,LLDeleteHistoryThread *> mDeleteHistoryThreads;
@@ -91,6 +91,7 @@
 #endif
 
 #include "llviewernetwork.h"
+#include "fsmemtags.h" // <FS/> Memory tags
 
 // Purpose
 //
@@ -913,6 +914,7 @@ LLMeshRepoThread::~LLMeshRepoThread()
 
 void LLMeshRepoThread::run()
 {
+    FSMemTagScope mem_tag(FSMT_MESHES); // <FS/> Memory tags
     LLCDResult res = LLConvexDecomposition::initThread();
     if (res != LLCD_OK && LLConvexDecomposition::isFunctional())
     {
@@ -3841,6 +3843,49 @@ S32 LLMeshRepository::loadMesh(LLVOVolume* vobj, const LLVolumeParams& mesh_para
     return detail;
 }
 
+// <FS> Region prefetch: queue a LOD request that no object is waiting on yet.
+// The request has an empty waiter list, so it scores 0 when pending requests get
+// sorted and only goes out ahead of real requests when there is spare capacity.
+// An object calling loadMesh() later simply joins the existing entry.
+// The system volume of the LOD is referenced for the caller, otherwise
+// notifyMeshLoaded() would decode into a volume that is dropped right away.
+LLVolume* LLMeshRepository::prefetchMesh(const LLVolumeParams& mesh_params, S32 detail)
+{
+    if (detail < 0 || detail >= LLVolumeLODGroup::NUM_LODS)
+    {
+        return NULL;
+    }
+
+    // Nothing to do if an object already brought this LOD in
+    LLVolumeLODGroup* group = LLPrimitive::getVolumeManager()->getGroup(mesh_params);
+    if (group)
+    {
+        LLVolume* lod = group->refLOD(detail);
+        bool loaded = lod && lod->isMeshAssetLoaded();
+        group->derefLOD(lod);
+        if (loaded)
+        {
+            return NULL;
+        }
+    }
+
+    const LLUUID& mesh_id = mesh_params.getSculptID();
+    {
+        LLMutexLock lock(mMeshMutex);
+        if (mLoadingMeshes[detail].find(mesh_id) != mLoadingMeshes[detail].end())
+        {
+            return NULL;
+        }
+
+        mLoadingMeshes[detail][mesh_id];
+        mPendingRequests.push_back(LLMeshRepoThread::LODRequest(mesh_params, detail));
+        LLMeshRepository::sLODPending++;
+    }
+
+    return LLPrimitive::getVolumeManager()->refVolume(mesh_params, detail);
+}
+// </FS>
+
 void LLMeshRepository::notifyLoadedMeshes()
 { //called from main thread
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK; //LL_RECORD_BLOCK_TIME(FTM_MESH_FETCH);
@@ -669,6 +669,11 @@ public:
     void unregisterMesh(LLVOVolume* volume);
     //mesh management functions
     S32 loadMesh(LLVOVolume* volume, const LLVolumeParams& mesh_params, S32 detail = 0, S32 last_lod = -1);
+    // <FS> Region prefetch: queue a LOD request that no object is waiting on yet.
+    // Returns the LOD's system volume, to be released with unrefVolume(), or NULL
+    // if nothing was queued.
+    LLVolume* prefetchMesh(const LLVolumeParams& mesh_params, S32 detail);
+    // </FS>
 
     void notifyLoadedMeshes();
     void notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVolume* volume);
@@ -110,6 +110,12 @@ const F64 COARSEUPDATE_MAX_Z = 1020.0f;
 const F32 WIDTH_PIXELS = 2.f;
 const S32 CIRCLE_STEPS = 100;
 
+// <FS> Incremental object and parcel layers
+static LLTrace::EventStatHandle<F64Milliseconds> MINIMAP_OBJECT_LAYER_TIME("minimapobjectlayerms", "Time to bring the minimap object layer up to date");
+static LLTrace::EventStatHandle<F64Milliseconds> MINIMAP_PARCEL_LAYER_TIME("minimapparcellayerms", "Time to bring the minimap parcel layer up to date");
+static LLTrace::CountStatHandle<> MINIMAP_OBJECT_TILES("minimapobjecttiles", "Minimap object layer tiles redrawn");
+// </FS>
+
 LLNetMap::avatar_marks_map_t LLNetMap::sAvatarMarksMap; // <FS:Ansariel>
 F32 LLNetMap::sScale; // <FS:Ansariel> Synchronizing netmaps throughout instances
 
@@ -254,8 +260,12 @@ BOOL LLNetMap::postBuild()
 // [/SL:KB]
 
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
-    mParcelMgrConn = LLViewerParcelMgr::instance().setCollisionUpdateCallback(boost::bind(&LLNetMap::refreshParcelOverlay, this));
-    mParcelOverlayConn = LLViewerParcelOverlay::setUpdateCallback(boost::bind(&LLNetMap::refreshParcelOverlay, this));
+    // <FS> Only redraw the region that changed
+    //mParcelMgrConn = LLViewerParcelMgr::instance().setCollisionUpdateCallback(boost::bind(&LLNetMap::refreshParcelOverlay, this));
+    //mParcelOverlayConn = LLViewerParcelOverlay::setUpdateCallback(boost::bind(&LLNetMap::refreshParcelOverlay, this));
+    mParcelMgrConn = LLViewerParcelMgr::instance().setCollisionUpdateCallback(boost::bind(&LLNetMap::refreshParcelOverlayRegion, this, _1));
+    mParcelOverlayConn = LLViewerParcelOverlay::setUpdateCallback(boost::bind(&LLNetMap::refreshParcelOverlayRegion, this, _1));
+    // </FS>
 // [/SL:KB]
 
     LLMenuGL* menu = LLUICtrlFactory::getInstance()->createFromFile<LLMenuGL>("menu_mini_map.xml", gMenuHolder, LLViewerMenuHolderGL::child_registry_t::instance());
@@ -606,6 +616,13 @@ void LLNetMap::draw()
         static LLCachedControl<bool> s_fShowObjects(gSavedSettings, "MiniMapObjects") ;
         if ( (s_fShowObjects) && ((mUpdateObjectImage) || (map_timer.getElapsedTimeF32() > 0.5f)) )
         {
+            // <FS> Incremental object layer
+            if (mUpdateObjectImage)
+            {
+                mObjectRaster.invalidate();
+            }
+            LLTimer layer_timer;
+            // </FS>
             mUpdateObjectImage = false;
 // [/SL:KB]
 
@@ -616,17 +633,34 @@ void LLNetMap::draw()
 //          new_center.mV[VZ] = 0.f;
 //          mObjectImageCenterGlobal = viewPosToGlobal(llfloor(new_center.mV[VX]), llfloor(new_center.mV[VY]));
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
-            mObjectImageCenterGlobal = posCenterGlobal;
+            // <FS> The raster keeps the center pixel aligned, so panning only
+            // scrolls the image
+            //mObjectImageCenterGlobal = posCenterGlobal;
+            // </FS>
 // [/SL:KB]
 
-            // Create the base texture.
-            U8 *default_texture = mObjectRawImagep->getData();
-            memset( default_texture, 0, mObjectImagep->getWidth() * mObjectImagep->getHeight() * mObjectImagep->getComponents() );
+            // <FS> Incremental object layer: the object list refreshes the
+            // footprints, only tiles with changed footprints are redrawn and
+            // uploaded
+            //// Create the base texture.
+            //U8 *default_texture = mObjectRawImagep->getData();
+            //memset( default_texture, 0, mObjectImagep->getWidth() * mObjectImagep->getHeight() * mObjectImagep->getComponents() );
 
             // Draw objects
             gObjectList.renderObjectsForMap(*this);
 
-            mObjectImagep->setSubImage(mObjectRawImagep, 0, 0, mObjectImagep->getWidth(), mObjectImagep->getHeight());
+            //mObjectImagep->setSubImage(mObjectRawImagep, 0, 0, mObjectImagep->getWidth(), mObjectImagep->getHeight());
+            mObjectRaster.setView(posCenterGlobal.mdV[VX], posCenterGlobal.mdV[VY], mObjectMapTPM, mObjectImagep->getWidth(), mObjectImagep->getHeight());
+            S32 left, bottom, right, top;
+            if (mObjectRaster.update(gObjectList.getMapFootprints(), (U32*)mObjectRawImagep->getData(), left, bottom, right, top))
+            {
+                mObjectImagep->setSubImage(mObjectRawImagep, left, bottom, right - left, top - bottom);
+            }
+            mObjectImageCenterGlobal.setVec(mObjectRaster.getCenterX(), mObjectRaster.getCenterY(), posCenterGlobal.mdV[VZ]);
+
+            add(MINIMAP_OBJECT_TILES, mObjectRaster.getTilesDrawn());
+            record(MINIMAP_OBJECT_LAYER_TIME, F64Seconds(layer_timer.getElapsedTimeF64()));
+            // </FS>
 
             map_timer.reset();
         }
@@ -635,7 +669,9 @@ void LLNetMap::draw()
         static LLCachedControl<bool> s_fShowPropertyLines(gSavedSettings, "MiniMapShowPropertyLines") ;
         if ( (s_fShowPropertyLines) && ((mUpdateParcelImage) || (dist_vec_squared2D(mParcelImageCenterGlobal, posCenterGlobal) > 9.0f)) )
         {
+            LLTimer layer_timer; // <FS/>
             mUpdateParcelImage = false;
+            mDirtyParcelRegions.clear(); // <FS/>
             mParcelImageCenterGlobal = posCenterGlobal;
 
             U8* pTextureData = mParcelRawImagep->getData();
@@ -654,7 +690,14 @@ void LLNetMap::draw()
             }
 
             mParcelImagep->setSubImage(mParcelRawImagep, 0, 0, mParcelImagep->getWidth(), mParcelImagep->getHeight());
+            record(MINIMAP_PARCEL_LAYER_TIME, F64Seconds(layer_timer.getElapsedTimeF64())); // <FS/>
+        }
+        // <FS> Parcel overlay updates only redraw their region
+        else if (s_fShowPropertyLines && !mDirtyParcelRegions.empty())
+        {
+            updateParcelImageRegions(map_parcel_outline_color.get());
         }
+        // </FS>
 // [/SL:KB]
 
         LLVector3 map_center_agent = gAgent.getPosAgentFromGlobal(mObjectImageCenterGlobal);
@@ -1570,62 +1613,72 @@ void LLNetMap::renderPropertyLinesForRegion(const LLViewerRegion* pRegion, const
 
     const U8* pOwnership = pRegion->getParcelOverlay()->getOwnership();
     const U8* pCollision = (pRegion->getHandle() == LLViewerParcelMgr::instance().getCollisionRegionHandle()) ? LLViewerParcelMgr::instance().getCollisionBitmap() : NULL;
-    for (S32 idxRow = 0; idxRow < GRIDS_PER_EDGE; idxRow++)
-    {
-        for (S32 idxCol = 0; idxCol < GRIDS_PER_EDGE; idxCol++)
+    // <FS> Without a collision bitmap only the cells marked when the overlay
+    // was last built can draw anything, skip the scan of the whole grid
+    //for (S32 idxRow = 0; idxRow < GRIDS_PER_EDGE; idxRow++)
+    //{
+    //    for (S32 idxCol = 0; idxCol < GRIDS_PER_EDGE; idxCol++)
+    //    {
+    //        S32 overlay = pOwnership[idxRow * GRIDS_PER_EDGE + idxCol];
+    //        S32 idxCollision = idxRow * GRIDS_PER_EDGE + idxCol;
+    const std::vector<U32>& markedCells = pRegion->getParcelOverlay()->getMarkedCells();
+    const S32 cntCells = (pCollision) ? GRIDS_PER_EDGE * GRIDS_PER_EDGE : (S32)markedCells.size();
+    for (S32 idxCell = 0; idxCell < cntCells; idxCell++)
+    {
+        const S32 idxCollision = (pCollision) ? idxCell : (S32)markedCells[idxCell];
+        const S32 idxRow = idxCollision / GRIDS_PER_EDGE;
+        const S32 idxCol = idxCollision % GRIDS_PER_EDGE;
+        S32 overlay = pOwnership[idxCollision];
+    // </FS>
+        bool fForSale = ((overlay & PARCEL_COLOR_MASK) == PARCEL_FOR_SALE);
+        bool fAuction = ((overlay & PARCEL_COLOR_MASK) == PARCEL_AUCTION);
+        bool fCollision = (pCollision) && (pCollision[idxCollision / 8] & (1 << (idxCollision % 8)));
+        if ( (!fForSale) && (!fCollision) && (!fAuction) && (0 == (overlay & (PARCEL_SOUTH_LINE | PARCEL_WEST_LINE))) )
+            continue;
+
+        const S32 posX = originX + ll_round(idxCol * GRID_STEP * mObjectMapTPM);
+        const S32 posY = originY + ll_round(idxRow * GRID_STEP * mObjectMapTPM);
+
+        static LLCachedControl<bool> s_fForSaleParcels(gSavedSettings, "MiniMapForSaleParcels");
+        static LLCachedControl<bool> s_fShowCollisionParcels(gSavedSettings, "MiniMapCollisionParcels");
+        if ( ((s_fForSaleParcels) && (fForSale || fAuction)) || ((s_fShowCollisionParcels) && (fCollision)) )
         {
-            S32 overlay = pOwnership[idxRow * GRIDS_PER_EDGE + idxCol];
-            S32 idxCollision = idxRow * GRIDS_PER_EDGE + idxCol;
-            bool fForSale = ((overlay & PARCEL_COLOR_MASK) == PARCEL_FOR_SALE);
-            bool fAuction = ((overlay & PARCEL_COLOR_MASK) == PARCEL_AUCTION);
-            bool fCollision = (pCollision) && (pCollision[idxCollision / 8] & (1 << (idxCollision % 8)));
-            if ( (!fForSale) && (!fCollision) && (!fAuction) && (0 == (overlay & (PARCEL_SOUTH_LINE | PARCEL_WEST_LINE))) )
-                continue;
-
-            const S32 posX = originX + ll_round(idxCol * GRID_STEP * mObjectMapTPM);
-            const S32 posY = originY + ll_round(idxRow * GRID_STEP * mObjectMapTPM);
-
-            static LLCachedControl<bool> s_fForSaleParcels(gSavedSettings, "MiniMapForSaleParcels");
-            static LLCachedControl<bool> s_fShowCollisionParcels(gSavedSettings, "MiniMapCollisionParcels");
-            if ( ((s_fForSaleParcels) && (fForSale || fAuction)) || ((s_fShowCollisionParcels) && (fCollision)) )
+            S32 curY = llclamp(posY, 0, imgHeight), endY = llclamp(posY + ll_round(GRID_STEP * mObjectMapTPM), 0, imgHeight - 1);
+            for (; curY <= endY; curY++)
             {
-                S32 curY = llclamp(posY, 0, imgHeight), endY = llclamp(posY + ll_round(GRID_STEP * mObjectMapTPM), 0, imgHeight - 1);
-                for (; curY <= endY; curY++)
+                S32 curX = llclamp(posX, 0, imgWidth) , endX = llclamp(posX + ll_round(GRID_STEP * mObjectMapTPM), 0, imgWidth - 1);
+                for (; curX <= endX; curX++)
                 {
-                    S32 curX = llclamp(posX, 0, imgWidth) , endX = llclamp(posX + ll_round(GRID_STEP * mObjectMapTPM), 0, imgWidth - 1);
-                    for (; curX <= endX; curX++)
+                    U32 texcolor = LLColor4U(255, 128, 128, 192).asRGBA();
+                    if (fForSale)
                     {
-                        U32 texcolor = LLColor4U(255, 128, 128, 192).asRGBA();
-                        if (fForSale)
-                        {
-                            texcolor = LLColor4U(255, 255, 128, 192).asRGBA();
-                        }
-                        else if (fAuction)
-                        {
-                            texcolor = LLColor4U(128, 0, 255, 102).asRGBA();
-                        }
-
-                        pTextureData[curY * imgWidth + curX] = texcolor;
+                        texcolor = LLColor4U(255, 255, 128, 192).asRGBA();
+                    }
+                    else if (fAuction)
+                    {
+                        texcolor = LLColor4U(128, 0, 255, 102).asRGBA();
                     }
+
+                    pTextureData[curY * imgWidth + curX] = texcolor;
                 }
             }
-            if (overlay & PARCEL_SOUTH_LINE)
+        }
+        if (overlay & PARCEL_SOUTH_LINE)
+        {
+            if ( (posY >= 0) && (posY < imgHeight) )
             {
-                if ( (posY >= 0) && (posY < imgHeight) )
-                {
-                    S32 curX = llclamp(posX, 0, imgWidth), endX = llclamp(posX + ll_round(GRID_STEP * mObjectMapTPM), 0, imgWidth - 1);
-                    for (; curX <= endX; curX++)
-                        pTextureData[posY * imgWidth + curX] = clrOverlay.asRGBA();
-                }
+                S32 curX = llclamp(posX, 0, imgWidth), endX = llclamp(posX + ll_round(GRID_STEP * mObjectMapTPM), 0, imgWidth - 1);
+                for (; curX <= endX; curX++)
+                    pTextureData[posY * imgWidth + curX] = clrOverlay.asRGBA();
             }
-            if (overlay & PARCEL_WEST_LINE)
+        }
+        if (overlay & PARCEL_WEST_LINE)
+        {
+            if ( (posX >= 0) && (posX < imgWidth) )
             {
-                if ( (posX >= 0) && (posX < imgWidth) )
-                {
-                    S32 curY = llclamp(posY, 0, imgHeight), endY = llclamp(posY + ll_round(GRID_STEP * mObjectMapTPM), 0, imgHeight - 1);
-                    for (; curY <= endY; curY++)
-                        pTextureData[curY * imgWidth + posX] = clrOverlay.asRGBA();
-                }
+                S32 curY = llclamp(posY, 0, imgHeight), endY = llclamp(posY + ll_round(GRID_STEP * mObjectMapTPM), 0, imgHeight - 1);
+                for (; curY <= endY; curY++)
+                    pTextureData[curY * imgWidth + posX] = clrOverlay.asRGBA();
             }
         }
     }
@@ -1696,6 +1749,97 @@ void LLNetMap::createParcelImage()
         mParcelImagep = LLViewerTextureManager::getLocalTexture( mParcelRawImagep.get(), FALSE);
     mUpdateParcelImage = true;
 }
+
+// <FS> Incremental parcel layer
+void LLNetMap::refreshParcelOverlayRegion(const LLViewerRegion* pRegion)
+{
+    if (!pRegion)
+    {
+        mUpdateParcelImage = true;
+        return;
+    }
+    mDirtyParcelRegions.insert(pRegion->getHandle());
+}
+
+void LLNetMap::updateParcelImageRegions(const LLColor4U& clrOutline)
+{
+    LLTimer layer_timer;
+
+    const S32 imgWidth = (S32)mParcelImagep->getWidth();
+    const S32 imgHeight = (S32)mParcelImagep->getHeight();
+    U32* pTextureData = (U32*)mParcelRawImagep->getData();
+
+    // Regions draw their north and east borders on the first row and
+    // column of their neighbors, so clearing a region also clears lines of
+    // the regions around it; those are drawn again as well.
+    const LLWorld::region_list_t& regions = LLWorld::getInstance()->getRegionList();
+    std::vector<LLRect> cleared;
+    for (U64 handle : mDirtyParcelRegions)
+    {
+        const LLViewerRegion* pRegion = LLWorld::getInstance()->getRegionFromHandle(handle);
+        if (!pRegion)
+        {
+            continue;
+        }
+        const LLVector3 originLocal(pRegion->getOriginGlobal() - mParcelImageCenterGlobal);
+        const S32 originX = ll_round(originLocal.mV[VX] * mObjectMapTPM + imgWidth / 2);
+        const S32 originY = ll_round(originLocal.mV[VY] * mObjectMapTPM + imgHeight / 2);
+        const S32 size = ll_round(pRegion->getWidth() * mObjectMapTPM);
+
+        LLRect rect(llmax(originX, 0), llmin(originY + size + 1, imgHeight), llmin(originX + size + 1, imgWidth), llmax(originY, 0));
+        if (rect.getWidth() <= 0 || rect.getHeight() <= 0)
+        {
+            continue;
+        }
+        for (S32 y = rect.mBottom; y < rect.mTop; ++y)
+        {
+            fs_fill_pixels(pTextureData + y * imgWidth + rect.mLeft, rect.getWidth(), 0);
+        }
+        cleared.push_back(rect);
+    }
+    mDirtyParcelRegions.clear();
+    if (cleared.empty())
+    {
+        return;
+    }
+
+    LLRect dirty = cleared.front();
+    for (const LLRect& rect : cleared)
+    {
+        dirty.unionWith(rect);
+    }
+
+    // In list order, like a full redraw
+    for (LLWorld::region_list_t::const_iterator itRegion = regions.begin(); itRegion != regions.end(); ++itRegion)
+    {
+        const LLViewerRegion* pRegion = *itRegion;
+        const LLVector3 originLocal(pRegion->getOriginGlobal() - mParcelImageCenterGlobal);
+        const S32 originX = ll_round(originLocal.mV[VX] * mObjectMapTPM + imgWidth / 2);
+        const S32 originY = ll_round(originLocal.mV[VY] * mObjectMapTPM + imgHeight / 2);
+        const S32 size = ll_round(pRegion->getWidth() * mObjectMapTPM);
+        const LLRect region_rect(originX, originY + size + 1, originX + size + 1, originY);
+
+        bool touches = false;
+        for (const LLRect& rect : cleared)
+        {
+            if (rect.overlaps(region_rect))
+            {
+                touches = true;
+                break;
+            }
+        }
+        if (!touches)
+        {
+            continue;
+        }
+
+        renderPropertyLinesForRegion(pRegion, pRegion->isAlive() ? clrOutline : LLColor4U(255, 128, 128, 255));
+    }
+
+    mParcelImagep->setSubImage(mParcelRawImagep, dirty.mLeft, dirty.mBottom, dirty.getWidth(), dirty.getHeight());
+    record(MINIMAP_PARCEL_LAYER_TIME, F64Seconds(layer_timer.getElapsedTimeF64()));
+}
+// </FS>
 // [/SL:KB]
 
 BOOL LLNetMap::handleMouseDown(S32 x, S32 y, MASK mask)
@@ -34,6 +34,7 @@
 #include "v4color.h"
 #include "llpointer.h"
 #include "llcoord.h"
+#include "fsminimapraster.h" // <FS/>
 
 class LLColor4U;
 class LLImageRaw;
@@ -88,6 +89,7 @@ public:
 
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
     void            refreshParcelOverlay() { mUpdateParcelImage = true; }
+    void            refreshParcelOverlayRegion(const LLViewerRegion* pRegion); // <FS/>
 // [/SL:KB]
     void            setScale(F32 scale);
 
@@ -142,6 +144,7 @@ private:
 
     F32             getScaleForName(std::string scale_name);
     void            renderPropertyLinesForRegion(const LLViewerRegion* pRegion, const LLColor4U& clrOverlay);
+    void            updateParcelImageRegions(const LLColor4U& clrOutline); // <FS/>
 // [/SL:KB]
 //  void            createObjectImage();
 
@@ -173,11 +176,13 @@ private:
     LLVector3d      mObjectImageCenterGlobal;
     LLPointer<LLImageRaw> mObjectRawImagep;
     LLPointer<LLViewerTexture>  mObjectImagep;
+    FSMinimapRaster mObjectRaster; // <FS/> Redraws only changed object tiles
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
     LLVector3d      mParcelImageCenterGlobal;
     LLPointer<LLImageRaw> mParcelRawImagep;
     LLPointer<LLViewerTexture>  mParcelImagep;
 
+    std::set<U64>   mDirtyParcelRegions; // <FS/> Handles of regions whose parcel lines changed
     boost::signals2::connection mParcelMgrConn;
     boost::signals2::connection mParcelOverlayConn;
 // [/SL:KB]
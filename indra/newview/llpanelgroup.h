@@ -34,6 +34,11 @@
 class LLOfferInfo;
 
 const F32 UPDATE_MEMBERS_SECONDS_PER_FRAME = 0.005f; // 5ms
+// <FS> Member lists are filled a page of rows at a time, names still missing
+// for listed members are looked up again in batches
+const U32 UPDATE_MEMBERS_PAGE_SIZE = 100;
+const F32 UPDATE_MEMBERS_NAME_POLL_SECONDS = 0.25f;
+// </FS>
 
 // Forward declares
 class LLPanelGroupTab;
@@ -94,6 +94,7 @@ LLPanelGroupGeneral::LLPanelGroupGeneral()
     mComboActiveTitle(NULL),
     mCtrlReceiveGroupChat(NULL), // <exodus/>
     // <FS:Ansariel> Re-add group member list on general panel
+    mMemberProgress(0), // <FS/> Page through the member table
     mPendingMemberUpdate(FALSE),
     mListVisibleMembers(NULL)
     // </FS:Ansariel>
@@ -104,14 +105,16 @@ LLPanelGroupGeneral::LLPanelGroupGeneral()
 LLPanelGroupGeneral::~LLPanelGroupGeneral()
 {
     // <FS:Ansariel> Re-add group member list on general panel
-    for (avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
-    {
-        if (it->second.connected())
-        {
-            it->second.disconnect();
-        }
-    }
-    mAvatarNameCacheConnections.clear();
+    // <FS> Names are polled, no callbacks to disconnect
+    //for (avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
+    //{
+    //    if (it->second.connected())
+    //    {
+    //        it->second.disconnect();
+    //    }
+    //}
+    //mAvatarNameCacheConnections.clear();
+    // </FS>
     // </FS:Ansariel>
 }
 
@@ -377,6 +380,12 @@ void LLPanelGroupGeneral::draw()
     {
         updateMembers();
     }
+    // <FS> Add members whose names arrived since
+    else if (!mPendingNameIDs.empty())
+    {
+        updatePendingNames();
+    }
+    // </FS>
     // </FS:Ansariel>
 }
 
@@ -688,7 +697,11 @@ void LLPanelGroupGeneral::update(LLGroupChange gc)
 
         if (gdatap->isMemberDataComplete())
         {
-            mMemberProgress = gdatap->mMembers.begin();
+            // <FS> Page through the member table
+            //mMemberProgress = gdatap->mMembers.begin();
+            mMemberProgress = 0;
+            mPendingNameIDs.clear();
+            // </FS>
             mPendingMemberUpdate = TRUE;
             mIteratorGroup = mGroupID; // <FS:ND/> FIRE-6074
 
@@ -993,53 +1006,50 @@ void LLPanelGroupGeneral::updateMembers()
     // <FS:ND> FIRE-6074; If the group changes, mMemberPRogresss is invalid, as it belongs to a different LLGroupMgrGroupData. Reset it, start over.
     if( mIteratorGroup != mGroupID )
     {
-        mMemberProgress = gdatap->mMembers.begin();
+        //mMemberProgress = gdatap->mMembers.begin();
+        mMemberProgress = 0; // <FS/> Page through the member table
+        mPendingNameIDs.clear();
         mIteratorGroup = mGroupID;
     }
     // </FS:ND> FIRE-6074
 
-    // <FS:Ansariel> Clear old callbacks so we don't end up adding people twice
-    for (avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
-    {
-        if (it->second.connected())
-        {
-            it->second.disconnect();
-        }
-    }
-    mAvatarNameCacheConnections.clear();
-    // </FS:Ansariel>
+    // <FS> Page through the member table, most recently online first
+    const FSGroupMemberTable& table = gdatap->mMemberTable;
+    const U32 num_rows = table.size();
 
     LLAvatarName av_name;
-
-    for( ; mMemberProgress != gdatap->mMembers.end() && !update_time.hasExpired();
-            ++mMemberProgress)
+    std::vector<U32> rows;
+    while (mMemberProgress < num_rows && !update_time.hasExpired())
     {
-        LLGroupMemberData* member = mMemberProgress->second;
-        if (!member)
+        rows.clear();
+        mMemberProgress += table.getPage(FSGroupMemberTable::COL_LAST_LOGIN, false, mMemberProgress, UPDATE_MEMBERS_PAGE_SIZE, rows);
+        for (std::vector<U32>::const_iterator row_it = rows.begin(); row_it != rows.end(); ++row_it)
         {
-            continue;
-        }
+            const LLUUID& member_id = table.getID(*row_it);
+            LLGroupMgrGroupData::member_list_t::iterator member_it = gdatap->mMembers.find(member_id);
+            if (member_it == gdatap->mMembers.end() || !member_it->second)
+            {
+                continue;
+            }
 
-        if (LLAvatarNameCache::get(mMemberProgress->first, &av_name))
-        {
-            addMember(mMemberProgress->second);
-        }
-        else
-        {
-            avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(mMemberProgress->first);
-            if (it != mAvatarNameCacheConnections.end())
+            if (LLAvatarNameCache::get(member_id, &av_name))
             {
-                if (it->second.connected())
-                {
-                    it->second.disconnect();
-                }
-                mAvatarNameCacheConnections.erase(it);
+                addMember(member_it->second);
+            }
+            else
+            {
+                // The lookup above asked for the name, updatePendingNames() adds the member once it is here
+                mPendingNameIDs.push_back(member_id);
             }
-            mAvatarNameCacheConnections[mMemberProgress->first] = LLAvatarNameCache::get(mMemberProgress->first, boost::bind(&LLPanelGroupGeneral::onNameCache, this, gdatap->getMemberVersion(), member, _2, _1));
+        }
+        if (rows.empty())
+        {
+            break;
         }
     }
 
-    if (mMemberProgress == gdatap->mMembers.end())
+    if (mMemberProgress >= num_rows)
+    // </FS>
     {
         LL_DEBUGS() << "   member list completed." << LL_ENDL;
         mListVisibleMembers->setEnabled(TRUE);
@@ -1073,30 +1083,78 @@ void LLPanelGroupGeneral::addMember(LLGroupMemberData* member)
     }
 }
 
-void LLPanelGroupGeneral::onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id)
+// <FS> Names of listed members are polled in batches instead of one callback per member
+//void LLPanelGroupGeneral::onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id)
+//{
+//    avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(av_id);
+//    if (it != mAvatarNameCacheConnections.end())
+//    {
+//        if (it->second.connected())
+//        {
+//            it->second.disconnect();
+//        }
+//        mAvatarNameCacheConnections.erase(it);
+//    }
+//
+//    LLGroupMgrGroupData* gdatap = LLGroupMgr::getInstance()->getGroupData(mGroupID);
+//
+//    if (!gdatap
+//        || !gdatap->isMemberDataComplete()
+//        || gdatap->getMemberVersion() != update_id)
+//    {
+//        // Stale data
+//        return;
+//    }
+//
+//    addMember(member);
+//}
+
+void LLPanelGroupGeneral::updatePendingNames()
 {
-    avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(av_id);
-    if (it != mAvatarNameCacheConnections.end())
+    if (mPendingNameTimer.getElapsedTimeF32() < UPDATE_MEMBERS_NAME_POLL_SECONDS)
     {
-        if (it->second.connected())
-        {
-            it->second.disconnect();
-        }
-        mAvatarNameCacheConnections.erase(it);
+        return;
     }
+    mPendingNameTimer.reset();
 
     LLGroupMgrGroupData* gdatap = LLGroupMgr::getInstance()->getGroupData(mGroupID);
-
-    if (!gdatap
-        || !gdatap->isMemberDataComplete()
-        || gdatap->getMemberVersion() != update_id)
+    if (!mListVisibleMembers
+        || !gdatap
+        || !gdatap->isMemberDataComplete())
     {
         // Stale data
+        mPendingNameIDs.clear();
         return;
     }
 
-    addMember(member);
+    LLTimer update_time;
+    update_time.setTimerExpirySec(UPDATE_MEMBERS_SECONDS_PER_FRAME);
+
+    LLAvatarName av_name;
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i < mPendingNameIDs.size() && !update_time.hasExpired(); ++i)
+    {
+        const LLUUID& member_id = mPendingNameIDs[i];
+        if (!LLAvatarNameCache::get(member_id, &av_name))
+        {
+            mPendingNameIDs[kept++] = member_id;
+            continue;
+        }
+
+        LLGroupMgrGroupData::member_list_t::iterator member_it = gdatap->mMembers.find(member_id);
+        if (member_it != gdatap->mMembers.end() && member_it->second)
+        {
+            addMember(member_it->second);
+        }
+    }
+    for (; i < mPendingNameIDs.size(); ++i)
+    {
+        mPendingNameIDs[kept++] = mPendingNameIDs[i];
+    }
+    mPendingNameIDs.resize(kept);
 }
+// </FS>
 
 S32 LLPanelGroupGeneral::sortMembersList(S32 col_idx,const LLScrollListItem* i1,const LLScrollListItem* i2)
 {
@@ -65,7 +65,8 @@ public:
     virtual void setupCtrls (LLPanel* parent);
 
     // <FS:Ansariel> Re-add group member list on general panel
-    void onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id);
+    //void onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id);
+    void updatePendingNames(); // <FS/> Names of listed members are polled in batches
 
     // <FS:Ansariel> FIRE-20149: Refresh insignia texture when clicking the refresh button
     void refreshInsigniaTexture();
@@ -126,9 +127,14 @@ private:
     void updateMembers();
     S32 sortMembersList(S32,const LLScrollListItem*,const LLScrollListItem*);
 
-    LLGroupMgrGroupData::member_list_t::iterator mMemberProgress;
-    typedef std::unordered_map<LLUUID, boost::signals2::connection, FSUUIDHash> avatar_name_cache_connection_map_t;
-    avatar_name_cache_connection_map_t mAvatarNameCacheConnections;
+    // <FS> Page through the columnar member table
+    //LLGroupMgrGroupData::member_list_t::iterator mMemberProgress;
+    //typedef std::unordered_map<LLUUID, boost::signals2::connection, FSUUIDHash> avatar_name_cache_connection_map_t;
+    //avatar_name_cache_connection_map_t mAvatarNameCacheConnections;
+    U32             mMemberProgress;    // rows of the member table listed so far
+    uuid_vec_t      mPendingNameIDs;    // listed members still waiting for their name
+    LLFrameTimer    mPendingNameTimer;
+    // </FS>
 
     BOOL            mPendingMemberUpdate;
     LLNameListCtrl* mListVisibleMembers;
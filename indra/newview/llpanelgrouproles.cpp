@@ -807,20 +807,23 @@ LLPanelGroupMembersSubTab::LLPanelGroupMembersSubTab()
     mChanged(FALSE),
     mPendingMemberUpdate(FALSE),
     mHasMatch(FALSE),
-    mNumOwnerAdditions(0)
+    mNumOwnerAdditions(0),
+    mMemberProgress(0) // <FS/> Page through the member table
 {
 }
 
 LLPanelGroupMembersSubTab::~LLPanelGroupMembersSubTab()
 {
-    for (avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
-    {
-        if (it->second.connected())
-        {
-            it->second.disconnect();
-        }
-    }
-    mAvatarNameCacheConnections.clear();
+    // <FS> Names are polled, no callbacks to disconnect
+    //for (avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
+    //{
+    //    if (it->second.connected())
+    //    {
+    //        it->second.disconnect();
+    //    }
+    //}
+    //mAvatarNameCacheConnections.clear();
+    // </FS>
     if (mMembersList)
     {
         gSavedSettings.setString("GroupMembersSortOrder", mMembersList->getSortColumnName());
@@ -1693,6 +1696,12 @@ void LLPanelGroupMembersSubTab::draw()
     {
         updateMembers();
     }
+    // <FS> Add members whose names arrived since
+    else if (!mPendingNameIDs.empty())
+    {
+        updatePendingNames();
+    }
+    // </FS>
 }
 
 void LLPanelGroupMembersSubTab::update(LLGroupChange gc)
@@ -1717,7 +1726,11 @@ void LLPanelGroupMembersSubTab::update(LLGroupChange gc)
         && gdatap->isRoleDataComplete()
         && gdatap->isRoleMemberDataComplete())
     {
-        mMemberProgress = gdatap->mMembers.begin();
+        // <FS> Page through the member table
+        //mMemberProgress = gdatap->mMembers.begin();
+        mMemberProgress = 0;
+        mPendingNameIDs.clear();
+        // </FS>
         mPendingMemberUpdate = TRUE;
         mHasMatch = FALSE;
     }
@@ -1777,40 +1790,94 @@ void LLPanelGroupMembersSubTab::addMemberToList(LLGroupMemberData* data)
     mHasMatch = TRUE;
 }
 
-void LLPanelGroupMembersSubTab::onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id)
+// <FS> Names of listed members are polled in batches instead of one callback per member
+//void LLPanelGroupMembersSubTab::onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id)
+//{
+//    avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(av_id);
+//    if (it != mAvatarNameCacheConnections.end())
+//    {
+//        if (it->second.connected())
+//        {
+//            it->second.disconnect();
+//        }
+//        mAvatarNameCacheConnections.erase(it);
+//    }
+//
+//    LLGroupMgrGroupData* gdatap = LLGroupMgr::getInstance()->getGroupData(mGroupID);
+//    if (!gdatap
+//        || gdatap->getMemberVersion() != update_id
+//        || !member)
+//    {
+//        return;
+//    }
+//
+//    // trying to avoid unnecessary hash lookups
+//    // <FS:CR> FIRE-11350
+//    //if (matchesSearchFilter(av_name.getAccountName()))
+//    if (matchesSearchFilter(av_name.getCompleteName()))
+//    // </FS:CR>
+//    {
+//        addMemberToList(member);
+//        if(!mMembersList->getEnabled())
+//        {
+//            mMembersList->setEnabled(TRUE);
+//        }
+//    }
+//
+//}
+
+void LLPanelGroupMembersSubTab::updatePendingNames()
 {
-    avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(av_id);
-    if (it != mAvatarNameCacheConnections.end())
+    if (mPendingNameTimer.getElapsedTimeF32() < UPDATE_MEMBERS_NAME_POLL_SECONDS)
     {
-        if (it->second.connected())
-        {
-            it->second.disconnect();
-        }
-        mAvatarNameCacheConnections.erase(it);
+        return;
     }
+    mPendingNameTimer.reset();
 
     LLGroupMgrGroupData* gdatap = LLGroupMgr::getInstance()->getGroupData(mGroupID);
-    if (!gdatap
-        || gdatap->getMemberVersion() != update_id
-        || !member)
+    if (!gdatap)
     {
+        mPendingNameIDs.clear();
         return;
     }
 
-    // trying to avoid unnecessary hash lookups
-    // <FS:CR> FIRE-11350
-    //if (matchesSearchFilter(av_name.getAccountName()))
-    if (matchesSearchFilter(av_name.getCompleteName()))
-    // </FS:CR>
+    // Looking names up again is cheap while they are still on their way, the
+    // name cache keeps the requests it already sent out
+    LLTimer update_time;
+    update_time.setTimerExpirySec(UPDATE_MEMBERS_SECONDS_PER_FRAME);
+
+    bool added = false;
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i < mPendingNameIDs.size() && !update_time.hasExpired(); ++i)
     {
-        addMemberToList(member);
-        if(!mMembersList->getEnabled())
+        const LLUUID& member_id = mPendingNameIDs[i];
+        LLAvatarName av_name;
+        if (!LLAvatarNameCache::get(member_id, &av_name))
         {
-            mMembersList->setEnabled(TRUE);
+            mPendingNameIDs[kept++] = member_id;
+            continue;
+        }
+
+        LLGroupMgrGroupData::member_list_t::iterator member_it = gdatap->mMembers.find(member_id);
+        if (member_it != gdatap->mMembers.end() && matchesSearchFilter(av_name.getCompleteName()))
+        {
+            addMemberToList(member_it->second);
+            added = true;
         }
     }
+    for (; i < mPendingNameIDs.size(); ++i)
+    {
+        mPendingNameIDs[kept++] = mPendingNameIDs[i];
+    }
+    mPendingNameIDs.resize(kept);
 
+    if (added && !mMembersList->getEnabled())
+    {
+        mMembersList->setEnabled(TRUE);
+    }
 }
+// </FS>
 
 void LLPanelGroupMembersSubTab::updateMembers()
 {
@@ -1835,61 +1902,59 @@ void LLPanelGroupMembersSubTab::updateMembers()
     }
 
     //cleanup list only for first iteration
-    if(mMemberProgress == gdatap->mMembers.begin())
+    // <FS> Page through the member table, most recently online first so
+    // the members people look for are listed in the first frames
+    //if(mMemberProgress == gdatap->mMembers.begin())
+    if (mMemberProgress == 0)
     {
         mMembersList->deleteAllItems();
+        mPendingNameIDs.clear();
     }
 
-    // <FS:Ansariel> Clear old callbacks so we don't end up adding people twice
-    for (avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.begin(); it != mAvatarNameCacheConnections.end(); ++it)
-    {
-        if (it->second.connected())
-        {
-            it->second.disconnect();
-        }
-    }
-    mAvatarNameCacheConnections.clear();
-    // </FS:Ansariel>
-
-    LLGroupMgrGroupData::member_list_t::iterator end = gdatap->mMembers.end();
+    const FSGroupMemberTable& table = gdatap->mMemberTable;
+    const U32 num_rows = table.size();
 
     LLTimer update_time;
     update_time.setTimerExpirySec(UPDATE_MEMBERS_SECONDS_PER_FRAME);
 
-    for( ; mMemberProgress != end && !update_time.hasExpired(); ++mMemberProgress)
+    std::vector<U32> rows;
+    while (mMemberProgress < num_rows && !update_time.hasExpired())
     {
-        if (!mMemberProgress->second)
-            continue;
-
-        // Do filtering on name if it is already in the cache.
-        LLAvatarName av_name;
-        if (LLAvatarNameCache::get(mMemberProgress->first, &av_name))
-        {
-            // <FS:CR> FIRE-11350
-            //if (matchesSearchFilter(av_name.getAccountName()))
-            if (matchesSearchFilter(av_name.getCompleteName()))
-            // </FS:CR>
-            {
-                addMemberToList(mMemberProgress->second);
-            }
-        }
-        else
+        rows.clear();
+        mMemberProgress += table.getPage(FSGroupMemberTable::COL_LAST_LOGIN, false, mMemberProgress, UPDATE_MEMBERS_PAGE_SIZE, rows);
+        for (std::vector<U32>::const_iterator row_it = rows.begin(); row_it != rows.end(); ++row_it)
         {
-            // If name is not cached, onNameCache() should be called when it is cached and add this member to list.
-            avatar_name_cache_connection_map_t::iterator it = mAvatarNameCacheConnections.find(mMemberProgress->first);
-            if (it != mAvatarNameCacheConnections.end())
+            const LLUUID& member_id = table.getID(*row_it);
+            LLGroupMgrGroupData::member_list_t::iterator member_it = gdatap->mMembers.find(member_id);
+            if (member_it == gdatap->mMembers.end() || !member_it->second)
+                continue;
+
+            // Do filtering on name if it is already in the cache.
+            LLAvatarName av_name;
+            if (LLAvatarNameCache::get(member_id, &av_name))
             {
-                if (it->second.connected())
+                // <FS:CR> FIRE-11350
+                //if (matchesSearchFilter(av_name.getAccountName()))
+                if (matchesSearchFilter(av_name.getCompleteName()))
+                // </FS:CR>
                 {
-                    it->second.disconnect();
+                    addMemberToList(member_it->second);
                 }
-                mAvatarNameCacheConnections.erase(it);
             }
-            mAvatarNameCacheConnections[mMemberProgress->first] = LLAvatarNameCache::get(mMemberProgress->first, boost::bind(&LLPanelGroupMembersSubTab::onNameCache, this, gdatap->getMemberVersion(), mMemberProgress->second, _2, _1));
+            else
+            {
+                // The lookup above asked for the name, updatePendingNames() adds the member once it is here
+                mPendingNameIDs.push_back(member_id);
+            }
+        }
+        if (rows.empty())
+        {
+            break;
         }
     }
 
-    if (mMemberProgress == end)
+    if (mMemberProgress >= num_rows)
+    // </FS>
     {
         if (mHasMatch)
         {
@@ -207,7 +207,10 @@ public:
     virtual void setGroupID(const LLUUID& id);
 
     void addMemberToList(LLGroupMemberData* data);
-    void onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id);
+    // <FS> Names of listed members are polled in batches instead of one callback per member
+    //void onNameCache(const LLUUID& update_id, LLGroupMemberData* member, const LLAvatarName& av_name, const LLUUID& av_id);
+    void updatePendingNames();
+    // </FS>
 
 protected:
     typedef std::map<LLUUID, LLRoleMemberChangeType> role_change_data_map_t;
@@ -235,9 +238,14 @@ protected:
     member_role_changes_map_t mMemberRoleChangeData;
     U32 mNumOwnerAdditions;
 
-    LLGroupMgrGroupData::member_list_t::iterator mMemberProgress;
-    typedef std::map<LLUUID, boost::signals2::connection> avatar_name_cache_connection_map_t;
-    avatar_name_cache_connection_map_t mAvatarNameCacheConnections;
+    // <FS> Page through the columnar member table
+    //LLGroupMgrGroupData::member_list_t::iterator mMemberProgress;
+    //typedef std::map<LLUUID, boost::signals2::connection> avatar_name_cache_connection_map_t;
+    //avatar_name_cache_connection_map_t mAvatarNameCacheConnections;
+    U32                 mMemberProgress;        // rows of the member table listed so far
+    uuid_vec_t          mPendingNameIDs;        // listed members still waiting for their name
+    LLFrameTimer        mPendingNameTimer;
+    // </FS>
 
 // [FS:CR] FIRE-12276
 private:
@@ -1015,6 +1015,11 @@ void LLPanelMainInventory::onFilterEdit(const std::string& search_string )
     {
         search_for = mFilterSubString;
     }
+
+    // <FS> Fetch the folders being searched first
+    LLInventoryModelBackgroundFetch::instance().setSearchInterest(!search_for.empty(), mActivePanel->getRootFolderID());
+    // </FS>
+
     if (mActivePanel->getFilterSubString().empty() && search_for.empty())
     // </FS:Ansariel> Separate search for inventory tabs from Satomi Ahn (FIRE-913 & FIRE-6862)
     {
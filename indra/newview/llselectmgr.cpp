@@ -53,6 +53,7 @@
 // viewer includes
 #include "llagent.h"
 #include "llagentcamera.h"
+#include "llappviewer.h" // <FS/> gFrameCount
 #include "llattachmentsmgr.h"
 #include "llaudioengine.h" // <FS:PP> For object deletion sound
 #include "llviewerwindow.h"
@@ -5867,6 +5868,26 @@ void LLSelectMgr::sendListToRegions(LLObjectSelectionHandle selected_handle,
         return;
     }
 
+    // <FS> A selection spanning regions used to flush a message on every
+    // change of region, interleaved nodes gave one message per node. Send
+    // all nodes of a region together, in their order within the region.
+    if (!link_operation && nodes_to_send.size() > 1)
+    {
+        std::vector<LLSelectNode*> nodes;
+        nodes.reserve(nodes_to_send.size());
+        while (!nodes_to_send.empty())
+        {
+            nodes.push_back(nodes_to_send.front());
+            nodes_to_send.pop();
+        }
+        fs_group_by_first_appearance(nodes, [](LLSelectNode* nodep) { return nodep->getObject()->getRegion(); });
+        for (LLSelectNode* nodep : nodes)
+        {
+            nodes_to_send.push(nodep);
+        }
+    }
+    // </FS>
+
     node = nodes_to_send.front();
     nodes_to_send.pop();
 
@@ -7911,7 +7932,12 @@ bool LLObjectSelection::is_root_object::operator()(LLSelectNode *node)
 
 LLObjectSelection::LLObjectSelection() :
     LLRefCount(),
-    mSelectType(SELECT_TYPE_WORLD)
+    mSelectType(SELECT_TYPE_WORLD),
+    // <FS> Root node cache
+    mRootNodesGeneration(0),
+    mRootNodesParentChanges(0),
+    mRootNodesFrame(0)
+    // </FS>
 {
 }
 
@@ -7928,12 +7954,50 @@ void LLObjectSelection::cleanupNodes()
         LLSelectNode* node = *curiter;
         if (node->getObject() == NULL || node->getObject()->isDead())
         {
+            // <FS> Don't leave dangling entries in the lookup map
+            if (node->getObject())
+            {
+                std::unordered_map<LLPointer<LLViewerObject>, LLSelectNode*>::iterator found_it = mSelectNodeMap.find(node->getObject());
+                if (found_it != mSelectNodeMap.end() && found_it->second == node)
+                {
+                    mSelectNodeMap.erase(found_it);
+                }
+            }
+            // </FS>
             mList.erase(curiter);
             delete node;
         }
     }
 }
 
+// <FS> Root nodes without walking every child of large linksets. The cache
+// is only trusted within one frame and is dropped whenever any object changes
+// parents, so an unlink from an ObjectUpdate surfaces the new roots at once.
+void LLObjectSelection::getRootNodes(node_vec_t& roots)
+{
+    if (mRootNodesGeneration != mList.getGeneration()
+        || mRootNodesParentChanges != LLViewerObject::getParentChangeCount()
+        || mRootNodesFrame != gFrameCount)
+    {
+        mRootNodes.clear();
+        is_root test;
+        for (list_t::iterator iter = mList.begin(); iter != mList.end(); ++iter)
+        {
+            if (test(*iter))
+            {
+                mRootNodes.push_back(*iter);
+            }
+        }
+        mRootNodesGeneration = mList.getGeneration();
+        mRootNodesParentChanges = LLViewerObject::getParentChangeCount();
+        mRootNodesFrame = gFrameCount;
+    }
+
+    // A copy, functors applied to the roots may change the selection
+    roots.assign(mRootNodes.begin(), mRootNodes.end());
+}
+// </FS>
+
 void LLObjectSelection::updateEffects()
 {
 }
@@ -8004,8 +8068,11 @@ void LLObjectSelection::addNodeAtEnd(LLSelectNode *nodep)
 
 void LLObjectSelection::moveNodeToFront(LLSelectNode *nodep)
 {
-    mList.remove(nodep);
-    mList.push_front(nodep);
+    // <FS> Indexed node store, no list walk
+    //mList.remove(nodep);
+    //mList.push_front(nodep);
+    mList.move_to_front(nodep);
+    // </FS>
 }
 
 void LLObjectSelection::removeNode(LLSelectNode *nodep)
@@ -8034,7 +8101,8 @@ void LLObjectSelection::deleteAllNodes()
 
 LLSelectNode* LLObjectSelection::findNode(LLViewerObject* objectp)
 {
-    std::map<LLPointer<LLViewerObject>, LLSelectNode*>::iterator found_it = mSelectNodeMap.find(objectp);
+    //std::map<LLPointer<LLViewerObject>, LLSelectNode*>::iterator found_it = mSelectNodeMap.find(objectp);
+    std::unordered_map<LLPointer<LLViewerObject>, LLSelectNode*>::iterator found_it = mSelectNodeMap.find(objectp); // <FS/>
     if (found_it != mSelectNodeMap.end())
     {
         return found_it->second;
@@ -8312,10 +8380,22 @@ S32 LLObjectSelection::getTECount()
 S32 LLObjectSelection::getRootObjectCount()
 {
     S32 count = 0;
-    for (LLObjectSelection::root_iterator iter = root_begin(); iter != root_end(); iter++)
+    // <FS> Cached roots
+    //for (LLObjectSelection::root_iterator iter = root_begin(); iter != root_end(); iter++)
+    //{
+    //    ++count;
+    //}
+    node_vec_t roots;
+    getRootNodes(roots);
+    is_root test;
+    for (LLSelectNode* node : roots)
     {
-        ++count;
+        if (test(node))
+        {
+            ++count;
+        }
     }
+    // </FS>
     return count;
 }
 
@@ -8339,11 +8419,21 @@ bool LLObjectSelection::checkAnimatedObjectEstTris()
     F32 est_tris = 0;
     F32 max_tris = 0;
     S32 anim_count = 0;
-    for (root_iterator iter = root_begin(); iter != root_end(); ++iter)
-    {
-        LLViewerObject* object = (*iter)->getObject();
-        if (!object)
+    // <FS> Cached roots
+    //for (root_iterator iter = root_begin(); iter != root_end(); ++iter)
+    //{
+    //    LLViewerObject* object = (*iter)->getObject();
+    //    if (!object)
+    //        continue;
+    node_vec_t roots;
+    getRootNodes(roots);
+    is_root test;
+    for (LLSelectNode* node : roots)
+    {
+        if (!test(node))
             continue;
+        LLViewerObject* object = node->getObject();
+    // </FS>
         if (object->isAnimatedObject())
         {
             anim_count++;
@@ -8362,12 +8452,22 @@ bool LLObjectSelection::checkAnimatedObjectLinkable()
 bool LLObjectSelection::applyToRootObjects(LLSelectedObjectFunctor* func, bool firstonly)
 {
     bool result = firstonly ? false : true;
-    for (root_iterator iter = root_begin(); iter != root_end(); )
-    {
-        root_iterator nextiter = iter++;
-        LLViewerObject* object = (*nextiter)->getObject();
-        if (!object)
+    // <FS> Cached roots; skip nodes the functor removed from the selection
+    //for (root_iterator iter = root_begin(); iter != root_end(); )
+    //{
+    //    root_iterator nextiter = iter++;
+    //    LLViewerObject* object = (*nextiter)->getObject();
+    //    if (!object)
+    //        continue;
+    node_vec_t roots;
+    getRootNodes(roots);
+    is_root test;
+    for (LLSelectNode* node : roots)
+    {
+        if (!mList.contains(node) || !test(node))
             continue;
+        LLViewerObject* object = node->getObject();
+    // </FS>
         bool r = func->apply(object);
         if (firstonly && r)
             return true;
@@ -8422,10 +8522,19 @@ bool LLObjectSelection::applyToNodes(LLSelectedNodeFunctor *func, bool firstonly
 bool LLObjectSelection::applyToRootNodes(LLSelectedNodeFunctor *func, bool firstonly)
 {
     bool result = firstonly ? false : true;
-    for (root_iterator iter = root_begin(); iter != root_end(); )
-    {
-        root_iterator nextiter = iter++;
-        LLSelectNode* node = *nextiter;
+    // <FS> Cached roots; skip nodes the functor removed from the selection
+    //for (root_iterator iter = root_begin(); iter != root_end(); )
+    //{
+    //    root_iterator nextiter = iter++;
+    //    LLSelectNode* node = *nextiter;
+    node_vec_t roots;
+    getRootNodes(roots);
+    is_root test;
+    for (LLSelectNode* node : roots)
+    {
+        if (!mList.contains(node) || !test(node))
+            continue;
+    // </FS>
         bool r = func->apply(node);
         if (firstonly && r)
             return true;
@@ -8556,9 +8665,18 @@ LLSelectNode* LLObjectSelection::getFirstNode(LLSelectedNodeFunctor* func)
 
 LLSelectNode* LLObjectSelection::getFirstRootNode(LLSelectedNodeFunctor* func, BOOL non_root_ok)
 {
-    for (root_iterator iter = root_begin(); iter != root_end(); ++iter)
+    // <FS> Cached roots
+    //for (root_iterator iter = root_begin(); iter != root_end(); ++iter)
+    //{
+    //    LLSelectNode* node = *iter;
+    node_vec_t roots;
+    getRootNodes(roots);
+    is_root test;
+    for (LLSelectNode* node : roots)
     {
-        LLSelectNode* node = *iter;
+        if (!mList.contains(node) || !test(node))
+            continue;
+    // </FS>
         if (func == NULL || func->apply(node))
         {
             return node;
@@ -44,8 +44,10 @@
 #include "llcontrol.h"
 #include "llviewerobject.h" // LLObjectSelection::getSelectedTEValue template
 #include "llmaterial.h"
+#include "fsselectnodelist.h" // <FS/>
 
 #include <deque>
+#include <unordered_map> // <FS/>
 #include <boost/iterator/filter_iterator.hpp>
 #include <boost/signals2.hpp>
 #include <boost/make_shared.hpp>    // boost::make_shared
@@ -422,14 +424,31 @@ private:
     void removeNode(LLSelectNode *nodep);
     void deleteAllNodes();
     void cleanupNodes();
+    // <FS> Root nodes without walking every child of large linksets
+    typedef std::vector<LLSelectNode*> node_vec_t;
+    void getRootNodes(node_vec_t& roots);
+    // </FS>
 
 
 private:
-    list_t mList;
+    // <FS> Indexed node store
+    //list_t mList;
+    FSSelectNodeList mList;
+    // </FS>
     const LLObjectSelection &operator=(const LLObjectSelection &);
 
     LLPointer<LLViewerObject> mPrimaryObject;
-    std::map<LLPointer<LLViewerObject>, LLSelectNode*> mSelectNodeMap;
+    // <FS> Hashed lookup for findNode()
+    //std::map<LLPointer<LLViewerObject>, LLSelectNode*> mSelectNodeMap;
+    std::unordered_map<LLPointer<LLViewerObject>, LLSelectNode*> mSelectNodeMap;
+
+    // Nodes that were roots when mRootNodes was built, rebuilt when the list
+    // changed, any object changed parents or a new frame started
+    node_vec_t mRootNodes;
+    U32 mRootNodesGeneration;
+    U32 mRootNodesParentChanges;
+    U32 mRootNodesFrame;
+    // </FS>
     ESelectType mSelectType;
 
     // <FS:Zi> Fix for crash while selecting objects with derendered child prims
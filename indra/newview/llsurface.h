@@ -92,6 +92,7 @@ public:
 
     inline F32 getZ(const U32 k) const              { return mSurfaceZ[k]; }
     inline F32 getZ(const S32 i, const S32 j) const { return mSurfaceZ[i + j*mGridsPerEdge]; }
+    const F32* getSurfaceZ() const                  { return mSurfaceZ; } // <FS/> For copies of the height field
 
     LLVector3 getOriginAgent() const;
     const LLVector3d &getOriginGlobal() const;
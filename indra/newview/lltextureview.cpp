@@ -54,6 +54,10 @@
 #include "llvovolume.h"
 #include "llviewerstats.h"
 #include "llworld.h"
+// <FS> Texture residency budget
+#include "llavatarnamecache.h"
+#include "llviewerregion.h"
+// </FS>
 
 // For avatar texture view
 #include "llvoavatarself.h"
@@ -477,6 +481,29 @@ LLRect LLAvatarTexBar::getRequiredRect()
 
 ////////////////////////////////////////////////////////////////////////////
 
+// <FS> Texture residency budget
+static std::string get_residency_owner_label(const FSTextureResidency::Owner& owner)
+{
+    if (owner.mType == FSTextureResidency::OWNER_AVATAR && owner.mID.notNull())
+    {
+        LLAvatarName av_name;
+        if (LLAvatarNameCache::get(owner.mID, &av_name))
+        {
+            return av_name.getUserName();
+        }
+    }
+    else if (owner.mType == FSTextureResidency::OWNER_WORLD && owner.mID.notNull())
+    {
+        LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromID(owner.mID);
+        if (regionp)
+        {
+            return regionp->getName();
+        }
+    }
+    return FSTextureResidency::getOwnerTypeName(owner.mType);
+}
+// </FS>
+
 class LLGLTexMemBar : public LLView
 {
 public:
@@ -567,6 +594,37 @@ void LLGLTexMemBar::draw()
     // </FS:Ansariel>
                                              text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
+    // <FS> Texture residency budget
+    const FSTextureResidency& residency = gTextureList.mResidency;
+    const FSTextureResidency::Usage& residency_total = residency.getTotalUsage();
+    text = llformat("Budget: %d MB%s Resident: %d MB Wanted: %d MB Capped: %d (%d MB)",
+                    (S32)(residency.getBudget() / 1024 / 1024),
+                    residency.isEnforcing() ? " (enforcing)" : "",
+                    (S32)(residency_total.mResidentBytes / 1024 / 1024),
+                    (S32)(residency_total.mWantedBytes / 1024 / 1024),
+                    residency_total.mCapped,
+                    (S32)(residency_total.mCappedBytes / 1024 / 1024));
+    for (S32 i = 0; i < FSTextureResidency::OWNER_COUNT; ++i)
+    {
+        FSTextureResidency::EOwnerType type = (FSTextureResidency::EOwnerType)i;
+        text += llformat(" %s: %d MB", FSTextureResidency::getOwnerTypeName(type),
+                         (S32)(residency.getTypeUsage(type).mResidentBytes / 1024 / 1024));
+    }
+    LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*9,
+                                             text_color, LLFontGL::LEFT, LLFontGL::TOP);
+
+    std::vector<std::pair<FSTextureResidency::Owner, FSTextureResidency::Usage> > top_owners;
+    residency.getTopOwners(top_owners, 5);
+    text = "Top owners:";
+    for (const auto& owner : top_owners)
+    {
+        text += llformat(" %s %d MB (%d tex)", get_residency_owner_label(owner.first).c_str(),
+                         (S32)(owner.second.mResidentBytes / 1024 / 1024), owner.second.mTextures);
+    }
+    LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*8,
+                                             text_color, LLFontGL::LEFT, LLFontGL::TOP);
+    // </FS>
+
     // <FS:Ansariel> Texture memory bars
     S32 bar_left = 0;
     constexpr S32 bar_width = 200;
@@ -754,7 +812,10 @@ LLRect LLGLTexMemBar::getRequiredRect()
     LLRect rect;
     // <FS:Ansariel> Texture memory bars
     //rect.mTop = 78; //LLFontGL::getFontMonospace()->getLineHeight() * 6;
-    rect.mTop = 93;
+    // <FS> Texture residency budget
+    //rect.mTop = 93;
+    rect.mTop = 93 + LLFontGL::getFontMonospace()->getLineHeight() * 2;
+    // </FS>
     // </FS:Ansariel>
     return rect;
 }
@@ -39,7 +39,8 @@ class LLView;
 class LLPanel;
 
 class LLTool
-:   public LLMouseHandler, public LLThreadSafeRefCount
+//: public LLMouseHandler, public LLThreadSafeRefCount
+:   public LLMouseHandler, public LLMainThreadRefCount // <FS/> Tools never leave the main thread
 {
 public:
     LLTool( const std::string& name, LLToolComposite* composite = NULL );
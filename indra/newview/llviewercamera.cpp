@@ -44,6 +44,7 @@
 // [RLVa:KB] - RLVa-2.0.0
 #include "rlvactions.h"
 // [/RLVa:KB]
+#include "fscamerapredictor.h"
 
 // Linden library includes
 #include "lldrawable.h"
@@ -150,6 +151,14 @@ void LLViewerCamera::updateCameraLocation(const LLVector3 &center, const LLVecto
     add(sVelocityStat, dpos);
     add(sAngularVelocityStat, drot);
 
+    // <FS> Predictive LOD
+    static LLCachedControl<bool> camera_prediction(gSavedSettings, "FSCameraPrediction");
+    static LLCachedControl<F32> camera_prediction_horizon(gSavedSettings, "FSCameraPredictionHorizon");
+    static LLCachedControl<F32> camera_prediction_blend(gSavedSettings, "FSCameraPredictionBlend");
+    gCameraPredictor.setParameters(camera_prediction, camera_prediction_horizon, camera_prediction_blend);
+    gCameraPredictor.update(origin, getAtAxis(), LLTimer::getElapsedSeconds());
+    // </FS>
+
     mAverageSpeed = LLTrace::get_frame_recording().getPeriodMeanPerSec(sVelocityStat, 50);
     mAverageAngularSpeed = LLTrace::get_frame_recording().getPeriodMeanPerSec(sAngularVelocityStat);
     mCosHalfCameraFOV = cosf(0.5f * getView() * llmax(1.0f, getAspect()));
@@ -211,6 +211,14 @@ static bool handleDebugAvatarJointsChanged(const LLSD& newvalue)
     return true;
 }
 
+// <FS> Flattened joint hierarchy
+static bool handleFlattenedJointHierarchyChanged(const LLSD& newvalue)
+{
+    LLJoint::sUseFlattenedHierarchy = newvalue.asBoolean();
+    return true;
+}
+// </FS>
+
 static bool handleAvatarHoverOffsetChanged(const LLSD& newvalue)
 {
     if (isAgentAvatarValid())
@@ -1309,6 +1317,7 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "SpellCheckDictionary", handleSpellCheckChanged);
     setting_setup_signal_listener(gSavedSettings, "LoginLocation", handleLoginLocationChanged);
     setting_setup_signal_listener(gSavedSettings, "DebugAvatarJoints", handleDebugAvatarJointsChanged);
+    setting_setup_signal_listener(gSavedSettings, "FSFlattenedJointHierarchy", handleFlattenedJointHierarchyChanged); // <FS> Flattened joint hierarchy
 
     setting_setup_signal_listener(gSavedSettings, "TargetFPS", handleTargetFPSChanged);
     setting_setup_signal_listener(gSavedSettings, "AutoTuneFPS", handleAutoTuneFPSChanged);
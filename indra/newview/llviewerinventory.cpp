@@ -537,6 +537,13 @@ void LLViewerInventoryItem::fetchFromServer(void) const
     }
 }
 
+// <FS> AIS worker unpacking
+void LLViewerInventoryItem::localizeName()
+{
+    LLLocalizedInventoryItemsDictionary::getInstance()->localizeInventoryObjectName(mName);
+}
+// </FS>
+
 // virtual
 BOOL LLViewerInventoryItem::unpackMessage(const LLSD& item)
 {
@@ -163,6 +163,12 @@ public:
     // If this is a broken link, try to fix it and any other identical link.
     BOOL regenerateLink();
 
+    // <FS> AIS responses are unpacked on a worker, the localization
+    // dictionary is only read on the main thread
+    friend class AISUpdate;
+    void localizeName();
+    // </FS>
+
 public:
     bool mIsComplete;
     LLTransactionID mTransactionID;
@@ -245,6 +251,7 @@ public:
 
 private:
     friend class LLInventoryModel;
+    friend class AISUpdate; // <FS/> localizes names unpacked on a worker
     void localizeName(); // intended to be called from the LLInventoryModel
 
 protected:
@@ -160,6 +160,7 @@
 #include "fsfloaterexport.h"
 #include "fsfloatercontacts.h"
 #include "fsfloaterplacedetails.h"
+#include "fsmemtags.h"
 #include "fspose.h"
 #include "lfsimfeaturehandler.h"
 #include "llavatarpropertiesprocessor.h"
@@ -801,6 +802,25 @@ class LLAdvancedDumpInfoToConsole : public view_listener_t
     }
 };
 
+// <FS> Memory tags
+class FSAdvancedDumpMemoryTags : public view_listener_t
+{
+    bool handleEvent(const LLSD& userdata)
+    {
+        std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "memory_tags.txt");
+        llofstream file(filename.c_str());
+        if (!file.is_open())
+        {
+            LL_WARNS() << "Unable to write memory tags to " << filename << LL_ENDL;
+            return true;
+        }
+        FSMemTags::dump(file);
+        LL_INFOS() << "Memory tags written to " << filename << LL_ENDL;
+        return true;
+    }
+};
+// </FS>
+
 
 //////////////
 // HUD INFO //
@@ -12370,6 +12390,7 @@ void initialize_menus()
     view_listener_t::addMenu(new LLAdvancedToggleConsole(), "Advanced.ToggleConsole");
     view_listener_t::addMenu(new LLAdvancedCheckConsole(), "Advanced.CheckConsole");
     view_listener_t::addMenu(new LLAdvancedDumpInfoToConsole(), "Advanced.DumpInfoToConsole");
+    view_listener_t::addMenu(new FSAdvancedDumpMemoryTags(), "Advanced.DumpMemoryTags"); // <FS/> Memory tags
 
     // Advanced > HUD Info
     view_listener_t::addMenu(new LLAdvancedToggleHUDInfo(), "Advanced.ToggleHUDInfo");
@@ -127,6 +127,7 @@ BOOL        LLViewerObject::sVelocityInterpolate = TRUE;
 BOOL        LLViewerObject::sPingInterpolate = TRUE;
 
 U32         LLViewerObject::sNumZombieObjects = 0;
+U32         LLViewerObject::sParentChangeCount = 0; // <FS/> Selection root cache
 S32         LLViewerObject::sNumObjects = 0;
 BOOL        LLViewerObject::sMapDebug = TRUE;
 LLColor4    LLViewerObject::sEditSelectColor(   1.0f, 1.f, 0.f, 0.3f);  // Edit OK
@@ -953,6 +954,12 @@ BOOL LLViewerObject::setParent(LLViewerObject* parent)
     {
         LLViewerObject* old_parent = (LLViewerObject*)mParent ;
         BOOL ret = LLPrimitive::setParent(parent);
+        // <FS> Linking or unlinking changes which selected nodes are roots
+        if (ret)
+        {
+            ++sParentChangeCount;
+        }
+        // </FS>
         if(ret && old_parent && parent)
         {
             old_parent->removeChild(this) ;
@@ -607,6 +607,7 @@ public:
 
     virtual void dump() const;
     static U32      getNumZombieObjects()           { return sNumZombieObjects; }
+    static U32      getParentChangeCount()          { return sParentChangeCount; } // <FS/> Bumped on every reparent
 
     void printNameValuePairs() const;
 
@@ -928,6 +929,7 @@ protected:
 
 private:
     static S32 sNumObjects;
+    static U32 sParentChangeCount; // <FS/> Selection root cache
 
     static F64Seconds sPhaseOutUpdateInterpolationTime; // For motion interpolation
     static F64Seconds sMaxUpdateInterpolationTime;          // For motion interpolation
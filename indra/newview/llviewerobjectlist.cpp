@@ -1621,6 +1621,7 @@ void LLViewerObjectList::killAllObjects()
         LL_WARNS() << "Some objects still on map object list!" << LL_ENDL;
         mMapObjects.clear();
     }
+    mMapFootprints.clear(); // <FS/>
 }
 
 void LLViewerObjectList::cleanDeadObjects(BOOL use_timer)
@@ -1990,6 +1991,11 @@ void LLViewerObjectList::renderObjectsForMap(LLNetMap &netmap)
     static LLCachedControl<F32> max_radius(gSavedSettings, "MiniMapPrimMaxRadius");
     static LLCachedControl<F32> max_zdistance_from_avatar(gSavedSettings, "MiniMapPrimMaxVertDistance");
 
+    // <FS> Objects only update their footprint here, minimaps redraw the
+    // tiles whose footprints changed. Objects skipped below are removed.
+    mMapFootprints.beginPass();
+    // </FS>
+
     for (vobj_list_t::iterator iter = mMapObjects.begin(); iter != mMapObjects.end(); ++iter)
     {
         LLViewerObject* objectp = *iter;
@@ -2108,11 +2114,17 @@ void LLViewerObjectList::renderObjectsForMap(LLNetMap &netmap)
         }
 // </FS:CR>
 
-        netmap.renderScaledPointGlobal(
-            pos,
-            color,
-            approx_radius );
+        // <FS> Incremental minimap object layer
+        //netmap.renderScaledPointGlobal(
+        //    pos,
+        //    color,
+        //    approx_radius );
+        FSMinimapFootprint footprint = { pos.mdV[VX], pos.mdV[VY], approx_radius, color.asRGBA() };
+        mMapFootprints.set(objectp, footprint);
+        // </FS>
     }
+
+    mMapFootprints.endPass(); // <FS/>
 }
 
 void LLViewerObjectList::renderObjectBounds(const LLVector3 &center)
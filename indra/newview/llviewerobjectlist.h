@@ -38,6 +38,7 @@
 #include "llviewerobject.h"
 #include "lleventcoro.h"
 #include "llcoros.h"
+#include "fsminimapraster.h" // <FS/>
 
 class LLCamera;
 class LLNetMap;
@@ -114,6 +115,9 @@ public:
     bool hasMapObjectInRegion(LLViewerRegion* regionp) ;
     void clearAllMapObjectsInRegion(LLViewerRegion* regionp) ;
     void renderObjectsForMap(LLNetMap &netmap);
+    // <FS> Object layer footprints, refreshed by renderObjectsForMap()
+    const FSMinimapFootprints& getMapFootprints() const { return mMapFootprints; }
+    // </FS>
     void renderObjectBounds(const LLVector3 &center);
 
     void addDebugBeacon(const LLVector3 &pos_agent, const std::string &string,
@@ -217,6 +221,7 @@ protected:
     std::vector<LLPointer<LLViewerObject> > mActiveObjects;
 
     vobj_list_t mMapObjects;
+    FSMinimapFootprints mMapFootprints; // <FS/>
 
     // <FS:Beq> deadobject cleanup
     // uuid_set_t   mDeadObjects;
@@ -48,6 +48,7 @@
 #include "llfloatertools.h"
 #include "llglheaders.h"
 #include "pipeline.h"
+#include "workqueue.h" // <FS/> Parcel overlay built on a worker
 
 
 static const U8  OVERLAY_IMG_COMPONENTS = 4;
@@ -65,7 +66,12 @@ LLViewerParcelOverlay::LLViewerParcelOverlay(LLViewerRegion* region, F32 region_
 // </FS:CR> Aurora Sim
     mDirty( FALSE ),
     mTimeSinceLastUpdate(),
-    mOverlayTextureIdx(-1)
+    mOverlayTextureIdx(-1),
+    // <FS> Parcel overlay built on a worker
+    mOverlayVersion(0),
+    mBuildPending(false),
+    mAliveToken(std::make_shared<bool>(true))
+    // </FS>
 {
     // Create a texture to hold color information.
     // 4 components
@@ -94,6 +100,7 @@ LLViewerParcelOverlay::LLViewerParcelOverlay(LLViewerRegion* region, F32 region_
     {
         mOwnership[i] = PARCEL_PUBLIC;
     }
+    fs_build_parcel_minimap_lines(mOwnership, mParcelGridsPerEdge, mMinimapLines, mMarkedCells); // <FS/>
 
     gPipeline.markGLRebuild(this);
 }
@@ -619,14 +626,136 @@ void LLViewerParcelOverlay::addPropertyLine(F32 start_x, F32 start_y, F32 dx, F3
 void LLViewerParcelOverlay::setDirty()
 {
     mDirty = TRUE;
+    ++mOverlayVersion; // <FS/> Results of builds started before are stale
 }
 
 void LLViewerParcelOverlay::updateGL()
 {
     LL_PROFILE_ZONE_SCOPED
+    // <FS> The threaded build uploads its texture when it is done
+    static LLCachedControl<bool> threaded_build(gSavedSettings, "FSParcelOverlayThreadedBuild");
+    if (threaded_build && mOverlayTextureIdx < 0)
+    {
+        return;
+    }
+    // </FS>
     updateOverlayTexture();
 }
 
+// <FS> Parcel overlay built on a worker
+//static
+void LLViewerParcelOverlay::getPropertyColors(LLColor4U colors[FS_PARCEL_COLOR_COUNT])
+{
+    const LLColor4U self = LLUIColorTable::instance().getColor("PropertyColorSelf").get();
+    for (S32 i = 0; i < FS_PARCEL_COLOR_COUNT; i++)
+    {
+        colors[i] = self;
+    }
+    colors[PARCEL_PUBLIC] = LLUIColorTable::instance().getColor("PropertyColorAvail").get();
+    colors[PARCEL_OWNED] = LLUIColorTable::instance().getColor("PropertyColorOther").get();
+    colors[PARCEL_GROUP] = LLUIColorTable::instance().getColor("PropertyColorGroup").get();
+    colors[PARCEL_FOR_SALE] = LLUIColorTable::instance().getColor("PropertyColorForSale").get();
+    colors[PARCEL_AUCTION] = LLUIColorTable::instance().getColor("PropertyColorAuction").get();
+}
+
+// Snapshots ownership, colors and heights and builds texture and lines from
+// them on the general worker. Returns false if nothing could be posted.
+bool LLViewerParcelOverlay::startBuild()
+{
+    LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!main_queue || !general_queue)
+    {
+        return false;
+    }
+
+    static LLCachedControl<bool> show(gSavedSettings, "ShowPropertyLines");
+
+    auto input = std::make_shared<FSParcelOverlayInput>();
+    input->mVersion = mOverlayVersion;
+    input->mGridsPerEdge = mParcelGridsPerEdge;
+    input->mOwnership.assign(mOwnership, mOwnership + mParcelGridsPerEdge * mParcelGridsPerEdge);
+    getPropertyColors(input->mColors);
+    input->mBuildLines = show;
+    if (show)
+    {
+        const LLSurface& land = mRegion->getLand();
+        input->mWaterHeight = land.getWaterHeight();
+        input->mHeights.assign(land.getSurfaceZ(), land.getGridsPerEdge(), land.getMetersPerGrid());
+    }
+
+    auto result = std::make_shared<FSParcelOverlayResult>();
+    std::weak_ptr<bool> alive = mAliveToken;
+    bool posted = false;
+    try
+    {
+        posted = main_queue->postTo(
+            general_queue,
+            [input, result]() // Work done on general queue
+            {
+                fs_build_parcel_overlay(*input, *result);
+            },
+            [this, alive, result]() // Upload on the main thread
+            {
+                if (!alive.expired())
+                {
+                    onBuildDone(*result);
+                }
+            });
+    }
+    catch (const LL::WorkQueue::Closed&)
+    {
+        posted = false;
+    }
+    if (!posted)
+    {
+        return false;
+    }
+
+    mBuildPending = true;
+    mDirty = FALSE;
+    return true;
+}
+
+void LLViewerParcelOverlay::onBuildDone(FSParcelOverlayResult& result)
+{
+    mBuildPending = false;
+    if (result.mVersion != mOverlayVersion || gGLManager.mIsDisabled)
+    {
+        // Ownership or land changed while building, the next idle update
+        // builds again
+        mDirty = TRUE;
+        return;
+    }
+
+    const S32 pixel_bytes = mParcelGridsPerEdge * mParcelGridsPerEdge * OVERLAY_IMG_COMPONENTS;
+    if ((S32)result.mPixels.size() == pixel_bytes)
+    {
+        memcpy(mImageRaw->getData(), result.mPixels.data(), pixel_bytes);      /*Flawfinder: ignore*/
+        if (!mTexture->hasGLTexture())
+        {
+            mTexture->createGLTexture(0, mImageRaw);
+        }
+        mTexture->setSubImage(mImageRaw, 0, 0, mParcelGridsPerEdge, mParcelGridsPerEdge);
+    }
+
+    if (result.mHasLines)
+    {
+        mEdges.swap(result.mEdges);
+    }
+    else
+    {
+        // Like the synchronous path, keep looking until lines are shown
+        mDirty = TRUE;
+    }
+    mMinimapLines.swap(result.mMinimapLines);
+    mMarkedCells.swap(result.mMarkedCells);
+
+    if (mUpdateSignal)
+        (*mUpdateSignal)(mRegion);
+}
+// </FS>
+
 void LLViewerParcelOverlay::idleUpdate(bool force_update)
 {
     if (gGLManager.mIsDisabled)
@@ -644,8 +773,25 @@ void LLViewerParcelOverlay::idleUpdate(bool force_update)
     {
         if (force_update || mTimeSinceLastUpdate.getElapsedTimeF32() > 4.0f)
         {
+            // <FS> Build on a worker, only the texture upload stays here
+            static LLCachedControl<bool> threaded_build(gSavedSettings, "FSParcelOverlayThreadedBuild");
+            if (threaded_build)
+            {
+                if (mBuildPending)
+                {
+                    // One build per region at a time
+                    return;
+                }
+                if (startBuild())
+                {
+                    mTimeSinceLastUpdate.reset();
+                    return;
+                }
+            }
+            // </FS>
             updateOverlayTexture();
             updatePropertyLines();
+            fs_build_parcel_minimap_lines(mOwnership, mParcelGridsPerEdge, mMinimapLines, mMarkedCells); // <FS/>
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
             if (mUpdateSignal)
                 (*mUpdateSignal)(mRegion);
@@ -801,28 +947,38 @@ void LLViewerParcelOverlay::renderPropertyLinesOnMinimap(F32 scale_pixels_per_me
     F32       region_left      = rel_region_pos.mV[0] * scale_pixels_per_meter;
     F32       region_bottom    = rel_region_pos.mV[1] * scale_pixels_per_meter;
     F32       map_parcel_width = PARCEL_GRID_STEP_METERS * scale_pixels_per_meter;
-    const S32 GRIDS_PER_EDGE   = mParcelGridsPerEdge;
+    //const S32 GRIDS_PER_EDGE   = mParcelGridsPerEdge; // <FS/> Merged when built
 
     gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
     glLineWidth(1.0f);
     gGL.color4fv(parcel_outline_color);
-    for (S32 i = 0; i <= GRIDS_PER_EDGE; i++)
+    // <FS> Borders are merged into runs when the overlay is built, draw them
+    // in one batch instead of one per cell
+    //for (S32 i = 0; i <= GRIDS_PER_EDGE; i++)
+    //{
+    //    const F32 bottom = region_bottom + (i * map_parcel_width);
+    //    const F32 top    = bottom + map_parcel_width;
+    //    for (S32 j = 0; j <= GRIDS_PER_EDGE; j++)
+    //    {
+    //        const F32  left               = region_left + (j * map_parcel_width);
+    //        const F32  right              = left + map_parcel_width;
+    //        const bool is_region_boundary = i == GRIDS_PER_EDGE || j == GRIDS_PER_EDGE;
+    //        const U8   overlay            = is_region_boundary ? 0 : mOwnership[(i * GRIDS_PER_EDGE) + j];
+    //        // The property line vertices are three-dimensional, but here we only care about the x and y coordinates, as we are drawing on a
+    //        // 2D map
+    //        const bool has_left   = i != GRIDS_PER_EDGE && (j == GRIDS_PER_EDGE || (overlay & PARCEL_WEST_LINE));
+    //        const bool has_bottom = j != GRIDS_PER_EDGE && (i == GRIDS_PER_EDGE || (overlay & PARCEL_SOUTH_LINE));
+    //        grid_2d_part_lines(left, top, right, bottom, has_left, has_bottom);
+    //    }
+    //}
+    gGL.begin(LLRender::LINES);
+    for (const FSParcelLineSegment& segment : mMinimapLines)
     {
-        const F32 bottom = region_bottom + (i * map_parcel_width);
-        const F32 top    = bottom + map_parcel_width;
-        for (S32 j = 0; j <= GRIDS_PER_EDGE; j++)
-        {
-            const F32  left               = region_left + (j * map_parcel_width);
-            const F32  right              = left + map_parcel_width;
-            const bool is_region_boundary = i == GRIDS_PER_EDGE || j == GRIDS_PER_EDGE;
-            const U8   overlay            = is_region_boundary ? 0 : mOwnership[(i * GRIDS_PER_EDGE) + j];
-            // The property line vertices are three-dimensional, but here we only care about the x and y coordinates, as we are drawing on a
-            // 2D map
-            const bool has_left   = i != GRIDS_PER_EDGE && (j == GRIDS_PER_EDGE || (overlay & PARCEL_WEST_LINE));
-            const bool has_bottom = j != GRIDS_PER_EDGE && (i == GRIDS_PER_EDGE || (overlay & PARCEL_SOUTH_LINE));
-            grid_2d_part_lines(left, top, right, bottom, has_left, has_bottom);
-        }
+        gGL.vertex2f(region_left + segment.mStartX * map_parcel_width, region_bottom + segment.mStartY * map_parcel_width);
+        gGL.vertex2f(region_left + segment.mEndX * map_parcel_width, region_bottom + segment.mEndY * map_parcel_width);
     }
+    gGL.end();
+    // </FS>
 }
 
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
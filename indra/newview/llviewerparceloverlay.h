@@ -35,6 +35,9 @@
 #include "lluuid.h"
 #include "llviewertexture.h"
 #include "llgl.h"
+#include "fsparceloverlaybuilder.h" // <FS/> Parcel overlay built on a worker
+
+#include <memory>
 
 class LLViewerRegion;
 class LLVector3;
@@ -69,6 +72,9 @@ public:
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
     const U8*       getOwnership() const { return mOwnership; }
 // [/SL:KB]
+    // <FS> Cells with a border, for sale or at auction, as of the last build
+    const std::vector<U32>& getMarkedCells() const { return mMarkedCells; }
+    // </FS>
 
     // Returns the number of vertices drawn
     void            renderPropertyLines();
@@ -105,6 +111,12 @@ private:
     void    updateOverlayTexture();
     void    updatePropertyLines();
 
+    // <FS> Parcel overlay built on a worker
+    static void getPropertyColors(LLColor4U colors[FS_PARCEL_COLOR_COUNT]);
+    bool    startBuild();
+    void    onBuildDone(FSParcelOverlayResult& result);
+    // </FS>
+
 private:
     // Back pointer to the region that owns this structure.
     LLViewerRegion* mRegion;
@@ -127,14 +139,25 @@ private:
     LLFrameTimer    mTimeSinceLastUpdate;
     S32             mOverlayTextureIdx;
 
-    struct Edge
-    {
-        std::vector<LLVector3> vertices;
-        LLColor4U color;
-    };
+    // <FS> Same edges, built by fs_build_parcel_overlay()
+    //struct Edge
+    //{
+    //    std::vector<LLVector3> vertices;
+    //    LLColor4U color;
+    //};
+    typedef FSParcelOverlayEdge Edge;
+    // </FS>
 
     std::vector<Edge> mEdges;
 
+    // <FS> Parcel overlay built on a worker
+    U32                     mOverlayVersion;    // bumped by every change of ownership or heights
+    bool                    mBuildPending;
+    std::shared_ptr<bool>   mAliveToken;        // lets pending builds notice the overlay is gone
+    std::vector<FSParcelLineSegment> mMinimapLines;
+    std::vector<U32>        mMarkedCells;
+    // </FS>
+
 // [SL:KB] - Patch: World-MinimapOverlay | Checked: 2012-06-20 (Catznip-3.3)
     static update_signal_t* mUpdateSignal;
 // [/SL:KB]
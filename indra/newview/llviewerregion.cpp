@@ -86,6 +86,8 @@
 #include <boost/regex.hpp>
 
 // Firestorm includes
+#include "fscamerapredictor.h"
+#include "fsregionprefetch.h"
 #include "lfsimfeaturehandler.h"
 #include "llviewermenu.h"
 #include "llviewernetwork.h"
@@ -857,6 +859,10 @@ void LLViewerRegion::loadObjectCache()
             mCacheDirty = TRUE;
         }
     }
+
+    // <FS> Region prefetch
+    FSRegionPrefetch::instance().planRegion(this, mImpl->mCacheMap);
+    // </FS>
 }
 
 
@@ -1502,6 +1508,11 @@ void LLViewerRegion::updateVisibleEntries(F32 max_time)
     U32 last_update = mImpl->mLastCameraUpdate;
     LLVector4a local_origin;
     local_origin.load3((camera_origin - getOriginAgent()).mV);
+    // <FS> Predictive LOD: also promote entries ahead of a moving camera
+    LLVector4a local_predicted_origin;
+    local_predicted_origin.load3((gCameraPredictor.getPredictedOrigin() - getOriginAgent()).mV);
+    const LLVector4a* predicted_origin = gCameraPredictor.isActive() ? &local_predicted_origin : NULL;
+    // </FS>
 
     //process visible entries
     for(LLVOCacheEntry::vocache_entry_set_t::iterator iter = mImpl->mVisibleEntries.begin(); iter != mImpl->mVisibleEntries.end();)
@@ -1535,8 +1546,12 @@ void LLViewerRegion::updateVisibleEntries(F32 max_time)
     std::set< LLPointer<LLViewerOctreeGroup> >::iterator group_iter = mImpl->mVisibleGroups.begin();
     for(; group_iter != mImpl->mVisibleGroups.end(); ++group_iter)
     {
-        LLPointer<LLViewerOctreeGroup> group = *group_iter;
-        if(group->getNumRefs() < 3 || //group to be deleted
+        // <FS> Borrowed pointers
+        //LLPointer<LLViewerOctreeGroup> group = *group_iter;
+        //if(group->getNumRefs() < 3 || //group to be deleted
+        LLBorrowedPointer<LLViewerOctreeGroup> group = *group_iter;
+        if(group->getNumRefs() < 2 || //group to be deleted, one reference less than with the copy
+        // </FS>
             !group->getOctreeNode() || group->isEmpty()) //group empty
         {
             continue;
@@ -1558,7 +1573,10 @@ void LLViewerRegion::updateVisibleEntries(F32 max_time)
                     continue; //skip invalid entry.
                 }
 
-                vo_entry->calcSceneContribution(local_origin, needs_update, last_update, dist_threshold);
+                // <FS> Predictive LOD
+                //vo_entry->calcSceneContribution(local_origin, needs_update, last_update, dist_threshold);
+                vo_entry->calcSceneContribution(local_origin, needs_update, last_update, dist_threshold, predicted_origin, gCameraPredictor.getBlend());
+                // </FS>
                 if(vo_entry->getSceneContribution() > projection_threshold)
                 {
                     mImpl->mWaitingList.insert(vo_entry);
@@ -66,6 +66,8 @@
 #include "llinventorymodel.h"
 #include "lluiusage.h"
 #include "lltranslate.h"
+#include "fsmemtags.h" // <FS/> Memory tags
+#include "fsframearena.h" // <FS/> Frame arena
 
 // "Minimal Vulkan" to get max API Version
 
@@ -378,10 +380,58 @@ U32Bytes            gTotalTextureBytesPerBoostLevel[LLViewerTexture::MAX_GL_IMAG
 extern U32  gVisCompared;
 extern U32  gVisTested;
 
+// <FS> Memory tags
+static LLTrace::SampleStatHandle<F64Megabytes> MEM_TAG_LIVE[FSMT_COUNT] =
+{
+    { "memtagtextures", "Image memory accounted to textures" },
+    { "memtagmeshes", "Geometry accounted to meshes and prims" },
+    { "memtagllsd", "Memory held by LLSD values" },
+    { "memtagui", "Memory held by views and widgets" },
+    { "memtaginventory", "Memory held by inventory items and folders" }
+};
+static LLTrace::CountStatHandle<> MEM_TAG_ALLOCATIONS[FSMT_COUNT] =
+{
+    { "memtagtexturesallocs", "Allocations accounted to textures" },
+    { "memtagmeshesallocs", "Allocations accounted to meshes and prims" },
+    { "memtagllsdallocs", "Allocations of LLSD values" },
+    { "memtaguiallocs", "Allocations of views and widgets" },
+    { "memtaginventoryallocs", "Allocations of inventory items and folders" }
+};
+
+static void update_memory_tag_stats()
+{
+    static U64 last_allocations[FSMT_COUNT] = { 0 };
+    for (S32 tag = 0; tag < FSMT_COUNT; ++tag)
+    {
+        FSMemTags::Totals totals = FSMemTags::getTotals(tag);
+        sample(MEM_TAG_LIVE[tag], F64Bytes((F64)llmax(totals.mLiveBytes, (S64)0)));
+        add(MEM_TAG_ALLOCATIONS[tag], (F64)(totals.mAllocations - last_allocations[tag]));
+        last_allocations[tag] = totals.mAllocations;
+    }
+}
+// </FS>
+
+// <FS> Frame arena
+static LLTrace::CountStatHandle<> FRAME_ARENA_REQUESTS("framearenarequests", "Allocations served by the main thread frame arena");
+static LLTrace::CountStatHandle<> FRAME_ARENA_MALLOCS("framearenamallocs", "Heap allocations made by the main thread frame arena");
+static LLTrace::SampleStatHandle<F64Kilobytes> FRAME_ARENA_CAPACITY("framearenacapacity", "Size of the main thread frame arena");
+
+static void update_frame_arena_stats()
+{
+    const FSFrameArena& arena = FSFrameArena::instance();
+    add(FRAME_ARENA_REQUESTS, (F64)arena.getFrameStats().mRequests);
+    add(FRAME_ARENA_MALLOCS, (F64)arena.getFrameStats().mSystemAllocations);
+    sample(FRAME_ARENA_CAPACITY, F64Bytes((F64)arena.getCapacity()));
+}
+// </FS>
+
 void update_statistics()
 {
     LL_PROFILE_ZONE_SCOPED;
 
+    update_memory_tag_stats(); // <FS/> Memory tags
+    update_frame_arena_stats(); // <FS/> Frame arena
+
     gTotalWorldData += gVLManager.getTotalBytes();
     gTotalObjectData += gObjectData;
 
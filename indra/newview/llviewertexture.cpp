@@ -3298,6 +3298,24 @@ bool LLViewerLODTexture::scaleDown()
     }
     return false;
 }
+// <FS> Texture residency budget
+void LLViewerLODTexture::applyDiscardCap(S32 discard_cap)
+{
+    if (discard_cap <= mDesiredDiscardLevel || mForceToSaveRawImage)
+    {
+        return;
+    }
+
+    mDesiredDiscardLevel = (S8)llmin(discard_cap, getMaxDiscardLevel() + 1);
+
+    S32 current_discard = getDiscardLevel();
+    if (current_discard >= 0 && current_discard < mDesiredDiscardLevel)
+    {
+        scaleDown();
+    }
+}
+// </FS>
+
 //----------------------------------------------------------------------------------------------
 //end of LLViewerLODTexture
 //----------------------------------------------------------------------------------------------
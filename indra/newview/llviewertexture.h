@@ -590,6 +590,10 @@ public:
     /*virtual*/ void processTextureStats();
     bool isUpdateFrozen() ;
 
+    // <FS> Texture residency budget: keep the texture at or above this discard level
+    void applyDiscardCap(S32 discard_cap);
+    // </FS>
+
 private:
     void init(bool firstinit) ;
     bool scaleDown() ;
@@ -61,6 +61,8 @@
 #include "llviewerdisplay.h"
 #include "llviewerwindow.h"
 #include "llprogressview.h"
+#include "llvoavatar.h" // <FS> Texture residency budget
+#include "lltextureview.h" // <FS> Texture residency budget
 
 ////////////////////////////////////////////////////////////////////////////
 
@@ -95,6 +97,7 @@ LLTextureKey::LLTextureKey(LLUUID id, ETexListType tex_type)
 
 LLViewerTextureList::LLViewerTextureList()
     : mForceResetTextureStats(FALSE),
+    mResidencyActive(false), // <FS/> Texture residency budget
     mInitialized(FALSE)
 {
 }
@@ -781,6 +784,12 @@ void LLViewerTextureList::deleteImage(LLViewerFetchedTexture *image)
         }
         LLTextureKey key(image->getID(), (ETexListType)image->getTextureListType());
         llverify(mUUIDMap.erase(key) == 1);
+        // <FS> Texture residency budget
+        FSTextureResidency::Key residency_key;
+        residency_key.mID = key.textureId;
+        residency_key.mList = key.textureType;
+        mResidency.removeTexture(residency_key);
+        // </FS>
         sNumImages--;
         removeImageFromList(image);
     }
@@ -863,6 +872,8 @@ void LLViewerTextureList::updateImages(F32 max_time)
     }
 
     updateImagesUpdateStats();
+
+    updateResidencyBudget(); // <FS> Texture residency budget
 }
 
 void LLViewerTextureList::clearFetchingRequests()
@@ -893,6 +904,59 @@ static void touch_texture(LLViewerFetchedTexture* tex, F32 vsize)
 
 extern BOOL gCubeSnapshot;
 
+// <FS> Texture residency budget
+static FSTextureResidency::Owner get_residency_owner(LLViewerFetchedTexture* imagep, LLViewerObject* objectp)
+{
+    FSTextureResidency::Owner owner;
+    if (objectp)
+    {
+        LLVOAvatar* avatarp = objectp->asAvatar() ? objectp->asAvatar() : objectp->getAvatar();
+        if (objectp->isHUDAttachment())
+        {
+            owner.mType = FSTextureResidency::OWNER_HUD;
+        }
+        else if (avatarp)
+        {
+            owner.mType = FSTextureResidency::OWNER_AVATAR;
+            owner.mID = avatarp->getID();
+        }
+        else if (objectp->getRegion())
+        {
+            owner.mType = FSTextureResidency::OWNER_WORLD;
+            owner.mID = objectp->getRegion()->getRegionID();
+        }
+        return owner;
+    }
+
+    switch (imagep->getBoostLevel())
+    {
+        case LLGLTexture::BOOST_AVATAR:
+        case LLGLTexture::BOOST_AVATAR_BAKED:
+        case LLGLTexture::BOOST_AVATAR_BAKED_SELF:
+        case LLGLTexture::BOOST_AVATAR_SELF:
+            owner.mType = FSTextureResidency::OWNER_AVATAR;
+            break;
+        case LLGLTexture::BOOST_TERRAIN:
+            owner.mType = FSTextureResidency::OWNER_WORLD;
+            break;
+        case LLGLTexture::BOOST_HUD:
+            owner.mType = FSTextureResidency::OWNER_HUD;
+            break;
+        case LLGLTexture::BOOST_ICON:
+        case LLGLTexture::BOOST_THUMBNAIL:
+        case LLGLTexture::BOOST_UI:
+        case LLGLTexture::BOOST_PREVIEW:
+        case LLGLTexture::BOOST_MAP:
+        case LLGLTexture::BOOST_MAP_VISIBLE:
+            owner.mType = FSTextureResidency::OWNER_UI;
+            break;
+        default:
+            break;
+    }
+    return owner;
+}
+// </FS>
+
 void LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imagep)
 {
     if (imagep->isInDebug() || imagep->isUnremovable())
@@ -905,6 +969,11 @@ void LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imag
 
     static LLCachedControl<F32> bias_distance_scale(gSavedSettings, "TextureBiasDistanceScale", 1.f);
 
+    // <FS> Texture residency budget: the face with the largest share owns the texture
+    F32 owner_vsize = -1.f;
+    LLViewerObject* owner_objectp = NULL;
+    // </FS>
+
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE
     {
         for (U32 i = 0; i < LLRender::NUM_TEXTURE_CHANNELS; ++i)
@@ -939,6 +1008,13 @@ void LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imag
                         vsize /= LLViewerTexture::sDesiredDiscardBias;
                     }
 // #endif // <FS:Beq/>
+                    // <FS> Texture residency budget
+                    if (vsize > owner_vsize)
+                    {
+                        owner_vsize = vsize;
+                        owner_objectp = face->getViewerObject();
+                    }
+                    // </FS>
                     // if a GLTF material is present, ignore that face
                     // as far as this texture stats go, but update the GLTF material
                     // stats
@@ -1026,7 +1102,78 @@ void LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imag
     }
 
     imagep->processTextureStats();
+
+    // <FS> Texture residency budget
+    if (mResidencyActive)
+    {
+        updateResidency(imagep, get_residency_owner(imagep, owner_objectp));
+    }
+    // </FS>
+}
+
+// <FS> Texture residency budget
+void LLViewerTextureList::updateResidency(LLViewerFetchedTexture* imagep, const FSTextureResidency::Owner& owner)
+{
+    FSTextureResidency::Key key;
+    key.mID = imagep->getID();
+    key.mList = imagep->getTextureListType();
+
+    // Only LOD textures can drop mips they already have; baked, UI and HUD
+    // textures still count against the budget
+    bool evictable = imagep->getType() == LLViewerTexture::LOD_TEXTURE
+                     && imagep->getBoostLevel() < LLGLTexture::BOOST_AVATAR_BAKED
+                     && !imagep->getDontDiscard()
+                     && imagep->getUseMipMaps();
+
+    mResidency.updateTexture(key, owner, imagep->getFullWidth(), imagep->getFullHeight(), imagep->getComponents(),
+                             imagep->getMaxDiscardLevel(), imagep->getDiscardLevel(), imagep->getDesiredDiscardLevel(),
+                             imagep->getMaxVirtualSize(), evictable, gFrameTimeSeconds);
+
+    S32 discard_cap = mResidency.getDiscardCap(key);
+    if (evictable && discard_cap > 0)
+    {
+        static_cast<LLViewerLODTexture*>(imagep)->applyDiscardCap(discard_cap);
+    }
+}
+
+void LLViewerTextureList::updateResidencyBudget()
+{
+    static LLCachedControl<bool> budget_enabled(gSavedSettings, "FSTextureMemoryBudget");
+    static LLCachedControl<U32> budget_mb(gSavedSettings, "FSTextureMemoryBudgetMB");
+    static LLCachedControl<U32> max_vram_budget(gSavedSettings, "RenderMaxVRAMBudget", 0);
+
+    // Without a budget the books are only read by the texture console, so
+    // don't keep them per texture and frame while it is closed
+    bool active = budget_enabled || (gTextureView && gTextureView->getVisible());
+    if (!active)
+    {
+        if (mResidencyActive)
+        {
+            mResidency.clear();
+            mResidencyActive = false;
+        }
+        return;
+    }
+    mResidencyActive = true;
+
+    U64 budget = 0;
+    if (budget_enabled)
+    {
+        S32 mb = budget_mb;
+        if (mb == 0)
+        {
+            // Same target as LLViewerTexture::updateClass() with a quarter
+            // left for vertex buffers and render targets
+            S32 vram = max_vram_budget == 0 ? gGLManager.mVRAM : (S32)max_vram_budget;
+            mb = llmax(vram - 512, 768) * 3 / 4;
+        }
+        budget = (U64)mb * 1024 * 1024;
+    }
+
+    mResidency.setBudget(budget);
+    mResidency.update(gFrameTimeSeconds);
 }
+// </FS>
 
 void LLViewerTextureList::setDebugFetching(LLViewerFetchedTexture* tex, S32 debug_level)
 {
@@ -1158,7 +1305,8 @@ F32 LLViewerTextureList::updateImagesFetchTextures(F32 max_time)
 
     LLTimer timer;
 
-    LLPointer<LLViewerTexture> last_imagep = nullptr;
+    //LLPointer<LLViewerTexture> last_imagep = nullptr;
+    LLBorrowedPointer<LLViewerFetchedTexture> last_imagep; // <FS/> Borrowed pointers, entries keep it alive
 
     for (auto& imagep : entries)
     {
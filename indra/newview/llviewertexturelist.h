@@ -35,6 +35,7 @@
 #include <list>
 #include <set>
 #include "lluiimage.h"
+#include "fstextureresidency.h" // <FS> Texture residency budget
 
 const U32 LL_IMAGE_REZ_LOSSLESS_CUTOFF = 128;
 
@@ -166,6 +167,11 @@ private:
     void addImageToList(LLViewerFetchedTexture *image);
     void removeImageFromList(LLViewerFetchedTexture *image);
 
+    // <FS> Texture residency budget
+    void updateResidency(LLViewerFetchedTexture* imagep, const FSTextureResidency::Owner& owner);
+    void updateResidencyBudget();
+    // </FS>
+
 public:     // PoundLife - Improved Object Inspect
     LLViewerFetchedTexture * getImage(const LLUUID &image_id,
                                      FTType f_type = FTT_DEFAULT,
@@ -228,6 +234,11 @@ public:
     // <FS:Ansariel> Fast cache stats
     static U32 sNumFastCacheReads;
 
+    // <FS> Texture residency budget
+    FSTextureResidency mResidency;
+    bool mResidencyActive; // budget enabled or texture console open
+    // </FS>
+
 private:
     typedef std::map< LLTextureKey, LLPointer<LLViewerFetchedTexture> > uuid_map_t;
     uuid_map_t mUUIDMap;
@@ -1231,6 +1231,7 @@ void LLVOAvatar::initClass()
 
     // Where should this be set initially?
     LLJoint::setDebugJointNames(gSavedSettings.getString("DebugAvatarJoints"));
+    LLJoint::sUseFlattenedHierarchy = gSavedSettings.getBOOL("FSFlattenedJointHierarchy"); // <FS> Flattened joint hierarchy
 
     LLControlAvatar::sRegionChangedSlot = gAgent.addRegionChangedCallback(&LLControlAvatar::onRegionChanged);
 
@@ -6829,7 +6830,8 @@ BOOL LLVOAvatar::startMotion(const LLUUID& id, F32 time_offset)
         }
         else
         {
-            gAgent.sendAnimationRequest(remap_id, ANIM_REQUEST_START);
+            //gAgent.sendAnimationRequest(remap_id, ANIM_REQUEST_START);
+            AOEngine::getInstance()->requestAnimation(remap_id, true); // <FS/> coalesced per frame
 
             // since we did an override, there is no need to do anything else,
             // specifically not the startMotion() part at the bottom of this function
@@ -6875,7 +6877,8 @@ BOOL LLVOAvatar::stopMotion(const LLUUID& id, BOOL stop_immediate)
         }
         else
         {
-            gAgent.sendAnimationRequest(remap_id, ANIM_REQUEST_STOP);
+            //gAgent.sendAnimationRequest(remap_id, ANIM_REQUEST_STOP);
+            AOEngine::getInstance()->requestAnimation(remap_id, false); // <FS/> coalesced per frame
 
             // since we did an override, there is no need to do anything else,
             // specifically not the stopMotion() part at the bottom of this function
@@ -589,13 +589,56 @@ bool LLVOCacheEntry::isAnyVisible(const LLVector4a& camera_origin, const LLVecto
     return vis;
 }
 
-void LLVOCacheEntry::calcSceneContribution(const LLVector4a& camera_origin, bool needs_update, U32 last_update, F32 max_dist)
+// <FS> Predictive LOD: entries the camera is heading towards are promoted early
+//void LLVOCacheEntry::calcSceneContribution(const LLVector4a& camera_origin, bool needs_update, U32 last_update, F32 max_dist)
+void LLVOCacheEntry::calcSceneContribution(const LLVector4a& camera_origin, bool needs_update, U32 last_update, F32 max_dist,
+                                           const LLVector4a* predicted_origin, F32 predicted_weight)
+// </FS>
 {
     if(!needs_update && getVisible() >= last_update)
     {
         return; //no need to update
     }
 
+    // <FS> Predictive LOD
+    //LLVector4a lookAt;
+    //lookAt.setSub(getPositionGroup(), camera_origin);
+    //F32 distance = lookAt.getLength3().getF32();
+    //distance -= sNearRadius;
+
+    //if(distance <= 0.f)
+    //{
+    //    //nearby objects, set a large number
+    //    const F32 LARGE_SCENE_CONTRIBUTION = 1000.f; //a large number to force to load the object.
+    //    mSceneContrib = LARGE_SCENE_CONTRIBUTION;
+    //}
+    //else
+    //{
+    //    F32 rad = getBinRadius();
+    //    max_dist += rad;
+
+    //    if(distance + sNearRadius < max_dist)
+    //    {
+    //        mSceneContrib = (rad * rad) / distance;
+    //    }
+    //    else
+    //    {
+    //        mSceneContrib = 0.f; //out of draw distance, not to load
+    //    }
+    //}
+    mSceneContrib = calcSceneContributionFrom(camera_origin, max_dist);
+    if (predicted_origin && predicted_weight > 0.f)
+    {
+        mSceneContrib = llmax(mSceneContrib, predicted_weight * calcSceneContributionFrom(*predicted_origin, max_dist));
+    }
+    // </FS>
+
+    setVisible();
+}
+
+// <FS> Predictive LOD
+F32 LLVOCacheEntry::calcSceneContributionFrom(const LLVector4a& camera_origin, F32 max_dist) const
+{
     LLVector4a lookAt;
     lookAt.setSub(getPositionGroup(), camera_origin);
     F32 distance = lookAt.getLength3().getF32();
@@ -605,25 +648,19 @@ void LLVOCacheEntry::calcSceneContribution(const LLVector4a& camera_origin, bool
     {
         //nearby objects, set a large number
         const F32 LARGE_SCENE_CONTRIBUTION = 1000.f; //a large number to force to load the object.
-        mSceneContrib = LARGE_SCENE_CONTRIBUTION;
+        return LARGE_SCENE_CONTRIBUTION;
     }
-    else
-    {
-        F32 rad = getBinRadius();
-        max_dist += rad;
 
-        if(distance + sNearRadius < max_dist)
-        {
-            mSceneContrib = (rad * rad) / distance;
-        }
-        else
-        {
-            mSceneContrib = 0.f; //out of draw distance, not to load
-        }
-    }
+    F32 rad = getBinRadius();
+    max_dist += rad;
 
-    setVisible();
+    if(distance + sNearRadius < max_dist)
+    {
+        return (rad * rad) / distance;
+    }
+    return 0.f; //out of draw distance, not to load
 }
+// </FS>
 
 void LLVOCacheEntry::saveBoundingSphere()
 {
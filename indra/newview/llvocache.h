@@ -127,7 +127,12 @@ public:
     S32 getHitCount() const         { return mHitCount; }
     S32 getCRCChangeCount() const   { return mCRCChangeCount; }
 
-    void calcSceneContribution(const LLVector4a& camera_origin, bool needs_update, U32 last_update, F32 dist_threshold);
+    // <FS> Predictive LOD
+    //void calcSceneContribution(const LLVector4a& camera_origin, bool needs_update, U32 last_update, F32 dist_threshold);
+    void calcSceneContribution(const LLVector4a& camera_origin, bool needs_update, U32 last_update, F32 dist_threshold,
+                               const LLVector4a* predicted_origin = NULL, F32 predicted_weight = 0.f);
+    F32  calcSceneContributionFrom(const LLVector4a& camera_origin, F32 dist_threshold) const;
+    // </FS>
     void setSceneContribution(F32 scene_contrib) {mSceneContrib = scene_contrib;}
     F32 getSceneContribution() const             { return mSceneContrib;}
 
@@ -390,6 +390,7 @@ LLVivoxVoiceClient::~LLVivoxVoiceClient()
         mAvatarNameCacheConnection.disconnect();
     }
     sShuttingDown = true;
+    gIdleCallbacks.deleteFunction(idle, this); // <FS/> idle() flushes participant updates
 }
 
 //---------------------------------------------------
@@ -717,6 +718,13 @@ void LLVivoxVoiceClient::setLoginInfo(
 
 void LLVivoxVoiceClient::idle(void* user_data)
 {
+    // <FS> Apply the participant updates of this frame in one go
+    LLVivoxVoiceClient* self = static_cast<LLVivoxVoiceClient*>(user_data);
+    if (self)
+    {
+        self->flushParticipantUpdates();
+    }
+    // </FS>
 }
 
 //=========================================================================
@@ -4493,79 +4501,109 @@ void LLVivoxVoiceClient::participantUpdatedEvent(
         int volume,
         F32 energy)
 {
-    sessionStatePtr_t session(findSession(sessionHandle));
-    if(session)
+    // <FS> Collect the update, idle() applies everything received during a frame at once
+    mParticipantUpdates.add(sessionHandle, sessionGroupHandle, uriString, alias, isModeratorMuted, isSpeaking, volume, energy);
+
+    static LLCachedControl<bool> batch_updates(gSavedSettings, "FSVivoxBatchParticipantUpdates");
+    if (!batch_updates)
     {
-        participantStatePtr_t participant(session->findParticipant(uriString));
+        flushParticipantUpdates();
+    }
+}
 
-        if(participant)
+void LLVivoxVoiceClient::flushParticipantUpdates()
+{
+    if (mParticipantUpdates.empty())
+    {
+        return;
+    }
+
+    mParticipantUpdates.take(mParticipantUpdateScratch);
+
+    bool updated = false;
+    bool agent_updated = false;
+    for (const FSVivoxParticipantUpdate& update : mParticipantUpdateScratch)
+    {
+        sessionStatePtr_t session(findSession(update.mSessionHandle));
+        if (!session)
         {
-            //LL_INFOS("Voice") << "Participant Update for " << participant->mDisplayName << LL_ENDL;
+            LL_DEBUGS("Voice") << "unknown session " << update.mSessionHandle << LL_ENDL;
+            continue;
+        }
 
-            participant->mIsSpeaking = isSpeaking;
-            participant->mIsModeratorMuted = isModeratorMuted;
+        participantStatePtr_t participant(session->findParticipant(update.mURI));
+        if (!participant)
+        {
+            LL_WARNS("Voice") << "unknown participant: " << update.mURI << LL_ENDL;
+            continue;
+        }
 
-            // SLIM SDK: convert range: ensure that energy is set to zero if is_speaking is false
-            if (isSpeaking)
-            {
-                participant->mSpeakingTimeout.reset();
-                participant->mPower = energy;
-            }
-            else
-            {
-                participant->mPower = 0.0f;
-            }
+        //LL_INFOS("Voice") << "Participant Update for " << participant->mDisplayName << LL_ENDL;
 
-            // Ignore incoming volume level if it has been explicitly set, or there
-            //  is a volume or mute change pending.
-            if ( !participant->mVolumeSet && !participant->mVolumeDirty)
-            {
-                participant->mVolume = (F32)volume * VOLUME_SCALE_VIVOX;
-            }
+        participant->mIsSpeaking = update.mIsSpeaking;
+        participant->mIsModeratorMuted = update.mIsModeratorMuted;
 
-            // *HACK: mantipov: added while working on EXT-3544
-            /*
-             Sometimes LLVoiceClient::participantUpdatedEvent callback is called BEFORE
-             LLViewerChatterBoxSessionAgentListUpdates::post() sometimes AFTER.
+        // SLIM SDK: convert range: ensure that energy is set to zero if is_speaking is false
+        if (update.mSpoke)
+        {
+            participant->mSpeakingTimeout.reset();
+        }
+        participant->mPower = update.mIsSpeaking ? update.mEnergy : 0.0f;
 
-             participantUpdatedEvent updates voice participant state in particular participantState::mIsModeratorMuted
-             Originally we wanted to update session Speaker Manager to fire LLSpeakerVoiceModerationEvent to fix the EXT-3544 bug.
-             Calling of the LLSpeakerMgr::update() method was added into LLIMMgr::processAgentListUpdates.
+        // Ignore incoming volume level if it has been explicitly set, or there
+        //  is a volume or mute change pending.
+        if ( !participant->mVolumeSet && !participant->mVolumeDirty)
+        {
+            participant->mVolume = (F32)update.mVolume * VOLUME_SCALE_VIVOX;
+        }
 
-             But in case participantUpdatedEvent() is called after LLViewerChatterBoxSessionAgentListUpdates::post()
-             voice participant mIsModeratorMuted is changed after speakers are updated in Speaker Manager
-             and event is not fired.
+        updated = true;
+        agent_updated = agent_updated || gAgent.getID() == participant->mAvatarID;
+    }
 
-             So, we have to call LLSpeakerMgr::update() here.
-             */
-            LLVoiceChannel* voice_cnl = LLVoiceChannel::getCurrentVoiceChannel();
+    if (!updated)
+    {
+        return;
+    }
 
-            // ignore session ID of local chat
-            if (voice_cnl && voice_cnl->getSessionID().notNull())
-            {
-                LLSpeakerMgr* speaker_manager = LLIMModel::getInstance()->getSpeakerManager(voice_cnl->getSessionID());
-                if (speaker_manager)
-                {
-                    speaker_manager->update(true);
+    // *HACK: mantipov: added while working on EXT-3544
+    /*
+     Sometimes LLVoiceClient::participantUpdatedEvent callback is called BEFORE
+     LLViewerChatterBoxSessionAgentListUpdates::post() sometimes AFTER.
 
-                    // also initialize voice moderate_mode depend on Agent's participant. See EXT-6937.
-                    // *TODO: remove once a way to request the current voice channel moderation mode is implemented.
-                    if (gAgent.getID() == participant->mAvatarID)
-                    {
-                        speaker_manager->initVoiceModerateMode();
-                    }
-                }
-            }
-        }
-        else
+     participantUpdatedEvent updates voice participant state in particular participantState::mIsModeratorMuted
+     Originally we wanted to update session Speaker Manager to fire LLSpeakerVoiceModerationEvent to fix the EXT-3544 bug.
+     Calling of the LLSpeakerMgr::update() method was added into LLIMMgr::processAgentListUpdates.
+
+     But in case participantUpdatedEvent() is called after LLViewerChatterBoxSessionAgentListUpdates::post()
+     voice participant mIsModeratorMuted is changed after speakers are updated in Speaker Manager
+     and event is not fired.
+
+     So, we have to call LLSpeakerMgr::update() here. Once per batch is enough.
+     */
+    LLVoiceChannel* voice_cnl = LLVoiceChannel::getCurrentVoiceChannel();
+
+    // ignore session ID of local chat
+    if (voice_cnl && voice_cnl->getSessionID().notNull())
+    {
+        LLSpeakerMgr* speaker_manager = LLIMModel::getInstance()->getSpeakerManager(voice_cnl->getSessionID());
+        if (speaker_manager)
         {
-            LL_WARNS("Voice") << "unknown participant: " << uriString << LL_ENDL;
+            speaker_manager->update(true);
+
+            // also initialize voice moderate_mode depend on Agent's participant. See EXT-6937.
+            // *TODO: remove once a way to request the current voice channel moderation mode is implemented.
+            if (agent_updated)
+            {
+                speaker_manager->initVoiceModerateMode();
+            }
         }
     }
-    else
-    {
-        LL_DEBUGS("Voice") << "unknown session " << sessionHandle << LL_ENDL;
-    }
+
+    LL_DEBUGS("Voice") << "Applied " << mParticipantUpdateScratch.size() << " participant updates, "
+                       << mParticipantUpdates.getReceivedCount() << " received and "
+                       << mParticipantUpdates.getAppliedCount() << " applied in total" << LL_ENDL;
+    // </FS>
 }
 
 void LLVivoxVoiceClient::messageEvent(
@@ -7510,6 +7548,7 @@ void LLVivoxProtocolParser::reset()
     incoming = false;
     enabled = false;
     isEvent = false;
+    eventType = FSVN_UNKNOWN; // <FS/> Interned event type
     isLocallyMuted = false;
     isModeratorMuted = false;
     isSpeaking = false;
@@ -7552,9 +7591,14 @@ LLIOPipe::EStatus LLVivoxProtocolParser::process_impl(
     }
 
     // Look for input delimiter(s) in the input buffer.  If one is found, send the message to the xml parser.
-    int start = 0;
-    int delim;
-    while((delim = mInput.find("\n\n\n", start)) != std::string::npos)
+    // <FS> Parse messages in place and drop them from the buffer once per read
+    //int start = 0;
+    //int delim;
+    //while((delim = mInput.find("\n\n\n", start)) != std::string::npos)
+    const char* message = NULL;
+    size_t length = 0;
+    while (mInput.nextMessage(message, length))
+    // </FS>
     {
 
         // Reset internal state of the LLVivoxProtocolParser (no effect on the expat parser)
@@ -7564,16 +7608,26 @@ LLIOPipe::EStatus LLVivoxProtocolParser::process_impl(
         XML_SetElementHandler(parser, ExpatStartTag, ExpatEndTag);
         XML_SetCharacterDataHandler(parser, ExpatCharHandler);
         XML_SetUserData(parser, this);
-        XML_Parse(parser, mInput.data() + start, delim - start, false);
+        // <FS>
+        //XML_Parse(parser, mInput.data() + start, delim - start, false);
+        //
+        //LL_DEBUGS("VivoxProtocolParser") << "parsing: " << mInput.substr(start, delim - start) << LL_ENDL;
+        //start = delim + 3;
+        XML_Parse(parser, message, (int)length, false);
 
-        LL_DEBUGS("VivoxProtocolParser") << "parsing: " << mInput.substr(start, delim - start) << LL_ENDL;
-        start = delim + 3;
+        LL_DEBUGS("VivoxProtocolParser") << "parsing: " << std::string(message, length) << LL_ENDL;
+        // </FS>
     }
 
-    if(start != 0)
-        mInput = mInput.substr(start);
+    // <FS>
+    //if(start != 0)
+    //    mInput = mInput.substr(start);
+    //
+    //LL_DEBUGS("VivoxProtocolParser") << "at end, mInput is: " << mInput << LL_ENDL;
+    mInput.compact();
 
-    LL_DEBUGS("VivoxProtocolParser") << "at end, mInput is: " << mInput << LL_ENDL;
+    LL_DEBUGS("VivoxProtocolParser") << "at end, mInput is: " << mInput.getBuffer() << LL_ENDL;
+    // </FS>
 
     if(!LLVivoxVoiceClient::sConnected)
     {
@@ -7626,11 +7680,15 @@ void LLVivoxProtocolParser::StartTag(const char *tag, const char **attr)
     // only accumulate text if we're not ignoring tags.
     accumulateText = !ignoringTags;
 
+    // <FS> Switch on interned names instead of comparing against every known tag
+    const EFSVivoxName name = fs_vivox_name(tag);
+    // </FS>
+
     if (responseDepth == 0)
     {
-        isEvent = !stricmp("Event", tag);
+        isEvent = (name == FSVN_EVENT);
 
-        if (!stricmp("Response", tag) || isEvent)
+        if (name == FSVN_RESPONSE || isEvent)
         {
             // Grab the attributes
             while (*attr)
@@ -7638,17 +7696,20 @@ void LLVivoxProtocolParser::StartTag(const char *tag, const char **attr)
                 const char  *key = *attr++;
                 const char  *value = *attr++;
 
-                if (!stricmp("requestId", key))
-                {
-                    requestId = value;
-                }
-                else if (!stricmp("action", key))
-                {
-                    actionString = value;
-                }
-                else if (!stricmp("type", key))
+                switch (fs_vivox_name(key))
                 {
-                    eventTypeString = value;
+                    case FSVN_REQUESTID:
+                        requestId = value;
+                        break;
+                    case FSVN_ACTION:
+                        actionString = value;
+                        break;
+                    case FSVN_TYPE:
+                        eventTypeString = value;
+                        eventType = fs_vivox_name(value);
+                        break;
+                    default:
+                        break;
                 }
             }
         }
@@ -7664,54 +7725,41 @@ void LLVivoxProtocolParser::StartTag(const char *tag, const char **attr)
         {
             LL_DEBUGS("VivoxProtocolParser") << tag << " (" << responseDepth << ")"  << LL_ENDL;
 
-            // Ignore the InputXml stuff so we don't get confused
-            if (!stricmp("InputXml", tag))
+            switch (name)
             {
-                ignoringTags = true;
-                ignoreDepth = responseDepth;
-                accumulateText = false;
+                case FSVN_INPUTXML:
+                    // Ignore the InputXml stuff so we don't get confused
+                    ignoringTags = true;
+                    ignoreDepth = responseDepth;
+                    accumulateText = false;
 
-                LL_DEBUGS("VivoxProtocolParser") << "starting ignore, ignoreDepth is " << ignoreDepth << LL_ENDL;
-            }
-            else if (!stricmp("CaptureDevices", tag))
-            {
-                LLVivoxVoiceClient::getInstance()->clearCaptureDevices();
-            }
-            else if (!stricmp("RenderDevices", tag))
-            {
-                LLVivoxVoiceClient::getInstance()->clearRenderDevices();
-            }
-            else if (!stricmp("CaptureDevice", tag))
-            {
-                deviceString.clear();
-            }
-            else if (!stricmp("RenderDevice", tag))
-            {
-                deviceString.clear();
-            }
-            else if (!stricmp("SessionFont", tag))
-            {
-                id = 0;
-                nameString.clear();
-                descriptionString.clear();
-                expirationDate = LLDate();
-                hasExpired = false;
-                fontType = 0;
-                fontStatus = 0;
-            }
-            else if (!stricmp("TemplateFont", tag))
-            {
-                id = 0;
-                nameString.clear();
-                descriptionString.clear();
-                expirationDate = LLDate();
-                hasExpired = false;
-                fontType = 0;
-                fontStatus = 0;
-            }
-            else if (!stricmp("MediaCompletionType", tag))
-            {
-                mediaCompletionType.clear();
+                    LL_DEBUGS("VivoxProtocolParser") << "starting ignore, ignoreDepth is " << ignoreDepth << LL_ENDL;
+                    break;
+                case FSVN_CAPTUREDEVICES:
+                    LLVivoxVoiceClient::getInstance()->clearCaptureDevices();
+                    break;
+                case FSVN_RENDERDEVICES:
+                    LLVivoxVoiceClient::getInstance()->clearRenderDevices();
+                    break;
+                case FSVN_CAPTUREDEVICE:
+                case FSVN_RENDERDEVICE:
+                    deviceString.clear();
+                    break;
+                case FSVN_SESSIONFONT:
+                case FSVN_TEMPLATEFONT:
+                    id = 0;
+                    nameString.clear();
+                    descriptionString.clear();
+                    expirationDate = LLDate();
+                    hasExpired = false;
+                    fontType = 0;
+                    fontStatus = 0;
+                    break;
+                case FSVN_MEDIACOMPLETIONTYPE:
+                    mediaCompletionType.clear();
+                    break;
+                default:
+                    break;
             }
         }
     }
@@ -7744,154 +7792,177 @@ void LLVivoxProtocolParser::EndTag(const char *tag)
         LL_DEBUGS("VivoxProtocolParser") << "processing tag " << tag << " (depth = " << responseDepth << ")" << LL_ENDL;
 
         // Closing a tag. Finalize the text we've accumulated and reset
-        if (!stricmp("ReturnCode", tag))
-            returnCode = strtol(string.c_str(), NULL, 10);
-        else if (!stricmp("SessionHandle", tag))
-            sessionHandle = string;
-        else if (!stricmp("SessionGroupHandle", tag))
-            sessionGroupHandle = string;
-        else if (!stricmp("StatusCode", tag))
-            statusCode = strtol(string.c_str(), NULL, 10);
-        else if (!stricmp("StatusString", tag))
-            statusString = string;
-        else if (!stricmp("ParticipantURI", tag))
-            uriString = string;
-        else if (!stricmp("Volume", tag))
-            volume = strtol(string.c_str(), NULL, 10);
-        else if (!stricmp("Energy", tag))
-            energy = (F32)strtod(string.c_str(), NULL);
-        else if (!stricmp("IsModeratorMuted", tag))
-            isModeratorMuted = !stricmp(string.c_str(), "true");
-        else if (!stricmp("IsSpeaking", tag))
-            isSpeaking = !stricmp(string.c_str(), "true");
-        else if (!stricmp("Alias", tag))
-            alias = string;
-        else if (!stricmp("NumberOfAliases", tag))
-            numberOfAliases = strtol(string.c_str(), NULL, 10);
-        else if (!stricmp("Application", tag))
-            applicationString = string;
-        else if (!stricmp("ConnectorHandle", tag))
-            connectorHandle = string;
-        else if (!stricmp("VersionID", tag))
-            versionID = string;
-        else if (!stricmp("Version", tag))
-            mBuildID = string;
-        else if (!stricmp("AccountHandle", tag))
-            accountHandle = string;
-        else if (!stricmp("State", tag))
-            state = strtol(string.c_str(), NULL, 10);
-        else if (!stricmp("URI", tag))
-            uriString = string;
-        else if (!stricmp("IsChannel", tag))
-            isChannel = !stricmp(string.c_str(), "true");
-        else if (!stricmp("Incoming", tag))
-            incoming = !stricmp(string.c_str(), "true");
-        else if (!stricmp("Enabled", tag))
-            enabled = !stricmp(string.c_str(), "true");
-        else if (!stricmp("Name", tag))
-            nameString = string;
-        else if (!stricmp("AudioMedia", tag))
-            audioMediaString = string;
-        else if (!stricmp("ChannelName", tag))
-            nameString = string;
-        else if (!stricmp("DisplayName", tag))
-            displayNameString = string;
-        else if (!stricmp("Device", tag))
-            deviceString = string;
-        else if (!stricmp("AccountName", tag))
-            nameString = string;
-        else if (!stricmp("ParticipantType", tag))
-            participantType = strtol(string.c_str(), NULL, 10);
-        else if (!stricmp("IsLocallyMuted", tag))
-            isLocallyMuted = !stricmp(string.c_str(), "true");
-        else if (!stricmp("MicEnergy", tag))
-            energy = (F32)strtod(string.c_str(), NULL);
-        else if (!stricmp("ChannelName", tag))
-            nameString = string;
-        else if (!stricmp("ChannelURI", tag))
-            uriString = string;
-        else if (!stricmp("BuddyURI", tag))
-            uriString = string;
-        else if (!stricmp("Presence", tag))
-            statusString = string;
-        else if (!stricmp("CaptureDevices", tag))
-        {
-            LLVivoxVoiceClient::getInstance()->setDevicesListUpdated(true);
-        }
-        else if (!stricmp("RenderDevices", tag))
-        {
-            LLVivoxVoiceClient::getInstance()->setDevicesListUpdated(true);
-        }
-        else if (!stricmp("CaptureDevice", tag))
-        {
-            LLVivoxVoiceClient::getInstance()->addCaptureDevice(LLVoiceDevice(displayNameString, deviceString));
-        }
-        else if (!stricmp("RenderDevice", tag))
-        {
-            LLVivoxVoiceClient::getInstance()->addRenderDevice(LLVoiceDevice(displayNameString, deviceString));
-        }
-        else if (!stricmp("BlockMask", tag))
-            blockMask = string;
-        else if (!stricmp("PresenceOnly", tag))
-            presenceOnly = string;
-        else if (!stricmp("AutoAcceptMask", tag))
-            autoAcceptMask = string;
-        else if (!stricmp("AutoAddAsBuddy", tag))
-            autoAddAsBuddy = string;
-        else if (!stricmp("MessageHeader", tag))
-            messageHeader = string;
-        else if (!stricmp("MessageBody", tag))
-            messageBody = string;
-        else if (!stricmp("NotificationType", tag))
-            notificationType = string;
-        else if (!stricmp("HasText", tag))
-            hasText = !stricmp(string.c_str(), "true");
-        else if (!stricmp("HasAudio", tag))
-            hasAudio = !stricmp(string.c_str(), "true");
-        else if (!stricmp("HasVideo", tag))
-            hasVideo = !stricmp(string.c_str(), "true");
-        else if (!stricmp("Terminated", tag))
-            terminated = !stricmp(string.c_str(), "true");
-        else if (!stricmp("SubscriptionHandle", tag))
-            subscriptionHandle = string;
-        else if (!stricmp("SubscriptionType", tag))
-            subscriptionType = string;
-        else if (!stricmp("SessionFont", tag))
-        {
-            LLVivoxVoiceClient::getInstance()->addVoiceFont(id, nameString, descriptionString, expirationDate, hasExpired, fontType, fontStatus, false);
-        }
-        else if (!stricmp("TemplateFont", tag))
-        {
-            LLVivoxVoiceClient::getInstance()->addVoiceFont(id, nameString, descriptionString, expirationDate, hasExpired, fontType, fontStatus, true);
-        }
-        else if (!stricmp("ID", tag))
-        {
-            id = strtol(string.c_str(), NULL, 10);
-        }
-        else if (!stricmp("Description", tag))
-        {
-            descriptionString = string;
-        }
-        else if (!stricmp("ExpirationDate", tag))
-        {
-            expirationDate = expiryTimeStampToLLDate(string);
-        }
-        else if (!stricmp("Expired", tag))
-        {
-            hasExpired = !stricmp(string.c_str(), "1");
-        }
-        else if (!stricmp("Type", tag))
-        {
-            fontType = strtol(string.c_str(), NULL, 10);
-        }
-        else if (!stricmp("Status", tag))
+        // <FS> Switch on interned names instead of comparing against every known tag
+        switch (fs_vivox_name(tag))
         {
-            fontStatus = strtol(string.c_str(), NULL, 10);
-        }
-        else if (!stricmp("MediaCompletionType", tag))
-        {
-            mediaCompletionType = string;;
+            case FSVN_RETURNCODE:
+                returnCode = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_SESSIONHANDLE:
+                sessionHandle = string;
+                break;
+            case FSVN_SESSIONGROUPHANDLE:
+                sessionGroupHandle = string;
+                break;
+            case FSVN_STATUSCODE:
+                statusCode = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_STATUSSTRING:
+            case FSVN_PRESENCE:
+                statusString = string;
+                break;
+            case FSVN_PARTICIPANTURI:
+            case FSVN_URI:
+            case FSVN_CHANNELURI:
+            case FSVN_BUDDYURI:
+                uriString = string;
+                break;
+            case FSVN_VOLUME:
+                volume = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_ENERGY:
+            case FSVN_MICENERGY:
+                energy = (F32)strtod(string.c_str(), NULL);
+                break;
+            case FSVN_ISMODERATORMUTED:
+                isModeratorMuted = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_ISSPEAKING:
+                isSpeaking = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_ALIAS:
+                alias = string;
+                break;
+            case FSVN_NUMBEROFALIASES:
+                numberOfAliases = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_APPLICATION:
+                applicationString = string;
+                break;
+            case FSVN_CONNECTORHANDLE:
+                connectorHandle = string;
+                break;
+            case FSVN_VERSIONID:
+                versionID = string;
+                break;
+            case FSVN_VERSION:
+                mBuildID = string;
+                break;
+            case FSVN_ACCOUNTHANDLE:
+                accountHandle = string;
+                break;
+            case FSVN_STATE:
+                state = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_ISCHANNEL:
+                isChannel = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_INCOMING:
+                incoming = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_ENABLED:
+                enabled = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_NAME:
+            case FSVN_CHANNELNAME:
+            case FSVN_ACCOUNTNAME:
+                nameString = string;
+                break;
+            case FSVN_AUDIOMEDIA:
+                audioMediaString = string;
+                break;
+            case FSVN_DISPLAYNAME:
+                displayNameString = string;
+                break;
+            case FSVN_DEVICE:
+                deviceString = string;
+                break;
+            case FSVN_PARTICIPANTTYPE:
+                participantType = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_ISLOCALLYMUTED:
+                isLocallyMuted = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_CAPTUREDEVICES:
+            case FSVN_RENDERDEVICES:
+                LLVivoxVoiceClient::getInstance()->setDevicesListUpdated(true);
+                break;
+            case FSVN_CAPTUREDEVICE:
+                LLVivoxVoiceClient::getInstance()->addCaptureDevice(LLVoiceDevice(displayNameString, deviceString));
+                break;
+            case FSVN_RENDERDEVICE:
+                LLVivoxVoiceClient::getInstance()->addRenderDevice(LLVoiceDevice(displayNameString, deviceString));
+                break;
+            case FSVN_BLOCKMASK:
+                blockMask = string;
+                break;
+            case FSVN_PRESENCEONLY:
+                presenceOnly = string;
+                break;
+            case FSVN_AUTOACCEPTMASK:
+                autoAcceptMask = string;
+                break;
+            case FSVN_AUTOADDASBUDDY:
+                autoAddAsBuddy = string;
+                break;
+            case FSVN_MESSAGEHEADER:
+                messageHeader = string;
+                break;
+            case FSVN_MESSAGEBODY:
+                messageBody = string;
+                break;
+            case FSVN_NOTIFICATIONTYPE:
+                notificationType = string;
+                break;
+            case FSVN_HASTEXT:
+                hasText = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_HASAUDIO:
+                hasAudio = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_HASVIDEO:
+                hasVideo = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_TERMINATED:
+                terminated = !stricmp(string.c_str(), "true");
+                break;
+            case FSVN_SUBSCRIPTIONHANDLE:
+                subscriptionHandle = string;
+                break;
+            case FSVN_SUBSCRIPTIONTYPE:
+                subscriptionType = string;
+                break;
+            case FSVN_SESSIONFONT:
+                LLVivoxVoiceClient::getInstance()->addVoiceFont(id, nameString, descriptionString, expirationDate, hasExpired, fontType, fontStatus, false);
+                break;
+            case FSVN_TEMPLATEFONT:
+                LLVivoxVoiceClient::getInstance()->addVoiceFont(id, nameString, descriptionString, expirationDate, hasExpired, fontType, fontStatus, true);
+                break;
+            case FSVN_ID:
+                id = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_DESCRIPTION:
+                descriptionString = string;
+                break;
+            case FSVN_EXPIRATIONDATE:
+                expirationDate = expiryTimeStampToLLDate(string);
+                break;
+            case FSVN_EXPIRED:
+                hasExpired = !stricmp(string.c_str(), "1");
+                break;
+            case FSVN_TYPE:
+                fontType = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_STATUS:
+                fontStatus = strtol(string.c_str(), NULL, 10);
+                break;
+            case FSVN_MEDIACOMPLETIONTYPE:
+                mediaCompletionType = string;
+                break;
+            default:
+                break;
         }
+        // </FS>
 
         textBuffer.clear();
         accumulateText= false;
@@ -7947,12 +8018,23 @@ void LLVivoxProtocolParser::processResponse(std::string tag)
     if(returnCode == 0)
         statusCode = 0;
 
+    // <FS> Participant updates are applied once per frame; anything else must
+    // see the participants as of the updates that arrived before it
+    if (!isEvent || eventType != FSVN_PARTICIPANTUPDATEDEVENT)
+    {
+        LLVivoxVoiceClient::getInstance()->flushParticipantUpdates();
+    }
+    // </FS>
+
     if (isEvent)
     {
         const char *eventTypeCstr = eventTypeString.c_str();
         LL_DEBUGS("LowVoice") << eventTypeCstr << LL_ENDL;
 
-        if (!stricmp(eventTypeCstr, "ParticipantUpdatedEvent"))
+        // <FS> Interned event type for the most frequent event
+        //if (!stricmp(eventTypeCstr, "ParticipantUpdatedEvent"))
+        if (eventType == FSVN_PARTICIPANTUPDATEDEVENT)
+        // </FS>
         {
             // These happen so often that logging them is pretty useless.
             LL_DEBUGS("LowVoice") << "Updated Params: " << sessionHandle << ", " << sessionGroupHandle << ", " << uriString << ", " << alias << ", " << isModeratorMuted << ", " << isSpeaking << ", " << volume << ", " << energy << LL_ENDL;
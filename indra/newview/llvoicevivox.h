@@ -47,6 +47,7 @@ class LLVivoxProtocolParser;
 # include "expat/expat.h"
 #endif
 #include "llvoiceclient.h"
+#include "fsvivoxprotocol.h" // <FS/> SLVoice message framing and update batching
 
 class LLAvatarName;
 class LLVivoxVoiceClientMuteListObserver;
@@ -473,6 +474,9 @@ protected:
     void participantAddedEvent(std::string &sessionHandle, std::string &sessionGroupHandle, std::string &uriString, std::string &alias, std::string &nameString, std::string &displayNameString, int participantType);
     void participantRemovedEvent(std::string &sessionHandle, std::string &sessionGroupHandle, std::string &uriString, std::string &alias, std::string &nameString);
     void participantUpdatedEvent(std::string &sessionHandle, std::string &sessionGroupHandle, std::string &uriString, std::string &alias, bool isModeratorMuted, bool isSpeaking, int volume, F32 energy);
+    // <FS> Apply participant updates once per frame
+    void flushParticipantUpdates();
+    // </FS>
     void voiceServiceConnectionStateChangedEvent(int statusCode, std::string &statusString, std::string &build_id);
     void auxAudioPropertiesEvent(F32 energy);
     void messageEvent(std::string &sessionHandle, std::string &uriString, std::string &alias, std::string &messageHeader, std::string &messageBody, std::string &applicationString);
@@ -674,6 +678,11 @@ private:
 
     static void idle(void *user_data);
 
+    // <FS> Participant updates collected since the last frame
+    FSVivoxParticipantUpdates mParticipantUpdates;
+    std::vector<FSVivoxParticipantUpdate> mParticipantUpdateScratch;
+    // </FS>
+
     LLHost mDaemonHost;
     LLSocket::ptr_t mSocket;
 
@@ -966,7 +975,10 @@ protected:
                                  LLPumpIO* pump);
     //@}
 
-    std::string     mInput;
+    // <FS> Frame messages in place instead of copying the remainder per message
+    //std::string     mInput;
+    FSVivoxMessageStream mInput;
+    // </FS>
 
     // Expat control members
     XML_Parser      parser;
@@ -992,6 +1004,7 @@ protected:
 
     // Members for processing events. The values are transient and only valid within a call to processResponse().
     std::string     eventTypeString;
+    EFSVivoxName    eventType; // <FS/> Interned event type
     int             state;
     std::string     uriString;
     bool            isChannel;
@@ -94,6 +94,7 @@
 #include "rlvlocks.h"
 // [/RLVa:KB]
 #include "llviewernetwork.h"
+#include "fscamerapredictor.h" // <FS> Predictive LOD
 
 const F32 FORCE_SIMPLE_RENDER_AREA = 512.f;
 const F32 FORCE_CULL_AREA = 8.f;
@@ -1618,6 +1619,14 @@ BOOL LLVOVolume::calcLOD()
     mLODDistance = distance;
     mLODRadius = radius;
 
+    // <FS> Predictive LOD: also consider where a moving camera is heading
+    if (gCameraPredictor.isActive())
+    {
+        LLDrawable* lod_drawable = mDrawable->isState(LLDrawable::RIGGED) ? getAvatar()->mDrawable.get() : mDrawable.get();
+        distance = gCameraPredictor.getBlendedDistance(lod_drawable->getPositionAgent(), distance);
+    }
+    // </FS>
+
     static LLCachedControl<bool> debug_lods(gSavedSettings, "DebugObjectLODs", false);
     if (debug_lods)
     {
@@ -272,7 +272,11 @@ public:
 
     // World Mipmap delegation: currently used when drawing the mipmap
     void    equalizeBoostLevels();
-    LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true) { return mWorldMipmap.getObjectsTile(grid_x, grid_y, level, load); }
+    // <FS> tile load priority and queue
+    //LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true) { return mWorldMipmap.getObjectsTile(grid_x, grid_y, level, load); }
+    LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true, F32 priority = 0.f) { return mWorldMipmap.getObjectsTile(grid_x, grid_y, level, load, priority); }
+    bool    isObjectsTileQueued(U32 grid_x, U32 grid_y, S32 level) const { return mWorldMipmap.isObjectsTileQueued(grid_x, grid_y, level); }
+    // </FS>
 
 private:
     bool clearItems(bool force = false);    // Clears the item lists
@@ -813,6 +813,10 @@ bool LLWorldMapView::drawMipmapLevel(S32 width, S32 height, S32 level, bool load
     // Dimension of the screen in meter at that scale
     LLVector3d pos_SW = viewPosToGlobal(0, 0);
     LLVector3d pos_NE = viewPosToGlobal(width, height);
+    // <FS> Tiles nearest to the middle of the view load first
+    const F64 center_x = (pos_SW[VX] + pos_NE[VX]) * 0.5;
+    const F64 center_y = (pos_SW[VY] + pos_NE[VY]) * 0.5;
+    // </FS>
     // Add external band of tiles on the outskirt so to hit the partially displayed tiles right and top
     pos_NE[VX] += tile_width;
     pos_NE[VY] += tile_width;
@@ -831,7 +835,12 @@ bool LLWorldMapView::drawMipmapLevel(S32 width, S32 height, S32 level, bool load
             // Get the tile. Note: NULL means that the image does not exist (so it's considered "complete" as far as fetching is concerned)
             // <FS:Ansariel> Performance tweak
             //LLPointer<LLViewerFetchedTexture> simimage = LLWorldMap::getInstance()->getObjectsTile(grid_x, grid_y, level, load);
-            LLPointer<LLViewerFetchedTexture> simimage = world_map->getObjectsTile(grid_x, grid_y, level, load);
+            // <FS> Load priority is the squared distance from the middle of the view in tiles
+            //LLPointer<LLViewerFetchedTexture> simimage = world_map->getObjectsTile(grid_x, grid_y, level, load);
+            F32 tiles_x = (F32)((grid_x * REGION_WIDTH_METERS + tile_width * 0.5 - center_x) / tile_width);
+            F32 tiles_y = (F32)((grid_y * REGION_WIDTH_METERS + tile_width * 0.5 - center_y) / tile_width);
+            LLPointer<LLViewerFetchedTexture> simimage = world_map->getObjectsTile(grid_x, grid_y, level, load, tiles_x * tiles_x + tiles_y * tiles_y);
+            // </FS>
             // </FS:Ansariel>
             if (simimage)
             {
@@ -901,7 +910,10 @@ bool LLWorldMapView::drawMipmapLevel(S32 width, S32 height, S32 level, bool load
                 //  LL_INFOS("WorldMap") << "Unfetched tile. level = " << level << LL_ENDL;
                 //}
             }
-            else
+            // <FS> Tiles still waiting for their turn to load are not complete
+            //else
+            else if (!load || !world_map->isObjectsTileQueued(grid_x, grid_y, level))
+            // </FS>
             {
                 // Unexistent tiles are counted as "completed"
                 completed_tiles++;
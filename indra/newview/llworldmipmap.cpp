@@ -43,8 +43,26 @@
 // Turn this on to output tile stats in the standard output
 #define DEBUG_TILES_STAT 0
 
+// <FS> Levels above a queued tile whose tile is loaded first as a placeholder
+static const S32 PLACEHOLDER_LEVELS = 2;
+
+// Decoded size of a tile, for the tile memory budget
+static U32 tile_bytes(const LLViewerFetchedTexture* img)
+{
+    if (img->isMissingAsset())
+    {
+        return 0;
+    }
+    S32 width = img->getFullWidth() > 0 ? img->getFullWidth() : LLWorldMipmap::MAP_TILE_SIZE;
+    S32 height = img->getFullHeight() > 0 ? img->getFullHeight() : LLWorldMipmap::MAP_TILE_SIZE;
+    S32 components = img->getComponents() > 0 ? img->getComponents() : 3;
+    return (U32)(width * height * components);
+}
+// </FS>
+
 LLWorldMipmap::LLWorldMipmap() :
-    mCurrentLevel(0)
+    mCurrentLevel(0),
+    mTileCache(MAP_LEVELS) // <FS/>
 {
 }
 
@@ -60,6 +78,7 @@ void LLWorldMipmap::reset()
     {
         mWorldObjectsMipMap[level].clear();
     }
+    mTileCache.clear(); // <FS/>
 }
 
 // This method should be called before each use of the mipmap (typically, before each draw), so that to let
@@ -93,6 +112,12 @@ void LLWorldMipmap::equalizeBoostLevels()
                 // so we drop its boost level to BOOST_NONE.
                 img->setBoostLevel(LLGLTexture::BOOST_NONE);
             }
+            // <FS> Finished loads free their slot and count towards the memory budget
+            if ((img->hasGLTexture() || img->isMissingAsset()) && mTileCache.isLoading(level + 1, iter->first))
+            {
+                mTileCache.setLoaded(level + 1, iter->first, tile_bytes(img.get()));
+            }
+            // </FS>
 #if DEBUG_TILES_STAT
             // Increment some stats if compile option on
             nb_tiles++;
@@ -110,8 +135,41 @@ void LLWorldMipmap::equalizeBoostLevels()
 #if DEBUG_TILES_STAT
     LL_INFOS("WorldMap") << "LLWorldMipmap tile stats : total requested = " << nb_tiles << ", visible = " << nb_visible << ", missing = " << nb_missing << LL_ENDL;
 #endif // DEBUG_TILES_STAT
+    updateTileCache(); // <FS/>
+}
+
+// <FS>
+void LLWorldMipmap::updateTileCache()
+{
+    static LLCachedControl<U32> cache_size(gSavedSettings, "FSWorldMapTileCacheMB");
+    static LLCachedControl<U32> max_in_flight(gSavedSettings, "FSWorldMapTileMaxInFlight");
+    mTileCache.setBudget(llmin((U32)cache_size, 4095U) * 1024 * 1024, max_in_flight);
+
+    // Released tiles go back to the texture list, which lets go of them once unused
+    mTileCache.evict(mTileKeys);
+    for (std::vector<FSWorldMapTileCache::TileKey>::const_iterator it = mTileKeys.begin(); it != mTileKeys.end(); ++it)
+    {
+        mWorldObjectsMipMap[it->mLevel - 1].erase(it->mHandle);
+    }
+
+    mTileCache.takeRequests(mTileKeys);
+    for (std::vector<FSWorldMapTileCache::TileKey>::const_iterator it = mTileKeys.begin(); it != mTileKeys.end(); ++it)
+    {
+        U32 global_x, global_y;
+        from_region_handle(it->mHandle, &global_x, &global_y);
+        LLPointer<LLViewerFetchedTexture> img = loadObjectsTile(global_x / REGION_WIDTH_UNITS, global_y / REGION_WIDTH_UNITS, it->mLevel);
+        mWorldObjectsMipMap[it->mLevel - 1][it->mHandle] = img;
+    }
+
+    mTileCache.beginFrame();
 }
 
+bool LLWorldMipmap::isObjectsTileQueued(U32 grid_x, U32 grid_y, S32 level) const
+{
+    return mTileCache.isWanted(level, to_region_handle(grid_x * REGION_WIDTH_UNITS, grid_y * REGION_WIDTH_UNITS));
+}
+// </FS>
+
 // This method should be used when the mipmap is not actively used for a while, e.g., the map UI is hidden
 void LLWorldMipmap::dropBoostLevels()
 {
@@ -126,9 +184,19 @@ void LLWorldMipmap::dropBoostLevels()
             img->setBoostLevel(LLGLTexture::BOOST_NONE);
         }
     }
+
+    // <FS>
+    LL_INFOS("WorldMap") << "Map tiles: " << mTileCache.getTileCount() << " held, " << (mTileCache.getResidentBytes() / 1024) << " KB decoded, "
+        << "hit rate " << (S32)(mTileCache.getHitRate() * 100.f) << "% of " << mTileCache.getLookupCount() << " lookups, "
+        << mTileCache.getRequestCount() << " requested, " << (mTileCache.getLoadedBytes() / 1024) << " KB loaded, "
+        << mTileCache.getEvictionCount() << " evicted" << LL_ENDL;
+    // </FS>
 }
 
-LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load)
+// <FS> priority
+//LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load)
+LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load, F32 priority)
+// </FS>
 {
     // Check the input data
     llassert(level <= MAP_LEVELS);
@@ -154,10 +222,32 @@ LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32
     {
         if (load)
         {
+            // <FS> With a bounded number of loads, queue the tile and load it once it's its turn
+            if (mTileCache.isBounded())
+            {
+                mTileCache.want(level, handle, priority);
+
+                // A coarser tile covers this one while it loads
+                S32 placeholder_level = llmin(level + PLACEHOLDER_LEVELS, MAP_LEVELS);
+                if (placeholder_level != level)
+                {
+                    U32 regions_in_tile = 1 << (placeholder_level - 1);
+                    U64 placeholder = convertGridToHandle(grid_x - (grid_x % regions_in_tile), grid_y - (grid_y % regions_in_tile));
+                    const sublevel_tiles_t& placeholder_mipmap = mWorldObjectsMipMap[placeholder_level - 1];
+                    if (placeholder_mipmap.find(placeholder) == placeholder_mipmap.end())
+                    {
+                        mTileCache.want(placeholder_level, placeholder, priority);
+                    }
+                }
+                return NULL;
+            }
+            // </FS>
+
             // Load it
             LLPointer<LLViewerFetchedTexture> img = loadObjectsTile(grid_x, grid_y, level);
             // Insert the image in the map
             level_mipmap.insert(sublevel_tiles_t::value_type( handle, img ));
+            mTileCache.addTile(level, handle); // <FS/>
             // Find the element again in the map (it's there now...)
             found = level_mipmap.find(handle);
         }
@@ -167,6 +257,12 @@ LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32
             return NULL;
         }
     }
+    // <FS> Mark the tile as used this frame
+    else
+    {
+        mTileCache.touch(level, handle);
+    }
+    // </FS>
 
     // Get the image pointer and check if this asset is missing
     LLPointer<LLViewerFetchedTexture> img = found->second;
@@ -234,6 +330,7 @@ void LLWorldMipmap::cleanMissedTilesFromLevel(S32 level)
         LLPointer<LLViewerFetchedTexture> img = it->second;
         if (img->isMissingAsset())
         {
+            mTileCache.remove(level, it->first); // <FS/>
             level_mipmap.erase(it++);
         }
         else
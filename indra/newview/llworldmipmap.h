@@ -33,6 +33,8 @@
 #include "indra_constants.h"    // REGION_WIDTH_UNITS
 #include "llregionhandle.h"     // to_region_handle()
 
+#include "fsworldmaptilecache.h"    // <FS/> tile request budget and LRU
+
 class LLViewerFetchedTexture;
 
 // LLWorldMipmap : Mipmap handling of all the tiles used to render the world at any resolution.
@@ -66,7 +68,13 @@ public:
     // Drop the boost levels to none (used when hiding the map)
     void    dropBoostLevels();
     // Get the tile smart pointer, does the loading if necessary
-    LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true);
+    // <FS> tiles to load are queued by priority (lower loads first) and may return NULL until their turn
+    //LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true);
+    LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true, F32 priority = 0.f);
+    // True if the tile is waiting for its turn to load
+    bool    isObjectsTileQueued(U32 grid_x, U32 grid_y, S32 level) const;
+    const FSWorldMapTileCache& getTileCache() const { return mTileCache; }
+    // </FS>
 
     // Helper functions: those are here as they depend solely on the topology of the mipmap though they don't access it
     // Convert sim scale (given in sim width in display pixels) into a mipmap level
@@ -81,6 +89,8 @@ private:
     LLPointer<LLViewerFetchedTexture> loadObjectsTile(U32 grid_x, U32 grid_y, S32 level);
     // Clear a level from its "missing" tiles
     void cleanMissedTilesFromLevel(S32 level);
+    // <FS> Drop tiles over budget and start the queued loads
+    void updateTileCache();
 
     // The mipmap is organized by resolution level (MAP_LEVELS of them). Each resolution level is an std::map
     // using a region_handle as a key and storing a smart pointer to the image as a value.
@@ -89,6 +99,11 @@ private:
 //  sublevel_tiles_t mWorldTerrainMipMap[MAP_LEVELS];
 
     S32 mCurrentLevel;      // The level last accessed by a getObjectsTile()
+
+    // <FS> Which tiles to load and which to let go
+    FSWorldMapTileCache mTileCache;
+    std::vector<FSWorldMapTileCache::TileKey> mTileKeys;
+    // </FS>
 };
 
 #endif // LL_LLWORLDMIPMAP_H
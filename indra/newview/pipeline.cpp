@@ -122,6 +122,7 @@
 
 #include "llenvironment.h"
 #include "llsettingsvo.h"
+#include "fsframearena.h" // <FS/> Frame arena
 
 extern BOOL gSnapshot;
 bool gShiftFrame = false;
@@ -8158,9 +8159,15 @@ void LLPipeline::renderDeferredLighting()
         if (local_light_count > 0)
         {
             gGL.setSceneBlendType(LLRender::BT_ADD);
-            std::list<LLVector4>        fullscreen_lights;
-            LLDrawable::drawable_list_t spot_lights;
-            LLDrawable::drawable_list_t fullscreen_spot_lights;
+            // <FS> Frame arena
+            //std::list<LLVector4>        fullscreen_lights;
+            //LLDrawable::drawable_list_t spot_lights;
+            //LLDrawable::drawable_list_t fullscreen_spot_lights;
+            typedef FSFrameList<LLPointer<LLDrawable> > frame_drawable_list_t;
+            FSFrameList<LLVector4>  fullscreen_lights;
+            frame_drawable_list_t   spot_lights;
+            frame_drawable_list_t   fullscreen_spot_lights;
+            // </FS>
 
             if (!gCubeSnapshot)
             {
@@ -8170,7 +8177,8 @@ void LLPipeline::renderDeferredLighting()
                 }
             }
 
-            std::list<LLVector4> light_colors;
+            //std::list<LLVector4> light_colors;
+            FSFrameList<LLVector4> light_colors; // <FS/> Frame arena
 
             LLVertexBuffer::unbind();
 
@@ -8294,7 +8302,7 @@ void LLPipeline::renderDeferredLighting()
 
                 gDeferredSpotLightProgram.enableTexture(LLShaderMgr::DEFERRED_PROJECTION);
 
-                for (LLDrawable::drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter)
+                for (frame_drawable_list_t::iterator iter = spot_lights.begin(); iter != spot_lights.end(); ++iter) // <FS/> Frame arena
                 {
                     LLDrawable *drawablep = *iter;
 
@@ -8368,7 +8376,7 @@ void LLPipeline::renderDeferredLighting()
 
                 mScreenTriangleVB->setBuffer();
 
-                for (LLDrawable::drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter)
+                for (frame_drawable_list_t::iterator iter = fullscreen_spot_lights.begin(); iter != fullscreen_spot_lights.end(); ++iter) // <FS/> Frame arena
                 {
                     LLDrawable* drawablep = *iter;
                     LLVOVolume* volume = drawablep->getVOVolume();
@@ -9195,7 +9203,8 @@ bool LLPipeline::getVisiblePointCloud(LLCamera& camera, LLVector3& min, LLVector
         LLPlane(max, LLVector3(0,0,1))};
 
     //potential points
-    std::vector<LLVector3> pp;
+    //std::vector<LLVector3> pp;
+    FSFrameVector<LLVector3> pp; // <FS/> Frame arena
 
     //add corners of AABB
     pp.push_back(LLVector3(min.mV[0], min.mV[1], min.mV[2]));
@@ -9734,7 +9743,8 @@ void LLPipeline::generateSunShadow(LLCamera& camera)
             //get a temporary view projection
             view[j] = look(camera.getOrigin(), lightDir, -up);
 
-            std::vector<LLVector3> wpf;
+            //std::vector<LLVector3> wpf;
+            FSFrameVector<LLVector3> wpf; // <FS/> Frame arena
 
             for (U32 i = 0; i < fp.size(); i++)
             {
@@ -147,7 +147,10 @@ static bool rlvParseGetStatusOption(const std::string& strOption, std::string& s
 //
 
 // Checked: 2010-04-07 (RLVa-1.2.0d) | Modified: RLVa-1.0.1d
-RlvHandler::RlvHandler() : m_fCanCancelTp(true), m_posSitSource(), m_pGCTimer(NULL)
+// <FS> Behaviour and exception index
+//RlvHandler::RlvHandler() : m_fCanCancelTp(true), m_posSitSource(), m_pGCTimer(NULL)
+RlvHandler::RlvHandler() : m_BehaviourIndex(RLV_BHVR_COUNT), m_ExceptionIndex(RLV_BHVR_COUNT), m_fCanCancelTp(true), m_posSitSource(), m_pGCTimer(NULL)
+// </FS>
 {
     gAgent.addListener(this, "new group");
 
@@ -217,26 +220,42 @@ void RlvHandler::cleanup()
 bool RlvHandler::findBehaviour(ERlvBehaviour eBhvr, std::list<const RlvObject*>& lObjects) const
 {
     lObjects.clear();
-    for (const auto& objEntry : m_Objects)
-        if (objEntry.second.hasBehaviour(eBhvr, false))
-            lObjects.push_back(&objEntry.second);
+    // <FS> Look up the holders instead of asking every object
+    //for (const auto& objEntry : m_Objects)
+    //    if (objEntry.second.hasBehaviour(eBhvr, false))
+    //        lObjects.push_back(&objEntry.second);
+    uuid_vec_t idObjs;
+    m_BehaviourIndex.getHolders(eBhvr, false, idObjs);
+    for (const LLUUID& idObj : idObjs)
+    {
+        rlv_object_map_t::const_iterator itObj = m_Objects.find(idObj);
+        if (m_Objects.end() != itObj)
+            lObjects.push_back(&itObj->second);
+    }
+    // </FS>
     return !lObjects.empty();
 }
 
 bool RlvHandler::hasBehaviour(const LLUUID& idRlvObj, ERlvBehaviour eBhvr, const std::string& strOption) const
 {
-    rlv_object_map_t::const_iterator itObj = m_Objects.find(idRlvObj);
-    if (m_Objects.end() != itObj)
-        return itObj->second.hasBehaviour(eBhvr, strOption, false);
-    return false;
+    // <FS> Behaviour index
+    //rlv_object_map_t::const_iterator itObj = m_Objects.find(idRlvObj);
+    //if (m_Objects.end() != itObj)
+    //    return itObj->second.hasBehaviour(eBhvr, strOption, false);
+    //return false;
+    return m_BehaviourIndex.hasBehaviour(idRlvObj, eBhvr, strOption);
+    // </FS>
 }
 
 bool RlvHandler::hasBehaviourExcept(ERlvBehaviour eBhvr, const std::string& strOption, const LLUUID& idObj) const
 {
-    for (rlv_object_map_t::const_iterator itObj = m_Objects.begin(); itObj != m_Objects.end(); ++itObj)
-        if ( (idObj != itObj->second.getObjectID()) && (itObj->second.hasBehaviour(eBhvr, strOption, false)) )
-            return true;
-    return false;
+    // <FS> Behaviour index
+    //for (rlv_object_map_t::const_iterator itObj = m_Objects.begin(); itObj != m_Objects.end(); ++itObj)
+    //    if ( (idObj != itObj->second.getObjectID()) && (itObj->second.hasBehaviour(eBhvr, strOption, false)) )
+    //        return true;
+    //return false;
+    return m_BehaviourIndex.hasBehaviourExcept(eBhvr, strOption, idObj);
+    // </FS>
 }
 
 // Checked: 2011-04-11 (RLVa-1.3.0h) | Added: RLVa-1.3.0h
@@ -250,26 +269,48 @@ bool RlvHandler::hasBehaviourRoot(const LLUUID& idObjRoot, ERlvBehaviour eBhvr,
 
 bool RlvHandler::ownsBehaviour(const LLUUID& idObj, ERlvBehaviour eBhvr) const
 {
-    bool fHasBhvr = false;
-    for (const auto& objEntry : m_Objects)
-    {
-        if (objEntry.second.hasBehaviour(eBhvr, false))
-        {
-            if (objEntry.first != idObj)
-                return false;
-            fHasBhvr = true;
-        }
-    }
-    return fHasBhvr;
+    // <FS> Behaviour index
+    //bool fHasBhvr = false;
+    //for (const auto& objEntry : m_Objects)
+    //{
+    //    if (objEntry.second.hasBehaviour(eBhvr, false))
+    //    {
+    //        if (objEntry.first != idObj)
+    //            return false;
+    //        fHasBhvr = true;
+    //    }
+    //}
+    //return fHasBhvr;
+    return m_BehaviourIndex.ownsBehaviour(idObj, eBhvr);
+    // </FS>
 }
 
 // ============================================================================
 // Behaviour exception handling
 //
 
+// <FS> Exception index
+namespace
+{
+    struct RlvExceptionOptionHashVisitor : public boost::static_visitor<size_t>
+    {
+        size_t operator()(const std::string& strOption) const { return std::hash<std::string>()(strOption); }
+        size_t operator()(const LLUUID& idOption) const      { return std::hash<LLUUID>()(idOption); }
+        size_t operator()(S32 nOption) const                 { return std::hash<S32>()(nOption); }
+        size_t operator()(ERlvBehaviour eOption) const       { return std::hash<S32>()(eOption) ^ 0x9e3779b9; }
+    };
+}
+
+size_t RlvHandler::RlvExceptionOptionHash::operator()(const RlvExceptionOption& varOption) const
+{
+    return boost::apply_visitor(RlvExceptionOptionHashVisitor(), varOption);
+}
+// </FS>
+
 void RlvHandler::addException(const LLUUID& idObj, ERlvBehaviour eBhvr, const RlvExceptionOption& varOption)
 {
     m_Exceptions.insert(std::make_pair(eBhvr, RlvException(idObj, eBhvr, varOption)));
+    m_ExceptionIndex.add(idObj, eBhvr, varOption); // <FS/> Exception index
 }
 
 bool RlvHandler::isException(ERlvBehaviour eBhvr, const RlvExceptionOption& varOption, ERlvExceptionCheck eCheckType) const
@@ -278,34 +319,53 @@ bool RlvHandler::isException(ERlvBehaviour eBhvr, const RlvExceptionOption& varO
     if (ERlvExceptionCheck::Default == eCheckType)
         eCheckType = ( (hasBehaviour(eBhvr)) && (!isPermissive(eBhvr)) ) ? ERlvExceptionCheck::Strict : ERlvExceptionCheck::Permissive;
 
-    uuid_vec_t objList;
-    if (ERlvExceptionCheck::Strict == eCheckType)
-    {
-        // If we're "strict checking" then we need the UUID of every object that currently has 'eBhvr' restricted
-        for (const auto& objEntry : m_Objects)
-        {
-            if (objEntry.second.hasBehaviour(eBhvr, !hasBehaviour(RLV_BHVR_PERMISSIVE)))
-                objList.push_back(objEntry.first);
-        }
-    }
+    // <FS> Look the option up in the exception index instead of walking every exception and object
+    //uuid_vec_t objList;
+    //if (ERlvExceptionCheck::Strict == eCheckType)
+    //{
+    //    // If we're "strict checking" then we need the UUID of every object that currently has 'eBhvr' restricted
+    //    for (const auto& objEntry : m_Objects)
+    //    {
+    //        if (objEntry.second.hasBehaviour(eBhvr, !hasBehaviour(RLV_BHVR_PERMISSIVE)))
+    //            objList.push_back(objEntry.first);
+    //    }
+    //}
+    //
+    //for (rlv_exception_map_t::const_iterator itException = m_Exceptions.lower_bound(eBhvr), endException = m_Exceptions.upper_bound(eBhvr); itException != endException; ++itException)
+    //{
+    //    if (itException->second.varOption == varOption)
+    //    {
+    //        // For permissive checks we just return on the very first match
+    //        if (ERlvExceptionCheck::Permissive == eCheckType)
+    //            return true;
+    //
+    //        // For strict checks we don't return until the list is empty (every object with 'eBhvr' restricted also contains the exception)
+    //        uuid_vec_t::iterator itList = std::find(objList.begin(), objList.end(), itException->second.idObject);
+    //        if (itList != objList.end())
+    //            objList.erase(itList);
+    //        if (objList.empty())
+    //            return true;
+    //    }
+    //}
+    //return false;
+    const fs_rlv_holders_t* pExceptionHolders = m_ExceptionIndex.find(eBhvr, varOption);
+    if (!pExceptionHolders)
+        return false;
 
-    for (rlv_exception_map_t::const_iterator itException = m_Exceptions.lower_bound(eBhvr), endException = m_Exceptions.upper_bound(eBhvr); itException != endException; ++itException)
-    {
-        if (itException->second.varOption == varOption)
-        {
-            // For permissive checks we just return on the very first match
-            if (ERlvExceptionCheck::Permissive == eCheckType)
-                return true;
+    // For permissive checks any object adding the exception will do
+    if (ERlvExceptionCheck::Permissive == eCheckType)
+        return true;
 
-            // For strict checks we don't return until the list is empty (every object with 'eBhvr' restricted also contains the exception)
-            uuid_vec_t::iterator itList = std::find(objList.begin(), objList.end(), itException->second.idObject);
-            if (itList != objList.end())
-                objList.erase(itList);
-            if (objList.empty())
-                return true;
-        }
+    // For strict checks every object with 'eBhvr' restricted also has to contain the exception
+    uuid_vec_t objList;
+    m_BehaviourIndex.getHolders(eBhvr, !hasBehaviour(RLV_BHVR_PERMISSIVE), objList);
+    for (const LLUUID& idObj : objList)
+    {
+        if (!pExceptionHolders->count(idObj))
+            return false;
     }
-    return false;
+    return true;
+    // </FS>
 }
 
 bool RlvHandler::isPermissive(ERlvBehaviour eBhvr) const
@@ -322,6 +382,7 @@ void RlvHandler::removeException(const LLUUID& idObj, ERlvBehaviour eBhvr, const
         if ( (itException->second.idObject == idObj) && (itException->second.varOption == varOption) )
         {
             m_Exceptions.erase(itException);
+            m_ExceptionIndex.remove(idObj, eBhvr, varOption); // <FS/> Exception index
             break;
         }
     }
@@ -512,12 +573,16 @@ ERlvCmdRet RlvHandler::processCommand(std::reference_wrapper<const RlvCommand> r
                 RLV_DEBUGS << "\t- " << ( (fAdded) ? "adding behaviour" : "skipping duplicate" ) << RLV_ENDL;
 
                 if (fAdded) {   // If FALSE then this was a duplicate, there's no need to handle those
+                    m_BehaviourIndex.addCommand(idCurObj, eBhvr, rlvCmd.get().getOption(), rlvCmd.get().isStrict()); // <FS/> Behaviour index
                     if (!m_pGCTimer)
                         m_pGCTimer = new RlvGCTimer();
                     eRet = processAddRemCommand(rlvCmd);
                     if (!RLV_RET_SUCCEEDED(eRet))
                     {
                         RlvCommand rlvCmdRem(rlvCmd, RLV_TYPE_REMOVE);
+                        // <FS> Behaviour index
+                        m_BehaviourIndex.removeCommand(idCurObj, eBhvr, rlvCmdRem.getOption(), rlvCmdRem.isStrict());
+                        // </FS>
                         itObj->second.removeCommand(rlvCmdRem);
                         if (itObj->second.m_Commands.empty())
                         {
@@ -538,6 +603,10 @@ ERlvCmdRet RlvHandler::processCommand(std::reference_wrapper<const RlvCommand> r
                 rlv_object_map_t::iterator itObj = m_Objects.find(idCurObj); bool fRemoved = false;
                 if (itObj != m_Objects.end())
                     fRemoved = itObj->second.removeCommand(rlvCmd);
+                // <FS> Behaviour index
+                if (fRemoved)
+                    m_BehaviourIndex.removeCommand(idCurObj, rlvCmd.get().getBehaviourType(), rlvCmd.get().getOption(), rlvCmd.get().isStrict());
+                // </FS>
 
                 RLV_DEBUGS << "\t- " << ( (fRemoved) ? "removing behaviour"
                                                      : "skipping remove (unset behaviour or unknown object)") << RLV_ENDL;
@@ -1294,7 +1363,10 @@ bool RlvHandler::filterChat(std::string& strUTF8Text, bool fFilterEmote) const
 // Checked: 2010-11-29 (RLVa-1.3.0c) | Added: RLVa-1.3.0c
 bool RlvHandler::hasException(ERlvBehaviour eBhvr) const
 {
-    return (m_Exceptions.find(eBhvr) != m_Exceptions.end());
+    // <FS> Exception index
+    //return (m_Exceptions.find(eBhvr) != m_Exceptions.end());
+    return m_ExceptionIndex.hasException(eBhvr);
+    // </FS>
 }
 
 // Checked: 2010-02-27 (RLVa-1.2.0b) | Modified: RLVa-1.2.0a
@@ -1719,12 +1791,14 @@ ERlvCmdRet RlvHandler::processAddRemCommand(const RlvCommand& rlvCmd)
                 addException(rlvCmd.getObjectID(), RLV_BHVR_PERMISSIVE, eBhvr);
             m_Behaviours[eBhvr]++;
             rlvCmd.markRefCounted();
+            m_BehaviourIndex.addRefCounted(rlvCmd.getObjectID(), eBhvr); // <FS/> Behaviour index
         }
         else
         {
             if (rlvCmd.isStrict())
                 removeException(rlvCmd.getObjectID(), RLV_BHVR_PERMISSIVE, eBhvr);
             m_Behaviours[eBhvr]--;
+            m_BehaviourIndex.removeRefCounted(rlvCmd.getObjectID(), eBhvr); // <FS/> Behaviour index
         }
 
         m_OnBehaviour(eBhvr, eType);
@@ -1752,6 +1826,7 @@ ERlvCmdRet RlvCommandHandlerBaseImpl<RLV_TYPE_ADDREM>::processCommand(const RlvC
                 gRlvHandler.addException(rlvCmd.getObjectID(), RLV_BHVR_PERMISSIVE, eBhvr);
             gRlvHandler.m_Behaviours[eBhvr]++;
             rlvCmd.markRefCounted();
+            gRlvHandler.m_BehaviourIndex.addRefCounted(rlvCmd.getObjectID(), eBhvr); // <FS/> Behaviour index
         }
         else
         {
@@ -1760,6 +1835,7 @@ ERlvCmdRet RlvCommandHandlerBaseImpl<RLV_TYPE_ADDREM>::processCommand(const RlvC
             if (RlvObject* pRlvObj = gRlvHandler.getObject(rlvCmd.getObjectID()))
                 pRlvObj->clearModifiers(eBhvr);
             gRlvHandler.m_Behaviours[eBhvr]--;
+            gRlvHandler.m_BehaviourIndex.removeRefCounted(rlvCmd.getObjectID(), eBhvr); // <FS/> Behaviour index
         }
 
         gRlvHandler.m_OnBehaviour(eBhvr, rlvCmd.getParamType());
@@ -22,6 +22,7 @@
 
 #include "rlvcommon.h"
 #include "rlvhelper.h"
+#include "fsrlvbehaviourindex.h" // <FS/> Behaviour and exception index
 
 // ============================================================================
 // RlvHandler class
@@ -242,11 +243,21 @@ public:
         RlvException();
     };
     typedef std::multimap<ERlvBehaviour, RlvException> rlv_exception_map_t;
+    // <FS> Hashes exception options for the exception index
+    struct RlvExceptionOptionHash
+    {
+        size_t operator()(const RlvExceptionOption& varOption) const;
+    };
+    // </FS>
 protected:
     rlv_object_map_t      m_Objects;                // Map of objects that have active restrictions (idObj -> RlvObject)
     rlv_blocked_object_list_t m_BlockedObjects;     // List of (attached) objects that can't issue commands
     rlv_exception_map_t   m_Exceptions;             // Map of currently active restriction exceptions (ERlvBehaviour -> RlvException)
     S16                   m_Behaviours[RLV_BHVR_COUNT];
+    // <FS> Which objects hold which behaviour/option and exception, kept in step with m_Objects and m_Exceptions
+    FSRlvBehaviourIndex   m_BehaviourIndex;
+    FSRlvExceptionIndex<RlvExceptionOption, RlvExceptionOptionHash> m_ExceptionIndex;
+    // </FS>
 
     rlv_command_list_t    m_Retained;
     RlvGCTimer*           m_pGCTimer;
@@ -0,0 +1,316 @@
+/**
+ * @file fsaostatetable_test.cpp
+ * @brief Animation overrider state tables and animation request coalescing
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsaostatetable.h"
+
+#include <cstring>
+#include <iostream>
+#include <set>
+
+namespace
+{
+    LLUUID make_id(U32 n)
+    {
+        LLUUID id;
+        memcpy(id.mData, &n, sizeof(n));
+        id.mData[UUID_BYTES - 1] = 0xa0;
+        return id;
+    }
+
+    enum
+    {
+        STAND = 1, WALK, RUN, HOVER, FLY, SIT_GROUND, SIT_GROUND_CONSTRAINED, TYPE
+    };
+
+    enum
+    {
+        Standing = 0, Walking, Running, SittingOnGround, Flying, Hovering, Typing, Floating, SwimmingForward, STATE_COUNT
+    };
+
+    // Same layout as an AO set: motions in state order, duplicates resolve
+    // to the first state
+    void build_set_table(FSAOStateTable& table)
+    {
+        const U32 motions[STATE_COUNT] =
+        {
+            STAND, WALK, RUN, SIT_GROUND_CONSTRAINED, FLY, HOVER, TYPE, HOVER, FLY
+        };
+        for (S32 state = 0; state < STATE_COUNT; ++state)
+        {
+            table.addState(make_id(motions[state]), state);
+        }
+        table.addAlias(make_id(SIT_GROUND), make_id(SIT_GROUND_CONSTRAINED));
+        table.addUnderwaterState(make_id(HOVER), Floating);
+        table.addUnderwaterState(make_id(FLY), SwimmingForward);
+    }
+
+    // Animations the region has running for the agent after a list of
+    // AgentAnimation messages
+    struct RegionModel
+    {
+        std::set<LLUUID>    mRunning;
+        U32                 mMessages;
+
+        RegionModel() : mMessages(0) {}
+
+        void send(const std::vector<LLUUID>& animations, bool start)
+        {
+            ++mMessages;
+            for (size_t i = 0; i < animations.size(); ++i)
+            {
+                if (start)
+                {
+                    mRunning.insert(animations[i]);
+                }
+                else
+                {
+                    mRunning.erase(animations[i]);
+                }
+            }
+        }
+    };
+}
+
+namespace tut
+{
+    struct aostatetable_data
+    {
+        FSAOStateTable mTable;
+        FSAOAnimationRequests mRequests;
+        std::vector<LLUUID> mStops;
+        std::vector<LLUUID> mStarts;
+    };
+    typedef test_group<aostatetable_data> aostatetable_t;
+    typedef aostatetable_t::object aostatetable_object_t;
+    tut::aostatetable_t tut_aostatetable("FSAOStateTable");
+
+    template<> template<>
+    void aostatetable_object_t::test<1>()
+    {
+        set_test_name("Compiled state table");
+        build_set_table(mTable);
+
+        ensure_equals("stand", mTable.getState(make_id(STAND)), (S32)Standing);
+        ensure_equals("first state wins", mTable.getState(make_id(HOVER)), (S32)Hovering);
+        ensure_equals("fly", mTable.getState(make_id(FLY)), (S32)Flying);
+        ensure_equals("alias", mTable.getState(make_id(SIT_GROUND)), (S32)SittingOnGround);
+        ensure_equals("underwater hover", mTable.getUnderwaterState(make_id(HOVER)), (S32)Floating);
+        ensure_equals("underwater fly", mTable.getUnderwaterState(make_id(FLY)), (S32)SwimmingForward);
+        ensure_equals("no underwater walk", mTable.getUnderwaterState(make_id(WALK)), (S32)FSAOStateTable::NO_STATE);
+        ensure_equals("unknown motion", mTable.getState(make_id(1000)), (S32)FSAOStateTable::NO_STATE);
+        ensure_equals("null motion", mTable.getState(LLUUID::null), (S32)FSAOStateTable::NO_STATE);
+
+        mTable.clear();
+        ensure_equals("cleared", mTable.getState(make_id(STAND)), (S32)FSAOStateTable::NO_STATE);
+    }
+
+    template<> template<>
+    void aostatetable_object_t::test<2>()
+    {
+        set_test_name("Coalescing within a frame");
+        const LLUUID a = make_id(100);
+        const LLUUID b = make_id(101);
+        const LLUUID c = make_id(102);
+
+        mRequests.add(a, false);
+        mRequests.add(b, true);
+        mRequests.add(b, true);         // duplicate
+        mRequests.add(c, true);
+        mRequests.add(c, false);        // started and stopped again
+        mRequests.add(a, true);         // stopped and started again, both go out
+        mRequests.add(LLUUID::null, true);
+        ensure_equals("pending", mRequests.size(), (size_t)4);
+
+        ensure_equals("two messages", mRequests.take(mStops, mStarts), (U32)2);
+        ensure("empty after take", mRequests.empty());
+        ensure_equals("two stops", mStops.size(), (size_t)2);
+        ensure_equals("stop a", mStops[0], a);
+        ensure_equals("then c", mStops[1], c);
+        ensure_equals("two starts", mStarts.size(), (size_t)2);
+        ensure_equals("b first", mStarts[0], b);
+        ensure_equals("then a", mStarts[1], a);
+
+        ensure_equals("requests", mRequests.getRequestCount(), (U32)6);
+        ensure_equals("suppressed", mRequests.getSuppressedCount(), (U32)2);
+        ensure_equals("sent", mRequests.getSentCount(), (U32)4);
+        ensure_equals("messages", mRequests.getMessageCount(), (U32)2);
+
+        ensure_equals("nothing to send", mRequests.take(mStops, mStarts), (U32)0);
+        ensure("no stops", mStops.empty());
+        ensure("no starts", mStarts.empty());
+
+        mRequests.add(a, false);
+        mRequests.clear();
+        ensure("cleared", mRequests.empty());
+        ensure_equals("dropped counts as suppressed", mRequests.getSuppressedCount(), (U32)3);
+    }
+
+    template<> template<>
+    void aostatetable_object_t::test<3>()
+    {
+        set_test_name("Synthetic state sequence");
+        build_set_table(mTable);
+
+        // Each state plays one override animation
+        std::vector<LLUUID> overrides;
+        for (S32 state = 0; state < STATE_COUNT; ++state)
+        {
+            overrides.push_back(make_id(500 + state));
+        }
+
+        // Motion changes per frame: walking in and out of a crowd flaps
+        // between stand and walk several times a frame, then a flight with
+        // hover and fly flapping, a dip under water and a ground sit.
+        std::vector<std::vector<U32> > frames;
+        for (S32 i = 0; i < 100; ++i)
+        {
+            std::vector<U32> frame;
+            frame.push_back(WALK);
+            if (i % 3)
+            {
+                frame.push_back(STAND);
+                frame.push_back(WALK);
+            }
+            if (i % 5 == 0)
+            {
+                frame.push_back(STAND);
+            }
+            frames.push_back(frame);
+        }
+        for (S32 i = 0; i < 100; ++i)
+        {
+            std::vector<U32> frame;
+            frame.push_back(i % 2 ? FLY : HOVER);
+            if (i % 4 == 0)
+            {
+                frame.push_back(HOVER);
+                frame.push_back(FLY);
+            }
+            frames.push_back(frame);
+        }
+        frames.push_back(std::vector<U32>(1, SIT_GROUND));
+        frames.push_back(std::vector<U32>(1, STAND));
+
+        // Replays the sequence the way the overrider reacts to it: stop the
+        // animation of the previous state, start the one of the new state.
+        // Half of the flight happens under water.
+        RegionModel direct;
+        RegionModel coalesced;
+        FSAOAnimationRequests& requests = mRequests;
+        S32 current_state = FSAOStateTable::NO_STATE;
+        U32 direct_requests = 0;
+        for (size_t f = 0; f < frames.size(); ++f)
+        {
+            const bool underwater = f >= 150 && f < 200;
+            for (size_t m = 0; m < frames[f].size(); ++m)
+            {
+                const LLUUID motion = make_id(frames[f][m]);
+                S32 state = underwater ? mTable.getUnderwaterState(motion) : FSAOStateTable::NO_STATE;
+                if (state == FSAOStateTable::NO_STATE)
+                {
+                    state = mTable.getState(motion);
+                }
+                ensure("known motion", state != FSAOStateTable::NO_STATE);
+
+                if (current_state != FSAOStateTable::NO_STATE)
+                {
+                    direct.send(std::vector<LLUUID>(1, overrides[current_state]), false);
+                    requests.add(overrides[current_state], false);
+                    ++direct_requests;
+                }
+                direct.send(std::vector<LLUUID>(1, overrides[state]), true);
+                requests.add(overrides[state], true);
+                ++direct_requests;
+                current_state = state;
+            }
+
+            if (requests.take(mStops, mStarts))
+            {
+                if (!mStops.empty())
+                {
+                    coalesced.send(mStops, false);
+                }
+                if (!mStarts.empty())
+                {
+                    coalesced.send(mStarts, true);
+                }
+            }
+
+            // Both ways the region ends up playing the same animations
+            ensure("same running animations", direct.mRunning == coalesced.mRunning);
+            ensure_equals("one override running", coalesced.mRunning.size(), (size_t)1);
+        }
+
+        ensure("runs on the last state", coalesced.mRunning.count(overrides[Standing]) == 1);
+        ensure_equals("all requests counted", requests.getRequestCount(), direct_requests);
+        ensure_equals("requests accounted for", requests.getSentCount() + requests.getSuppressedCount(), direct_requests);
+        ensure("at most two messages a frame", coalesced.mMessages <= frames.size() * 2);
+        ensure("fewer messages", coalesced.mMessages < direct.mMessages);
+
+        std::cout << "\nAO state sequence: " << frames.size() << " frames, " << direct.mMessages
+                  << " messages sent directly, " << coalesced.mMessages << " coalesced, "
+                  << requests.getSuppressedCount() << " requests suppressed" << std::endl;
+    }
+
+    template<> template<>
+    void aostatetable_object_t::test<4>()
+    {
+        set_test_name("Restarting within a frame");
+        const LLUUID a = make_id(100);
+
+        // Playing from an earlier frame, stopped and started again
+        RegionModel region;
+        region.send(std::vector<LLUUID>(1, a), true);
+        mRequests.add(a, false);
+        mRequests.add(a, true);
+        ensure_equals("two messages", mRequests.take(mStops, mStarts), (U32)2);
+        ensure("stop sent", mStops.size() == 1 && mStops[0] == a);
+        ensure("start sent", mStarts.size() == 1 && mStarts[0] == a);
+        region.send(mStops, false);
+        region.send(mStarts, true);
+        ensure("still running", region.mRunning.count(a) == 1);
+
+        // The same again, then stopped for good
+        mRequests.add(a, false);
+        mRequests.add(a, true);
+        mRequests.add(a, false);
+        ensure_equals("one message", mRequests.take(mStops, mStarts), (U32)1);
+        ensure("only the stop", mStops.size() == 1 && mStops[0] == a && mStarts.empty());
+
+        // Repeated stops and starts do not pile up
+        mRequests.add(a, false);
+        mRequests.add(a, true);
+        mRequests.add(a, false);
+        mRequests.add(a, true);
+        mRequests.add(a, true);
+        ensure_equals("one stop and one start", mRequests.size(), (size_t)2);
+    }
+}
@@ -0,0 +1,295 @@
+/**
+ * @file fscamerapredictor_test.cpp
+ * @brief Camera trajectory prediction and recorded camera path replay
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fscamerapredictor.h"
+
+#include "llmath.h"
+#include "llquaternion.h"
+
+#include <vector>
+
+namespace
+{
+    const F64 FRAME_TIME = 1.0 / 30.0;
+
+    struct CameraSample
+    {
+        LLVector3   mOrigin;
+        LLVector3   mAtAxis;
+    };
+    typedef std::vector<CameraSample> camera_path_t;
+
+    // A recorded session: hover, fly straight along a street of objects,
+    // turn left on the spot, then fly on in the new direction.
+    camera_path_t record_camera_path()
+    {
+        camera_path_t path;
+        LLVector3 origin(0.f, 0.f, 25.f);
+        F32 heading = 0.f;
+
+        for (S32 frame = 0; frame < 600; ++frame)
+        {
+            if (frame >= 30 && frame < 240)
+            {
+                origin += LLVector3(cosf(heading), sinf(heading), 0.f) * (15.f * (F32)FRAME_TIME);
+            }
+            else if (frame >= 240 && frame < 300)
+            {
+                heading += F_PI_BY_TWO / 60.f;
+            }
+            else if (frame >= 300)
+            {
+                origin += LLVector3(cosf(heading), sinf(heading), 0.f) * (15.f * (F32)FRAME_TIME);
+            }
+
+            CameraSample sample;
+            sample.mOrigin = origin;
+            sample.mAtAxis.setVec(cosf(heading), sinf(heading), 0.f);
+            path.push_back(sample);
+        }
+        return path;
+    }
+
+    std::vector<LLVector3> build_scene()
+    {
+        std::vector<LLVector3> objects;
+        for (S32 i = 0; i < 50; ++i)
+        {
+            // Both sides of the first street and of the street after the turn
+            objects.push_back(LLVector3(8.f * i, -12.f, 25.f));
+            objects.push_back(LLVector3(8.f * i, 12.f, 25.f));
+            objects.push_back(LLVector3(105.f - 12.f, 8.f * i, 25.f));
+            objects.push_back(LLVector3(105.f + 12.f, 8.f * i, 25.f));
+        }
+        return objects;
+    }
+
+    const F32 OBJECT_RADIUS = 3.f;
+    const F32 COS_HALF_FOV = 0.7f;
+
+    // Stand-in for the viewer's detail selection: projected size picks one
+    // of four detail levels, anything out of view needs nothing.
+    F32 object_importance(F32 distance, F32 cos_angle)
+    {
+        if (cos_angle < COS_HALF_FOV)
+        {
+            return 0.f;
+        }
+        return OBJECT_RADIUS / llmax(distance, 0.001f);
+    }
+
+    S32 detail_for_importance(F32 importance)
+    {
+        if (importance > 0.3f) return 3;
+        if (importance > 0.15f) return 2;
+        if (importance > 0.07f) return 1;
+        if (importance > 0.f) return 0;
+        return -1;
+    }
+
+    struct ReplayResult
+    {
+        S32 mPopIns;        // object-frames shown with less detail than needed
+        S32 mFetches;       // detail levels requested
+        S32 mWasted;        // requested levels never needed during the replay
+    };
+
+    // Replays the path with a fetch latency: a level requested at frame f
+    // can be shown from frame f + latency on.
+    ReplayResult replay(const camera_path_t& path, const std::vector<LLVector3>& objects, bool predict, S32 latency)
+    {
+        FSCameraPredictor predictor;
+        predictor.setParameters(predict, 0.5f, 0.5f);
+
+        const size_t num_objects = objects.size();
+        std::vector<S32> requested(num_objects, -1);
+        std::vector<S32> max_needed(num_objects, -1);
+        std::vector<std::vector<S32> > request_frame(num_objects, std::vector<S32>(4, -1));
+
+        ReplayResult result = { 0, 0, 0 };
+        for (S32 frame = 0; frame < (S32)path.size(); ++frame)
+        {
+            const CameraSample& sample = path[frame];
+            predictor.update(sample.mOrigin, sample.mAtAxis, frame * FRAME_TIME);
+
+            for (size_t i = 0; i < num_objects; ++i)
+            {
+                LLVector3 look_at = objects[i] - sample.mOrigin;
+                F32 distance = look_at.normVec();
+                F32 importance = object_importance(distance, look_at * sample.mAtAxis);
+
+                S32 needed = detail_for_importance(importance);
+                max_needed[i] = llmax(max_needed[i], needed);
+
+                F32 future_distance, future_cos;
+                if (predictor.getFutureView(objects[i], future_distance, future_cos))
+                {
+                    importance = predictor.blendWithFuture(importance, object_importance(future_distance, future_cos));
+                }
+
+                S32 wanted = detail_for_importance(importance);
+                for (S32 level = requested[i] + 1; level <= wanted; ++level)
+                {
+                    request_frame[i][level] = frame;
+                    ++result.mFetches;
+                }
+                requested[i] = llmax(requested[i], wanted);
+
+                // The first second the camera is parked while the scene loads, which
+                // no prediction can help with
+                if (frame >= 30 && needed >= 0 && (request_frame[i][needed] < 0 || request_frame[i][needed] + latency > frame))
+                {
+                    ++result.mPopIns;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < num_objects; ++i)
+        {
+            result.mWasted += llmax(requested[i] - max_needed[i], 0);
+        }
+        return result;
+    }
+}
+
+namespace tut
+{
+    struct camerapredictor_data
+    {
+        FSCameraPredictor mPredictor;
+
+        camerapredictor_data()
+        {
+            mPredictor.setParameters(true, 0.5f, 0.5f);
+        }
+
+        void fly(const LLVector3& start, const LLVector3& velocity, S32 frames)
+        {
+            for (S32 frame = 0; frame < frames; ++frame)
+            {
+                mPredictor.update(start + velocity * (F32)(frame * FRAME_TIME), LLVector3::x_axis, frame * FRAME_TIME);
+            }
+        }
+    };
+    typedef test_group<camerapredictor_data> camerapredictor_t;
+    typedef camerapredictor_t::object camerapredictor_object_t;
+    tut::camerapredictor_t tut_camerapredictor("FSCameraPredictor");
+
+    template<> template<>
+    void camerapredictor_object_t::test<1>()
+    {
+        set_test_name("Parked camera");
+        fly(LLVector3(10.f, 10.f, 20.f), LLVector3::zero, 30);
+        ensure("parked camera is not active", !mPredictor.isActive());
+        ensure_equals("distance untouched", mPredictor.getBlendedDistance(LLVector3(20.f, 10.f, 20.f), 10.f), 10.f);
+        ensure_equals("importance untouched", mPredictor.blendWithFuture(0.25f, 1.f), 0.25f);
+    }
+
+    template<> template<>
+    void camerapredictor_object_t::test<2>()
+    {
+        set_test_name("Straight flight");
+        fly(LLVector3(0.f, 0.f, 20.f), LLVector3(20.f, 0.f, 0.f), 30);
+        ensure("moving camera is active", mPredictor.isActive());
+        ensure_distance("velocity", mPredictor.getVelocity().mV[VX], 20.f, 0.5f);
+
+        // 29 frames flown, predicted half a second further
+        F32 current_x = 20.f * (F32)(29 * FRAME_TIME);
+        ensure_distance("predicted origin", mPredictor.getPredictedOrigin().mV[VX], current_x + 10.f, 0.5f);
+
+        // Objects ahead are treated as closer, objects behind are not
+        LLVector3 ahead(current_x + 30.f, 0.f, 20.f);
+        ensure("ahead is closer", mPredictor.getBlendedDistance(ahead, 30.f) < 30.f);
+        ensure("ahead not closer than predicted", mPredictor.getBlendedDistance(ahead, 30.f) >= 20.f - 0.5f);
+        LLVector3 behind(current_x - 30.f, 0.f, 20.f);
+        ensure_equals("behind unchanged", mPredictor.getBlendedDistance(behind, 30.f), 30.f);
+    }
+
+    template<> template<>
+    void camerapredictor_object_t::test<3>()
+    {
+        set_test_name("Turning camera");
+        for (S32 frame = 0; frame < 30; ++frame)
+        {
+            F32 heading = (F32)(frame * FRAME_TIME);   // one radian per second to the left
+            mPredictor.update(LLVector3(0.f, 0.f, 20.f), LLVector3(cosf(heading), sinf(heading), 0.f), frame * FRAME_TIME);
+        }
+        ensure("turning camera is active", mPredictor.isActive());
+        ensure_distance("angular velocity", mPredictor.getAngularVelocity().mV[VZ], 1.f, 0.05f);
+
+        F32 heading = (F32)(29 * FRAME_TIME);
+        F32 predicted_heading = atan2f(mPredictor.getPredictedAtAxis().mV[VY], mPredictor.getPredictedAtAxis().mV[VX]);
+        ensure_distance("predicted heading", predicted_heading, heading + 0.5f, 0.05f);
+
+        // Something just outside the view on the left comes into the future view
+        LLVector3 left(0.f, 30.f, 20.f);
+        F32 distance, cos_angle;
+        ensure("future view", mPredictor.getFutureView(left, distance, cos_angle));
+        ensure_distance("future distance", distance, 30.f, 0.01f);
+        ensure("left is more in view", cos_angle > left / 30.f * LLVector3(cosf(heading), sinf(heading), 0.f));
+    }
+
+    template<> template<>
+    void camerapredictor_object_t::test<4>()
+    {
+        set_test_name("Teleports and disabled prediction");
+        fly(LLVector3(0.f, 0.f, 20.f), LLVector3(20.f, 0.f, 0.f), 30);
+        ensure("active before teleport", mPredictor.isActive());
+        mPredictor.update(LLVector3(200.f, 200.f, 20.f), LLVector3::x_axis, 30 * FRAME_TIME);
+        ensure("teleport is not motion", !mPredictor.isActive());
+        ensure("teleport clears velocity", mPredictor.getVelocity().isExactlyZero());
+
+        mPredictor.setParameters(false, 0.5f, 0.5f);
+        fly(LLVector3(0.f, 0.f, 20.f), LLVector3(20.f, 0.f, 0.f), 30);
+        ensure("disabled never active", !mPredictor.isActive());
+        F32 distance, cos_angle;
+        ensure("disabled has no future view", !mPredictor.getFutureView(LLVector3::zero, distance, cos_angle));
+    }
+
+    template<> template<>
+    void camerapredictor_object_t::test<5>()
+    {
+        set_test_name("Recorded camera path replay");
+        camera_path_t path = record_camera_path();
+        std::vector<LLVector3> objects = build_scene();
+
+        const S32 latency = 15; // half a second from request to display
+        ReplayResult current_only = replay(path, objects, false, latency);
+        ReplayResult predicted = replay(path, objects, true, latency);
+
+        // Without prediction no level is requested that is never needed
+        ensure_equals("no waste without prediction", current_only.mWasted, 0);
+
+        // Pop-in drops by at least a third, extra fetches stay a small share
+        ensure("pop-in reduced", predicted.mPopIns * 3 <= current_only.mPopIns * 2);
+        ensure("waste bounded", predicted.mWasted * 10 <= predicted.mFetches);
+    }
+}
@@ -0,0 +1,282 @@
+/**
+ * @file fsgroupmembertable_test.cpp
+ * @brief Columnar group member table, sorted views and capability unpacking
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsgroupmembertable.h"
+
+#include "llsd.h"
+#include "lltimer.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    LLUUID make_id(U32 n)
+    {
+        LLUUID id;
+        U32 values[4] = { n + 1, n * 2654435761u, 0x46534753, n ^ 0x5bd1e995 };
+        memcpy(id.mData, values, sizeof(values));
+        return id;
+    }
+
+    // A synthetic GroupMemberData response body: a few owners, a tenth of
+    // the members with another title, a few percent online, the rest
+    // spread over the last few years
+    void make_capability_members(U32 count, LLSD& members, LLSD& titles)
+    {
+        const char* title_names[] = { "Member", "Officer", "Builder", "Greeter", "Owner" };
+        titles = LLSD::emptyArray();
+        for (U32 i = 0; i < LL_ARRAY_SIZE(title_names); i++)
+        {
+            titles.append(title_names[i]);
+        }
+
+        members = LLSD::emptyMap();
+        U32 seed = 12345;
+        for (U32 n = 0; n < count; n++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            const U32 r = seed >> 8;
+
+            LLSD info = LLSD::emptyMap();
+            if (n < 3)
+            {
+                info["owner"] = true;
+                info["title"] = 4;
+                info["powers"] = "FFFFFFFFFFFFFFFF";
+            }
+            else if (r % 10 == 0)
+            {
+                info["title"] = (S32)(1 + (r / 10) % 3);
+            }
+            if (r % 33 == 0)
+            {
+                info["last_login"] = "Online";
+            }
+            else
+            {
+                info["last_login"] = llformat("%02u/%02u/%04u", 1 + (r / 7) % 12, 1 + (r / 91) % 28, 2020 + (r / 2557) % 6);
+            }
+            if (r % 20 == 0)
+            {
+                info["donated_square_meters"] = (S32)(512 << ((r / 20) % 4));
+            }
+            members[make_id(n).asString()] = info;
+        }
+    }
+
+    bool is_sorted_by(const FSGroupMemberTable& table, FSGroupMemberTable::EColumn column)
+    {
+        const std::vector<U32>& rows = table.getSortedRows(column);
+        if (rows.size() != table.size())
+        {
+            return false;
+        }
+        for (size_t i = 1; i < rows.size(); i++)
+        {
+            U32 a = rows[i - 1];
+            U32 b = rows[i];
+            switch (column)
+            {
+            case FSGroupMemberTable::COL_CONTRIBUTION:
+                if (table.getContribution(a) > table.getContribution(b)) return false;
+                break;
+            case FSGroupMemberTable::COL_LAST_LOGIN:
+                if (table.getLastLogin(a) > table.getLastLogin(b)) return false;
+                break;
+            case FSGroupMemberTable::COL_TITLE:
+                if (table.getTitle(b) < table.getTitle(a)) return false;
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+namespace tut
+{
+    struct groupmembertable_data
+    {
+        FSGroupMemberTable mTable;
+    };
+    typedef test_group<groupmembertable_data> groupmembertable_t;
+    typedef groupmembertable_t::object groupmembertable_object_t;
+    tut::groupmembertable_t tut_groupmembertable("FSGroupMemberTable");
+
+    template<> template<>
+    void groupmembertable_object_t::test<1>()
+    {
+        set_test_name("Members and interned strings");
+        for (U32 n = 0; n < 100; n++)
+        {
+            mTable.setMember(make_id(n), n, n % 3, n % 2 ? "Officer" : "Member", n % 10 ? "01/02/2024" : "Online",
+                             FSGroupMemberTable::lastLoginKey(n % 10 ? "01/02/2024" : "Online"), n == 0);
+        }
+        ensure_equals("size", mTable.size(), 100U);
+        ensure_equals("two titles", mTable.getTitleCount(), 2U);
+        ensure_equals("two statuses", mTable.getStatusCount(), 2U);
+
+        U32 row = mTable.findRow(make_id(42));
+        ensure("found", row != FSGroupMemberTable::NO_ROW);
+        ensure_equals("id", mTable.getID(row), make_id(42));
+        ensure_equals("contribution", mTable.getContribution(row), 42);
+        ensure_equals("title", mTable.getTitle(row), std::string("Member"));
+        ensure("owner", mTable.isOwner(mTable.findRow(make_id(0))));
+        ensure("unknown member", mTable.findRow(make_id(1000)) == FSGroupMemberTable::NO_ROW);
+
+        // Replacing keeps the row
+        ensure_equals("same row", mTable.setMember(make_id(42), 7, 0, "Builder", "Online",
+                                                   FSGroupMemberTable::LOGIN_ONLINE, false), row);
+        ensure_equals("replaced", mTable.getContribution(row), 7);
+        ensure_equals("new title", mTable.getTitleCount(), 3U);
+
+        // Removing moves the last member into the gap
+        mTable.removeMember(make_id(42));
+        ensure_equals("removed", mTable.size(), 99U);
+        ensure("gone", mTable.findRow(make_id(42)) == FSGroupMemberTable::NO_ROW);
+        U32 moved = mTable.findRow(make_id(99));
+        ensure_equals("last moved", moved, row);
+        ensure_equals("moved data", mTable.getContribution(moved), 99);
+
+        mTable.formatStatuses([](std::string& status) { if (status == "Online") status = "En ligne"; });
+        ensure_equals("formatted", mTable.getStatus(mTable.findRow(make_id(10))), std::string("En ligne"));
+    }
+
+    template<> template<>
+    void groupmembertable_object_t::test<2>()
+    {
+        set_test_name("Last login keys");
+        ensure_equals("online", FSGroupMemberTable::lastLoginKey("Online"), FSGroupMemberTable::LOGIN_ONLINE);
+        ensure_equals("server date", FSGroupMemberTable::lastLoginKey("03/14/2023"), 20230314U);
+        ensure_equals("formatted date", FSGroupMemberTable::lastLoginKey("2023/03/14"), 20230314U);
+        ensure_equals("unknown", FSGroupMemberTable::lastLoginKey("unknown"), 0U);
+        ensure_equals("bad month", FSGroupMemberTable::lastLoginKey("13/01/2023"), 0U);
+        ensure_equals("too few parts", FSGroupMemberTable::lastLoginKey("03/2023"), 0U);
+        ensure("ordered", FSGroupMemberTable::lastLoginKey("12/31/2022") < FSGroupMemberTable::lastLoginKey("01/01/2023"));
+    }
+
+    template<> template<>
+    void groupmembertable_object_t::test<3>()
+    {
+        set_test_name("Incremental sorted views and paging");
+        LLSD members, titles;
+        make_capability_members(5000, members, titles);
+
+        // Stream the members in four chunks, asking for the views in between
+        LLSD chunk = LLSD::emptyMap();
+        U32 n = 0;
+        for (LLSD::map_const_iterator it = members.beginMap(); it != members.endMap(); ++it, ++n)
+        {
+            chunk[it->first] = it->second;
+            if (chunk.size() == 1250 || n + 1 == members.size())
+            {
+                mTable.addCapabilityMembers(chunk, titles, 0);
+                chunk = LLSD::emptyMap();
+                ensure("contribution sorted", is_sorted_by(mTable, FSGroupMemberTable::COL_CONTRIBUTION));
+                ensure("login sorted", is_sorted_by(mTable, FSGroupMemberTable::COL_LAST_LOGIN));
+            }
+        }
+        ensure_equals("all members", mTable.size(), 5000U);
+        ensure("title sorted", is_sorted_by(mTable, FSGroupMemberTable::COL_TITLE));
+
+        // The incrementally built view matches a full sort with the same tie break
+        std::vector<U32> full(mTable.size());
+        for (U32 row = 0; row < mTable.size(); row++)
+        {
+            full[row] = row;
+        }
+        std::stable_sort(full.begin(), full.end(), [this](U32 a, U32 b) { return mTable.getLastLogin(a) < mTable.getLastLogin(b); });
+        ensure("same as full sort", full == mTable.getSortedRows(FSGroupMemberTable::COL_LAST_LOGIN));
+
+        // Descending pages cover every member once, online members first
+        std::vector<U32> rows;
+        U32 first = 0;
+        U32 copied;
+        while ((copied = mTable.getPage(FSGroupMemberTable::COL_LAST_LOGIN, false, first, 100, rows)) > 0)
+        {
+            first += copied;
+        }
+        ensure_equals("paged all", (U32)rows.size(), mTable.size());
+        ensure_equals("online first", mTable.getLastLogin(rows.front()), FSGroupMemberTable::LOGIN_ONLINE);
+        std::sort(rows.begin(), rows.end());
+        ensure("each once", std::adjacent_find(rows.begin(), rows.end()) == rows.end());
+        ensure_equals("past the end", mTable.getPage(FSGroupMemberTable::COL_LAST_LOGIN, true, mTable.size(), 100, rows), 0U);
+
+        // Removing invalidates the views, they come back sorted
+        mTable.removeMember(mTable.getID(0));
+        ensure("sorted after remove", is_sorted_by(mTable, FSGroupMemberTable::COL_LAST_LOGIN));
+    }
+
+    template<> template<>
+    void groupmembertable_object_t::test<4>()
+    {
+        set_test_name("Capability unpacking of a 50k member group");
+        LLSD members, titles;
+        make_capability_members(50000, members, titles);
+
+        LLTimer timer;
+        mTable.addCapabilityMembers(members, titles, 0x10);
+        F32 unpack_ms = timer.getElapsedTimeF32() * 1000.f;
+
+        ensure_equals("members", mTable.size(), 50000U);
+        ensure_equals("titles interned", mTable.getTitleCount(), 5U);
+        ensure("statuses interned", mTable.getStatusCount() < 3000U);
+
+        U32 owner = mTable.findRow(make_id(0));
+        ensure("owner", owner != FSGroupMemberTable::NO_ROW && mTable.isOwner(owner));
+        ensure_equals("owner title", mTable.getTitle(owner), std::string("Owner"));
+        ensure_equals("owner powers", mTable.getPowers(owner), (U64)0xFFFFFFFFFFFFFFFFULL);
+        for (U32 row = 0; row < mTable.size(); row++)
+        {
+            if (!mTable.isOwner(row))
+            {
+                ensure_equals("default powers", mTable.getPowers(row), (U64)0x10);
+                break;
+            }
+        }
+
+        timer.reset();
+        const std::vector<U32>& sorted = mTable.getSortedRows(FSGroupMemberTable::COL_LAST_LOGIN);
+        F32 sort_ms = timer.getElapsedTimeF32() * 1000.f;
+        ensure_equals("sorted all", (U32)sorted.size(), 50000U);
+
+        timer.reset();
+        std::vector<U32> rows;
+        mTable.getPage(FSGroupMemberTable::COL_LAST_LOGIN, false, 0, 100, rows);
+        F32 page_ms = timer.getElapsedTimeF32() * 1000.f;
+
+        std::cout << std::endl << "FSGroupMemberTable: 50000 members unpacked in " << unpack_ms << " ms ("
+                  << mTable.getStatusCount() << " status strings), sorted by last login in " << sort_ms
+                  << " ms, first page in " << page_ms << " ms" << std::endl;
+    }
+}
@@ -0,0 +1,295 @@
+/**
+ * @file fsimpipeline_test.cpp
+ * @brief IM intake pipeline: transcript writer, update coalescing, stage latency and a burst replay
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+#include "../test/namedtempfile.h"
+
+#include "../fsimpipeline.h"
+
+#include "lltimer.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    std::vector<std::string> read_lines(const std::string& path)
+    {
+        std::vector<std::string> lines;
+        std::ifstream in(path.c_str());
+        std::string line;
+        while (std::getline(in, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // Sequence number at the end of "[time] name: message <n>"
+    S32 sequence_of(const std::string& line)
+    {
+        size_t pos = line.rfind(' ');
+        return pos == std::string::npos ? -1 : atoi(line.c_str() + pos + 1);
+    }
+
+    LLUUID make_session(U32 n)
+    {
+        LLUUID id;
+        id.mData[0] = (U8)(n + 1);
+        id.mData[15] = 0x42;
+        return id;
+    }
+}
+
+namespace tut
+{
+    struct impipeline_data
+    {
+        impipeline_data()
+        {
+            gIMStageStats.reset();
+        }
+    };
+    typedef test_group<impipeline_data> impipeline_t;
+    typedef impipeline_t::object impipeline_object_t;
+    tut::impipeline_t tut_impipeline("FSIMPipeline");
+
+    template<> template<>
+    void impipeline_object_t::test<1>()
+    {
+        set_test_name("Stage latency");
+        FSIMStageStats stats;
+        for (S32 i = 0; i < 99; ++i)
+        {
+            stats.record(FSIM_STAGE_UI, 0.001);     // 1 ms
+        }
+        stats.record(FSIM_STAGE_UI, 0.5);           // one slow frame
+
+        ensure_equals("count", stats.getCount(FSIM_STAGE_UI), 100U);
+        ensure_distance("mean", stats.getMean(FSIM_STAGE_UI), (99 * 0.001 + 0.5) / 100.0, 1e-9);
+        ensure_equals("max", stats.getMax(FSIM_STAGE_UI), 0.5);
+
+        // Percentiles are bucket bounds: at least the sample, less than twice it
+        F64 p50 = stats.getPercentile(FSIM_STAGE_UI, 0.5f);
+        ensure("p50 lower bound", p50 >= 0.001);
+        ensure("p50 upper bound", p50 < 0.002);
+        ensure("p99 is fast", stats.getPercentile(FSIM_STAGE_UI, 0.99f) < 0.002);
+        ensure_equals("p100 is the max", stats.getPercentile(FSIM_STAGE_UI, 1.f), 0.5);
+
+        ensure_equals("other stages empty", stats.getCount(FSIM_STAGE_FILTER), 0U);
+        ensure_equals("empty percentile", stats.getPercentile(FSIM_STAGE_FILTER, 0.5f), 0.0);
+        ensure("summary names stages", stats.getSummary().find("transcript 0 x") != std::string::npos);
+
+        // Intake timers mark the arrival for later stages
+        F64 now = LLTimer::getTotalSeconds();
+        ensure_equals("no arrival outside intake", gIMStageStats.getMessageArrival(now), now);
+        {
+            FSIMStageTimer intake(FSIM_STAGE_INTAKE);
+            ensure("arrival during intake", gIMStageStats.getMessageArrival(now + 10.0) <= LLTimer::getTotalSeconds());
+        }
+        ensure_equals("intake recorded", gIMStageStats.getCount(FSIM_STAGE_INTAKE), 1U);
+        ensure_equals("arrival cleared", gIMStageStats.getMessageArrival(now), now);
+        {
+            FSIMStageTimer untracked(FSIM_STAGE_FILTER, false);
+        }
+        ensure_equals("untracked not recorded", gIMStageStats.getCount(FSIM_STAGE_FILTER), 0U);
+    }
+
+    template<> template<>
+    void impipeline_object_t::test<2>()
+    {
+        set_test_name("Update coalescing");
+        FSIMUpdateCoalescer coalescer;
+        ensure("first add", coalescer.add(make_session(0), 1.0));
+        ensure("second session", coalescer.add(make_session(1), 1.5));
+        ensure("repeat coalesced", !coalescer.add(make_session(0), 2.0));
+        ensure_equals("two pending", coalescer.size(), 2U);
+
+        std::vector<LLUUID> flushed;
+        std::vector<F64> times;
+        U32 count = coalescer.flush([&](const LLUUID& session_id, F64 first_queued)
+        {
+            flushed.push_back(session_id);
+            times.push_back(first_queued);
+            // Messages arriving while updating wait for the next flush
+            coalescer.add(make_session(2), 3.0);
+        });
+        ensure_equals("flushed", count, 2U);
+        ensure("arrival order", flushed[0] == make_session(0) && flushed[1] == make_session(1));
+        ensure_equals("first arrival kept", times[0], 1.0);
+        ensure_equals("added during flush", coalescer.size(), 1U);
+    }
+
+    template<> template<>
+    void impipeline_object_t::test<3>()
+    {
+        set_test_name("Transcript writer order and batching");
+        NamedTempFile group("fsimpipeline_group", "");
+        NamedTempFile p2p("fsimpipeline_p2p", "existing line\n");
+
+        FSTranscriptWriter writer;
+        ensure("nothing pending", !writer.hasPending());
+        for (S32 i = 0; i < 10; ++i)
+        {
+            writer.queue(i % 3 ? group.getName() : p2p.getName(), llformat("line %d", i), 100.0 + i);
+        }
+        ensure("pending", writer.hasPending());
+
+        F64 oldest = 0.0;
+        ensure_equals("written", writer.drain(&oldest), 10U);
+        ensure_equals("oldest queue time", oldest, 100.0);
+        ensure("drained", !writer.hasPending());
+        ensure_equals("second drain is empty", writer.drain(), 0U);
+
+        writer.queue(group.getName(), "line 10", 200.0);
+        writer.drain();
+
+        std::vector<std::string> group_lines = read_lines(group.getName());
+        std::vector<std::string> p2p_lines = read_lines(p2p.getName());
+        ensure_equals("group lines", group_lines.size(), (size_t)7);
+        ensure_equals("p2p lines", p2p_lines.size(), (size_t)5);
+        ensure_equals("appended", p2p_lines[0], std::string("existing line"));
+        ensure_equals("p2p order", p2p_lines[4], std::string("line 9"));
+        for (size_t i = 1; i < group_lines.size(); ++i)
+        {
+            ensure("group order", sequence_of(group_lines[i - 1]) < sequence_of(group_lines[i]));
+        }
+
+        writer.queue("/nonexistent-directory/fsimpipeline/transcript.txt", "lost", 300.0);
+        ensure_equals("unwritable", writer.drain(), 0U);
+        ensure_equals("failed open counted", writer.getFailedOpens(), 1U);
+    }
+
+    template<> template<>
+    void impipeline_object_t::test<4>()
+    {
+        set_test_name("Group chat burst replay");
+        const S32 SESSIONS = 4;             // a busy group and three IMs
+        const S32 FRAMES = 300;             // five seconds at 60 fps
+        const S32 GROUP_PER_FRAME = 80;     // 4800 messages per second
+        const F64 FRAME_TIME = 1.0 / 60.0;
+
+        std::vector<NamedTempFile*> files;
+        for (S32 i = 0; i < SESSIONS; ++i)
+        {
+            files.push_back(new NamedTempFile(llformat("fsimpipeline_replay%d", i), ""));
+        }
+
+        // Stands in for the General work queue, draining as fast as it can
+        FSTranscriptWriter writer;
+        std::atomic<bool> running(true);
+        std::atomic<U32> drained(0);
+        std::thread worker([&]()
+        {
+            while (running)
+            {
+                U32 written = writer.drain();
+                drained += written;
+                if (!written)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        FSIMUpdateCoalescer coalescer;
+        FSIMStageStats stats;
+        std::vector<S32> sequence(SESSIONS, 0);
+        std::vector<S32> updates(SESSIONS, 0);
+        S32 messages = 0;
+        F64 main_thread_seconds = 0.0;
+
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            const F64 frame_start = frame * FRAME_TIME;
+            LLTimer frame_timer;
+            for (S32 session = 0; session < SESSIONS; ++session)
+            {
+                // The group gets the burst, the IMs a message every few frames
+                S32 count = session == 0 ? GROUP_PER_FRAME : (frame % (5 * session) == 0 ? 1 : 0);
+                for (S32 i = 0; i < count; ++i)
+                {
+                    const F64 arrival = frame_start + i * FRAME_TIME / count;
+                    writer.queue(files[session]->getName(),
+                                 llformat("[12:00] Resident %d: message %d", i, sequence[session]++), arrival);
+                    coalescer.add(make_session(session), arrival);
+                    ++messages;
+                }
+            }
+
+            // End of frame: one update per session that got anything
+            const F64 frame_end = frame_start + FRAME_TIME;
+            coalescer.flush([&](const LLUUID& session_id, F64 first_queued)
+            {
+                ++updates[session_id.mData[0] - 1];
+                stats.record(FSIM_STAGE_UI, frame_end - first_queued);
+            });
+            main_thread_seconds += frame_timer.getElapsedTimeF64();
+        }
+
+        // Let the worker catch up, then stop it
+        LLTimer wait;
+        while (drained < (U32)messages && wait.getElapsedTimeF32() < 10.f)
+        {
+            std::this_thread::yield();
+        }
+        running = false;
+        worker.join();
+        writer.drain();
+
+        ensure_equals("every message written", (S32)drained, messages);
+        ensure_equals("group updated once per frame", updates[0], FRAMES);
+        for (S32 session = 1; session < SESSIONS; ++session)
+        {
+            ensure_equals("IM updated per message", updates[session], sequence[session]);
+        }
+        ensure("UI latency within a frame", stats.getMax(FSIM_STAGE_UI) <= FRAME_TIME + 1e-9);
+
+        for (S32 session = 0; session < SESSIONS; ++session)
+        {
+            std::vector<std::string> lines = read_lines(files[session]->getName());
+            ensure_equals("lines in file", (S32)lines.size(), sequence[session]);
+            for (size_t i = 0; i < lines.size(); ++i)
+            {
+                if (sequence_of(lines[i]) != (S32)i)
+                {
+                    fail(llformat("session %d line %d out of order: %s", session, (S32)i, lines[i].c_str()));
+                }
+            }
+            delete files[session];
+        }
+
+        std::cout << std::endl << "FSIMPipeline replay: " << messages << " messages in " << FRAMES << " frames ("
+                  << messages / (FRAMES * FRAME_TIME) << "/s), " << updates[0] << " group updates instead of "
+                  << sequence[0] << ", main thread " << main_thread_seconds * 1000.0 / messages * 1000.0
+                  << " us per message" << std::endl;
+    }
+}
@@ -0,0 +1,247 @@
+/**
+ * @file fsinventoryfetchqueue_test.cpp
+ * @brief Tests of the prioritized inventory fetch queue
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsinventoryfetchqueue.h"
+
+#include <map>
+
+namespace
+{
+    struct Entry
+    {
+        S32 mID;
+        S32 mPriority;
+    };
+
+    Entry make_entry(S32 id, S32 priority)
+    {
+        Entry entry = { id, priority };
+        return entry;
+    }
+
+    S32 entry_priority(const Entry& entry)
+    {
+        return entry.mPriority;
+    }
+
+    typedef FSPriorityFetchQueue<Entry> queue_t;
+
+    // A synthetic account: folders are numbered breadth first, every folder
+    // but the leaves has `fanout` children. Some subtree is the outfits.
+    struct Account
+    {
+        S32 mFanout;
+        S32 mFolders;
+        S32 mOutfitsRoot;
+
+        S32 parent(S32 id) const { return id ? (id - 1) / mFanout : -1; }
+
+        bool isOutfit(S32 id) const
+        {
+            for (; id >= 0; id = parent(id))
+            {
+                if (id == mOutfitsRoot)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Fetches the whole account, `concurrency` folders per tick, and returns
+    // the tick at which the last outfit folder arrived
+    S32 ticks_until_outfits(const Account& account, S32 concurrency, bool prioritized)
+    {
+        queue_t queue;
+        if (prioritized)
+        {
+            queue.setPriorityFunction([&account](const Entry& entry)
+                {
+                    return account.isOutfit(entry.mID) ? (S32)FSFP_OUTFITS : (S32)FSFP_INVENTORY;
+                });
+        }
+
+        S32 outfits_left = 0;
+        for (S32 id = 0; id < account.mFolders; ++id)
+        {
+            outfits_left += account.isOutfit(id) ? 1 : 0;
+        }
+
+        queue.push_back(make_entry(0, 0));
+        S32 tick = 0;
+        while (!queue.empty() && outfits_left > 0)
+        {
+            ++tick;
+            for (S32 i = 0; i < concurrency && !queue.empty(); ++i)
+            {
+                S32 id = queue.front().mID;
+                queue.pop_front();
+                outfits_left -= account.isOutfit(id) ? 1 : 0;
+                for (S32 child = id * account.mFanout + 1; child <= id * account.mFanout + account.mFanout; ++child)
+                {
+                    if (child < account.mFolders)
+                    {
+                        queue.push_back(make_entry(child, 0));
+                    }
+                }
+            }
+        }
+        return tick;
+    }
+}
+
+namespace tut
+{
+    struct fetchqueue_data
+    {
+        queue_t mQueue;
+
+        fetchqueue_data()
+        {
+            mQueue.setPriorityFunction(entry_priority);
+        }
+    };
+    typedef test_group<fetchqueue_data> fetchqueue_t;
+    typedef fetchqueue_t::object fetchqueue_object_t;
+    tut::fetchqueue_t tut_fetchqueue("FSPriorityFetchQueue");
+
+    template<> template<>
+    void fetchqueue_object_t::test<1>()
+    {
+        set_test_name("Most urgent level first");
+        mQueue.push_back(make_entry(1, FSFP_LIBRARY));
+        mQueue.push_back(make_entry(2, FSFP_INVENTORY));
+        mQueue.push_back(make_entry(3, FSFP_REQUESTED));
+        mQueue.push_back(make_entry(4, FSFP_OUTFITS));
+        mQueue.push_back(make_entry(5, 99));    // clamped to the least urgent level
+
+        ensure_equals("size", (S32)mQueue.size(), 5);
+        ensure_equals("requested first", mQueue.front().mID, 3);
+        ensure_equals("front priority", mQueue.frontPriority(), (S32)FSFP_REQUESTED);
+        mQueue.pop_front();
+        ensure_equals("outfits next", mQueue.front().mID, 4);
+        mQueue.pop_front();
+        ensure_equals("inventory next", mQueue.front().mID, 2);
+        mQueue.pop_front();
+        ensure_equals("library last", mQueue.front().mID, 1);
+        mQueue.pop_front();
+        ensure_equals("clamped entry", mQueue.front().mID, 5);
+        mQueue.pop_front();
+        ensure("empty", mQueue.empty());
+    }
+
+    template<> template<>
+    void fetchqueue_object_t::test<2>()
+    {
+        set_test_name("Order within a level");
+        mQueue.push_back(make_entry(1, FSFP_INVENTORY));
+        mQueue.push_back(make_entry(2, FSFP_INVENTORY));
+        mQueue.push_front(make_entry(3, FSFP_INVENTORY));
+        mQueue.push_back(make_entry(4, FSFP_LIBRARY));
+        ensure_equals("back is last pushed back", mQueue.back().mID, 4);
+        mQueue.push_back(make_entry(5, FSFP_INVENTORY));
+        ensure_equals("back follows the level", mQueue.back().mID, 5);
+
+        ensure_equals("push_front goes first", mQueue.front().mID, 3);
+        mQueue.pop_front();
+        ensure_equals("then fifo", mQueue.front().mID, 1);
+        mQueue.pop_front();
+        ensure_equals("fifo", mQueue.front().mID, 2);
+        ensure_equals("level size", (S32)mQueue.size(FSFP_INVENTORY), 2);
+    }
+
+    template<> template<>
+    void fetchqueue_object_t::test<3>()
+    {
+        set_test_name("Taking batches");
+        for (S32 id = 0; id < 20; ++id)
+        {
+            mQueue.push_back(make_entry(id, FSFP_INVENTORY));
+        }
+        mQueue.push_back(make_entry(100, FSFP_LIBRARY));
+
+        std::vector<Entry> batch;
+        mQueue.takeMatching([](const Entry& entry) { return entry.mID % 2 == 0; }, 10, 3, batch);
+        ensure_equals("count limited", (S32)batch.size(), 3);
+        ensure_equals("first match", batch[0].mID, 0);
+        ensure_equals("last match", batch[2].mID, 4);
+        ensure_equals("removed", (S32)mQueue.size(), 18);
+        ensure_equals("rest keeps order", mQueue.front().mID, 1);
+
+        batch.clear();
+        // Looks at 1, 3, 5, 6, 7, 8 only
+        mQueue.takeMatching([](const Entry& entry) { return entry.mID % 2 == 0; }, 6, 100, batch);
+        ensure_equals("scan limited", (S32)batch.size(), 2);
+        ensure_equals("scan limited last match", batch[1].mID, 8);
+
+        batch.clear();
+        mQueue.takeMatching([](const Entry& entry) { return entry.mID == 100; }, 100, 100, batch);
+        ensure("only the most urgent level", batch.empty());
+    }
+
+    template<> template<>
+    void fetchqueue_object_t::test<4>()
+    {
+        set_test_name("Reprioritizing");
+        std::map<S32, S32> priorities;
+        mQueue.setPriorityFunction([&priorities](const Entry& entry) { return priorities[entry.mID]; });
+        for (S32 id = 0; id < 6; ++id)
+        {
+            priorities[id] = FSFP_INVENTORY;
+            mQueue.push_back(make_entry(id, 0));
+        }
+
+        // A search starts below folders 3 and 5
+        priorities[3] = FSFP_SEARCH;
+        priorities[5] = FSFP_SEARCH;
+        ensure_equals("nothing moves by itself", mQueue.front().mID, 0);
+        mQueue.reprioritize();
+        ensure_equals("size kept", (S32)mQueue.size(), 6);
+        ensure_equals("search first", mQueue.front().mID, 3);
+        mQueue.pop_front();
+        ensure_equals("search in order", mQueue.front().mID, 5);
+        mQueue.pop_front();
+        ensure_equals("then the rest in order", mQueue.front().mID, 0);
+    }
+
+    template<> template<>
+    void fetchqueue_object_t::test<5>()
+    {
+        set_test_name("Outfits of a large account arrive early");
+        // 11111 folders, the outfits are a subtree found late breadth first
+        Account account = { 10, 11111, 9 };
+        S32 fifo = ticks_until_outfits(account, 19, false);
+        S32 prioritized = ticks_until_outfits(account, 19, true);
+        ensure("fifo needs most of the account", fifo * 19 > account.mFolders / 2);
+        ensure("prioritized at least five times sooner", prioritized * 5 <= fifo);
+    }
+}
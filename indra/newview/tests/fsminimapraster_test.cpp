@@ -0,0 +1,297 @@
+/**
+ * @file fsminimapraster_test.cpp
+ * @brief Minimap object layer footprints and incremental tile rasterizer
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsminimapraster.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    const S32 IMAGE_SIZE = 256;
+
+    // Small deterministic generator, the same scene on every platform
+    struct SceneRandom
+    {
+        U32 mState;
+        SceneRandom(U32 seed) : mState(seed) {}
+        F64 next()
+        {
+            mState = mState * 1664525u + 1013904223u;
+            return (F64)(mState >> 8) / (F64)(1 << 24);
+        }
+    };
+
+    // A recorded object list: global position, radius and map color of
+    // every object in a square of regions from (256000, 256000) on
+    std::vector<FSMinimapFootprint> record_objects(S32 count, U32 seed, bool one_color, F64 extent = 512.0)
+    {
+        SceneRandom random(seed);
+        std::vector<FSMinimapFootprint> objects;
+        for (S32 i = 0; i < count; ++i)
+        {
+            FSMinimapFootprint footprint;
+            footprint.mX = 256000.0 + random.next() * extent;
+            footprint.mY = 256000.0 + random.next() * extent;
+            footprint.mRadius = (F32)(1.0 + random.next() * random.next() * 12.0);
+            footprint.mColor = one_color ? 0xFF00FFFF : 0xFF000000 | (U32)(random.next() * 0xFFFFFF);
+            objects.push_back(footprint);
+        }
+        return objects;
+    }
+
+    void set_all(FSMinimapFootprints& footprints, const std::vector<FSMinimapFootprint>& objects)
+    {
+        footprints.beginPass();
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            footprints.set(&objects[i], objects[i]);
+        }
+        footprints.endPass();
+    }
+
+    // Every pixel whose center any footprint covers, one pixel at a time
+    std::vector<U32> reference_image(const std::vector<FSMinimapFootprint>& objects, F64 center_x, F64 center_y, F32 ppm)
+    {
+        std::vector<U32> image(IMAGE_SIZE * IMAGE_SIZE, 0);
+        const S64 origin_x = (S64)floor(center_x * ppm + 0.5) - IMAGE_SIZE / 2;
+        const S64 origin_y = (S64)floor(center_y * ppm + 0.5) - IMAGE_SIZE / 2;
+        for (const FSMinimapFootprint& object : objects)
+        {
+            for (S32 row = 0; row < IMAGE_SIZE; ++row)
+            {
+                F64 center = origin_y + row + 0.5;
+                if (center < (object.mY - object.mRadius) * ppm || center >= (object.mY + object.mRadius) * ppm)
+                {
+                    continue;
+                }
+                for (S32 column = 0; column < IMAGE_SIZE; ++column)
+                {
+                    center = origin_x + column + 0.5;
+                    if (center >= (object.mX - object.mRadius) * ppm && center < (object.mX + object.mRadius) * ppm)
+                    {
+                        image[row * IMAGE_SIZE + column] = object.mColor;
+                    }
+                }
+            }
+        }
+        return image;
+    }
+
+    std::vector<U32> fresh_image(const FSMinimapFootprints& footprints, F64 center_x, F64 center_y, F32 ppm)
+    {
+        std::vector<U32> image(IMAGE_SIZE * IMAGE_SIZE, 0xDEADBEEF);
+        FSMinimapRaster raster;
+        raster.setView(center_x, center_y, ppm, IMAGE_SIZE, IMAGE_SIZE);
+        S32 left, bottom, right, top;
+        raster.update(footprints, &image[0], left, bottom, right, top);
+        return image;
+    }
+
+    S32 count_differences(const std::vector<U32>& a, const std::vector<U32>& b)
+    {
+        S32 count = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            count += a[i] != b[i];
+        }
+        return count;
+    }
+
+    typedef std::chrono::steady_clock bench_clock_t;
+
+    F64 elapsed_ms(const bench_clock_t::time_point& start)
+    {
+        return std::chrono::duration<F64, std::milli>(bench_clock_t::now() - start).count();
+    }
+}
+
+namespace tut
+{
+    struct minimapraster_data
+    {
+    };
+    typedef test_group<minimapraster_data> minimapraster_t;
+    typedef minimapraster_t::object minimapraster_object_t;
+    tut::minimapraster_t tut_minimapraster("FSMinimapRaster");
+
+    template<> template<>
+    void minimapraster_object_t::test<1>()
+    {
+        set_test_name("Tile revisions");
+        FSMinimapFootprints footprints;
+        FSMinimapFootprint object = { 100.0, 100.0, 2.f, 0xFFFFFFFF };
+        S32 tile = FSMinimapFootprints::tileIndex(100.0);
+        ensure_equals("empty tile", footprints.getTileRevision(tile, tile), (U32)0);
+
+        footprints.set(&object, object);
+        U32 revision = footprints.getTileRevision(tile, tile);
+        ensure("added", revision != 0);
+        footprints.set(&object, object);
+        ensure_equals("unchanged set", footprints.getTileRevision(tile, tile), revision);
+
+        FSMinimapFootprint moved = object;
+        moved.mX += 1.0;
+        footprints.set(&object, moved);
+        ensure("moved", footprints.getTileRevision(tile, tile) != revision);
+
+        // Far away tiles never see it
+        ensure_equals("far tile", footprints.getTileRevision(tile + 3, tile), (U32)0);
+
+        // Not set again during a pass, gone
+        footprints.beginPass();
+        footprints.endPass();
+        ensure_equals("swept", footprints.size(), (size_t)0);
+        ensure_equals("tile emptied", footprints.getTileRevision(tile, tile), (U32)0);
+    }
+
+    template<> template<>
+    void minimapraster_object_t::test<2>()
+    {
+        set_test_name("Matches the per pixel reference");
+        std::vector<FSMinimapFootprint> objects = record_objects(400, 7, true);
+        FSMinimapFootprints footprints;
+        set_all(footprints, objects);
+
+        const F32 scales[] = { 0.5f, 1.f, 2.f };
+        for (F32 ppm : scales)
+        {
+            std::vector<U32> image = fresh_image(footprints, 256256.0, 256256.0, ppm);
+            std::vector<U32> reference = reference_image(objects, 256256.0, 256256.0, ppm);
+            ensure_equals("pixels differing from reference", count_differences(image, reference), 0);
+        }
+    }
+
+    template<> template<>
+    void minimapraster_object_t::test<3>()
+    {
+        set_test_name("Incremental updates and panning match a full redraw");
+        std::vector<FSMinimapFootprint> objects = record_objects(1500, 11, false);
+        FSMinimapFootprints footprints;
+        set_all(footprints, objects);
+
+        const F32 ppm = 1.f;
+        FSMinimapRaster raster;
+        std::vector<U32> image(IMAGE_SIZE * IMAGE_SIZE, 0);
+        S32 left, bottom, right, top;
+        F64 center_x = 256200.0, center_y = 256250.0;
+
+        SceneRandom random(3);
+        for (S32 step = 0; step < 40; ++step)
+        {
+            // Some objects move, change color or vanish, the camera pans
+            for (S32 i = 0; i < 20; ++i)
+            {
+                FSMinimapFootprint& object = objects[(size_t)(random.next() * objects.size())];
+                object.mX += random.next() * 4.0 - 2.0;
+                object.mY += random.next() * 4.0 - 2.0;
+                if (i % 5 == 0)
+                {
+                    object.mColor ^= 0x00FF00;
+                }
+            }
+            if (step % 10 == 9)
+            {
+                objects.pop_back();
+            }
+            set_all(footprints, objects);
+            if (step % 3 == 0)
+            {
+                center_x += random.next() * 20.0 - 7.0;
+                center_y += random.next() * 10.0 - 3.0;
+            }
+
+            raster.setView(center_x, center_y, ppm, IMAGE_SIZE, IMAGE_SIZE);
+            raster.update(footprints, &image[0], left, bottom, right, top);
+            ensure("full redraws only on the first update", step == 0 || raster.getTilesDrawn() < 256);
+
+            std::vector<U32> expected = fresh_image(footprints, center_x, center_y, ppm);
+            ensure_equals("pixels differing from a full redraw", count_differences(image, expected), 0);
+        }
+
+        // Nothing changed, nothing drawn
+        set_all(footprints, objects);
+        ensure("unchanged", !raster.update(footprints, &image[0], left, bottom, right, top));
+        ensure_equals("no tiles drawn", raster.getTilesDrawn(), 0);
+    }
+
+    template<> template<>
+    void minimapraster_object_t::test<4>()
+    {
+        set_test_name("Object layer refresh benchmark");
+        const S32 counts[] = { 2000, 10000, 40000 };
+        const S32 REFRESHES = 20;
+        const S32 MOVING = 25;  // vehicles and physical objects
+        for (S32 count : counts)
+        {
+            // 4x4 regions, the whole area in view at half a pixel per meter
+            std::vector<FSMinimapFootprint> objects = record_objects(count, 5, false, 1024.0);
+            FSMinimapFootprints footprints;
+            set_all(footprints, objects);
+
+            FSMinimapRaster full, incremental;
+            std::vector<U32> full_image(IMAGE_SIZE * IMAGE_SIZE * 4, 0);
+            std::vector<U32> incremental_image(IMAGE_SIZE * IMAGE_SIZE * 4, 0);
+            full.setView(256512.0, 256512.0, 0.5f, IMAGE_SIZE * 2, IMAGE_SIZE * 2);
+            incremental.setView(256512.0, 256512.0, 0.5f, IMAGE_SIZE * 2, IMAGE_SIZE * 2);
+            S32 left, bottom, right, top;
+            incremental.update(footprints, &incremental_image[0], left, bottom, right, top);
+
+            SceneRandom random(9);
+            F64 full_ms = 0.0, incremental_ms = 0.0;
+            S64 upload_pixels = 0;
+            for (S32 refresh = 0; refresh < REFRESHES; ++refresh)
+            {
+                for (S32 i = 0; i < MOVING; ++i)
+                {
+                    objects[i * 7].mX += random.next() * 4.0 - 2.0;
+                }
+                set_all(footprints, objects);
+
+                bench_clock_t::time_point start = bench_clock_t::now();
+                full.invalidate();
+                full.update(footprints, &full_image[0], left, bottom, right, top);
+                full_ms += elapsed_ms(start);
+
+                start = bench_clock_t::now();
+                if (incremental.update(footprints, &incremental_image[0], left, bottom, right, top))
+                {
+                    upload_pixels += (S64)(right - left) * (top - bottom);
+                }
+                incremental_ms += elapsed_ms(start);
+            }
+            ensure("same image", full_image == incremental_image);
+            std::cout << "FSMinimapRaster: " << count << " objects, " << MOVING << " moving, full redraw " << full_ms / REFRESHES
+                      << " ms, incremental " << incremental_ms / REFRESHES << " ms, uploaded "
+                      << upload_pixels * 100 / ((S64)REFRESHES * IMAGE_SIZE * IMAGE_SIZE * 4) << "% of the image" << std::endl;
+        }
+    }
+}
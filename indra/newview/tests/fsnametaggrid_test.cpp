@@ -0,0 +1,239 @@
+/**
+ * @file fsnametaggrid_test.cpp
+ * @brief Name tag overlap grid against pairwise tests, with timings over tag counts
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsnametaggrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    const F32 SCREEN_WIDTH = 1920.f;
+    const F32 SCREEN_HEIGHT = 1080.f;
+    const F32 MARGIN = 2.f;
+    const S32 ITERATIONS = 10;
+
+    // Small deterministic generator, the same scene on every platform
+    struct SceneRandom
+    {
+        U32 mState;
+        SceneRandom(U32 seed) : mState(seed) {}
+        F32 next()
+        {
+            mState = mState * 1664525u + 1013904223u;
+            return (F32)(mState >> 8) / (F32)(1 << 24);
+        }
+    };
+
+    // Name tags of an event: most of the crowd around the stage in the
+    // middle of the screen, the rest spread out
+    std::vector<LLRectf> make_tags(S32 count, U32 seed)
+    {
+        SceneRandom random(seed);
+        std::vector<LLRectf> tags;
+        for (S32 i = 0; i < count; ++i)
+        {
+            F32 width = 80.f + random.next() * 218.f;
+            F32 height = 30.f + random.next() * 30.f;
+            F32 x, y;
+            if (i % 3)
+            {
+                x = SCREEN_WIDTH * (0.3f + 0.4f * random.next());
+                y = SCREEN_HEIGHT * (0.3f + 0.4f * random.next());
+            }
+            else
+            {
+                x = SCREEN_WIDTH * random.next();
+                y = SCREEN_HEIGHT * random.next();
+            }
+            LLRectf rect;
+            rect.setCenterAndSize(x, y, width, height);
+            tags.push_back(rect);
+        }
+        return tags;
+    }
+
+    void find_pairwise(const std::vector<LLRectf>& rects, FSNameTagGrid::pair_list_t& pairs)
+    {
+        pairs.clear();
+        for (S32 i = 0; i < (S32)rects.size(); ++i)
+        {
+            LLRectf first = rects[i];
+            first.stretch(MARGIN);
+            for (S32 j = i + 1; j < (S32)rects.size(); ++j)
+            {
+                LLRectf second = rects[j];
+                second.stretch(MARGIN);
+                if (first.overlaps(second))
+                {
+                    pairs.push_back(FSNameTagGrid::index_pair_t(i, j));
+                }
+            }
+        }
+    }
+
+    // Stand-in for the force step: pushes each overlapping pair apart
+    // horizontally by half their overlap
+    void separate(std::vector<LLRectf>& rects, const FSNameTagGrid::pair_list_t& pairs)
+    {
+        for (FSNameTagGrid::pair_list_t::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+        {
+            LLRectf& src = rects[it->first];
+            LLRectf& dst = rects[it->second];
+            if (!src.overlaps(dst))
+            {
+                continue;
+            }
+            F32 overlap = llmin(src.mRight, dst.mRight) - llmax(src.mLeft, dst.mLeft);
+            F32 push = (src.getCenterX() < dst.getCenterX() ? 0.25f : -0.25f) * overlap;
+            src.translate(-push, 0.f);
+            dst.translate(push, 0.f);
+        }
+    }
+
+    // Runs the overlap passes of one frame, returns the microseconds spent
+    // finding overlaps
+    F64 run_frame(std::vector<LLRectf>& rects, bool use_grid, FSNameTagGrid& grid, size_t& overlaps)
+    {
+        FSNameTagGrid::pair_list_t pairs;
+        F64 elapsed = 0.0;
+        overlaps = 0;
+        for (S32 i = 0; i < ITERATIONS; ++i)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (use_grid)
+            {
+                grid.findOverlaps(rects, MARGIN, pairs);
+            }
+            else
+            {
+                find_pairwise(rects, pairs);
+            }
+            elapsed += std::chrono::duration<F64, std::micro>(std::chrono::steady_clock::now() - start).count();
+            overlaps += pairs.size();
+            separate(rects, pairs);
+        }
+        return elapsed;
+    }
+}
+
+namespace tut
+{
+    struct nametaggrid_data
+    {
+        FSNameTagGrid mGrid;
+        FSNameTagGrid::pair_list_t mPairs;
+    };
+    typedef test_group<nametaggrid_data> nametaggrid_t;
+    typedef nametaggrid_t::object nametaggrid_object_t;
+    tut::nametaggrid_t tut_nametaggrid("FSNameTagGrid");
+
+    template<> template<>
+    void nametaggrid_object_t::test<1>()
+    {
+        set_test_name("Nothing to overlap");
+        std::vector<LLRectf> rects;
+        mGrid.findOverlaps(rects, MARGIN, mPairs);
+        ensure("empty", mPairs.empty());
+
+        rects.push_back(LLRectf(0.f, 20.f, 100.f, 0.f));
+        mGrid.findOverlaps(rects, MARGIN, mPairs);
+        ensure("single", mPairs.empty());
+
+        rects.push_back(LLRectf(500.f, 20.f, 600.f, 0.f));
+        mGrid.findOverlaps(rects, MARGIN, mPairs);
+        ensure("apart", mPairs.empty());
+    }
+
+    template<> template<>
+    void nametaggrid_object_t::test<2>()
+    {
+        set_test_name("Margin and shared edges");
+        std::vector<LLRectf> rects;
+        rects.push_back(LLRectf(0.f, 20.f, 100.f, 0.f));
+        rects.push_back(LLRectf(103.f, 20.f, 200.f, 0.f));  // 3 pixels apart, closer than two margins
+        rects.push_back(LLRectf(210.f, 20.f, 300.f, 0.f));
+        rects.push_back(LLRectf(0.f, 1000.f, 1900.f, 22.f)); // spans many cells
+        mGrid.findOverlaps(rects, MARGIN, mPairs);
+
+        ensure_equals("pairs", (S32)mPairs.size(), 4);
+        ensure("margin counts", mPairs[0] == FSNameTagGrid::index_pair_t(0, 1));
+        ensure("large rect once per neighbour", mPairs[1] == FSNameTagGrid::index_pair_t(0, 3));
+        ensure("ordered", mPairs[2] == FSNameTagGrid::index_pair_t(1, 3));
+        ensure("last", mPairs[3] == FSNameTagGrid::index_pair_t(2, 3));
+    }
+
+    template<> template<>
+    void nametaggrid_object_t::test<3>()
+    {
+        set_test_name("Same pairs as the pairwise test");
+        FSNameTagGrid::pair_list_t expected;
+        for (U32 seed = 1; seed <= 20; ++seed)
+        {
+            std::vector<LLRectf> rects = make_tags(10 * seed, seed);
+            find_pairwise(rects, expected);
+            mGrid.findOverlaps(rects, MARGIN, mPairs);
+            ensure_equals("pair count", mPairs.size(), expected.size());
+            ensure("same pairs in the same order", mPairs == expected);
+        }
+    }
+
+    template<> template<>
+    void nametaggrid_object_t::test<4>()
+    {
+        set_test_name("Update time over tag counts");
+        const S32 counts[] = { 25, 50, 100, 200, 400, 800 };
+        for (size_t i = 0; i < LL_ARRAY_SIZE(counts); ++i)
+        {
+            const S32 count = counts[i];
+            std::vector<LLRectf> pairwise_rects = make_tags(count, 42);
+            std::vector<LLRectf> grid_rects = pairwise_rects;
+
+            size_t overlaps = 0;
+            F64 pairwise_us = run_frame(pairwise_rects, false, mGrid, overlaps);
+            F64 grid_us = run_frame(grid_rects, true, mGrid, overlaps);
+            std::cout << "name tags " << count << ": pairwise " << pairwise_us << " us, grid " << grid_us
+                      << " us, " << mGrid.getTestCount() << " of " << count * (count - 1) / 2 << " pairs tested, "
+                      << overlaps / ITERATIONS << " overlaps per pass" << std::endl;
+
+            // Both resolve the frame the same way
+            for (S32 tag = 0; tag < count; ++tag)
+            {
+                ensure_equals("same result", grid_rects[tag].mLeft, pairwise_rects[tag].mLeft);
+            }
+            if (count >= 200)
+            {
+                ensure("grid tests a fraction of all pairs", mGrid.getTestCount() * 4 < count * (count - 1) / 2);
+            }
+        }
+    }
+}
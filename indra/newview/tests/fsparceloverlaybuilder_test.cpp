@@ -0,0 +1,302 @@
+/**
+ * @file fsparceloverlaybuilder_test.cpp
+ * @brief Parcel overlay texture and property line generation off the main thread
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsparceloverlaybuilder.h"
+
+#include "llparcel.h"
+#include "lltimer.h"
+
+#include <iostream>
+#include <set>
+#include <utility>
+
+namespace
+{
+    const S32 GRIDS = 64;           // 256m region
+    const S32 SURFACE_GRIDS = 257;  // one meter per grid plus the north and east buffer
+
+    // A region cut into four parcels along x = 128m and y = 128m, the
+    // north east one for sale
+    std::vector<U8> make_quadrants()
+    {
+        std::vector<U8> ownership(GRIDS * GRIDS, PARCEL_OWNED);
+        for (S32 row = 0; row < GRIDS; row++)
+        {
+            for (S32 col = 0; col < GRIDS; col++)
+            {
+                U8& cell = ownership[row * GRIDS + col];
+                if (row >= GRIDS / 2 && col >= GRIDS / 2)
+                {
+                    cell = PARCEL_FOR_SALE;
+                }
+                if (col == 0 || col == GRIDS / 2)
+                {
+                    cell |= PARCEL_WEST_LINE;
+                }
+                if (row == 0 || row == GRIDS / 2)
+                {
+                    cell |= PARCEL_SOUTH_LINE;
+                }
+            }
+        }
+        return ownership;
+    }
+
+    // Ground sloping up to the north east, crossing the water at 20.5m
+    std::vector<F32> make_slope()
+    {
+        std::vector<F32> heights(SURFACE_GRIDS * SURFACE_GRIDS);
+        for (S32 j = 0; j < SURFACE_GRIDS; j++)
+        {
+            for (S32 i = 0; i < SURFACE_GRIDS; i++)
+            {
+                heights[i + j * SURFACE_GRIDS] = 0.1f * i + 0.05f * j;
+            }
+        }
+        return heights;
+    }
+
+    typedef std::pair<S32, S32> grid_point_t;
+    typedef std::pair<grid_point_t, grid_point_t> unit_line_t;
+
+    // Unit borders the minimap used to draw, one cell at a time
+    std::set<unit_line_t> reference_minimap_lines(const std::vector<U8>& ownership)
+    {
+        std::set<unit_line_t> lines;
+        for (S32 i = 0; i <= GRIDS; i++)
+        {
+            for (S32 j = 0; j <= GRIDS; j++)
+            {
+                const bool is_region_boundary = i == GRIDS || j == GRIDS;
+                const U8   overlay            = is_region_boundary ? 0 : ownership[(i * GRIDS) + j];
+                const bool has_left   = i != GRIDS && (j == GRIDS || (overlay & PARCEL_WEST_LINE));
+                const bool has_bottom = j != GRIDS && (i == GRIDS || (overlay & PARCEL_SOUTH_LINE));
+                if (has_left)
+                {
+                    lines.insert(unit_line_t(grid_point_t(j, i), grid_point_t(j, i + 1)));
+                }
+                if (has_bottom)
+                {
+                    lines.insert(unit_line_t(grid_point_t(j, i), grid_point_t(j + 1, i)));
+                }
+            }
+        }
+        return lines;
+    }
+
+    std::set<unit_line_t> split_segments(const std::vector<FSParcelLineSegment>& segments)
+    {
+        std::set<unit_line_t> lines;
+        for (const FSParcelLineSegment& segment : segments)
+        {
+            S32 dx = segment.mEndX > segment.mStartX ? 1 : 0;
+            S32 dy = segment.mEndY > segment.mStartY ? 1 : 0;
+            S32 x = segment.mStartX;
+            S32 y = segment.mStartY;
+            while (x < segment.mEndX || y < segment.mEndY)
+            {
+                lines.insert(unit_line_t(grid_point_t(x, y), grid_point_t(x + dx, y + dy)));
+                x += dx;
+                y += dy;
+            }
+        }
+        return lines;
+    }
+}
+
+namespace tut
+{
+    struct parceloverlaybuilder_data
+    {
+        FSParcelOverlayInput mInput;
+        std::vector<F32> mSurface;
+
+        parceloverlaybuilder_data()
+        :   mSurface(make_slope())
+        {
+            mInput.mVersion = 7;
+            mInput.mGridsPerEdge = GRIDS;
+            mInput.mOwnership = make_quadrants();
+            for (S32 i = 0; i < FS_PARCEL_COLOR_COUNT; i++)
+            {
+                mInput.mColors[i].setVec(10 * i, 20 * i, 30 * i, 255);
+            }
+            mInput.mBuildLines = true;
+            mInput.mWaterHeight = 20.5f;
+            mInput.mHeights.assign(mSurface.data(), SURFACE_GRIDS, 1.f);
+        }
+    };
+    typedef test_group<parceloverlaybuilder_data> parceloverlaybuilder_t;
+    typedef parceloverlaybuilder_t::object parceloverlaybuilder_object_t;
+    tut::parceloverlaybuilder_t tut_parceloverlaybuilder("FSParcelOverlayBuilder");
+
+    template<> template<>
+    void parceloverlaybuilder_object_t::test<1>()
+    {
+        set_test_name("Height field copy");
+        const FSParcelHeightField& field = mInput.mHeights;
+        // The slope is planar, so both triangles of every square interpolate it exactly
+        ensure_distance("grid point", field.resolveHeight(10.f, 20.f), 2.f, 0.0001f);
+        ensure_distance("triangle 1", field.resolveHeight(10.25f, 20.75f), 0.1f * 10.25f + 0.05f * 20.75f, 0.0001f);
+        ensure_distance("triangle 2", field.resolveHeight(10.75f, 20.25f), 0.1f * 10.75f + 0.05f * 20.25f, 0.0001f);
+        ensure_distance("north east corner", field.resolveHeight(256.f, 256.f), 0.1f * 256.f + 0.05f * 256.f, 0.0001f);
+        ensure_equals("outside", field.resolveHeight(-1.f, 10.f), 0.f);
+        ensure_equals("beyond the edge", field.resolveHeight(10.f, 256.5f), 0.f);
+
+        FSParcelHeightField empty;
+        ensure("empty", empty.isEmpty());
+        ensure_equals("empty resolves to zero", empty.resolveHeight(10.f, 10.f), 0.f);
+    }
+
+    template<> template<>
+    void parceloverlaybuilder_object_t::test<2>()
+    {
+        set_test_name("Overlay pixels");
+        mInput.mOwnership[0] = PARCEL_AUCTION | PARCEL_WEST_LINE | PARCEL_SOUTH_LINE;
+        mInput.mOwnership[1] = 0x06;    // not a known ownership
+        FSParcelOverlayResult result;
+        fs_build_parcel_overlay(mInput, result);
+
+        ensure_equals("version", result.mVersion, 7U);
+        ensure_equals("pixel bytes", result.mPixels.size(), (size_t)(GRIDS * GRIDS * 4));
+        ensure_equals("auction red", result.mPixels[0], mInput.mColors[PARCEL_AUCTION].mV[VRED]);
+        ensure_equals("unknown uses its slot", result.mPixels[4 + 1], mInput.mColors[6].mV[VGREEN]);
+        const S32 for_sale = (GRIDS - 1) * GRIDS + GRIDS - 1;
+        ensure_equals("for sale blue", result.mPixels[for_sale * 4 + 2], mInput.mColors[PARCEL_FOR_SALE].mV[VBLUE]);
+        ensure_equals("alpha", result.mPixels[for_sale * 4 + 3], (U8)255);
+    }
+
+    template<> template<>
+    void parceloverlaybuilder_object_t::test<3>()
+    {
+        set_test_name("Property lines follow the ground");
+        FSParcelOverlayResult result;
+        fs_build_parcel_overlay(mInput, result);
+        ensure("lines built", result.mHasLines);
+
+        // Every parcel draws its own side of each border: the region edges
+        // once, the two inner borders from both sides
+        const size_t expected = 4 * GRIDS + 2 * 2 * GRIDS;
+        ensure_equals("edges", result.mEdges.size(), expected);
+
+        S32 split_edges = 0;
+        for (const FSParcelOverlayEdge& edge : result.mEdges)
+        {
+            for (const LLVector3& vertex : edge.vertices)
+            {
+                // The last square before the buffer is flattened like on the surface
+                if (vertex.mV[VX] < 255.f && vertex.mV[VY] < 255.f)
+                {
+                    ensure_distance("on the ground", vertex.mV[VZ], 0.1f * vertex.mV[VX] + 0.05f * vertex.mV[VY], 0.001f);
+                }
+            }
+            if (edge.vertices.size() > 2 * PARCEL_GRID_STEP_METERS + 4)
+            {
+                ++split_edges;
+            }
+        }
+        // Strips crossing the shore line get extra vertices
+        ensure("split at the water", split_edges > 0);
+        ensure("not everything split", split_edges < (S32)expected);
+
+        mInput.mBuildLines = false;
+        fs_build_parcel_overlay(mInput, result);
+        ensure("no lines", !result.mHasLines);
+        ensure("no edges", result.mEdges.empty());
+    }
+
+    template<> template<>
+    void parceloverlaybuilder_object_t::test<4>()
+    {
+        set_test_name("Merged minimap lines");
+        FSParcelOverlayResult result;
+        fs_build_parcel_overlay(mInput, result);
+
+        // Three vertical and three horizontal borders spanning the region
+        ensure_equals("segments", result.mMinimapLines.size(), (size_t)6);
+        ensure("same borders", split_segments(result.mMinimapLines) == reference_minimap_lines(mInput.mOwnership));
+
+        // A ragged layout still covers exactly the same borders
+        for (S32 i = 0; i < GRIDS * GRIDS; i += 7)
+        {
+            mInput.mOwnership[i] ^= (i % 3) ? PARCEL_WEST_LINE : PARCEL_SOUTH_LINE;
+        }
+        fs_build_parcel_overlay(mInput, result);
+        ensure("same ragged borders", split_segments(result.mMinimapLines) == reference_minimap_lines(mInput.mOwnership));
+    }
+
+    template<> template<>
+    void parceloverlaybuilder_object_t::test<5>()
+    {
+        set_test_name("Marked cells");
+        FSParcelOverlayResult result;
+        fs_build_parcel_overlay(mInput, result);
+
+        size_t expected = 0;
+        for (S32 i = 0; i < GRIDS * GRIDS; i++)
+        {
+            const U8 overlay = mInput.mOwnership[i];
+            if ((overlay & (PARCEL_WEST_LINE | PARCEL_SOUTH_LINE)) || (overlay & PARCEL_COLOR_MASK) == PARCEL_FOR_SALE)
+            {
+                ++expected;
+            }
+        }
+        ensure_equals("marked", result.mMarkedCells.size(), expected);
+        ensure("well below the grid", result.mMarkedCells.size() < (size_t)(GRIDS * GRIDS));
+
+        mInput.mOwnership.clear();
+        fs_build_parcel_overlay(mInput, result);
+        ensure("no ownership, no pixels", result.mPixels.empty());
+        ensure("no ownership, no lines", result.mMinimapLines.empty() && result.mMarkedCells.empty());
+    }
+
+    template<> template<>
+    void parceloverlaybuilder_object_t::test<6>()
+    {
+        set_test_name("Build cost");
+        const S32 ROUNDS = 20;
+        FSParcelOverlayResult result;
+        LLTimer timer;
+        for (S32 i = 0; i < ROUNDS; i++)
+        {
+            mInput.mVersion = i;
+            fs_build_parcel_overlay(mInput, result);
+        }
+        F32 build_ms = timer.getElapsedTimeF32() * 1000.f / ROUNDS;
+
+        const size_t per_cell = reference_minimap_lines(mInput.mOwnership).size();
+        std::cout << std::endl << "parcel overlay build: " << build_ms << " ms per region off the main thread, "
+                  << result.mEdges.size() << " edges, minimap draws " << result.mMinimapLines.size()
+                  << " merged lines in one batch instead of " << per_cell << " cell borders in "
+                  << (GRIDS + 1) * (GRIDS + 1) << " batches" << std::endl;
+        ensure_equals("version of last build", result.mVersion, (U32)(ROUNDS - 1));
+    }
+}
@@ -0,0 +1,347 @@
+/**
+ * @file fsrlvbehaviourindex_test.cpp
+ * @brief RLVa behaviour and exception index
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsrlvbehaviourindex.h"
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <map>
+
+namespace
+{
+    const S32 NUM_BEHAVIOURS = 120;
+
+    // What RlvObject keeps: the commands of an object in the order received
+    struct ReferenceCommand
+    {
+        S32         mBehaviour;
+        std::string mOption;
+        bool        mStrict;
+        bool        mRefCounted;
+    };
+    typedef std::map<LLUUID, std::list<ReferenceCommand> > reference_objects_t;
+
+    bool reference_has(const std::list<ReferenceCommand>& commands, S32 bhvr, const std::string& option, bool strict_only)
+    {
+        for (const ReferenceCommand& command : commands)
+        {
+            if (command.mBehaviour == bhvr &&
+                (command.mOption == option || (option.empty() && command.mRefCounted && !strict_only)) &&
+                (!strict_only || command.mStrict))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool reference_has_except(const reference_objects_t& objects, S32 bhvr, const std::string& option, const LLUUID& id_except)
+    {
+        for (const reference_objects_t::value_type& object : objects)
+        {
+            if (object.first != id_except && reference_has(object.second, bhvr, option, false))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Applies commands to both the reference and the index
+    struct Restrictions
+    {
+        reference_objects_t mObjects;
+        FSRlvBehaviourIndex mIndex;
+
+        Restrictions() : mIndex(NUM_BEHAVIOURS) {}
+
+        bool add(const LLUUID& id_obj, S32 bhvr, const std::string& option, bool strict)
+        {
+            std::list<ReferenceCommand>& commands = mObjects[id_obj];
+            for (const ReferenceCommand& command : commands)
+            {
+                if (command.mBehaviour == bhvr && command.mOption == option && command.mStrict == strict)
+                {
+                    return false;
+                }
+            }
+            // Restrictions without an option and every fourth behaviour with one are reference counted
+            ReferenceCommand command = { bhvr, option, strict, option.empty() || bhvr % 4 == 0 };
+            commands.push_back(command);
+            mIndex.addCommand(id_obj, bhvr, option, strict);
+            if (command.mRefCounted)
+            {
+                mIndex.addRefCounted(id_obj, bhvr);
+            }
+            return true;
+        }
+
+        bool remove(const LLUUID& id_obj, S32 bhvr, const std::string& option, bool strict)
+        {
+            reference_objects_t::iterator it = mObjects.find(id_obj);
+            if (it == mObjects.end())
+            {
+                return false;
+            }
+            for (std::list<ReferenceCommand>::iterator cmd = it->second.begin(); cmd != it->second.end(); ++cmd)
+            {
+                if (cmd->mBehaviour == bhvr && cmd->mOption == option && cmd->mStrict == strict)
+                {
+                    mIndex.removeCommand(id_obj, bhvr, option, strict);
+                    if (cmd->mRefCounted)
+                    {
+                        mIndex.removeRefCounted(id_obj, bhvr);
+                    }
+                    it->second.erase(cmd);
+                    if (it->second.empty())
+                    {
+                        mObjects.erase(it);
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    LLUUID make_id(U32 n)
+    {
+        LLUUID id;
+        memcpy(id.mData, &n, sizeof(n));
+        id.mData[UUID_BYTES - 1] = 0x5a;
+        return id;
+    }
+
+    std::string option_for(U32 n)
+    {
+        switch (n % 4)
+        {
+            case 0: return std::string();
+            case 1: return "8cb8d4a8-5e7c-4b6b-a8a4-1d2e3f4a5b6c";
+            case 2: return "15";
+            default: return "Outfits/Restricted";
+        }
+    }
+}
+
+namespace tut
+{
+    struct rlvbehaviourindex_data
+    {
+        LLUUID mObjA, mObjB;
+
+
+        rlvbehaviourindex_data()
+        :   mObjA(make_id(1)),
+            mObjB(make_id(2))
+        {
+        }
+    };
+    typedef test_group<rlvbehaviourindex_data> rlvbehaviourindex_t;
+    typedef rlvbehaviourindex_t::object rlvbehaviourindex_object_t;
+    tut::rlvbehaviourindex_t tut_rlvbehaviourindex("FSRlvBehaviourIndex");
+
+    template<> template<>
+    void rlvbehaviourindex_object_t::test<1>()
+    {
+        set_test_name("Behaviour checks");
+        FSRlvBehaviourIndex index(NUM_BEHAVIOURS);
+        index.addCommand(mObjA, 5, "", false);
+        index.addCommand(mObjB, 5, "", true);
+        index.addCommand(mObjB, 7, "sit", false);
+
+        ensure("held by A and B", index.hasBehaviourExcept(5, "", LLUUID::null));
+        ensure("held by B except A", index.hasBehaviourExcept(5, "", mObjA));
+        ensure("object check", index.hasBehaviour(mObjA, 5, ""));
+        ensure("not owned when shared", !index.ownsBehaviour(mObjA, 5));
+        ensure("option", index.hasBehaviourExcept(7, "sit", LLUUID::null));
+        ensure("only B has the option", !index.hasBehaviourExcept(7, "sit", mObjB));
+        ensure("option is not the plain behaviour", !index.hasBehaviourExcept(7, "", LLUUID::null));
+
+        std::vector<LLUUID> holders;
+        index.getHolders(5, true, holders);
+        ensure("strict holders", holders.size() == 1 && holders[0] == mObjB);
+        index.getHolders(5, false, holders);
+        ensure_equals("all holders", holders.size(), (size_t)2);
+        ensure("holders in UUID order", holders[0] < holders[1]);
+
+        // A reference counted command with an option also counts as the plain behaviour
+        index.addRefCounted(mObjB, 7);
+        ensure("ref counted option", index.hasBehaviourExcept(7, "", mObjA));
+        ensure("ref counted object check", index.hasBehaviour(mObjB, 7, ""));
+        index.removeRefCounted(mObjB, 7);
+        ensure("ref count dropped", !index.hasBehaviourExcept(7, "", LLUUID::null));
+
+        index.removeCommand(mObjB, 5, "", true);
+        ensure("owned once B let go", index.ownsBehaviour(mObjA, 5));
+        index.getHolders(5, true, holders);
+        ensure("no strict holders left", holders.empty());
+        index.removeCommand(mObjB, 5, "", true);
+        ensure("removing twice is harmless", index.ownsBehaviour(mObjA, 5));
+        ensure("out of range", !index.hasBehaviourExcept(NUM_BEHAVIOURS, "", LLUUID::null));
+
+        index.clear();
+        ensure_equals("cleared", index.getEntryCount(), (size_t)0);
+        ensure("nothing held", !index.hasBehaviourExcept(5, "", LLUUID::null));
+    }
+
+    template<> template<>
+    void rlvbehaviourindex_object_t::test<2>()
+    {
+        set_test_name("Exception sets");
+        FSRlvExceptionIndex<std::string> exceptions(NUM_BEHAVIOURS);
+        ensure("no exceptions", !exceptions.hasException(3));
+
+        exceptions.add(mObjA, 3, "friend");
+        exceptions.add(mObjB, 3, "friend");
+        exceptions.add(mObjA, 3, "friend");
+        ensure("has exception", exceptions.hasException(3));
+        const fs_rlv_holders_t* holders = exceptions.find(3, "friend");
+        ensure("found", holders && holders->size() == 2);
+        ensure("other option", !exceptions.find(3, "stranger"));
+        ensure("other behaviour", !exceptions.find(4, "friend"));
+
+        exceptions.remove(mObjA, 3, "friend");
+        ensure("A added it twice", exceptions.find(3, "friend")->count(mObjA) == 1);
+        exceptions.remove(mObjA, 3, "friend");
+        exceptions.remove(mObjB, 3, "friend");
+        ensure("all removed", !exceptions.hasException(3));
+    }
+
+    template<> template<>
+    void rlvbehaviourindex_object_t::test<3>()
+    {
+        set_test_name("Random commands match the object lists");
+        Restrictions restrictions;
+        std::vector<LLUUID> objects;
+        for (U32 n = 0; n < 12; ++n)
+        {
+            objects.push_back(make_id(n + 10));
+        }
+
+        U32 seed = 12345;
+        for (S32 step = 0; step < 20000; ++step)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const LLUUID& id_obj = objects[(seed >> 8) % objects.size()];
+            S32 bhvr = (S32)((seed >> 12) % 16);
+            std::string option = option_for(seed >> 20);
+            bool strict = ((seed >> 24) & 7) == 0;
+            if ((seed >> 28) & 1)
+            {
+                restrictions.add(id_obj, bhvr, option, strict);
+            }
+            else
+            {
+                restrictions.remove(id_obj, bhvr, option, strict);
+            }
+
+            if (step % 50 != 0)
+            {
+                continue;
+            }
+            for (S32 check = 0; check < 16; ++check)
+            {
+                for (U32 n = 0; n < 4; ++n)
+                {
+                    const std::string check_option = option_for(n);
+                    ensure("except null", restrictions.mIndex.hasBehaviourExcept(check, check_option, LLUUID::null) ==
+                                          reference_has_except(restrictions.mObjects, check, check_option, LLUUID::null));
+                    ensure("except object", restrictions.mIndex.hasBehaviourExcept(check, check_option, id_obj) ==
+                                            reference_has_except(restrictions.mObjects, check, check_option, id_obj));
+                    reference_objects_t::const_iterator it = restrictions.mObjects.find(id_obj);
+                    ensure("object", restrictions.mIndex.hasBehaviour(id_obj, check, check_option) ==
+                                     (it != restrictions.mObjects.end() && reference_has(it->second, check, check_option, false)));
+                }
+
+                std::vector<LLUUID> holders, expected;
+                restrictions.mIndex.getHolders(check, true, holders);
+                for (const reference_objects_t::value_type& object : restrictions.mObjects)
+                {
+                    if (reference_has(object.second, check, "", true))
+                    {
+                        expected.push_back(object.first);
+                    }
+                }
+                ensure("strict holders", holders == expected);
+            }
+        }
+    }
+
+    template<> template<>
+    void rlvbehaviourindex_object_t::test<4>()
+    {
+        set_test_name("Query cost with thousands of commands");
+        // A heavy user: 40 worn devices with 100 restrictions each, most of
+        // them exceptions and options (@sendim:<uuid>=add, @tplocal:<n>=n, ...)
+        Restrictions restrictions;
+        std::vector<LLUUID> objects;
+        for (U32 n = 0; n < 40; ++n)
+        {
+            objects.push_back(make_id(n + 100));
+        }
+        auto apply_start = std::chrono::steady_clock::now();
+        for (size_t obj = 0; obj < objects.size(); ++obj)
+        {
+            for (S32 cmd = 0; cmd < 100; ++cmd)
+            {
+                S32 bhvr = (S32)((obj * 7 + cmd * 13) % NUM_BEHAVIOURS);
+                std::string option = (cmd % 3) ? std::to_string(obj * 100 + cmd) : std::string();
+                restrictions.add(objects[obj], bhvr, option, cmd % 10 == 0);
+            }
+        }
+        F64 apply_ms = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - apply_start).count();
+
+        // What a frame asks: chat, camera, inventory and name tag checks
+        const S32 queries = 20000;
+        size_t legacy_hits = 0;
+        auto legacy_start = std::chrono::steady_clock::now();
+        for (S32 q = 0; q < queries; ++q)
+        {
+            legacy_hits += reference_has_except(restrictions.mObjects, q % NUM_BEHAVIOURS, (q & 1) ? "" : "4217", LLUUID::null) ? 1 : 0;
+        }
+        F64 legacy_ms = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - legacy_start).count();
+
+        size_t hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (S32 q = 0; q < queries; ++q)
+        {
+            hits += restrictions.mIndex.hasBehaviourExcept(q % NUM_BEHAVIOURS, (q & 1) ? "" : "4217", LLUUID::null) ? 1 : 0;
+        }
+        F64 index_ms = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::endl << "RLV index, " << restrictions.mIndex.getEntryCount() << " commands applied in " << apply_ms << " ms; "
+                  << queries << " behaviour checks: object walk " << legacy_ms << " ms, index " << index_ms << " ms" << std::endl;
+
+        ensure_equals("same answers", hits, legacy_hits);
+    }
+}
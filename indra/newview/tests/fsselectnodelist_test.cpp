@@ -0,0 +1,225 @@
+/**
+ * @file fsselectnodelist_test.cpp
+ * @brief Selection node list with constant time lookup, removal and reordering
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsselectnodelist.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+
+namespace
+{
+    // The list only handles node pointers, stand-ins never dereferenced
+    std::vector<LLSelectNode*> make_nodes(std::vector<char>& storage, size_t count)
+    {
+        storage.assign(count, 0);
+        std::vector<LLSelectNode*> nodes;
+        for (size_t i = 0; i < count; ++i)
+        {
+            nodes.push_back(reinterpret_cast<LLSelectNode*>(&storage[i]));
+        }
+        return nodes;
+    }
+
+    std::vector<LLSelectNode*> to_vector(const FSSelectNodeList& list)
+    {
+        return std::vector<LLSelectNode*>(list.begin(), list.end());
+    }
+
+    typedef std::chrono::steady_clock bench_clock_t;
+
+    F64 elapsed_ms(const bench_clock_t::time_point& start)
+    {
+        return std::chrono::duration<F64, std::milli>(bench_clock_t::now() - start).count();
+    }
+
+    // One editing session on a linkset: select every prim the way
+    // LLSelectMgr does (children at the end, root moved to the front),
+    // look each one up as property updates arrive, then deselect half of
+    // the prims one by one.
+    template<typename LIST, typename MAP>
+    F64 edit_session(LIST& list, MAP& lookup, const std::vector<LLSelectNode*>& nodes)
+    {
+        bench_clock_t::time_point start = bench_clock_t::now();
+        for (LLSelectNode* node : nodes)
+        {
+            list.push_back(node);
+            lookup[node] = node;
+        }
+        list.remove(nodes.front());
+        list.push_front(nodes.front());
+
+        size_t found = 0;
+        for (size_t pass = 0; pass < 4; ++pass)
+        {
+            for (LLSelectNode* node : nodes)
+            {
+                found += lookup.find(node) != lookup.end();
+            }
+        }
+
+        for (size_t i = 0; i < nodes.size(); i += 2)
+        {
+            lookup.erase(nodes[i]);
+            list.remove(nodes[i]);
+        }
+        tut::ensure_equals("all found", found, nodes.size() * 4);
+        return elapsed_ms(start);
+    }
+}
+
+namespace tut
+{
+    struct selectnodelist_data
+    {
+        std::vector<char> mStorage;
+        std::vector<LLSelectNode*> mNodes;
+        FSSelectNodeList mList;
+
+        selectnodelist_data()
+        {
+            mNodes = make_nodes(mStorage, 8);
+        }
+    };
+    typedef test_group<selectnodelist_data> selectnodelist_t;
+    typedef selectnodelist_t::object selectnodelist_object_t;
+    tut::selectnodelist_t tut_selectnodelist("FSSelectNodeList");
+
+    template<> template<>
+    void selectnodelist_object_t::test<1>()
+    {
+        set_test_name("Order of added, moved and removed nodes");
+        mList.push_back(mNodes[0]);
+        mList.push_back(mNodes[1]);
+        mList.push_front(mNodes[2]);
+        mList.push_back(mNodes[3]);
+
+        std::vector<LLSelectNode*> expected = { mNodes[2], mNodes[0], mNodes[1], mNodes[3] };
+        ensure("added", to_vector(mList) == expected);
+
+        mList.move_to_front(mNodes[3]);
+        expected = { mNodes[3], mNodes[2], mNodes[0], mNodes[1] };
+        ensure("moved", to_vector(mList) == expected);
+
+        mList.remove(mNodes[2]);
+        mList.remove(mNodes[7]);
+        expected = { mNodes[3], mNodes[0], mNodes[1] };
+        ensure("removed", to_vector(mList) == expected);
+        ensure("contains", mList.contains(mNodes[0]));
+        ensure("removed not contained", !mList.contains(mNodes[2]));
+
+        // Pushing a listed node moves it instead of listing it twice
+        mList.push_back(mNodes[3]);
+        expected = { mNodes[0], mNodes[1], mNodes[3] };
+        ensure("pushed again", to_vector(mList) == expected);
+        ensure_equals("size", mList.size(), (size_t)3);
+
+        // Moving a node not listed adds it, as remove and push_front did
+        mList.move_to_front(mNodes[5]);
+        ensure("moved unlisted", *mList.begin() == mNodes[5]);
+    }
+
+    template<> template<>
+    void selectnodelist_object_t::test<2>()
+    {
+        set_test_name("Iterators and generation");
+        for (LLSelectNode* node : mNodes)
+        {
+            mList.push_back(node);
+        }
+        FSSelectNodeList::iterator third = ++(++mList.begin());
+        U32 generation = mList.getGeneration();
+
+        // Other nodes going away leave iterators alone
+        mList.remove(mNodes[0]);
+        mList.move_to_front(mNodes[5]);
+        ensure("iterator still valid", *third == mNodes[2]);
+        ensure("generation changed", mList.getGeneration() != generation);
+
+        // Erasing while iterating, as cleanupNodes() does
+        for (FSSelectNodeList::iterator it = mList.begin(); it != mList.end(); )
+        {
+            FSSelectNodeList::iterator cur = it++;
+            if (*cur == mNodes[2] || *cur == mNodes[6])
+            {
+                mList.erase(cur);
+            }
+        }
+        ensure_equals("erased", mList.size(), (size_t)5);
+        ensure("erased not contained", !mList.contains(mNodes[6]));
+
+        generation = mList.getGeneration();
+        mList.clear();
+        ensure("cleared", mList.empty() && !mList.contains(mNodes[1]));
+        ensure("generation changed on clear", mList.getGeneration() != generation);
+    }
+
+    template<> template<>
+    void selectnodelist_object_t::test<3>()
+    {
+        set_test_name("Grouping by region");
+        // Nodes of three regions, interleaved as a selection across a
+        // region border comes out of the selection
+        std::vector<S32> nodes = { 10, 21, 11, 32, 22, 12, 33, 13 };
+        fs_group_by_first_appearance(nodes, [](S32 node) { return node / 10; });
+        std::vector<S32> expected = { 10, 11, 12, 13, 21, 22, 32, 33 };
+        ensure("grouped in order of first appearance", nodes == expected);
+
+        std::vector<S32> single = { 3, 1, 2 };
+        fs_group_by_first_appearance(single, [](S32) { return 0; });
+        ensure("single region unchanged", single == std::vector<S32>({ 3, 1, 2 }));
+    }
+
+    template<> template<>
+    void selectnodelist_object_t::test<4>()
+    {
+        set_test_name("Large linkset editing benchmark");
+        const size_t sizes[] = { 256, 1024, 4096 };
+        for (size_t count : sizes)
+        {
+            std::vector<char> storage;
+            std::vector<LLSelectNode*> nodes = make_nodes(storage, count);
+
+            std::list<LLSelectNode*> old_list;
+            std::map<LLSelectNode*, LLSelectNode*> old_map;
+            F64 old_ms = edit_session(old_list, old_map, nodes);
+
+            FSSelectNodeList new_list;
+            std::unordered_map<LLSelectNode*, LLSelectNode*> new_map;
+            F64 new_ms = edit_session(new_list, new_map, nodes);
+
+            ensure_equals("same selection left", to_vector(new_list).size(), old_list.size());
+            ensure("same order", to_vector(new_list) == std::vector<LLSelectNode*>(old_list.begin(), old_list.end()));
+            std::cout << "FSSelectNodeList: " << count << " prims, list and map " << old_ms
+                      << " ms, indexed " << new_ms << " ms" << std::endl;
+        }
+    }
+}
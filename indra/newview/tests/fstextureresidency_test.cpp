@@ -0,0 +1,241 @@
+/**
+ * @file fstextureresidency_test.cpp
+ * @brief Texture residency budget and owner accounting
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+
+#include "../fstextureresidency.h"
+
+namespace
+{
+    const U64 MB = 1024 * 1024;
+
+    FSTextureResidency::Key make_key(U32 n)
+    {
+        FSTextureResidency::Key key;
+        key.mID.mData[0] = (U8)(n & 0xff);
+        key.mID.mData[1] = (U8)(n >> 8);
+        return key;
+    }
+
+    FSTextureResidency::Owner make_owner(FSTextureResidency::EOwnerType type, U32 n = 0)
+    {
+        FSTextureResidency::Owner owner;
+        owner.mType = type;
+        if (n)
+        {
+            owner.mID.mData[15] = (U8)n;
+        }
+        return owner;
+    }
+}
+
+namespace tut
+{
+    struct textureresidency_data
+    {
+        FSTextureResidency mResidency;
+
+        // A fully loaded 1024x1024 RGBA texture
+        void addTexture(U32 n, const FSTextureResidency::Owner& owner, F32 value, bool evictable = true, F64 now = 0.0)
+        {
+            mResidency.updateTexture(make_key(n), owner, 1024, 1024, 4, 5, 0, 0, value, evictable, now);
+        }
+    };
+    typedef test_group<textureresidency_data> textureresidency_t;
+    typedef textureresidency_t::object textureresidency_object_t;
+    tut::textureresidency_t tut_textureresidency("FSTextureResidency");
+
+    template<> template<>
+    void textureresidency_object_t::test<1>()
+    {
+        set_test_name("Decoded bytes");
+        ensure_equals("full", FSTextureResidency::getDecodedBytes(1024, 1024, 4, 0), (U64)(4 * MB + 4 * MB / 3));
+        ensure_equals("one discard", FSTextureResidency::getDecodedBytes(1024, 1024, 4, 1), (U64)(MB + MB / 3));
+        ensure_equals("not loaded", FSTextureResidency::getDecodedBytes(1024, 1024, 4, -1), (U64)0);
+        ensure_equals("no size yet", FSTextureResidency::getDecodedBytes(0, 0, 4, 0), (U64)0);
+        ensure_equals("smallest mip", FSTextureResidency::getDecodedBytes(8, 4, 3, 3), (U64)4);
+    }
+
+    template<> template<>
+    void textureresidency_object_t::test<2>()
+    {
+        set_test_name("Accounting per owner");
+        FSTextureResidency::Owner alice = make_owner(FSTextureResidency::OWNER_AVATAR, 1);
+        FSTextureResidency::Owner bob = make_owner(FSTextureResidency::OWNER_AVATAR, 2);
+        FSTextureResidency::Owner region = make_owner(FSTextureResidency::OWNER_WORLD, 3);
+
+        addTexture(1, alice, 100.f);
+        addTexture(2, alice, 100.f);
+        addTexture(3, bob, 100.f);
+        addTexture(4, region, 100.f);
+        addTexture(5, make_owner(FSTextureResidency::OWNER_UI), 100.f, false);
+        mResidency.update(0.0);
+
+        const U64 texture_bytes = FSTextureResidency::getDecodedBytes(1024, 1024, 4, 0);
+        ensure_equals("total", mResidency.getTotalUsage().mResidentBytes, 5 * texture_bytes);
+        ensure_equals("textures", mResidency.getTotalUsage().mTextures, (U32)5);
+        ensure_equals("avatars", mResidency.getTypeUsage(FSTextureResidency::OWNER_AVATAR).mResidentBytes, 3 * texture_bytes);
+        ensure_equals("world", mResidency.getTypeUsage(FSTextureResidency::OWNER_WORLD).mResidentBytes, texture_bytes);
+        ensure_equals("ui", mResidency.getTypeUsage(FSTextureResidency::OWNER_UI).mTextures, (U32)1);
+        ensure_equals("hud", mResidency.getTypeUsage(FSTextureResidency::OWNER_HUD).mTextures, (U32)0);
+
+        std::vector<std::pair<FSTextureResidency::Owner, FSTextureResidency::Usage> > owners;
+        mResidency.getTopOwners(owners, 2);
+        ensure_equals("top owners", owners.size(), (size_t)2);
+        ensure("largest owner first", owners[0].first.mID == alice.mID);
+        ensure_equals("largest owner bytes", owners[0].second.mResidentBytes, 2 * texture_bytes);
+
+        mResidency.removeTexture(make_key(2));
+        mResidency.update(0.0);
+        ensure_equals("removed", mResidency.getTotalUsage().mTextures, (U32)4);
+    }
+
+    template<> template<>
+    void textureresidency_object_t::test<3>()
+    {
+        set_test_name("No caps within budget");
+        for (U32 i = 0; i < 8; ++i)
+        {
+            addTexture(i, make_owner(FSTextureResidency::OWNER_WORLD), 100.f);
+        }
+        mResidency.setBudget(64 * MB);
+        mResidency.update(0.0);
+        ensure("not enforcing", !mResidency.isEnforcing());
+        for (U32 i = 0; i < 8; ++i)
+        {
+            ensure_equals("uncapped", mResidency.getDiscardCap(make_key(i)), 0);
+        }
+
+        mResidency.setBudget(0);
+        for (U32 i = 8; i < 100; ++i)
+        {
+            addTexture(i, make_owner(FSTextureResidency::OWNER_WORLD), 100.f);
+        }
+        mResidency.update(0.0);
+        ensure("no budget, no enforcement", !mResidency.isEnforcing());
+    }
+
+    template<> template<>
+    void textureresidency_object_t::test<4>()
+    {
+        set_test_name("Least valuable mips go first");
+        // 16 textures of 5.3 MB each, one of them barely visible, one pinned
+        for (U32 i = 0; i < 16; ++i)
+        {
+            addTexture(i, make_owner(FSTextureResidency::OWNER_WORLD), i == 0 ? 1.f : 1000.f, i != 15);
+        }
+        mResidency.setBudget(80 * MB);
+        mResidency.update(0.0);
+
+        ensure("enforcing", mResidency.isEnforcing());
+        ensure("barely visible texture loses detail", mResidency.getDiscardCap(make_key(0)) > 0);
+        ensure_equals("pinned texture keeps detail", mResidency.getDiscardCap(make_key(15)), 0);
+
+        const FSTextureResidency::Usage& total = mResidency.getTotalUsage();
+        ensure("within budget after caps", total.mWantedBytes - total.mCappedBytes <= 80 * MB);
+
+        // Only as many valuable textures lose a level as needed
+        U32 capped_valuable = 0;
+        for (U32 i = 1; i < 15; ++i)
+        {
+            S32 cap = mResidency.getDiscardCap(make_key(i));
+            ensure("valuable textures lose one level at most", cap <= 1);
+            capped_valuable += cap;
+        }
+        ensure("not every valuable texture capped", capped_valuable < 14);
+        ensure_equals("capped count", total.mCapped, capped_valuable + 1);
+    }
+
+    template<> template<>
+    void textureresidency_object_t::test<5>()
+    {
+        set_test_name("No thrash around the budget");
+        // Two equally sized textures whose values flicker against each other
+        mResidency.setBudget(8 * MB);
+        S32 changes = 0;
+        S32 last_cap_a = 0;
+        S32 last_cap_b = 0;
+        for (S32 frame = 0; frame < 60; ++frame)
+        {
+            F32 flicker = (frame & 1) ? 1.f : -1.f;
+            addTexture(1, make_owner(FSTextureResidency::OWNER_WORLD), 100.f + flicker, true, frame);
+            addTexture(2, make_owner(FSTextureResidency::OWNER_WORLD), 100.f - flicker, true, frame);
+            mResidency.update(frame);
+
+            S32 cap_a = mResidency.getDiscardCap(make_key(1));
+            S32 cap_b = mResidency.getDiscardCap(make_key(2));
+            changes += (cap_a != last_cap_a) + (cap_b != last_cap_b);
+            last_cap_a = cap_a;
+            last_cap_b = cap_b;
+        }
+        ensure("one texture capped", (last_cap_a > 0) != (last_cap_b > 0));
+        ensure("caps do not flip between textures", changes <= 1);
+
+        // Dropping slightly below the budget keeps enforcing, well below releases
+        mResidency.setBudget(11 * MB);
+        mResidency.update(60.0);
+        ensure("still enforcing above low water mark", mResidency.isEnforcing());
+        mResidency.setBudget(16 * MB);
+        mResidency.update(60.0);
+        ensure("released below low water mark", !mResidency.isEnforcing());
+        ensure_equals("caps released", mResidency.getDiscardCap(make_key(1)) + mResidency.getDiscardCap(make_key(2)), 0);
+    }
+
+    template<> template<>
+    void textureresidency_object_t::test<6>()
+    {
+        set_test_name("Stale entries expire");
+        addTexture(1, make_owner(FSTextureResidency::OWNER_HUD), 10.f, false, 0.0);
+        addTexture(2, make_owner(FSTextureResidency::OWNER_HUD), 10.f, false, 25.0);
+        mResidency.update(40.0);
+        ensure_equals("stale entry dropped", mResidency.getTotalUsage().mTextures, (U32)1);
+    }
+
+    template<> template<>
+    void textureresidency_object_t::test<7>()
+    {
+        set_test_name("Clearing forgets everything");
+        for (U32 i = 0; i < 16; ++i)
+        {
+            addTexture(i, make_owner(FSTextureResidency::OWNER_WORLD), i == 0 ? 1.f : 1000.f, true);
+        }
+        mResidency.setBudget(80 * MB);
+        mResidency.update(0.0);
+        ensure("enforcing", mResidency.isEnforcing());
+
+        mResidency.clear();
+        ensure("not enforcing", !mResidency.isEnforcing());
+        ensure_equals("no textures", mResidency.getTotalUsage().mTextures, (U32)0);
+        ensure_equals("caps released", mResidency.getDiscardCap(make_key(0)), 0);
+        std::vector<std::pair<FSTextureResidency::Owner, FSTextureResidency::Usage> > owners;
+        mResidency.getTopOwners(owners, 5);
+        ensure("no owners", owners.empty());
+    }
+}
@@ -0,0 +1,376 @@
+/**
+ * @file fsvivoxprotocol_test.cpp
+ * @brief SLVoice protocol name interning, framing and update batching
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsvivoxprotocol.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    // Element names in the order the parser used to compare against them
+    const char* LEGACY_END_TAGS[] =
+    {
+        "ReturnCode", "SessionHandle", "SessionGroupHandle", "StatusCode", "StatusString",
+        "ParticipantURI", "Volume", "Energy", "IsModeratorMuted", "IsSpeaking", "Alias",
+        "NumberOfAliases", "Application", "ConnectorHandle", "VersionID", "Version",
+        "AccountHandle", "State", "URI", "IsChannel", "Incoming", "Enabled", "Name",
+        "AudioMedia", "ChannelName", "DisplayName", "Device", "AccountName", "ParticipantType",
+        "IsLocallyMuted", "MicEnergy", "ChannelURI", "BuddyURI", "Presence", "CaptureDevices",
+        "RenderDevices", "CaptureDevice", "RenderDevice", "BlockMask", "PresenceOnly",
+        "AutoAcceptMask", "AutoAddAsBuddy", "MessageHeader", "MessageBody", "NotificationType",
+        "HasText", "HasAudio", "HasVideo", "Terminated", "SubscriptionHandle", "SubscriptionType",
+        "SessionFont", "TemplateFont", "ID", "Description", "ExpirationDate", "Expired", "Type",
+        "Status", "MediaCompletionType"
+    };
+    const size_t NUM_LEGACY_END_TAGS = sizeof(LEGACY_END_TAGS) / sizeof(LEGACY_END_TAGS[0]);
+
+    const char UPDATE_PREFIX[] = "<Event type=\"ParticipantUpdatedEvent\"";
+    const size_t UPDATE_PREFIX_LENGTH = sizeof(UPDATE_PREFIX) - 1;
+
+    size_t legacy_lookup(const char* tag)
+    {
+        for (size_t i = 0; i < NUM_LEGACY_END_TAGS; ++i)
+        {
+            if (!stricmp(LEGACY_END_TAGS[i], tag))
+            {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    std::string participant_updated_event(S32 session, S32 participant, bool speaking, S32 energy)
+    {
+        std::ostringstream event;
+        event << "<Event type=\"ParticipantUpdatedEvent\">"
+              << "<SessionGroupHandle>c1_m1000xFnPP04IpREWNkuw1cOXlhw==_sg" << session << "</SessionGroupHandle>"
+              << "<SessionHandle>c1_m1000xFnPP04IpREWNkuw1cOXlhw==" << session << "</SessionHandle>"
+              << "<ParticipantUri>sip:xI5auBZ60SJWIk606-" << participant << "==@bhr.vivox.com</ParticipantUri>"
+              << "<IsModeratorMuted>false</IsModeratorMuted>"
+              << "<IsSpeaking>" << (speaking ? "true" : "false") << "</IsSpeaking>"
+              << "<Volume>50</Volume>"
+              << "<Energy>0." << energy << "</Energy>"
+              << "</Event>\n\n\n";
+        return event.str();
+    }
+
+    // What SLVoice sends in a busy region: a few seconds of updates for 40
+    // avatars in local chat, talkers updating ten times a second, with the
+    // occasional response and join or leave mixed in.
+    std::string record_stream(S32 seconds)
+    {
+        std::string stream;
+        for (S32 tick = 0; tick < seconds * 10; ++tick)
+        {
+            for (S32 participant = 0; participant < 40; ++participant)
+            {
+                bool speaking = ((participant + tick / 20) % 8) == 0;
+                if (speaking || tick % 10 == participant % 10)
+                {
+                    stream += participant_updated_event(0, participant, speaking, (tick * 7 + participant) % 90);
+                }
+            }
+            if (tick % 25 == 0)
+            {
+                stream += "<Response requestId=\"42\" action=\"Session.Set3DPosition.1\"><ReturnCode>0</ReturnCode>"
+                          "<Results><StatusCode>0</StatusCode><StatusString /></Results>"
+                          "<InputXml><Request requestId=\"42\" action=\"Session.Set3DPosition.1\" /></InputXml></Response>\n\n\n";
+            }
+            if (tick % 40 == 0)
+            {
+                stream += "<Event type=\"ParticipantAddedEvent\"><SessionGroupHandle>c1_sg0</SessionGroupHandle>"
+                          "<SessionHandle>c1_0</SessionHandle><ParticipantUri>sip:new@bhr.vivox.com</ParticipantUri>"
+                          "<AccountName>new</AccountName><DisplayName /><ParticipantType>0</ParticipantType></Event>\n\n\n";
+            }
+        }
+        return stream;
+    }
+
+    // Captured streams can be replayed with FS_SLVOICE_CAPTURE=<file>, the raw
+    // bytes the viewer read from SLVoice
+    std::string load_stream()
+    {
+        const char* capture = getenv("FS_SLVOICE_CAPTURE");
+        if (capture && *capture)
+        {
+            std::ifstream file(capture, std::ios::binary);
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            if (!contents.str().empty())
+            {
+                return contents.str();
+            }
+        }
+        return record_stream(10);
+    }
+
+    // Names of all start tags of a message, the way expat hands them out
+    template<typename FUNC>
+    void for_each_tag(const char* message, size_t length, FUNC func)
+    {
+        char name[64];
+        for (size_t i = 0; i + 1 < length; ++i)
+        {
+            if (message[i] != '<' || message[i + 1] == '/')
+            {
+                continue;
+            }
+            size_t n = 0;
+            for (++i; i < length && n < sizeof(name) - 1 && (isalnum((U8)message[i]) || message[i] == '_'); ++i)
+            {
+                name[n++] = message[i];
+            }
+            name[n] = '\0';
+            func(name);
+        }
+    }
+}
+
+namespace tut
+{
+    struct vivoxprotocol_data
+    {
+    };
+    typedef test_group<vivoxprotocol_data> vivoxprotocol_t;
+    typedef vivoxprotocol_t::object vivoxprotocol_object_t;
+    tut::vivoxprotocol_t tut_vivoxprotocol("FSVivoxProtocol");
+
+    template<> template<>
+    void vivoxprotocol_object_t::test<1>()
+    {
+        set_test_name("Name interning");
+        for (S32 id = FSVN_UNKNOWN + 1; id < FSVN_COUNT; ++id)
+        {
+            const char* name = fs_vivox_name_string((EFSVivoxName)id);
+            ensure("every id has a name", *name != '\0');
+            ensure_equals(name, fs_vivox_name(name), (EFSVivoxName)id);
+        }
+        ensure_equals("case insensitive", fs_vivox_name("participanturi"), FSVN_PARTICIPANTURI);
+        ensure_equals("attribute shares element id", fs_vivox_name("type"), FSVN_TYPE);
+        ensure_equals("event type", fs_vivox_name("ParticipantUpdatedEvent"), FSVN_PARTICIPANTUPDATEDEVENT);
+        ensure_equals("unknown", fs_vivox_name("Results"), FSVN_UNKNOWN);
+        ensure_equals("prefix is unknown", fs_vivox_name("Session"), FSVN_UNKNOWN);
+        ensure_equals("longer is unknown", fs_vivox_name("VolumeX"), FSVN_UNKNOWN);
+        ensure_equals("empty", fs_vivox_name(""), FSVN_UNKNOWN);
+        for (size_t i = 0; i < NUM_LEGACY_END_TAGS; ++i)
+        {
+            ensure(LEGACY_END_TAGS[i], fs_vivox_name(LEGACY_END_TAGS[i]) != FSVN_UNKNOWN);
+        }
+    }
+
+    template<> template<>
+    void vivoxprotocol_object_t::test<2>()
+    {
+        set_test_name("Message framing");
+        const std::string stream = "<A/>\n\n\n<B>x\n</B>\n\n\n\n\n\n<C/>\n\n\n<D";
+
+        // Every chunk size, including delimiters split across reads
+        for (size_t chunk = 1; chunk <= stream.size(); ++chunk)
+        {
+            FSVivoxMessageStream input;
+            std::vector<std::string> messages;
+            for (size_t pos = 0; pos < stream.size(); pos += chunk)
+            {
+                input.append(stream.data() + pos, llmin(chunk, stream.size() - pos));
+                const char* message;
+                size_t length;
+                while (input.nextMessage(message, length))
+                {
+                    messages.push_back(std::string(message, length));
+                }
+                input.compact();
+            }
+            ensure_equals("message count", messages.size(), (size_t)4);
+            ensure_equals("first", messages[0], std::string("<A/>"));
+            ensure_equals("newline inside", messages[1], std::string("<B>x\n</B>"));
+            ensure_equals("empty message", messages[2], std::string());
+            ensure_equals("third", messages[3], std::string("<C/>"));
+            ensure_equals("incomplete tail kept", input.getBuffer(), std::string("<D"));
+            ensure_equals("pending", input.getPendingBytes(), (size_t)2);
+        }
+    }
+
+    template<> template<>
+    void vivoxprotocol_object_t::test<3>()
+    {
+        set_test_name("Participant update batching");
+        FSVivoxParticipantUpdates updates;
+        updates.add("s1", "g1", "sip:a", "", false, false, 50, 0.f);
+        updates.add("s1", "g1", "sip:b", "", false, true, 50, 0.4f);
+        updates.add("s1", "g1", "sip:a", "", false, true, 60, 0.7f);
+        updates.add("s1", "g1", "sip:a", "", true, false, 70, 0.1f);
+        updates.add("s2", "g2", "sip:a", "", false, false, 50, 0.f);
+        ensure_equals("coalesced per participant and session", updates.size(), (size_t)3);
+
+        std::vector<FSVivoxParticipantUpdate> batch;
+        updates.take(batch);
+        ensure("taken", updates.empty());
+        ensure_equals("batch size", batch.size(), (size_t)3);
+        ensure_equals("first arrival order", batch[0].mURI, std::string("sip:a"));
+        ensure_equals("second arrival order", batch[1].mURI, std::string("sip:b"));
+        ensure_equals("other session", batch[2].mSessionHandle, std::string("s2"));
+        ensure("latest speaking state", !batch[0].mIsSpeaking);
+        ensure("spoke during the frame", batch[0].mSpoke);
+        ensure("latest moderator mute", batch[0].mIsModeratorMuted);
+        ensure_equals("latest volume", batch[0].mVolume, 70);
+        ensure("never spoke", !batch[2].mSpoke);
+        ensure_equals("received", updates.getReceivedCount(), (U64)5);
+        ensure_equals("applied", updates.getAppliedCount(), (U64)3);
+
+        updates.add("s1", "g1", "sip:a", "", false, false, 50, 0.f);
+        updates.take(batch);
+        ensure("new batch starts clean", batch.size() == 1 && !batch[0].mSpoke);
+    }
+
+    template<> template<>
+    void vivoxprotocol_object_t::test<4>()
+    {
+        set_test_name("SLVoice stream replay");
+        const std::string stream = load_stream();
+        const size_t read_size = 1024;  // what the socket pipe hands over per read
+
+        // Framing: copying the remainder after every read against framing in place
+        std::vector<std::string> legacy_messages;
+        auto legacy_start = std::chrono::steady_clock::now();
+        {
+            std::string input;
+            for (size_t pos = 0; pos < stream.size(); pos += read_size)
+            {
+                input.append(stream.data() + pos, llmin(read_size, stream.size() - pos));
+                size_t start = 0;
+                size_t delim;
+                while ((delim = input.find("\n\n\n", start)) != std::string::npos)
+                {
+                    legacy_messages.push_back(input.substr(start, delim - start));
+                    start = delim + 3;
+                }
+                if (start != 0)
+                {
+                    input = input.substr(start);
+                }
+            }
+        }
+        F64 legacy_framing_ms = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - legacy_start).count();
+
+        // One read per frame; the parser applies the updates collected so
+        // far before any other message
+        std::vector<std::string> messages;
+        std::vector<std::string> names;
+        size_t updates_received = 0;
+        size_t refreshes = 0;
+        F64 framing_ms = 0.0;
+        {
+            FSVivoxMessageStream input;
+            FSVivoxParticipantUpdates updates;
+            std::vector<FSVivoxParticipantUpdate> batch;
+            for (size_t pos = 0; pos < stream.size(); pos += read_size)
+            {
+                auto start = std::chrono::steady_clock::now();
+                input.append(stream.data() + pos, llmin(read_size, stream.size() - pos));
+                const char* message;
+                size_t length;
+                std::vector<std::pair<const char*, size_t> > framed;
+                while (input.nextMessage(message, length))
+                {
+                    framed.push_back(std::make_pair(message, length));
+                }
+                framing_ms += std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                for (const std::pair<const char*, size_t>& msg : framed)
+                {
+                    messages.push_back(std::string(msg.first, msg.second));
+                    for_each_tag(msg.first, msg.second, [&](const char* name) { names.push_back(name); });
+
+                    if (msg.second >= UPDATE_PREFIX_LENGTH && !strncmp(msg.first, UPDATE_PREFIX, UPDATE_PREFIX_LENGTH))
+                    {
+                        const char* uri = strstr(msg.first, "<ParticipantUri>");
+                        const char* uri_end = uri ? strstr(uri, "</ParticipantUri>") : NULL;
+                        std::string participant = uri && uri_end ? std::string(uri + 16, uri_end) : std::string();
+                        bool speaking = strstr(msg.first, "<IsSpeaking>true") != NULL;
+                        updates.add("0", "g0", participant, "", false, speaking, 50, 0.5f);
+                        ++updates_received;
+                    }
+                    else if (!updates.empty())
+                    {
+                        updates.take(batch);
+                        ++refreshes;
+                    }
+                }
+                input.compact();
+
+                if (!updates.empty())
+                {
+                    updates.take(batch);
+                    ++refreshes;
+                }
+            }
+        }
+        ensure("same messages", messages == legacy_messages);
+
+        // Name lookup: comparing against every known name against interned ids
+        const S32 rounds = 20;
+        size_t legacy_known = 0;
+        legacy_start = std::chrono::steady_clock::now();
+        for (S32 round = 0; round < rounds; ++round)
+        {
+            for (const std::string& name : names)
+            {
+                legacy_known += legacy_lookup(name.c_str()) ? 1 : 0;
+            }
+        }
+        F64 legacy_lookup_ms = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - legacy_start).count() / rounds;
+
+        size_t known = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (S32 round = 0; round < rounds; ++round)
+        {
+            for (const std::string& name : names)
+            {
+                // Element names the parser acts on at the end of a tag
+                EFSVivoxName id = fs_vivox_name(name.c_str());
+                known += (id >= FSVN_TYPE && id < FSVN_ACCOUNTLOGINSTATECHANGEEVENT) ? 1 : 0;
+            }
+        }
+        F64 lookup_ms = std::chrono::duration<F64, std::milli>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+        std::cout << std::endl << "SLVoice replay, " << stream.size() << " bytes, " << messages.size() << " messages, "
+                  << names.size() << " tags: framing " << legacy_framing_ms << " ms copied vs " << framing_ms << " ms in place, "
+                  << "names " << legacy_lookup_ms << " ms compared vs " << lookup_ms << " ms interned, "
+                  << updates_received << " participant updates in " << refreshes << " speaker list refreshes" << std::endl;
+
+        ensure_equals("same known names", known, legacy_known);
+        ensure("updates batched", refreshes < updates_received || updates_received == 0);
+    }
+}
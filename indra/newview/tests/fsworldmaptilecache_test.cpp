@@ -0,0 +1,384 @@
+/**
+ * @file fsworldmaptilecache_test.cpp
+ * @brief Request budget and memory bounded LRU for world map tiles
+ *
+ * $LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../fsworldmaptilecache.h"
+
+#include <iostream>
+#include <set>
+
+namespace
+{
+    const S32 LEVELS = 8;
+    const U32 TILE_BYTES = 256 * 256 * 3;
+    const S32 LOADS_PER_FRAME = 4;
+
+    U64 make_handle(U32 grid_x, U32 grid_y)
+    {
+        return ((U64)grid_x << 32) | grid_y;
+    }
+
+    // Stands in for the tile directory of the map server: regions exist in
+    // a block with holes, a tile of a coarser level exists if any region
+    // below it does.
+    struct TileDirectory
+    {
+        bool exists(S32 level, U32 grid_x, U32 grid_y) const
+        {
+            U32 regions = 1 << (level - 1);
+            for (U32 y = grid_y; y < grid_y + regions; ++y)
+            {
+                for (U32 x = grid_x; x < grid_x + regions; ++x)
+                {
+                    if (x >= 1000 && x < 1100 && y >= 1000 && y < 1100 && (x * 7 + y * 3) % 11)
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    };
+
+    typedef std::pair<S32, U64> tile_t;
+
+    // Loads share the bandwidth: each frame the oldest few loads that are
+    // at least latency frames old complete. Released tiles stop loading.
+    struct MapReplay
+    {
+        FSWorldMapTileCache                 mCache;
+        TileDirectory                       mDirectory;
+        std::vector<std::pair<tile_t, S32> > mLoads;    // tile and frame it started, oldest first
+        std::set<tile_t>                    mHeld;      // tiles the map holds on to
+        S32                                 mFrame;
+        S32                                 mLatency;
+        U32                                 mPeakInFlight;
+        U64                                 mPeakBytes;
+        S32                                 mIncompleteFrames;
+
+        MapReplay(U32 max_bytes, U32 max_in_flight, S32 latency)
+        :   mCache(LEVELS),
+            mFrame(0),
+            mLatency(latency),
+            mPeakInFlight(0),
+            mPeakBytes(0),
+            mIncompleteFrames(0)
+        {
+            mCache.setBudget(max_bytes, max_in_flight);
+        }
+
+        bool isLoaded(S32 level, U64 handle) const
+        {
+            return mHeld.count(std::make_pair(level, handle)) && !mCache.isLoading(level, handle);
+        }
+
+        void startLoad(S32 level, U64 handle)
+        {
+            mHeld.insert(std::make_pair(level, handle));
+            mLoads.push_back(std::make_pair(std::make_pair(level, handle), mFrame));
+        }
+
+        void cancelLoad(const tile_t& tile)
+        {
+            for (size_t i = 0; i < mLoads.size(); ++i)
+            {
+                if (mLoads[i].first == tile)
+                {
+                    mLoads.erase(mLoads.begin() + i);
+                    return;
+                }
+            }
+        }
+
+        // What LLWorldMipmap::equalizeBoostLevels() does before each draw
+        void update()
+        {
+            S32 completed = 0;
+            while (!mLoads.empty() && completed < LOADS_PER_FRAME && mLoads.front().second + mLatency <= mFrame)
+            {
+                const tile_t& tile = mLoads.front().first;
+                U32 grid_x = (U32)(tile.second >> 32);
+                U32 grid_y = (U32)(tile.second & 0xffffffff);
+                bool exists = mDirectory.exists(tile.first, grid_x, grid_y);
+                mCache.setLoaded(tile.first, tile.second, exists ? TILE_BYTES : 0);
+                mLoads.erase(mLoads.begin());
+                ++completed;
+            }
+
+            std::vector<FSWorldMapTileCache::TileKey> keys;
+            mCache.evict(keys);
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                tile_t tile(keys[i].mLevel, keys[i].mHandle);
+                mHeld.erase(tile);
+                cancelLoad(tile);
+            }
+            mCache.takeRequests(keys);
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                startLoad(keys[i].mLevel, keys[i].mHandle);
+            }
+            mCache.beginFrame();
+            ++mFrame;
+        }
+
+        // What LLWorldMipmap::getObjectsTile() does; returns true if the tile can be drawn
+        bool lookup(S32 level, U32 grid_x, U32 grid_y, bool load, F32 priority)
+        {
+            U64 handle = make_handle(grid_x, grid_y);
+            if (mHeld.count(std::make_pair(level, handle)))
+            {
+                mCache.touch(level, handle);
+                return isLoaded(level, handle);
+            }
+            if (!load)
+            {
+                return false;
+            }
+            if (!mCache.isBounded())
+            {
+                startLoad(level, handle);
+                mCache.addTile(level, handle);
+                return false;
+            }
+
+            mCache.want(level, handle, priority);
+            S32 placeholder_level = llmin(level + 2, LEVELS);
+            if (placeholder_level != level)
+            {
+                U32 regions = 1 << (placeholder_level - 1);
+                U64 placeholder = make_handle(grid_x - grid_x % regions, grid_y - grid_y % regions);
+                if (!mHeld.count(std::make_pair(placeholder_level, placeholder)))
+                {
+                    mCache.want(placeholder_level, placeholder, priority);
+                }
+            }
+            return false;
+        }
+
+        // What LLWorldMapView::drawMipmapLevel() does for a view of 8 by 5
+        // tiles of the level around the center, given in regions
+        bool drawLevel(S32 level, F32 center_x, F32 center_y, bool load)
+        {
+            U32 regions = 1 << (level - 1);
+            bool complete = true;
+            for (S32 dy = -3; dy <= 3; ++dy)
+            {
+                for (S32 dx = -4; dx <= 4; ++dx)
+                {
+                    F32 x = center_x + dx * (F32)regions;
+                    F32 y = center_y + dy * (F32)regions;
+                    U32 grid_x = (U32)x - ((U32)x % regions);
+                    U32 grid_y = (U32)y - ((U32)y % regions);
+                    F32 tiles_x = (grid_x + regions * 0.5f - center_x) / regions;
+                    F32 tiles_y = (grid_y + regions * 0.5f - center_y) / regions;
+                    if (!lookup(level, grid_x, grid_y, load, tiles_x * tiles_x + tiles_y * tiles_y))
+                    {
+                        complete = false;
+                    }
+                }
+            }
+            return complete;
+        }
+
+        void frame(S32 level, F32 center_x, F32 center_y)
+        {
+            update();
+            for (S32 coarser = LEVELS; coarser > level; --coarser)
+            {
+                drawLevel(coarser, center_x, center_y, false);
+            }
+            if (!drawLevel(level, center_x, center_y, true))
+            {
+                ++mIncompleteFrames;
+            }
+            mPeakInFlight = llmax(mPeakInFlight, mCache.getInFlightCount());
+            mPeakBytes = llmax(mPeakBytes, mCache.getResidentBytes());
+        }
+
+        // Pan across the block at full detail, zoom out fast over the whole
+        // grid, pan there, then zoom back in somewhere else
+        void run()
+        {
+            F32 x = 1010.f, y = 1010.f;
+            for (S32 i = 0; i < 60; ++i)
+            {
+                x += 0.25f;
+                frame(1, x, y);
+            }
+            for (S32 level = 1; level <= LEVELS; ++level)
+            {
+                for (S32 i = 0; i < 3; ++i)
+                {
+                    frame(level, x, y);
+                }
+            }
+            for (S32 i = 0; i < 60; ++i)
+            {
+                x += 2.f;
+                y += 1.f;
+                frame(LEVELS, x, y);
+            }
+            for (S32 level = LEVELS; level >= 2; --level)
+            {
+                for (S32 i = 0; i < 20; ++i)
+                {
+                    frame(level, x, y);
+                }
+            }
+            for (S32 i = 0; i < 60; ++i)
+            {
+                frame(2, x, y);
+            }
+        }
+    };
+}
+
+namespace tut
+{
+    struct worldmaptilecache_data
+    {
+        worldmaptilecache_data()
+        :   mCache(LEVELS)
+        {
+        }
+
+        FSWorldMapTileCache mCache;
+        std::vector<FSWorldMapTileCache::TileKey> mKeys;
+    };
+    typedef test_group<worldmaptilecache_data> worldmaptilecache_t;
+    typedef worldmaptilecache_t::object worldmaptilecache_object_t;
+    tut::worldmaptilecache_t tut_worldmaptilecache("FSWorldMapTileCache");
+
+    template<> template<>
+    void worldmaptilecache_object_t::test<1>()
+    {
+        set_test_name("Prioritized requests");
+        mCache.setBudget(0, 3);
+        ensure("bounded", mCache.isBounded());
+
+        mCache.want(1, make_handle(1, 1), 4.f);
+        mCache.want(1, make_handle(2, 1), 1.f);
+        mCache.want(3, make_handle(0, 0), 1.f);
+        mCache.want(1, make_handle(3, 1), 0.f);
+        mCache.want(1, make_handle(2, 1), 9.f);     // again, keeps the better priority
+        ensure("wanted", mCache.isWanted(1, make_handle(1, 1)));
+        ensure("not wanted", !mCache.isWanted(2, make_handle(1, 1)));
+        ensure_equals("misses", mCache.getMissCount(), (U32)4);
+
+        mCache.takeRequests(mKeys);
+        ensure_equals("three may load", mKeys.size(), (size_t)3);
+        ensure_equals("most urgent first", mKeys[0].mHandle, make_handle(3, 1));
+        ensure_equals("coarse level before fine at equal priority", mKeys[1].mLevel, 3);
+        ensure_equals("then the fine tile", mKeys[2].mHandle, make_handle(2, 1));
+        ensure_equals("in flight", mCache.getInFlightCount(), (U32)3);
+        ensure("queue dropped after the frame", !mCache.isWanted(1, make_handle(1, 1)));
+
+        mCache.beginFrame();
+        mCache.want(1, make_handle(1, 1), 4.f);
+        mCache.takeRequests(mKeys);
+        ensure("no slot left", mKeys.empty());
+
+        mCache.setLoaded(1, make_handle(3, 1), TILE_BYTES);
+        ensure("loaded", !mCache.isLoading(1, make_handle(3, 1)));
+        ensure_equals("resident", mCache.getResidentBytes(), (U64)TILE_BYTES);
+        mCache.beginFrame();
+        mCache.want(1, make_handle(1, 1), 4.f);
+        mCache.takeRequests(mKeys);
+        ensure_equals("slot freed", mKeys.size(), (size_t)1);
+    }
+
+    template<> template<>
+    void worldmaptilecache_object_t::test<2>()
+    {
+        set_test_name("Least recently used eviction");
+        mCache.setBudget(3 * TILE_BYTES, 8);
+
+        // Frame 1: four tiles of level 1 and one of level 3
+        for (U32 i = 0; i < 4; ++i)
+        {
+            mCache.addTile(1, make_handle(i, 0));
+            mCache.setLoaded(1, make_handle(i, 0), TILE_BYTES);
+        }
+        mCache.addTile(3, make_handle(0, 0));
+        mCache.setLoaded(3, make_handle(0, 0), TILE_BYTES);
+        mCache.addTile(1, make_handle(9, 9));      // still loading
+        mCache.beginFrame();
+
+        // Frame 2: only two of them are looked at
+        mCache.touch(1, make_handle(3, 0));
+        mCache.touch(1, make_handle(2, 0));
+        ensure_equals("hits", mCache.getHitCount(), (U32)2);
+        mCache.evict(mKeys);
+
+        // The abandoned load goes, then finer unused tiles before the coarse one
+        ensure_equals("evicted", mKeys.size(), (size_t)3);
+        ensure_equals("abandoned load", mKeys[0].mHandle, make_handle(9, 9));
+        ensure_equals("fine first", mKeys[1].mLevel, 1);
+        ensure_equals("fine second", mKeys[2].mLevel, 1);
+        ensure_equals("tiles left", mCache.getTileCount(), (size_t)3);
+        ensure_equals("within budget", mCache.getResidentBytes(), (U64)3 * TILE_BYTES);
+        ensure_equals("no loads left", mCache.getInFlightCount(), (U32)0);
+
+        // Tiles used this frame survive even over budget
+        mCache.setBudget(TILE_BYTES, 8);
+        mCache.evict(mKeys);
+        ensure_equals("only the unused one", mKeys.size(), (size_t)1);
+        ensure_equals("coarse one last", mKeys[0].mLevel, 3);
+        ensure_equals("tiles", mCache.getTileCount(), (size_t)2);
+    }
+
+    template<> template<>
+    void worldmaptilecache_object_t::test<3>()
+    {
+        set_test_name("Synthetic zoom and pan path");
+        const U32 budget = 200 * TILE_BYTES;
+        MapReplay unbounded(budget, 0, 6);
+        unbounded.run();
+        MapReplay bounded(budget, 16, 6);
+        bounded.run();
+
+        const FSWorldMapTileCache& a = unbounded.mCache;
+        const FSWorldMapTileCache& b = bounded.mCache;
+        std::cout << "\nMap replay, requests / peak in flight / peak KB / hit rate / KB loaded / incomplete frames:"
+                  << "\n  all at once: " << a.getRequestCount() << " / " << unbounded.mPeakInFlight << " / "
+                  << unbounded.mPeakBytes / 1024 << " / " << (S32)(a.getHitRate() * 100.f) << "% / " << a.getLoadedBytes() / 1024
+                  << " / " << unbounded.mIncompleteFrames
+                  << "\n  prioritized: " << b.getRequestCount() << " / " << bounded.mPeakInFlight << " / "
+                  << bounded.mPeakBytes / 1024 << " / " << (S32)(b.getHitRate() * 100.f) << "% / " << b.getLoadedBytes() / 1024
+                  << " / " << bounded.mIncompleteFrames << std::endl;
+
+        ensure("loads bounded", bounded.mPeakInFlight <= 16);
+        ensure("fewer bytes loaded", b.getLoadedBytes() < a.getLoadedBytes());
+        // Only what is on screen may go over the budget
+        ensure("memory bounded", bounded.mPeakBytes <= budget + 2 * 63 * TILE_BYTES);
+        ensure("view completes sooner", bounded.mIncompleteFrames < unbounded.mIncompleteFrames);
+    }
+}
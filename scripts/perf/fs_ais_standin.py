@@ -0,0 +1,332 @@
+#!/usr/bin/env python3
+"""\
+@file fs_ais_standin.py
+@brief Local stand-in for the AISv3 inventory service serving a large
+       synthetic account, used to benchmark bulk inventory updates.
+
+$LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+Phoenix Firestorm Viewer Source Code
+Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+http://www.firestormviewer.org
+$/LicenseInfo$
+
+Usage:
+  1. Start the stand-in:
+       fs_ais_standin.py --items 100000 --port 8787
+  2. Log in, then point the viewer at it from the debug settings:
+       FSAISCapOverride = http://127.0.0.1:8787
+     and open the inventory floater, or relog with the setting still set in
+     the session (it does not persist). The first folder the viewer asks for
+     becomes the root of the synthetic account.
+  3. Repeat with FSAISThreadedUnpack on and off, then compare the
+     "AIS update applied" and "Inventory background fetch completed" lines
+     of both runs:
+       fs_ais_standin.py --summarize /path/to/Firestorm.log
+"""
+
+import argparse
+import re
+import sys
+import time
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+from xml.sax.saxutils import escape
+
+NAMESPACE = uuid.UUID("5f0e4c1e-8a51-4f0b-9c7e-3d0f5b2a6c11")
+
+# LLAssetType / LLInventoryType values for the synthetic content
+ITEM_KINDS = [
+    # (asset type, inventory type, name)
+    (0, 0, "Texture"),
+    (7, 7, "Notecard"),
+    (6, 6, "Object"),
+    (13, 18, "Bodypart"),
+    (5, 18, "Clothing"),
+    (10, 10, "Script"),
+]
+
+PERM_ALL = 0x7FFFFFFF
+
+
+def llsd_xml(value):
+    """Serialize plain python values as LLSD XML"""
+    out = []
+
+    def write(v):
+        if isinstance(v, bool):
+            out.append("<boolean>%s</boolean>" % ("true" if v else "false"))
+        elif isinstance(v, int):
+            out.append("<integer>%d</integer>" % v)
+        elif isinstance(v, float):
+            out.append("<real>%r</real>" % v)
+        elif isinstance(v, uuid.UUID):
+            out.append("<uuid>%s</uuid>" % v)
+        elif isinstance(v, str):
+            out.append("<string>%s</string>" % escape(v))
+        elif isinstance(v, dict):
+            out.append("<map>")
+            for key, item in v.items():
+                out.append("<key>%s</key>" % escape(str(key)))
+                write(item)
+            out.append("</map>")
+        elif isinstance(v, (list, tuple)):
+            out.append("<array>")
+            for item in v:
+                write(item)
+            out.append("</array>")
+        elif v is None:
+            out.append("<undef />")
+        else:
+            raise TypeError("can't serialize %r" % (v,))
+
+    out.append('<?xml version="1.0" ?><llsd>')
+    write(value)
+    out.append("</llsd>")
+    return "".join(out).encode("utf-8")
+
+
+class SyntheticAccount:
+    """A folder tree with a fixed number of items, laid out deterministically
+    below whatever folder the viewer asks for first."""
+
+    def __init__(self, items, fanout, depth, agent_id):
+        self.num_items = items
+        self.fanout = fanout
+        self.depth = depth
+        self.agent_id = agent_id
+        self.root_id = None
+        self.categories = {}    # id -> (parent id, name, level)
+        self.children = {}      # id -> [child category ids]
+        self.items = {}         # id -> [item dicts]
+
+    def adopt_root(self, root_id):
+        self.root_id = root_id
+        self.categories[root_id] = (uuid.UUID(int=0), "My Inventory", 0)
+        folders = [root_id]
+        level = [root_id]
+        for depth in range(1, self.depth + 1):
+            next_level = []
+            for parent in level:
+                kids = []
+                for i in range(self.fanout):
+                    cat_id = uuid.uuid5(NAMESPACE, "%s/%d" % (parent, i))
+                    self.categories[cat_id] = (parent, "Folder %d-%d" % (depth, len(next_level)), depth)
+                    kids.append(cat_id)
+                    next_level.append(cat_id)
+                self.children[parent] = kids
+            folders.extend(next_level)
+            level = next_level
+
+        created = int(time.time()) - 86400
+        for n in range(self.num_items):
+            parent = folders[n % len(folders)]
+            asset_type, inv_type, kind = ITEM_KINDS[n % len(ITEM_KINDS)]
+            item_id = uuid.uuid5(NAMESPACE, "item/%d" % n)
+            self.items.setdefault(parent, []).append({
+                "item_id": item_id,
+                "parent_id": parent,
+                "name": "%s %d" % (kind, n),
+                "desc": "Synthetic item %d" % n,
+                "type": asset_type,
+                "inv_type": inv_type,
+                "flags": 0,
+                "asset_id": uuid.uuid5(NAMESPACE, "asset/%d" % n),
+                "created_at": created + n,
+                "permissions": {
+                    "creator_id": self.agent_id,
+                    "owner_id": self.agent_id,
+                    "last_owner_id": self.agent_id,
+                    "group_id": uuid.UUID(int=0),
+                    "is_owner_group": False,
+                    "base_mask": PERM_ALL,
+                    "owner_mask": PERM_ALL,
+                    "group_mask": 0,
+                    "everyone_mask": 0,
+                    "next_owner_mask": PERM_ALL,
+                },
+                "sale_info": {"sale_type": 0, "sale_price": 10},
+            })
+
+    def knows(self, cat_id):
+        if cat_id not in self.categories and self.root_id is None:
+            self.adopt_root(cat_id)
+        return cat_id in self.categories
+
+    def category(self, cat_id, depth, with_items, budget, only=None):
+        parent, name, level = self.categories[cat_id]
+        cat = {
+            "category_id": cat_id,
+            "parent_id": parent,
+            "name": name,
+            "type_default": -1,
+            "agent_id": self.agent_id,
+            "version": 1,
+        }
+        if depth < 0:
+            return cat
+
+        kids = self.children.get(cat_id, [])
+        items = self.items.get(cat_id, []) if with_items else []
+        if only is not None:
+            # children=id1,id2: a subset of the subfolders, no items
+            kids = [kid for kid in kids if kid in only]
+            items = []
+        budget[0] -= len(kids) + len(items)
+        cat["_embedded"] = {
+            "categories": dict((str(kid), self.category(kid, depth - 1, with_items, budget)) for kid in kids),
+            "items": dict((str(item["item_id"]), item) for item in items),
+            "links": {},
+        }
+        return cat
+
+
+class Handler(BaseHTTPRequestHandler):
+    account = None
+    max_objects = 0
+    latency = 0.0
+    stats = {"requests": 0, "objects": 0, "bytes": 0}
+
+    def log_message(self, format, *args):
+        pass
+
+    def reply(self, code, body=b""):
+        self.send_response(code)
+        self.send_header("Content-Type", "application/llsd+xml")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        parts = [p for p in url.path.split("/") if p]
+        query = parse_qs(url.query)
+        if self.latency:
+            time.sleep(self.latency)
+
+        # /category/<id>[/children|/categories|/links]; items are never asked
+        # for by id during a bulk fetch
+        if "category" not in parts:
+            return self.reply(404)
+        rest = parts[parts.index("category") + 1:]
+        if not rest:
+            return self.reply(404)
+        cat_token = rest[0]
+        what = rest[1] if len(rest) > 1 else ""
+        try:
+            cat_id = uuid.UUID(cat_token)
+        except ValueError:
+            return self.reply(404)
+        if not self.account.knows(cat_id):
+            return self.reply(404)
+
+        depth = query.get("depth", ["0"])[0]
+        depth = 50 if depth == "*" else int(depth)
+        if what == "links":
+            depth = 0
+        only = None
+        if "children" in query:
+            try:
+                only = set(uuid.UUID(token) for token in query["children"][0].split(","))
+            except ValueError:
+                return self.reply(400)
+        limit = self.max_objects or sys.maxsize
+        budget = [limit]
+        body = self.account.category(cat_id, depth, what != "categories", budget, only)
+        if budget[0] < 0:
+            # The real service refuses responses over its content limit,
+            # the viewer then retries with less depth
+            return self.reply(403)
+
+        payload = llsd_xml(body)
+        Handler.stats["requests"] += 1
+        Handler.stats["objects"] += limit - budget[0]
+        Handler.stats["bytes"] += len(payload)
+        print("GET %s depth=%d%s -> %d bytes" % (url.path, depth,
+                                                   " children=%d" % len(only) if only is not None else "", len(payload)))
+        self.reply(200, payload)
+
+
+FETCH_RE = re.compile(r"Inventory background fetch completed: (\d+) folders in ([\d.]+) s \(([\d.]+) folders/s\), "
+                      r"(\d+) batched requests")
+SUMMARY_RE = re.compile(r"AIS update applied (\d+) objects \((\d+) unpacked on worker in ([\d.]+) ms\), "
+                        r"(\d+) batches, (\d+) slices, longest slice ([\d.]+) ms, waited ([\d.]+) ms, total ([\d.]+) ms")
+
+
+def summarize(path):
+    rows = []
+    fetches = []
+    with open(path, errors="replace") as log:
+        for line in log:
+            match = SUMMARY_RE.search(line)
+            if match:
+                rows.append([float(v) for v in match.groups()])
+            match = FETCH_RE.search(line)
+            if match:
+                fetches.append([float(v) for v in match.groups()])
+    for folders, seconds, rate, batched in fetches:
+        print("background fetch:     %d folders in %.1f s, %.1f folders/s, %d batched requests"
+              % (folders, seconds, rate, batched))
+    if not rows:
+        print("no AIS update statistics in %s" % path)
+        return 0 if fetches else 1
+
+    objects = sum(r[0] for r in rows)
+    worker = sum(r[1] for r in rows)
+    print("updates:              %d" % len(rows))
+    print("objects applied:      %d (%d unpacked on worker)" % (objects, worker))
+    print("worker unpack:        %.1f ms" % sum(r[2] for r in rows))
+    print("observer batches:     %d" % sum(r[3] for r in rows))
+    print("main thread slices:   %d" % sum(r[4] for r in rows))
+    print("longest slice:        %.1f ms" % max(r[5] for r in rows))
+    print("total update time:    %.1f ms" % sum(r[7] for r in rows))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stand-in AISv3 service with a synthetic inventory")
+    parser.add_argument("--port", type=int, default=8787)
+    parser.add_argument("--items", type=int, default=100000, help="items in the synthetic account")
+    parser.add_argument("--fanout", type=int, default=10, help="subfolders per folder")
+    parser.add_argument("--depth", type=int, default=3, help="folder levels below the root")
+    parser.add_argument("--agent", default=str(uuid.UUID(int=0)), help="agent id to own the content")
+    parser.add_argument("--max-objects", type=int, default=0,
+                        help="refuse responses with more objects, like the real service (0 = no limit)")
+    parser.add_argument("--latency", type=float, default=0.0, help="seconds to delay every response")
+    parser.add_argument("--summarize", metavar="LOG", help="summarize the viewer log of a benchmark run and exit")
+    args = parser.parse_args()
+
+    if args.summarize:
+        return summarize(args.summarize)
+
+    Handler.account = SyntheticAccount(args.items, args.fanout, args.depth, uuid.UUID(args.agent))
+    Handler.max_objects = args.max_objects
+    Handler.latency = args.latency
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), Handler)
+    print("AIS stand-in on http://127.0.0.1:%d with %d items" % (args.port, args.items))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print("served %(requests)d requests, %(objects)d objects, %(bytes)d bytes" % Handler.stats)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""\
+@file fs_group_members_standin.py
+@brief Local stand-in for the GroupMemberData capability serving a large
+       synthetic group, used to benchmark loading group member lists.
+
+$LicenseInfo:firstyear=2024&license=fsviewerlgpl$
+Phoenix Firestorm Viewer Source Code
+Copyright (C) 2024, The Phoenix Firestorm Project, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+http://www.firestormviewer.org
+$/LicenseInfo$
+
+Usage:
+  1. Start the stand-in:
+       fs_group_members_standin.py --members 50000 --port 8788
+  2. Log in, then point the viewer at it from the debug settings:
+       FSGroupMemberDataCapOverride = http://127.0.0.1:8788
+     and open the profile of any group you are in. Whatever group the viewer
+     asks for is answered with the synthetic member list.
+  3. Repeat with FSGroupMembersThreadedUnpack on and off, then compare the
+     "Group member data applied" lines of both runs:
+       fs_group_members_standin.py --summarize /path/to/Firestorm.log
+"""
+
+import argparse
+import random
+import re
+import sys
+import time
+import uuid
+from datetime import date, timedelta
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from xml.sax.saxutils import escape
+
+NAMESPACE = uuid.UUID("8c3b7a52-1f64-4e0d-a9b7-64d2e1f05c93")
+
+TITLES = ["Member", "Officer", "Builder", "Greeter", "Moderator", "DJ", "Host", "Owner"]
+OWNER_TITLE = len(TITLES) - 1
+MEMBER_POWERS = 0x0000000000000000
+OFFICER_POWERS = 0x000000FFFFFFFFFF
+OWNER_POWERS = 0xFFFFFFFFFFFFFFFF
+
+
+def llsd_xml(value):
+    """Serialize plain python values as LLSD XML"""
+    out = []
+
+    def write(v):
+        if isinstance(v, bool):
+            out.append("<boolean>%s</boolean>" % ("true" if v else "false"))
+        elif isinstance(v, int):
+            out.append("<integer>%d</integer>" % v)
+        elif isinstance(v, float):
+            out.append("<real>%r</real>" % v)
+        elif isinstance(v, uuid.UUID):
+            out.append("<uuid>%s</uuid>" % v)
+        elif isinstance(v, str):
+            out.append("<string>%s</string>" % escape(v))
+        elif isinstance(v, dict):
+            out.append("<map>")
+            for key, item in v.items():
+                out.append("<key>%s</key>" % escape(str(key)))
+                write(item)
+            out.append("</map>")
+        elif isinstance(v, (list, tuple)):
+            out.append("<array>")
+            for item in v:
+                write(item)
+            out.append("</array>")
+        elif v is None:
+            out.append("<undef />")
+        else:
+            raise TypeError("can't serialize %r" % (v,))
+
+    out.append('<?xml version="1.0" ?><llsd>')
+    write(value)
+    out.append("</llsd>")
+    return "".join(out).encode("utf-8")
+
+
+class SyntheticGroup:
+    """Members with a realistic mix of online status, titles and land
+    contributions, the same for every run with the same seed."""
+
+    def __init__(self, members, online, seed):
+        rng = random.Random(seed)
+        today = date.today()
+        self.members = {}
+        for n in range(members):
+            member_id = uuid.uuid5(NAMESPACE, "member/%d" % n)
+            info = {}
+            if n < 3:
+                info["owner"] = True
+                info["title"] = OWNER_TITLE
+                info["powers"] = "%016X" % OWNER_POWERS
+            else:
+                # Most members keep the default title and powers, which the
+                # service leaves out of the entry
+                title = rng.choice(TITLES[:-1]) if rng.random() < 0.1 else 0
+                if title:
+                    info["title"] = title
+                if title == 1:
+                    info["powers"] = "%016X" % OFFICER_POWERS
+            if rng.random() < online:
+                info["last_login"] = "Online"
+            else:
+                # Skewed towards recent logins, like real groups
+                days = int(rng.expovariate(1.0 / 60.0)) % 3650
+                info["last_login"] = (today - timedelta(days=days)).strftime("%m/%d/%Y")
+            if rng.random() < 0.05:
+                info["donated_square_meters"] = rng.choice([512, 1024, 4096, 16384])
+            self.members[str(member_id)] = info
+
+    def response(self, group_id):
+        return {
+            "group_id": group_id,
+            "agent_id": uuid.UUID(int=0),
+            "member_count": len(self.members),
+            "members": self.members,
+            "titles": TITLES,
+            "defaults": {"default_powers": "%016X" % MEMBER_POWERS},
+        }
+
+
+GROUP_ID_RE = re.compile(rb"<key>group_id</key>\s*<uuid>([0-9a-fA-F-]{36})</uuid>")
+
+
+class Handler(BaseHTTPRequestHandler):
+    group = None
+    latency = 0.0
+    stats = {"requests": 0, "bytes": 0}
+
+    def log_message(self, format, *args):
+        pass
+
+    def reply(self, code, body=b""):
+        self.send_response(code)
+        self.send_header("Content-Type", "application/llsd+xml")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        request = self.rfile.read(length)
+        match = GROUP_ID_RE.search(request)
+        if not match:
+            return self.reply(400)
+        if self.latency:
+            time.sleep(self.latency)
+
+        started = time.time()
+        payload = llsd_xml(self.group.response(uuid.UUID(match.group(1).decode("ascii"))))
+        Handler.stats["requests"] += 1
+        Handler.stats["bytes"] += len(payload)
+        print("POST group %s -> %d members, %d bytes in %.1f s"
+              % (match.group(1).decode("ascii"), len(self.group.members), len(payload), time.time() - started))
+        self.reply(200, payload)
+
+
+SUMMARY_RE = re.compile(r"Group member data applied (\d+) members \((\d+) titles, (\d+) status strings\), "
+                        r"unpacked (on worker )?in ([\d.]+) ms, (\d+) slices, longest slice ([\d.]+) ms, total ([\d.]+) ms")
+
+
+def summarize(path):
+    rows = []
+    with open(path, errors="replace") as log:
+        for line in log:
+            match = SUMMARY_RE.search(line)
+            if match:
+                rows.append(match.groups())
+    if not rows:
+        print("no group member statistics in %s" % path)
+        return 1
+
+    for members, titles, statuses, worker, unpack, slices, longest, total in rows:
+        print("%6d members, %3d titles, %4d status strings: unpack %7.1f ms%s, %4d slices, "
+              "longest slice %5.1f ms, total %8.1f ms"
+              % (int(members), int(titles), int(statuses), float(unpack), " (worker)" if worker else "",
+                 int(slices), float(longest), float(total)))
+    print("longest slice overall: %.1f ms" % max(float(r[6]) for r in rows))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stand-in GroupMemberData capability with a synthetic group")
+    parser.add_argument("--port", type=int, default=8788)
+    parser.add_argument("--members", type=int, default=50000, help="members in the synthetic group")
+    parser.add_argument("--online", type=float, default=0.03, help="share of members shown online")
+    parser.add_argument("--seed", type=int, default=1, help="seed of the synthetic member data")
+    parser.add_argument("--latency", type=float, default=0.0, help="seconds to delay every response")
+    parser.add_argument("--summarize", metavar="LOG", help="summarize the viewer log of a benchmark run and exit")
+    args = parser.parse_args()
+
+    if args.summarize:
+        return summarize(args.summarize)
+
+    Handler.group = SyntheticGroup(args.members, args.online, args.seed)
+    Handler.latency = args.latency
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), Handler)
+    print("GroupMemberData stand-in on http://127.0.0.1:%d with %d members" % (args.port, args.members))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print("served %(requests)d requests, %(bytes)d bytes" % Handler.stats)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())